@@ -0,0 +1,6 @@
+#pragma once
+
+// Batch de-identification, run as:
+//   dicom_viewer --anonymize --output <dir> [--profile <file>] <file or directory>...
+// Returns the process exit code.
+int run_anonymize(int argc, char* argv[]);
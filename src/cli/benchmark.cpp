@@ -0,0 +1,2424 @@
+#include "benchmark.hpp"
+#include "core/buffer_pool.hpp"
+#include "core/cine_player.hpp"
+#include "core/color_convert.hpp"
+#include "core/cpu_features.hpp"
+#include "core/image_cache.hpp"
+#include "core/mask_blend.hpp"
+#include "core/mpr.hpp"
+#include "core/overlay.hpp"
+#include "core/roi_statistics.hpp"
+#include "core/segmentation.hpp"
+#include "core/slab_projection.hpp"
+#include "core/structure_set.hpp"
+#include "core/study_index.hpp"
+#include "core/thread_pool.hpp"
+#include "core/viewport.hpp"
+#include "infrastructure/codec_registry.hpp"
+#include "infrastructure/dcmtk_wrapper.hpp"
+#include "infrastructure/dicomweb_retriever.hpp"
+#include "infrastructure/frame_decoder.hpp"
+#include "infrastructure/functional_groups_reader.hpp"
+#include "infrastructure/http_client.hpp"
+#include "infrastructure/instance_ingest.hpp"
+#include "infrastructure/memory_usage.hpp"
+#include "infrastructure/preview_reader.hpp"
+#include "infrastructure/process_info.hpp"
+#include "infrastructure/query_scu.hpp"
+#include "infrastructure/rtstruct_reader.hpp"
+#include "infrastructure/segmentation_reader.hpp"
+#include "infrastructure/series_retriever.hpp"
+#include "infrastructure/storage_scp.hpp"
+#include "infrastructure/store_scu.hpp"
+#include "infrastructure/study_anonymizer.hpp"
+#include "infrastructure/study_transcoder.hpp"
+#include "infrastructure/test_dicomweb_server.hpp"
+#include "infrastructure/test_pacs.hpp"
+#include "infrastructure/test_pattern.hpp"
+#include "infrastructure/thumbnail_cache.hpp"
+#include "infrastructure/tiled_reader.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Options = std::map<std::string, std::string>;
+
+// Parses "--key value" pairs
+Options parse_options(int argc, char* argv[]) {
+    Options options;
+    for (int i = 0; i + 1 < argc; i += 2) {
+        std::string_view key = argv[i];
+        if (key.substr(0, 2) == "--") {
+            options[std::string(key.substr(2))] = argv[i + 1];
+        }
+    }
+    return options;
+}
+
+uint32_t option_u32(const Options& options, const std::string& key, uint32_t fallback) {
+    auto it = options.find(key);
+    return it == options.end() ? fallback : static_cast<uint32_t>(std::strtoul(it->second.c_str(), nullptr, 10));
+}
+
+std::vector<size_t> thread_counts(size_t max_threads) {
+    std::vector<size_t> counts;
+    for (size_t n = 1; n < max_threads; n *= 2) {
+        counts.push_back(n);
+    }
+    counts.push_back(max_threads);
+    return counts;
+}
+
+// Whether two decodes produced the same frames, pixel for pixel
+bool same_frames(const FrameSet& a, const FrameSet& b) {
+    return a.width == b.width && a.height == b.height && a.frame_count == b.frame_count &&
+        a.pixels.pixel_count() == b.pixels.pixel_count() && a.pixels.gray16() && b.pixels.gray16() &&
+        std::equal(a.pixels.gray16(), a.pixels.gray16() + a.pixels.pixel_count(), b.pixels.gray16());
+}
+
+// Decode throughput of compressed multi-frame objects versus worker count.
+// Every decode is checked against the uncompressed object decoded by one
+// worker, which needs neither a codec nor fragment lookup.
+int benchmark_decode(const Options& options) {
+    const uint32_t frames = option_u32(options, "frames", 64);
+    const uint32_t size = option_u32(options, "size", 512);
+    const size_t max_threads = option_u32(options, "threads",
+        static_cast<uint32_t>(ThreadPool::default_thread_count()));
+
+    const auto dir = std::filesystem::temp_directory_path() / "dicom_viewer_bench";
+    std::filesystem::create_directories(dir);
+
+    std::cout << "Frame decode benchmark: " << frames << " frames of " << size << "x" << size << std::endl;
+    std::cout << std::left << std::setw(6) << "Bits" << std::setw(20) << "Codec"
+        << std::setw(10) << "Workers" << std::setw(12) << "Frames/s" << std::setw(11) << "Pixels"
+        << "Speedup" << std::endl;
+
+    const PixelCodec codecs[] = { PixelCodec::Rle, PixelCodec::JpegLossless, PixelCodec::JpegLsLossless };
+    uint32_t mismatches = 0;
+
+    for (uint16_t bits : { uint16_t{ 8 }, uint16_t{ 16 } }) {
+        // The codecs are lossless, so each must reproduce the native frames
+        const auto reference_path = dir / ("decode_" + std::to_string(bits) + "_reference.dcm");
+        auto reference_written = write_test_pattern(reference_path,
+            TestPatternSpec{ size, size, frames, bits, PixelCodec::Uncompressed });
+        if (reference_written.is_error()) {
+            std::cerr << "Reference failed: " << reference_written.error().full_message() << std::endl;
+            return 1;
+        }
+        ThreadPool reference_pool(1);
+        auto reference = FrameDecodeScheduler(reference_pool).decode(reference_path);
+        std::filesystem::remove(reference_path);
+        if (reference.is_error()) {
+            std::cerr << "Reference decode failed: " << reference.error().full_message() << std::endl;
+            return 1;
+        }
+
+        for (PixelCodec codec : codecs) {
+            const auto path = dir / ("decode_" + std::to_string(bits) + "_" +
+                std::to_string(static_cast<int>(codec)) + ".dcm");
+
+            auto written = write_test_pattern(path, TestPatternSpec{ size, size, frames, bits, codec });
+            if (written.is_error()) {
+                std::cerr << "Skipping " << codec_name(codec) << ": "
+                    << written.error().full_message() << std::endl;
+                continue;
+            }
+
+            double baseline_fps = 0.0;
+            for (size_t threads : thread_counts(max_threads)) {
+                ThreadPool pool(threads);
+                FrameDecodeScheduler scheduler(pool);
+                FrameDecodeStats stats;
+
+                auto result = scheduler.decode(path, &stats);
+                if (result.is_error()) {
+                    std::cerr << "Decode failed: " << result.error().full_message() << std::endl;
+                    ++mismatches;
+                    break;
+                }
+
+                if (threads == 1) {
+                    baseline_fps = stats.frames_per_second();
+                }
+                const bool match = same_frames(result.value(), reference.value());
+                mismatches += match ? 0 : 1;
+
+                std::cout << std::left << std::setw(6) << bits << std::setw(20) << codec_name(codec)
+                    << std::setw(10) << stats.workers << std::setw(12) << std::fixed << std::setprecision(1)
+                    << stats.frames_per_second() << std::setw(11) << (match ? "identical" : "DIFFER")
+                    << std::setprecision(2) << (baseline_fps > 0 ? stats.frames_per_second() / baseline_fps : 0.0)
+                    << "x" << std::endl;
+            }
+
+            std::filesystem::remove(path);
+        }
+    }
+
+    if (mismatches > 0) {
+        std::cout << mismatches << " decodes differ from the uncompressed frames" << std::endl;
+    }
+    return mismatches == 0 ? 0 : 1;
+}
+
+// Peak and steady-state memory of single-frame loads, several images held at once
+int benchmark_memory(const Options& options) {
+    const uint32_t size = option_u32(options, "size", 4096);
+    const uint32_t images = option_u32(options, "images", 4);
+    const double mb = 1024.0 * 1024.0;
+
+    DcmtkReader reader;
+
+    const auto dir = std::filesystem::temp_directory_path() / "dicom_viewer_bench";
+    std::filesystem::create_directories(dir);
+
+    std::cout << "Load memory benchmark: " << images << " images of " << size << "x" << size
+        << " (16-bit)" << std::endl;
+    if (!reset_peak_memory()) {
+        std::cout << "Peak counter cannot be reset on this platform; peaks are process-wide" << std::endl;
+    }
+    std::cout << std::left << std::setw(20) << "Codec" << std::setw(12) << "Image MB"
+        << std::setw(16) << "Peak/image" << "Steady/image" << std::endl;
+
+    for (PixelCodec codec : { PixelCodec::Uncompressed, PixelCodec::JpegLsLossless }) {
+        const auto path = dir / ("memory_" + std::to_string(static_cast<int>(codec)) + ".dcm");
+        auto written = write_test_pattern(path, TestPatternSpec{ size, size, 1, 16, codec });
+        if (written.is_error()) {
+            std::cerr << "Skipping " << codec_name(codec) << ": "
+                << written.error().full_message() << std::endl;
+            continue;
+        }
+
+        std::vector<DicomImageData> held;
+        double image_bytes = 0.0;
+        double worst_peak = 0.0;
+        const MemoryUsage start = current_memory_usage();
+
+        for (uint32_t i = 0; i < images; ++i) {
+            reset_peak_memory();
+            const MemoryUsage before = current_memory_usage();
+
+            auto result = reader.load_image(path);
+            if (result.is_error()) {
+                std::cerr << "Load failed: " << result.error().full_message() << std::endl;
+                break;
+            }
+
+            const MemoryUsage after = current_memory_usage();
+            image_bytes = static_cast<double>(result.value().data().pixels.size_bytes());
+            worst_peak = std::max(worst_peak,
+                static_cast<double>(after.peak_resident_bytes) - static_cast<double>(before.resident_bytes));
+            held.push_back(std::move(result.value()));
+        }
+
+        if (!held.empty()) {
+            const double steady = (static_cast<double>(current_memory_usage().resident_bytes) -
+                static_cast<double>(start.resident_bytes)) / static_cast<double>(held.size());
+
+            std::cout << std::left << std::setw(20) << codec_name(codec) << std::setw(12)
+                << std::fixed << std::setprecision(1) << image_bytes / mb
+                << std::setw(16) << (std::to_string(static_cast<int>(worst_peak / mb)) + " MB (" +
+                    std::to_string(worst_peak / image_bytes).substr(0, 4) + "x)")
+                << static_cast<int>(steady / mb) << " MB (" << std::setprecision(2) << steady / image_bytes
+                << "x)" << std::endl;
+        }
+
+        std::filesystem::remove(path);
+    }
+
+    return 0;
+}
+
+// Cost of repeated loads and renders with and without buffer recycling,
+// for each huge page mode
+int benchmark_alloc(const Options& options) {
+    const uint32_t size = option_u32(options, "size", 4096);
+    const uint32_t iterations = std::max<uint32_t>(option_u32(options, "iterations", 10), 1);
+
+    DcmtkReader reader;
+
+    const auto dir = std::filesystem::temp_directory_path() / "dicom_viewer_bench";
+    std::filesystem::create_directories(dir);
+    const auto path = dir / "alloc.dcm";
+
+    auto written = write_test_pattern(path, TestPatternSpec{ size, size, 1, 16, PixelCodec::Uncompressed });
+    if (written.is_error()) {
+        std::cerr << written.error().full_message() << std::endl;
+        return 1;
+    }
+
+    std::cout << "Buffer pool benchmark: " << size << "x" << size << ", " << iterations
+        << " loads and renders per configuration" << std::endl;
+    std::cout << std::left << std::setw(8) << "Pool" << std::setw(14) << "Huge pages"
+        << std::setw(12) << "Load ms" << std::setw(14) << "Load faults"
+        << std::setw(12) << "Render ms" << std::setw(14) << "Render faults"
+        << "Fresh/reused blocks" << std::endl;
+
+    struct Mode { HugePageMode mode; const char* name; };
+    const Mode modes[] = {
+        { HugePageMode::None, "none" },
+        { HugePageMode::Transparent, "transparent" },
+        { HugePageMode::Explicit, "explicit" },
+    };
+
+    BufferPool& pool = BufferPool::shared();
+    using Clock = std::chrono::steady_clock;
+
+    for (bool pooled : { false, true }) {
+        for (const Mode& mode : modes) {
+            pool.set_max_cached_bytes(pooled ? 1024ull * 1024 * 1024 : 0);
+            pool.set_huge_page_mode(mode.mode);
+            const BufferPoolStats pool_before = pool.stats();
+
+            double load_ms = 0.0, render_ms = 0.0;
+            uint64_t load_faults = 0, render_faults = 0;
+
+            for (uint32_t i = 0; i < iterations; ++i) {
+                MemoryUsage before = current_memory_usage();
+                auto start = Clock::now();
+                auto result = reader.load_image(path);
+                load_ms += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+                load_faults += current_memory_usage().minor_page_faults - before.minor_page_faults;
+                if (result.is_error()) {
+                    std::cerr << "Load failed: " << result.error().full_message() << std::endl;
+                    return 1;
+                }
+
+                const ImageData& data = result.value().data();
+                before = current_memory_usage();
+                start = Clock::now();
+                PixelBuffer display = result.value().to_display_buffer(data.window_center, data.window_width);
+                display.reset();
+                render_ms += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+                render_faults += current_memory_usage().minor_page_faults - before.minor_page_faults;
+            }
+
+            const BufferPoolStats pool_after = pool.stats();
+            std::cout << std::left << std::setw(8) << (pooled ? "on" : "off") << std::setw(14) << mode.name
+                << std::fixed << std::setprecision(1)
+                << std::setw(12) << load_ms / iterations << std::setw(14) << load_faults / iterations
+                << std::setw(12) << render_ms / iterations << std::setw(14) << render_faults / iterations
+                << (pool_after.allocations - pool_before.allocations) << "/"
+                << (pool_after.reuses - pool_before.reuses) << std::endl;
+        }
+    }
+
+    std::filesystem::remove(path);
+    return 0;
+}
+
+// Zoomed-region render time of the row-major layout versus tiles
+int benchmark_tiles(const Options& options) {
+    const uint32_t size = option_u32(options, "size", 8192);
+    const uint32_t out = option_u32(options, "viewport", 1024);
+    const uint32_t renders = std::max<uint32_t>(option_u32(options, "renders", 20), 1);
+    const uint32_t tile_size = option_u32(options, "tile", TiledImage::kDefaultTileSize);
+
+    DcmtkReader reader;
+    reader.set_tiled_layout(false);
+
+    const auto dir = std::filesystem::temp_directory_path() / "dicom_viewer_bench";
+    std::filesystem::create_directories(dir);
+    const auto path = dir / "tiles.dcm";
+
+    auto written = write_test_pattern(path, TestPatternSpec{ size, size, 1, 16, PixelCodec::Uncompressed });
+    if (written.is_error()) {
+        std::cerr << written.error().full_message() << std::endl;
+        return 1;
+    }
+
+    auto loaded = reader.load_image(path);
+    if (loaded.is_error()) {
+        std::cerr << loaded.error().full_message() << std::endl;
+        return 1;
+    }
+    const DicomImageData& row_major = loaded.value();
+    const ImageData& data = row_major.data();
+
+    // Same samples in tiles, so both layouts must render identical output
+    DicomImageData tiled;
+    {
+        ImageData tiled_data;
+        tiled_data.width = data.width;
+        tiled_data.height = data.height;
+        tiled_data.tiles = TiledImage::from_row_major(data.pixels.gray16(), data.width, data.height, tile_size);
+        tiled.set_data(std::move(tiled_data));
+    }
+
+    std::cout << "Tiled layout benchmark: " << size << "x" << size << " image, " << out << "x" << out
+        << " viewport, " << tile_size << " px tiles, " << renders << " renders per zoom" << std::endl;
+    std::cout << std::left << std::setw(8) << "Zoom" << std::setw(14) << "Row-major ms"
+        << std::setw(12) << "Tiled ms" << std::setw(16) << "Lazy first ms" << std::setw(14) << "Tiles read"
+        << "Match" << std::endl;
+
+    using Clock = std::chrono::steady_clock;
+    auto ms_since = [](Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    };
+
+    for (uint32_t zoom : { 1u, 4u, 16u }) {
+        const uint32_t region_size = std::min(size, std::max(out / zoom, 1u) * (zoom == 1 ? 2 : 1));
+
+        // Viewports spread over the image, identical for every layout
+        std::vector<PixelRegion> regions;
+        uint32_t seed = 2463534242u;
+        for (uint32_t i = 0; i < renders; ++i) {
+            seed ^= seed << 13; seed ^= seed >> 17; seed ^= seed << 5;
+            const uint32_t x = seed % (size - region_size + 1);
+            seed ^= seed << 13; seed ^= seed >> 17; seed ^= seed << 5;
+            const uint32_t y = seed % (size - region_size + 1);
+            regions.push_back(PixelRegion{ x, y, region_size, region_size });
+        }
+
+        // Materialize every tile once so the comparison measures the layout only
+        for (const PixelRegion& region : regions) {
+            tiled.render_region(region, out, out, data.window_center, data.window_width);
+        }
+
+        bool match = true;
+        auto start = Clock::now();
+        for (const PixelRegion& region : regions) {
+            row_major.render_region(region, out, out, data.window_center, data.window_width);
+        }
+        const double row_major_ms = ms_since(start) / renders;
+
+        start = Clock::now();
+        for (const PixelRegion& region : regions) {
+            tiled.render_region(region, out, out, data.window_center, data.window_width);
+        }
+        const double tiled_ms = ms_since(start) / renders;
+
+        for (const PixelRegion& region : regions) {
+            PixelBuffer a = row_major.render_region(region, out, out, data.window_center, data.window_width);
+            PixelBuffer b = tiled.render_region(region, out, out, data.window_center, data.window_width);
+            match = match && std::memcmp(a.gray8(), b.gray8(), a.size_bytes()) == 0;
+        }
+
+        // Fresh lazily read image: only the tiles under the first viewport come from disk
+        double lazy_ms = 0.0;
+        size_t tiles_read = 0;
+        start = Clock::now();
+        auto lazy = load_tiled_image(path, tile_size);
+        if (lazy.is_ok()) {
+            DicomImageData lazy_image;
+            lazy_image.set_data(std::move(lazy.value()));
+            lazy_image.render_region(regions.front(), out, out, data.window_center, data.window_width);
+            lazy_ms = ms_since(start);
+            tiles_read = lazy_image.data().tiles->materialized_tiles();
+        }
+
+        std::cout << std::left << std::setw(8) << (std::to_string(zoom) + "x") << std::fixed << std::setprecision(2)
+            << std::setw(14) << row_major_ms << std::setw(12) << tiled_ms << std::setw(16) << lazy_ms
+            << std::setw(14) << tiles_read << (match ? "yes" : "NO") << std::endl;
+    }
+
+    std::filesystem::remove(path);
+    return 0;
+}
+
+// Synthetic CT-like volume: nested shells plus noise
+Volume make_synthetic_volume(uint32_t size, uint32_t depth) {
+    Volume volume;
+    volume.allocate(size, size, depth);
+    volume.spacing = { 0.7, 0.7, 0.6 };
+    for (uint32_t k = 0; k < depth; ++k) {
+        uint16_t* slice = volume.slice(k);
+        for (uint32_t j = 0; j < size; ++j) {
+            for (uint32_t i = 0; i < size; ++i) {
+                const double dx = i - size * 0.5, dy = j - size * 0.5, dz = (k - depth * 0.5) * 1.2;
+                const double r = std::sqrt(dx * dx + dy * dy + dz * dz);
+                const uint32_t shell = static_cast<uint32_t>(r) / 24;
+                const uint32_t noise = (i * 73856093u ^ j * 19349663u ^ k * 83492791u) * 2654435761u >> 24;
+                slice[static_cast<size_t>(j) * size + i] =
+                    static_cast<uint16_t>((shell * 9001u + noise * 16u) & 0xFFFF);
+            }
+        }
+    }
+    return volume;
+}
+
+// Reslice time per plane orientation, scalar vs AVX2 kernel, versus worker count
+int benchmark_mpr(const Options& options) {
+    const uint32_t size = std::max<uint32_t>(option_u32(options, "size", 512), 2);
+    const uint32_t depth = std::max<uint32_t>(option_u32(options, "depth", 256), 2);
+    const uint32_t renders = std::max<uint32_t>(option_u32(options, "renders", 10), 1);
+    const size_t max_threads = option_u32(options, "threads",
+        static_cast<uint32_t>(ThreadPool::default_thread_count()));
+
+    const Volume volume = make_synthetic_volume(size, depth);
+
+    struct PlaneCase {
+        const char* name;
+        MprPlane plane;
+    };
+    const PlaneCase planes[] = {
+        { "axial", make_mpr_plane(volume, MprOrientation::Axial) },
+        { "coronal", make_mpr_plane(volume, MprOrientation::Coronal) },
+        { "sagittal", make_mpr_plane(volume, MprOrientation::Sagittal) },
+        { "oblique", make_mpr_plane(volume, MprOrientation::Oblique, 0.0, 30.0, 20.0) },
+    };
+
+    std::cout << "MPR benchmark: " << size << "x" << size << "x" << depth << " volume, "
+        << renders << " renders per case, AVX2 " << (cpu_features().avx2 ? "available" : "unavailable") << std::endl;
+    std::cout << std::left << std::setw(10) << "Plane" << std::setw(12) << "Output" << std::setw(10) << "Workers"
+        << std::setw(12) << "Scalar ms" << std::setw(12) << "AVX2 ms" << "Max diff" << std::endl;
+
+    using Clock = std::chrono::steady_clock;
+    for (const PlaneCase& c : planes) {
+        const size_t out_pixels = static_cast<size_t>(c.plane.width) * c.plane.height;
+        std::vector<uint16_t> scalar_out(out_pixels), simd_out(out_pixels);
+
+        for (size_t threads : thread_counts(max_threads)) {
+            ThreadPool pool(threads);
+            MprRenderer renderer(pool);
+
+            auto time_renders = [&](bool simd, std::vector<uint16_t>& out) {
+                renderer.set_simd_enabled(simd);
+                renderer.reslice(volume, c.plane, out.data());
+                const auto start = Clock::now();
+                for (uint32_t r = 0; r < renders; ++r) {
+                    renderer.reslice(volume, c.plane, out.data());
+                }
+                return std::chrono::duration<double, std::milli>(Clock::now() - start).count() / renders;
+            };
+            const double scalar_ms = time_renders(false, scalar_out);
+            const double simd_ms = time_renders(true, simd_out);
+
+            int max_diff = 0;
+            for (size_t i = 0; i < out_pixels; ++i) {
+                max_diff = std::max(max_diff, std::abs(int{ scalar_out[i] } - int{ simd_out[i] }));
+            }
+
+            std::cout << std::left << std::setw(10) << c.name
+                << std::setw(12) << (std::to_string(c.plane.width) + "x" + std::to_string(c.plane.height))
+                << std::setw(10) << threads << std::fixed << std::setprecision(2)
+                << std::setw(12) << scalar_ms << std::setw(12) << simd_ms << max_diff << std::endl;
+        }
+    }
+
+    return 0;
+}
+
+// Slab projection time, full rebuild vs sliding by one slice, scalar vs AVX2
+int benchmark_slab(const Options& options) {
+    const uint32_t size = std::max<uint32_t>(option_u32(options, "size", 512), 2);
+    const uint32_t depth = std::max<uint32_t>(option_u32(options, "depth", 256), 2);
+    const uint32_t thickness = std::clamp<uint32_t>(option_u32(options, "thickness", 32), 1, depth);
+    const uint32_t steps = std::clamp<uint32_t>(option_u32(options, "steps", 64), 1, depth - thickness + 1);
+    const size_t threads = option_u32(options, "threads",
+        static_cast<uint32_t>(ThreadPool::default_thread_count()));
+
+    const Volume volume = make_synthetic_volume(size, depth);
+    ThreadPool pool(threads);
+
+    std::cout << "Slab projection benchmark: " << size << "x" << size << "x" << depth << " volume, "
+        << thickness << "-slice slab slid over " << steps << " positions, " << threads << " workers" << std::endl;
+    std::cout << std::left << std::setw(10) << "Mode" << std::setw(8) << "Kernel" << std::setw(14) << "Rebuild ms"
+        << std::setw(12) << "Slide ms" << std::setw(18) << "Pixels rescanned" << "Match" << std::endl;
+
+    using Clock = std::chrono::steady_clock;
+    const std::pair<const char*, SlabMode> modes[] = {
+        { "MIP", SlabMode::Maximum }, { "MinIP", SlabMode::Minimum }, { "Average", SlabMode::Average } };
+
+    for (const auto& [name, mode] : modes) {
+        for (bool simd : { false, true }) {
+            SlabProjector rebuild(pool), slide(pool);
+            rebuild.set_simd_enabled(simd);
+            slide.set_simd_enabled(simd);
+
+            double rebuild_ms = 0.0, slide_ms = 0.0;
+            uint64_t rescanned = 0;
+            bool match = true;
+            slide.project(volume, mode, 0, thickness);
+            for (uint32_t s = 1; s < steps; ++s) {
+                rebuild.reset();
+                auto start = Clock::now();
+                DicomImageData full = rebuild.project(volume, mode, s, thickness);
+                rebuild_ms += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+                start = Clock::now();
+                DicomImageData moved = slide.project(volume, mode, s, thickness);
+                slide_ms += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+                rescanned += slide.last_recomputed_pixels();
+
+                const PixelBuffer& a = full.data().pixels;
+                const PixelBuffer& b = moved.data().pixels;
+                match = match && std::memcmp(a.gray16(), b.gray16(), a.size_bytes()) == 0;
+            }
+            const uint32_t runs = std::max<uint32_t>(steps - 1, 1);
+
+            std::cout << std::left << std::setw(10) << name << std::setw(8) << (simd ? "AVX2" : "scalar")
+                << std::fixed << std::setprecision(2) << std::setw(14) << rebuild_ms / runs
+                << std::setw(12) << slide_ms / runs << std::setw(18) << rescanned / runs
+                << (match ? "yes" : "NO") << std::endl;
+        }
+    }
+
+    return 0;
+}
+
+struct BenchmarkEntry {
+    std::string_view name;
+    std::string_view description;
+    std::function<int(const Options&)> run;
+};
+
+// Cine playback of a synthetic loop while the consumer thread stalls now and
+// then, as a GUI busy with other work would
+int benchmark_cine(const Options& options) {
+    const uint32_t size = std::max<uint32_t>(option_u32(options, "size", 1024), 16);
+    const uint32_t frame_count = std::max<uint32_t>(option_u32(options, "frames", 32), 1);
+    const uint32_t seconds = std::max<uint32_t>(option_u32(options, "seconds", 3), 1);
+    const uint32_t stall_ms = option_u32(options, "stall", 40);
+    const uint32_t stall_every = std::max<uint32_t>(option_u32(options, "stall-every", 30), 1);
+
+    FrameSet frames;
+    frames.width = size;
+    frames.height = size;
+    frames.frame_count = frame_count;
+    frames.pixels = PixelBuffer::allocate(PixelFormat::Gray16, frames.frame_pixels() * frame_count);
+    for (uint32_t f = 0; f < frame_count; ++f) {
+        uint16_t* frame = frames.frame(f);
+        for (size_t i = 0; i < frames.frame_pixels(); ++i) {
+            frame[i] = static_cast<uint16_t>((i * 40503u + f * 2654435761u) >> 8);
+        }
+    }
+    const std::vector<uint8_t> lut = DicomImageData::window_lut(32768, 40000);
+
+    std::cout << "Cine benchmark: " << frame_count << " frames of " << size << "x" << size << ", "
+        << seconds << " s per rate, consumer stalls " << stall_ms << " ms every " << stall_every << " frames, "
+        << ThreadPool::shared().size() << " workers" << std::endl;
+    std::cout << std::left << std::setw(12) << "Target fps" << std::setw(14) << "Shown fps"
+        << std::setw(10) << "Shown" << "Dropped" << std::endl;
+
+    using Clock = std::chrono::steady_clock;
+    PixelBuffer screen = PixelBuffer::allocate(PixelFormat::Gray8, frames.frame_pixels());
+    for (double fps : { 30.0, 60.0 }) {
+        CinePlayer player;
+        player.start(frame_count, fps, [&](uint32_t index) { return frames.window_frame(index, lut); });
+
+        const auto end = Clock::now() + std::chrono::seconds(seconds);
+        uint64_t shown = 0;
+        while (Clock::now() < end) {
+            std::this_thread::sleep_until(player.next_due());
+            std::optional<CineFrame> frame = player.next_frame();
+            if (!frame) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+            // Stand-in for painting the frame
+            std::memcpy(screen.gray8(), frame->pixels.gray8(), screen.size_bytes());
+            if (++shown % stall_every == 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(stall_ms));
+            }
+        }
+
+        const CineStats stats = player.stats();
+        player.stop();
+        std::cout << std::left << std::fixed << std::setprecision(0) << std::setw(12) << fps << std::setprecision(1)
+            << std::setw(14) << stats.presented_fps() << std::setw(10) << stats.presented
+            << stats.dropped << std::endl;
+    }
+
+    return 0;
+}
+
+// Color conversion to interleaved RGB per photometric interpretation and
+// layout, scalar vs AVX2, against a plain copy of the same output size
+int benchmark_color(const Options& options) {
+    const uint32_t size = std::max<uint32_t>(option_u32(options, "size", 1024), 16);
+    const uint32_t iterations = std::max<uint32_t>(option_u32(options, "iterations", 20), 1);
+    const size_t count = static_cast<size_t>(size) * size;
+
+    std::vector<uint8_t> samples(count * 3);
+    std::vector<uint16_t> indices16(count);
+    for (size_t i = 0; i < samples.size(); ++i) {
+        samples[i] = static_cast<uint8_t>((i * 2654435761u) >> 24);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        indices16[i] = static_cast<uint16_t>((i * 40503u) >> 4);
+    }
+    PaletteChannel channel;
+    channel.count = 65536;
+    for (uint32_t i = 0; i < channel.count; ++i) channel.entries.push_back(static_cast<uint16_t>(i * 7));
+    const std::vector<uint32_t> lut8 = build_palette_lut(channel, channel, channel, 8);
+    const std::vector<uint32_t> lut16 = build_palette_lut(channel, channel, channel, 16);
+
+    std::cout << "Color conversion benchmark: " << size << "x" << size << " frame, " << iterations
+        << " runs per case, AVX2 " << (cpu_features().avx2 ? "available" : "unavailable") << std::endl;
+    std::cout << std::left << std::setw(22) << "Conversion" << std::setw(12) << "Scalar ms"
+        << std::setw(12) << "AVX2 ms" << std::setw(12) << "Copy ms" << "Match" << std::endl;
+
+    using Clock = std::chrono::steady_clock;
+    std::vector<uint8_t> scalar_out(count * 3), simd_out(count * 3);
+    auto time_runs = [&](const std::function<void()>& run) {
+        run();
+        const auto start = Clock::now();
+        for (uint32_t r = 0; r < iterations; ++r) run();
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count() / iterations;
+    };
+    const double copy_ms = time_runs([&]() { std::memcpy(simd_out.data(), samples.data(), samples.size()); });
+
+    struct ColorCase {
+        const char* name;
+        std::function<void(uint8_t* out, bool simd)> run;
+    };
+    const ColorCase cases[] = {
+        { "RGB planar", [&](uint8_t* out, bool simd) { convert_to_rgb(ColorModel::Rgb, samples.data(), true, count, out, simd); } },
+        { "YBR_FULL", [&](uint8_t* out, bool simd) { convert_to_rgb(ColorModel::YbrFull, samples.data(), false, count, out, simd); } },
+        { "YBR_FULL planar", [&](uint8_t* out, bool simd) { convert_to_rgb(ColorModel::YbrFull, samples.data(), true, count, out, simd); } },
+        { "YBR_FULL_422", [&](uint8_t* out, bool simd) { convert_to_rgb(ColorModel::YbrFull422, samples.data(), false, count, out, simd); } },
+        { "YBR_RCT", [&](uint8_t* out, bool simd) { convert_to_rgb(ColorModel::YbrRct, samples.data(), false, count, out, simd); } },
+        { "PALETTE 8-bit", [&](uint8_t* out, bool simd) { apply_palette(samples.data(), lut8, count, out, simd); } },
+        { "PALETTE 16-bit", [&](uint8_t* out, bool simd) { apply_palette(indices16.data(), lut16, count, out, simd); } },
+    };
+
+    for (const ColorCase& c : cases) {
+        const double scalar_ms = time_runs([&]() { c.run(scalar_out.data(), false); });
+        const double simd_ms = time_runs([&]() { c.run(simd_out.data(), true); });
+        std::cout << std::left << std::setw(22) << c.name << std::fixed << std::setprecision(2)
+            << std::setw(12) << scalar_ms << std::setw(12) << simd_ms << std::setw(12) << copy_ms
+            << (scalar_out == simd_out ? "yes" : "NO") << std::endl;
+    }
+
+    return 0;
+}
+
+// Hanging of several large images: every image decoded once into the shared
+// cache, then a linked window/level drag re-renders all viewports per step.
+// Compared against rendering the viewports one after another on one thread.
+int benchmark_viewports(const Options& options) {
+    const uint32_t size = std::max<uint32_t>(option_u32(options, "size", 7072), 16);
+    const uint32_t views = std::max<uint32_t>(option_u32(options, "views", 4), 1);
+    const uint32_t width = std::max<uint32_t>(option_u32(options, "width", 1920), 1);
+    const uint32_t height = std::max<uint32_t>(option_u32(options, "height", 1080), 1);
+    const uint32_t steps = std::max<uint32_t>(option_u32(options, "steps", 30), 1);
+    const size_t max_threads = option_u32(options, "threads",
+        static_cast<uint32_t>(ThreadPool::default_thread_count()));
+    constexpr double kFrameBudgetMs = 1000.0 / 60.0;
+
+    using Clock = std::chrono::steady_clock;
+    auto ms_since = [](Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    };
+
+    // Mammography-like views: a bright breast outline over a dark background
+    ImageCache cache;
+    auto load_view = [&](uint32_t view) {
+        return cache.get_or_load("view" + std::to_string(view), [&]() -> Result<DicomImageData, ErrorInfo> {
+            ImageData data;
+            data.width = size;
+            data.height = size;
+            data.bits_stored = 16;
+            data.bits_allocated = 16;
+            data.pixels = PixelBuffer::allocate(PixelFormat::Gray16, data.pixel_count());
+            uint16_t* pixels = data.pixels.gray16();
+            for (uint32_t y = 0; y < size; ++y) {
+                for (uint32_t x = 0; x < size; ++x) {
+                    const double dx = (view % 2 ? size - x : x) / static_cast<double>(size);
+                    const double dy = y / static_cast<double>(size) - 0.5;
+                    const uint32_t noise = (x * 73856093u ^ y * 19349663u ^ view * 83492791u) * 2654435761u >> 22;
+                    pixels[static_cast<size_t>(y) * size + x] = static_cast<uint16_t>(
+                        (dx * dx + dy * dy < 0.36 ? 30000u : 2000u) + noise * 8u);
+                }
+            }
+            DicomImageData image;
+            image.set_data(std::move(data));
+            return image;
+        });
+    };
+
+    auto start = Clock::now();
+    std::vector<ViewportRequest> requests;
+    for (uint32_t v = 0; v < views; ++v) {
+        auto image = load_view(v % 4);
+        if (image.is_error()) {
+            std::cerr << image.error().full_message() << std::endl;
+            return 1;
+        }
+        ViewportRequest request;
+        request.state.image = image.value();
+        request.state.zoom = (v < 2) ? 1.0 : 2.0 * (v - 1);   // fit, fit, 2x, 4x, ...
+        request.state.pan_x = (v < 2) ? 0.0 : size / 8.0;
+        request.width = width;
+        request.height = height;
+        requests.push_back(std::move(request));
+    }
+    const double load_ms = ms_since(start);
+    const ImageCacheStats cache_stats = cache.stats();
+
+    std::cout << "Viewport benchmark: " << views << " viewports of " << width << "x" << height << " showing "
+        << size << "x" << size << " images, " << steps << " linked window/level steps" << std::endl;
+    std::cout << "Shared cache: " << cache_stats.misses << " decodes, " << cache_stats.hits << " hits, "
+        << cache_stats.bytes / (1024 * 1024) << " MB, filled in " << std::fixed << std::setprecision(0)
+        << load_ms << " ms" << std::endl;
+    std::cout << std::left << std::setw(18) << "Renderer" << std::setw(12) << "Mean ms" << std::setw(12) << "Max ms"
+        << "Within " << std::setprecision(1) << kFrameBudgetMs << " ms" << std::endl;
+
+    auto report = [&](const std::string& name, const std::function<void(int32_t center, int32_t width)>& render) {
+        render(16000, 30000);   // warm-up: display buffers and page faults
+        double total_ms = 0.0, max_ms = 0.0;
+        uint32_t within = 0;
+        for (uint32_t step = 0; step < steps; ++step) {
+            const int32_t center = 12000 + static_cast<int32_t>(step) * 400;
+            const int32_t window = 20000 + static_cast<int32_t>(step) * 300;
+            const auto t = Clock::now();
+            render(center, window);
+            const double ms = ms_since(t);
+            total_ms += ms;
+            max_ms = std::max(max_ms, ms);
+            within += ms <= kFrameBudgetMs ? 1 : 0;
+        }
+        std::cout << std::left << std::setw(18) << name << std::fixed << std::setprecision(2)
+            << std::setw(12) << total_ms / steps << std::setw(12) << max_ms
+            << within << " / " << steps << std::endl;
+    };
+
+    // One viewport after another, each with its own window LUT and split
+    // over the shared pool on its own
+    report("one by one", [&](int32_t center, int32_t window) {
+        for (const ViewportRequest& request : requests) {
+            const ViewportPlacement placement = place_in_viewport(request.state, request.width, request.height);
+            request.state.image->render_region(placement.source, placement.width, placement.height, center, window);
+        }
+    });
+
+    for (size_t threads : thread_counts(max_threads)) {
+        ThreadPool pool(threads);
+        ViewportRenderer renderer(pool);
+        report(std::to_string(threads) + " threads", [&](int32_t center, int32_t window) {
+            for (ViewportRequest& request : requests) {
+                request.state.window_center = center;
+                request.state.window_width = window;
+            }
+            renderer.render(requests);
+        });
+    }
+
+    // Band-wise rendering must match the whole-region render
+    bool match = true;
+    const std::vector<ViewportFrame> frames = ViewportRenderer().render(requests);
+    for (size_t v = 0; v < requests.size(); ++v) {
+        const ViewportRequest& request = requests[v];
+        const ViewportPlacement& placement = frames[v].placement;
+        PixelBuffer reference = request.state.image->render_region(placement.source, placement.width,
+            placement.height, request.state.window_center, request.state.window_width);
+        match = match && reference.size_bytes() == frames[v].pixels.size_bytes() &&
+            std::memcmp(reference.gray8(), frames[v].pixels.gray8(), reference.size_bytes()) == 0;
+    }
+    std::cout << "Match: " << (match ? "yes" : "NO") << std::endl;
+
+    return 0;
+}
+
+// C-STORE receive throughput of the embedded storage server, fed by 1..N
+// storescu-style senders on concurrent associations over loopback. The
+// store rate is until every instance is acknowledged; decoding into the
+// image cache continues in the background and is timed separately.
+int benchmark_store(const Options& options) {
+    const uint32_t instances = std::max<uint32_t>(option_u32(options, "instances", 200), 1);
+    const uint32_t size = std::max<uint32_t>(option_u32(options, "size", 512), 16);
+    const uint32_t max_senders = std::max<uint32_t>(option_u32(options, "senders", 4), 1);
+    const uint16_t port = static_cast<uint16_t>(option_u32(options, "port", 11113));
+
+    using Clock = std::chrono::steady_clock;
+    auto ms_since = [](Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    };
+
+    DcmtkReader reader;
+
+    const auto dir = std::filesystem::temp_directory_path() / "dicom_viewer_bench" / "store";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir / "send");
+
+    std::vector<std::filesystem::path> files;
+    for (uint32_t i = 0; i < instances; ++i) {
+        auto written = write_test_pattern(dir / "send" / ("instance_" + std::to_string(i) + ".dcm"),
+            TestPatternSpec{ size, size, 1, 16, PixelCodec::Uncompressed });
+        if (written.is_error()) {
+            std::cerr << written.error().full_message() << std::endl;
+            return 1;
+        }
+        files.push_back(written.value());
+    }
+
+    std::cout << "Storage SCP benchmark: " << instances << " instances of " << size << "x" << size
+        << " (16-bit), loopback port " << port << std::endl;
+    std::cout << std::left << std::setw(10) << "Senders" << std::setw(12) << "Inst/s" << std::setw(10) << "MB/s"
+        << std::setw(10) << "Failed" << std::setw(16) << "Decoded" << "All decoded after" << std::endl;
+
+    for (size_t senders : thread_counts(max_senders)) {
+        StudyIndex index;
+        ImageCache cache;
+        StorageServer server(reader, index, cache);
+
+        StorageServerConfig config;
+        config.port = port;
+        config.max_associations = static_cast<uint16_t>(senders);
+        config.storage_directory = dir / ("received_" + std::to_string(senders));
+        config.max_pending_decodes = instances;
+        auto started = server.start(config);
+        if (started.is_error()) {
+            std::cerr << started.error().full_message() << std::endl;
+            return 1;
+        }
+
+        // Each sender gets every senders-th file on its own association
+        std::vector<StoreSendStats> sent(senders);
+        std::vector<std::thread> threads;
+        const auto start = Clock::now();
+        for (size_t s = 0; s < senders; ++s) {
+            threads.emplace_back([&, s]() {
+                std::vector<std::filesystem::path> share;
+                for (size_t i = s; i < files.size(); i += senders) {
+                    share.push_back(files[i]);
+                }
+                DicomPeer peer;
+                peer.port = port;
+                auto result = send_files(peer, share);
+                if (result.is_error()) {
+                    std::cerr << result.error().full_message() << std::endl;
+                    sent[s].failed = static_cast<uint32_t>(share.size());
+                }
+                else {
+                    sent[s] = result.value();
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        const double store_ms = ms_since(start);
+        server.wait_idle();
+        const double decoded_ms = ms_since(start);
+        server.stop();
+
+        uint32_t failed = 0;
+        uint64_t bytes = 0;
+        for (const StoreSendStats& stats : sent) {
+            failed += stats.failed;
+            bytes += stats.bytes;
+        }
+        const StorageServerStats stats = server.stats();
+        std::cout << std::left << std::setw(10) << senders << std::fixed << std::setprecision(1)
+            << std::setw(12) << stats.instances_received * 1000.0 / store_ms
+            << std::setw(10) << bytes / (1024.0 * 1024.0) * 1000.0 / store_ms
+            << std::setw(10) << failed
+            << std::setw(16) << (std::to_string(stats.instances_decoded) + " / " + std::to_string(index.instance_count()))
+            << std::setprecision(0) << decoded_ms << " ms (acks after " << store_ms << " ms)" << std::endl;
+
+        std::filesystem::remove_all(config.storage_directory);
+    }
+
+    std::filesystem::remove_all(dir);
+    return 0;
+}
+
+int benchmark_retrieve(const Options& options) {
+    const uint32_t instances = std::max<uint32_t>(option_u32(options, "instances", 100), 1);
+    const uint32_t size = std::max<uint32_t>(option_u32(options, "size", 512), 16);
+    const uint32_t batch = std::max<uint32_t>(option_u32(options, "batch", 8), 1);
+    const uint16_t port = static_cast<uint16_t>(option_u32(options, "port", 11114));
+    const uint16_t storage_port = static_cast<uint16_t>(port + 1);
+
+    using Clock = std::chrono::steady_clock;
+    auto ms_since = [](Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    };
+
+    DcmtkReader reader;
+
+    const auto dir = std::filesystem::temp_directory_path() / "dicom_viewer_bench" / "retrieve";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir / "pacs" / "files");
+
+    // One series, instance numbers in slice order
+    TestPatternSpec spec{ size, size, 1, 16, PixelCodec::Uncompressed };
+    spec.study_instance_uid = make_test_uid();
+    spec.series_instance_uid = make_test_uid();
+    std::vector<std::filesystem::path> files;
+    for (uint32_t i = 0; i < instances; ++i) {
+        spec.instance_number = static_cast<int32_t>(i + 1);
+        auto written = write_test_pattern(dir / "pacs" / "files" / ("slice_" + std::to_string(i) + ".dcm"), spec);
+        if (written.is_error()) {
+            std::cerr << written.error().full_message() << std::endl;
+            return 1;
+        }
+        files.push_back(written.value());
+    }
+
+    TestPacsConfig pacs_config;
+    pacs_config.port = port;
+    pacs_config.storage_directory = dir / "pacs";
+    DicomPeer destination;
+    destination.port = storage_port;
+    pacs_config.move_destinations.push_back(destination);
+    TestPacs pacs(pacs_config);
+    auto added = pacs.add_files(files);
+    if (added.is_error()) {
+        std::cerr << added.error().full_message() << std::endl;
+        return 1;
+    }
+    auto started = pacs.start();
+    if (started.is_error()) {
+        std::cerr << started.error().full_message() << std::endl;
+        return 1;
+    }
+    const DicomPeer peer = pacs.peer();
+
+    auto start = Clock::now();
+    auto studies = find_studies(peer, StudyQuery{});
+    if (studies.is_error() || studies.value().empty()) {
+        std::cerr << (studies.is_error() ? studies.error().full_message() : "No study found") << std::endl;
+        return 1;
+    }
+    const std::string study_uid = studies.value().front().study_instance_uid;
+    auto series = find_series(peer, study_uid);
+    if (series.is_error() || series.value().empty()) {
+        std::cerr << (series.is_error() ? series.error().full_message() : "No series found") << std::endl;
+        return 1;
+    }
+    const std::string series_uid = series.value().front().series_instance_uid;
+    auto matches = find_instances(peer, study_uid, series_uid);
+    if (matches.is_error()) {
+        std::cerr << matches.error().full_message() << std::endl;
+        return 1;
+    }
+    const std::vector<InstanceMatch>& slices = matches.value();
+    const double find_ms = ms_since(start);
+
+    // The viewer sits on the middle slice, e.g. after jumping there
+    const size_t focus = slices.size() / 2;
+    const std::string focus_uid = slices.empty() ? std::string() : slices[focus].sop_instance_uid;
+
+    std::cout << "Retrieve benchmark: " << added.value() << " instances of " << size << "x" << size
+        << " (16-bit) from a local dcmqrdb SCP, focus on slice " << focus + 1 << std::endl;
+    std::cout << "C-FIND study/series/instances: " << std::fixed << std::setprecision(1) << find_ms
+        << " ms, " << slices.size() << " instances" << std::endl;
+    std::cout << std::left << std::setw(26) << "Method" << std::setw(14) << "First image" << std::setw(14)
+        << "Focus slice" << std::setw(14) << "All decoded" << std::setw(10) << "Inst/s" << std::setw(10)
+        << "MB/s" << "Failed" << std::endl;
+
+    // Decode completion times, from the ingest handler on receiving and pool threads
+    struct Timeline {
+        std::mutex mutex;
+        Clock::time_point start;
+        double first_ms = -1.0;
+        double focus_ms = -1.0;
+    };
+    auto make_handler = [&](Timeline& timeline) {
+        return [&timeline, &focus_uid, ms_since](const InstanceRecord& record) {
+            if (!record.decoded) {
+                return;
+            }
+            std::lock_guard lock(timeline.mutex);
+            const double now = ms_since(timeline.start);
+            if (timeline.first_ms < 0.0) {
+                timeline.first_ms = now;
+            }
+            if (record.sop_instance_uid == focus_uid) {
+                timeline.focus_ms = now;
+            }
+        };
+    };
+    auto report = [&](const std::string& method, Timeline& timeline, double decoded_ms,
+        uint64_t received, uint64_t bytes, uint64_t failed, double transfer_ms) {
+        std::lock_guard lock(timeline.mutex);
+        std::cout << std::left << std::setw(26) << method << std::fixed << std::setprecision(1)
+            << std::setw(14) << (std::to_string(static_cast<int>(timeline.first_ms)) + " ms")
+            << std::setw(14) << (std::to_string(static_cast<int>(timeline.focus_ms)) + " ms")
+            << std::setw(14) << (std::to_string(static_cast<int>(decoded_ms)) + " ms")
+            << std::setw(10) << received * 1000.0 / transfer_ms
+            << std::setw(10) << bytes / (1024.0 * 1024.0) * 1000.0 / transfer_ms
+            << failed << std::endl;
+    };
+
+    // C-MOVE: the PACS opens an association to our storage SCP and sends the series in its own order
+    {
+        StudyIndex index;
+        ImageCache cache;
+        StorageServer server(reader, index, cache);
+        Timeline timeline;
+        server.set_instance_handler(make_handler(timeline));
+
+        StorageServerConfig config;
+        config.port = storage_port;
+        config.storage_directory = dir / "move";
+        config.max_pending_decodes = instances;
+        auto listening = server.start(config);
+        if (listening.is_error()) {
+            std::cerr << listening.error().full_message() << std::endl;
+            return 1;
+        }
+
+        timeline.start = Clock::now();
+        auto moved = move_series(peer, config.ae_title, study_uid, series_uid);
+        const double transfer_ms = ms_since(timeline.start);
+        server.wait_idle();
+        const double decoded_ms = ms_since(timeline.start);
+        server.stop();
+        if (moved.is_error()) {
+            std::cerr << moved.error().full_message() << std::endl;
+            return 1;
+        }
+
+        const StorageServerStats stats = server.stats();
+        report("C-MOVE series", timeline, decoded_ms, stats.instances_received, stats.bytes_received,
+            moved.value().failed, transfer_ms);
+    }
+
+    // C-GET on the viewer's own association: once as one request, once in focus-ordered batches
+    const uint32_t batch_sizes[] = { static_cast<uint32_t>(std::max<size_t>(slices.size(), 1)), batch };
+    for (uint32_t batch_size : batch_sizes) {
+        StudyIndex index;
+        ImageCache cache;
+        InstanceIngest ingest(reader, index, cache);
+        Timeline timeline;
+        ingest.configure(IngestConfig{ dir / ("get_" + std::to_string(batch_size)), instances });
+        ingest.set_handler(make_handler(timeline));
+
+        SeriesRetriever retriever(ingest);
+        retriever.set_batch_size(batch_size);
+        retriever.set_focus(focus);
+
+        timeline.start = Clock::now();
+        auto retrieved = retriever.retrieve(peer, study_uid, series_uid, slices);
+        ingest.wait_idle();
+        const double decoded_ms = ms_since(timeline.start);
+        if (retrieved.is_error()) {
+            std::cerr << retrieved.error().full_message() << std::endl;
+            return 1;
+        }
+
+        const RetrieveStats& stats = retrieved.value();
+        const std::string method = batch_size >= slices.size()
+            ? std::string("C-GET series")
+            : "C-GET batches of " + std::to_string(batch_size);
+        report(method, timeline, decoded_ms, stats.received, stats.bytes, stats.failed, stats.total_ms);
+    }
+
+    pacs.stop();
+    std::filesystem::remove_all(dir);
+    return 0;
+}
+
+// WADO-RS from a local server replaying recorded responses, paced like a
+// WAN link. The series response is either downloaded whole and then parsed,
+// or parsed and ingested part by part while it downloads; frames of a
+// multi-frame instance come back as application/octet-stream parts.
+int benchmark_dicomweb(const Options& options) {
+    const uint32_t instances = std::max<uint32_t>(option_u32(options, "instances", 50), 1);
+    const uint32_t size = std::max<uint32_t>(option_u32(options, "size", 512), 16);
+    const uint32_t frames = std::max<uint32_t>(option_u32(options, "frames", 32), 1);
+    const uint32_t mbit = option_u32(options, "mbit", 200);
+    const uint16_t port = static_cast<uint16_t>(option_u32(options, "port", 8042));
+
+    using Clock = std::chrono::steady_clock;
+    auto ms_since = [](Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    };
+
+    DcmtkReader reader;
+
+    const auto dir = std::filesystem::temp_directory_path() / "dicom_viewer_bench" / "dicomweb";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir / "files");
+
+    TestPatternSpec spec{ size, size, 1, 16, PixelCodec::Uncompressed };
+    spec.study_instance_uid = make_test_uid();
+    spec.series_instance_uid = make_test_uid();
+    std::vector<std::filesystem::path> files;
+    uint64_t series_bytes = 0;
+    for (uint32_t i = 0; i < instances; ++i) {
+        spec.instance_number = static_cast<int32_t>(i + 1);
+        auto written = write_test_pattern(dir / "files" / ("slice_" + std::to_string(i) + ".dcm"), spec);
+        if (written.is_error()) {
+            std::cerr << written.error().full_message() << std::endl;
+            return 1;
+        }
+        series_bytes += std::filesystem::file_size(written.value());
+        files.push_back(written.value());
+    }
+    auto multi_frame = write_test_pattern(dir / "files" / "multi_frame.dcm",
+        TestPatternSpec{ size, size, frames, 16, PixelCodec::Uncompressed });
+    if (multi_frame.is_error()) {
+        std::cerr << multi_frame.error().full_message() << std::endl;
+        return 1;
+    }
+    std::vector<uint32_t> frame_numbers;
+    for (uint32_t i = 1; i <= frames; ++i) {
+        frame_numbers.push_back(i);
+    }
+
+    TestDicomWebConfig server_config;
+    server_config.port = port;
+    server_config.storage_directory = dir / "server";
+    server_config.bytes_per_second = uint64_t(mbit) * 1000 * 1000 / 8;
+    TestDicomWebServer server(server_config);
+    auto series_url = server.add_series(files);
+    auto instance_url = series_url.is_ok() ? server.add_frames(multi_frame.value(), frame_numbers)
+                                           : Result<std::string, ErrorInfo>(series_url.error());
+    if (instance_url.is_error()) {
+        std::cerr << instance_url.error().full_message() << std::endl;
+        return 1;
+    }
+    auto started = server.start();
+    if (started.is_error()) {
+        std::cerr << started.error().full_message() << std::endl;
+        return 1;
+    }
+
+    std::cout << "DICOMweb benchmark: " << instances << " instances of " << size << "x" << size << " (16-bit), "
+        << std::fixed << std::setprecision(1) << series_bytes / (1024.0 * 1024.0) << " MB, served at "
+        << (mbit == 0 ? std::string("loopback speed") : std::to_string(mbit) + " Mbit/s") << std::endl;
+    std::cout << std::left << std::setw(28) << "Method" << std::setw(14) << "First image" << std::setw(14)
+        << "All decoded" << std::setw(10) << "Parts/s" << std::setw(10) << "MB/s" << "Failed" << std::endl;
+
+    auto report = [&](const std::string& method, double first_ms, double all_ms, uint64_t parts,
+        uint64_t bytes, uint64_t failed) {
+        std::cout << std::left << std::setw(28) << method << std::fixed << std::setprecision(1)
+            << std::setw(14) << (std::to_string(static_cast<int>(first_ms)) + " ms")
+            << std::setw(14) << (std::to_string(static_cast<int>(all_ms)) + " ms")
+            << std::setw(10) << parts * 1000.0 / all_ms
+            << std::setw(10) << bytes / (1024.0 * 1024.0) * 1000.0 / all_ms
+            << failed << std::endl;
+    };
+
+    for (bool streaming : { false, true }) {
+        StudyIndex index;
+        ImageCache cache;
+        InstanceIngest ingest(reader, index, cache);
+        ingest.configure(IngestConfig{ dir / (streaming ? "streamed" : "buffered"), instances });
+
+        // First decode completion, from a pool thread
+        std::mutex mutex;
+        double first_ms = -1.0;
+        const auto start = Clock::now();
+        ingest.set_handler([&](const InstanceRecord& record) {
+            std::lock_guard lock(mutex);
+            if (record.decoded && first_ms < 0.0) {
+                first_ms = ms_since(start);
+            }
+        });
+
+        uint64_t bytes = 0;
+        uint32_t received = 0;
+        uint32_t failed = 0;
+        if (streaming) {
+            DicomWebRetriever retriever(ingest);
+            auto retrieved = retriever.retrieve(series_url.value());
+            if (retrieved.is_error()) {
+                std::cerr << retrieved.error().full_message() << std::endl;
+                return 1;
+            }
+            bytes = retrieved.value().bytes;
+            received = retrieved.value().received;
+            failed = retrieved.value().failed;
+        }
+        else {
+            // What a plain HTTP client would do: the whole body in memory first
+            std::vector<char> body;
+            std::string content_type;
+            auto response = http_get(parse_http_url(series_url.value()).value(),
+                "multipart/related; type=\"application/dicom\"",
+                [&](const HttpResponse& response) {
+                    content_type = response.content_type;
+                    return true;
+                },
+                [&](const char* data, size_t size) {
+                    body.insert(body.end(), data, data + size);
+                    return true;
+                });
+            auto type = parse_multipart_content_type(content_type);
+            if (response.is_error() || !type) {
+                std::cerr << (response.is_error() ? response.error().full_message() : "Not multipart") << std::endl;
+                return 1;
+            }
+            DicomMultipartReader parts(ingest, type->boundary);
+            auto fed = parts.feed(body.data(), body.size());
+            if (fed.is_error()) {
+                std::cerr << fed.error().full_message() << std::endl;
+                return 1;
+            }
+            bytes = body.size();
+            received = parts.instances();
+            failed = parts.failed();
+        }
+        ingest.wait_idle();
+        const double decoded_ms = ms_since(start);
+
+        std::lock_guard lock(mutex);
+        report(streaming ? "Streamed, parsed per part" : "Buffered, then parsed", first_ms, decoded_ms,
+            received, bytes, failed + (instances - std::min(instances, received + failed)));
+    }
+
+    // Frames are handed over raw, so delivery is the end of the line here
+    const size_t frame_bytes = size_t(size) * size * 2;
+    uint32_t wrong_size = 0;
+    auto retrieved_frames = retrieve_frames(instance_url.value(), frame_numbers,
+        [&](uint32_t, std::vector<uint8_t> bytes) {
+            wrong_size += bytes.size() != frame_bytes;
+            return true;
+        });
+    if (retrieved_frames.is_error()) {
+        std::cerr << retrieved_frames.error().full_message() << std::endl;
+        return 1;
+    }
+    const DicomWebStats& frame_stats = retrieved_frames.value();
+    report("Frames, octet-stream", frame_stats.first_part_ms, frame_stats.total_ms, frame_stats.received,
+        frame_stats.bytes, frame_stats.failed + wrong_size);
+
+    server.stop();
+    std::filesystem::remove_all(dir);
+    return 0;
+}
+
+// Lossless export of an uncompressed study: frames encoded across workers, files streamed out
+int benchmark_transcode(const Options& options) {
+    const uint32_t instances = option_u32(options, "instances", 32);
+    const uint32_t frames = option_u32(options, "frames", 4);
+    const uint32_t size = option_u32(options, "size", 512);
+    const size_t max_threads = option_u32(options, "threads",
+        static_cast<uint32_t>(ThreadPool::default_thread_count()));
+    const double mb = 1024.0 * 1024.0;
+
+    const auto dir = std::filesystem::temp_directory_path() / "dicom_viewer_bench_transcode";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir / "in");
+
+    const std::string study_uid = make_test_uid();
+    const std::string series_uid = make_test_uid();
+    std::vector<std::filesystem::path> files;
+    for (uint32_t i = 0; i < instances; ++i) {
+        const auto path = dir / "in" / ("instance_" + std::to_string(i) + ".dcm");
+        auto written = write_test_pattern(path, TestPatternSpec{ size, size, frames, 16, PixelCodec::Uncompressed,
+            study_uid, series_uid, static_cast<int32_t>(i + 1) });
+        if (written.is_error()) {
+            std::cerr << written.error().full_message() << std::endl;
+            return 1;
+        }
+        files.push_back(path);
+    }
+
+    std::cout << "Transcode benchmark: " << instances << " instances of " << frames << " frames, "
+        << size << "x" << size << " 16-bit" << std::endl;
+    std::cout << std::left << std::setw(20) << "Codec" << std::setw(10) << "Workers" << std::setw(12) << "Frames/s"
+        << std::setw(10) << "MB/s" << std::setw(8) << "Ratio" << std::setw(10) << "Speedup"
+        << std::setw(12) << "Peak MB" << "Failed" << std::endl;
+
+    for (TranscodeCodec codec : { TranscodeCodec::JpegLsLossless, TranscodeCodec::Rle }) {
+        double baseline = 0.0;
+        for (size_t threads : thread_counts(max_threads)) {
+            std::filesystem::remove_all(dir / "out");
+            ThreadPool pool(threads);
+            StudyTranscoder transcoder(codec, pool);
+            reset_peak_memory();
+            const uint64_t resident_before = current_memory_usage().resident_bytes;
+
+            auto result = transcoder.transcode(files, dir / "out");
+            if (result.is_error()) {
+                std::cerr << "Transcode failed: " << result.error().full_message() << std::endl;
+                return 1;
+            }
+            const TranscodeStats& stats = result.value();
+            const uint64_t peak = current_memory_usage().peak_resident_bytes;
+            if (threads == 1) {
+                baseline = stats.megabytes_per_second();
+            }
+
+            std::cout << std::left << std::setw(20) << transcode_codec_name(codec) << std::setw(10) << threads
+                << std::fixed << std::setprecision(1)
+                << std::setw(12) << (stats.total_ms > 0 ? stats.frames * 1000.0 / stats.total_ms : 0.0)
+                << std::setw(10) << stats.megabytes_per_second()
+                << std::setprecision(2) << std::setw(8) << stats.compression_ratio()
+                << std::setw(9) << (baseline > 0 ? stats.megabytes_per_second() / baseline : 0.0) << " "
+                << std::setprecision(1) << std::setw(12)
+                << (peak > resident_before ? (peak - resident_before) / mb : 0.0)
+                << stats.failed << std::endl;
+        }
+    }
+
+    std::filesystem::remove_all(dir);
+    return 0;
+}
+
+int benchmark_anonymize(const Options& options) {
+    const uint32_t instances = option_u32(options, "instances", 64);
+    const uint32_t frames = option_u32(options, "frames", 4);
+    const uint32_t size = option_u32(options, "size", 512);
+    const size_t max_threads = option_u32(options, "threads",
+        static_cast<uint32_t>(ThreadPool::default_thread_count()));
+    const double mb = 1024.0 * 1024.0;
+
+    const auto dir = std::filesystem::temp_directory_path() / "dicom_viewer_bench_anonymize";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir / "in");
+
+    // Native and encapsulated pixel data alike are copied without decoding
+    const std::string study_uid = make_test_uid();
+    const std::string series_uid = make_test_uid();
+    std::vector<std::filesystem::path> files;
+    uint64_t input_bytes = 0;
+    for (uint32_t i = 0; i < instances; ++i) {
+        const auto path = dir / "in" / ("instance_" + std::to_string(i) + ".dcm");
+        const PixelCodec codec = i % 2 == 0 ? PixelCodec::Uncompressed : PixelCodec::JpegLsLossless;
+        auto written = write_test_pattern(path, TestPatternSpec{ size, size, frames, 16, codec,
+            study_uid, series_uid, static_cast<int32_t>(i + 1) });
+        if (written.is_error()) {
+            std::cerr << written.error().full_message() << std::endl;
+            return 1;
+        }
+        files.push_back(path);
+        input_bytes += std::filesystem::file_size(path);
+    }
+
+    // A plain file copy of the same input is the bandwidth to compare with
+    std::filesystem::create_directories(dir / "copy");
+    const auto copy_start = std::chrono::steady_clock::now();
+    for (const auto& file : files) {
+        std::filesystem::copy_file(file, dir / "copy" / file.filename());
+    }
+    const double copy_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - copy_start).count();
+    const double copy_rate = copy_ms > 0 ? input_bytes / mb / (copy_ms / 1000.0) : 0.0;
+    std::filesystem::remove_all(dir / "copy");
+
+    std::cout << "Anonymize benchmark: " << instances << " instances of " << frames << " frames, "
+        << size << "x" << size << " 16-bit, native and JPEG-LS, " << std::fixed << std::setprecision(1)
+        << input_bytes / mb << " MB" << std::endl;
+    std::cout << std::left << std::setw(14) << "Method" << std::setw(10) << "Workers" << std::setw(10) << "Files/s"
+        << std::setw(10) << "MB/s" << std::setw(10) << "Of copy" << std::setw(10) << "Speedup" << "Failed" << std::endl;
+    std::cout << std::left << std::setw(14) << "File copy" << std::setw(10) << 1
+        << std::setw(10) << (copy_ms > 0 ? instances * 1000.0 / copy_ms : 0.0)
+        << std::setw(10) << copy_rate << std::setw(10) << "100%" << std::setw(10) << "-" << 0 << std::endl;
+
+    double baseline = 0.0;
+    for (size_t threads : thread_counts(max_threads)) {
+        std::filesystem::remove_all(dir / "out");
+        ThreadPool pool(threads);
+        StudyAnonymizer anonymizer(AnonymizationProfile::basic(), pool);
+        auto result = anonymizer.anonymize(files, dir / "out");
+        if (result.is_error()) {
+            std::cerr << "Anonymize failed: " << result.error().full_message() << std::endl;
+            return 1;
+        }
+        const AnonymizeStats& stats = result.value();
+        if (threads == 1) {
+            baseline = stats.megabytes_per_second();
+        }
+        std::cout << std::left << std::setw(14) << "Anonymize" << std::setw(10) << threads
+            << std::setw(10) << (stats.total_ms > 0 ? stats.files * 1000.0 / stats.total_ms : 0.0)
+            << std::setw(10) << stats.megabytes_per_second()
+            << std::setw(10) << (std::to_string(static_cast<int>(copy_rate > 0
+                ? 100.0 * stats.megabytes_per_second() / copy_rate + 0.5 : 0.0)) + "%")
+            << std::setw(10) << (baseline > 0 ? stats.megabytes_per_second() / baseline : 0.0)
+            << stats.failed << std::endl;
+    }
+
+    // Untimed check of the last output: identical pixel bytes, no patient name,
+    // and a meta header naming the new SOP Instance UID
+    std::filesystem::remove_all(dir / "out");
+    StudyAnonymizer verifier(AnonymizationProfile::basic());
+    verifier.set_verify_pixels(true);
+    auto verified = verifier.anonymize(files, dir / "out");
+    if (verified.is_error()) {
+        std::cerr << "Anonymize failed: " << verified.error().full_message() << std::endl;
+        return 1;
+    }
+    uint32_t named = 0;
+    uint32_t stale_meta = 0;
+    DcmtkReader reader;
+    for (const auto& output : collect_files({ dir / "out" })) {
+        auto metadata = reader.load_metadata(output);
+        if (metadata.is_error() || !metadata.value().patient_name.value_or("").empty()) {
+            ++named;
+        }
+        auto meta_matches = meta_header_matches_dataset(output);
+        if (meta_matches.is_error() || !meta_matches.value()) {
+            ++stale_meta;
+        }
+    }
+    std::cout << "Pixel data identical: " << verified.value().verified << " / " << instances
+        << ", files with a patient name left: " << named
+        << ", meta headers with the old SOP Instance UID: " << stale_meta << std::endl;
+
+    std::filesystem::remove_all(dir);
+    return verified.value().verified == instances && named == 0 && stale_meta == 0 ? 0 : 1;
+}
+
+// Thumbnails per second by source, against a full load, cold and cached
+int benchmark_thumbnails(const Options& options) {
+    const uint32_t count = option_u32(options, "count", 32);
+    const uint32_t size = option_u32(options, "size", 2048);
+    const uint32_t thumb = option_u32(options, "thumb", 128);
+    const uint32_t full_loads = std::min<uint32_t>(count, 4);
+
+    DcmtkReader reader;
+
+    const auto dir = std::filesystem::temp_directory_path() / "dicom_viewer_bench_thumbnails";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+
+    struct Source {
+        const char* name;
+        uint16_t bits;
+        PixelCodec codec;
+        uint32_t icon_size;
+    };
+    const Source sources[] = {
+        { "Native 16-bit", 16, PixelCodec::Uncompressed, 0 },
+        { "JPEG Baseline", 8, PixelCodec::JpegBaseline, 0 },
+        { "JPEG + icon", 8, PixelCodec::JpegBaseline, thumb },
+        { "JPEG-LS 16-bit", 16, PixelCodec::JpegLsLossless, 0 },
+    };
+    const char* const source_names[] = { "strided", "icon", "scaled JPEG", "full decode" };
+
+    std::cout << "Thumbnail benchmark: " << count << " images of " << size << "x" << size
+        << ", thumbnails of " << thumb << std::endl;
+    std::cout << std::left << std::setw(16) << "Source" << std::setw(26) << "Method" << std::setw(12) << "Per second"
+        << std::setw(10) << "ms each" << "Speedup" << std::endl;
+
+    for (const Source& source : sources) {
+        std::vector<std::filesystem::path> files;
+        for (uint32_t i = 0; i < count; ++i) {
+            const auto path = dir / (std::string("in_") + std::to_string(files.size()) + "_" +
+                std::to_string(static_cast<int>(source.codec)) + "_" + std::to_string(source.icon_size) + ".dcm");
+            TestPatternSpec spec{ size, size, 1, source.bits, source.codec };
+            spec.icon_size = source.icon_size;
+            auto written = write_test_pattern(path, spec);
+            if (written.is_error()) {
+                std::cerr << "Skipping " << source.name << ": " << written.error().full_message() << std::endl;
+                break;
+            }
+            files.push_back(path);
+        }
+        if (files.size() != count) {
+            continue;
+        }
+
+        auto rate = [](uint32_t n, std::chrono::steady_clock::time_point start) {
+            const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            return std::make_pair(ms > 0 ? n * 1000.0 / ms : 0.0, n > 0 ? ms / n : 0.0);
+        };
+        auto print = [&](const std::string& method, std::pair<double, double> measured, double baseline) {
+            std::cout << std::left << std::setw(16) << source.name << std::setw(26) << method
+                << std::fixed << std::setprecision(1) << std::setw(12) << measured.first
+                << std::setprecision(2) << std::setw(10) << measured.second
+                << std::setprecision(1) << (baseline > 0 ? measured.first / baseline : 0.0) << "x" << std::endl;
+        };
+
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < full_loads; ++i) {
+            auto image = reader.load_image(files[i]);
+            if (image.is_error()) {
+                std::cerr << "Load failed: " << image.error().full_message() << std::endl;
+                return 1;
+            }
+        }
+        const auto full = rate(full_loads, start);
+        print("Full load", full, full.first);
+
+        ThumbnailCache cache(ThumbnailCacheConfig{ dir / ("cache_" + std::to_string(static_cast<int>(source.codec)) +
+            "_" + std::to_string(source.icon_size)), 64ull * 1024 * 1024 });
+        std::string method = "Thumbnail";
+        start = std::chrono::steady_clock::now();
+        for (const auto& file : files) {
+            auto loaded = reader.load_thumbnail(file, thumb, &cache);
+            if (loaded.is_error()) {
+                std::cerr << "Thumbnail failed: " << loaded.error().full_message() << std::endl;
+                return 1;
+            }
+            if (loaded.value().source) {
+                method = std::string("Thumbnail, ") + source_names[static_cast<int>(*loaded.value().source)];
+            }
+        }
+        print(method, rate(count, start), full.first);
+
+        start = std::chrono::steady_clock::now();
+        uint32_t hits = 0;
+        for (const auto& file : files) {
+            auto loaded = reader.load_thumbnail(file, thumb, &cache);
+            hits += loaded.is_ok() && !loaded.value().source ? 1 : 0;
+        }
+        print("Thumbnail, cached", rate(count, start), full.first);
+        if (hits != count) {
+            std::cerr << "Only " << hits << " of " << count << " thumbnails came from the cache" << std::endl;
+            return 1;
+        }
+        std::cout << std::left << std::setw(16) << "" << "cache: " << cache.entry_count() << " entries, "
+            << cache.size_bytes() / 1024 << " KB" << std::endl;
+
+        for (const auto& file : files) {
+            std::filesystem::remove(file);
+        }
+    }
+
+    std::filesystem::remove_all(dir);
+    return 0;
+}
+
+// ROI statistics while dragging: summed-area table build time versus worker
+// count, then per-query time of the tables against visiting every pixel
+int benchmark_roi(const Options& options) {
+    const uint32_t size = std::max<uint32_t>(option_u32(options, "size", 4096), 16);
+    const uint32_t queries = std::max<uint32_t>(option_u32(options, "queries", 200), 1);
+    const size_t max_threads = option_u32(options, "threads",
+        static_cast<uint32_t>(ThreadPool::default_thread_count()));
+    using Clock = std::chrono::steady_clock;
+
+    // A CT-like slice: samples cover -1024 to 3071 HU
+    ImageData img_data;
+    img_data.width = size;
+    img_data.height = size;
+    img_data.bits_allocated = 16;
+    img_data.bits_stored = 16;
+    img_data.modality = ModalityMapping{ 4096.0 / 65535.0, -1024.0 };
+    img_data.pixels = PixelBuffer::allocate(PixelFormat::Gray16, img_data.pixel_count());
+    uint16_t* pixels = img_data.pixels.gray16();
+    for (uint32_t y = 0; y < size; ++y) {
+        for (uint32_t x = 0; x < size; ++x) {
+            const double dx = x - size * 0.5, dy = y - size * 0.5;
+            const uint32_t ring = static_cast<uint32_t>(std::sqrt(dx * dx + dy * dy)) / 32;
+            const uint32_t noise = (x * 73856093u ^ y * 19349663u) * 2654435761u >> 22;
+            pixels[static_cast<size_t>(y) * size + x] = static_cast<uint16_t>((ring * 4001u + noise * 8u) & 0xFFFF);
+        }
+    }
+    DicomImageData image;
+    image.set_data(std::move(img_data));
+
+    std::cout << "ROI benchmark: " << size << "x" << size << " image, " << queries << " queries per shape" << std::endl;
+    std::cout << std::left << std::setw(10) << "Workers" << std::setw(12) << "Build ms" << "Table MB" << std::endl;
+    SummedAreaTable table;
+    for (size_t threads : thread_counts(max_threads)) {
+        ThreadPool pool(threads);
+        const auto start = Clock::now();
+        table = SummedAreaTable::build(image, pool);
+        const double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        std::cout << std::left << std::setw(10) << threads << std::fixed << std::setprecision(1)
+            << std::setw(12) << ms << table.memory_bytes() / (1024.0 * 1024.0) << std::endl;
+    }
+
+    // ROIs from 8 pixels to half the image across, as while dragging
+    uint32_t seed = 12345;
+    auto next = [&seed](uint32_t range) {
+        seed = seed * 1103515245u + 12345u;
+        return (seed >> 8) % range;
+    };
+    struct Query {
+        uint32_t x0, y0, x1, y1;
+    };
+    std::vector<Query> boxes;
+    for (uint32_t i = 0; i < queries; ++i) {
+        const uint32_t w = 8 + next(size / 2), h = 8 + next(size / 2);
+        const uint32_t x0 = next(size - w), y0 = next(size - h);
+        boxes.push_back({ x0, y0, x0 + w, y0 + h });
+    }
+
+    std::cout << std::left << std::setw(12) << "Shape" << std::setw(14) << "Table us" << std::setw(14) << "Scan us"
+        << std::setw(10) << "Speedup" << "Max mean diff (HU)" << std::endl;
+    for (const char* shape : { "Rectangle", "Ellipse" }) {
+        const bool ellipse = std::string_view(shape) == "Ellipse";
+        std::vector<std::vector<RowSpan>> regions;
+        for (const Query& q : boxes) {
+            if (ellipse) {
+                regions.push_back(ellipse_spans((q.x0 + q.x1) * 0.5, (q.y0 + q.y1) * 0.5,
+                    (q.x1 - q.x0) * 0.5, (q.y1 - q.y0) * 0.5, size, size));
+            }
+            else {
+                std::vector<RowSpan> spans;
+                for (uint32_t y = q.y0; y < q.y1; ++y) {
+                    spans.push_back({ y, q.x0, q.x1 });
+                }
+                regions.push_back(std::move(spans));
+            }
+        }
+
+        // Ellipse spans are computed per query, as the drag changes the shape
+        std::vector<RoiStatistics> fast(queries), slow(queries);
+        auto start = Clock::now();
+        for (uint32_t i = 0; i < queries; ++i) {
+            const Query& q = boxes[i];
+            fast[i] = ellipse
+                ? table.spans(ellipse_spans((q.x0 + q.x1) * 0.5, (q.y0 + q.y1) * 0.5,
+                      (q.x1 - q.x0) * 0.5, (q.y1 - q.y0) * 0.5, size, size))
+                : table.rectangle(q.x0, q.y0, q.x1, q.y1);
+        }
+        const double fast_us = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / queries;
+
+        start = Clock::now();
+        for (uint32_t i = 0; i < queries; ++i) {
+            slow[i] = scan_roi_statistics(image, regions[i]);
+        }
+        const double slow_us = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / queries;
+
+        double max_diff = 0.0;
+        for (uint32_t i = 0; i < queries; ++i) {
+            if (fast[i].pixels != slow[i].pixels || fast[i].min != slow[i].min || fast[i].max != slow[i].max) {
+                std::cerr << shape << " " << i << ": table and scan disagree" << std::endl;
+                return 1;
+            }
+            max_diff = std::max({ max_diff, std::abs(fast[i].mean - slow[i].mean),
+                std::abs(fast[i].std_dev - slow[i].std_dev) });
+        }
+
+        std::cout << std::left << std::setw(12) << shape << std::fixed << std::setprecision(2)
+            << std::setw(14) << fast_us << std::setw(14) << slow_us << std::setprecision(1)
+            << std::setw(10) << (fast_us > 0 ? slow_us / fast_us : 0.0) << std::scientific << std::setprecision(1)
+            << max_diff << std::defaultfloat << std::endl;
+    }
+
+    return 0;
+}
+
+// Interactive latency of the shared scheduler while background work floods
+// it: how long a render loop and a visible decode take to get going when
+// every worker is busy with indexing tasks, compared with the same flood
+// submitted in the render class, where nothing can overtake it. Also checks
+// that nested parallel loops finish and that cancelled tasks never run.
+int benchmark_scheduler(const Options& options) {
+    const uint32_t background_tasks = std::max<uint32_t>(option_u32(options, "tasks", 400), 1);
+    const uint32_t task_us = std::max<uint32_t>(option_u32(options, "task-us", 2000), 1);
+    const size_t threads = std::max<uint32_t>(option_u32(options, "threads",
+        static_cast<uint32_t>(ThreadPool::default_thread_count())), 1);
+    using Clock = std::chrono::steady_clock;
+
+    auto spin = [](std::chrono::microseconds duration) {
+        const auto end = Clock::now() + duration;
+        while (Clock::now() < end) {
+        }
+    };
+    auto ms_since = [](Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    };
+
+    // A 2048-row render split over the pool, 10 us of work per row
+    auto render = [&](ThreadPool& pool) {
+        const auto start = Clock::now();
+        pool.parallel_for(2048, [&](size_t begin, size_t end) {
+            spin(std::chrono::microseconds(10 * (end - begin)));
+        });
+        return ms_since(start);
+    };
+    // Time from submission until a visible decode task starts
+    auto visible_wait = [&](ThreadPool& pool) {
+        const auto submitted = Clock::now();
+        return pool.submit([&]() { return ms_since(submitted); }, TaskPriority::VisibleDecode).get();
+    };
+
+    std::cout << "Scheduler benchmark: " << threads << " workers (one reserved), " << background_tasks
+        << " background tasks of " << task_us << " us" << std::endl;
+    std::cout << std::left << std::setw(26) << "Background class" << std::setw(14) << "Render ms"
+        << std::setw(20) << "Visible wait ms" << "Flood drained ms" << std::endl;
+
+    ThreadPool idle_pool(threads, 1);
+    std::cout << std::left << std::setw(26) << "(idle)" << std::fixed << std::setprecision(2)
+        << std::setw(14) << render(idle_pool) << std::setw(20) << visible_wait(idle_pool) << "-" << std::endl;
+
+    for (TaskPriority flood_class : { TaskPriority::Render, TaskPriority::Indexing }) {
+        ThreadPool pool(threads, 1);
+        const auto flood_start = Clock::now();
+        std::vector<std::future<void>> flood;
+        for (uint32_t i = 0; i < background_tasks; ++i) {
+            flood.push_back(pool.submit([&]() { spin(std::chrono::microseconds(task_us)); }, flood_class));
+        }
+        // Let the workers pick up the flood first
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+        const double render_ms = render(pool);
+        const double wait_ms = visible_wait(pool);
+        for (auto& future : flood) {
+            future.get();
+        }
+        const double drained_ms = ms_since(flood_start);
+
+        std::cout << std::left << std::setw(26) << to_string(flood_class) << std::fixed << std::setprecision(2)
+            << std::setw(14) << render_ms << std::setw(20) << wait_ms << drained_ms << std::endl;
+
+        if (flood_class == TaskPriority::Indexing) {
+            const SchedulerStats stats = pool.stats();
+            std::cout << std::left << std::setw(16) << "Class" << std::setw(10) << "Done" << std::setw(16)
+                << "Mean wait ms" << std::setw(16) << "Max wait ms" << "Mean run ms" << std::endl;
+            for (size_t p = 0; p < kTaskPriorityCount; ++p) {
+                const TaskClassStats& task_class = stats.classes[p];
+                std::cout << std::left << std::setw(16) << to_string(static_cast<TaskPriority>(p))
+                    << std::setw(10) << task_class.completed << std::setprecision(3)
+                    << std::setw(16) << task_class.mean_wait_ms << std::setw(16) << task_class.max_wait_ms
+                    << task_class.mean_run_ms << std::endl;
+            }
+            std::cout << "Steals: " << stats.steals << ", NUMA nodes: " << stats.numa_nodes << std::endl;
+        }
+    }
+
+    // Every outer task splits its own loop; the loops must all complete
+    {
+        ThreadPool pool(threads, 1);
+        std::atomic<uint64_t> inner_rows{ 0 };
+        const auto start = Clock::now();
+        pool.parallel_for(threads * 4, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                pool.parallel_for(256, [&](size_t row_begin, size_t row_end) {
+                    spin(std::chrono::microseconds(5 * (row_end - row_begin)));
+                    inner_rows += row_end - row_begin;
+                });
+            }
+        });
+        std::cout << "Nested loops: " << inner_rows.load() << " / " << threads * 4 * 256 << " rows in "
+            << std::setprecision(1) << ms_since(start) << " ms" << std::endl;
+        if (inner_rows.load() != threads * 4 * 256) {
+            return 1;
+        }
+    }
+
+    // Tasks queued behind a busy pool are dropped once cancelled
+    {
+        ThreadPool pool(threads, 1);
+        CancellationToken token;
+        std::atomic<uint32_t> ran{ 0 };
+        std::vector<std::future<void>> blockers;
+        for (size_t i = 0; i < threads; ++i) {
+            blockers.push_back(pool.submit([&]() { spin(std::chrono::milliseconds(20)); }));
+        }
+        for (uint32_t i = 0; i < 1000; ++i) {
+            pool.post([&ran]() { ++ran; }, TaskPriority::Prefetch, &token);
+        }
+        token.cancel();
+        for (auto& future : blockers) {
+            future.get();
+        }
+        // The last cancelled tasks are dropped right after the blockers end
+        while (pool.stats().of(TaskPriority::Prefetch).cancelled + ran.load() < 1000) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        std::cout << "Cancelled: " << pool.stats().of(TaskPriority::Prefetch).cancelled << " of 1000 queued tasks dropped, "
+            << ran.load() << " ran" << std::endl;
+    }
+
+    return 0;
+}
+
+// Per-frame values of an enhanced multi-frame object: indexing its functional
+// groups once, then random lookups in the table versus walking the sequences
+int benchmark_functional_groups(const Options& options) {
+    const uint32_t frames = std::max<uint32_t>(option_u32(options, "frames", 2000), 1);
+    const uint32_t lookups = std::max<uint32_t>(option_u32(options, "lookups", 20000), 1);
+    const size_t max_threads = option_u32(options, "threads",
+        static_cast<uint32_t>(ThreadPool::default_thread_count()));
+    using Clock = std::chrono::steady_clock;
+
+    const auto dir = std::filesystem::temp_directory_path() / "dicom_viewer_bench";
+    std::filesystem::create_directories(dir);
+    const auto path = dir / "enhanced.dcm";
+
+    TestPatternSpec spec{ 32, 32, frames, 16, PixelCodec::Uncompressed };
+    spec.enhanced = true;
+    auto written = write_test_pattern(path, spec);
+    if (written.is_error()) {
+        std::cerr << "Cannot write test object: " << written.error().full_message() << std::endl;
+        return 1;
+    }
+
+    std::cout << "Functional group benchmark: " << frames << " frames, " << lookups << " lookups" << std::endl;
+    std::cout << std::left << std::setw(10) << "Workers" << "Parse + index ms" << std::endl;
+    FunctionalGroupTable table;
+    for (size_t threads : thread_counts(max_threads)) {
+        ThreadPool pool(threads);
+        const auto start = Clock::now();
+        auto result = read_functional_groups(path, pool);
+        const double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        if (result.is_error()) {
+            std::cerr << "Indexing failed: " << result.error().full_message() << std::endl;
+            return 1;
+        }
+        table = std::move(result.value());
+        std::cout << std::left << std::setw(10) << threads << std::fixed << std::setprecision(1) << ms << std::endl;
+    }
+
+    auto walker = FunctionalGroupWalker::open(path);
+    if (walker.is_error() || table.frame_count != frames) {
+        std::cerr << "Cannot open test object" << std::endl;
+        return 1;
+    }
+
+    // Frames in the order a user scrolls or jumps: random
+    std::vector<uint32_t> order(lookups);
+    uint32_t seed = 12345;
+    for (uint32_t& f : order) {
+        seed = seed * 1103515245u + 12345u;
+        f = (seed >> 8) % frames;
+    }
+
+    double table_sum = 0.0, walk_sum = 0.0;
+    uint32_t mismatches = 0;
+    auto start = Clock::now();
+    for (uint32_t f : order) {
+        table_sum += table.position[f].z + table.rescale_intercept[f] + table.window_center[f];
+    }
+    const double table_us = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / lookups;
+
+    start = Clock::now();
+    for (uint32_t f : order) {
+        const FunctionalGroupWalker::FrameValues values = walker.value().frame(f);
+        walk_sum += values.position.z + values.rescale_intercept + values.window_center;
+        if (values.position.z != table.position[f].z || values.rescale_slope != table.rescale_slope[f] ||
+            values.window_center != table.window_center[f] || values.window_width != table.window_width[f]) {
+            ++mismatches;
+        }
+    }
+    const double walk_us = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / lookups;
+
+    std::cout << std::left << std::setw(16) << "Table us" << std::setw(16) << "Walk us" << std::setw(12) << "Speedup"
+        << "Mismatches" << std::endl;
+    std::cout << std::left << std::fixed << std::setprecision(3) << std::setw(16) << table_us
+        << std::setw(16) << walk_us << std::setprecision(0) << std::setw(12) << walk_us / std::max(table_us, 1e-6)
+        << mismatches << (table_sum == walk_sum ? "" : " (sums differ)") << std::endl;
+
+    std::filesystem::remove(path);
+    return 0;
+}
+
+// Segmentation overlays: loading a SEG object (unpack, crop, index), 1-bit
+// unpacking and multi-segment blending scalar vs AVX2, and a segment toggle
+// (re-blend of the windowed frame) against reloading and windowing the image
+int benchmark_segmentation(const Options& options) {
+    const uint32_t size = std::max<uint32_t>(option_u32(options, "size", 512), 16);
+    const uint32_t frames = std::max<uint32_t>(option_u32(options, "frames", 16), 1);
+    const uint16_t segment_count = static_cast<uint16_t>(std::clamp<uint32_t>(option_u32(options, "segments", 4), 1, 64));
+    const uint32_t renders = std::max<uint32_t>(option_u32(options, "renders", 50), 1);
+    const size_t max_threads = option_u32(options, "threads",
+        static_cast<uint32_t>(ThreadPool::default_thread_count()));
+    using Clock = std::chrono::steady_clock;
+
+    const auto dir = std::filesystem::temp_directory_path() / "dicom_viewer_bench";
+    std::filesystem::create_directories(dir);
+    const auto image_path = dir / "seg_source.dcm";
+    const auto seg_path = dir / "seg.dcm";
+
+    TestPatternSpec spec{ size, size, frames, 16, PixelCodec::Uncompressed };
+    spec.sop_instance_uid = make_test_uid();
+    auto written = write_test_pattern(image_path, spec);
+    if (written.is_ok()) {
+        written = write_test_segmentation(seg_path, spec, segment_count);
+    }
+    if (written.is_error()) {
+        std::cerr << "Cannot write test objects: " << written.error().full_message() << std::endl;
+        return 1;
+    }
+
+    std::cout << "Segmentation benchmark: " << size << "x" << size << ", " << frames << " frames, "
+        << segment_count << " segments, AVX2 " << (cpu_features().avx2 ? "available" : "unavailable") << std::endl;
+    std::cout << std::left << std::setw(10) << "Workers" << "Load ms" << std::endl;
+    Segmentation segmentation;
+    for (size_t threads : thread_counts(max_threads)) {
+        ThreadPool pool(threads);
+        const auto start = Clock::now();
+        auto result = load_segmentation(seg_path, pool);
+        const double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        if (result.is_error()) {
+            std::cerr << "Loading failed: " << result.error().full_message() << std::endl;
+            return 1;
+        }
+        segmentation = std::move(result.value());
+        std::cout << std::left << std::setw(10) << threads << std::fixed << std::setprecision(1) << ms << std::endl;
+    }
+    if (!segmentation.covers(spec.sop_instance_uid, 0)) {
+        std::cerr << "Segmentation frames were not matched to their source" << std::endl;
+        return 1;
+    }
+
+    const size_t count = static_cast<size_t>(size) * size;
+    auto time_runs = [&](const std::function<void()>& run) {
+        run();
+        const auto start = Clock::now();
+        for (uint32_t r = 0; r < renders; ++r) run();
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count() / renders;
+    };
+
+    std::cout << std::left << std::setw(22) << "Kernel" << std::setw(12) << "Scalar ms"
+        << std::setw(12) << "AVX2 ms" << "Match" << std::endl;
+    std::vector<uint8_t> packed((count + 7) / 8 + 1);
+    for (size_t i = 0; i < packed.size(); ++i) {
+        packed[i] = static_cast<uint8_t>((i * 2654435761u) >> 24);
+    }
+    std::vector<uint8_t> scalar_out(count * 3), simd_out(count * 3);
+    auto report = [&](const char* name, const std::function<void(uint8_t* out, bool simd)>& run) {
+        const double scalar_ms = time_runs([&]() { run(scalar_out.data(), false); });
+        const double simd_ms = time_runs([&]() { run(simd_out.data(), true); });
+        std::cout << std::left << std::setw(22) << name << std::fixed << std::setprecision(3)
+            << std::setw(12) << scalar_ms << std::setw(12) << simd_ms
+            << (scalar_out == simd_out ? "yes" : "NO") << std::endl;
+    };
+    report("unpack 1-bit", [&](uint8_t* out, bool simd) { unpack_bits(packed.data(), 0, count, out, simd); });
+    report("unpack, bit offset 3", [&](uint8_t* out, bool simd) { unpack_bits(packed.data(), 3, count, out, simd); });
+
+    // Fractional-looking coverage for every segment over the whole frame
+    std::vector<std::vector<uint8_t>> coverages(segment_count, std::vector<uint8_t>(count));
+    std::vector<BlendLayer> layers;
+    for (uint16_t s = 0; s < segment_count; ++s) {
+        for (size_t i = 0; i < count; ++i) {
+            coverages[s][i] = static_cast<uint8_t>(((i + s * 97) * 40503u) >> 8);
+        }
+        layers.push_back(BlendLayer{ coverages[s].data(),
+            segmentation.segments[s % segmentation.segments.size()].color, 128 });
+    }
+    std::vector<uint8_t> gray(count);
+    for (size_t i = 0; i < count; ++i) gray[i] = static_cast<uint8_t>(i * 7);
+    report("blend dense layers", [&](uint8_t* out, bool simd) {
+        blend_layers(gray.data(), layers.data(), layers.size(), count, out, simd);
+    });
+
+    // A toggle re-blends the already windowed frame; without the cached
+    // masks and display buffer it would reload and window the image
+    DcmtkReader reader;
+    auto image = reader.load_image(image_path);
+    if (image.is_error()) {
+        std::cerr << "Load failed: " << image.error().full_message() << std::endl;
+        return 1;
+    }
+    const ImageData& data = image.value().data();
+    const PixelBuffer display = image.value().to_display_buffer(data.window_center, data.window_width);
+    std::vector<bool> visible(segmentation.segments.size(), true);
+    uint32_t toggles = 0;
+    size_t blended_pixels = 0;
+    const double toggle_ms = time_runs([&]() {
+        visible[toggles++ % visible.size()].flip();
+        PixelBuffer out = segmentation.blend(display, data.width, data.height, spec.sop_instance_uid, 0,
+            visible, static_cast<uint8_t>(64 + toggles % 192));
+        blended_pixels += out.pixel_count();
+    });
+    const double reload_ms = time_runs([&]() {
+        auto reloaded = reader.load_image(image_path);
+        if (reloaded.is_ok()) {
+            const ImageData& d = reloaded.value().data();
+            blended_pixels += reloaded.value().to_display_buffer(d.window_center, d.window_width).pixel_count();
+        }
+    });
+    std::cout << "Segment toggle: re-blend " << std::fixed << std::setprecision(2) << toggle_ms
+        << " ms vs reload + window " << reload_ms << " ms" << (blended_pixels > 0 ? "" : " (nothing drawn)")
+        << std::endl;
+
+    std::filesystem::remove(image_path);
+    std::filesystem::remove(seg_path);
+    return 0;
+}
+
+// RT Structure Set contours over a volume's slices: load, rasterizing each
+// slice on demand, background prefetch versus worker count, then scrolling
+// through the cached slices
+int benchmark_rtstruct(const Options& options) {
+    const uint32_t slices = std::max<uint32_t>(option_u32(options, "slices", 300), 1);
+    const uint32_t structure_count = std::max<uint32_t>(option_u32(options, "structures", 50), 1);
+    const uint32_t points = std::max<uint32_t>(option_u32(options, "points", 128), 3);
+    const uint32_t size = std::max<uint32_t>(option_u32(options, "size", 512), 16);
+    const size_t max_threads = option_u32(options, "threads",
+        static_cast<uint32_t>(ThreadPool::default_thread_count()));
+    using Clock = std::chrono::steady_clock;
+
+    const auto dir = std::filesystem::temp_directory_path() / "dicom_viewer_bench";
+    std::filesystem::create_directories(dir);
+    const auto path = dir / "rtstruct.dcm";
+
+    // Only the geometry is used; the voxels are never touched
+    Volume volume;
+    volume.allocate(size, size, slices);
+    volume.spacing = { 0.8, 0.8, 1.5 };
+    auto written = write_test_structure_set(path, structure_count, slices, volume.spacing.z,
+        size * volume.spacing.x, points);
+    if (written.is_error()) {
+        std::cerr << "Cannot write test structure set: " << written.error().full_message() << std::endl;
+        return 1;
+    }
+
+    std::cout << "RT Structure Set benchmark: " << structure_count << " structures, " << slices << " slices of "
+        << size << "x" << size << ", " << points << " points per contour" << std::endl;
+    auto start = Clock::now();
+    auto loaded = load_structure_set(path);
+    const double load_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    std::filesystem::remove(path);
+    if (loaded.is_error()) {
+        std::cerr << "Loading failed: " << loaded.error().full_message() << std::endl;
+        return 1;
+    }
+    auto structures = std::make_shared<const StructureSet>(std::move(loaded.value()));
+    std::cout << "Load: " << std::fixed << std::setprecision(1) << load_ms << " ms, "
+        << structures->contour_count() << " contours" << std::endl;
+
+    PixelBuffer display = PixelBuffer::allocate(PixelFormat::Gray8, static_cast<size_t>(size) * size);
+    for (size_t i = 0; i < display.pixel_count(); ++i) {
+        display.gray8()[i] = static_cast<uint8_t>(i * 7 >> 4);
+    }
+    const std::vector<bool> visible(structures->structures.size(), true);
+
+    // Every slice in turn, as scrolling through the stack
+    auto scroll = [&](const ContourRasterCache& cache, double& max_ms) {
+        size_t drawn = 0;
+        max_ms = 0.0;
+        const auto begin = Clock::now();
+        for (uint32_t k = 0; k < slices; ++k) {
+            const auto slice_start = Clock::now();
+            PixelBuffer out = draw_structures(display, size, size, cache.slice(k), *structures, visible, true, 96);
+            drawn += out.pixel_count() > 0 ? 1 : 0;
+            max_ms = std::max(max_ms, std::chrono::duration<double, std::milli>(Clock::now() - slice_start).count());
+        }
+        const double total = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+        return std::make_pair(total / slices, drawn);
+    };
+
+    auto cache = ContourRasterCache::create(structures, volume);
+    if (cache->matched_contours() != structures->contour_count()) {
+        std::cerr << "Only " << cache->matched_contours() << " contours matched a slice" << std::endl;
+        return 1;
+    }
+    double cold_max = 0.0, warm_max = 0.0;
+    const auto [cold_ms, cold_drawn] = scroll(*cache, cold_max);
+    const auto [warm_ms, warm_drawn] = scroll(*cache, warm_max);
+    std::cout << std::left << std::setw(26) << "Scroll" << std::setw(14) << "ms per slice" << "max ms" << std::endl;
+    std::cout << std::setprecision(3);
+    std::cout << std::left << std::setw(26) << "rasterize on demand" << std::setw(14) << cold_ms << cold_max << std::endl;
+    std::cout << std::left << std::setw(26) << "cached" << std::setw(14) << warm_ms << warm_max
+        << (cold_drawn == slices && warm_drawn == slices ? "" : " (slices left blank)") << std::endl;
+    std::cout << "Cache: " << std::setprecision(1) << cache->memory_bytes() / (1024.0 * 1024.0) << " MB" << std::endl;
+
+    // Background rasterization of the whole stack from the middle outwards
+    std::cout << std::left << std::setw(10) << "Workers" << "Prefetch all ms" << std::endl;
+    for (size_t threads : thread_counts(max_threads)) {
+        ThreadPool pool(threads);
+        auto fresh = ContourRasterCache::create(structures, volume);
+        start = Clock::now();
+        fresh->prefetch(slices / 2, pool);
+        for (uint32_t k = 0; k < slices; ++k) {
+            while (!fresh->cached(k)) std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        const double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        std::cout << std::left << std::setw(10) << threads << std::setprecision(1) << ms << std::endl;
+    }
+    return 0;
+}
+
+int benchmark_overlay(const Options& options) {
+    const uint32_t size = std::max<uint32_t>(option_u32(options, "size", 2048), 64);
+    const uint16_t overlay_count = static_cast<uint16_t>(std::clamp<uint32_t>(option_u32(options, "overlays", 4), 1, 15));
+    const uint32_t loads = std::max<uint32_t>(option_u32(options, "loads", 5), 1);
+    const uint32_t renders = std::max<uint32_t>(option_u32(options, "renders", 30), 1);
+    using Clock = std::chrono::steady_clock;
+
+    const auto dir = std::filesystem::temp_directory_path() / "dicom_viewer_bench";
+    std::filesystem::create_directories(dir);
+    const auto plain_path = dir / "overlay_none.dcm";
+    const auto overlay_path = dir / "overlay.dcm";
+
+    TestPatternSpec spec{ size, size, 1, 16, PixelCodec::Uncompressed };
+    auto written = write_test_pattern(plain_path, spec);
+    spec.overlays = overlay_count;
+    spec.embedded_overlay = true;
+    if (written.is_ok()) {
+        written = write_test_pattern(overlay_path, spec);
+    }
+    if (written.is_error()) {
+        std::cerr << "Cannot write test patterns: " << written.error().full_message() << std::endl;
+        return 1;
+    }
+
+    std::cout << "Overlay benchmark: " << size << "x" << size << ", " << overlay_count
+        << " overlay planes + 1 embedded in bit 15, AVX2 " << (cpu_features().avx2 ? "available" : "unavailable")
+        << std::endl;
+
+    // Extraction is part of the load, before the pixel data is decoded
+    DcmtkReader reader;
+    std::optional<DicomImageData> image;
+    std::cout << std::left << std::setw(22) << "Load" << "ms" << std::endl;
+    for (const auto& [name, path] : { std::make_pair("without overlays", plain_path),
+                                      std::make_pair("with overlays", overlay_path) }) {
+        double total_ms = 0.0;
+        for (uint32_t l = 0; l < loads; ++l) {
+            const auto start = Clock::now();
+            auto result = reader.load_image(path);
+            total_ms += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            if (result.is_error()) {
+                std::cerr << "Load failed: " << result.error().full_message() << std::endl;
+                return 1;
+            }
+            image = std::move(result.value());
+        }
+        std::cout << std::left << std::setw(22) << name << std::fixed << std::setprecision(1)
+            << total_ms / loads << std::endl;
+    }
+    const ImageData& data = image->data();
+    if (!data.overlays || data.overlays->size() != overlay_count + 1u || !data.overlays->back().embedded) {
+        std::cerr << "Overlay planes were not extracted" << std::endl;
+        return 1;
+    }
+    const OverlayPlanes& planes = *data.overlays;
+    size_t run_count = 0;
+    for (const OverlayPlane& plane : planes) run_count += plane.runs.size();
+    std::cout << "Overlays: " << planes.size() << " planes, " << run_count << " runs, "
+        << std::setprecision(1) << overlay_memory_bytes(planes) / 1024.0 << " KB" << std::endl;
+
+    const size_t count = static_cast<size_t>(size) * size;
+    auto time_runs = [&](const std::function<void()>& run) {
+        run();
+        const auto start = Clock::now();
+        for (uint32_t r = 0; r < renders; ++r) run();
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count() / renders;
+    };
+
+    // A plane's pixels as drawn from its runs; repacked to bits for the
+    // unpacker, or put in bit 15 of samples for the embedded extraction
+    auto plane_mask = [&](size_t p) {
+        std::vector<uint8_t> mask(count, 0);
+        std::vector<bool> only(planes.size(), false);
+        only[p] = true;
+        composite_overlays(planes, only, 0, mask.data(), size, 0, size);
+        return mask;
+    };
+    const std::vector<uint8_t> first_mask = plane_mask(0);
+    const std::vector<uint8_t> embedded_mask = plane_mask(planes.size() - 1);
+    std::vector<uint8_t> packed((count + 7) / 8, 0);
+    std::vector<uint16_t> samples(count);
+    for (size_t i = 0; i < count; ++i) {
+        if (first_mask[i]) packed[i / 8] |= static_cast<uint8_t>(1u << (i % 8));
+        samples[i] = static_cast<uint16_t>(((i * 2654435761u) >> 20 & 0x0FFF) | (embedded_mask[i] ? 0x8000 : 0));
+    }
+
+    std::vector<uint8_t> scalar_out(count), simd_out(count), bit_scalar(count), bit_simd(count);
+    const double scalar_ms = time_runs([&]() { unpack_bits(packed.data(), 0, count, scalar_out.data(), false); });
+    const double simd_ms = time_runs([&]() { unpack_bits(packed.data(), 0, count, simd_out.data(), true); });
+    const double bit_scalar_ms = time_runs([&]() { extract_bit_plane(samples.data(), count, 15, bit_scalar.data(), false); });
+    const double bit_simd_ms = time_runs([&]() { extract_bit_plane(samples.data(), count, 15, bit_simd.data(), true); });
+    OverlayPlane encoded;
+    encoded.width = size;
+    encoded.height = size;
+    const double runs_ms = time_runs([&]() {
+        encoded.runs.clear();
+        encoded.frame_runs.assign(1, 0);
+        encoded.add_frame(simd_out.data());
+    });
+    std::cout << std::left << std::setw(22) << "Kernel" << std::setw(12) << "Scalar ms"
+        << std::setw(12) << "AVX2 ms" << "Match" << std::endl;
+    std::cout << std::left << std::setw(22) << "unpack Overlay Data" << std::setprecision(3) << std::setw(12)
+        << scalar_ms << std::setw(12) << simd_ms
+        << (scalar_out == first_mask && simd_out == first_mask ? "yes" : "NO") << std::endl;
+    std::cout << std::left << std::setw(22) << "embedded bit 15" << std::setw(12) << bit_scalar_ms
+        << std::setw(12) << bit_simd_ms
+        << (bit_scalar == embedded_mask && bit_simd == embedded_mask ? "yes" : "NO") << std::endl;
+    std::cout << std::left << std::setw(22) << "frame to runs" << std::setw(12) << runs_ms << std::setw(12) << "-"
+        << (encoded.runs.size() == planes[0].runs.size() ? "yes" : "NO") << std::endl;
+
+    // Drawn into each band as it is windowed, against a second pass over
+    // the windowed frame as a separate overlay layer would make
+    const std::vector<bool> visible(planes.size(), true);
+    size_t shown = 0;
+    const double plain_ms = time_runs([&]() {
+        shown += image->to_display_buffer(data.window_center, data.window_width).pixel_count();
+    });
+    PixelBuffer in_pass;
+    const double in_pass_ms = time_runs([&]() {
+        in_pass = image->to_display_buffer(data.window_center, data.window_width, &visible);
+    });
+    PixelBuffer separate;
+    const double separate_ms = time_runs([&]() {
+        separate = image->to_display_buffer(data.window_center, data.window_width);
+        composite_overlays(planes, visible, 0, separate.gray8(), size, 0, size);
+    });
+    const bool same = std::memcmp(in_pass.gray8(), separate.gray8(), count) == 0;
+    std::cout << std::left << std::setw(22) << "Render" << "ms" << std::endl;
+    std::cout << std::left << std::setw(22) << "no overlays" << std::setprecision(2) << plain_ms << std::endl;
+    std::cout << std::left << std::setw(22) << "overlays in pass" << in_pass_ms << std::endl;
+    std::cout << std::left << std::setw(22) << "overlays after" << separate_ms
+        << (same && shown > 0 ? "" : " (results differ)") << std::endl;
+
+    std::filesystem::remove(plain_path);
+    std::filesystem::remove(overlay_path);
+    return 0;
+}
+
+// One cold start, run in a fresh process by benchmark_startup: prints the
+// steady clock when main was entered, when the window could be shown and
+// when the first image was decoded. The sleep stands in for building the
+// window, which is mostly waiting on the display server, fonts and plugins.
+int startup_probe(const Options& options) {
+    using Clock = std::chrono::steady_clock;
+    const int64_t main_ns = Clock::now().time_since_epoch().count();
+    const bool eager = options.at("probe") == "eager";
+    const uint32_t window_ms = option_u32(options, "window-ms", 100);
+
+    std::optional<DictionaryPreload> dictionary_preload;
+    if (eager) {
+        // As before: every decoder registered up front, the dictionary
+        // loaded by the first parse
+        register_all_decoders();
+    }
+    else {
+        dictionary_preload.emplace();
+    }
+    DcmtkReader reader;
+    std::this_thread::sleep_for(std::chrono::milliseconds(window_ms));
+    const int64_t window_ns = Clock::now().time_since_epoch().count();
+
+    auto image = reader.load_image(options.at("file"));
+    if (image.is_error()) {
+        std::cerr << "Load failed: " << image.error().full_message() << std::endl;
+        return 1;
+    }
+    const int64_t image_ns = Clock::now().time_since_epoch().count();
+    std::cout << "startup " << main_ns << " " << window_ns << " " << image_ns << std::endl;
+    return 0;
+}
+
+int benchmark_startup(const Options& options) {
+    if (options.count("probe") && options.count("file")) {
+        return startup_probe(options);
+    }
+    using Clock = std::chrono::steady_clock;
+
+    const uint32_t runs = std::max<uint32_t>(option_u32(options, "runs", 5), 1);
+    const uint32_t size = option_u32(options, "size", 512);
+    const uint32_t window_ms = option_u32(options, "window-ms", 100);
+
+    const std::filesystem::path executable = executable_path();
+    if (executable.empty()) {
+        std::cerr << "Cannot locate the executable to start" << std::endl;
+        return 1;
+    }
+
+    const auto dir = std::filesystem::temp_directory_path() / "dicom_viewer_bench" / "startup";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+
+    struct Source {
+        const char* name;
+        PixelCodec codec;
+    };
+    const Source sources[] = {
+        { "Native", PixelCodec::Uncompressed },
+        { "JPEG-LS", PixelCodec::JpegLsLossless },
+    };
+    const std::pair<const char*, const char*> modes[] = {
+        { "eager", "Eager codecs, dictionary on first parse" },
+        { "lazy", "Lazy codecs, dictionary preloaded" },
+    };
+
+    std::cout << "Startup benchmark: " << runs << " cold starts each, " << size << "x" << size
+        << " image, " << window_ms << " ms window construction" << std::endl;
+    std::cout << "Times are medians in ms from process spawn" << std::endl;
+    std::cout << std::left << std::setw(10) << "Image" << std::setw(42) << "Startup" << std::setw(10) << "Main"
+        << std::setw(10) << "Window" << "First image" << std::endl;
+
+    auto median = [](std::vector<double> values) {
+        std::sort(values.begin(), values.end());
+        return values[values.size() / 2];
+    };
+
+    for (const Source& source : sources) {
+        const auto path = dir / (std::string("image_") + std::to_string(static_cast<int>(source.codec)) + ".dcm");
+        auto written = write_test_pattern(path, TestPatternSpec{ size, size, 1, 16, source.codec });
+        if (written.is_error()) {
+            std::cerr << "Skipping " << source.name << ": " << written.error().full_message() << std::endl;
+            continue;
+        }
+
+        for (const auto& [mode, label] : modes) {
+            std::vector<double> main_ms, window_ms_measured, image_ms;
+            for (uint32_t run = 0; run < runs; ++run) {
+                const int64_t spawn_ns = Clock::now().time_since_epoch().count();
+                auto output = run_and_capture(executable, { "--benchmark", "startup", "--probe", mode,
+                    "--file", path.string(), "--window-ms", std::to_string(window_ms) });
+                if (output.is_error()) {
+                    std::cerr << "Probe failed: " << output.error().full_message() << std::endl;
+                    return 1;
+                }
+
+                // The reader's debug lines come first
+                const size_t line = output.value().rfind("startup ");
+                long long main_ns = 0, window_ns = 0, image_ns = 0;
+                if (line == std::string::npos || std::sscanf(output.value().c_str() + line, "startup %lld %lld %lld",
+                        &main_ns, &window_ns, &image_ns) != 3) {
+                    std::cerr << "Probe gave no timings" << std::endl;
+                    return 1;
+                }
+                main_ms.push_back((main_ns - spawn_ns) / 1e6);
+                window_ms_measured.push_back((window_ns - spawn_ns) / 1e6);
+                image_ms.push_back((image_ns - spawn_ns) / 1e6);
+            }
+
+            std::cout << std::left << std::setw(10) << source.name << std::setw(42) << label
+                << std::fixed << std::setprecision(1) << std::setw(10) << median(main_ms)
+                << std::setw(10) << median(window_ms_measured) << median(image_ms) << std::endl;
+        }
+    }
+
+    std::filesystem::remove_all(dir);
+    return 0;
+}
+
+const std::vector<BenchmarkEntry>& benchmarks() {
+    static const std::vector<BenchmarkEntry> entries = {
+        { "decode", "Parallel multi-frame decode throughput, checked against the uncompressed frames [--frames N --size N --threads N]", benchmark_decode },
+        { "memory", "Peak and steady-state memory per loaded image [--size N --images N]", benchmark_memory },
+        { "alloc", "Load/render cost with and without the buffer pool [--size N --iterations N]", benchmark_alloc },
+        { "tiles", "Zoomed-region render time, row-major vs tiled [--size N --viewport N --renders N --tile N]", benchmark_tiles },
+        { "mpr", "Reslice time per plane, scalar vs AVX2 [--size N --depth N --renders N --threads N]", benchmark_mpr },
+        { "slab", "Slab MIP/MinIP/average, rebuild vs one-slice slide [--size N --depth N --thickness N --steps N --threads N]", benchmark_slab },
+        { "cine", "Cine playback rate and dropped frames with a stalling consumer [--size N --frames N --seconds N --stall MS --stall-every N]", benchmark_cine },
+        { "color", "YBR/palette to RGB conversion, scalar vs AVX2 vs copy [--size N --iterations N]", benchmark_color },
+        { "viewports", "Linked window/level re-render of a multi-viewport hanging [--size N --views N --width N --height N --steps N --threads N]", benchmark_viewports },
+        { "store", "C-STORE receive rate with concurrent senders, background decode [--instances N --size N --senders N --port N]", benchmark_store },
+        { "retrieve", "Time to first image and throughput of C-MOVE vs focus-ordered C-GET from a local PACS [--instances N --size N --batch N --port N]", benchmark_retrieve },
+        { "dicomweb", "WADO-RS time to first image, buffered vs streamed multipart, and frame retrieval [--instances N --size N --frames N --mbit N --port N]", benchmark_dicomweb },
+        { "transcode", "Lossless export to JPEG-LS and RLE: throughput, ratio and peak memory versus worker count [--instances N --frames N --size N --threads N]", benchmark_transcode },
+        { "anonymize", "Header-only de-identification throughput against a plain file copy, with a pixel identity check [--instances N --frames N --size N --threads N]", benchmark_anonymize },
+        { "thumbnails", "Thumbnails per second from native, JPEG, icon and JPEG-LS sources, cold and cached, against a full load [--count N --size N --thumb N]", benchmark_thumbnails },
+        { "roi", "ROI mean/SD/min/max from summed-area tables vs a pixel scan, and table build time [--size N --queries N --threads N]", benchmark_roi },
+        { "scheduler", "Render and visible decode latency under a background flood, nested loops, cancellation [--tasks N --task-us N --threads N]", benchmark_scheduler },
+        { "groups", "Enhanced multi-frame per-frame values: functional group indexing, table vs sequence walk lookups [--frames N --lookups N --threads N]", benchmark_functional_groups },
+        { "seg", "DICOM SEG overlays: load and unpack, 1-bit unpack and blending scalar vs AVX2, toggle vs reload [--size N --frames N --segments N --renders N --threads N]", benchmark_segmentation },
+        { "rtstruct", "RT Structure Set contours: load, rasterize on demand vs cached scrolling, background prefetch [--slices N --structures N --points N --size N --threads N]", benchmark_rtstruct },
+        { "overlay", "Overlay planes: extraction at load, 1-bit unpack scalar vs AVX2, embedded bits, in-pass vs separate compositing [--size N --overlays N --loads N --renders N]", benchmark_overlay },
+        { "startup", "Cold start to window and to first image, eager vs lazy codecs and dictionary [--runs N --size N --window-ms N]", benchmark_startup },
+    };
+    return entries;
+}
+
+void print_usage() {
+    std::cout << "Usage: dicom_viewer --benchmark <name> [options]" << std::endl;
+    for (const auto& entry : benchmarks()) {
+        std::cout << "  " << std::left << std::setw(12) << entry.name << entry.description << std::endl;
+    }
+}
+
+} // namespace
+
+int run_benchmark(int argc, char* argv[]) {
+    if (argc < 1) {
+        print_usage();
+        return 1;
+    }
+
+    const std::string_view name = argv[0];
+    for (const auto& entry : benchmarks()) {
+        if (entry.name == name) {
+            return entry.run(parse_options(argc - 1, argv + 1));
+        }
+    }
+
+    print_usage();
+    return 1;
+}
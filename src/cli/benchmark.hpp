@@ -0,0 +1,5 @@
+#pragma once
+
+// Command line benchmarks, run as: dicom_viewer --benchmark <name> [options]
+// Returns the process exit code.
+int run_benchmark(int argc, char* argv[]);
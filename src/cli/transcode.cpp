@@ -0,0 +1,84 @@
+#include "transcode.hpp"
+#include "core/thread_pool.hpp"
+#include "infrastructure/study_transcoder.hpp"
+
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+void print_usage() {
+    std::cout << "Usage: dicom_viewer --transcode --codec jpegls|rle --output <dir> [--threads N] "
+        "<file or directory>..." << std::endl;
+    std::cout << "  Re-encodes every DICOM file to JPEG-LS Lossless or RLE Lossless, written as "
+        "<dir>/<Study UID>/<SOP UID>.dcm" << std::endl;
+}
+
+} // namespace
+
+int run_transcode(int argc, char* argv[]) {
+    std::string codec_name = "jpegls";
+    std::filesystem::path output;
+    size_t threads = 0;
+    std::vector<std::filesystem::path> inputs;
+    for (int i = 0; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if ((arg == "--codec" || arg == "--output" || arg == "--threads") && i + 1 < argc) {
+            const char* value = argv[++i];
+            if (arg == "--codec") codec_name = value;
+            else if (arg == "--output") output = value;
+            else threads = std::strtoul(value, nullptr, 10);
+        }
+        else if (arg.substr(0, 2) == "--") {
+            print_usage();
+            return 1;
+        }
+        else {
+            inputs.emplace_back(argv[i]);
+        }
+    }
+
+    const auto codec = parse_transcode_codec(codec_name);
+    if (!codec || output.empty() || inputs.empty()) {
+        print_usage();
+        return 1;
+    }
+    const auto files = collect_files(inputs);
+    if (files.empty()) {
+        std::cerr << "No files to transcode" << std::endl;
+        return 1;
+    }
+
+    ThreadPool pool(threads > 0 ? threads : ThreadPool::default_thread_count());
+    StudyTranscoder transcoder(*codec, pool);
+    transcoder.set_progress([](uint32_t done, uint32_t total) {
+        std::cout << "\r" << done << " / " << total << std::flush;
+    });
+    std::cout << "Transcoding " << files.size() << " files to " << transcode_codec_name(*codec)
+        << " with " << pool.size() << " encoder threads" << std::endl;
+
+    auto result = transcoder.transcode(files, output);
+    std::cout << std::endl;
+    if (result.is_error()) {
+        std::cerr << result.error().full_message() << std::endl;
+        return 1;
+    }
+
+    const TranscodeStats& stats = result.value();
+    std::cout << std::fixed << std::setprecision(2)
+        << "Encoded:           " << stats.files << " files, " << stats.frames << " frames" << std::endl
+        << "Copied unchanged:  " << stats.copied << std::endl
+        << "Failed:            " << stats.failed << std::endl
+        << "Compression ratio: " << stats.compression_ratio() << ":1" << std::endl
+        << "Throughput:        " << stats.megabytes_per_second() << " MB/s of pixel data, "
+        << stats.total_ms / 1000.0 << " s" << std::endl;
+    if (!stats.first_error.empty()) {
+        std::cout << "First failure:     " << stats.first_error << std::endl;
+    }
+    return stats.failed == 0 ? 0 : 2;
+}
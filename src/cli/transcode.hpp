@@ -0,0 +1,6 @@
+#pragma once
+
+// Batch export, run as:
+//   dicom_viewer --transcode --codec jpegls|rle --output <dir> <file or directory>...
+// Returns the process exit code.
+int run_transcode(int argc, char* argv[]);
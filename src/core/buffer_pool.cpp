@@ -0,0 +1,260 @@
+#include "buffer_pool.hpp"
+
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+PooledBlock::~PooledBlock() {
+    reset();
+}
+
+PooledBlock::PooledBlock(PooledBlock&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr))
+    , capacity_(std::exchange(other.capacity_, 0))
+    , pool_(std::exchange(other.pool_, nullptr))
+    , huge_tlb_(std::exchange(other.huge_tlb_, false)) {
+}
+
+PooledBlock& PooledBlock::operator=(PooledBlock&& other) noexcept {
+    if (this != &other) {
+        reset();
+        data_ = std::exchange(other.data_, nullptr);
+        capacity_ = std::exchange(other.capacity_, 0);
+        pool_ = std::exchange(other.pool_, nullptr);
+        huge_tlb_ = std::exchange(other.huge_tlb_, false);
+    }
+    return *this;
+}
+
+void PooledBlock::reset() noexcept {
+    if (!data_) {
+        return;
+    }
+    if (pool_) {
+        pool_->release(data_, capacity_, huge_tlb_);
+    }
+    else {
+        ::operator delete(data_);
+    }
+    data_ = nullptr;
+    capacity_ = 0;
+    pool_ = nullptr;
+    huge_tlb_ = false;
+}
+
+BufferPool::BufferPool(size_t max_cached_bytes, HugePageMode mode)
+    : max_cached_bytes_(max_cached_bytes)
+    , mode_(mode) {
+}
+
+BufferPool::~BufferPool() {
+    trim();
+}
+
+BufferPool& BufferPool::shared() {
+    static BufferPool pool;
+    return pool;
+}
+
+PooledBlock BufferPool::acquire(size_t bytes) {
+    PooledBlock block;
+    if (bytes == 0) {
+        return block;
+    }
+
+    if (bytes < kMinPooledBytes) {
+        block.data_ = ::operator new(bytes);
+        block.capacity_ = bytes;
+        return block;
+    }
+
+    const size_t capacity = (bytes + kBlockGranularity - 1) / kBlockGranularity * kBlockGranularity;
+    // Reusing a somewhat larger block beats a fresh allocation, but not at any waste
+    const size_t max_capacity = capacity + capacity / 4;
+
+    {
+        std::lock_guard lock(mutex_);
+        size_t best = free_blocks_.size();
+        for (size_t i = 0; i < free_blocks_.size(); ++i) {
+            const size_t candidate = free_blocks_[i].capacity;
+            if (candidate >= capacity && candidate <= max_capacity &&
+                (best == free_blocks_.size() || candidate < free_blocks_[best].capacity)) {
+                best = i;
+            }
+        }
+
+        if (best != free_blocks_.size()) {
+            const FreeBlock found = free_blocks_[best];
+            free_blocks_.erase(free_blocks_.begin() + static_cast<std::ptrdiff_t>(best));
+            stats_.reuses++;
+            stats_.bytes_cached -= found.capacity;
+            stats_.bytes_in_use += found.capacity;
+
+            block.data_ = found.data;
+            block.capacity_ = found.capacity;
+            block.huge_tlb_ = found.huge_tlb;
+            block.pool_ = this;
+            return block;
+        }
+    }
+
+    // Fresh blocks are allocated outside the lock
+    bool huge_tlb = false;
+    bool huge_pages = false;
+    void* data = allocate_block(capacity, huge_tlb, huge_pages);
+    if (!data) {
+        // Drop the cache and try once more before giving up
+        trim();
+        data = allocate_block(capacity, huge_tlb, huge_pages);
+        if (!data) {
+            throw std::bad_alloc();
+        }
+    }
+
+    {
+        std::lock_guard lock(mutex_);
+        stats_.allocations++;
+        stats_.bytes_in_use += capacity;
+        if (huge_pages) {
+            stats_.huge_page_blocks++;
+        }
+    }
+
+    block.data_ = data;
+    block.capacity_ = capacity;
+    block.huge_tlb_ = huge_tlb;
+    block.pool_ = this;
+    return block;
+}
+
+void BufferPool::release(void* data, size_t capacity, bool huge_tlb) noexcept {
+    std::vector<FreeBlock> evicted;
+    {
+        std::lock_guard lock(mutex_);
+        stats_.bytes_in_use -= capacity;
+
+        if (capacity > max_cached_bytes_) {
+            evicted.push_back({ data, capacity, huge_tlb });
+        }
+        else {
+            free_blocks_.push_back({ data, capacity, huge_tlb });
+            stats_.bytes_cached += capacity;
+
+            // Oldest blocks go first
+            size_t drop = 0;
+            while (stats_.bytes_cached > max_cached_bytes_ && drop < free_blocks_.size()) {
+                stats_.bytes_cached -= free_blocks_[drop].capacity;
+                evicted.push_back(free_blocks_[drop]);
+                ++drop;
+            }
+            free_blocks_.erase(free_blocks_.begin(), free_blocks_.begin() + static_cast<std::ptrdiff_t>(drop));
+        }
+        stats_.evictions += evicted.size();
+    }
+
+    for (const FreeBlock& block : evicted) {
+        free_block(block.data, block.capacity, block.huge_tlb);
+    }
+}
+
+void BufferPool::trim() {
+    std::vector<FreeBlock> evicted;
+    {
+        std::lock_guard lock(mutex_);
+        evicted.swap(free_blocks_);
+        stats_.bytes_cached = 0;
+        stats_.evictions += evicted.size();
+    }
+
+    for (const FreeBlock& block : evicted) {
+        free_block(block.data, block.capacity, block.huge_tlb);
+    }
+}
+
+void BufferPool::set_max_cached_bytes(size_t bytes) {
+    {
+        std::lock_guard lock(mutex_);
+        max_cached_bytes_ = bytes;
+    }
+    trim();
+}
+
+void BufferPool::set_huge_page_mode(HugePageMode mode) {
+    std::lock_guard lock(mutex_);
+    mode_ = mode;
+}
+
+HugePageMode BufferPool::huge_page_mode() const {
+    std::lock_guard lock(mutex_);
+    return mode_;
+}
+
+BufferPoolStats BufferPool::stats() const {
+    std::lock_guard lock(mutex_);
+    return stats_;
+}
+
+#ifdef _WIN32
+
+// Large pages need a user right that desktop accounts rarely have, so Windows
+// always uses regular pages
+void* BufferPool::allocate_block(size_t capacity, bool& huge_tlb, bool& huge_pages) {
+    huge_tlb = false;
+    huge_pages = false;
+    return _aligned_malloc(capacity, kBlockGranularity);
+}
+
+void BufferPool::free_block(void* data, size_t /*capacity*/, bool /*huge_tlb*/) noexcept {
+    _aligned_free(data);
+}
+
+#else
+
+void* BufferPool::allocate_block(size_t capacity, bool& huge_tlb, bool& huge_pages) {
+    const HugePageMode mode = huge_page_mode();
+    huge_tlb = false;
+    huge_pages = false;
+
+#ifdef MAP_HUGETLB
+    if (mode == HugePageMode::Explicit) {
+        void* data = mmap(nullptr, capacity, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (data != MAP_FAILED) {
+            huge_tlb = true;
+            huge_pages = true;
+            return data;
+        }
+    }
+#endif
+
+    // capacity is a multiple of the alignment, as aligned_alloc requires
+    void* data = std::aligned_alloc(kBlockGranularity, capacity);
+    if (!data) {
+        return nullptr;
+    }
+
+#ifdef MADV_HUGEPAGE
+    if (mode != HugePageMode::None && madvise(data, capacity, MADV_HUGEPAGE) == 0) {
+        huge_pages = true;
+    }
+#endif
+
+    return data;
+}
+
+void BufferPool::free_block(void* data, size_t capacity, bool huge_tlb) noexcept {
+    if (huge_tlb) {
+        munmap(data, capacity);
+    }
+    else {
+        std::free(data);
+    }
+}
+
+#endif
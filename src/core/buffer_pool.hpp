@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// How large pooled blocks are backed
+enum class HugePageMode {
+    None,          // regular pages
+    Transparent,   // 2 MiB aligned blocks advised with MADV_HUGEPAGE
+    Explicit       // MAP_HUGETLB from the reserved pool, Transparent if none is left
+};
+
+struct BufferPoolStats {
+    uint64_t allocations = 0;        // fresh blocks taken from the OS
+    uint64_t reuses = 0;             // requests served from the free list
+    uint64_t huge_page_blocks = 0;   // fresh blocks backed by huge pages (explicit or advised)
+    uint64_t evictions = 0;          // cached blocks returned to the OS
+    uint64_t bytes_in_use = 0;
+    uint64_t bytes_cached = 0;
+};
+
+class BufferPool;
+
+// Uninitialized memory from a BufferPool, handed back to it on destruction
+class PooledBlock {
+    friend class BufferPool;
+
+    void* data_ = nullptr;
+    size_t capacity_ = 0;
+    BufferPool* pool_ = nullptr;
+    bool huge_tlb_ = false;
+
+public:
+    PooledBlock() = default;
+    ~PooledBlock();
+
+    PooledBlock(const PooledBlock&) = delete;
+    PooledBlock& operator=(const PooledBlock&) = delete;
+    PooledBlock(PooledBlock&& other) noexcept;
+    PooledBlock& operator=(PooledBlock&& other) noexcept;
+
+    void* data() const { return data_; }
+    size_t capacity() const { return capacity_; }
+
+    void reset() noexcept;
+};
+
+// Recycles the large buffers of the load and render paths so that repeated
+// loads and renders do not page-fault and zero tens of MB each time.
+// Requests below kMinPooledBytes go straight to operator new.
+class BufferPool {
+public:
+    static constexpr size_t kMinPooledBytes = 1024 * 1024;
+    static constexpr size_t kBlockGranularity = 2 * 1024 * 1024;
+
+    explicit BufferPool(size_t max_cached_bytes = 1024ull * 1024 * 1024,
+        HugePageMode mode = HugePageMode::Transparent);
+    ~BufferPool();
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    PooledBlock acquire(size_t bytes);
+
+    // 0 turns recycling off; excess cached blocks are freed right away
+    void set_max_cached_bytes(size_t bytes);
+
+    // Applies to blocks allocated from now on
+    void set_huge_page_mode(HugePageMode mode);
+    HugePageMode huge_page_mode() const;
+
+    // Returns every cached block to the OS
+    void trim();
+
+    BufferPoolStats stats() const;
+
+    // Process-wide pool used by PixelBuffer
+    static BufferPool& shared();
+
+private:
+    friend class PooledBlock;
+
+    struct FreeBlock {
+        void* data;
+        size_t capacity;
+        bool huge_tlb;
+    };
+
+    void release(void* data, size_t capacity, bool huge_tlb) noexcept;
+    void* allocate_block(size_t capacity, bool& huge_tlb, bool& huge_pages);
+    static void free_block(void* data, size_t capacity, bool huge_tlb) noexcept;
+
+    mutable std::mutex mutex_;
+    std::vector<FreeBlock> free_blocks_;   // oldest first
+    size_t max_cached_bytes_;
+    HugePageMode mode_;
+    BufferPoolStats stats_;
+};
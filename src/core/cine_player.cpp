@@ -0,0 +1,173 @@
+#include "cine_player.hpp"
+#include <algorithm>
+#include <cmath>
+
+CinePlayer::CinePlayer(ThreadPool& pool, size_t ring_size)
+    : pool_(pool)
+    , slots_(std::max<size_t>(ring_size, 2)) {
+}
+
+CinePlayer::~CinePlayer() {
+    stop();
+}
+
+void CinePlayer::start(uint32_t frame_count, double fps, RenderFrame render, uint32_t first_frame,
+    Clock::time_point now) {
+    stop();
+    if (frame_count == 0 || fps <= 0.0) return;
+
+    std::lock_guard lock(mutex_);
+    render_ = std::make_shared<const RenderFrame>(std::move(render));
+    ++generation_;
+    playing_ = true;
+    frame_count_ = frame_count;
+    first_frame_ = first_frame % frame_count;
+    fps_ = fps;
+    playhead_ = 0;
+    scheduled_ = 0;
+    base_sequence_ = 0;
+    base_time_ = now;
+    presented_ = 0;
+    dropped_ = 0;
+    started_ = now;
+    schedule_locked();
+}
+
+void CinePlayer::stop() {
+    std::unique_lock lock(mutex_);
+    playing_ = false;
+    ++generation_;
+    idle_.wait(lock, [this]() { return in_flight_ == 0; });
+    for (Slot& slot : slots_) {
+        slot = Slot{};
+    }
+}
+
+bool CinePlayer::playing() const {
+    std::lock_guard lock(mutex_);
+    return playing_;
+}
+
+void CinePlayer::set_frame_rate(double fps, Clock::time_point now) {
+    if (fps <= 0.0) return;
+    std::lock_guard lock(mutex_);
+    fps_ = fps;
+    base_sequence_ = playhead_;
+    base_time_ = now;
+}
+
+double CinePlayer::frame_rate() const {
+    std::lock_guard lock(mutex_);
+    return fps_;
+}
+
+void CinePlayer::set_renderer(RenderFrame render) {
+    std::lock_guard lock(mutex_);
+    render_ = std::make_shared<const RenderFrame>(std::move(render));
+    if (!playing_) return;
+
+    ++generation_;
+    for (Slot& slot : slots_) {
+        slot = Slot{};
+    }
+    scheduled_ = playhead_;
+    schedule_locked();
+}
+
+std::optional<CineFrame> CinePlayer::next_frame(Clock::time_point now) {
+    std::lock_guard lock(mutex_);
+    if (!playing_ || now < base_time_) return std::nullopt;
+
+    const double elapsed_s = std::chrono::duration<double>(now - base_time_).count();
+    const uint64_t due = base_sequence_ + static_cast<uint64_t>(elapsed_s * fps_);
+    if (due < playhead_) return std::nullopt;
+
+    // After a stall longer than the ring, frames up to now can no longer be
+    // shown in time: give them up and render ahead from the present
+    if (due >= playhead_ + slots_.size()) {
+        dropped_ += due - playhead_;
+        playhead_ = due;
+        scheduled_ = std::max(scheduled_, due);
+        schedule_locked();
+    }
+
+    // Newest due frame that is ready; older due frames are skipped
+    const uint64_t newest = std::min(due, scheduled_ - 1);
+    for (uint64_t sequence = newest + 1; sequence-- > playhead_;) {
+        Slot& slot = slots_[sequence % slots_.size()];
+        if (slot.sequence != sequence || !slot.ready) continue;
+
+        CineFrame frame;
+        frame.index = frame_index(sequence);
+        frame.pixels = std::move(slot.pixels);
+        slot.ready = false;
+
+        dropped_ += sequence - playhead_;
+        ++presented_;
+        playhead_ = sequence + 1;
+        schedule_locked();
+        return frame;
+    }
+    return std::nullopt;
+}
+
+CinePlayer::Clock::time_point CinePlayer::next_due() const {
+    std::lock_guard lock(mutex_);
+    if (fps_ <= 0.0) return base_time_;
+    const double offset_s = (playhead_ - base_sequence_) / fps_;
+    return base_time_ + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(offset_s));
+}
+
+CineStats CinePlayer::stats(Clock::time_point now) const {
+    std::lock_guard lock(mutex_);
+    CineStats stats;
+    stats.presented = presented_;
+    stats.dropped = dropped_;
+    stats.elapsed_ms = std::chrono::duration<double, std::milli>(now - started_).count();
+    return stats;
+}
+
+uint32_t CinePlayer::frame_index(uint64_t sequence) const {
+    return static_cast<uint32_t>((first_frame_ + sequence) % frame_count_);
+}
+
+void CinePlayer::schedule_locked() {
+    // Keep every slot busy with one of the next ring_size frames
+    while (scheduled_ < playhead_ + slots_.size()) {
+        const uint64_t sequence = scheduled_++;
+        Slot& slot = slots_[sequence % slots_.size()];
+        slot = Slot{};
+        slot.sequence = sequence;
+
+        ++in_flight_;
+        pool_.post([this, sequence, generation = generation_, render = render_]() {
+            this->render(sequence, generation, render);
+        }, TaskPriority::Render);
+    }
+}
+
+void CinePlayer::render(uint64_t sequence, uint64_t generation, std::shared_ptr<const RenderFrame> render) {
+    uint32_t index = 0;
+    bool wanted = false;
+    {
+        std::lock_guard lock(mutex_);
+        wanted = generation == generation_ && sequence >= playhead_;
+        index = frame_index(sequence);
+    }
+
+    // Frames already skipped are not rendered at all
+    PixelBuffer pixels;
+    if (wanted) {
+        pixels = (*render)(index);
+    }
+
+    std::lock_guard lock(mutex_);
+    Slot& slot = slots_[sequence % slots_.size()];
+    if (wanted && generation == generation_ && slot.sequence == sequence) {
+        slot.pixels = std::move(pixels);
+        slot.ready = true;
+    }
+    if (--in_flight_ == 0) {
+        idle_.notify_all();
+    }
+}
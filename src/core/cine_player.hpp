@@ -0,0 +1,106 @@
+#pragma once
+
+#include "pixel_buffer.hpp"
+#include "thread_pool.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+// A frame ready for display, as produced by the player's render function
+struct CineFrame {
+    uint32_t index = 0;
+    PixelBuffer pixels;
+};
+
+struct CineStats {
+    uint64_t presented = 0;
+    uint64_t dropped = 0;   // frames whose display time passed before they could be shown
+    double elapsed_ms = 0.0;
+
+    double presented_fps() const {
+        return elapsed_ms > 0.0 ? presented * 1000.0 / elapsed_ms : 0.0;
+    }
+};
+
+// Loops over the frames of a multi-frame object at a fixed rate, timed
+// against the wall clock. Pool workers render (window, convert) frames ahead
+// of the playhead into a bounded ring of slots; the display side polls
+// next_frame() and receives the newest frame that is both due and ready. A
+// frame still missing when a later one is due is skipped and counted as
+// dropped, so a busy GUI costs frames rather than slowing the loop down.
+class CinePlayer {
+public:
+    using Clock = std::chrono::steady_clock;
+    // Called concurrently from pool workers for different frames
+    using RenderFrame = std::function<PixelBuffer(uint32_t index)>;
+
+    explicit CinePlayer(ThreadPool& pool = ThreadPool::shared(), size_t ring_size = 16);
+    ~CinePlayer();
+
+    CinePlayer(const CinePlayer&) = delete;
+    CinePlayer& operator=(const CinePlayer&) = delete;
+
+    // Starts looping over frame_count frames at fps, first_frame due at now
+    void start(uint32_t frame_count, double fps, RenderFrame render, uint32_t first_frame = 0,
+        Clock::time_point now = Clock::now());
+
+    // Stops playback and waits for renders in flight
+    void stop();
+
+    bool playing() const;
+
+    // Keeps the playhead; the frames after it follow the new rate
+    void set_frame_rate(double fps, Clock::time_point now = Clock::now());
+    double frame_rate() const;
+
+    // Discards frames rendered so far and renders ahead again with render,
+    // e.g. after the window changed
+    void set_renderer(RenderFrame render);
+
+    // Newest frame due at now that is ready, if it has not been handed out yet
+    std::optional<CineFrame> next_frame(Clock::time_point now = Clock::now());
+
+    // When the frame after the last presented one is due
+    Clock::time_point next_due() const;
+
+    CineStats stats(Clock::time_point now = Clock::now()) const;
+
+private:
+    struct Slot {
+        uint64_t sequence = UINT64_MAX;   // position in the endless loop
+        bool ready = false;
+        PixelBuffer pixels;
+    };
+
+    ThreadPool& pool_;
+    mutable std::mutex mutex_;
+    std::condition_variable idle_;
+    std::vector<Slot> slots_;
+
+    std::shared_ptr<const RenderFrame> render_;
+    uint64_t generation_ = 0;   // bumped to orphan renders in flight
+    size_t in_flight_ = 0;
+    bool playing_ = false;
+
+    uint32_t frame_count_ = 0;
+    uint32_t first_frame_ = 0;
+    double fps_ = 0.0;
+    uint64_t playhead_ = 0;        // sequence of the next frame to present
+    uint64_t scheduled_ = 0;       // next sequence to hand to a worker
+    uint64_t base_sequence_ = 0;   // sequence due at base_time_
+    Clock::time_point base_time_;
+
+    uint64_t presented_ = 0;
+    uint64_t dropped_ = 0;
+    Clock::time_point started_;
+
+    uint32_t frame_index(uint64_t sequence) const;
+    void schedule_locked();
+    void render(uint64_t sequence, uint64_t generation, std::shared_ptr<const RenderFrame> render);
+};
@@ -0,0 +1,183 @@
+// Built with AVX2 enabled; only reached after a runtime CPU check. Like
+// mpr_avx2.cpp, this file avoids inline library code.
+#include "color_kernels.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+namespace {
+
+// pshufb masks moving 16 interleaved pixels (three 16-byte blocks) to one
+// 16-byte vector per channel and back
+struct ShuffleMasks {
+    uint8_t deinterleave[3][3][16];   // [channel][source block]
+    uint8_t interleave[3][3][16];     // [output block][channel]
+};
+
+constexpr ShuffleMasks make_masks() {
+    ShuffleMasks m{};
+    for (int c = 0; c < 3; ++c) {
+        for (int b = 0; b < 3; ++b) {
+            for (int i = 0; i < 16; ++i) {
+                const int p = 3 * i + c - 16 * b;
+                m.deinterleave[c][b][i] = static_cast<uint8_t>(p >= 0 && p < 16 ? p : 0x80);
+
+                const int q = 16 * b + i;
+                m.interleave[b][c][i] = static_cast<uint8_t>(q % 3 == c ? q / 3 : 0x80);
+            }
+        }
+    }
+    return m;
+}
+
+constexpr ShuffleMasks kMasks = make_masks();
+
+inline __m128i mask(const uint8_t* m) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(m));
+}
+
+inline __m128i load16(const uint8_t* p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+// Three channels of 16 pixels from interleaved or planar sources
+inline void load_pixels(const uint8_t* c0, const uint8_t* c1, const uint8_t* c2, size_t stride, size_t i,
+    __m128i& a, __m128i& b, __m128i& c) {
+    if (stride == 3) {
+        const __m128i s0 = load16(c0 + 3 * i);
+        const __m128i s1 = load16(c0 + 3 * i + 16);
+        const __m128i s2 = load16(c0 + 3 * i + 32);
+        __m128i* out[3] = { &a, &b, &c };
+        for (int ch = 0; ch < 3; ++ch) {
+            *out[ch] = _mm_or_si128(_mm_or_si128(
+                _mm_shuffle_epi8(s0, mask(kMasks.deinterleave[ch][0])),
+                _mm_shuffle_epi8(s1, mask(kMasks.deinterleave[ch][1]))),
+                _mm_shuffle_epi8(s2, mask(kMasks.deinterleave[ch][2])));
+        }
+    }
+    else {
+        a = load16(c0 + i);
+        b = load16(c1 + i);
+        c = load16(c2 + i);
+    }
+}
+
+inline void store_rgb(uint8_t* rgb, __m128i r, __m128i g, __m128i b) {
+    for (int block = 0; block < 3; ++block) {
+        const __m128i out = _mm_or_si128(_mm_or_si128(
+            _mm_shuffle_epi8(r, mask(kMasks.interleave[block][0])),
+            _mm_shuffle_epi8(g, mask(kMasks.interleave[block][1]))),
+            _mm_shuffle_epi8(b, mask(kMasks.interleave[block][2])));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(rgb + 16 * block), out);
+    }
+}
+
+inline __m256i widen(__m128i v) {
+    return _mm256_cvtepu8_epi16(v);
+}
+
+// 16 x int16 back to 16 saturated bytes
+inline __m128i narrow(__m256i v) {
+    return _mm256_castsi256_si128(_mm256_permute4x64_epi64(_mm256_packus_epi16(v, v), 0x08));
+}
+
+struct CopyOp {
+    static void apply(__m128i&, __m128i&, __m128i&) {}
+};
+
+struct YbrFullOp {
+    static void apply(__m128i& x0, __m128i& x1, __m128i& x2) {
+        const __m256i bias = _mm256_set1_epi16(128);
+        const __m256i y = widen(x0);
+        const __m256i cb = _mm256_sub_epi16(widen(x1), bias);
+        const __m256i cr = _mm256_sub_epi16(widen(x2), bias);
+        const __m256i r = _mm256_add_epi16(_mm256_add_epi16(y, cr),
+            _mm256_mulhrs_epi16(cr, _mm256_set1_epi16(kYbrCrToR)));
+        const __m256i g = _mm256_sub_epi16(_mm256_sub_epi16(y,
+            _mm256_mulhrs_epi16(cb, _mm256_set1_epi16(kYbrCbToG))),
+            _mm256_mulhrs_epi16(cr, _mm256_set1_epi16(kYbrCrToG)));
+        const __m256i b = _mm256_add_epi16(_mm256_add_epi16(y, cb),
+            _mm256_mulhrs_epi16(cb, _mm256_set1_epi16(kYbrCbToB)));
+        x0 = narrow(r);
+        x1 = narrow(g);
+        x2 = narrow(b);
+    }
+};
+
+struct YbrRctOp {
+    static void apply(__m128i& x0, __m128i& x1, __m128i& x2) {
+        const __m256i bias = _mm256_set1_epi16(128);
+        const __m256i cb = _mm256_sub_epi16(widen(x1), bias);
+        const __m256i cr = _mm256_sub_epi16(widen(x2), bias);
+        const __m256i g = _mm256_sub_epi16(widen(x0), _mm256_srai_epi16(_mm256_add_epi16(cb, cr), 2));
+        x0 = narrow(_mm256_add_epi16(cr, g));
+        x1 = narrow(g);
+        x2 = narrow(_mm256_add_epi16(cb, g));
+    }
+};
+
+template<typename Op, void (*ColorKernels::*Tail)(const uint8_t*, const uint8_t*, const uint8_t*, size_t,
+    uint8_t*, size_t)>
+void convert(const uint8_t* c0, const uint8_t* c1, const uint8_t* c2, size_t stride, uint8_t* rgb, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i a, b, c;
+        load_pixels(c0, c1, c2, stride, i, a, b, c);
+        Op::apply(a, b, c);
+        store_rgb(rgb + 3 * i, a, b, c);
+    }
+    if (i < n) {
+        (color_kernels_scalar().*Tail)(c0 + i * stride, c1 + i * stride, c2 + i * stride, stride,
+            rgb + 3 * i, n - i);
+    }
+}
+
+// Eight gathered 0x00BBGGRR colors per step, packed to 24 bytes. Each 16-byte
+// store runs 4 bytes past its 12 valid ones, so the loop stops short of the end.
+template<typename Index>
+void palette(const Index* indices, const uint32_t* lut, uint8_t* rgb, size_t n) {
+    const __m256i pack = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    size_t i = 0;
+    for (; i + 10 <= n; i += 8) {
+        __m256i index;
+        if constexpr (sizeof(Index) == 1) {
+            index = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(indices + i)));
+        }
+        else {
+            index = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(indices + i)));
+        }
+        const __m256i colors = _mm256_i32gather_epi32(reinterpret_cast<const int*>(lut), index, 4);
+        const __m256i packed = _mm256_shuffle_epi8(colors, pack);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(rgb + 3 * i), _mm256_castsi256_si128(packed));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(rgb + 3 * i + 12), _mm256_extracti128_si256(packed, 1));
+    }
+    for (; i < n; ++i) {
+        const uint32_t color = lut[indices[i]];
+        rgb[i * 3 + 0] = static_cast<uint8_t>(color);
+        rgb[i * 3 + 1] = static_cast<uint8_t>(color >> 8);
+        rgb[i * 3 + 2] = static_cast<uint8_t>(color >> 16);
+    }
+}
+
+const ColorKernels kKernels{
+    convert<CopyOp, &ColorKernels::copy_rgb>,
+    convert<YbrFullOp, &ColorKernels::ybr_full>,
+    convert<YbrRctOp, &ColorKernels::ybr_rct>,
+    palette<uint8_t>,
+    palette<uint16_t>
+};
+
+} // namespace
+
+const ColorKernels* color_kernels_avx2() {
+    return &kKernels;
+}
+
+#else
+
+const ColorKernels* color_kernels_avx2() {
+    return nullptr;
+}
+
+#endif
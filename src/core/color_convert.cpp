@@ -0,0 +1,184 @@
+#include "color_convert.hpp"
+#include "color_kernels.hpp"
+#include "cpu_features.hpp"
+#include <algorithm>
+
+namespace {
+
+// Rounding Q15 multiply, as _mm256_mulhrs_epi16
+inline int mulhrs(int a, int b) {
+    return (a * b + (1 << 14)) >> 15;
+}
+
+inline uint8_t clamp_u8(int v) {
+    return static_cast<uint8_t>(std::clamp(v, 0, 255));
+}
+
+void copy_rgb(const uint8_t* c0, const uint8_t* c1, const uint8_t* c2, size_t stride, uint8_t* rgb, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        rgb[i * 3 + 0] = c0[i * stride];
+        rgb[i * 3 + 1] = c1[i * stride];
+        rgb[i * 3 + 2] = c2[i * stride];
+    }
+}
+
+void ybr_full(const uint8_t* y, const uint8_t* cb, const uint8_t* cr, size_t stride, uint8_t* rgb, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        const int l = y[i * stride];
+        const int b = cb[i * stride] - 128;
+        const int r = cr[i * stride] - 128;
+        rgb[i * 3 + 0] = clamp_u8(l + r + mulhrs(r, kYbrCrToR));
+        rgb[i * 3 + 1] = clamp_u8(l - mulhrs(b, kYbrCbToG) - mulhrs(r, kYbrCrToG));
+        rgb[i * 3 + 2] = clamp_u8(l + b + mulhrs(b, kYbrCbToB));
+    }
+}
+
+void ybr_rct(const uint8_t* y, const uint8_t* cb, const uint8_t* cr, size_t stride, uint8_t* rgb, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        const int b = cb[i * stride] - 128;
+        const int r = cr[i * stride] - 128;
+        const int g = y[i * stride] - ((b + r) >> 2);
+        rgb[i * 3 + 0] = clamp_u8(r + g);
+        rgb[i * 3 + 1] = clamp_u8(g);
+        rgb[i * 3 + 2] = clamp_u8(b + g);
+    }
+}
+
+template<typename Index>
+void palette(const Index* indices, const uint32_t* lut, uint8_t* rgb, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        const uint32_t color = lut[indices[i]];
+        rgb[i * 3 + 0] = static_cast<uint8_t>(color);
+        rgb[i * 3 + 1] = static_cast<uint8_t>(color >> 8);
+        rgb[i * 3 + 2] = static_cast<uint8_t>(color >> 16);
+    }
+}
+
+const ColorKernels& kernels(bool simd) {
+    const ColorKernels* avx2 = simd && cpu_features().avx2 ? color_kernels_avx2() : nullptr;
+    return avx2 ? *avx2 : color_kernels_scalar();
+}
+
+// Pairs Y0 Y1 Cb Cr are split into planes a chunk at a time and converted from there
+void convert_ybr_422(const ColorKernels& k, const uint8_t* src, size_t count, uint8_t* rgb) {
+    constexpr size_t kChunk = 1024;
+    uint8_t y[kChunk], cb[kChunk], cr[kChunk];
+    for (size_t start = 0; start < count; start += kChunk) {
+        const size_t n = std::min(kChunk, count - start);
+        const uint8_t* group = src + start * 2;
+        for (size_t i = 0; i < n; ++i) {
+            const uint8_t* g = group + (i / 2) * 4;
+            y[i] = g[i & 1];
+            cb[i] = g[2];
+            cr[i] = g[3];
+        }
+        k.ybr_full(y, cb, cr, 1, rgb + start * 3, n);
+    }
+}
+
+// Entry i of a channel scaled to 8 bits
+uint8_t palette_entry(const PaletteChannel& channel, size_t i) {
+    const uint16_t value = channel.entries[std::min(i, channel.entries.size() - 1)];
+    if (channel.bits > 8) return static_cast<uint8_t>(value >> 8);
+    // Some writers put 8-bit entries in the high byte of each word
+    return static_cast<uint8_t>(value > 0xFF ? value >> 8 : value);
+}
+
+} // namespace
+
+const ColorKernels& color_kernels_scalar() {
+    static const ColorKernels kernels{ copy_rgb, ybr_full, ybr_rct, palette<uint8_t>, palette<uint16_t> };
+    return kernels;
+}
+
+void convert_to_rgb(ColorModel model, const uint8_t* src, bool planar, size_t count, uint8_t* rgb, bool simd) {
+    const ColorKernels& k = kernels(simd);
+    if (model == ColorModel::YbrFull422) {
+        convert_ybr_422(k, src, count, rgb);
+        return;
+    }
+
+    const uint8_t* c0 = src;
+    const uint8_t* c1 = planar ? src + count : src + 1;
+    const uint8_t* c2 = planar ? src + 2 * count : src + 2;
+    const size_t stride = planar ? 1 : 3;
+    switch (model) {
+    case ColorModel::Rgb:
+        k.copy_rgb(c0, c1, c2, stride, rgb, count);
+        break;
+    case ColorModel::YbrFull:
+    case ColorModel::YbrIct:
+        k.ybr_full(c0, c1, c2, stride, rgb, count);
+        break;
+    case ColorModel::YbrRct:
+        k.ybr_rct(c0, c1, c2, stride, rgb, count);
+        break;
+    case ColorModel::YbrFull422:
+        break;
+    }
+}
+
+std::vector<uint16_t> expand_segmented_lut(const uint16_t* data, size_t words, uint32_t count) {
+    std::vector<uint16_t> out;
+    out.reserve(count);
+
+    // Indirect segments replay earlier ones but may not nest
+    auto run = [&](auto&& self, size_t pos, size_t segments, bool indirect_allowed) -> void {
+        for (size_t s = 0; s < segments && pos + 1 < words && out.size() < count; ++s) {
+            const uint16_t opcode = data[pos];
+            const uint16_t length = data[pos + 1];
+            pos += 2;
+            if (opcode == 0) {
+                // Discrete: length values follow
+                for (uint16_t j = 0; j < length && pos < words; ++j) out.push_back(data[pos++]);
+            }
+            else if (opcode == 1) {
+                // Linear: from the last value to the given one over length entries
+                if (pos >= words) return;
+                const double y0 = out.empty() ? data[pos] : out.back();
+                const double y1 = data[pos++];
+                for (uint16_t j = 1; j <= length; ++j) {
+                    out.push_back(static_cast<uint16_t>(y0 + (y1 - y0) * j / length + 0.5));
+                }
+            }
+            else if (opcode == 2 && indirect_allowed) {
+                // Indirect: length segments copied from a word offset (low word first)
+                if (pos + 1 >= words) return;
+                const size_t offset = data[pos] | (static_cast<size_t>(data[pos + 1]) << 16);
+                pos += 2;
+                self(self, offset, length, false);
+            }
+            else {
+                return;
+            }
+        }
+    };
+    run(run, 0, words, true);
+
+    if (out.size() > count) out.resize(count);
+    return out;
+}
+
+std::vector<uint32_t> build_palette_lut(const PaletteChannel& red, const PaletteChannel& green,
+    const PaletteChannel& blue, uint16_t index_bits) {
+    std::vector<uint32_t> lut(size_t{ 1 } << (index_bits > 8 ? 16 : 8));
+    if (red.entries.empty() || green.entries.empty() || blue.entries.empty()) {
+        return lut;
+    }
+    for (size_t value = 0; value < lut.size(); ++value) {
+        auto entry = [value](const PaletteChannel& c) -> uint32_t {
+            const size_t i = value > c.first_mapped ? value - c.first_mapped : 0;
+            return palette_entry(c, std::min<size_t>(i, std::max<uint32_t>(c.count, 1) - 1));
+        };
+        lut[value] = entry(red) | (entry(green) << 8) | (entry(blue) << 16);
+    }
+    return lut;
+}
+
+void apply_palette(const uint8_t* indices, const std::vector<uint32_t>& lut, size_t count, uint8_t* rgb, bool simd) {
+    kernels(simd).palette8(indices, lut.data(), rgb, count);
+}
+
+void apply_palette(const uint16_t* indices, const std::vector<uint32_t>& lut, size_t count, uint8_t* rgb, bool simd) {
+    kernels(simd).palette16(indices, lut.data(), rgb, count);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Photometric interpretations of three-sample color data
+enum class ColorModel {
+    Rgb,
+    YbrFull,
+    YbrFull422,   // two pixels per Y Y Cb Cr group, always interleaved
+    YbrRct,
+    YbrIct
+};
+
+// Converts count pixels of 8-bit color samples to interleaved RGB. planar is
+// Planar Configuration 1 (one plane per sample). Uses AVX2 when the CPU has it
+// and simd is set.
+void convert_to_rgb(ColorModel model, const uint8_t* src, bool planar, size_t count, uint8_t* rgb,
+    bool simd = true);
+
+// One channel of a Palette Color Lookup Table as stored in the file
+struct PaletteChannel {
+    uint32_t count = 0;          // entries (a descriptor value of 0 means 65536)
+    uint32_t first_mapped = 0;   // pixel value mapped to the first entry
+    uint16_t bits = 16;          // 8 or 16 bits per entry
+    std::vector<uint16_t> entries;
+};
+
+// Expands Segmented Palette Color Lookup Table Data (discrete, linear and
+// indirect segments) into at most count entries
+std::vector<uint16_t> expand_segmented_lut(const uint16_t* data, size_t words, uint32_t count);
+
+// Packed 0x00BBGGRR colors for every value of an index_bits-bit pixel; values
+// outside the tables take their first or last entry
+std::vector<uint32_t> build_palette_lut(const PaletteChannel& red, const PaletteChannel& green,
+    const PaletteChannel& blue, uint16_t index_bits);
+
+// Looks up count 8- or 16-bit palette indices into interleaved RGB
+void apply_palette(const uint8_t* indices, const std::vector<uint32_t>& lut, size_t count, uint8_t* rgb,
+    bool simd = true);
+void apply_palette(const uint16_t* indices, const std::vector<uint32_t>& lut, size_t count, uint8_t* rgb,
+    bool simd = true);
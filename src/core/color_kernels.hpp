@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Internal to color_convert: conversions of n pixels to interleaved 8-bit RGB.
+// The three source channels of pixel i are c0[i * stride], c1[i * stride] and
+// c2[i * stride]: stride 3 for interleaved samples (Planar Configuration 0),
+// stride 1 for separate planes (Planar Configuration 1).
+struct ColorKernels {
+    void (*copy_rgb)(const uint8_t* c0, const uint8_t* c1, const uint8_t* c2, size_t stride,
+        uint8_t* rgb, size_t n);
+
+    // YBR_FULL / YBR_ICT: JPEG (JFIF) YCbCr, full range, in Q15 fixed point
+    void (*ybr_full)(const uint8_t* y, const uint8_t* cb, const uint8_t* cr, size_t stride,
+        uint8_t* rgb, size_t n);
+
+    // YBR_RCT: reversible component transform with chroma centered on 128
+    void (*ybr_rct)(const uint8_t* y, const uint8_t* cb, const uint8_t* cr, size_t stride,
+        uint8_t* rgb, size_t n);
+
+    // PALETTE COLOR: lut holds 0x00BBGGRR for every possible index value
+    void (*palette8)(const uint8_t* indices, const uint32_t* lut, uint8_t* rgb, size_t n);
+    void (*palette16)(const uint16_t* indices, const uint32_t* lut, uint8_t* rgb, size_t n);
+};
+
+const ColorKernels& color_kernels_scalar();
+
+// nullptr when the build has no AVX2 kernels
+const ColorKernels* color_kernels_avx2();
+
+// Fixed-point YBR_FULL coefficients shared by all kernels, so they agree bit for bit
+inline constexpr int kYbrCrToR = 13173;    // 1.402 - 1
+inline constexpr int kYbrCbToG = 11277;    // 0.344136
+inline constexpr int kYbrCrToG = 23401;    // 0.714136
+inline constexpr int kYbrCbToB = 25297;    // 1.772 - 1
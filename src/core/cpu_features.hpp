@@ -0,0 +1,10 @@
+#pragma once
+
+// Instruction set extensions the running CPU (and OS) supports, detected once.
+// Kernels built for them are only called when the matching flag is set.
+struct CpuFeatures {
+    bool avx2 = false;
+    bool fma = false;
+};
+
+const CpuFeatures& cpu_features();
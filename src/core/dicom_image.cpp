@@ -1,8 +1,10 @@
 #include "dicom_image.hpp"
+#include "thread_pool.hpp"
 #include <algorithm>
 #include <cmath>
 #include <numeric>
 #include <iostream>
+#include <vector>
 
 uint8_t DicomImageData::apply_window_level(
     uint16_t pixel_value,
@@ -39,13 +41,45 @@ uint8_t DicomImageData::apply_window_level(
     return static_cast<uint8_t>(std::clamp(output, 0.0, 255.0));
 }
 
+ImageData ImageData::clone() const {
+    ImageData copy;
+    copy.pixels = pixels.clone();
+    copy.tiles = tiles;
+    copy.width = width;
+    copy.height = height;
+    copy.bits_stored = bits_stored;
+    copy.bits_allocated = bits_allocated;
+    copy.samples_per_pixel = samples_per_pixel;
+    copy.is_signed = is_signed;
+    copy.photometric = photometric;
+    copy.window_center = window_center;
+    copy.window_width = window_width;
+    copy.original_window_center = original_window_center;
+    copy.original_window_width = original_window_width;
+    copy.modality = modality;
+    copy.statistics = statistics;
+    copy.overlays = overlays;
+    copy.frame_index = frame_index;
+    return copy;
+}
+
+const PixelStatistics& DicomImageData::ensure_statistics() {
+    if (!data_.statistics) {
+        data_.statistics = data_.tiles
+            ? compute_tiled_statistics(*data_.tiles)
+            : compute_pixel_statistics(data_.pixels.gray16(), data_.pixels.pixel_count());
+    }
+    return *data_.statistics;
+}
+
 void DicomImageData::auto_window_level() {
-    if (data_.pixels.empty()) {
+    if (!data_.has_grayscale_pixels()) {
         return;
     }
 
-    uint16_t min_val = *std::min_element(data_.pixels.begin(), data_.pixels.end());
-    uint16_t max_val = *std::max_element(data_.pixels.begin(), data_.pixels.end());
+    const PixelStatistics& stats = ensure_statistics();
+    uint16_t min_val = stats.min_value;
+    uint16_t max_val = stats.max_value;
 
     std::cout << "[DEBUG] Auto W/L - Data range: " << min_val << " - " << max_val << std::endl;
 
@@ -57,18 +91,11 @@ void DicomImageData::auto_window_level() {
         return;
     }
 
-    const size_t num_bins = 4096;
-    const double range = static_cast<double>(max_val - min_val + 1);
-    const double bin_size = range / static_cast<double>(num_bins);
-    std::vector<uint32_t> histogram(num_bins, 0);
+    const size_t num_bins = PixelStatistics::kHistogramBins;
+    const double bin_size = stats.bin_size();
+    const std::vector<uint32_t>& histogram = stats.histogram;
 
-    for (uint16_t pixel : data_.pixels) {
-        size_t bin = static_cast<size_t>((pixel - min_val) / bin_size);
-        if (bin >= num_bins) bin = num_bins - 1;
-        histogram[bin]++;
-    }
-
-    const size_t total_pixels = data_.pixels.size();
+    const size_t total_pixels = data_.pixel_count();
 
     const size_t lower_threshold = total_pixels / 100;
     const size_t upper_threshold = total_pixels / 100;
@@ -111,51 +138,171 @@ void DicomImageData::auto_window_level() {
         << ", WW: " << data_.window_width << std::endl;
 }
 
-std::vector<uint8_t> DicomImageData::to_display_buffer(
+PixelBuffer DicomImageData::to_display_buffer(
     int32_t window_center,
-    int32_t window_width
+    int32_t window_width,
+    const std::vector<bool>* overlay_visible
 ) const {
     if (data_.is_rgb()) {
         return to_rgb_display_buffer();
     }
 
-    if (data_.is_preprocessed && !data_.processed_pixels.empty()) {
-        return data_.processed_pixels;
+    if (data_.tiles) {
+        return render_region(PixelRegion{ 0, 0, data_.width, data_.height },
+            data_.width, data_.height, window_center, window_width);
     }
 
-    const size_t pixel_count = data_.width * data_.height;
-    std::vector<uint8_t> display_buffer(pixel_count);
-
-    bool invert = false;
-
-    for (size_t i = 0; i < pixel_count; ++i) {
-        display_buffer[i] = apply_window_level(
-            data_.pixels[i],
-            window_center,
-            window_width,
-            invert
-        );
+    const uint16_t* pixels = data_.pixels.gray16();
+    if (!pixels) {
+        return {};
     }
 
+    const size_t pixel_count = data_.pixel_count();
+    PixelBuffer display_buffer = PixelBuffer::allocate(PixelFormat::Gray8, pixel_count);
+    uint8_t* display = display_buffer.gray8();
+
+    // Rows are windowed through one LUT on the shared pool, at the caller's
+    // priority, and overlays are drawn into each band while it is in cache
+    const std::vector<uint8_t> lut = window_lut(window_center, window_width);
+    const size_t width = data_.width;
+    const OverlayPlanes* overlays = overlay_visible ? data_.overlays.get() : nullptr;
+    ThreadPool::shared().parallel_for(data_.height, [&](size_t begin, size_t end) {
+        for (size_t i = begin * width; i < end * width; ++i) {
+            display[i] = lut[pixels[i]];
+        }
+        if (overlays) {
+            composite_overlays(*overlays, *overlay_visible, data_.frame_index, display, data_.width,
+                static_cast<uint32_t>(begin), static_cast<uint32_t>(end));
+        }
+    });
+
     return display_buffer;
 }
 
-std::vector<uint8_t> DicomImageData::to_rgb_display_buffer() const {
+PixelBuffer DicomImageData::to_rgb_display_buffer() const {
     if (!data_.is_rgb()) {
-        const size_t pixel_count = data_.width * data_.height;
-        std::vector<uint8_t> rgb_buffer(pixel_count * 3);
+        const size_t pixel_count = data_.pixel_count();
+        PixelBuffer gray_buffer = to_display_buffer(data_.window_center, data_.window_width);
+        const uint8_t* gray = gray_buffer.gray8();
+        if (!gray) {
+            return {};
+        }
 
-        auto gray_buffer = to_display_buffer(data_.window_center, data_.window_width);
+        PixelBuffer rgb_buffer = PixelBuffer::allocate(PixelFormat::Rgb8, pixel_count);
+        uint8_t* rgb = rgb_buffer.rgb8();
 
         for (size_t i = 0; i < pixel_count; ++i) {
-            uint8_t gray = gray_buffer[i];
-            rgb_buffer[i * 3 + 0] = gray;
-            rgb_buffer[i * 3 + 1] = gray;
-            rgb_buffer[i * 3 + 2] = gray;
+            rgb[i * 3 + 0] = gray[i];
+            rgb[i * 3 + 1] = gray[i];
+            rgb[i * 3 + 2] = gray[i];
         }
 
         return rgb_buffer;
     }
 
-    return data_.rgb_pixels;
-}
\ No newline at end of file
+    return data_.pixels.clone();
+}
+
+std::vector<uint8_t> DicomImageData::window_lut(int32_t window_center, int32_t window_width) {
+    std::vector<uint8_t> lut(65536);
+    for (uint32_t v = 0; v < lut.size(); ++v) {
+        lut[v] = apply_window_level(static_cast<uint16_t>(v), window_center, window_width, false);
+    }
+    return lut;
+}
+
+PixelRegion DicomImageData::clip_region(const PixelRegion& requested) const {
+    PixelRegion region = requested;
+    region.x = std::min(region.x, data_.width);
+    region.y = std::min(region.y, data_.height);
+    region.width = std::min(region.width, data_.width - region.x);
+    region.height = std::min(region.height, data_.height - region.y);
+    return region;
+}
+
+PixelBuffer DicomImageData::render_region(
+    const PixelRegion& requested,
+    uint32_t out_width,
+    uint32_t out_height,
+    int32_t window_center,
+    int32_t window_width
+) const {
+    const PixelRegion region = clip_region(requested);
+    if (!data_.has_grayscale_pixels() || region.width == 0 || region.height == 0 ||
+        out_width == 0 || out_height == 0) {
+        return {};
+    }
+
+    // One LUT per render instead of floating point math per pixel
+    const std::vector<uint8_t> lut = window_lut(window_center, window_width);
+
+    PixelBuffer output = PixelBuffer::allocate(PixelFormat::Gray8, static_cast<size_t>(out_width) * out_height);
+    uint8_t* out = output.gray8();
+    ThreadPool::shared().parallel_for(out_height, [&](size_t begin, size_t end) {
+        render_region_rows(region, out_width, out_height, lut.data(),
+            static_cast<uint32_t>(begin), static_cast<uint32_t>(end), out);
+    });
+    return output;
+}
+
+void DicomImageData::render_region_rows(
+    const PixelRegion& requested,
+    uint32_t out_width,
+    uint32_t out_height,
+    const uint8_t* lut,
+    uint32_t row_begin,
+    uint32_t row_end,
+    uint8_t* out
+) const {
+    const PixelRegion region = clip_region(requested);
+    row_end = std::min(row_end, out_height);
+    if (!data_.has_grayscale_pixels() || region.width == 0 || region.height == 0 ||
+        out_width == 0 || row_begin >= row_end) {
+        return;
+    }
+
+    // Source column of every output column and source row of every output row in the band
+    std::vector<uint32_t> src_x(out_width);
+    std::vector<uint32_t> src_y(row_end - row_begin);
+    for (uint32_t ox = 0; ox < out_width; ++ox) {
+        src_x[ox] = region.x + static_cast<uint32_t>(static_cast<uint64_t>(ox) * region.width / out_width);
+    }
+    for (uint32_t oy = row_begin; oy < row_end; ++oy) {
+        src_y[oy - row_begin] = region.y +
+            static_cast<uint32_t>(static_cast<uint64_t>(oy) * region.height / out_height);
+    }
+
+    if (!data_.tiles) {
+        const uint16_t* pixels = data_.pixels.gray16();
+        for (uint32_t oy = row_begin; oy < row_end; ++oy) {
+            const uint16_t* row = pixels + static_cast<size_t>(src_y[oy - row_begin]) * data_.width;
+            uint8_t* dst = out + static_cast<size_t>(oy) * out_width;
+            for (uint32_t ox = 0; ox < out_width; ++ox) {
+                dst[ox] = lut[row[src_x[ox]]];
+            }
+        }
+        return;
+    }
+
+    // Each tile fills the block of output pixels whose source lies inside it.
+    // The source coordinates are monotonic, so that block is a rectangle.
+    const PixelRegion band{ region.x, src_y.front(), region.width, src_y.back() - src_y.front() + 1 };
+    data_.tiles->for_each_tile(band, [&](const PixelRegion& part, const uint16_t* data, size_t stride) {
+        const uint32_t ox0 = static_cast<uint32_t>(
+            std::lower_bound(src_x.begin(), src_x.end(), part.x) - src_x.begin());
+        const uint32_t ox1 = static_cast<uint32_t>(
+            std::lower_bound(src_x.begin(), src_x.end(), part.x + part.width) - src_x.begin());
+        const uint32_t oy0 = static_cast<uint32_t>(
+            std::lower_bound(src_y.begin(), src_y.end(), part.y) - src_y.begin());
+        const uint32_t oy1 = static_cast<uint32_t>(
+            std::lower_bound(src_y.begin(), src_y.end(), part.y + part.height) - src_y.begin());
+
+        for (uint32_t oy = oy0; oy < oy1; ++oy) {
+            const uint16_t* row = data + (src_y[oy] - part.y) * stride;
+            uint8_t* dst = out + static_cast<size_t>(row_begin + oy) * out_width;
+            for (uint32_t ox = ox0; ox < ox1; ++ox) {
+                dst[ox] = lut[row[src_x[ox] - part.x]];
+            }
+        }
+    });
+}
@@ -3,6 +3,12 @@
 #include <cstdint>
 #include <optional>
 #include <algorithm>
+#include <memory>
+
+#include "overlay.hpp"
+#include "pixel_buffer.hpp"
+#include "pixel_statistics.hpp"
+#include "tiled_image.hpp"
 
 enum class PhotometricInterpretation {
     Monochrome1,
@@ -12,10 +18,31 @@ enum class PhotometricInterpretation {
     Unknown
 };
 
+// Maps a normalized 16-bit sample back to the modality value it came from
+// (e.g. HU): modality = sample * slope + intercept. A negative slope means
+// the samples were stored inverted, as MONOCHROME1 images are.
+struct ModalityMapping {
+    double slope = 1.0;
+    double intercept = 0.0;
+
+    double to_modality(double sample) const { return sample * slope + intercept; }
+    double to_sample(double modality) const { return (modality - intercept) / slope; }
+
+    // For samples normalized as (modality - min_value) * scale, then inverted if asked
+    static ModalityMapping from_normalization(double min_value, double scale, bool inverted) {
+        if (inverted) {
+            return ModalityMapping{ -1.0 / scale, min_value + 65535.0 / scale };
+        }
+        return ModalityMapping{ 1.0 / scale, min_value };
+    }
+};
+
 struct ImageData {
-    std::vector<uint16_t> pixels;
-    std::vector<uint8_t> rgb_pixels;
-    std::vector<uint8_t> processed_pixels;
+    // Gray16 for grayscale images, Rgb8 for color images
+    PixelBuffer pixels;
+
+    // Optional tiled layout of very large grayscale images; when set, pixels is empty
+    std::shared_ptr<const TiledImage> tiles;
 
     uint32_t width;
     uint32_t height;
@@ -23,7 +50,6 @@ struct ImageData {
     uint16_t bits_allocated;
     uint16_t samples_per_pixel;
     bool is_signed;
-    bool is_preprocessed;
 
     PhotometricInterpretation photometric;
 
@@ -35,12 +61,24 @@ struct ImageData {
     int32_t original_window_center;
     int32_t original_window_width;
 
+    // Normalized grayscale samples back to modality values
+    ModalityMapping modality;
+
+    // Min/max and histogram of the normalized pixels, filled on first use
+    std::optional<PixelStatistics> statistics;
+
+    // Overlay planes unpacked at load, shared by copies and frames as they never change
+    std::shared_ptr<const OverlayPlanes> overlays;
+
+    // Frame of the source object these pixels are, for multi-frame overlays
+    uint32_t frame_index;
+
     ImageData()
         : width(0), height(0), bits_stored(0), bits_allocated(0),
-        samples_per_pixel(1), is_signed(false), is_preprocessed(false),
+        samples_per_pixel(1), is_signed(false),
         photometric(PhotometricInterpretation::Monochrome2),
         window_center(0), window_width(0),
-        original_window_center(0), original_window_width(0) {
+        original_window_center(0), original_window_width(0), frame_index(0) {
     }
 
     bool is_rgb() const {
@@ -51,6 +89,18 @@ struct ImageData {
         return photometric == PhotometricInterpretation::Monochrome1 ||
             photometric == PhotometricInterpretation::Monochrome2;
     }
+
+    size_t pixel_count() const {
+        return static_cast<size_t>(width) * height;
+    }
+
+    bool has_grayscale_pixels() const {
+        return tiles != nullptr || pixels.gray16() != nullptr;
+    }
+
+    // Explicit deep copy; ImageData is move-only because of its pixel buffer.
+    // Tiles are immutable once materialized and are shared, not copied.
+    ImageData clone() const;
 };
 
 class DicomImageData {
@@ -71,18 +121,51 @@ public:
         return data_;
     }
 
-    // Convert grayscale to 8-bit display buffer with window/level
-    std::vector<uint8_t> to_display_buffer(
+    // Convert grayscale to 8-bit display buffer (Gray8) with window/level.
+    // Display buffers come from the shared buffer pool and are recycled across renders.
+    // With overlay_visible (one flag per overlay plane) the visible overlays
+    // are drawn into each band of rows as it is windowed.
+    PixelBuffer to_display_buffer(
+        int32_t window_center,
+        int32_t window_width,
+        const std::vector<bool>* overlay_visible = nullptr
+    ) const;
+
+    // Convert to an 8-bit RGB display buffer (Rgb8)
+    PixelBuffer to_rgb_display_buffer() const;
+
+    // Window a grayscale region and resample it (nearest neighbour) to
+    // out_width x out_height (Gray8). Tiled images are processed tile by tile.
+    PixelBuffer render_region(
+        const PixelRegion& region,
+        uint32_t out_width,
+        uint32_t out_height,
         int32_t window_center,
         int32_t window_width
     ) const;
 
-    // Convert RGB to 8-bit display buffer
-    std::vector<uint8_t> to_rgb_display_buffer() const;
+    // Rows [row_begin, row_end) of render_region's output, windowed through a
+    // 65536-entry window_lut into out (the whole out_width x out_height image).
+    // Disjoint row ranges may be rendered concurrently.
+    void render_region_rows(
+        const PixelRegion& region,
+        uint32_t out_width,
+        uint32_t out_height,
+        const uint8_t* lut,
+        uint32_t row_begin,
+        uint32_t row_end,
+        uint8_t* out
+    ) const;
+
+    // Display value of every 16-bit sample for a window, for paths that window many pixels
+    static std::vector<uint8_t> window_lut(int32_t window_center, int32_t window_width);
 
     // Auto-calculate optimal window/level from histogram
     void auto_window_level();
 
+    // Compute and cache pixel statistics if not already present
+    const PixelStatistics& ensure_statistics();
+
     // Reset to original window/level
     void reset_window_level() {
         data_.window_center = data_.original_window_center;
@@ -96,6 +179,9 @@ public:
     }
 
 private:
+    // Region clipped to the image bounds
+    PixelRegion clip_region(const PixelRegion& region) const;
+
     static uint8_t apply_window_level(
         uint16_t pixel_value,
         int32_t window_center,
@@ -51,12 +51,27 @@ std::string DicomMetadata::to_string() const {
         if (rows && columns) {
             oss << "  Dimensions: " << *columns << " x " << *rows << std::endl;
         }
+        if (number_of_frames) oss << "  Number of Frames: " << *number_of_frames << std::endl;
+        if (const auto rate = cine_frame_rate()) oss << "  Frame Rate: " << *rate << " fps" << std::endl;
         if (samples_per_pixel) oss << "  Samples Per Pixel: " << *samples_per_pixel << std::endl;
         if (bits_allocated) oss << "  Bits Allocated: " << *bits_allocated << std::endl;
         if (bits_stored) oss << "  Bits Stored: " << *bits_stored << std::endl;
         if (photometric_interpretation) oss << "  Photometric: " << *photometric_interpretation << std::endl;
+        if (rescale_slope || rescale_intercept) {
+            oss << "  Rescale: slope " << rescale_slope.value_or(1.0)
+                << ", intercept " << rescale_intercept.value_or(0.0) << std::endl;
+        }
         if (pixel_spacing) oss << "  Pixel Spacing: " << *pixel_spacing << std::endl;
         if (slice_thickness) oss << "  Slice Thickness: " << *slice_thickness << " mm" << std::endl;
+        if (image_position) {
+            const auto& p = *image_position;
+            oss << "  Position: " << p[0] << ", " << p[1] << ", " << p[2] << " mm" << std::endl;
+        }
+        if (image_orientation) {
+            const auto& o = *image_orientation;
+            oss << "  Orientation: " << o[0] << ", " << o[1] << ", " << o[2] << " / "
+                << o[3] << ", " << o[4] << ", " << o[5] << std::endl;
+        }
     }
     
     // Window/Level
@@ -68,4 +83,32 @@ std::string DicomMetadata::to_string() const {
     }
     
     return oss.str();
-}
\ No newline at end of file
+}
+std::optional<double> DicomMetadata::cine_frame_rate() const {
+    if (recommended_frame_rate) return recommended_frame_rate;
+    if (frame_time_ms) return 1000.0 / *frame_time_ms;
+    if (cine_rate) return cine_rate;
+    return std::nullopt;
+}
+
+bool is_valid_uid(const std::string& uid) {
+    if (uid.empty() || uid.size() > 64) {
+        return false;
+    }
+    bool component_start = true;
+    for (const char c : uid) {
+        if (c == '.') {
+            if (component_start) {
+                return false;
+            }
+            component_start = true;
+        }
+        else if (c >= '0' && c <= '9') {
+            component_start = false;
+        }
+        else {
+            return false;
+        }
+    }
+    return !component_start;
+}
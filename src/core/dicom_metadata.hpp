@@ -2,6 +2,7 @@
 
 #include <string>
 #include <optional>
+#include <array>
 #include <cstdint>
 
 struct DicomMetadata {
@@ -46,9 +47,23 @@ struct DicomMetadata {
     std::optional<uint16_t> bits_stored;
     std::optional<uint16_t> high_bit;
     std::optional<uint16_t> samples_per_pixel;
+    std::optional<uint16_t> pixel_representation;
     std::optional<std::string> photometric_interpretation;
     std::optional<std::string> pixel_spacing;
     std::optional<double> slice_thickness;
+    std::optional<int32_t> number_of_frames;
+    std::optional<double> rescale_slope;
+    std::optional<double> rescale_intercept;
+    
+    // Cine timing of multi-frame objects
+    std::optional<double> frame_time_ms;                  // Frame Time
+    std::optional<double> recommended_frame_rate;         // Recommended Display Frame Rate
+    std::optional<double> cine_rate;                      // Cine Rate
+    
+    // Patient-space geometry (mm)
+    std::optional<std::array<double, 3>> image_position;      // Image Position (Patient)
+    std::optional<std::array<double, 6>> image_orientation;   // Image Orientation (Patient): row, then column cosines
+    std::optional<std::array<double, 2>> pixel_spacing_mm;    // Between rows, then between columns
     
     // Window/Level
     std::optional<int32_t> window_center;
@@ -58,6 +73,14 @@ struct DicomMetadata {
     // Transfer Syntax
     std::optional<std::string> transfer_syntax_uid;
     
+    // Playback rate in frames per second: the recommended display rate,
+    // else the acquisition Frame Time, else the Cine Rate
+    std::optional<double> cine_frame_rate() const;
+    
     // Helper method to format for display
     std::string to_string() const;
-};
\ No newline at end of file
+};
+
+// Whether uid follows the UID grammar: at most 64 characters, components of
+// digits separated by single dots. Such a UID is safe as a path component.
+bool is_valid_uid(const std::string& uid);
@@ -12,6 +12,7 @@ enum class DicomError {
     MemoryAllocationFailed,
     UnsupportedPhotometricInterpretation,
     InvalidMetadata,
+    NetworkError,
     UnknownError
 };
 
@@ -40,6 +41,7 @@ struct ErrorInfo {
             case DicomError::MemoryAllocationFailed: return "MemoryAllocationFailed";
             case DicomError::UnsupportedPhotometricInterpretation: return "UnsupportedPhotometricInterpretation";
             case DicomError::InvalidMetadata: return "InvalidMetadata";
+            case DicomError::NetworkError: return "NetworkError";
             default: return "UnknownError";
         }
     }
@@ -0,0 +1,60 @@
+#include "frame_set.hpp"
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+
+std::pair<int32_t, int32_t> FrameSet::frame_window(uint32_t index) const {
+    if (functional_groups.empty() || index >= functional_groups.frame_count ||
+        !functional_groups.has(index, FunctionalGroupTable::Window)) {
+        return { window_center, window_width };
+    }
+    const double center = modality.to_sample(functional_groups.window_center[index]);
+    const double width = functional_groups.window_width[index] / std::abs(modality.slope);
+    return { static_cast<int32_t>(std::lround(center)), std::max(static_cast<int32_t>(std::lround(width)), 1) };
+}
+
+DicomImageData FrameSet::frame_image(uint32_t index) const {
+    ImageData img_data;
+    img_data.width = width;
+    img_data.height = height;
+    img_data.bits_allocated = bits_allocated;
+    img_data.bits_stored = bits_stored;
+    img_data.samples_per_pixel = 1;
+    img_data.is_signed = is_signed;
+    img_data.photometric = PhotometricInterpretation::Monochrome2;
+    std::tie(img_data.window_center, img_data.window_width) = frame_window(index);
+    img_data.modality = modality;
+    img_data.overlays = overlays;
+    img_data.frame_index = index;
+
+    const uint16_t* src = frame(index);
+    img_data.pixels = PixelBuffer::allocate(PixelFormat::Gray16, frame_pixels());
+    std::copy(src, src + frame_pixels(), img_data.pixels.gray16());
+
+    DicomImageData image;
+    image.set_data(std::move(img_data));
+    return image;
+}
+
+PixelBuffer FrameSet::window_frame(uint32_t index, const std::vector<uint8_t>& lut,
+    const std::vector<bool>* overlay_visible) const {
+    const uint16_t* src = frame(index);
+    PixelBuffer display = PixelBuffer::allocate(PixelFormat::Gray8, frame_pixels());
+    uint8_t* dst = display.gray8();
+    if (!overlay_visible || !overlays) {
+        for (size_t i = 0; i < frame_pixels(); ++i) {
+            dst[i] = lut[src[i]];
+        }
+        return display;
+    }
+
+    // Overlays go into each row right after it is windowed
+    for (uint32_t y = 0; y < height; ++y) {
+        const size_t row = static_cast<size_t>(y) * width;
+        for (size_t i = row; i < row + width; ++i) {
+            dst[i] = lut[src[i]];
+        }
+        composite_overlays(*overlays, *overlay_visible, index, dst, width, y, y + 1);
+    }
+    return display;
+}
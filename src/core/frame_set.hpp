@@ -0,0 +1,65 @@
+#pragma once
+
+#include "dicom_image.hpp"
+#include "functional_groups.hpp"
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// All frames of a multi-frame grayscale object, normalized to 0-65535
+// and stored back to back in one preallocated buffer (one slot per frame)
+struct FrameSet {
+    PixelBuffer pixels;
+
+    uint32_t width;
+    uint32_t height;
+    uint32_t frame_count;
+    uint16_t bits_stored;
+    uint16_t bits_allocated;
+    bool is_signed;
+
+    int32_t window_center;
+    int32_t window_width;
+
+    // Shared by all frames, which are normalized with one value range
+    ModalityMapping modality;
+
+    // Per-frame geometry, rescale and window of enhanced multi-frame
+    // objects; empty for other objects
+    FunctionalGroupTable functional_groups;
+
+    // Overlay planes of the object, handed to every frame image
+    std::shared_ptr<const OverlayPlanes> overlays;
+
+    FrameSet()
+        : width(0), height(0), frame_count(0), bits_stored(0), bits_allocated(0),
+        is_signed(false), window_center(0), window_width(0) {
+    }
+
+    size_t frame_pixels() const {
+        return static_cast<size_t>(width) * height;
+    }
+
+    const uint16_t* frame(uint32_t index) const {
+        return pixels.gray16() + index * frame_pixels();
+    }
+
+    uint16_t* frame(uint32_t index) {
+        return pixels.gray16() + index * frame_pixels();
+    }
+
+    // The frame's own window from its functional groups, else the shared
+    // one, as center and width in sample units
+    std::pair<int32_t, int32_t> frame_window(uint32_t index) const;
+
+    // Copy one frame out as a standalone image for the display path,
+    // carrying the frame's window and the overlays
+    DicomImageData frame_image(uint32_t index) const;
+
+    // Window one frame into a Gray8 display buffer through a DicomImageData::window_lut
+    // table, drawing the visible overlays (one flag per plane) row by row if given
+    PixelBuffer window_frame(uint32_t index, const std::vector<uint8_t>& lut,
+        const std::vector<bool>* overlay_visible = nullptr) const;
+};
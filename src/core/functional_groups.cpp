@@ -0,0 +1,39 @@
+#include "functional_groups.hpp"
+
+void FunctionalGroupTable::resize(uint32_t frames) {
+    frame_count = frames;
+    fields.assign(frames, 0);
+    position.assign(frames, Vec3{});
+    row_direction.assign(frames, Vec3{ 1, 0, 0 });
+    column_direction.assign(frames, Vec3{ 0, 1, 0 });
+    pixel_spacing.assign(frames, { 1.0, 1.0 });
+    slice_thickness.assign(frames, 0.0);
+    rescale_slope.assign(frames, 1.0);
+    rescale_intercept.assign(frames, 0.0);
+    window_center.assign(frames, 0.0);
+    window_width.assign(frames, 0.0);
+    in_stack_position.assign(frames, 0);
+    temporal_position.assign(frames, 0);
+    common_fields_ = 0;
+    varying_fields_ = 0;
+}
+
+void FunctionalGroupTable::finish() {
+    common_fields_ = frame_count > 0 ? 0xFF : 0;
+    varying_fields_ = 0;
+    for (uint32_t f = 0; f < frame_count; ++f) {
+        common_fields_ &= fields[f];
+    }
+
+    auto same_vec = [](const Vec3& a, const Vec3& b) { return a.x == b.x && a.y == b.y && a.z == b.z; };
+    for (uint32_t f = 1; f < frame_count; ++f) {
+        if (!same_vec(position[f], position[0])) varying_fields_ |= Position;
+        if (!same_vec(row_direction[f], row_direction[0]) ||
+            !same_vec(column_direction[f], column_direction[0])) varying_fields_ |= Orientation;
+        if (pixel_spacing[f] != pixel_spacing[0] || slice_thickness[f] != slice_thickness[0]) varying_fields_ |= Spacing;
+        if (rescale_slope[f] != rescale_slope[0] || rescale_intercept[f] != rescale_intercept[0]) varying_fields_ |= Rescale;
+        if (window_center[f] != window_center[0] || window_width[f] != window_width[0]) varying_fields_ |= Window;
+        if (in_stack_position[f] != in_stack_position[0] ||
+            temporal_position[f] != temporal_position[0]) varying_fields_ |= Stack;
+    }
+}
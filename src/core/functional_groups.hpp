@@ -0,0 +1,56 @@
+#pragma once
+
+#include "volume.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Per-frame values of an enhanced multi-frame object (Enhanced CT and MR,
+// breast tomosynthesis), flattened once at load from its Shared and
+// Per-Frame Functional Groups Sequences. Each attribute is one array indexed
+// by frame, so a lookup is a single load however many frames there are;
+// shared values are copied into every frame's entry. A frame whose groups
+// lack an attribute has its flag for it cleared.
+struct FunctionalGroupTable {
+    enum Field : uint8_t {
+        Position = 1 << 0,      // Plane Position (Patient)
+        Orientation = 1 << 1,   // Plane Orientation (Patient)
+        Spacing = 1 << 2,       // Pixel Measures
+        Rescale = 1 << 3,       // Pixel Value Transformation
+        Window = 1 << 4,        // Frame VOI LUT
+        Stack = 1 << 5          // Frame Content: stack and temporal position
+    };
+
+    uint32_t frame_count = 0;
+    std::vector<uint8_t> fields;                  // Field bits present per frame
+
+    std::vector<Vec3> position;                   // mm, center of the first pixel
+    std::vector<Vec3> row_direction;
+    std::vector<Vec3> column_direction;
+    std::vector<std::array<double, 2>> pixel_spacing;   // between rows, then columns (mm)
+    std::vector<double> slice_thickness;          // mm, 0 when not given
+    std::vector<double> rescale_slope;
+    std::vector<double> rescale_intercept;
+    std::vector<double> window_center;            // modality units
+    std::vector<double> window_width;
+    std::vector<uint32_t> in_stack_position;      // 1-based, 0 when not given
+    std::vector<uint32_t> temporal_position;      // 1-based, 0 when not given
+
+    // Every frame with default values and no fields
+    void resize(uint32_t frames);
+
+    bool empty() const { return frame_count == 0; }
+    bool has(uint32_t frame, Field field) const { return (fields[frame] & field) != 0; }
+    bool all_have(Field field) const { return !empty() && (common_fields_ & field) != 0; }
+
+    // Whether any two frames carry different values for a field they all have
+    bool varies(Field field) const { return all_have(field) && (varying_fields_ & field) != 0; }
+
+    // Called once the arrays are filled, before the table is shared
+    void finish();
+
+private:
+    uint8_t common_fields_ = 0;
+    uint8_t varying_fields_ = 0;
+};
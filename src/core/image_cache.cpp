@@ -0,0 +1,123 @@
+#include "image_cache.hpp"
+#include <iostream>
+
+ImageCache::ImageCache(uint64_t max_bytes)
+    : max_bytes_(max_bytes) {
+}
+
+Result<SharedImage, ErrorInfo> ImageCache::get_or_load(const std::string& key, const Loader& loader) {
+    std::unique_lock lock(mutex_);
+    for (;;) {
+        auto it = entries_.find(key);
+        if (it == entries_.end()) {
+            break;
+        }
+        if (!it->second.loading) {
+            lru_.splice(lru_.begin(), lru_, it->second.lru);
+            ++stats_.hits;
+            return it->second.image;
+        }
+        // Another viewport is decoding it; a failed load leaves no entry and we load ourselves
+        loaded_.wait(lock);
+    }
+
+    entries_.emplace(key, Entry{});
+    ++stats_.misses;
+    lock.unlock();
+
+    auto result = loader();
+
+    lock.lock();
+    if (result.is_error()) {
+        entries_.erase(key);
+        loaded_.notify_all();
+        return result.error();
+    }
+
+    auto image = std::make_shared<const DicomImageData>(std::move(result.value()));
+    Entry& entry = entries_[key];
+    entry.image = image;
+    entry.loading = false;
+    entry.bytes = image_bytes(*image);
+    lru_.push_front(key);
+    entry.lru = lru_.begin();
+    stats_.bytes += entry.bytes;
+
+    evict_locked();
+    loaded_.notify_all();
+    return image;
+}
+
+void ImageCache::insert(const std::string& key, DicomImageData image) {
+    auto shared = std::make_shared<const DicomImageData>(std::move(image));
+    const uint64_t bytes = image_bytes(*shared);
+
+    std::lock_guard lock(mutex_);
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+        if (it->second.loading) {
+            return;
+        }
+        stats_.bytes -= it->second.bytes;
+        lru_.erase(it->second.lru);
+        entries_.erase(it);
+    }
+
+    Entry& entry = entries_[key];
+    entry.image = std::move(shared);
+    entry.loading = false;
+    entry.bytes = bytes;
+    lru_.push_front(key);
+    entry.lru = lru_.begin();
+    stats_.bytes += bytes;
+
+    evict_locked();
+}
+
+SharedImage ImageCache::find(const std::string& key) {
+    std::lock_guard lock(mutex_);
+    auto it = entries_.find(key);
+    if (it == entries_.end() || it->second.loading) {
+        return nullptr;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second.lru);
+    return it->second.image;
+}
+
+void ImageCache::clear() {
+    std::lock_guard lock(mutex_);
+    for (const std::string& key : lru_) {
+        entries_.erase(key);
+    }
+    lru_.clear();
+    stats_.bytes = 0;
+}
+
+ImageCacheStats ImageCache::stats() const {
+    std::lock_guard lock(mutex_);
+    ImageCacheStats stats = stats_;
+    stats.entries = lru_.size();
+    return stats;
+}
+
+uint64_t ImageCache::image_bytes(const DicomImageData& image) {
+    const ImageData& data = image.data();
+    if (data.tiles) {
+        // Tiles materialize on demand; count them as if all were read
+        return static_cast<uint64_t>(data.pixel_count()) * sizeof(uint16_t);
+    }
+    return data.pixels.size_bytes();
+}
+
+void ImageCache::evict_locked() {
+    // The most recent image stays even when it alone exceeds the budget
+    while (stats_.bytes > max_bytes_ && lru_.size() > 1) {
+        const std::string key = lru_.back();
+        lru_.pop_back();
+        auto it = entries_.find(key);
+        stats_.bytes -= it->second.bytes;
+        entries_.erase(it);
+        ++stats_.evictions;
+        std::cout << "[DEBUG] Image cache evicted " << key << std::endl;
+    }
+}
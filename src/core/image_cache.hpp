@@ -0,0 +1,73 @@
+#pragma once
+
+#include "dicom_image.hpp"
+#include "error_codes.hpp"
+#include "result.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Decoded images are immutable once cached and shared by every viewport showing them
+using SharedImage = std::shared_ptr<const DicomImageData>;
+
+struct ImageCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;        // loads started
+    uint64_t evictions = 0;
+    uint64_t bytes = 0;         // pixel bytes of the cached images
+    size_t entries = 0;
+};
+
+// In-memory LRU of decoded images keyed by file path. Each image is decoded
+// once however many viewports show it; concurrent requests for an image that
+// is still loading wait for that load instead of decoding it again. Eviction
+// only drops the cache's reference, so images on screen stay alive.
+class ImageCache {
+public:
+    using Loader = std::function<Result<DicomImageData, ErrorInfo>()>;
+
+    explicit ImageCache(uint64_t max_bytes = 2ull * 1024 * 1024 * 1024);
+
+    ImageCache(const ImageCache&) = delete;
+    ImageCache& operator=(const ImageCache&) = delete;
+
+    // Cached image for key, or the result of loader() which is then cached.
+    // A failed load is not cached; the next request tries again.
+    Result<SharedImage, ErrorInfo> get_or_load(const std::string& key, const Loader& loader);
+
+    // Caches an image decoded elsewhere (e.g. received over the network),
+    // replacing an older one; ignored while a load of the same key is running
+    void insert(const std::string& key, DicomImageData image);
+
+    // Cached image for key, nullptr if absent or still loading
+    SharedImage find(const std::string& key);
+
+    void clear();
+
+    ImageCacheStats stats() const;
+
+    // Bytes an image occupies once fully decoded
+    static uint64_t image_bytes(const DicomImageData& image);
+
+private:
+    struct Entry {
+        SharedImage image;
+        bool loading = true;
+        uint64_t bytes = 0;
+        std::list<std::string>::iterator lru;   // valid once loaded
+    };
+
+    uint64_t max_bytes_;
+    mutable std::mutex mutex_;
+    std::condition_variable loaded_;
+    std::unordered_map<std::string, Entry> entries_;
+    std::list<std::string> lru_;   // loaded keys, most recently used first
+    ImageCacheStats stats_;
+
+    void evict_locked();
+};
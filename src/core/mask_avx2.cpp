@@ -0,0 +1,108 @@
+// Built with AVX2 enabled; only reached after a runtime CPU check. Like
+// mpr_avx2.cpp, this file avoids inline library code.
+#include "mask_kernels.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+namespace {
+
+// 32 bits of 4 packed bytes to 32 bytes of 0 or 255: byte k goes to lanes
+// 8k..8k+7, each of which tests its own bit
+void unpack_bits(const uint8_t* packed, uint8_t* out, size_t n) {
+    const __m256i spread = _mm256_setr_epi8(
+        0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1,
+        2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+    const __m256i bits = _mm256_set1_epi64x(static_cast<long long>(0x8040201008040201ULL));
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const __m256i word = _mm256_broadcastd_epi32(_mm_loadu_si32(packed + i / 8));
+        const __m256i bytes = _mm256_shuffle_epi8(word, spread);
+        const __m256i set = _mm256_cmpeq_epi8(_mm256_and_si256(bytes, bits), bits);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), set);
+    }
+    for (; i < n; ++i) {
+        out[i] = (packed[i >> 3] >> (i & 7)) & 1 ? 255 : 0;
+    }
+}
+
+// 32 samples at a time: shift the bit down to bit 0 of each 16-bit lane,
+// pack to bytes (lane-interleaved, hence the permute), and 0 - 1 = 255
+void extract_bit(const uint16_t* samples, unsigned bit, uint8_t* out, size_t n) {
+    const __m128i shift = _mm_cvtsi32_si128(static_cast<int>(bit));
+    const __m256i one = _mm256_set1_epi16(1);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(samples + i));
+        const __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(samples + i + 16));
+        const __m256i packed = _mm256_packus_epi16(_mm256_and_si256(_mm256_srl_epi16(low, shift), one),
+            _mm256_and_si256(_mm256_srl_epi16(high, shift), one));
+        const __m256i set = _mm256_sub_epi8(_mm256_setzero_si256(), _mm256_permute4x64_epi64(packed, 0xD8));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), set);
+    }
+    for (; i < n; ++i) {
+        out[i] = (samples[i] >> bit) & 1 ? 255 : 0;
+    }
+}
+
+inline uint32_t div255(uint32_t x) {
+    const uint32_t t = x + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+// x / 255 rounded for 16-bit lanes holding at most 255 * 255
+inline __m256i div255(__m256i x) {
+    const __m256i t = _mm256_add_epi16(x, _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+// One channel of 16 pixels: c * keep + color * alpha, rounded back to bytes
+inline void blend_channel(uint8_t* c, __m256i keep, __m256i color_alpha) {
+    const __m256i value = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(c)));
+    const __m256i mixed = div255(_mm256_add_epi16(_mm256_mullo_epi16(value, keep), color_alpha));
+    const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(mixed, mixed), 0xD8);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(c), _mm256_castsi256_si128(packed));
+}
+
+void blend_layer(uint8_t* r, uint8_t* g, uint8_t* b, const uint8_t* coverage,
+    uint8_t red, uint8_t green, uint8_t blue, uint8_t opacity, size_t n) {
+    const __m256i opacity_v = _mm256_set1_epi16(opacity);
+    const __m256i full = _mm256_set1_epi16(255);
+    const __m256i red_v = _mm256_set1_epi16(red);
+    const __m256i green_v = _mm256_set1_epi16(green);
+    const __m256i blue_v = _mm256_set1_epi16(blue);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m128i cov = _mm_loadu_si128(reinterpret_cast<const __m128i*>(coverage + i));
+        // Masks are mostly empty away from the segmented structure
+        if (_mm_testz_si128(cov, cov)) continue;
+        const __m256i alpha = div255(_mm256_mullo_epi16(_mm256_cvtepu8_epi16(cov), opacity_v));
+        const __m256i keep = _mm256_sub_epi16(full, alpha);
+        blend_channel(r + i, keep, _mm256_mullo_epi16(red_v, alpha));
+        blend_channel(g + i, keep, _mm256_mullo_epi16(green_v, alpha));
+        blend_channel(b + i, keep, _mm256_mullo_epi16(blue_v, alpha));
+    }
+    for (; i < n; ++i) {
+        const uint32_t alpha = div255(coverage[i] * uint32_t{ opacity });
+        const uint32_t keep = 255 - alpha;
+        r[i] = static_cast<uint8_t>(div255(r[i] * keep + red * alpha));
+        g[i] = static_cast<uint8_t>(div255(g[i] * keep + green * alpha));
+        b[i] = static_cast<uint8_t>(div255(b[i] * keep + blue * alpha));
+    }
+}
+
+const MaskKernels kKernels{ unpack_bits, extract_bit, blend_layer };
+
+} // namespace
+
+const MaskKernels* mask_kernels_avx2() {
+    return &kKernels;
+}
+
+#else
+
+const MaskKernels* mask_kernels_avx2() {
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,111 @@
+#include "mask_blend.hpp"
+#include "color_convert.hpp"
+#include "cpu_features.hpp"
+#include "mask_kernels.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+void unpack(const uint8_t* packed, uint8_t* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = (packed[i >> 3] >> (i & 7)) & 1 ? 255 : 0;
+    }
+}
+
+void extract_bit(const uint16_t* samples, unsigned bit, uint8_t* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = (samples[i] >> bit) & 1 ? 255 : 0;
+    }
+}
+
+// x / 255 rounded, exact for x up to 255 * 255
+inline uint32_t div255(uint32_t x) {
+    const uint32_t t = x + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+void blend_layer(uint8_t* r, uint8_t* g, uint8_t* b, const uint8_t* coverage,
+    uint8_t red, uint8_t green, uint8_t blue, uint8_t opacity, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        const uint32_t alpha = div255(coverage[i] * uint32_t{ opacity });
+        if (alpha == 0) continue;
+        const uint32_t keep = 255 - alpha;
+        r[i] = static_cast<uint8_t>(div255(r[i] * keep + red * alpha));
+        g[i] = static_cast<uint8_t>(div255(g[i] * keep + green * alpha));
+        b[i] = static_cast<uint8_t>(div255(b[i] * keep + blue * alpha));
+    }
+}
+
+const MaskKernels& kernels(bool simd) {
+    const MaskKernels* avx2 = simd && cpu_features().avx2 ? mask_kernels_avx2() : nullptr;
+    return avx2 ? *avx2 : mask_kernels_scalar();
+}
+
+// Pixels are blended as planes a block at a time, then interleaved
+constexpr size_t kBlock = 256;
+
+void blend_planes(const MaskKernels& k, uint8_t* planes, const BlendLayer* layers, size_t layer_count,
+    size_t start, size_t n) {
+    uint8_t* r = planes;
+    uint8_t* g = planes + n;
+    uint8_t* b = planes + 2 * n;
+    for (size_t l = 0; l < layer_count; ++l) {
+        const BlendLayer& layer = layers[l];
+        if (layer.opacity == 0) continue;
+        k.blend_layer(r, g, b, layer.coverage + start, layer.color[0], layer.color[1], layer.color[2],
+            layer.opacity, n);
+    }
+}
+
+} // namespace
+
+const MaskKernels& mask_kernels_scalar() {
+    static const MaskKernels kernels{ unpack, extract_bit, blend_layer };
+    return kernels;
+}
+
+void unpack_bits(const uint8_t* packed, size_t first_bit, size_t count, uint8_t* out, bool simd) {
+    packed += first_bit >> 3;
+    // Bits up to the next byte boundary, then whole bytes
+    const size_t lead = std::min(count, (8 - (first_bit & 7)) & 7);
+    for (size_t i = 0; i < lead; ++i) {
+        out[i] = (packed[0] >> ((first_bit & 7) + i)) & 1 ? 255 : 0;
+    }
+    if (lead > 0) ++packed;
+    kernels(simd).unpack_bits(packed, out + lead, count - lead);
+}
+
+void extract_bit_plane(const uint16_t* samples, size_t count, unsigned bit, uint8_t* out, bool simd) {
+    kernels(simd).extract_bit(samples, bit & 15, out, count);
+}
+
+void blend_layers(const uint8_t* gray, const BlendLayer* layers, size_t layer_count, size_t count,
+    uint8_t* rgb, bool simd) {
+    const MaskKernels& k = kernels(simd);
+    uint8_t planes[3 * kBlock];
+    for (size_t start = 0; start < count; start += kBlock) {
+        const size_t n = std::min(kBlock, count - start);
+        for (size_t c = 0; c < 3; ++c) {
+            std::memcpy(planes + c * n, gray + start, n);
+        }
+        blend_planes(k, planes, layers, layer_count, start, n);
+        convert_to_rgb(ColorModel::Rgb, planes, true, n, rgb + start * 3, simd);
+    }
+}
+
+void blend_layers_rgb(uint8_t* rgb, const BlendLayer* layers, size_t layer_count, size_t count, bool simd) {
+    const MaskKernels& k = kernels(simd);
+    uint8_t planes[3 * kBlock];
+    for (size_t start = 0; start < count; start += kBlock) {
+        const size_t n = std::min(kBlock, count - start);
+        uint8_t* block = rgb + start * 3;
+        for (size_t i = 0; i < n; ++i) {
+            planes[i] = block[i * 3];
+            planes[n + i] = block[i * 3 + 1];
+            planes[2 * n + i] = block[i * 3 + 2];
+        }
+        blend_planes(k, planes, layers, layer_count, start, n);
+        convert_to_rgb(ColorModel::Rgb, planes, true, n, block, simd);
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Expands count 1-bit samples, least significant bit first, starting at bit
+// first_bit of packed, to one byte each: 255 where the bit is set, else 0.
+// This is the packing of binary segmentation frames and overlay planes.
+// Uses AVX2 when the CPU has it and simd is set.
+void unpack_bits(const uint8_t* packed, size_t first_bit, size_t count, uint8_t* out, bool simd = true);
+
+// Same for bit `bit` (0-15) of count 16-bit samples: an overlay embedded
+// in the unused high bits of pixel data
+void extract_bit_plane(const uint16_t* samples, size_t count, unsigned bit, uint8_t* out, bool simd = true);
+
+// A colored mask drawn over an image: coverage is 0-255 per pixel (a
+// fractional segment's probability, or 0/255 for a binary one) and is
+// scaled by opacity
+struct BlendLayer {
+    const uint8_t* coverage;
+    std::array<uint8_t, 3> color;
+    uint8_t opacity;
+};
+
+// Colors count 8-bit gray pixels and alpha-blends the layers over them in
+// order, writing interleaved RGB
+void blend_layers(const uint8_t* gray, const BlendLayer* layers, size_t layer_count, size_t count,
+    uint8_t* rgb, bool simd = true);
+
+// Same over interleaved RGB pixels, in place
+void blend_layers_rgb(uint8_t* rgb, const BlendLayer* layers, size_t layer_count, size_t count,
+    bool simd = true);
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Internal to mask_blend: 1-bit expansion and alpha blending of one run of pixels
+struct MaskKernels {
+    // n bits of packed, least significant bit first, to 0 or 255 per byte;
+    // the first bit is bit 0 of packed[0]
+    void (*unpack_bits)(const uint8_t* packed, uint8_t* out, size_t n);
+
+    // Bit `bit` of n samples to 0 or 255 per byte
+    void (*extract_bit)(const uint16_t* samples, unsigned bit, uint8_t* out, size_t n);
+
+    // Blends color over the planes r, g, b where coverage is set:
+    // alpha = coverage * opacity / 255, c = (c * (255 - alpha) + color * alpha) / 255,
+    // each division rounded to nearest
+    void (*blend_layer)(uint8_t* r, uint8_t* g, uint8_t* b, const uint8_t* coverage,
+        uint8_t red, uint8_t green, uint8_t blue, uint8_t opacity, size_t n);
+};
+
+const MaskKernels& mask_kernels_scalar();
+
+// nullptr when the build has no AVX2 kernels
+const MaskKernels* mask_kernels_avx2();
@@ -0,0 +1,191 @@
+#include "mpr.hpp"
+#include "cpu_features.hpp"
+#include "mpr_kernels.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <numbers>
+
+namespace {
+
+constexpr uint32_t kMaxPlaneDimension = 4096;
+
+std::array<Vec3, 8> volume_corners(const Volume& volume) {
+    const double x = volume.width - 1.0;
+    const double y = volume.height - 1.0;
+    const double z = volume.depth - 1.0;
+    return { volume.voxel_to_patient({ 0, 0, 0 }), volume.voxel_to_patient({ x, 0, 0 }),
+             volume.voxel_to_patient({ 0, y, 0 }), volume.voxel_to_patient({ x, y, 0 }),
+             volume.voxel_to_patient({ 0, 0, z }), volume.voxel_to_patient({ x, 0, z }),
+             volume.voxel_to_patient({ 0, y, z }), volume.voxel_to_patient({ x, y, z }) };
+}
+
+// Largest distance of a volume corner from the volume center along axis
+double half_extent(const Volume& volume, const Vec3& axis) {
+    const Vec3 center = volume.center();
+    double extent = 0;
+    for (const Vec3& corner : volume_corners(volume)) {
+        extent = std::max(extent, std::abs((corner - center).dot(axis)));
+    }
+    return extent;
+}
+
+uint32_t plane_dimension(double half, double spacing) {
+    const double samples = std::ceil(2.0 * half / spacing) + 1.0;
+    return static_cast<uint32_t>(std::clamp(samples, 1.0, static_cast<double>(kMaxPlaneDimension)));
+}
+
+} // namespace
+
+Vec3 MprPlane::origin() const {
+    return center - u * ((width - 1.0) * 0.5 * spacing) - v * ((height - 1.0) * 0.5 * spacing);
+}
+
+MprPlane make_mpr_plane(const Volume& volume, MprOrientation orientation, double offset_mm,
+    double tilt_degrees, double rotation_degrees) {
+    // Patient axes (LPS): x to the patient's left, y posterior, z toward the head
+    MprPlane plane;
+    switch (orientation) {
+    case MprOrientation::Axial:
+    case MprOrientation::Oblique:
+        plane.u = { 1, 0, 0 };
+        plane.v = { 0, 1, 0 };
+        break;
+    case MprOrientation::Coronal:
+        plane.u = { 1, 0, 0 };
+        plane.v = { 0, 0, -1 };
+        break;
+    case MprOrientation::Sagittal:
+        plane.u = { 0, 1, 0 };
+        plane.v = { 0, 0, -1 };
+        break;
+    }
+
+    if (orientation == MprOrientation::Oblique) {
+        const double tilt = tilt_degrees * std::numbers::pi / 180.0;
+        const double rotation = rotation_degrees * std::numbers::pi / 180.0;
+        const Vec3 n = plane.normal();
+        const Vec3 tilted_v = plane.v * std::cos(tilt) + n * std::sin(tilt);
+        const Vec3 u = plane.u;
+        plane.u = u * std::cos(rotation) + tilted_v * std::sin(rotation);
+        plane.v = tilted_v * std::cos(rotation) - u * std::sin(rotation);
+    }
+
+    plane.spacing = std::max(std::min(volume.spacing.x, volume.spacing.y), 1e-3);
+    plane.center = volume.center() + plane.normal() * offset_mm;
+    plane.width = plane_dimension(half_extent(volume, plane.u), plane.spacing);
+    plane.height = plane_dimension(half_extent(volume, plane.v), plane.spacing);
+    return plane;
+}
+
+double mpr_offset_limit(const Volume& volume, const MprPlane& plane) {
+    return half_extent(volume, plane.normal());
+}
+
+MprRenderer::MprRenderer(ThreadPool& pool)
+    : pool_(pool)
+    , simd_enabled_(true) {
+}
+
+void MprRenderer::set_simd_enabled(bool enabled) {
+    simd_enabled_ = enabled;
+}
+
+void MprRenderer::reslice(const Volume& volume, const MprPlane& plane, uint16_t* out) const {
+    const size_t out_pixels = static_cast<size_t>(plane.width) * plane.height;
+    if (volume.width < 2 || volume.height < 2 || volume.depth < 2 || volume.empty()) {
+        std::fill(out, out + out_pixels, uint16_t{ 0 });
+        return;
+    }
+
+    // Voxel coordinates are affine in the output pixel position
+    const Vec3 start = volume.patient_to_voxel(plane.origin());
+    const Vec3 step_i = volume.patient_to_voxel(plane.origin() + plane.u * plane.spacing) - start;
+    const Vec3 step_j = volume.patient_to_voxel(plane.origin() + plane.v * plane.spacing) - start;
+
+    ResliceParams params;
+    params.voxels = volume.data();
+    params.width = volume.width;
+    params.height = volume.height;
+    params.depth = volume.depth;
+    params.slice_stride = volume.slice_stride;
+    params.start[0] = static_cast<float>(start.x);
+    params.start[1] = static_cast<float>(start.y);
+    params.start[2] = static_cast<float>(start.z);
+    params.step_i[0] = static_cast<float>(step_i.x);
+    params.step_i[1] = static_cast<float>(step_i.y);
+    params.step_i[2] = static_cast<float>(step_i.z);
+    params.step_j[0] = static_cast<float>(step_j.x);
+    params.step_j[1] = static_cast<float>(step_j.y);
+    params.step_j[2] = static_cast<float>(step_j.z);
+    params.out = out;
+    params.out_stride = plane.width;
+
+    // The vector kernel gathers with 32-bit voxel indices
+    const bool use_avx2 = simd_enabled_ && cpu_features().avx2 && cpu_features().fma &&
+        volume.voxel_span() < static_cast<size_t>(std::numeric_limits<int32_t>::max());
+
+    const uint32_t tiles_x = (plane.width + kTileSize - 1) / kTileSize;
+    const uint32_t tiles_y = (plane.height + kTileSize - 1) / kTileSize;
+    pool_.parallel_for(static_cast<size_t>(tiles_x) * tiles_y, [&](size_t begin, size_t end) {
+        for (size_t t = begin; t < end; ++t) {
+            const uint32_t i0 = static_cast<uint32_t>(t % tiles_x) * kTileSize;
+            const uint32_t j0 = static_cast<uint32_t>(t / tiles_x) * kTileSize;
+            const uint32_t i1 = std::min(i0 + kTileSize, plane.width);
+            const uint32_t j1 = std::min(j0 + kTileSize, plane.height);
+            if (!use_avx2 || !reslice_block_avx2(params, i0, i1, j0, j1)) {
+                reslice_block_scalar(params, i0, i1, j0, j1);
+            }
+        }
+    });
+}
+
+DicomImageData MprRenderer::reslice_image(const Volume& volume, const MprPlane& plane) const {
+    DicomImageData image = make_volume_image(plane.width, plane.height, volume);
+    reslice(volume, plane, image.data().pixels.gray16());
+    return image;
+}
+
+void reslice_block_scalar(const ResliceParams& p, uint32_t i0, uint32_t i1, uint32_t j0, uint32_t j1) {
+    const float max_x = static_cast<float>(p.width - 1);
+    const float max_y = static_cast<float>(p.height - 1);
+    const float max_z = static_cast<float>(p.depth - 1);
+    const size_t row = p.width;
+    const size_t slice = p.slice_stride;
+
+    for (uint32_t j = j0; j < j1; ++j) {
+        const float bx = p.start[0] + p.step_j[0] * static_cast<float>(j);
+        const float by = p.start[1] + p.step_j[1] * static_cast<float>(j);
+        const float bz = p.start[2] + p.step_j[2] * static_cast<float>(j);
+        uint16_t* out = p.out + j * p.out_stride;
+
+        for (uint32_t i = i0; i < i1; ++i) {
+            const float fi = static_cast<float>(i);
+            const float x = bx + p.step_i[0] * fi;
+            const float y = by + p.step_i[1] * fi;
+            const float z = bz + p.step_i[2] * fi;
+            if (!(x >= 0 && x <= max_x && y >= 0 && y <= max_y && z >= 0 && z <= max_z)) {
+                out[i] = 0;
+                continue;
+            }
+
+            // Lower corner of the surrounding cell, kept one voxel inside each axis
+            const uint32_t x0 = std::min(static_cast<uint32_t>(x), p.width - 2);
+            const uint32_t y0 = std::min(static_cast<uint32_t>(y), p.height - 2);
+            const uint32_t z0 = std::min(static_cast<uint32_t>(z), p.depth - 2);
+            const float fx = x - x0;
+            const float fy = y - y0;
+            const float fz = z - z0;
+
+            const uint16_t* c = p.voxels + z0 * slice + y0 * row + x0;
+            const float c00 = c[0] + fx * (c[1] - c[0]);
+            const float c10 = c[row] + fx * (c[row + 1] - c[row]);
+            const float c01 = c[slice] + fx * (c[slice + 1] - c[slice]);
+            const float c11 = c[slice + row] + fx * (c[slice + row + 1] - c[slice + row]);
+            const float c0 = c00 + fy * (c10 - c00);
+            const float c1 = c01 + fy * (c11 - c01);
+            out[i] = static_cast<uint16_t>(c0 + fz * (c1 - c0) + 0.5f);
+        }
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "dicom_image.hpp"
+#include "thread_pool.hpp"
+#include "volume.hpp"
+#include <cstdint>
+
+enum class MprOrientation {
+    Axial,
+    Coronal,
+    Sagittal,
+    Oblique
+};
+
+// Output plane in patient space: pixel (i, j) is sampled at
+//   origin() + u * (i * spacing) + v * (j * spacing)
+// with u pointing right and v pointing down on screen.
+struct MprPlane {
+    Vec3 center;
+    Vec3 u{ 1, 0, 0 };
+    Vec3 v{ 0, 1, 0 };
+    double spacing = 1.0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+
+    Vec3 normal() const { return u.cross(v); }
+    Vec3 origin() const;
+};
+
+// Plane through the volume center, moved offset_mm along its normal, sized to
+// cover the whole volume at its finest in-plane spacing. Oblique planes start
+// from axial, tilt about the screen's horizontal axis, then rotate in-plane.
+MprPlane make_mpr_plane(const Volume& volume, MprOrientation orientation, double offset_mm = 0.0,
+    double tilt_degrees = 0.0, double rotation_degrees = 0.0);
+
+// Half the extent of the volume along a plane's normal, i.e. the useful offset range
+double mpr_offset_limit(const Volume& volume, const MprPlane& plane);
+
+// Trilinear reslicing of a volume onto a plane. The output is split into tiles
+// spread over the pool; samples outside the volume are 0. Uses an AVX2 kernel
+// when the CPU has one.
+class MprRenderer {
+    ThreadPool& pool_;
+    bool simd_enabled_;
+
+public:
+    static constexpr uint32_t kTileSize = 64;
+
+    explicit MprRenderer(ThreadPool& pool = ThreadPool::shared());
+
+    // For comparing against the scalar kernel
+    void set_simd_enabled(bool enabled);
+    bool simd_enabled() const { return simd_enabled_; }
+
+    // Writes plane.width * plane.height samples, row-major
+    void reslice(const Volume& volume, const MprPlane& plane, uint16_t* out) const;
+
+    // Reslice as a displayable grayscale image carrying the volume's window
+    DicomImageData reslice_image(const Volume& volume, const MprPlane& plane) const;
+};
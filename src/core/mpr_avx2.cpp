@@ -0,0 +1,100 @@
+// Built with AVX2 and FMA enabled; only reached after a runtime CPU check.
+// Keep this file free of inline library code so no AVX2 instantiation can be
+// shared with (and picked over) the baseline build of the same function.
+#include "mpr_kernels.hpp"
+
+#if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+#include <immintrin.h>
+
+namespace {
+
+// Two neighbouring voxels per 32-bit lane (low and high half), interpolated along x
+inline __m256 lerp_pair(__m256i pair, __m256 fx) {
+    const __m256 lo = _mm256_cvtepi32_ps(_mm256_and_si256(pair, _mm256_set1_epi32(0xFFFF)));
+    const __m256 hi = _mm256_cvtepi32_ps(_mm256_srli_epi32(pair, 16));
+    return _mm256_fmadd_ps(fx, _mm256_sub_ps(hi, lo), lo);
+}
+
+} // namespace
+
+bool reslice_block_avx2(const ResliceParams& p, uint32_t i0, uint32_t i1, uint32_t j0, uint32_t j1) {
+    const __m256 lane = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 max_x = _mm256_set1_ps(static_cast<float>(p.width - 1));
+    const __m256 max_y = _mm256_set1_ps(static_cast<float>(p.height - 1));
+    const __m256 max_z = _mm256_set1_ps(static_cast<float>(p.depth - 1));
+    const __m256 cell_x = _mm256_set1_ps(static_cast<float>(p.width - 2));
+    const __m256 cell_y = _mm256_set1_ps(static_cast<float>(p.height - 2));
+    const __m256 cell_z = _mm256_set1_ps(static_cast<float>(p.depth - 2));
+    const __m256i row = _mm256_set1_epi32(static_cast<int>(p.width));
+    const __m256i slice = _mm256_set1_epi32(static_cast<int>(p.slice_stride));
+    const __m256 step_x = _mm256_set1_ps(p.step_i[0]);
+    const __m256 step_y = _mm256_set1_ps(p.step_i[1]);
+    const __m256 step_z = _mm256_set1_ps(p.step_i[2]);
+    const int* base = reinterpret_cast<const int*>(p.voxels);
+
+    for (uint32_t j = j0; j < j1; ++j) {
+        const __m256 bx = _mm256_set1_ps(p.start[0] + p.step_j[0] * static_cast<float>(j));
+        const __m256 by = _mm256_set1_ps(p.start[1] + p.step_j[1] * static_cast<float>(j));
+        const __m256 bz = _mm256_set1_ps(p.start[2] + p.step_j[2] * static_cast<float>(j));
+        uint16_t* out = p.out + j * p.out_stride;
+
+        uint32_t i = i0;
+        for (; i + 8 <= i1; i += 8) {
+            const __m256 fi = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(i)), lane);
+            const __m256 x = _mm256_fmadd_ps(fi, step_x, bx);
+            const __m256 y = _mm256_fmadd_ps(fi, step_y, by);
+            const __m256 z = _mm256_fmadd_ps(fi, step_z, bz);
+
+            __m256 inside = _mm256_and_ps(_mm256_cmp_ps(x, zero, _CMP_GE_OQ), _mm256_cmp_ps(x, max_x, _CMP_LE_OQ));
+            inside = _mm256_and_ps(inside, _mm256_and_ps(_mm256_cmp_ps(y, zero, _CMP_GE_OQ), _mm256_cmp_ps(y, max_y, _CMP_LE_OQ)));
+            inside = _mm256_and_ps(inside, _mm256_and_ps(_mm256_cmp_ps(z, zero, _CMP_GE_OQ), _mm256_cmp_ps(z, max_z, _CMP_LE_OQ)));
+
+            // Clamp every lane into the volume so the gathers stay in bounds;
+            // outside lanes are masked to 0 afterwards
+            const __m256 xc = _mm256_min_ps(_mm256_max_ps(x, zero), max_x);
+            const __m256 yc = _mm256_min_ps(_mm256_max_ps(y, zero), max_y);
+            const __m256 zc = _mm256_min_ps(_mm256_max_ps(z, zero), max_z);
+            const __m256 x0 = _mm256_min_ps(_mm256_floor_ps(xc), cell_x);
+            const __m256 y0 = _mm256_min_ps(_mm256_floor_ps(yc), cell_y);
+            const __m256 z0 = _mm256_min_ps(_mm256_floor_ps(zc), cell_z);
+            const __m256 fx = _mm256_sub_ps(xc, x0);
+            const __m256 fy = _mm256_sub_ps(yc, y0);
+            const __m256 fz = _mm256_sub_ps(zc, z0);
+
+            const __m256i index = _mm256_add_epi32(
+                _mm256_add_epi32(_mm256_mullo_epi32(_mm256_cvttps_epi32(z0), slice),
+                                 _mm256_mullo_epi32(_mm256_cvttps_epi32(y0), row)),
+                _mm256_cvttps_epi32(x0));
+
+            // A 32-bit gather at a 16-bit index fetches the voxel and its x neighbour
+            const __m256 c00 = lerp_pair(_mm256_i32gather_epi32(base, index, 2), fx);
+            const __m256 c10 = lerp_pair(_mm256_i32gather_epi32(base, _mm256_add_epi32(index, row), 2), fx);
+            const __m256i index_z = _mm256_add_epi32(index, slice);
+            const __m256 c01 = lerp_pair(_mm256_i32gather_epi32(base, index_z, 2), fx);
+            const __m256 c11 = lerp_pair(_mm256_i32gather_epi32(base, _mm256_add_epi32(index_z, row), 2), fx);
+
+            const __m256 c0 = _mm256_fmadd_ps(fy, _mm256_sub_ps(c10, c00), c00);
+            const __m256 c1 = _mm256_fmadd_ps(fy, _mm256_sub_ps(c11, c01), c01);
+            const __m256 value = _mm256_and_ps(_mm256_add_ps(_mm256_fmadd_ps(fz, _mm256_sub_ps(c1, c0), c0), half), inside);
+
+            // 8 x int32 -> 8 x uint16: pack within each 128-bit half, then join the halves
+            const __m256i packed = _mm256_packus_epi32(_mm256_cvttps_epi32(value), _mm256_setzero_si256());
+            const __m256i joined = _mm256_permute4x64_epi64(packed, 0x08);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm256_castsi256_si128(joined));
+        }
+        if (i < i1) {
+            reslice_block_scalar(p, i, i1, j, j + 1);
+        }
+    }
+    return true;
+}
+
+#else
+
+bool reslice_block_avx2(const ResliceParams&, uint32_t, uint32_t, uint32_t, uint32_t) {
+    return false;
+}
+
+#endif
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Internal to the MPR renderer. Output pixel (i, j) samples the volume at
+// voxel coordinate start + step_i * i + step_j * j.
+struct ResliceParams {
+    const uint16_t* voxels = nullptr;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t depth = 0;
+    size_t slice_stride = 0;   // samples
+    float start[3] = {};
+    float step_i[3] = {};
+    float step_j[3] = {};
+    uint16_t* out = nullptr;
+    size_t out_stride = 0;
+};
+
+// Fill output columns [i0, i1) of rows [j0, j1). Volumes must be at least 2
+// voxels along every axis.
+void reslice_block_scalar(const ResliceParams& params, uint32_t i0, uint32_t i1, uint32_t j0, uint32_t j1);
+
+// Same with 8 pixels per step; returns false when the build has no AVX2 kernel
+bool reslice_block_avx2(const ResliceParams& params, uint32_t i0, uint32_t i1, uint32_t j0, uint32_t j1);
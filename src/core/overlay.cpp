@@ -0,0 +1,73 @@
+#include "overlay.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+uint64_t load_word(const uint8_t* p) {
+    uint64_t word;
+    std::memcpy(&word, p, sizeof(word));
+    return word;
+}
+
+} // namespace
+
+void OverlayPlane::add_frame(const uint8_t* mask) {
+    for (uint32_t y = 0; y < height; ++y) {
+        const uint8_t* row = mask + static_cast<size_t>(y) * width;
+        uint32_t x = 0;
+        while (x < width) {
+            // Empty and full stretches are skipped eight pixels at a time
+            while (x + 8 <= width && load_word(row + x) == 0) x += 8;
+            while (x < width && !row[x]) ++x;
+            if (x == width) break;
+            const uint32_t begin = x;
+            while (x + 8 <= width && load_word(row + x) == ~uint64_t{ 0 }) x += 8;
+            while (x < width && row[x]) ++x;
+            runs.push_back({ static_cast<uint16_t>(y), static_cast<uint16_t>(begin),
+                             static_cast<uint16_t>(x - begin) });
+        }
+    }
+    frame_runs.push_back(static_cast<uint32_t>(runs.size()));
+}
+
+int64_t OverlayPlane::frame_for(uint32_t image_frame) const {
+    if (frame_count() == 0) return -1;
+    if (every_frame) return 0;
+    if (image_frame < first_frame || image_frame - first_frame >= frame_count()) return -1;
+    return image_frame - first_frame;
+}
+
+void composite_overlays(const OverlayPlanes& planes, const std::vector<bool>& visible, uint32_t image_frame,
+    uint8_t* display, uint32_t width, uint32_t row_begin, uint32_t row_end) {
+    for (size_t p = 0; p < planes.size() && p < visible.size(); ++p) {
+        const OverlayPlane& plane = planes[p];
+        const int64_t frame = visible[p] ? plane.frame_for(image_frame) : -1;
+        if (frame < 0) continue;
+
+        // Runs of the overlay rows that fall inside the band
+        const auto first = plane.runs.begin() + plane.frame_runs[frame];
+        const auto last = plane.runs.begin() + plane.frame_runs[frame + 1];
+        const int64_t row_first = int64_t{ row_begin } - plane.row_origin;
+        const int64_t row_last = int64_t{ row_end } - plane.row_origin;
+        auto run = std::lower_bound(first, last, row_first,
+            [](const OverlayRun& r, int64_t row) { return r.row < row; });
+        for (; run != last && run->row < row_last; ++run) {
+            const int64_t x_begin = std::max<int64_t>(0, int64_t{ plane.column_origin } + run->column);
+            const int64_t x_end = std::min<int64_t>(width, int64_t{ plane.column_origin } + run->column + run->length);
+            if (x_begin >= x_end) continue;
+            const size_t y = static_cast<size_t>(run->row + plane.row_origin);
+            std::memset(display + y * width + static_cast<size_t>(x_begin), 255,
+                static_cast<size_t>(x_end - x_begin));
+        }
+    }
+}
+
+size_t overlay_memory_bytes(const OverlayPlanes& planes) {
+    size_t bytes = planes.capacity() * sizeof(OverlayPlane);
+    for (const OverlayPlane& plane : planes) {
+        bytes += plane.runs.capacity() * sizeof(OverlayRun) + plane.frame_runs.capacity() * sizeof(uint32_t) +
+            plane.label.capacity();
+    }
+    return bytes;
+}
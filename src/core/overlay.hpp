@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Set pixels [column, column + length) of one overlay row
+struct OverlayRun {
+    uint16_t row;
+    uint16_t column;
+    uint16_t length;
+};
+
+// One overlay plane (repeating group 60xx) of an image, unpacked at load
+// and kept as runs of set pixels: overlays are sparse graphics and text,
+// so drawing one is a few short fills rather than a pass over the frame
+struct OverlayPlane {
+    uint16_t group = 0x6000;
+    std::string label;                // Overlay Label, else Overlay Description
+    bool roi = false;                 // Overlay Type R; graphics (G) otherwise
+    bool embedded = false;            // taken from unused high bits of the pixel data
+
+    // Image pixel of the overlay's first pixel (Overlay Origin - 1), may be negative
+    int32_t row_origin = 0;
+    int32_t column_origin = 0;
+    uint32_t width = 0;               // Overlay Columns
+    uint32_t height = 0;              // Overlay Rows
+
+    // Image frames from first_frame on have a frame of the overlay each; a
+    // plane without Number of Frames in Overlay is shown on every frame
+    uint32_t first_frame = 0;
+    bool every_frame = false;
+
+    // Runs of every overlay frame, sorted by row then column; frame f has
+    // runs [frame_runs[f], frame_runs[f + 1])
+    std::vector<OverlayRun> runs;
+    std::vector<uint32_t> frame_runs{ 0 };
+
+    size_t frame_pixels() const { return static_cast<size_t>(width) * height; }
+    uint32_t frame_count() const { return static_cast<uint32_t>(frame_runs.size() - 1); }
+
+    // Appends the next overlay frame from height x width bytes, set where non-zero
+    void add_frame(const uint8_t* mask);
+
+    // Index of the overlay frame shown on an image frame, -1 if none
+    int64_t frame_for(uint32_t image_frame) const;
+};
+
+using OverlayPlanes = std::vector<OverlayPlane>;
+
+// Turns the pixels that a visible overlay (one flag per plane) covers on
+// an image frame white, in rows [row_begin, row_end) of a Gray8 display
+// buffer width pixels wide. Meant to run on each band right after it is
+// windowed, while its rows are still in cache, rather than as a pass of
+// its own over the whole frame.
+void composite_overlays(const OverlayPlanes& planes, const std::vector<bool>& visible, uint32_t image_frame,
+    uint8_t* display, uint32_t width, uint32_t row_begin, uint32_t row_end);
+
+size_t overlay_memory_bytes(const OverlayPlanes& planes);
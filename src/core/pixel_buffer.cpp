@@ -0,0 +1,99 @@
+#include "pixel_buffer.hpp"
+#include <cstring>
+#include <utility>
+
+PixelBuffer PixelBuffer::allocate(PixelFormat format, size_t pixel_count) {
+    PixelBuffer buffer;
+    buffer.format_ = format;
+    buffer.pixel_count_ = pixel_count;
+    buffer.storage_ = BufferPool::shared().acquire(buffer.size_bytes());
+    return buffer;
+}
+
+PixelBuffer PixelBuffer::wrap(PixelFormat format, size_t pixel_count,
+    std::shared_ptr<const void> owner, const void* data) {
+    PixelBuffer buffer;
+    buffer.format_ = format;
+    buffer.pixel_count_ = pixel_count;
+    buffer.shared_owner_ = std::move(owner);
+    buffer.shared_data_ = data;
+    return buffer;
+}
+
+PixelBuffer::PixelBuffer(PixelBuffer&& other) noexcept
+    : storage_(std::move(other.storage_))
+    , shared_owner_(std::move(other.shared_owner_))
+    , shared_data_(std::exchange(other.shared_data_, nullptr))
+    , pixel_count_(std::exchange(other.pixel_count_, 0))
+    , format_(std::exchange(other.format_, PixelFormat::None)) {
+}
+
+PixelBuffer& PixelBuffer::operator=(PixelBuffer&& other) noexcept {
+    if (this != &other) {
+        storage_ = std::move(other.storage_);
+        shared_owner_ = std::move(other.shared_owner_);
+        shared_data_ = std::exchange(other.shared_data_, nullptr);
+        pixel_count_ = std::exchange(other.pixel_count_, 0);
+        format_ = std::exchange(other.format_, PixelFormat::None);
+    }
+    return *this;
+}
+
+PixelBuffer PixelBuffer::clone() const {
+    PixelBuffer copy = allocate(format_, pixel_count_);
+    if (size_bytes() > 0) {
+        std::memcpy(copy.storage_.data(), bytes(), size_bytes());
+    }
+    return copy;
+}
+
+void PixelBuffer::reset() {
+    storage_.reset();
+    shared_owner_.reset();
+    shared_data_ = nullptr;
+    pixel_count_ = 0;
+    format_ = PixelFormat::None;
+}
+
+uint16_t* PixelBuffer::gray16() {
+    return format_ == PixelFormat::Gray16 ? static_cast<uint16_t*>(writable_bytes()) : nullptr;
+}
+
+const uint16_t* PixelBuffer::gray16() const {
+    return format_ == PixelFormat::Gray16 ? static_cast<const uint16_t*>(bytes()) : nullptr;
+}
+
+uint8_t* PixelBuffer::gray8() {
+    return format_ == PixelFormat::Gray8 ? static_cast<uint8_t*>(writable_bytes()) : nullptr;
+}
+
+const uint8_t* PixelBuffer::gray8() const {
+    return format_ == PixelFormat::Gray8 ? static_cast<const uint8_t*>(bytes()) : nullptr;
+}
+
+uint8_t* PixelBuffer::rgb8() {
+    return format_ == PixelFormat::Rgb8 ? static_cast<uint8_t*>(writable_bytes()) : nullptr;
+}
+
+const uint8_t* PixelBuffer::rgb8() const {
+    return format_ == PixelFormat::Rgb8 ? static_cast<const uint8_t*>(bytes()) : nullptr;
+}
+
+void* PixelBuffer::writable_bytes() {
+    if (shared_data_) {
+        PixelBuffer copy = clone();
+        storage_ = std::move(copy.storage_);
+        shared_owner_.reset();
+        shared_data_ = nullptr;
+    }
+    return storage_.data();
+}
+
+size_t PixelBuffer::bytes_per_pixel(PixelFormat format) {
+    switch (format) {
+        case PixelFormat::Gray16: return sizeof(uint16_t);
+        case PixelFormat::Gray8: return 1;
+        case PixelFormat::Rgb8: return 3;
+        default: return 0;
+    }
+}
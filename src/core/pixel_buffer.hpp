@@ -0,0 +1,68 @@
+#pragma once
+
+#include "buffer_pool.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Sample layout of a PixelBuffer
+enum class PixelFormat {
+    None,
+    Gray16,   // one normalized uint16 sample per pixel
+    Gray8,    // windowed 8-bit display samples
+    Rgb8      // interleaved 8-bit R, G, B
+};
+
+// The single owning pixel store of an image. Move-only so that full-image
+// copies cannot happen by accident; use clone() where one is really needed.
+// Storage comes from BufferPool::shared() and returns there when released,
+// or is read-only memory owned elsewhere (such as a mapped cache file) that
+// the buffer keeps alive; the first writable view copies that into the pool.
+class PixelBuffer {
+    PooledBlock storage_;
+    std::shared_ptr<const void> shared_owner_;
+    const void* shared_data_ = nullptr;
+    size_t pixel_count_ = 0;
+    PixelFormat format_ = PixelFormat::None;
+
+public:
+    PixelBuffer() = default;
+
+    // Storage is left uninitialized; the decoder writes every sample
+    static PixelBuffer allocate(PixelFormat format, size_t pixel_count);
+
+    // Read-only view of data, which stays valid as long as owner lives
+    static PixelBuffer wrap(PixelFormat format, size_t pixel_count,
+        std::shared_ptr<const void> owner, const void* data);
+
+    PixelBuffer(const PixelBuffer&) = delete;
+    PixelBuffer& operator=(const PixelBuffer&) = delete;
+    PixelBuffer(PixelBuffer&& other) noexcept;
+    PixelBuffer& operator=(PixelBuffer&& other) noexcept;
+
+    PixelBuffer clone() const;
+
+    // Releases the storage
+    void reset();
+
+    PixelFormat format() const { return format_; }
+    size_t pixel_count() const { return pixel_count_; }
+    size_t size_bytes() const { return pixel_count_ * bytes_per_pixel(format_); }
+    bool empty() const { return pixel_count_ == 0; }
+    bool is_shared() const { return shared_data_ != nullptr; }
+
+    // Typed views, nullptr if the buffer holds another format. The writable
+    // ones copy shared storage into a pooled block first.
+    uint16_t* gray16();
+    const uint16_t* gray16() const;
+    uint8_t* gray8();
+    const uint8_t* gray8() const;
+    uint8_t* rgb8();
+    const uint8_t* rgb8() const;
+
+    static size_t bytes_per_pixel(PixelFormat format);
+
+private:
+    const void* bytes() const { return shared_data_ ? shared_data_ : storage_.data(); }
+    void* writable_bytes();
+};
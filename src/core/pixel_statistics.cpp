@@ -0,0 +1,26 @@
+#include "pixel_statistics.hpp"
+#include <algorithm>
+
+PixelStatistics compute_pixel_statistics(const uint16_t* pixels, size_t count) {
+    PixelStatistics stats;
+    stats.histogram.assign(PixelStatistics::kHistogramBins, 0);
+
+    if (count == 0) {
+        return stats;
+    }
+
+    auto [min_it, max_it] = std::minmax_element(pixels, pixels + count);
+    stats.min_value = *min_it;
+    stats.max_value = *max_it;
+
+    const double bin_size = stats.bin_size();
+    const size_t last_bin = PixelStatistics::kHistogramBins - 1;
+
+    for (size_t i = 0; i < count; ++i) {
+        size_t bin = static_cast<size_t>((pixels[i] - stats.min_value) / bin_size);
+        if (bin > last_bin) bin = last_bin;
+        stats.histogram[bin]++;
+    }
+
+    return stats;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+struct PixelStatistics {
+    static constexpr size_t kHistogramBins = 4096;
+
+    uint16_t min_value;
+    uint16_t max_value;
+
+    // kHistogramBins equally sized bins spanning [min_value, max_value]
+    std::vector<uint32_t> histogram;
+
+    PixelStatistics() : min_value(0), max_value(0) {}
+
+    double bin_size() const {
+        return static_cast<double>(max_value - min_value + 1) /
+            static_cast<double>(kHistogramBins);
+    }
+};
+
+// Single pass min/max followed by a single histogram pass
+PixelStatistics compute_pixel_statistics(const uint16_t* pixels, size_t count);
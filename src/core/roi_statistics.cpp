@@ -0,0 +1,372 @@
+#include "roi_statistics.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+std::vector<RowSpan> ellipse_spans(double center_x, double center_y, double radius_x, double radius_y,
+    uint32_t width, uint32_t height) {
+    std::vector<RowSpan> spans;
+    if (radius_x <= 0 || radius_y <= 0 || width == 0 || height == 0) {
+        return spans;
+    }
+
+    const double top = std::max(0.0, std::ceil(center_y - radius_y - 0.5));
+    const double bottom = std::min(static_cast<double>(height), std::floor(center_y + radius_y - 0.5) + 1.0);
+    for (double row = top; row < bottom; row += 1.0) {
+        // Half the chord through the pixel centers of this row
+        const double dy = (row + 0.5 - center_y) / radius_y;
+        if (dy * dy > 1.0) {
+            continue;
+        }
+        const double half = radius_x * std::sqrt(1.0 - dy * dy);
+        const double left = std::max(0.0, std::ceil(center_x - half - 0.5));
+        const double right = std::min(static_cast<double>(width), std::floor(center_x + half - 0.5) + 1.0);
+        if (left < right) {
+            spans.push_back({ static_cast<uint32_t>(row), static_cast<uint32_t>(left), static_cast<uint32_t>(right) });
+        }
+    }
+    return spans;
+}
+
+std::vector<RowSpan> polygon_spans(const std::vector<std::array<double, 2>>& vertices,
+    uint32_t width, uint32_t height) {
+    std::vector<RowSpan> spans;
+    if (vertices.size() < 3 || width == 0 || height == 0) {
+        return spans;
+    }
+
+    // Edge table: each edge with the rows whose pixel centers it may cross,
+    // sorted by first row, so a row only tests the edges active on it
+    struct Edge {
+        double first_row;
+        double end_row;
+        size_t index;
+    };
+    std::vector<Edge> edges;
+    edges.reserve(vertices.size());
+    double min_y = vertices[0][1], max_y = vertices[0][1];
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        const double a = vertices[i][1];
+        const double b = vertices[(i + 1) % vertices.size()][1];
+        min_y = std::min(min_y, a);
+        max_y = std::max(max_y, a);
+        if (a == b) continue;
+        // A row longer on each side; the exact test below decides
+        edges.push_back({ std::floor(std::min(a, b) - 0.5), std::ceil(std::max(a, b) - 0.5) + 1.0, i });
+    }
+    std::sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b) { return a.first_row < b.first_row; });
+    const double top = std::max(0.0, std::ceil(min_y - 0.5));
+    const double bottom = std::min(static_cast<double>(height), std::ceil(max_y - 0.5));
+
+    std::vector<const Edge*> active;
+    std::vector<double> crossings;
+    size_t next = 0;
+    for (double row = top; row < bottom; row += 1.0) {
+        while (next < edges.size() && edges[next].first_row <= row) {
+            active.push_back(&edges[next++]);
+        }
+        active.erase(std::remove_if(active.begin(), active.end(),
+            [row](const Edge* edge) { return edge->end_row <= row; }), active.end());
+
+        // Edges crossing the line through this row's pixel centers, each
+        // counted once by treating the lower end as inside and the upper as outside
+        const double y = row + 0.5;
+        crossings.clear();
+        for (const Edge* edge : active) {
+            const auto& a = vertices[edge->index];
+            const auto& b = vertices[(edge->index + 1) % vertices.size()];
+            if ((a[1] <= y && y < b[1]) || (b[1] <= y && y < a[1])) {
+                crossings.push_back(a[0] + (y - a[1]) * (b[0] - a[0]) / (b[1] - a[1]));
+            }
+        }
+        std::sort(crossings.begin(), crossings.end());
+
+        for (size_t i = 0; i + 1 < crossings.size(); i += 2) {
+            const double left = std::max(0.0, std::ceil(crossings[i] - 0.5));
+            const double right = std::min(static_cast<double>(width), std::ceil(crossings[i + 1] - 0.5));
+            if (left < right) {
+                spans.push_back({ static_cast<uint32_t>(row), static_cast<uint32_t>(left), static_cast<uint32_t>(right) });
+            }
+        }
+    }
+    return spans;
+}
+
+namespace {
+
+// Packing of the in-tile sums: the sum in the low bits, the squares above
+constexpr uint32_t kSumBits = 24;
+constexpr uint64_t kSumMask = (uint64_t{ 1 } << kSumBits) - 1;
+constexpr uint64_t kTilePixels = uint64_t{ SummedAreaTable::kTileSize - 1 } * (SummedAreaTable::kTileSize - 1);
+static_assert(kTilePixels * UINT16_MAX <= kSumMask, "in-tile sums must fit their bits");
+static_assert(kTilePixels * UINT16_MAX * UINT16_MAX < (uint64_t{ 1 } << (64 - kSumBits)),
+    "in-tile squares must fit their bits");
+
+uint64_t pack_in_tile(uint64_t sum, uint64_t squares) {
+    return sum | (squares << kSumBits);
+}
+
+} // namespace
+
+SummedAreaTable SummedAreaTable::build(const DicomImageData& image, ThreadPool& pool) {
+    SummedAreaTable table;
+    const ImageData& data = image.data();
+    const uint16_t* pixels = data.pixels.gray16();
+    if (!pixels || data.tiles || data.width == 0 || data.height == 0) {
+        return table;
+    }
+
+    const uint32_t width = data.width;
+    const uint32_t height = data.height;
+    const size_t stride = static_cast<size_t>(width) + 1;
+    const size_t tile_columns = width / kTileSize + 1;
+    const size_t tile_rows = height / kTileSize + 1;
+    table.width_ = width;
+    table.height_ = height;
+    table.chunks_per_row_ = (width + kChunkSamples - 1) / kChunkSamples;
+    table.levels_ = static_cast<uint32_t>(std::bit_width(table.chunks_per_row_));
+    table.modality_ = data.modality;
+    table.samples_ = pixels;
+    table.tile_columns_.resize(tile_columns * (height + 1));
+    table.tile_rows_.resize(tile_rows * stride);
+    table.in_tile_.resize(stride * (height + 1));
+    const size_t level_size = static_cast<size_t>(height) * table.chunks_per_row_;
+    table.chunk_min_.resize(level_size * table.levels_);
+    table.chunk_max_.resize(level_size * table.levels_);
+
+    // Bands of tile rows are independent. Walking each row's prefix sums,
+    // a band fills its in-tile sums, its part of the tile column totals and
+    // its own totals on the tile row below it, and the chunk extremes.
+    pool.parallel_for(tile_rows, [&](size_t begin, size_t end) {
+        for (size_t band = begin; band < end; ++band) {
+            const size_t first_row = band * kTileSize;
+            const size_t end_row = std::min<size_t>(first_row + kTileSize, height);
+            Totals* band_totals = band + 1 < tile_rows ? table.tile_rows_.data() + (band + 1) * stride : nullptr;
+
+            for (size_t y = first_row; y < end_row; ++y) {
+                const uint16_t* row = pixels + y * width;
+                // Point row y + 1 opens the next band, where the in-tile sums restart
+                const bool in_band = y + 1 - first_row < kTileSize;
+                const uint64_t* in_tile_above = table.in_tile_.data() + y * stride;
+                uint64_t* in_tile = table.in_tile_.data() + (y + 1) * stride;
+                const Totals* columns_above = table.tile_columns_.data() + y * tile_columns;
+                Totals* columns = table.tile_columns_.data() + (y + 1) * tile_columns;
+
+                uint64_t sum = 0, square_sum = 0;
+                uint64_t tile_sum = 0, tile_square_sum = 0;
+                for (uint32_t x = 0; x <= width; ++x) {
+                    if (x % kTileSize == 0) {
+                        tile_sum = sum;
+                        tile_square_sum = square_sum;
+                        if (in_band) {
+                            const Totals& above = columns_above[x / kTileSize];
+                            columns[x / kTileSize] = { above.sum + sum, above.squares + square_sum };
+                        }
+                    }
+                    if (in_band) {
+                        in_tile[x] = in_tile_above[x] + pack_in_tile(sum - tile_sum, square_sum - tile_square_sum);
+                    }
+                    if (band_totals) {
+                        band_totals[x].sum += sum;
+                        band_totals[x].squares += square_sum;
+                    }
+                    if (x < width) {
+                        const uint64_t value = row[x];
+                        sum += value;
+                        square_sum += value * value;
+                    }
+                }
+
+                uint16_t* chunk_min = table.chunk_min_.data() + y * table.chunks_per_row_;
+                uint16_t* chunk_max = table.chunk_max_.data() + y * table.chunks_per_row_;
+                for (uint32_t c = 0; c < table.chunks_per_row_; ++c) {
+                    const uint16_t* first = row + c * kChunkSamples;
+                    const uint16_t* last = row + std::min(width, (c + 1) * kChunkSamples);
+                    const auto [lo, hi] = std::minmax_element(first, last);
+                    chunk_min[c] = *lo;
+                    chunk_max[c] = *hi;
+                }
+                for (uint32_t level = 1; level < table.levels_; ++level) {
+                    const size_t half = size_t{ 1 } << (level - 1);
+                    const uint16_t* min_below = chunk_min;
+                    const uint16_t* max_below = chunk_max;
+                    chunk_min += level_size;
+                    chunk_max += level_size;
+                    for (size_t c = 0; c + 2 * half <= table.chunks_per_row_; ++c) {
+                        chunk_min[c] = std::min(min_below[c], min_below[c + half]);
+                        chunk_max[c] = std::max(max_below[c], max_below[c + half]);
+                    }
+                }
+            }
+        }
+    });
+
+    // Band totals accumulate down the tile rows, each worker taking a band
+    // of columns so reads and writes stay sequential within it
+    pool.parallel_for(stride, [&](size_t begin, size_t end) {
+        for (size_t band = 2; band < tile_rows; ++band) {
+            Totals* totals = table.tile_rows_.data() + band * stride;
+            const Totals* totals_above = totals - stride;
+            for (size_t x = begin; x < end; ++x) {
+                totals[x].sum += totals_above[x].sum;
+                totals[x].squares += totals_above[x].squares;
+            }
+        }
+    });
+
+    // Tile column totals so far start at their band; add everything above it
+    pool.parallel_for(static_cast<size_t>(height) + 1, [&](size_t begin, size_t end) {
+        for (size_t y = begin; y < end; ++y) {
+            Totals* columns = table.tile_columns_.data() + y * tile_columns;
+            const Totals* above = table.tile_rows_.data() + (y / kTileSize) * stride;
+            for (size_t column = 0; column < tile_columns; ++column) {
+                columns[column].sum += above[column * kTileSize].sum;
+                columns[column].squares += above[column * kTileSize].squares;
+            }
+        }
+    });
+
+    return table;
+}
+
+size_t SummedAreaTable::memory_bytes() const {
+    return (tile_columns_.size() + tile_rows_.size()) * sizeof(Totals) + in_tile_.size() * sizeof(uint64_t) +
+        (chunk_min_.size() + chunk_max_.size()) * sizeof(uint16_t);
+}
+
+SummedAreaTable::Totals SummedAreaTable::totals(uint32_t x, uint32_t y) const {
+    // [0, 16 X) x [0, y), plus [16 X, x) x [0, 16 Y), plus the tile's own part
+    const size_t stride = static_cast<size_t>(width_) + 1;
+    const size_t tile_x = x / kTileSize;
+    const size_t tile_y = y / kTileSize;
+    const Totals& column = tile_columns_[y * (width_ / kTileSize + 1) + tile_x];
+    const Totals& row = tile_rows_[tile_y * stride + x];
+    const Totals& corner = tile_rows_[tile_y * stride + tile_x * kTileSize];
+    const uint64_t in_tile = in_tile_[y * stride + x];
+    return { column.sum + row.sum - corner.sum + (in_tile & kSumMask),
+             column.squares + row.squares - corner.squares + (in_tile >> kSumBits) };
+}
+
+void SummedAreaTable::add_block(uint32_t x_begin, uint32_t y_begin, uint32_t x_end, uint32_t y_end,
+    Accumulator& acc) const {
+    const Totals top_left = totals(x_begin, y_begin);
+    const Totals top_right = totals(x_end, y_begin);
+    const Totals bottom_left = totals(x_begin, y_end);
+    const Totals bottom_right = totals(x_end, y_end);
+    acc.count += static_cast<uint64_t>(x_end - x_begin) * (y_end - y_begin);
+    acc.sum += bottom_right.sum - top_right.sum - bottom_left.sum + top_left.sum;
+    acc.squares += bottom_right.squares - top_right.squares - bottom_left.squares + top_left.squares;
+}
+
+void SummedAreaTable::add_row_extremes(uint32_t y, uint32_t x_begin, uint32_t x_end, Accumulator& acc) const {
+    const uint16_t* row = samples_ + static_cast<size_t>(y) * width_;
+    uint16_t lo = acc.min, hi = acc.max;
+    auto scan = [&](uint32_t from, uint32_t to) {
+        for (uint32_t x = from; x < to; ++x) {
+            lo = std::min(lo, row[x]);
+            hi = std::max(hi, row[x]);
+        }
+    };
+
+    const uint32_t first_chunk = (x_begin + kChunkSamples - 1) / kChunkSamples;
+    const uint32_t end_chunk = x_end / kChunkSamples;
+    if (first_chunk >= end_chunk) {
+        scan(x_begin, x_end);
+    }
+    else {
+        scan(x_begin, first_chunk * kChunkSamples);
+        // Two overlapping power-of-two runs cover the whole chunks
+        const uint32_t level = static_cast<uint32_t>(std::bit_width(end_chunk - first_chunk)) - 1;
+        const size_t offset = (static_cast<size_t>(level) * height_ + y) * chunks_per_row_;
+        const uint32_t second = end_chunk - (1u << level);
+        lo = std::min({ lo, chunk_min_[offset + first_chunk], chunk_min_[offset + second] });
+        hi = std::max({ hi, chunk_max_[offset + first_chunk], chunk_max_[offset + second] });
+        scan(end_chunk * kChunkSamples, x_end);
+    }
+    acc.min = lo;
+    acc.max = hi;
+}
+
+RoiStatistics SummedAreaTable::finish(const Accumulator& acc) const {
+    RoiStatistics stats;
+    if (acc.count == 0) {
+        return stats;
+    }
+    const double n = static_cast<double>(acc.count);
+    const double mean = static_cast<double>(acc.sum) / n;
+    const double variance = std::max(0.0, static_cast<double>(acc.squares) / n - mean * mean);
+
+    stats.pixels = acc.count;
+    stats.mean = modality_.to_modality(mean);
+    stats.std_dev = std::sqrt(variance) * std::abs(modality_.slope);
+    const double a = modality_.to_modality(acc.min);
+    const double b = modality_.to_modality(acc.max);
+    stats.min = std::min(a, b);
+    stats.max = std::max(a, b);
+    return stats;
+}
+
+RoiStatistics SummedAreaTable::rectangle(uint32_t x_begin, uint32_t y_begin, uint32_t x_end, uint32_t y_end) const {
+    x_end = std::min(x_end, width_);
+    y_end = std::min(y_end, height_);
+    Accumulator acc;
+    if (x_begin >= x_end || y_begin >= y_end) {
+        return finish(acc);
+    }
+
+    add_block(x_begin, y_begin, x_end, y_end, acc);
+    for (uint32_t y = y_begin; y < y_end; ++y) {
+        add_row_extremes(y, x_begin, x_end, acc);
+    }
+    return finish(acc);
+}
+
+RoiStatistics SummedAreaTable::spans(const std::vector<RowSpan>& spans) const {
+    Accumulator acc;
+    for (const RowSpan& span : spans) {
+        if (span.y >= height_ || span.x_begin >= span.x_end || span.x_end > width_) {
+            continue;
+        }
+        add_block(span.x_begin, span.y, span.x_end, span.y + 1, acc);
+        add_row_extremes(span.y, span.x_begin, span.x_end, acc);
+    }
+    return finish(acc);
+}
+
+RoiStatistics scan_roi_statistics(const DicomImageData& image, const std::vector<RowSpan>& spans) {
+    const ImageData& data = image.data();
+    const uint16_t* pixels = data.pixels.gray16();
+    RoiStatistics stats;
+    if (!pixels) {
+        return stats;
+    }
+
+    uint64_t count = 0;
+    double sum = 0.0, squares = 0.0;
+    uint16_t lo = UINT16_MAX, hi = 0;
+    for (const RowSpan& span : spans) {
+        const uint16_t* row = pixels + static_cast<size_t>(span.y) * data.width;
+        for (uint32_t x = span.x_begin; x < span.x_end; ++x) {
+            const double value = row[x];
+            sum += value;
+            squares += value * value;
+            lo = std::min(lo, row[x]);
+            hi = std::max(hi, row[x]);
+        }
+        count += span.x_end - span.x_begin;
+    }
+    if (count == 0) {
+        return stats;
+    }
+
+    const double mean = sum / static_cast<double>(count);
+    stats.pixels = count;
+    stats.mean = data.modality.to_modality(mean);
+    stats.std_dev = std::sqrt(std::max(0.0, squares / static_cast<double>(count) - mean * mean)) *
+        std::abs(data.modality.slope);
+    const double a = data.modality.to_modality(lo);
+    const double b = data.modality.to_modality(hi);
+    stats.min = std::min(a, b);
+    stats.max = std::max(a, b);
+    return stats;
+}
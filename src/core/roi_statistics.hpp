@@ -0,0 +1,122 @@
+#pragma once
+
+#include "dicom_image.hpp"
+#include "thread_pool.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Pixels [x_begin, x_end) of row y
+struct RowSpan {
+    uint32_t y;
+    uint32_t x_begin;
+    uint32_t x_end;
+};
+
+// The pixels whose centers lie inside the ellipse, one span per row,
+// clipped to a width x height image. Coordinates are in pixels, with
+// pixel (x, y) covering [x, x + 1) x [y, y + 1).
+std::vector<RowSpan> ellipse_spans(double center_x, double center_y, double radius_x, double radius_y,
+    uint32_t width, uint32_t height);
+
+// The pixels whose centers lie inside the polygon (even-odd rule), clipped
+// to the image. A row of a concave polygon may have several spans. Each row
+// only tests the edges spanning it, so contours with hundreds of points
+// stay cheap.
+std::vector<RowSpan> polygon_spans(const std::vector<std::array<double, 2>>& vertices,
+    uint32_t width, uint32_t height);
+
+// Statistics of a region in modality units (e.g. HU)
+struct RoiStatistics {
+    uint64_t pixels = 0;
+    double mean = 0.0;
+    double std_dev = 0.0;   // population standard deviation
+    double min = 0.0;
+    double max = 0.0;
+
+    // Pixel spacing between rows, then between columns, as in DicomMetadata
+    double area_mm2(const std::array<double, 2>& pixel_spacing_mm) const {
+        return static_cast<double>(pixels) * pixel_spacing_mm[0] * pixel_spacing_mm[1];
+    }
+};
+
+// Summed-area tables of a grayscale image's samples and squared samples,
+// so the sum, mean and standard deviation of any rectangle take a fixed
+// number of lookups whatever its size, and a region made of row spans
+// (ellipse, polygon) the same per row. Exact 64-bit totals are kept only on
+// the lines of a 16 x 16 tile grid; inside a tile, sums relative to its
+// corner fit 24 bits and squares 40, packed into one word per pixel. Min and
+// max come from per-row sparse tables over the extremes of 16-sample
+// chunks: two lookups per row plus a scan of the partial chunks at span
+// ends, read from the image's own samples. So a rectangle's min and max
+// cost O(rows), unlike its sum and deviation. Results map back through the
+// image's modality mapping. Built in parallel; holds about 12 bytes per
+// pixel. Immutable once built, so it can be queried from any thread, but
+// only while the image it was built from keeps its pixels (moving the image
+// leaves them in place).
+class SummedAreaTable {
+public:
+    static constexpr uint32_t kChunkSamples = 16;
+    static constexpr uint32_t kTileSize = 16;
+
+    SummedAreaTable() = default;
+
+    // Needs a non-tiled grayscale image; otherwise the table stays empty
+    static SummedAreaTable build(const DicomImageData& image, ThreadPool& pool = ThreadPool::shared());
+
+    bool empty() const { return width_ == 0 || height_ == 0; }
+    uint32_t width() const { return width_; }
+    uint32_t height() const { return height_; }
+    size_t memory_bytes() const;
+
+    // Pixels [x_begin, x_end) x [y_begin, y_end), clipped to the image
+    RoiStatistics rectangle(uint32_t x_begin, uint32_t y_begin, uint32_t x_end, uint32_t y_end) const;
+
+    // Spans must lie inside the image, as the *_spans functions return them
+    RoiStatistics spans(const std::vector<RowSpan>& spans) const;
+
+private:
+    struct Accumulator {
+        uint64_t count = 0;
+        uint64_t sum = 0;
+        uint64_t squares = 0;
+        uint16_t min = UINT16_MAX;
+        uint16_t max = 0;
+    };
+
+    // Sum and sum of squares of [0, x) x [0, y); squares wrap modulo 2^64,
+    // which keeps differences exact
+    struct Totals {
+        uint64_t sum = 0;
+        uint64_t squares = 0;
+    };
+
+    Totals totals(uint32_t x, uint32_t y) const;
+
+    // Sum and sum of squares of rows [y_begin, y_end), columns [x_begin, x_end)
+    void add_block(uint32_t x_begin, uint32_t y_begin, uint32_t x_end, uint32_t y_end, Accumulator& acc) const;
+    void add_row_extremes(uint32_t y, uint32_t x_begin, uint32_t x_end, Accumulator& acc) const;
+    RoiStatistics finish(const Accumulator& acc) const;
+
+    uint32_t width_ = 0;
+    uint32_t height_ = 0;
+    uint32_t chunks_per_row_ = 0;
+    uint32_t levels_ = 0;
+    ModalityMapping modality_;
+    const uint16_t* samples_ = nullptr;   // the image's samples, for partial chunks
+    // Totals at x = 16 X for every y, (width / 16 + 1) x (height + 1), and at
+    // y = 16 Y for every x, (height / 16 + 1) x (width + 1)
+    std::vector<Totals> tile_columns_;
+    std::vector<Totals> tile_rows_;
+    // (width + 1) x (height + 1): sum (bits 0-23) and squares (bits 24-63) of
+    // [16 X, x) x [16 Y, y) for the tile (X, Y) that point (x, y) lies in
+    std::vector<uint64_t> in_tile_;
+    // levels x height x chunks_per_row: entry c of level k is the extreme
+    // of chunks [c, c + 2^k) of the row, where those exist
+    std::vector<uint16_t> chunk_min_;
+    std::vector<uint16_t> chunk_max_;
+};
+
+// The same statistics by visiting every pixel, for checking the tables
+RoiStatistics scan_roi_statistics(const DicomImageData& image, const std::vector<RowSpan>& spans);
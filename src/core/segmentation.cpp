@@ -0,0 +1,75 @@
+#include "segmentation.hpp"
+#include "mask_blend.hpp"
+#include <algorithm>
+#include <cstring>
+
+void Segmentation::finish() {
+    index_.clear();
+    for (uint32_t m = 0; m < masks.size(); ++m) {
+        for (const SourceFrame& source : masks[m].sources) {
+            index_[source].push_back(m);
+        }
+    }
+    // Later segments are drawn over earlier ones
+    for (auto& [source, list] : index_) {
+        std::stable_sort(list.begin(), list.end(),
+            [this](uint32_t a, uint32_t b) { return masks[a].segment < masks[b].segment; });
+    }
+}
+
+const std::vector<uint32_t>& Segmentation::masks_for(const std::string& sop_instance_uid, uint32_t frame) const {
+    static const std::vector<uint32_t> kNone;
+    auto it = index_.find(SourceFrame{ sop_instance_uid, frame });
+    return it != index_.end() ? it->second : kNone;
+}
+
+PixelBuffer Segmentation::blend(const PixelBuffer& display, uint32_t image_width, uint32_t image_height,
+    const std::string& sop_instance_uid, uint32_t frame, const std::vector<bool>& visible,
+    uint8_t opacity, ThreadPool& pool, bool simd) const {
+    // Masks are only defined on the source frame's own pixel grid
+    const bool is_rgb = display.format() == PixelFormat::Rgb8;
+    if (image_width != width || image_height != height || opacity == 0 ||
+        display.pixel_count() != static_cast<size_t>(width) * height ||
+        (!is_rgb && display.format() != PixelFormat::Gray8)) {
+        return {};
+    }
+
+    std::vector<const SegmentMask*> shown;
+    for (uint32_t m : masks_for(sop_instance_uid, frame)) {
+        const SegmentMask& mask = masks[m];
+        if (mask.segment < visible.size() && visible[mask.segment]) {
+            shown.push_back(&mask);
+        }
+    }
+    if (shown.empty()) {
+        return {};
+    }
+
+    PixelBuffer out = PixelBuffer::allocate(PixelFormat::Rgb8, display.pixel_count());
+    uint8_t* rgb = out.rgb8();
+    const size_t row_bytes = static_cast<size_t>(width) * 3;
+    if (is_rgb) {
+        std::memcpy(rgb, display.rgb8(), display.size_bytes());
+    }
+
+    // Each row blends only the masks whose rows reach it
+    pool.parallel_for(height, [&](size_t begin, size_t end) {
+        std::vector<BlendLayer> layers;
+        for (size_t y = begin; y < end; ++y) {
+            layers.clear();
+            for (const SegmentMask* mask : shown) {
+                if (y < mask->first_row || y >= mask->end_row) continue;
+                layers.push_back(BlendLayer{ mask->coverage.data() + (y - mask->first_row) * width,
+                    segments[mask->segment].color, opacity });
+            }
+            uint8_t* row = rgb + y * row_bytes;
+            if (is_rgb) {
+                if (!layers.empty()) blend_layers_rgb(row, layers.data(), layers.size(), width, simd);
+            }
+            else {
+                blend_layers(display.gray8() + y * width, layers.data(), layers.size(), width, row, simd);
+            }
+        }
+    });
+    return out;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "pixel_buffer.hpp"
+#include "thread_pool.hpp"
+#include <array>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// One segment of a DICOM Segmentation (SEG) object
+struct Segment {
+    uint16_t number = 0;                  // Segment Number as in the file
+    std::string label;
+    std::array<uint8_t, 3> color{};       // sRGB, from the recommended CIELab value
+};
+
+// A source image frame: the SOP Instance UID and the 0-based frame index
+using SourceFrame = std::pair<std::string, uint32_t>;
+
+// One segment's coverage of one source frame, kept only for the rows
+// [first_row, end_row) that hold any of it
+struct SegmentMask {
+    uint32_t segment = 0;                 // index into Segmentation::segments
+    std::vector<SourceFrame> sources;     // frames this mask was derived from
+    uint32_t first_row = 0;
+    uint32_t end_row = 0;
+    std::vector<uint8_t> coverage;        // 0-255, (end_row - first_row) rows of width
+};
+
+// The segments of a SEG object unpacked once at load to 8-bit coverage per
+// pixel, indexed by the source frames they were derived from. Blending
+// works on an already windowed display buffer, so showing, hiding or fading
+// segments never decodes the source image again. Immutable once finished,
+// so it can be shared with render threads.
+class Segmentation {
+public:
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<Segment> segments;
+    std::vector<SegmentMask> masks;
+
+    // Builds the source frame index; call once masks are filled
+    void finish();
+
+    // Indices of the masks over a source frame, in segment order
+    const std::vector<uint32_t>& masks_for(const std::string& sop_instance_uid, uint32_t frame) const;
+
+    bool covers(const std::string& sop_instance_uid, uint32_t frame) const {
+        return !masks_for(sop_instance_uid, frame).empty();
+    }
+
+    // Alpha-blends the visible segments over a Gray8 or Rgb8 display buffer
+    // of width x height pixels, giving Rgb8. visible has one flag per
+    // segment; opacity scales every segment's coverage. Row bands run on
+    // the pool. An empty buffer comes back when nothing is drawn.
+    PixelBuffer blend(const PixelBuffer& display, uint32_t image_width, uint32_t image_height,
+        const std::string& sop_instance_uid, uint32_t frame, const std::vector<bool>& visible,
+        uint8_t opacity, ThreadPool& pool = ThreadPool::shared(), bool simd = true) const;
+
+private:
+    std::map<SourceFrame, std::vector<uint32_t>> index_;
+};
@@ -0,0 +1,129 @@
+// Built with AVX2 enabled; only reached after a runtime CPU check. Like
+// mpr_avx2.cpp, this file avoids inline library code.
+#include "slab_kernels.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+namespace {
+
+inline __m256i load(const uint16_t* p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+inline void store(uint16_t* p, __m256i v) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+}
+
+// One 16-pixel step of a fold: take src where it beats or ties the extreme
+template<bool Maximum>
+inline void fold_step(__m256i& extreme, __m256i& slice_of, __m256i src, __m256i slice) {
+    const __m256i best = Maximum ? _mm256_max_epu16(extreme, src) : _mm256_min_epu16(extreme, src);
+    const __m256i take = _mm256_cmpeq_epi16(best, src);
+    extreme = best;
+    slice_of = _mm256_blendv_epi8(slice_of, slice, take);
+}
+
+template<bool Maximum>
+void fold(uint16_t* extreme, uint16_t* slice_of, const uint16_t* src, uint16_t slice, size_t n) {
+    const __m256i slice_v = _mm256_set1_epi16(static_cast<short>(slice));
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i e = load(extreme + i);
+        __m256i s = load(slice_of + i);
+        fold_step<Maximum>(e, s, load(src + i), slice_v);
+        store(extreme + i, e);
+        store(slice_of + i, s);
+    }
+    for (; i < n; ++i) {
+        if (Maximum ? src[i] >= extreme[i] : src[i] <= extreme[i]) {
+            extreme[i] = src[i];
+            slice_of[i] = slice;
+        }
+    }
+}
+
+// Recomputes whole 16-pixel groups in which any extreme left the slab
+template<bool Maximum>
+size_t rescan_impl(uint16_t* extreme, uint16_t* slice_of, const uint16_t* slab, size_t slice_stride,
+    uint16_t first, uint16_t count, size_t n) {
+    const __m256i first_v = _mm256_set1_epi16(static_cast<short>(first));
+    const __m256i last_offset = _mm256_set1_epi16(static_cast<short>(count - 1));
+    size_t recomputed = 0;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        // In the slab iff (slice - first) <= count - 1, unsigned
+        const __m256i offset = _mm256_sub_epi16(load(slice_of + i), first_v);
+        const __m256i inside = _mm256_cmpeq_epi16(_mm256_min_epu16(offset, last_offset), offset);
+        if (_mm256_movemask_epi8(inside) == -1) continue;
+
+        __m256i e = load(slab + i);
+        __m256i s = first_v;
+        for (uint16_t c = 1; c < count; ++c) {
+            fold_step<Maximum>(e, s, load(slab + c * slice_stride + i),
+                _mm256_set1_epi16(static_cast<short>(first + c)));
+        }
+        store(extreme + i, e);
+        store(slice_of + i, s);
+        recomputed += 16;
+    }
+    for (; i < n; ++i) {
+        if (static_cast<uint16_t>(slice_of[i] - first) < count) continue;
+        uint16_t best = slab[i];
+        uint16_t best_slice = first;
+        for (uint16_t c = 1; c < count; ++c) {
+            const uint16_t v = slab[c * slice_stride + i];
+            if (Maximum ? v >= best : v <= best) {
+                best = v;
+                best_slice = static_cast<uint16_t>(first + c);
+            }
+        }
+        extreme[i] = best;
+        slice_of[i] = best_slice;
+        ++recomputed;
+    }
+    return recomputed;
+}
+
+size_t rescan(uint16_t* extreme, uint16_t* slice_of, const uint16_t* slab, size_t slice_stride,
+    uint16_t first, uint16_t count, bool maximum, size_t n) {
+    return maximum ? rescan_impl<true>(extreme, slice_of, slab, slice_stride, first, count, n)
+                   : rescan_impl<false>(extreme, slice_of, slab, slice_stride, first, count, n);
+}
+
+// Widen 16 samples to two vectors of 8 x uint32 and add or subtract them
+template<bool Add>
+void accumulate(uint32_t* sum, const uint16_t* src, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m256i v = load(src + i);
+        const __m256i lo = _mm256_cvtepu16_epi32(_mm256_castsi256_si128(v));
+        const __m256i hi = _mm256_cvtepu16_epi32(_mm256_extracti128_si256(v, 1));
+        __m256i* s0 = reinterpret_cast<__m256i*>(sum + i);
+        __m256i* s1 = reinterpret_cast<__m256i*>(sum + i + 8);
+        const __m256i a = _mm256_loadu_si256(s0);
+        const __m256i b = _mm256_loadu_si256(s1);
+        _mm256_storeu_si256(s0, Add ? _mm256_add_epi32(a, lo) : _mm256_sub_epi32(a, lo));
+        _mm256_storeu_si256(s1, Add ? _mm256_add_epi32(b, hi) : _mm256_sub_epi32(b, hi));
+    }
+    for (; i < n; ++i) {
+        if (Add) sum[i] += src[i];
+        else sum[i] -= src[i];
+    }
+}
+
+const SlabKernels kKernels{ fold<true>, fold<false>, rescan, accumulate<true>, accumulate<false> };
+
+} // namespace
+
+const SlabKernels* slab_kernels_avx2() {
+    return &kKernels;
+}
+
+#else
+
+const SlabKernels* slab_kernels_avx2() {
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Internal to the slab projector: element-wise updates of one row. For MIP and
+// MinIP each pixel keeps its extreme and the slice that holds it; on ties the
+// most recently folded slice wins, as it stays in a sliding slab longest.
+struct SlabKernels {
+    void (*fold_max)(uint16_t* extreme, uint16_t* slice_of, const uint16_t* src, uint16_t slice, size_t n);
+    void (*fold_min)(uint16_t* extreme, uint16_t* slice_of, const uint16_t* src, uint16_t slice, size_t n);
+
+    // Recomputes pixels whose extreme lies outside slices [first, first + count)
+    // from the slab, whose rows are slice_stride samples apart starting at slab.
+    // Returns the number of pixels recomputed.
+    size_t (*rescan)(uint16_t* extreme, uint16_t* slice_of, const uint16_t* slab, size_t slice_stride,
+        uint16_t first, uint16_t count, bool maximum, size_t n);
+
+    void (*add_into)(uint32_t* sum, const uint16_t* src, size_t n);
+    void (*subtract_from)(uint32_t* sum, const uint16_t* src, size_t n);
+};
+
+const SlabKernels& slab_kernels_scalar();
+
+// nullptr when the build has no AVX2 kernels
+const SlabKernels* slab_kernels_avx2();
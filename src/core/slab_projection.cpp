@@ -0,0 +1,185 @@
+#include "slab_projection.hpp"
+#include "cpu_features.hpp"
+#include "slab_kernels.hpp"
+#include <algorithm>
+#include <atomic>
+#include <limits>
+
+namespace {
+
+void fold_max(uint16_t* extreme, uint16_t* slice_of, const uint16_t* src, uint16_t slice, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        if (src[i] >= extreme[i]) {
+            extreme[i] = src[i];
+            slice_of[i] = slice;
+        }
+    }
+}
+
+void fold_min(uint16_t* extreme, uint16_t* slice_of, const uint16_t* src, uint16_t slice, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        if (src[i] <= extreme[i]) {
+            extreme[i] = src[i];
+            slice_of[i] = slice;
+        }
+    }
+}
+
+size_t rescan(uint16_t* extreme, uint16_t* slice_of, const uint16_t* slab, size_t slice_stride,
+    uint16_t first, uint16_t count, bool maximum, size_t n) {
+    size_t recomputed = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (static_cast<uint16_t>(slice_of[i] - first) < count) continue;
+
+        uint16_t best = slab[i];
+        uint16_t best_slice = first;
+        for (uint16_t c = 1; c < count; ++c) {
+            const uint16_t v = slab[c * slice_stride + i];
+            if (maximum ? v >= best : v <= best) {
+                best = v;
+                best_slice = static_cast<uint16_t>(first + c);
+            }
+        }
+        extreme[i] = best;
+        slice_of[i] = best_slice;
+        ++recomputed;
+    }
+    return recomputed;
+}
+
+void add_into(uint32_t* sum, const uint16_t* src, size_t n) {
+    for (size_t i = 0; i < n; ++i) sum[i] += src[i];
+}
+
+void subtract_from(uint32_t* sum, const uint16_t* src, size_t n) {
+    for (size_t i = 0; i < n; ++i) sum[i] -= src[i];
+}
+
+} // namespace
+
+const SlabKernels& slab_kernels_scalar() {
+    static const SlabKernels kernels{ fold_max, fold_min, rescan, add_into, subtract_from };
+    return kernels;
+}
+
+SlabProjector::SlabProjector(ThreadPool& pool)
+    : pool_(pool)
+    , simd_enabled_(true) {
+}
+
+void SlabProjector::set_simd_enabled(bool enabled) {
+    simd_enabled_ = enabled;
+}
+
+void SlabProjector::reset() {
+    voxels_ = nullptr;
+    count_ = 0;
+    extreme_.clear();
+    slice_of_.clear();
+    sum_.clear();
+}
+
+DicomImageData SlabProjector::project(const Volume& volume, SlabMode mode, uint32_t first_slice,
+    uint32_t thickness) {
+    if (volume.empty() || volume.depth > std::numeric_limits<uint16_t>::max()) {
+        return {};
+    }
+
+    const uint32_t first = std::min(first_slice, volume.depth - 1);
+    const uint32_t last = std::min(first + std::max(thickness, 1u), volume.depth);   // exclusive
+    const size_t width = volume.width;
+    const size_t pixels = volume.slice_voxels();
+
+    const SlabKernels* simd = simd_enabled_ && cpu_features().avx2 ? slab_kernels_avx2() : nullptr;
+    const SlabKernels& k = simd ? *simd : slab_kernels_scalar();
+
+    // Keep the running slab if it overlaps the new one and updating is cheaper than rebuilding
+    const uint32_t old_last = first_ + count_;
+    const uint32_t overlap_begin = std::max(first, first_);
+    const uint32_t overlap_end = std::min(last, old_last);
+    const int64_t overlap = std::max<int64_t>(int64_t{ overlap_end } - overlap_begin, 0);
+    const int64_t changed = int64_t{ last - first } + count_ - 2 * overlap;
+    const bool incremental = voxels_ == volume.data() && width_ == volume.width &&
+        height_ == volume.height && mode_ == mode && count_ > 0 &&
+        overlap > 0 && changed < int64_t{ last - first };
+
+    if (!incremental) {
+        voxels_ = volume.data();
+        width_ = volume.width;
+        height_ = volume.height;
+        mode_ = mode;
+        first_ = 0;
+        count_ = 0;
+        if (mode == SlabMode::Average) {
+            sum_.assign(pixels, 0);
+            extreme_.clear();
+        }
+        else {
+            extreme_.resize(pixels);
+            slice_of_.resize(pixels);
+            sum_.clear();
+        }
+    }
+
+    // Slices entering and leaving the slab
+    std::vector<uint32_t> entering, leaving;
+    for (uint32_t s = first; s < last; ++s) {
+        if (!incremental || s < first_ || s >= old_last) entering.push_back(s);
+    }
+    if (incremental) {
+        for (uint32_t s = first_; s < old_last; ++s) {
+            if (s < first || s >= last) leaving.push_back(s);
+        }
+    }
+
+    std::atomic<size_t> recomputed{ 0 };
+    pool_.parallel_for(volume.height, [&](size_t begin, size_t end) {
+        size_t chunk_recomputed = 0;
+        for (size_t y = begin; y < end; ++y) {
+            const size_t offset = y * width;
+            if (mode == SlabMode::Average) {
+                uint32_t* sum = sum_.data() + offset;
+                for (uint32_t s : entering) k.add_into(sum, volume.slice(s) + offset, width);
+                for (uint32_t s : leaving) k.subtract_from(sum, volume.slice(s) + offset, width);
+                continue;
+            }
+
+            uint16_t* extreme = extreme_.data() + offset;
+            uint16_t* slice_of = slice_of_.data() + offset;
+            auto fold = mode == SlabMode::Maximum ? k.fold_max : k.fold_min;
+            if (!incremental) {
+                std::fill(extreme, extreme + width, mode == SlabMode::Maximum ? uint16_t{ 0 } : uint16_t{ 0xFFFF });
+                std::fill(slice_of, slice_of + width, static_cast<uint16_t>(first));
+            }
+            for (uint32_t s : entering) {
+                fold(extreme, slice_of, volume.slice(s) + offset, static_cast<uint16_t>(s), width);
+            }
+            // Only pixels whose extreme left the slab need the rest of it
+            if (!leaving.empty()) {
+                chunk_recomputed += k.rescan(extreme, slice_of, volume.slice(first) + offset, volume.slice_stride,
+                    static_cast<uint16_t>(first), static_cast<uint16_t>(last - first),
+                    mode == SlabMode::Maximum, width);
+            }
+        }
+        recomputed += chunk_recomputed;
+    });
+
+    first_ = first;
+    count_ = last - first;
+    last_update_slices_ = static_cast<uint32_t>(entering.size() + leaving.size());
+    last_recomputed_pixels_ = recomputed;
+
+    DicomImageData image = make_volume_image(volume.width, volume.height, volume);
+    uint16_t* out = image.data().pixels.gray16();
+    if (mode == SlabMode::Average) {
+        const uint32_t count = count_;
+        for (size_t i = 0; i < pixels; ++i) {
+            out[i] = static_cast<uint16_t>((sum_[i] + count / 2) / count);
+        }
+    }
+    else {
+        std::copy(extreme_.begin(), extreme_.end(), out);
+    }
+
+    return image;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "dicom_image.hpp"
+#include "thread_pool.hpp"
+#include "volume.hpp"
+#include <cstdint>
+#include <vector>
+
+enum class SlabMode {
+    Maximum,   // MIP
+    Minimum,   // MinIP
+    Average
+};
+
+// Thick-slab projection through consecutive slices of a volume. The running
+// result of the current slab is kept, so sliding the slab only folds in the
+// entering slices and takes out the leaving ones: sums are updated directly,
+// and for MIP/MinIP each pixel remembers the slice holding its extreme, so
+// only pixels whose extreme left the slab are recomputed from the rest of it.
+// Rows are spread over the pool. Volumes deeper than 65535 slices are not
+// supported.
+class SlabProjector {
+    ThreadPool& pool_;
+    bool simd_enabled_;
+
+    // Current slab; a new volume or mode starts over
+    const uint16_t* voxels_ = nullptr;
+    uint32_t width_ = 0;
+    uint32_t height_ = 0;
+    SlabMode mode_ = SlabMode::Maximum;
+    uint32_t first_ = 0;
+    uint32_t count_ = 0;
+    std::vector<uint16_t> extreme_;
+    std::vector<uint16_t> slice_of_;   // slice holding each extreme
+    std::vector<uint32_t> sum_;
+
+    uint32_t last_update_slices_ = 0;
+    size_t last_recomputed_pixels_ = 0;
+
+public:
+    explicit SlabProjector(ThreadPool& pool = ThreadPool::shared());
+
+    // For comparing against the scalar kernels
+    void set_simd_enabled(bool enabled);
+    bool simd_enabled() const { return simd_enabled_; }
+
+    // Projection of slices [first_slice, first_slice + thickness), clipped to
+    // the volume, as a grayscale image carrying the volume's window
+    DicomImageData project(const Volume& volume, SlabMode mode, uint32_t first_slice, uint32_t thickness);
+
+    // Forget the running slab, e.g. when the volume is replaced
+    void reset();
+
+    // Slices folded in or taken out, and pixels rescanned, by the last project()
+    uint32_t last_update_slices() const { return last_update_slices_; }
+    size_t last_recomputed_pixels() const { return last_recomputed_pixels_; }
+};
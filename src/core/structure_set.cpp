@@ -0,0 +1,275 @@
+#include "structure_set.hpp"
+#include "mask_blend.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// Even-odd combination of the spans of several contours: a pixel is filled
+// when an odd number of them cover it. Spans come back sorted by row, then x.
+std::vector<RowSpan> combine_even_odd(const std::vector<std::vector<RowSpan>>& contours) {
+    // Every span edge toggles coverage; edges at the same spot cancel in pairs
+    std::vector<uint64_t> edges;
+    for (const auto& spans : contours) {
+        for (const RowSpan& span : spans) {
+            edges.push_back(uint64_t{ span.y } << 32 | span.x_begin);
+            edges.push_back(uint64_t{ span.y } << 32 | span.x_end);
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+
+    std::vector<RowSpan> combined;
+    bool inside = false;
+    uint32_t begin = 0;
+    for (size_t i = 0; i < edges.size();) {
+        size_t same = i + 1;
+        while (same < edges.size() && edges[same] == edges[i]) ++same;
+        if ((same - i) % 2 == 1) {
+            const uint32_t y = static_cast<uint32_t>(edges[i] >> 32);
+            const uint32_t x = static_cast<uint32_t>(edges[i]);
+            if (inside) combined.push_back({ y, begin, x });
+            else begin = x;
+            inside = !inside;
+        }
+        i = same;
+    }
+    return combined;
+}
+
+// The filled pixels with a 4-neighbour outside the fill, found on a mask
+// of the fill's bounding box with an empty border
+std::vector<RowSpan> outline_spans(const std::vector<RowSpan>& fill) {
+    std::vector<RowSpan> outline;
+    if (fill.empty()) return outline;
+
+    uint32_t x_min = UINT32_MAX, x_max = 0;
+    for (const RowSpan& span : fill) {
+        x_min = std::min(x_min, span.x_begin);
+        x_max = std::max(x_max, span.x_end);
+    }
+    const uint32_t y_min = fill.front().y;
+    const size_t stride = static_cast<size_t>(x_max - x_min) + 2;
+    const size_t rows = static_cast<size_t>(fill.back().y - y_min) + 3;
+    std::vector<uint8_t> mask(stride * rows, 0);
+    for (const RowSpan& span : fill) {
+        std::memset(mask.data() + (span.y - y_min + 1) * stride + (span.x_begin - x_min + 1), 1,
+            span.x_end - span.x_begin);
+    }
+
+    for (const RowSpan& span : fill) {
+        const uint8_t* row = mask.data() + (span.y - y_min + 1) * stride + 1;
+        bool open = false;
+        uint32_t begin = 0;
+        for (uint32_t x = span.x_begin; x < span.x_end; ++x) {
+            const uint8_t* pixel = row + (x - x_min);
+            const bool edge = !pixel[-1] || !pixel[1] || !*(pixel - stride) || !pixel[stride];
+            if (edge && !open) begin = x;
+            if (!edge && open) outline.push_back({ span.y, begin, x });
+            open = edge;
+        }
+        if (open) outline.push_back({ span.y, begin, span.x_end });
+    }
+    return outline;
+}
+
+size_t spans_bytes(const std::vector<RowSpan>& spans) {
+    return spans.capacity() * sizeof(RowSpan);
+}
+
+} // namespace
+
+size_t StructureSet::contour_count() const {
+    size_t count = 0;
+    for (const Structure& structure : structures) {
+        count += structure.contours.size();
+    }
+    return count;
+}
+
+std::shared_ptr<ContourRasterCache> ContourRasterCache::create(std::shared_ptr<const StructureSet> structures,
+    const Volume& volume) {
+    std::shared_ptr<ContourRasterCache> cache(new ContourRasterCache());
+    cache->structures_ = std::move(structures);
+    cache->width_ = volume.width;
+    cache->height_ = volume.height;
+    cache->row_direction_ = volume.row_direction;
+    cache->column_direction_ = volume.column_direction;
+    cache->spacing_ = volume.spacing;
+
+    // Each slice's plane as its offset along the normal, sorted for lookup
+    const Vec3 normal = volume.row_direction.cross(volume.column_direction).normalized();
+    std::vector<std::pair<double, uint32_t>> planes;
+    cache->slices_.reserve(volume.depth);
+    for (uint32_t k = 0; k < volume.depth; ++k) {
+        auto slice = std::make_unique<Slice>();
+        slice->origin = volume.voxel_to_patient(Vec3{ 0, 0, static_cast<double>(k) });
+        planes.emplace_back(slice->origin.dot(normal), k);
+        cache->slices_.push_back(std::move(slice));
+    }
+    std::sort(planes.begin(), planes.end());
+    double tolerance = 0.5 * volume.spacing.z * std::abs(volume.slice_direction.normalized().dot(normal));
+    if (!(tolerance > 1e-3)) tolerance = 0.5;
+
+    const StructureSet& set = *cache->structures_;
+    for (uint32_t s = 0; s < set.structures.size() && !planes.empty(); ++s) {
+        const auto& contours = set.structures[s].contours;
+        for (uint32_t c = 0; c < contours.size(); ++c) {
+            const auto& points = contours[c].points;
+            if (points.size() < 3) continue;
+            double offset = 0.0;
+            for (const Vec3& point : points) offset += point.dot(normal);
+            offset /= static_cast<double>(points.size());
+
+            // Nearest plane: the first at or above the offset, or the one below it
+            auto it = std::lower_bound(planes.begin(), planes.end(), std::make_pair(offset, 0u));
+            if (it == planes.end() || (it != planes.begin() && offset - (it - 1)->first < it->first - offset)) {
+                --it;
+            }
+            if (std::abs(it->first - offset) > tolerance) continue;
+            cache->slices_[it->second]->contours.push_back({ s, c });
+            ++cache->matched_contours_;
+        }
+    }
+
+    for (auto& slice : cache->slices_) {
+        if (slice->contours.empty()) slice->ready.store(true, std::memory_order_release);
+    }
+    return cache;
+}
+
+void ContourRasterCache::rasterize(Slice& slice) const {
+    std::vector<std::array<double, 2>> vertices;
+    std::vector<std::vector<RowSpan>> contour_spans;
+    for (size_t i = 0; i < slice.contours.size();) {
+        const uint32_t s = slice.contours[i].structure;
+        contour_spans.clear();
+        for (; i < slice.contours.size() && slice.contours[i].structure == s; ++i) {
+            // Patient position to pixel coordinates, pixel (x, y) covering [x, x + 1) x [y, y + 1)
+            const auto& points = structures_->structures[s].contours[slice.contours[i].contour].points;
+            vertices.resize(points.size());
+            for (size_t p = 0; p < points.size(); ++p) {
+                const Vec3 offset = points[p] - slice.origin;
+                vertices[p] = { offset.dot(row_direction_) / spacing_.x + 0.5,
+                                offset.dot(column_direction_) / spacing_.y + 0.5 };
+            }
+            contour_spans.push_back(polygon_spans(vertices, width_, height_));
+        }
+
+        RasterizedStructure rasterized;
+        rasterized.structure = s;
+        rasterized.fill = contour_spans.size() == 1 ? std::move(contour_spans[0]) : combine_even_odd(contour_spans);
+        if (rasterized.fill.empty()) continue;
+        rasterized.outline = outline_spans(rasterized.fill);
+        rasterized.fill.shrink_to_fit();
+        rasterized.outline.shrink_to_fit();
+        slice.structures.push_back(std::move(rasterized));
+    }
+}
+
+const std::vector<RasterizedStructure>& ContourRasterCache::slice(uint32_t k) const {
+    Slice& entry = *slices_[k];
+    if (!entry.ready.load(std::memory_order_acquire)) {
+        std::call_once(entry.once, [&]() {
+            rasterize(entry);
+            entry.ready.store(true, std::memory_order_release);
+        });
+    }
+    return entry.structures;
+}
+
+bool ContourRasterCache::cached(uint32_t k) const {
+    return slices_[k]->ready.load(std::memory_order_acquire);
+}
+
+void ContourRasterCache::prefetch(uint32_t focus, ThreadPool& pool) {
+    std::lock_guard lock(prefetch_mutex_);
+    prefetch_token_.cancel();
+    prefetch_token_ = CancellationToken{};
+    if (slices_.empty()) return;
+
+    // One task per slice, so scrolling elsewhere only waits for the slice
+    // being rasterized and a new focus can drop the rest
+    const std::shared_ptr<const ContourRasterCache> self = shared_from_this();
+    const int64_t depth = static_cast<int64_t>(slices_.size());
+    const int64_t center = std::min<int64_t>(focus, depth - 1);
+    for (int64_t distance = 0; distance < depth; ++distance) {
+        for (int64_t k : { center + distance, center - distance }) {
+            if (k < 0 || k >= depth || (distance == 0 && k != center)) continue;
+            if (cached(static_cast<uint32_t>(k))) continue;
+            pool.post([self, k]() { self->slice(static_cast<uint32_t>(k)); }, TaskPriority::Prefetch,
+                &prefetch_token_);
+        }
+    }
+}
+
+void ContourRasterCache::cancel() {
+    std::lock_guard lock(prefetch_mutex_);
+    prefetch_token_.cancel();
+}
+
+size_t ContourRasterCache::memory_bytes() const {
+    size_t bytes = slices_.capacity() * sizeof(std::unique_ptr<Slice>);
+    for (const auto& slice : slices_) {
+        bytes += sizeof(Slice) + slice->contours.capacity() * sizeof(ContourRef);
+        if (!slice->ready.load(std::memory_order_acquire)) continue;
+        bytes += slice->structures.capacity() * sizeof(RasterizedStructure);
+        for (const RasterizedStructure& structure : slice->structures) {
+            bytes += spans_bytes(structure.fill) + spans_bytes(structure.outline);
+        }
+    }
+    return bytes;
+}
+
+PixelBuffer draw_structures(const PixelBuffer& display, uint32_t width, uint32_t height,
+    const std::vector<RasterizedStructure>& rasterized, const StructureSet& structures,
+    const std::vector<bool>& visible, bool filled, uint8_t opacity, bool simd) {
+    const bool is_rgb = display.format() == PixelFormat::Rgb8;
+    if (display.pixel_count() != static_cast<size_t>(width) * height ||
+        (!is_rgb && display.format() != PixelFormat::Gray8)) {
+        return {};
+    }
+
+    std::vector<const RasterizedStructure*> shown;
+    for (const RasterizedStructure& structure : rasterized) {
+        if (structure.structure < visible.size() && visible[structure.structure]) {
+            shown.push_back(&structure);
+        }
+    }
+    if (shown.empty()) {
+        return {};
+    }
+
+    PixelBuffer out = PixelBuffer::allocate(PixelFormat::Rgb8, display.pixel_count());
+    uint8_t* rgb = out.rgb8();
+    if (is_rgb) {
+        std::memcpy(rgb, display.rgb8(), display.size_bytes());
+    }
+    else {
+        blend_layers(display.gray8(), nullptr, 0, display.pixel_count(), rgb, simd);
+    }
+
+    // Fills first, so every outline stays solid on top
+    if (filled && opacity > 0) {
+        const std::vector<uint8_t> full(width, 255);
+        for (const RasterizedStructure* structure : shown) {
+            const BlendLayer layer{ full.data(), structures.structures[structure->structure].color, opacity };
+            for (const RowSpan& span : structure->fill) {
+                blend_layers_rgb(rgb + (static_cast<size_t>(span.y) * width + span.x_begin) * 3, &layer, 1,
+                    span.x_end - span.x_begin, simd);
+            }
+        }
+    }
+    for (const RasterizedStructure* structure : shown) {
+        const auto& color = structures.structures[structure->structure].color;
+        for (const RowSpan& span : structure->outline) {
+            uint8_t* pixel = rgb + (static_cast<size_t>(span.y) * width + span.x_begin) * 3;
+            for (uint32_t x = span.x_begin; x < span.x_end; ++x, pixel += 3) {
+                pixel[0] = color[0];
+                pixel[1] = color[1];
+                pixel[2] = color[2];
+            }
+        }
+    }
+    return out;
+}
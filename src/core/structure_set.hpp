@@ -0,0 +1,116 @@
+#pragma once
+
+#include "pixel_buffer.hpp"
+#include "roi_statistics.hpp"
+#include "thread_pool.hpp"
+#include "volume.hpp"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// One closed planar contour of an RT Structure Set, in patient coordinates (mm)
+struct StructureContour {
+    std::vector<Vec3> points;
+};
+
+// One ROI of an RT Structure Set with its contours on every slice
+struct Structure {
+    int32_t number = 0;                   // ROI Number as in the file
+    std::string name;
+    std::array<uint8_t, 3> color{};       // ROI Display Color
+    std::vector<StructureContour> contours;
+};
+
+struct StructureSet {
+    std::string frame_of_reference_uid;
+    std::vector<Structure> structures;
+
+    size_t contour_count() const;
+};
+
+// One structure's pixels on one slice, as row spans in slice pixel space.
+// Contours of a structure on the same slice combine by the even-odd rule,
+// so an inner contour cuts a hole. outline holds the filled pixels that
+// touch an unfilled one across an edge.
+struct RasterizedStructure {
+    uint32_t structure = 0;               // index into StructureSet::structures
+    std::vector<RowSpan> fill;
+    std::vector<RowSpan> outline;
+};
+
+// Rasterized contours of a structure set over the acquired slices of a
+// volume. Contours are assigned to the slice whose plane they lie in (within
+// half the slice spacing), then each slice is scan-converted once, the
+// first time it is asked for or by a background prefetch, and kept. Only
+// the volume's geometry is copied, so the cache does not pin its voxels.
+// Slices may be read from any thread.
+class ContourRasterCache : public std::enable_shared_from_this<ContourRasterCache> {
+public:
+    static std::shared_ptr<ContourRasterCache> create(std::shared_ptr<const StructureSet> structures,
+        const Volume& volume);
+
+    ContourRasterCache(const ContourRasterCache&) = delete;
+    ContourRasterCache& operator=(const ContourRasterCache&) = delete;
+
+    const StructureSet& structure_set() const { return *structures_; }
+    uint32_t width() const { return width_; }
+    uint32_t height() const { return height_; }
+    uint32_t depth() const { return static_cast<uint32_t>(slices_.size()); }
+
+    // Contours that lie in one of the volume's slice planes
+    size_t matched_contours() const { return matched_contours_; }
+
+    // Structures on slice k, in structure order; rasterized now on a miss
+    const std::vector<RasterizedStructure>& slice(uint32_t k) const;
+    bool cached(uint32_t k) const;
+
+    // Queues every slice not yet rasterized as Prefetch work on the pool,
+    // nearest to focus first, replacing an earlier prefetch
+    void prefetch(uint32_t focus, ThreadPool& pool = ThreadPool::shared());
+    // Drops queued prefetch work; slices already rasterized stay
+    void cancel();
+
+    size_t memory_bytes() const;
+
+private:
+    struct ContourRef {
+        uint32_t structure;
+        uint32_t contour;
+    };
+
+    struct Slice {
+        Vec3 origin;                      // center of the slice's first pixel
+        std::vector<ContourRef> contours; // in structure order
+        std::once_flag once;
+        std::atomic<bool> ready{ false };
+        std::vector<RasterizedStructure> structures;
+    };
+
+    std::shared_ptr<const StructureSet> structures_;
+    uint32_t width_ = 0;
+    uint32_t height_ = 0;
+    Vec3 row_direction_;
+    Vec3 column_direction_;
+    Vec3 spacing_;
+    std::vector<std::unique_ptr<Slice>> slices_;
+    size_t matched_contours_ = 0;
+
+    std::mutex prefetch_mutex_;
+    CancellationToken prefetch_token_;
+
+    ContourRasterCache() = default;
+    void rasterize(Slice& slice) const;
+};
+
+// Draws rasterized structures over a Gray8 or Rgb8 display buffer of
+// width x height pixels, giving Rgb8: the visible ones (one flag per
+// structure) as outlines, and with filled set also alpha-blended at
+// opacity inside. An empty buffer comes back when nothing is drawn.
+PixelBuffer draw_structures(const PixelBuffer& display, uint32_t width, uint32_t height,
+    const std::vector<RasterizedStructure>& rasterized, const StructureSet& structures,
+    const std::vector<bool>& visible, bool filled, uint8_t opacity, bool simd = true);
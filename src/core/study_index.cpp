@@ -0,0 +1,104 @@
+#include "study_index.hpp"
+#include <algorithm>
+
+void StudyIndex::add(InstanceRecord record) {
+    std::lock_guard lock(mutex_);
+    auto it = instances_.find(record.sop_instance_uid);
+    if (it != instances_.end()) {
+        unlink_locked(it->second);
+    }
+    studies_[record.study_instance_uid][record.series_instance_uid].push_back(record.sop_instance_uid);
+    const std::string key = record.sop_instance_uid;
+    instances_.insert_or_assign(key, std::move(record));
+}
+
+void StudyIndex::mark_decoded(const std::string& sop_instance_uid, bool decoded) {
+    std::lock_guard lock(mutex_);
+    auto it = instances_.find(sop_instance_uid);
+    if (it != instances_.end()) {
+        it->second.decoded = decoded;
+    }
+}
+
+std::vector<std::string> StudyIndex::study_uids() const {
+    std::lock_guard lock(mutex_);
+    std::vector<std::string> uids;
+    uids.reserve(studies_.size());
+    for (const auto& [uid, series] : studies_) {
+        uids.push_back(uid);
+    }
+    return uids;
+}
+
+std::vector<std::string> StudyIndex::series_uids(const std::string& study_instance_uid) const {
+    std::lock_guard lock(mutex_);
+    std::vector<std::string> uids;
+    auto study = studies_.find(study_instance_uid);
+    if (study != studies_.end()) {
+        for (const auto& [uid, instances] : study->second) {
+            uids.push_back(uid);
+        }
+    }
+    return uids;
+}
+
+std::vector<InstanceRecord> StudyIndex::series_instances(const std::string& series_instance_uid) const {
+    std::lock_guard lock(mutex_);
+    std::vector<InstanceRecord> records;
+    for (const auto& [study_uid, series] : studies_) {
+        auto it = series.find(series_instance_uid);
+        if (it == series.end()) {
+            continue;
+        }
+        for (const std::string& sop_uid : it->second) {
+            records.push_back(instances_.at(sop_uid));
+        }
+    }
+    std::stable_sort(records.begin(), records.end(), [](const InstanceRecord& a, const InstanceRecord& b) {
+        return a.instance_number < b.instance_number;
+    });
+    return records;
+}
+
+std::optional<InstanceRecord> StudyIndex::find(const std::string& sop_instance_uid) const {
+    std::lock_guard lock(mutex_);
+    auto it = instances_.find(sop_instance_uid);
+    if (it == instances_.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+size_t StudyIndex::instance_count() const {
+    std::lock_guard lock(mutex_);
+    return instances_.size();
+}
+
+size_t StudyIndex::study_count() const {
+    std::lock_guard lock(mutex_);
+    return studies_.size();
+}
+
+void StudyIndex::clear() {
+    std::lock_guard lock(mutex_);
+    instances_.clear();
+    studies_.clear();
+}
+
+void StudyIndex::unlink_locked(const InstanceRecord& record) {
+    auto study = studies_.find(record.study_instance_uid);
+    if (study == studies_.end()) {
+        return;
+    }
+    auto series = study->second.find(record.series_instance_uid);
+    if (series != study->second.end()) {
+        auto& uids = series->second;
+        uids.erase(std::remove(uids.begin(), uids.end(), record.sop_instance_uid), uids.end());
+        if (uids.empty()) {
+            study->second.erase(series);
+        }
+    }
+    if (study->second.empty()) {
+        studies_.erase(study);
+    }
+}
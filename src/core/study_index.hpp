@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// One received or opened instance, identified by its SOP Instance UID
+struct InstanceRecord {
+    std::string patient_id;
+    std::string patient_name;
+    std::string study_instance_uid;
+    std::string study_description;
+    std::string series_instance_uid;
+    std::string series_description;
+    std::string modality;
+    std::string sop_class_uid;
+    std::string sop_instance_uid;
+    int32_t instance_number = 0;
+    std::filesystem::path path;
+    bool decoded = false;      // pixels are in the image cache
+};
+
+// Patient/study/series/instance hierarchy of the instances known to the
+// viewer. Safe to update from several receiving threads at once.
+class StudyIndex {
+public:
+    // Adds the instance or replaces the record with the same SOP Instance UID
+    void add(InstanceRecord record);
+
+    void mark_decoded(const std::string& sop_instance_uid, bool decoded = true);
+
+    std::vector<std::string> study_uids() const;
+    std::vector<std::string> series_uids(const std::string& study_instance_uid) const;
+
+    // Instances of a series ordered by Instance Number
+    std::vector<InstanceRecord> series_instances(const std::string& series_instance_uid) const;
+
+    std::optional<InstanceRecord> find(const std::string& sop_instance_uid) const;
+
+    size_t instance_count() const;
+    size_t study_count() const;
+
+    void clear();
+
+private:
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, InstanceRecord> instances_;
+    // study -> series -> SOP Instance UIDs, in arrival order
+    std::map<std::string, std::map<std::string, std::vector<std::string>>> studies_;
+
+    void unlink_locked(const InstanceRecord& record);
+};
@@ -0,0 +1,411 @@
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <limits>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#endif
+
+namespace {
+
+constexpr size_t kNoWorker = std::numeric_limits<size_t>::max();
+constexpr size_t kFirstBackground = static_cast<size_t>(TaskPriority::Prefetch);
+
+// The pool and worker this thread belongs to, if any
+thread_local const ThreadPool* tls_pool = nullptr;
+thread_local size_t tls_worker = kNoWorker;
+thread_local TaskPriority tls_priority = TaskPriority::Render;
+
+#ifdef __linux__
+
+// CPUs this process may run on, grouped by NUMA node. One group when the
+// node layout is unknown or the process is confined to one node.
+std::vector<std::vector<int>> allowed_cpus_by_node() {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    std::vector<int> all;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &allowed)) {
+                all.push_back(cpu);
+            }
+        }
+    }
+    if (all.empty()) {
+        return {};
+    }
+
+    // Lists look like "0-3,8-11"
+    std::vector<std::vector<int>> nodes;
+    for (int node = 0;; ++node) {
+        std::ifstream list("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if (!list) {
+            break;
+        }
+        std::vector<int> cpus;
+        std::string range;
+        while (std::getline(list, range, ',')) {
+            int first = 0, last = 0;
+            char dash = 0;
+            std::istringstream parser(range);
+            if (!(parser >> first)) {
+                continue;
+            }
+            last = (parser >> dash >> last) ? last : first;
+            for (int cpu = first; cpu <= last; ++cpu) {
+                if (std::find(all.begin(), all.end(), cpu) != all.end()) {
+                    cpus.push_back(cpu);
+                }
+            }
+        }
+        if (!cpus.empty()) {
+            nodes.push_back(std::move(cpus));
+        }
+    }
+    if (nodes.size() < 2) {
+        return { all };
+    }
+    return nodes;
+}
+
+#endif
+
+} // namespace
+
+const char* to_string(TaskPriority priority) {
+    switch (priority) {
+        case TaskPriority::Render: return "render";
+        case TaskPriority::VisibleDecode: return "visible decode";
+        case TaskPriority::Prefetch: return "prefetch";
+        case TaskPriority::Indexing: return "indexing";
+    }
+    return "unknown";
+}
+
+ThreadPool::ThreadPool(size_t thread_count, size_t reserved_workers) : numa_nodes_(1), stopping_(false) {
+    thread_count = std::max<size_t>(thread_count, 1);
+    background_limit_ = thread_count - std::min(reserved_workers, thread_count - 1);
+
+    // Workers are spread over the NUMA nodes in proportion to their CPUs
+    std::vector<size_t> node_of(thread_count, 0);
+#ifdef __linux__
+    const std::vector<std::vector<int>> nodes = allowed_cpus_by_node();
+    if (nodes.size() > 1) {
+        numa_nodes_ = nodes.size();
+        std::vector<size_t> cpu_nodes;
+        for (size_t node = 0; node < nodes.size(); ++node) {
+            cpu_nodes.insert(cpu_nodes.end(), nodes[node].size(), node);
+        }
+        for (size_t i = 0; i < thread_count; ++i) {
+            node_of[i] = cpu_nodes[i * cpu_nodes.size() / thread_count];
+        }
+    }
+#endif
+
+    workers_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+        auto worker = std::make_unique<Worker>();
+        for (size_t pass = 0; pass < 2; ++pass) {
+            for (size_t other = 0; other < thread_count; ++other) {
+                if (other != i && (node_of[other] == node_of[i]) == (pass == 0)) {
+                    worker->victims.push_back(other);
+                }
+            }
+        }
+        workers_.push_back(std::move(worker));
+    }
+
+    for (size_t i = 0; i < thread_count; ++i) {
+        workers_[i]->thread = std::thread([this, i]() { worker_loop(i); });
+#ifdef __linux__
+        // Pinned to the node, not to one CPU, so the OS still balances within it
+        if (numa_nodes_ > 1) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (int cpu : nodes[node_of[i]]) {
+                CPU_SET(cpu, &set);
+            }
+            pthread_setaffinity_np(workers_[i]->thread.native_handle(), sizeof(set), &set);
+        }
+#endif
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(sleep_mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_) {
+        worker->thread.join();
+    }
+}
+
+size_t ThreadPool::default_thread_count() {
+#ifdef __linux__
+    // Containers and taskset narrow the CPUs hardware_concurrency reports
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+        return std::max<size_t>(static_cast<size_t>(CPU_COUNT(&allowed)), 1);
+    }
+#endif
+    return std::max<size_t>(std::thread::hardware_concurrency(), 1);
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool(default_thread_count(), 1);
+    return pool;
+}
+
+TaskPriority ThreadPool::current_priority() {
+    return tls_priority;
+}
+
+ThreadPool::PriorityScope::PriorityScope(TaskPriority priority) : previous_(tls_priority) {
+    tls_priority = priority;
+}
+
+ThreadPool::PriorityScope::~PriorityScope() {
+    tls_priority = previous_;
+}
+
+void ThreadPool::post(std::function<void()> task, TaskPriority priority, const CancellationToken* token) {
+    enqueue(std::move(task), priority, token);
+}
+
+void ThreadPool::enqueue(std::function<void()> run, TaskPriority priority, const CancellationToken* token) {
+    const size_t p = static_cast<size_t>(priority);
+    counters_[p].submitted.fetch_add(1, std::memory_order_relaxed);
+
+    // Counted before it is queued, so a pop never takes the count below zero
+    {
+        std::lock_guard lock(sleep_mutex_);
+        (p < kFirstBackground ? pending_urgent_ : pending_background_).fetch_add(1);
+    }
+
+    // A worker keeps what it submits, for locality; others steal it if idle
+    Queues& queues = tls_pool == this ? workers_[tls_worker]->queues : injected_;
+    {
+        std::lock_guard lock(queues.mutex);
+        queues.tasks[p].push_back(Task{ std::move(run), token ? token->flag_ : nullptr, Clock::now() });
+        queues.sizes[p].fetch_add(1, std::memory_order_relaxed);
+    }
+    wake_.notify_one();
+}
+
+bool ThreadPool::pop(Queues& queues, size_t priority, bool newest, Task& task) {
+    if (queues.sizes[priority].load(std::memory_order_relaxed) == 0) {
+        return false;
+    }
+    std::lock_guard lock(queues.mutex);
+    auto& tasks = queues.tasks[priority];
+    if (tasks.empty()) {
+        return false;
+    }
+    if (newest) {
+        task = std::move(tasks.back());
+        tasks.pop_back();
+    }
+    else {
+        task = std::move(tasks.front());
+        tasks.pop_front();
+    }
+    queues.sizes[priority].fetch_sub(1, std::memory_order_relaxed);
+    (priority < kFirstBackground ? pending_urgent_ : pending_background_).fetch_sub(1);
+    return true;
+}
+
+bool ThreadPool::try_run_one(size_t self) {
+    Worker& worker = *workers_[self];
+    bool background_reserved = false;
+    for (size_t p = 0; p < kTaskPriorityCount; ++p) {
+        if (p == kFirstBackground) {
+            if (background_running_.fetch_add(1) >= background_limit_) {
+                background_running_.fetch_sub(1);
+                return false;
+            }
+            background_reserved = true;
+        }
+
+        Task task;
+        bool found = pop(worker.queues, p, true, task) || pop(injected_, p, false, task);
+        for (size_t i = 0; !found && i < worker.victims.size(); ++i) {
+            found = pop(workers_[worker.victims[i]]->queues, p, false, task);
+            if (found) {
+                steals_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        if (found) {
+            run_task(task, p);
+            if (background_reserved) {
+                background_running_.fetch_sub(1);
+                // A background task may have waited for this slot
+                if (pending_background_.load() > 0) {
+                    std::lock_guard lock(sleep_mutex_);
+                    wake_.notify_one();
+                }
+            }
+            return true;
+        }
+    }
+    if (background_reserved) {
+        background_running_.fetch_sub(1);
+    }
+    return false;
+}
+
+void ThreadPool::run_task(Task& task, size_t priority) {
+    ClassCounters& counters = counters_[priority];
+    if (task.cancelled && task.cancelled->load(std::memory_order_relaxed)) {
+        counters.cancelled.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    const auto start = Clock::now();
+    const uint64_t wait_ns = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(start - task.queued).count());
+    counters.wait_ns.fetch_add(wait_ns, std::memory_order_relaxed);
+    uint64_t max_wait = counters.max_wait_ns.load(std::memory_order_relaxed);
+    while (wait_ns > max_wait && !counters.max_wait_ns.compare_exchange_weak(max_wait, wait_ns)) {
+    }
+    counters.running.fetch_add(1, std::memory_order_relaxed);
+
+    const TaskPriority previous = tls_priority;
+    tls_priority = static_cast<TaskPriority>(priority);
+    task.run();
+    tls_priority = previous;
+    task.run = nullptr;   // captures are released before the task counts as done
+
+    counters.run_ns.fetch_add(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count()),
+        std::memory_order_relaxed);
+    counters.running.fetch_sub(1, std::memory_order_relaxed);
+    counters.completed.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool ThreadPool::has_runnable() const {
+    return pending_urgent_.load() > 0 ||
+        (pending_background_.load() > 0 && background_running_.load() < background_limit_);
+}
+
+void ThreadPool::worker_loop(size_t self) {
+    tls_pool = this;
+    tls_worker = self;
+    for (;;) {
+        if (try_run_one(self)) {
+            continue;
+        }
+        std::unique_lock lock(sleep_mutex_);
+        if (stopping_ && !has_runnable()) {
+            return;
+        }
+        wake_.wait(lock, [this]() { return stopping_ || has_runnable(); });
+    }
+}
+
+bool ThreadPool::parallel_for(size_t count, const std::function<void(size_t, size_t)>& body,
+    const CancellationToken* token) {
+    if (count == 0) {
+        return true;
+    }
+
+    // A few chunks per worker keeps the load balanced without much queue traffic
+    const size_t chunk_count = std::min(count, size() * 4);
+    const size_t chunk_size = (count + chunk_count - 1) / chunk_count;
+    if (chunk_count == 1) {
+        if (token && token->cancelled()) {
+            return false;
+        }
+        body(0, count);
+        return true;
+    }
+
+    // Chunks are claimed from a counter rather than queued one per task.
+    // A helper that starts after the last chunk was claimed returns at once
+    // and never touches the body, which lives only as long as this call.
+    struct Job {
+        std::atomic<size_t> next{ 0 };
+        std::atomic<size_t> done{ 0 };
+        std::atomic<bool> skipped{ false };
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+    auto job = std::make_shared<Job>();
+    auto work = [job, chunk_count, chunk_size, count, &body, token]() {
+        for (;;) {
+            const size_t chunk = job->next.fetch_add(1);
+            if (chunk >= chunk_count) {
+                return;
+            }
+            if (token && token->cancelled()) {
+                job->skipped = true;
+            }
+            else {
+                const size_t begin = chunk * chunk_size;
+                body(begin, std::min(begin + chunk_size, count));
+            }
+            if (job->done.fetch_add(1) + 1 == chunk_count) {
+                std::lock_guard lock(job->mutex);
+                job->finished.notify_all();
+            }
+        }
+    };
+
+    const size_t helpers = std::min(size(), chunk_count - 1);
+    for (size_t i = 0; i < helpers; ++i) {
+        enqueue(work, current_priority(), nullptr);
+    }
+    work();
+
+    std::unique_lock lock(job->mutex);
+    job->finished.wait(lock, [&job, chunk_count]() { return job->done.load() == chunk_count; });
+    return !job->skipped;
+}
+
+SchedulerStats ThreadPool::stats() const {
+    SchedulerStats stats;
+    stats.steals = steals_.load(std::memory_order_relaxed);
+    stats.workers = workers_.size();
+    stats.numa_nodes = numa_nodes_;
+
+    for (size_t p = 0; p < kTaskPriorityCount; ++p) {
+        const ClassCounters& counters = counters_[p];
+        TaskClassStats& out = stats.classes[p];
+        out.submitted = counters.submitted.load(std::memory_order_relaxed);
+        out.completed = counters.completed.load(std::memory_order_relaxed);
+        out.cancelled = counters.cancelled.load(std::memory_order_relaxed);
+        out.running = counters.running.load(std::memory_order_relaxed);
+        out.queued = injected_.sizes[p].load(std::memory_order_relaxed);
+        for (const auto& worker : workers_) {
+            out.queued += worker->queues.sizes[p].load(std::memory_order_relaxed);
+        }
+
+        const uint64_t started = out.completed + out.running;
+        if (started > 0) {
+            out.mean_wait_ms = counters.wait_ns.load(std::memory_order_relaxed) / 1e6 / static_cast<double>(started);
+        }
+        if (out.completed > 0) {
+            out.mean_run_ms = counters.run_ns.load(std::memory_order_relaxed) / 1e6 / static_cast<double>(out.completed);
+        }
+        out.max_wait_ms = counters.max_wait_ns.load(std::memory_order_relaxed) / 1e6;
+    }
+    return stats;
+}
+
+void ThreadPool::reset_stats() {
+    for (ClassCounters& counters : counters_) {
+        counters.submitted = 0;
+        counters.completed = 0;
+        counters.cancelled = 0;
+        counters.wait_ns = 0;
+        counters.max_wait_ns = 0;
+        counters.run_ns = 0;
+    }
+    steals_ = 0;
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Scheduling classes, most urgent first. A free worker always takes the most
+// urgent queued task; running tasks are never preempted, so background work
+// is submitted in small pieces.
+enum class TaskPriority : uint8_t {
+    Render,          // what the user is looking at: windowing, MPR, cine frames
+    VisibleDecode,   // images about to be shown
+    Prefetch,        // images that may be shown next (received, retrieved)
+    Indexing         // batch work: export, anonymization
+};
+
+constexpr size_t kTaskPriorityCount = 4;
+
+const char* to_string(TaskPriority priority);
+
+// Shared flag that stops queued tasks from starting. Tasks already running
+// are not interrupted; they may poll cancelled() themselves.
+class CancellationToken {
+    friend class ThreadPool;
+    std::shared_ptr<std::atomic<bool>> flag_;
+
+public:
+    CancellationToken() : flag_(std::make_shared<std::atomic<bool>>(false)) {}
+
+    void cancel() const { flag_->store(true, std::memory_order_relaxed); }
+    bool cancelled() const { return flag_->load(std::memory_order_relaxed); }
+};
+
+struct TaskClassStats {
+    uint64_t submitted = 0;
+    uint64_t completed = 0;
+    uint64_t cancelled = 0;     // dropped before they started
+    uint32_t queued = 0;        // waiting now
+    uint32_t running = 0;
+    double mean_wait_ms = 0.0;  // from submission to start
+    double max_wait_ms = 0.0;
+    double mean_run_ms = 0.0;
+};
+
+struct SchedulerStats {
+    std::array<TaskClassStats, kTaskPriorityCount> classes;
+    uint64_t steals = 0;        // tasks taken from another worker's queue
+    size_t workers = 0;
+    size_t numa_nodes = 0;
+
+    const TaskClassStats& of(TaskPriority priority) const { return classes[static_cast<size_t>(priority)]; }
+};
+
+// Work-stealing worker pool shared by the decode, render and background
+// paths. Each worker keeps its own queues, one per priority class, and runs
+// its newest task first; idle workers steal the oldest task of another,
+// trying workers on the same NUMA node first. Tasks submitted from outside
+// the pool go to a shared queue. Prefetch and Indexing tasks never occupy
+// the reserved workers, so render and visible decode work always finds one;
+// the shared pool reserves one.
+// Tasks run with their class as the thread's current priority, so work they
+// submit or split with parallel_for inherits it; other threads default to
+// Render unless they set a PriorityScope.
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t thread_count = default_thread_count(), size_t reserved_workers = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return workers_.size(); }
+
+    template<typename F>
+    auto submit(F&& task, TaskPriority priority = current_priority()) -> std::future<std::invoke_result_t<F>> {
+        using R = std::invoke_result_t<F>;
+        auto packaged = std::make_shared<std::packaged_task<R()>>(std::forward<F>(task));
+        std::future<R> future = packaged->get_future();
+        enqueue([packaged]() { (*packaged)(); }, priority, nullptr);
+        return future;
+    }
+
+    // Fire and forget; dropped without running if the token is cancelled first
+    void post(std::function<void()> task, TaskPriority priority = current_priority(),
+        const CancellationToken* token = nullptr);
+
+    // Split [0, count) into contiguous chunks and block until all are
+    // processed. Workers and the calling thread claim chunks as they become
+    // free, so the caller finishes the loop alone when every worker is busy,
+    // and calling this from inside a task cannot deadlock. Chunks not yet
+    // started when the token is cancelled are skipped; returns false then.
+    bool parallel_for(size_t count, const std::function<void(size_t begin, size_t end)>& body,
+        const CancellationToken* token = nullptr);
+
+    SchedulerStats stats() const;
+    void reset_stats();
+
+    // Process-wide pool sized to the CPUs this process may run on
+    static ThreadPool& shared();
+
+    // CPUs in the process's affinity mask, at least 1
+    static size_t default_thread_count();
+
+    // Priority of the task running on this thread, or of the enclosing PriorityScope
+    static TaskPriority current_priority();
+
+    // Sets this thread's priority for the work it submits, until destroyed
+    class PriorityScope {
+        TaskPriority previous_;
+
+    public:
+        explicit PriorityScope(TaskPriority priority);
+        ~PriorityScope();
+
+        PriorityScope(const PriorityScope&) = delete;
+        PriorityScope& operator=(const PriorityScope&) = delete;
+    };
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Task {
+        std::function<void()> run;
+        std::shared_ptr<std::atomic<bool>> cancelled;
+        Clock::time_point queued;
+    };
+
+    struct Queues {
+        std::mutex mutex;
+        std::array<std::deque<Task>, kTaskPriorityCount> tasks;
+        std::array<std::atomic<uint32_t>, kTaskPriorityCount> sizes{};   // read without the lock
+    };
+
+    struct Worker {
+        Queues queues;
+        std::vector<size_t> victims;   // other workers, same NUMA node first
+        std::thread thread;
+    };
+
+    struct ClassCounters {
+        std::atomic<uint64_t> submitted{ 0 };
+        std::atomic<uint64_t> completed{ 0 };
+        std::atomic<uint64_t> cancelled{ 0 };
+        std::atomic<uint32_t> running{ 0 };
+        std::atomic<uint64_t> wait_ns{ 0 };
+        std::atomic<uint64_t> max_wait_ns{ 0 };
+        std::atomic<uint64_t> run_ns{ 0 };
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    Queues injected_;                  // submitted from outside the pool
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_;
+    std::atomic<size_t> pending_urgent_{ 0 };       // queued Render and VisibleDecode tasks
+    std::atomic<size_t> pending_background_{ 0 };   // queued Prefetch and Indexing tasks
+    std::atomic<size_t> background_running_{ 0 };
+    size_t background_limit_;
+    size_t numa_nodes_;
+    bool stopping_;
+
+    std::array<ClassCounters, kTaskPriorityCount> counters_;
+    std::atomic<uint64_t> steals_{ 0 };
+
+    void enqueue(std::function<void()> run, TaskPriority priority, const CancellationToken* token);
+    bool try_run_one(size_t self);
+    bool pop(Queues& queues, size_t priority, bool newest, Task& task);
+    void run_task(Task& task, size_t priority);
+    bool has_runnable() const;
+    void worker_loop(size_t self);
+};
@@ -0,0 +1,98 @@
+#include "tiled_image.hpp"
+#include <algorithm>
+#include <atomic>
+#include <limits>
+
+TiledImage::TiledImage(uint32_t width, uint32_t height, TileSource source, uint32_t tile_size)
+    : width_(width)
+    , height_(height)
+    , tile_size_(std::max<uint32_t>(tile_size, 1))
+    , tiles_x_((width + tile_size_ - 1) / tile_size_)
+    , tiles_y_((height + tile_size_ - 1) / tile_size_)
+    , source_(std::move(source))
+    , tiles_(std::make_unique<Tile[]>(static_cast<size_t>(tiles_x_) * tiles_y_)) {
+}
+
+std::shared_ptr<TiledImage> TiledImage::from_row_major(const uint16_t* pixels, uint32_t width,
+    uint32_t height, uint32_t tile_size) {
+    auto source = [pixels, width](const PixelRegion& region, uint16_t* dst, size_t dst_stride) {
+        for (uint32_t y = 0; y < region.height; ++y) {
+            const uint16_t* row = pixels + static_cast<size_t>(region.y + y) * width + region.x;
+            std::copy(row, row + region.width, dst + y * dst_stride);
+        }
+    };
+    return std::make_shared<TiledImage>(width, height, std::move(source), tile_size);
+}
+
+PixelRegion TiledImage::tile_region(uint32_t tx, uint32_t ty) const {
+    PixelRegion region;
+    region.x = tx * tile_size_;
+    region.y = ty * tile_size_;
+    region.width = std::min(tile_size_, width_ - region.x);
+    region.height = std::min(tile_size_, height_ - region.y);
+    return region;
+}
+
+const uint16_t* TiledImage::tile(uint32_t tx, uint32_t ty) const {
+    Tile& entry = tiles_[static_cast<size_t>(ty) * tiles_x_ + tx];
+    std::call_once(entry.once, [&]() {
+        const size_t samples = static_cast<size_t>(tile_size_) * tile_size_;
+        PixelBuffer pixels = PixelBuffer::allocate(PixelFormat::Gray16, samples);
+        const PixelRegion region = tile_region(tx, ty);
+        if (region.width < tile_size_ || region.height < tile_size_) {
+            // Keep the padding of edge tiles deterministic
+            std::fill(pixels.gray16(), pixels.gray16() + samples, uint16_t{ 0 });
+        }
+        source_(region, pixels.gray16(), tile_size_);
+        entry.pixels = std::move(pixels);
+    });
+    return entry.pixels.gray16();
+}
+
+size_t TiledImage::materialized_tiles() const {
+    size_t count = 0;
+    const size_t total = static_cast<size_t>(tiles_x_) * tiles_y_;
+    for (size_t i = 0; i < total; ++i) {
+        if (!tiles_[i].pixels.empty()) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+PixelStatistics compute_tiled_statistics(const TiledImage& image) {
+    PixelStatistics stats;
+    stats.histogram.assign(PixelStatistics::kHistogramBins, 0);
+
+    const PixelRegion all{ 0, 0, image.width(), image.height() };
+    if (all.width == 0 || all.height == 0) {
+        return stats;
+    }
+
+    uint16_t min_value = std::numeric_limits<uint16_t>::max();
+    uint16_t max_value = 0;
+    image.for_each_tile(all, [&](const PixelRegion& part, const uint16_t* data, size_t stride) {
+        for (uint32_t y = 0; y < part.height; ++y) {
+            auto [lo, hi] = std::minmax_element(data + y * stride, data + y * stride + part.width);
+            min_value = std::min(min_value, *lo);
+            max_value = std::max(max_value, *hi);
+        }
+    });
+    stats.min_value = min_value;
+    stats.max_value = max_value;
+
+    const double bin_size = stats.bin_size();
+    const size_t last_bin = PixelStatistics::kHistogramBins - 1;
+    image.for_each_tile(all, [&](const PixelRegion& part, const uint16_t* data, size_t stride) {
+        for (uint32_t y = 0; y < part.height; ++y) {
+            const uint16_t* row = data + y * stride;
+            for (uint32_t x = 0; x < part.width; ++x) {
+                size_t bin = static_cast<size_t>((row[x] - min_value) / bin_size);
+                if (bin > last_bin) bin = last_bin;
+                stats.histogram[bin]++;
+            }
+        }
+    });
+
+    return stats;
+}
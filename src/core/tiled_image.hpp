@@ -0,0 +1,97 @@
+#pragma once
+
+#include "pixel_buffer.hpp"
+#include "pixel_statistics.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Axis-aligned region in image pixels
+struct PixelRegion {
+    uint32_t x = 0;
+    uint32_t y = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+};
+
+// Normalized 16-bit grayscale pixels stored as square tiles, each one
+// contiguous in memory, so a zoomed-in region touches a few tiles instead of
+// one short run in each of thousands of rows. Tiles are produced on first use
+// by a TileSource and then kept; edge tiles are padded to the full tile size.
+class TiledImage {
+public:
+    static constexpr uint32_t kDefaultTileSize = 256;
+
+    // Fills the region (never larger than one tile) into dst, rows dst_stride samples apart.
+    // May be called concurrently for different tiles.
+    using TileSource = std::function<void(const PixelRegion& region, uint16_t* dst, size_t dst_stride)>;
+
+    TiledImage(uint32_t width, uint32_t height, TileSource source,
+        uint32_t tile_size = kDefaultTileSize);
+
+    TiledImage(const TiledImage&) = delete;
+    TiledImage& operator=(const TiledImage&) = delete;
+
+    // Retiles an existing row-major buffer; the buffer must outlive the tiles' materialization
+    static std::shared_ptr<TiledImage> from_row_major(const uint16_t* pixels, uint32_t width,
+        uint32_t height, uint32_t tile_size = kDefaultTileSize);
+
+    uint32_t width() const { return width_; }
+    uint32_t height() const { return height_; }
+    uint32_t tile_size() const { return tile_size_; }
+    uint32_t tiles_x() const { return tiles_x_; }
+    uint32_t tiles_y() const { return tiles_y_; }
+
+    // Image area covered by a tile, clipped to the image
+    PixelRegion tile_region(uint32_t tx, uint32_t ty) const;
+
+    // Tile samples with a row stride of tile_size(), materialized on first access
+    const uint16_t* tile(uint32_t tx, uint32_t ty) const;
+
+    size_t materialized_tiles() const;
+
+    // Calls fn(part, data, stride) for every tile overlapping region, where part
+    // is the overlap and data points at its first sample
+    template<typename F>
+    void for_each_tile(const PixelRegion& region, F&& fn) const {
+        if (region.width == 0 || region.height == 0) return;
+        const uint32_t tx0 = region.x / tile_size_;
+        const uint32_t ty0 = region.y / tile_size_;
+        const uint32_t tx1 = (region.x + region.width - 1) / tile_size_;
+        const uint32_t ty1 = (region.y + region.height - 1) / tile_size_;
+        for (uint32_t ty = ty0; ty <= ty1 && ty < tiles_y_; ++ty) {
+            for (uint32_t tx = tx0; tx <= tx1 && tx < tiles_x_; ++tx) {
+                const PixelRegion bounds = tile_region(tx, ty);
+                PixelRegion part;
+                part.x = std::max(bounds.x, region.x);
+                part.y = std::max(bounds.y, region.y);
+                part.width = std::min(bounds.x + bounds.width, region.x + region.width) - part.x;
+                part.height = std::min(bounds.y + bounds.height, region.y + region.height) - part.y;
+                const uint16_t* data = tile(tx, ty) +
+                    static_cast<size_t>(part.y - bounds.y) * tile_size_ + (part.x - bounds.x);
+                fn(part, data, static_cast<size_t>(tile_size_));
+            }
+        }
+    }
+
+private:
+    struct Tile {
+        std::once_flag once;
+        PixelBuffer pixels;
+    };
+
+    uint32_t width_;
+    uint32_t height_;
+    uint32_t tile_size_;
+    uint32_t tiles_x_;
+    uint32_t tiles_y_;
+    TileSource source_;
+    std::unique_ptr<Tile[]> tiles_;
+};
+
+// Min/max and histogram gathered tile by tile (materializes every tile)
+PixelStatistics compute_tiled_statistics(const TiledImage& image);
@@ -0,0 +1,141 @@
+#include "viewport.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+
+ViewportPlacement place_in_viewport(const ViewportState& state,
+    uint32_t viewport_width, uint32_t viewport_height) {
+    ViewportPlacement placement;
+    if (!state.image || viewport_width == 0 || viewport_height == 0 || state.zoom <= 0.0) {
+        return placement;
+    }
+    const ImageData& data = state.image->data();
+    if (data.width == 0 || data.height == 0) {
+        return placement;
+    }
+
+    // Viewport pixels per image pixel
+    const double scale = std::min(static_cast<double>(viewport_width) / data.width,
+        static_cast<double>(viewport_height) / data.height) * state.zoom;
+
+    // Image area under the viewport, then clipped to the image
+    const double left = data.width / 2.0 + state.pan_x - viewport_width / (2.0 * scale);
+    const double top = data.height / 2.0 + state.pan_y - viewport_height / (2.0 * scale);
+    const double x0 = std::clamp(std::floor(left), 0.0, static_cast<double>(data.width));
+    const double y0 = std::clamp(std::floor(top), 0.0, static_cast<double>(data.height));
+    const double x1 = std::clamp(std::ceil(left + viewport_width / scale), 0.0, static_cast<double>(data.width));
+    const double y1 = std::clamp(std::ceil(top + viewport_height / scale), 0.0, static_cast<double>(data.height));
+    if (x1 <= x0 || y1 <= y0) {
+        return placement;
+    }
+
+    placement.source = PixelRegion{ static_cast<uint32_t>(x0), static_cast<uint32_t>(y0),
+        static_cast<uint32_t>(x1 - x0), static_cast<uint32_t>(y1 - y0) };
+    placement.x = static_cast<int32_t>(std::lround((x0 - left) * scale));
+    placement.y = static_cast<int32_t>(std::lround((y0 - top) * scale));
+
+    // Partially visible edge pixels may reach past the viewport; the caller clips when drawing
+    placement.width = static_cast<uint32_t>(std::max(1l, std::lround((x1 - x0) * scale)));
+    placement.height = static_cast<uint32_t>(std::max(1l, std::lround((y1 - y0) * scale)));
+    return placement;
+}
+
+namespace {
+
+// Nearest-neighbour resampling of rows [row_begin, row_end) of an Rgb8 region
+void resample_rgb_rows(const ImageData& data, const PixelRegion& region, uint32_t out_width,
+    uint32_t out_height, uint32_t row_begin, uint32_t row_end, uint8_t* out) {
+    const uint8_t* pixels = data.pixels.rgb8();
+    for (uint32_t oy = row_begin; oy < row_end; ++oy) {
+        const uint32_t sy = region.y + static_cast<uint32_t>(static_cast<uint64_t>(oy) * region.height / out_height);
+        const uint8_t* row = pixels + static_cast<size_t>(sy) * data.width * 3;
+        uint8_t* dst = out + static_cast<size_t>(oy) * out_width * 3;
+        for (uint32_t ox = 0; ox < out_width; ++ox) {
+            const uint32_t sx = region.x + static_cast<uint32_t>(static_cast<uint64_t>(ox) * region.width / out_width);
+            std::copy(row + static_cast<size_t>(sx) * 3, row + static_cast<size_t>(sx) * 3 + 3, dst + ox * 3);
+        }
+    }
+}
+
+struct Band {
+    size_t viewport;
+    uint32_t row_begin;
+    uint32_t row_end;
+};
+
+} // namespace
+
+ViewportRenderer::ViewportRenderer(ThreadPool& pool)
+    : pool_(pool) {
+}
+
+std::vector<ViewportFrame> ViewportRenderer::render(const std::vector<ViewportRequest>& requests) const {
+    std::vector<ViewportFrame> frames(requests.size());
+    std::vector<std::pair<int32_t, int32_t>> windows;   // distinct windows of the grayscale viewports
+    std::vector<size_t> window_of(requests.size(), SIZE_MAX);
+    std::vector<Band> bands;
+
+    for (size_t i = 0; i < requests.size(); ++i) {
+        const ViewportRequest& request = requests[i];
+        ViewportFrame& frame = frames[i];
+        frame.placement = place_in_viewport(request.state, request.width, request.height);
+        if (frame.placement.width == 0) {
+            continue;
+        }
+
+        const ImageData& data = request.state.image->data();
+        const size_t pixel_count = static_cast<size_t>(frame.placement.width) * frame.placement.height;
+        if (data.is_rgb() && data.pixels.rgb8()) {
+            frame.pixels = PixelBuffer::allocate(PixelFormat::Rgb8, pixel_count);
+        }
+        else if (data.has_grayscale_pixels()) {
+            frame.pixels = PixelBuffer::allocate(PixelFormat::Gray8, pixel_count);
+            const std::pair<int32_t, int32_t> window{ request.state.window_center, request.state.window_width };
+            auto it = std::find(windows.begin(), windows.end(), window);
+            window_of[i] = static_cast<size_t>(it - windows.begin());
+            if (it == windows.end()) {
+                windows.push_back(window);
+            }
+        }
+        else {
+            frame.placement = ViewportPlacement{};
+            continue;
+        }
+
+        for (uint32_t row = 0; row < frame.placement.height; row += kBandRows) {
+            bands.push_back(Band{ i, row, std::min(row + kBandRows, frame.placement.height) });
+        }
+    }
+
+    std::vector<std::vector<uint8_t>> luts(windows.size());
+    pool_.parallel_for(windows.size(), [&](size_t begin, size_t end) {
+        for (size_t w = begin; w < end; ++w) {
+            luts[w] = DicomImageData::window_lut(windows[w].first, windows[w].second);
+        }
+    });
+
+    pool_.parallel_for(bands.size(), [&](size_t begin, size_t end) {
+        for (size_t b = begin; b < end; ++b) {
+            const Band& band = bands[b];
+            const DicomImageData& image = *requests[band.viewport].state.image;
+            ViewportFrame& frame = frames[band.viewport];
+            const ViewportPlacement& placement = frame.placement;
+            if (window_of[band.viewport] != SIZE_MAX) {
+                image.render_region_rows(placement.source, placement.width, placement.height,
+                    luts[window_of[band.viewport]].data(), band.row_begin, band.row_end, frame.pixels.gray8());
+            }
+            else {
+                resample_rgb_rows(image.data(), placement.source, placement.width, placement.height,
+                    band.row_begin, band.row_end, frame.pixels.rgb8());
+            }
+        }
+    });
+
+    return frames;
+}
+
+ViewportFrame ViewportRenderer::render(const ViewportState& state, uint32_t width, uint32_t height) const {
+    std::vector<ViewportRequest> requests{ ViewportRequest{ state, width, height } };
+    return std::move(render(requests).front());
+}
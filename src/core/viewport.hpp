@@ -0,0 +1,59 @@
+#pragma once
+
+#include "image_cache.hpp"
+#include "pixel_buffer.hpp"
+#include "thread_pool.hpp"
+#include <cstdint>
+#include <vector>
+
+// What one viewport of a layout shows: a shared image with its own window and view
+struct ViewportState {
+    SharedImage image;
+    int32_t window_center = 0;
+    int32_t window_width = 1;
+    double zoom = 1.0;    // 1 fits the whole image into the viewport
+    double pan_x = 0.0;   // view center relative to the image center, in image pixels
+    double pan_y = 0.0;
+};
+
+// Where the visible part of the image is drawn inside a viewport
+struct ViewportPlacement {
+    PixelRegion source;   // visible image pixels
+    int32_t x = 0;        // top-left of the drawn area, in viewport pixels
+    int32_t y = 0;
+    uint32_t width = 0;   // drawn size; 0 when nothing is visible
+    uint32_t height = 0;
+};
+
+ViewportPlacement place_in_viewport(const ViewportState& state,
+    uint32_t viewport_width, uint32_t viewport_height);
+
+struct ViewportRequest {
+    ViewportState state;
+    uint32_t width = 0;
+    uint32_t height = 0;
+};
+
+// Gray8 (or Rgb8 for color images) pixels of the drawn area
+struct ViewportFrame {
+    PixelBuffer pixels;
+    ViewportPlacement placement;
+};
+
+// Renders all viewports of a layout in one pass. Every viewport is cut into
+// row bands and the bands of all viewports are spread over the pool together,
+// so one large viewport does not leave the other workers idle. Viewports with
+// the same window (e.g. linked window/level) share one window LUT.
+class ViewportRenderer {
+    ThreadPool& pool_;
+
+public:
+    static constexpr uint32_t kBandRows = 32;
+
+    explicit ViewportRenderer(ThreadPool& pool = ThreadPool::shared());
+
+    // One frame per request, in order. Must not be called from a pool worker.
+    std::vector<ViewportFrame> render(const std::vector<ViewportRequest>& requests) const;
+
+    ViewportFrame render(const ViewportState& state, uint32_t width, uint32_t height) const;
+};
@@ -0,0 +1,91 @@
+#include "volume.hpp"
+#include "pixel_buffer.hpp"
+#include <algorithm>
+
+namespace {
+
+class PooledVoxelStorage : public VoxelStorage {
+    PixelBuffer buffer_;
+
+public:
+    explicit PooledVoxelStorage(size_t samples)
+        : buffer_(PixelBuffer::allocate(PixelFormat::Gray16, samples)) {
+        data_ = buffer_.gray16();
+    }
+
+    bool file_backed() const override { return false; }
+};
+
+} // namespace
+
+size_t Volume::aligned_slice_stride(uint32_t w, uint32_t h) {
+    constexpr size_t samples_per_line = kSliceAlignment / sizeof(uint16_t);
+    const size_t samples = static_cast<size_t>(w) * h;
+    return (samples + samples_per_line - 1) / samples_per_line * samples_per_line;
+}
+
+size_t Volume::storage_bytes(uint32_t w, uint32_t h, uint32_t d) {
+    return aligned_slice_stride(w, h) * d * sizeof(uint16_t);
+}
+
+void Volume::allocate(uint32_t w, uint32_t h, uint32_t d) {
+    allocate(w, h, d, std::make_unique<PooledVoxelStorage>(aligned_slice_stride(w, h) * d));
+}
+
+void Volume::allocate(uint32_t w, uint32_t h, uint32_t d, std::unique_ptr<VoxelStorage> storage) {
+    width = w;
+    height = h;
+    depth = d;
+    slice_stride = aligned_slice_stride(w, h);
+    storage_ = std::move(storage);
+}
+
+DicomImageData Volume::slice_image(uint32_t k) const {
+    DicomImageData image = make_volume_image(width, height, *this);
+    const uint16_t* src = slice(std::min(k, depth - 1));
+    std::copy(src, src + slice_voxels(), image.data().pixels.gray16());
+    return image;
+}
+
+Vec3 Volume::voxel_to_patient(const Vec3& ijk) const {
+    return origin + row_direction * (ijk.x * spacing.x) + column_direction * (ijk.y * spacing.y) +
+        slice_direction * (ijk.z * spacing.z);
+}
+
+Vec3 Volume::patient_to_voxel(const Vec3& position) const {
+    // Invert the 3x3 matrix whose columns are the scaled axes: the rows of the
+    // inverse are the pairwise cross products divided by the determinant
+    const Vec3 a = row_direction * spacing.x;
+    const Vec3 b = column_direction * spacing.y;
+    const Vec3 c = slice_direction * spacing.z;
+    const double det = a.dot(b.cross(c));
+    if (det == 0) {
+        return {};
+    }
+    const Vec3 d = position - origin;
+    return { b.cross(c).dot(d) / det, c.cross(a).dot(d) / det, a.cross(b).dot(d) / det };
+}
+
+Vec3 Volume::center() const {
+    return voxel_to_patient({ (width - 1.0) * 0.5, (height - 1.0) * 0.5, (depth - 1.0) * 0.5 });
+}
+
+DicomImageData make_volume_image(uint32_t w, uint32_t h, const Volume& volume) {
+    ImageData img_data;
+    img_data.width = w;
+    img_data.height = h;
+    img_data.bits_allocated = 16;
+    img_data.bits_stored = 16;
+    img_data.samples_per_pixel = 1;
+    img_data.photometric = PhotometricInterpretation::Monochrome2;
+    img_data.window_center = volume.window_center;
+    img_data.window_width = volume.window_width;
+    img_data.original_window_center = volume.window_center;
+    img_data.original_window_width = volume.window_width;
+    img_data.modality = volume.modality;
+    img_data.pixels = PixelBuffer::allocate(PixelFormat::Gray16, img_data.pixel_count());
+
+    DicomImageData image;
+    image.set_data(std::move(img_data));
+    return image;
+}
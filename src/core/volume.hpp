@@ -0,0 +1,104 @@
+#pragma once
+
+#include "dicom_image.hpp"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Point or direction in patient space (mm)
+struct Vec3 {
+    double x = 0;
+    double y = 0;
+    double z = 0;
+
+    Vec3 operator+(const Vec3& o) const { return { x + o.x, y + o.y, z + o.z }; }
+    Vec3 operator-(const Vec3& o) const { return { x - o.x, y - o.y, z - o.z }; }
+    Vec3 operator*(double s) const { return { x * s, y * s, z * s }; }
+
+    double dot(const Vec3& o) const { return x * o.x + y * o.y + z * o.z; }
+    Vec3 cross(const Vec3& o) const {
+        return { y * o.z - z * o.y, z * o.x - x * o.z, x * o.y - y * o.x };
+    }
+    double length() const { return std::sqrt(dot(*this)); }
+    Vec3 normalized() const {
+        const double len = length();
+        return len > 0 ? *this * (1.0 / len) : *this;
+    }
+};
+
+// Where a volume's voxels live: pooled memory, or for volumes larger than RAM
+// a memory-mapped scratch file (see series_loader)
+class VoxelStorage {
+protected:
+    uint16_t* data_ = nullptr;   // set by the implementation
+
+public:
+    virtual ~VoxelStorage() = default;
+    uint16_t* data() const { return data_; }
+    virtual bool file_backed() const = 0;
+};
+
+// A series stacked into one contiguous block of 16-bit samples, x fastest,
+// then y, then slice, with slices ordered along the slice normal. Each slice
+// starts on a cache-line boundary, slice_stride samples after the previous one.
+// Voxel (i, j, k) lies at
+//   origin + row_direction * (i * spacing.x) + column_direction * (j * spacing.y)
+//          + slice_direction * (k * spacing.z)
+// slice_direction need not be perpendicular to the slices (gantry tilt).
+struct Volume {
+    static constexpr size_t kSliceAlignment = 64;   // bytes
+
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t depth = 0;
+    size_t slice_stride = 0;   // samples
+
+    Vec3 origin;
+    Vec3 row_direction{ 1, 0, 0 };
+    Vec3 column_direction{ 0, 1, 0 };
+    Vec3 slice_direction{ 0, 0, 1 };
+    Vec3 spacing{ 1, 1, 1 };
+
+    // The single voxel to modality value mapping shared by every slice
+    ModalityMapping modality;
+
+    // In voxel units
+    int32_t window_center = 32768;
+    int32_t window_width = 65536;
+
+    // Samples between slices for a given slice size
+    static size_t aligned_slice_stride(uint32_t w, uint32_t h);
+    static size_t storage_bytes(uint32_t w, uint32_t h, uint32_t d);
+
+    // Uninitialized pooled memory for a w x h x d volume
+    void allocate(uint32_t w, uint32_t h, uint32_t d);
+    // Caller-provided storage of at least storage_bytes(w, h, d)
+    void allocate(uint32_t w, uint32_t h, uint32_t d, std::unique_ptr<VoxelStorage> storage);
+
+    bool empty() const { return data() == nullptr; }
+    bool file_backed() const { return storage_ && storage_->file_backed(); }
+    size_t slice_voxels() const { return static_cast<size_t>(width) * height; }
+    // Samples spanned by all slices, padding included
+    size_t voxel_span() const { return slice_stride * depth; }
+
+    const uint16_t* data() const { return storage_ ? storage_->data() : nullptr; }
+    uint16_t* data() { return storage_ ? storage_->data() : nullptr; }
+    const uint16_t* slice(uint32_t k) const { return data() + k * slice_stride; }
+    uint16_t* slice(uint32_t k) { return data() + k * slice_stride; }
+
+    // One acquired slice as a displayable image carrying the volume's window
+    DicomImageData slice_image(uint32_t k) const;
+
+    // Continuous voxel index (i, j, k) <-> patient position
+    Vec3 voxel_to_patient(const Vec3& ijk) const;
+    Vec3 patient_to_voxel(const Vec3& position) const;
+
+    Vec3 center() const;
+
+private:
+    std::unique_ptr<VoxelStorage> storage_;
+};
+
+// Grayscale image of w x h samples with a window, as produced from volumes
+DicomImageData make_volume_image(uint32_t w, uint32_t h, const Volume& volume);
@@ -0,0 +1,88 @@
+#include "codec_registry.hpp"
+
+// DCMTK includes
+#include <dcmtk/dcmdata/dcdatset.h>
+#include <dcmtk/dcmdata/dcdict.h>
+#include <dcmtk/dcmdata/dcrledrg.h>
+#include <dcmtk/dcmdata/dcxfer.h>
+#include <dcmtk/dcmjpeg/djdecode.h>
+#include <dcmtk/dcmjpls/djdecode.h>
+
+#include <iostream>
+#include <mutex>
+
+namespace {
+
+std::once_flag rle_once;
+std::once_flag jpeg_once;
+std::once_flag jpeg_ls_once;
+
+void register_rle() {
+    std::call_once(rle_once, []() {
+        DcmRLEDecoderRegistration::registerCodecs();
+        std::cout << "[DEBUG] Registered RLE decoder" << std::endl;
+    });
+}
+
+void register_jpeg() {
+    std::call_once(jpeg_once, []() {
+        DJDecoderRegistration::registerCodecs(EDC_photometricInterpretation, EUC_default, EPC_default, OFTrue);
+        std::cout << "[DEBUG] Registered JPEG decoders" << std::endl;
+    });
+}
+
+void register_jpeg_ls() {
+    std::call_once(jpeg_ls_once, []() {
+        DJLSDecoderRegistration::registerCodecs();
+        std::cout << "[DEBUG] Registered JPEG-LS decoders" << std::endl;
+    });
+}
+
+} // namespace
+
+void ensure_decoders(const DcmDataset& dataset) {
+    E_TransferSyntax xfer = dataset.getOriginalXfer();
+    if (xfer == EXS_Unknown) {
+        xfer = dataset.getCurrentXfer();
+    }
+    const DcmXfer info(xfer);
+    if (!info.usesEncapsulatedFormat() || !info.isPixelDataCompressed()) {
+        return;
+    }
+
+    if (xfer == EXS_RLELossless) {
+        register_rle();
+    }
+    else if (xfer == EXS_JPEGLSLossless || xfer == EXS_JPEGLSLossy) {
+        register_jpeg_ls();
+    }
+    else if (info.getJPEGProcess8Bit() != 0) {
+        register_jpeg();
+    }
+    // Other syntaxes (JPEG 2000, video) have no decoder; DCMTK reports that
+}
+
+void register_all_decoders() {
+    register_rle();
+    register_jpeg();
+    register_jpeg_ls();
+}
+
+DictionaryPreload::DictionaryPreload() {
+    thread_ = std::thread([]() {
+        // The first query loads the dictionary under its write lock
+        if (!dcmDataDict.isDictionaryLoaded()) {
+            std::cout << "[DEBUG] DICOM data dictionary could not be loaded" << std::endl;
+        }
+    });
+}
+
+DictionaryPreload::~DictionaryPreload() {
+    wait();
+}
+
+void DictionaryPreload::wait() {
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <thread>
+
+class DcmDataset;
+
+// Registers the DCMTK decoders (RLE, JPEG or JPEG-LS) for the transfer
+// syntax the dataset was read in, the first time that family is needed.
+// Native syntaxes need none. Registrations last for the life of the
+// process, so no reader can unregister codecs another one is using.
+// Any thread; call before decoding pixel data.
+void ensure_decoders(const DcmDataset& dataset);
+
+// Every decoder family at once, for code that decodes arbitrary input
+void register_all_decoders();
+
+// Loads the DCMTK data dictionary on a background thread, so the work is
+// done while the window is being built rather than when the first file
+// is parsed. A thread that needs the dictionary earlier waits on DCMTK's
+// dictionary lock until it is loaded. Joined on destruction.
+class DictionaryPreload {
+public:
+    DictionaryPreload();
+    ~DictionaryPreload();
+
+    DictionaryPreload(const DictionaryPreload&) = delete;
+    DictionaryPreload& operator=(const DictionaryPreload&) = delete;
+
+    // Blocks until the dictionary is loaded
+    void wait();
+
+private:
+    std::thread thread_;
+};
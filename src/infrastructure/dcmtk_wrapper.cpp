@@ -1,53 +1,110 @@
 #include "dcmtk_wrapper.hpp"
+#include "core/color_convert.hpp"
+#include "codec_registry.hpp"
+#include "frame_decoder.hpp"
+#include "memory_usage.hpp"
+#include "overlay_reader.hpp"
+#include "preview_reader.hpp"
+#include "tiled_reader.hpp"
 
 // DCMTK includes
-#include <dcmtk/dcmdata/dcrledrg.h>
 #include <dcmtk/dcmdata/dctk.h>
 #include <dcmtk/dcmimage/diregist.h>
 #include <dcmtk/dcmimgle/dcmimage.h>
 #include <dcmtk/dcmimgle/diutils.h>
 #include <dcmtk/dcmjpeg/dipijpeg.h>
-#include <dcmtk/dcmjpeg/djdecode.h>
-#include <dcmtk/dcmjpls/djdecode.h>
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
 #include <cstring>
 #include <iostream>
+#include <mutex>
 
 class DcmtkReader::Impl {
 public:
-    Impl() {
-        DcmRLEDecoderRegistration::registerCodecs();
-        DJDecoderRegistration::registerCodecs(EDC_photometricInterpretation,
-            EUC_default, EPC_default, OFTrue);
-        DJLSDecoderRegistration::registerCodecs();
-    }
-
-    ~Impl() {
-        DJLSDecoderRegistration::cleanup();
-        DJDecoderRegistration::cleanup();
-        DcmRLEDecoderRegistration::cleanup();
-    }
+    // Loads may run on a background thread while the UI swaps the cache
+    std::shared_ptr<PixelCache> pixel_cache_;
+    std::mutex pixel_cache_mutex_;
+    std::atomic<bool> tiled_layout_{ false };
+    FrameDecodeScheduler frame_decoder_{ ThreadPool::shared() };
 
     Result<DicomImageData, ErrorInfo>
         load_image_impl(const std::filesystem::path& path) noexcept {
-        DicomImageData di_image;
-        OFCondition status;
+        DcmFileFormat file_format;
+        OFCondition status = file_format.loadFile(path.string().c_str());
+
+        if (status.bad()) {
+            return ErrorInfo{ DicomError::InvalidFormat, "Failed to load DICOM file",
+                             status.text() };
+        }
+
+        return decode_image(path, file_format);
+    }
 
+    // Metadata and pixels from a single parse of the file
+    Result<std::pair<DicomImageData, DicomMetadata>, ErrorInfo>
+        load_complete_impl(const std::filesystem::path& path) noexcept {
         DcmFileFormat file_format;
-        status = file_format.loadFile(path.string().c_str());
+        OFCondition status = file_format.loadFile(path.string().c_str());
 
         if (status.bad()) {
             return ErrorInfo{ DicomError::InvalidFormat, "Failed to load DICOM file",
                              status.text() };
         }
 
+        return decode_complete_impl(path, file_format);
+    }
+
+    Result<std::pair<DicomImageData, DicomMetadata>, ErrorInfo>
+        decode_complete_impl(const std::filesystem::path& path, DcmFileFormat& file_format) noexcept {
+        DcmDataset* dataset = file_format.getDataset();
+        if (!dataset) {
+            return ErrorInfo{ DicomError::InvalidMetadata, "No dataset found", "" };
+        }
+
+        // Read the tags before decoding, which may detach the pixel data
+        DicomMetadata metadata = extract_metadata(dataset);
+
+        auto image = decode_image(path, file_format);
+        if (image.is_error()) {
+            return image.error();
+        }
+
+        return std::make_pair(std::move(image.value()), std::move(metadata));
+    }
+
+    // Decode the pixel data and log the resident growth next to the finished
+    // image. No peak: it is process-wide and loads run concurrently.
+    Result<DicomImageData, ErrorInfo>
+        decode_image(const std::filesystem::path& path, DcmFileFormat& file_format) noexcept {
+        const MemoryUsage before = current_memory_usage();
+
+        auto result = decode_pixels(path, file_format);
+
+        if (result.is_ok()) {
+            const MemoryUsage after = current_memory_usage();
+            const double mb = 1024.0 * 1024.0;
+            const double image_mb = result.value().data().pixels.size_bytes() / mb;
+            std::cout << "[DEBUG] Memory: image " << image_mb << " MB, resident +"
+                << (static_cast<double>(after.resident_bytes) - static_cast<double>(before.resident_bytes)) / mb
+                << " MB, page faults +" << after.minor_page_faults - before.minor_page_faults << std::endl;
+        }
+
+        return result;
+    }
+
+    Result<DicomImageData, ErrorInfo>
+        decode_pixels(const std::filesystem::path& path, DcmFileFormat& file_format) noexcept {
+        DicomImageData di_image;
+
         DcmDataset* dataset = file_format.getDataset();
         if (!dataset) {
             return ErrorInfo{ DicomError::InvalidFormat,
                              "No dataset found in DICOM file", "" };
         }
+        ensure_decoders(*dataset);
 
         OFString photometric_str;
         dataset->findAndGetOFString(DCM_PhotometricInterpretation, photometric_str);
@@ -59,12 +116,41 @@ public:
         else if (photometric_str == "MONOCHROME2") {
             photometric = PhotometricInterpretation::Monochrome2;
         }
-        else if (photometric_str == "RGB") {
+        else if (photometric_str == "RGB" || photometric_str.compare(0, 4, "YBR_") == 0) {
             photometric = PhotometricInterpretation::RGB;
         }
+        else if (photometric_str == "PALETTE COLOR") {
+            photometric = PhotometricInterpretation::PaletteColor;
+        }
+
+        // Decoded frames of compressed grayscale images may come from the disk cache
+        std::shared_ptr<PixelCache> pixel_cache = current_pixel_cache();
+        std::optional<PixelCacheKey> cache_key;
+        if (pixel_cache &&
+            (photometric == PhotometricInterpretation::Monochrome1 ||
+                photometric == PhotometricInterpretation::Monochrome2) &&
+            DcmXfer(dataset->getOriginalXfer()).isPixelDataCompressed()) {
+            OFString sop_instance_uid;
+            if (dataset->findAndGetOFString(DCM_SOPInstanceUID, sop_instance_uid).good() &&
+                !sop_instance_uid.empty()) {
+                cache_key = PixelCacheKey{ sop_instance_uid.c_str(), 0,
+                                           PixelCache::fingerprint(path) };
+
+                auto start = std::chrono::steady_clock::now();
+                if (auto cached = pixel_cache->lookup(*cache_key)) {
+                    auto elapsed = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - start).count();
+                    std::cout << "[DEBUG] Pixel cache hit in " << elapsed << " ms" << std::endl;
+                    cached->overlays = load_overlays(*dataset);
+                    di_image.set_data(std::move(*cached));
+                    return di_image;
+                }
+            }
+        }
 
-        if (photometric == PhotometricInterpretation::RGB) {
-            auto result = load_rgb_image(dataset, file_format);
+        if (photometric == PhotometricInterpretation::RGB ||
+            photometric == PhotometricInterpretation::PaletteColor) {
+            auto result = load_color_image(dataset, file_format);
             if (result.is_error()) {
                 return result.error();
             }
@@ -72,11 +158,30 @@ public:
         }
         else if (photometric == PhotometricInterpretation::Monochrome1 ||
             photometric == PhotometricInterpretation::Monochrome2) {
+            // Tiled images are shown without overlays: reading embedded ones
+            // would pull in the whole pixel data the tiles leave on disk
+            if (auto tiled = load_tiled(path, dataset)) {
+                return std::move(*tiled);
+            }
+
+            // Before decoding, which masks embedded overlays out of the
+            // samples and may detach the pixel data
+            std::shared_ptr<const OverlayPlanes> overlays = load_overlays(*dataset);
+
             auto result = load_grayscale_image(dataset, file_format);
             if (result.is_error()) {
                 return result.error();
             }
             di_image = std::move(result.value());
+            di_image.data().overlays = std::move(overlays);
+
+            if (cache_key) {
+                di_image.ensure_statistics();
+                if (pixel_cache->store(*cache_key, di_image.data())) {
+                    std::cout << "[DEBUG] Stored decoded frame in pixel cache ("
+                        << pixel_cache->size_bytes() / (1024 * 1024) << " MB used)" << std::endl;
+                }
+            }
         }
         else {
             return ErrorInfo{ DicomError::UnsupportedPhotometricInterpretation,
@@ -105,7 +210,50 @@ public:
         return extract_metadata(dataset);
     }
 
+    // Very large native grayscale images as lazily read tiles, if enabled.
+    // std::nullopt means the regular row-major load should be used.
+    std::optional<DicomImageData> load_tiled(const std::filesystem::path& path, DcmDataset* dataset) {
+        if (!tiled_layout_) {
+            return std::nullopt;
+        }
+
+        Uint16 rows = 0, columns = 0;
+        dataset->findAndGetUint16(DCM_Rows, rows);
+        dataset->findAndGetUint16(DCM_Columns, columns);
+        if (static_cast<uint64_t>(rows) * columns < kTiledLayoutMinPixels ||
+            !DcmXfer(dataset->getOriginalXfer()).usesNativeFormat()) {
+            return std::nullopt;
+        }
+
+        auto result = load_tiled_image(path);
+        if (result.is_error()) {
+            std::cout << "[DEBUG] Tiled layout not used: " << result.error().full_message() << std::endl;
+            return std::nullopt;
+        }
+
+        DicomImageData image;
+        image.set_data(std::move(result.value()));
+        if (image.data().window_width <= 0) {
+            image.auto_window_level();
+        }
+        return image;
+    }
+
+    std::shared_ptr<PixelCache> current_pixel_cache() {
+        std::lock_guard lock(pixel_cache_mutex_);
+        return pixel_cache_;
+    }
+
 private:
+    // Overlay planes to share between the image and its frames, or none
+    static std::shared_ptr<const OverlayPlanes> load_overlays(DcmDataset& dataset) {
+        OverlayPlanes planes = read_overlays(dataset);
+        if (planes.empty()) {
+            return nullptr;
+        }
+        return std::make_shared<const OverlayPlanes>(std::move(planes));
+    }
+
     Result<DicomImageData, ErrorInfo>
         load_grayscale_image(DcmDataset* dataset,
             DcmFileFormat& file_format) noexcept {
@@ -139,127 +287,134 @@ private:
         std::cout << "[DEBUG] Rescale Slope: " << rescale_slope
             << ", Intercept: " << rescale_intercept << std::endl;
 
-        // Create DicomImage with appropriate flags
-        unsigned long flags = CIF_MayDetachPixelData;
-
-        ::DicomImage dcmtk_image(
-            static_cast<DcmObject*>(file_format.getDataset()),
-            EXS_Unknown,
-            flags);
-
-        if (dcmtk_image.getStatus() != EIS_Normal) {
-            return ErrorInfo{ DicomError::InvalidImageDimensions,
-                             "Failed to load DICOM image",
-                             ::DicomImage::getString(dcmtk_image.getStatus()) };
-        }
-
-        if (!dcmtk_image.isMonochrome()) {
-            return ErrorInfo{ DicomError::InvalidFormat, "Not a monochrome image", "" };
-        }
+        // Read the window tags now; nothing below needs the dataset again
+        Float64 file_wc = 0, file_ww = 0;
+        const bool has_window =
+            dataset->findAndGetFloat64(DCM_WindowCenter, file_wc).good() &&
+            dataset->findAndGetFloat64(DCM_WindowWidth, file_ww).good() &&
+            file_ww > 0;
 
         ImageData img_data;
-        img_data.width = dcmtk_image.getWidth();
-        img_data.height = dcmtk_image.getHeight();
-
-        if (img_data.width == 0 || img_data.height == 0) {
-            return ErrorInfo{ DicomError::InvalidImageDimensions,
-                             "Invalid image dimensions", "" };
-        }
-
         img_data.bits_allocated = bits_allocated;
         img_data.bits_stored = bits_stored;
         img_data.samples_per_pixel = samples_per_pixel;
         img_data.is_signed = is_signed;
 
-        size_t pixel_count = img_data.width * img_data.height;
+        double min_val = 0, max_val = 0;
+        double voi_wc = 0, voi_ww = 0;
+        bool has_voi_window = false;
+
+        {
+            // The DCMTK image and its intermediate pixel representation only live
+            // for this block. CIF_MayDetachPixelData lets DCMTK drop the dataset's
+            // copy of the pixel data once the intermediate has been built, so at
+            // most two full-size buffers exist at any time.
+            ::DicomImage dcmtk_image(
+                static_cast<DcmObject*>(file_format.getDataset()),
+                EXS_Unknown,
+                CIF_MayDetachPixelData);
+
+            if (dcmtk_image.getStatus() != EIS_Normal) {
+                return ErrorInfo{ DicomError::InvalidImageDimensions,
+                                 "Failed to load DICOM image",
+                                 ::DicomImage::getString(dcmtk_image.getStatus()) };
+            }
 
-        // Obtain pixel data using DCMTK internal representation
-        // DCMTK already applies rescale slope/intercept internally
-        const DiPixel* pixel_data = dcmtk_image.getInterData();
-        if (!pixel_data) {
-            return ErrorInfo{ DicomError::MissingPixelData, "No pixel data found", "" };
-        }
+            if (!dcmtk_image.isMonochrome()) {
+                return ErrorInfo{ DicomError::InvalidFormat, "Not a monochrome image", "" };
+            }
 
-        EP_Representation rep = pixel_data->getRepresentation();
-        std::cout << "[DEBUG] Internal representation: " << static_cast<int>(rep) << std::endl;
+            img_data.width = dcmtk_image.getWidth();
+            img_data.height = dcmtk_image.getHeight();
 
-        // Retrieve min/max values from internal pixel data
-        double min_val = 0, max_val = 0;
-        dcmtk_image.getMinMaxValues(min_val, max_val);
-        std::cout << "[DEBUG] DCMTK min/max values: " << min_val << " - " << max_val << std::endl;
+            if (img_data.width == 0 || img_data.height == 0) {
+                return ErrorInfo{ DicomError::InvalidImageDimensions,
+                                 "Invalid image dimensions", "" };
+            }
 
-        // Allocate buffer for normalized pixels (always use int32 internally to support signed data)
-        img_data.pixels.resize(pixel_count);
+            const size_t pixel_count = img_data.pixel_count();
 
-        // Compute effective data range
-        double data_range = max_val - min_val;
-        if (data_range < 1) data_range = 1;
+            // Obtain pixel data using DCMTK internal representation
+            // DCMTK already applies rescale slope/intercept internally
+            const DiPixel* pixel_data = dcmtk_image.getInterData();
+            if (!pixel_data) {
+                return ErrorInfo{ DicomError::MissingPixelData, "No pixel data found", "" };
+            }
+
+            EP_Representation rep = pixel_data->getRepresentation();
+            std::cout << "[DEBUG] Internal representation: " << static_cast<int>(rep) << std::endl;
 
-        // Normalize to 0-65535 (uint16) for storage
-        // Track offset for window/level calculations
-        double scale = 65535.0 / data_range;
+            // Retrieve min/max values from internal pixel data
+            dcmtk_image.getMinMaxValues(min_val, max_val);
+            std::cout << "[DEBUG] DCMTK min/max values: " << min_val << " - " << max_val << std::endl;
 
-        // Copy data based on representation
-        const void* raw_data = pixel_data->getData();
+            img_data.pixels = PixelBuffer::allocate(PixelFormat::Gray16, pixel_count);
+            uint16_t* pixels = img_data.pixels.gray16();
 
-        if (rep == EPR_Sint16 || rep == EPR_Uint16) {
-            const uint16_t* src = static_cast<const uint16_t*>(raw_data);
-            if (is_signed) {
-                const int16_t* signed_src = static_cast<const int16_t*>(raw_data);
+            // Compute effective data range
+            double data_range = max_val - min_val;
+            if (data_range < 1) data_range = 1;
+
+            // Normalize to 0-65535 (uint16) for storage, inverting MONOCHROME1 on the way
+            const double scale = 65535.0 / data_range;
+            auto normalize = [&](const auto* src) {
                 for (size_t i = 0; i < pixel_count; ++i) {
-                    double normalized = (static_cast<double>(signed_src[i]) - min_val) * scale;
-                    img_data.pixels[i] = static_cast<uint16_t>(std::clamp(normalized, 0.0, 65535.0));
+                    double normalized = std::clamp((static_cast<double>(src[i]) - min_val) * scale, 0.0, 65535.0);
+                    if (is_monochrome1) normalized = 65535.0 - normalized;
+                    pixels[i] = static_cast<uint16_t>(normalized);
                 }
-            }
-            else {
-                for (size_t i = 0; i < pixel_count; ++i) {
-                    double normalized = (static_cast<double>(src[i]) - min_val) * scale;
-                    img_data.pixels[i] = static_cast<uint16_t>(std::clamp(normalized, 0.0, 65535.0));
+            };
+
+            // Copy data based on representation
+            const void* raw_data = pixel_data->getData();
+
+            if (rep == EPR_Sint16 || rep == EPR_Uint16) {
+                if (is_signed) {
+                    normalize(static_cast<const int16_t*>(raw_data));
+                }
+                else {
+                    normalize(static_cast<const uint16_t*>(raw_data));
                 }
             }
-        }
-        else if (rep == EPR_Sint32 || rep == EPR_Uint32) {
-            const int32_t* src = static_cast<const int32_t*>(raw_data);
-            for (size_t i = 0; i < pixel_count; ++i) {
-                double normalized = (static_cast<double>(src[i]) - min_val) * scale;
-                img_data.pixels[i] = static_cast<uint16_t>(std::clamp(normalized, 0.0, 65535.0));
+            else if (rep == EPR_Sint32 || rep == EPR_Uint32) {
+                normalize(static_cast<const int32_t*>(raw_data));
             }
-        }
-        else {
-            // Fallback: use getOutputData
-            dcmtk_image.setMinMaxWindow();
-            const void* output_8 = dcmtk_image.getOutputData(8, 0, 0);
-            if (output_8) {
-                const uint8_t* src = static_cast<const uint8_t*>(output_8);
-                for (size_t i = 0; i < pixel_count; ++i) {
-                    img_data.pixels[i] = static_cast<uint16_t>(src[i]) * 257; // Scale 8-bit to 16-bit
+            else {
+                // Fallback: render 8-bit output into the front of our own buffer
+                // and widen it in place, back to front
+                dcmtk_image.setMinMaxWindow();
+                auto* bytes = reinterpret_cast<uint8_t*>(pixels);
+                if (dcmtk_image.getOutputData(bytes, static_cast<unsigned long>(pixel_count), 8, 0, 0)) {
+                    for (size_t i = pixel_count; i-- > 0;) {
+                        uint16_t value = static_cast<uint16_t>(bytes[i]) * 257; // Scale 8-bit to 16-bit
+                        pixels[i] = is_monochrome1 ? 65535 - value : value;
+                    }
+                }
+                else {
+                    std::fill(pixels, pixels + pixel_count, uint16_t{ 0 });
                 }
             }
-        }
 
-        // Invert MONOCHROME1 images
-        if (is_monochrome1) {
-            std::cout << "[DEBUG] Inverting MONOCHROME1 pixels" << std::endl;
-            for (auto& pixel : img_data.pixels) {
-                pixel = 65535 - pixel;
+            if (is_monochrome1) {
+                std::cout << "[DEBUG] Inverted MONOCHROME1 pixels" << std::endl;
             }
+
+            has_voi_window = dcmtk_image.getWindow(voi_wc, voi_ww) && voi_ww > 0;
         }
 
-        uint16_t min_pix = *std::min_element(img_data.pixels.begin(), img_data.pixels.end());
-        uint16_t max_pix = *std::max_element(img_data.pixels.begin(), img_data.pixels.end());
-        std::cout << "[DEBUG] Final pixel range: " << min_pix << " - " << max_pix << std::endl;
+        double data_range = max_val - min_val;
+        if (data_range < 1) data_range = 1;
+        const double scale = 65535.0 / data_range;
+
+        img_data.statistics = compute_pixel_statistics(img_data.pixels.gray16(), img_data.pixels.pixel_count());
+        std::cout << "[DEBUG] Final pixel range: " << img_data.statistics->min_value
+            << " - " << img_data.statistics->max_value << std::endl;
 
-        img_data.is_preprocessed = false;
         img_data.photometric = PhotometricInterpretation::Monochrome2;
+        img_data.modality = ModalityMapping::from_normalization(min_val, scale, is_monochrome1);
 
         // Extract window/level from DICOM tags
-        Float64 file_wc = 0, file_ww = 0;
-        bool has_window = false;
-
-        if (dataset->findAndGetFloat64(DCM_WindowCenter, file_wc).good() &&
-            dataset->findAndGetFloat64(DCM_WindowWidth, file_ww).good() &&
-            file_ww > 0) {
-            has_window = true;
+        if (has_window) {
             std::cout << "[DEBUG] Window from DICOM tags (original): Center=" << file_wc
                 << ", Width=" << file_ww << std::endl;
 
@@ -278,57 +433,204 @@ private:
                 << ", Width=" << img_data.window_width << std::endl;
         }
 
-        // If no window/level is present, try DCMTK VOI LUT or compute automatically
-        if (!has_window || img_data.window_width <= 0) {
-            double wc = 0, ww = 0;
+        DicomImageData result;
+        result.set_data(std::move(img_data));
+        ImageData& data = result.data();
 
-            // Try DCMTK VOI LUT
-            if (dcmtk_image.getWindow(wc, ww) && ww > 0) {
-                double normalized_wc = (wc - min_val) * scale;
-                double normalized_ww = ww * scale;
+        // If no window/level is present, try DCMTK VOI LUT or compute automatically
+        if (!has_window || data.window_width <= 0) {
+            if (has_voi_window) {
+                double normalized_wc = (voi_wc - min_val) * scale;
+                double normalized_ww = voi_ww * scale;
 
-                img_data.window_center = static_cast<int32_t>(normalized_wc);
-                img_data.window_width = static_cast<int32_t>(normalized_ww);
+                data.window_center = static_cast<int32_t>(normalized_wc);
+                data.window_width = static_cast<int32_t>(normalized_ww);
 
                 if (is_monochrome1) {
-                    img_data.window_center = 65535 - img_data.window_center;
+                    data.window_center = 65535 - data.window_center;
                 }
 
-                std::cout << "[DEBUG] Window from DCMTK VOI: Center=" << img_data.window_center
-                    << ", Width=" << img_data.window_width << std::endl;
+                std::cout << "[DEBUG] Window from DCMTK VOI: Center=" << data.window_center
+                    << ", Width=" << data.window_width << std::endl;
             }
             else {
-                // Automatically compute window/level based on histogram
-                DicomImageData temp_img;
-                temp_img.set_data(img_data);
-                temp_img.auto_window_level();
-                img_data = temp_img.data();
-                std::cout << "[DEBUG] Auto-calculated window: Center=" << img_data.window_center
-                    << ", Width=" << img_data.window_width << std::endl;
+                // Automatically compute window/level based on histogram, in place
+                result.auto_window_level();
+                std::cout << "[DEBUG] Auto-calculated window: Center=" << data.window_center
+                    << ", Width=" << data.window_width << std::endl;
             }
         }
 
         // Ensure reasonable minimum values
-        if (img_data.window_width < 1) {
-            img_data.window_width = 1;
+        if (data.window_width < 1) {
+            data.window_width = 1;
+        }
+
+        return result;
+    }
+
+    // Color images become interleaved 8-bit RGB through our own conversion
+    // kernels. Compressed data is decompressed first (JPEG decoding turns YBR
+    // into RGB on the way); layouts the kernels do not cover, such as 16-bit
+    // samples, go through DCMTK's renderer. Multi-frame objects show frame 1.
+    Result<DicomImageData, ErrorInfo>
+        load_color_image(DcmDataset* dataset, DcmFileFormat& file_format) noexcept {
+        if (DcmXfer(dataset->getOriginalXfer()).isPixelDataCompressed()) {
+            OFCondition status = dataset->chooseRepresentation(EXS_LittleEndianExplicit, nullptr);
+            if (status.bad()) {
+                return ErrorInfo{ DicomError::UnsupportedTransferSyntax,
+                                 "Failed to decompress color image", status.text() };
+            }
         }
 
+        OFString photometric;
+        Uint16 rows = 0, columns = 0, samples_per_pixel = 0, bits_allocated = 0, planar = 0;
+        dataset->findAndGetOFString(DCM_PhotometricInterpretation, photometric);
+        dataset->findAndGetUint16(DCM_Rows, rows);
+        dataset->findAndGetUint16(DCM_Columns, columns);
+        dataset->findAndGetUint16(DCM_SamplesPerPixel, samples_per_pixel);
+        dataset->findAndGetUint16(DCM_BitsAllocated, bits_allocated);
+        dataset->findAndGetUint16(DCM_PlanarConfiguration, planar);
+
+        ImageData img_data;
+        img_data.width = columns;
+        img_data.height = rows;
+        img_data.bits_allocated = 8;
+        img_data.bits_stored = 8;
+        img_data.samples_per_pixel = 3;
+        img_data.photometric = PhotometricInterpretation::RGB;
+        const size_t count = img_data.pixel_count();
+        if (count == 0) {
+            return ErrorInfo{ DicomError::InvalidImageDimensions, "Image has no pixels", "" };
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        if (photometric == "PALETTE COLOR") {
+            if (samples_per_pixel != 1 || (bits_allocated != 8 && bits_allocated != 16)) {
+                return ErrorInfo{ DicomError::InvalidImageDimensions, "Unsupported palette color layout", "" };
+            }
+            auto red = read_palette_channel(dataset, DCM_RedPaletteColorLookupTableDescriptor,
+                DCM_RedPaletteColorLookupTableData, DCM_SegmentedRedPaletteColorLookupTableData);
+            auto green = read_palette_channel(dataset, DCM_GreenPaletteColorLookupTableDescriptor,
+                DCM_GreenPaletteColorLookupTableData, DCM_SegmentedGreenPaletteColorLookupTableData);
+            auto blue = read_palette_channel(dataset, DCM_BluePaletteColorLookupTableDescriptor,
+                DCM_BluePaletteColorLookupTableData, DCM_SegmentedBluePaletteColorLookupTableData);
+            if (!red || !green || !blue) {
+                return ErrorInfo{ DicomError::InvalidMetadata, "Missing or invalid palette color lookup tables", "" };
+            }
+            const std::vector<uint32_t> lut = build_palette_lut(*red, *green, *blue, bits_allocated);
+
+            img_data.pixels = PixelBuffer::allocate(PixelFormat::Rgb8, count);
+            if (bits_allocated == 8) {
+                const Uint8* indices = nullptr;
+                unsigned long length = 0;
+                if (dataset->findAndGetUint8Array(DCM_PixelData, indices, &length).bad() || !indices || length < count) {
+                    return ErrorInfo{ DicomError::MissingPixelData, "No pixel data found", "" };
+                }
+                apply_palette(indices, lut, count, img_data.pixels.rgb8());
+            }
+            else {
+                const Uint16* indices = nullptr;
+                unsigned long length = 0;
+                if (dataset->findAndGetUint16Array(DCM_PixelData, indices, &length).bad() || !indices || length < count) {
+                    return ErrorInfo{ DicomError::MissingPixelData, "No pixel data found", "" };
+                }
+                apply_palette(indices, lut, count, img_data.pixels.rgb8());
+            }
+        }
+        else {
+            ColorModel model = ColorModel::Rgb;
+            if (photometric == "YBR_FULL") model = ColorModel::YbrFull;
+            else if (photometric == "YBR_FULL_422") model = ColorModel::YbrFull422;
+            else if (photometric == "YBR_RCT") model = ColorModel::YbrRct;
+            else if (photometric == "YBR_ICT") model = ColorModel::YbrIct;
+            else if (photometric != "RGB") {
+                return load_color_image_dcmtk(file_format);
+            }
+            if (samples_per_pixel != 3 || bits_allocated != 8) {
+                return load_color_image_dcmtk(file_format);
+            }
+
+            const Uint8* samples = nullptr;
+            unsigned long length = 0;
+            const size_t needed = model == ColorModel::YbrFull422 ? count * 2 : count * 3;
+            if (dataset->findAndGetUint8Array(DCM_PixelData, samples, &length).bad() || !samples || length < needed) {
+                return ErrorInfo{ DicomError::MissingPixelData, "No pixel data found", "" };
+            }
+
+            img_data.pixels = PixelBuffer::allocate(PixelFormat::Rgb8, count);
+            if (model == ColorModel::Rgb && planar == 0) {
+                // Already in display layout
+                std::memcpy(img_data.pixels.rgb8(), samples, count * 3);
+            }
+            else {
+                convert_to_rgb(model, samples, planar == 1, count, img_data.pixels.rgb8());
+            }
+        }
+
+        std::cout << "[DEBUG] " << photometric.c_str() << " to RGB"
+            << (planar == 1 ? " (planar)" : "") << " in "
+            << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()
+            << " ms" << std::endl;
+
+        img_data.window_center = 128;
+        img_data.window_width = 256;
+        img_data.original_window_center = img_data.window_center;
+        img_data.original_window_width = img_data.window_width;
+
         DicomImageData result;
         result.set_data(std::move(img_data));
+        return result;
+    }
 
+    // One channel of a palette from its descriptor and plain or segmented data
+    std::optional<PaletteChannel>
+        read_palette_channel(DcmDataset* dataset, const DcmTagKey& descriptor_tag,
+            const DcmTagKey& data_tag, const DcmTagKey& segmented_tag) noexcept {
+        // The descriptor may be US or SS
+        Uint16 descriptor[3];
+        for (unsigned long i = 0; i < 3; ++i) {
+            Sint16 signed_value = 0;
+            if (dataset->findAndGetUint16(descriptor_tag, descriptor[i], i).good()) continue;
+            if (dataset->findAndGetSint16(descriptor_tag, signed_value, i).bad()) return std::nullopt;
+            descriptor[i] = static_cast<Uint16>(signed_value);
+        }
+
+        PaletteChannel channel;
+        channel.count = descriptor[0] == 0 ? 65536 : descriptor[0];
+        channel.first_mapped = descriptor[1];
+        channel.bits = descriptor[2];
+
+        const Uint16* words = nullptr;
+        unsigned long word_count = 0;
+        if (dataset->findAndGetUint16Array(data_tag, words, &word_count).good() && words && word_count > 0) {
+            if (channel.bits <= 8 && word_count < channel.count && word_count * 2 >= channel.count) {
+                // Two 8-bit entries per word, low byte first
+                for (uint32_t i = 0; i < channel.count; ++i) {
+                    channel.entries.push_back((words[i / 2] >> (8 * (i & 1))) & 0xFF);
+                }
+            }
+            else {
+                channel.entries.assign(words, words + std::min<unsigned long>(word_count, channel.count));
+            }
+        }
+        else if (dataset->findAndGetUint16Array(segmented_tag, words, &word_count).good() && words) {
+            channel.entries = expand_segmented_lut(words, word_count, channel.count);
+        }
 
-        return result;
+        if (channel.entries.empty()) return std::nullopt;
+        return channel;
     }
 
+    // DCMTK's generic color rendering
     Result<DicomImageData, ErrorInfo>
-        load_rgb_image(DcmDataset* /*dataset*/,
-            DcmFileFormat& file_format) noexcept {
+        load_color_image_dcmtk(DcmFileFormat& file_format) noexcept {
         ::DicomImage dcmtk_image(static_cast<DcmObject*>(file_format.getDataset()),
             EXS_Unknown, CIF_MayDetachPixelData);
 
         if (dcmtk_image.getStatus() != EIS_Normal) {
             return ErrorInfo{ DicomError::InvalidImageDimensions,
-                             "Failed to load RGB DICOM image",
+                             "Failed to load color DICOM image",
                              ::DicomImage::getString(dcmtk_image.getStatus()) };
         }
 
@@ -338,17 +640,14 @@ private:
         img_data.photometric = PhotometricInterpretation::RGB;
         img_data.samples_per_pixel = 3;
 
-        const void* rgb_data = dcmtk_image.getOutputData(8);
-        if (!rgb_data) {
+        // Render straight into our buffer instead of DCMTK's own output buffer
+        img_data.pixels = PixelBuffer::allocate(PixelFormat::Rgb8, img_data.pixel_count());
+        if (!dcmtk_image.getOutputData(img_data.pixels.rgb8(),
+                static_cast<unsigned long>(img_data.pixels.size_bytes()), 8)) {
             return ErrorInfo{ DicomError::MissingPixelData,
                              "Failed to get RGB pixel data", "" };
         }
 
-        size_t rgb_size = img_data.width * img_data.height * 3;
-        img_data.rgb_pixels.resize(rgb_size);
-
-        std::memcpy(img_data.rgb_pixels.data(), rgb_data, rgb_size);
-
         img_data.original_window_center = img_data.window_center;
         img_data.original_window_width = img_data.window_width;
 
@@ -372,6 +671,18 @@ private:
         }
     }
 
+    // True when the element holds at least count numeric values
+    bool find_float64_values(DcmDataset* dataset, const DcmTagKey& tag, double* values, size_t count) noexcept {
+        for (size_t i = 0; i < count; ++i) {
+            Float64 value = 0;
+            if (dataset->findAndGetFloat64(tag, value, static_cast<unsigned long>(i)).bad()) {
+                return false;
+            }
+            values[i] = value;
+        }
+        return true;
+    }
+
     DicomMetadata extract_metadata(DcmDataset* dataset) noexcept {
         DicomMetadata meta;
         OFString str_value;
@@ -467,6 +778,9 @@ private:
         if (dataset->findAndGetUint16(DCM_SamplesPerPixel, uint16_value).good()) {
             meta.samples_per_pixel = uint16_value;
         }
+        if (dataset->findAndGetUint16(DCM_PixelRepresentation, uint16_value).good()) {
+            meta.pixel_representation = uint16_value;
+        }
         if (dataset->findAndGetOFString(DCM_PhotometricInterpretation, str_value).good()) {
             meta.photometric_interpretation = str_value.c_str();
         }
@@ -476,6 +790,38 @@ private:
         if (dataset->findAndGetFloat64(DCM_SliceThickness, float_value).good()) {
             meta.slice_thickness = float_value;
         }
+        if (dataset->findAndGetSint32(DCM_NumberOfFrames, sint32_value).good()) {
+            meta.number_of_frames = sint32_value;
+        }
+        if (dataset->findAndGetFloat64(DCM_RescaleSlope, float_value).good()) {
+            meta.rescale_slope = float_value;
+        }
+        if (dataset->findAndGetFloat64(DCM_RescaleIntercept, float_value).good()) {
+            meta.rescale_intercept = float_value;
+        }
+        if (dataset->findAndGetFloat64(DCM_FrameTime, float_value).good() && float_value > 0) {
+            meta.frame_time_ms = float_value;
+        }
+        if (dataset->findAndGetSint32(DCM_RecommendedDisplayFrameRate, sint32_value).good() && sint32_value > 0) {
+            meta.recommended_frame_rate = sint32_value;
+        }
+        if (dataset->findAndGetSint32(DCM_CineRate, sint32_value).good() && sint32_value > 0) {
+            meta.cine_rate = sint32_value;
+        }
+
+        // Geometry
+        std::array<double, 3> position{};
+        if (find_float64_values(dataset, DCM_ImagePositionPatient, position.data(), position.size())) {
+            meta.image_position = position;
+        }
+        std::array<double, 6> orientation{};
+        if (find_float64_values(dataset, DCM_ImageOrientationPatient, orientation.data(), orientation.size())) {
+            meta.image_orientation = orientation;
+        }
+        std::array<double, 2> spacing{};
+        if (find_float64_values(dataset, DCM_PixelSpacing, spacing.data(), spacing.size())) {
+            meta.pixel_spacing_mm = spacing;
+        }
 
         // Window/Level
         if (dataset->findAndGetSint32(DCM_WindowCenter, sint32_value).good()) {
@@ -508,18 +854,45 @@ DcmtkReader::load_metadata(const std::filesystem::path& path) {
     return impl_->load_metadata_impl(path);
 }
 
-Result<std::pair<DicomImageData, DicomMetadata>, ErrorInfo>
-DcmtkReader::load_complete(const std::filesystem::path& path) {
-    auto img_result = load_image(path);
-    if (img_result.is_error()) {
-        return img_result.error();
-    }
+Result<FrameSet, ErrorInfo>
+DcmtkReader::load_frames(const std::filesystem::path& path) {
+    std::shared_ptr<PixelCache> pixel_cache = impl_->current_pixel_cache();
+    return impl_->frame_decoder_.decode(path, nullptr, pixel_cache.get());
+}
+
+Result<ImagePreview, ErrorInfo>
+DcmtkReader::load_preview(const std::filesystem::path& path, uint32_t max_dimension) {
+    return load_image_preview(path, max_dimension);
+}
+
+Result<LoadedThumbnail, ErrorInfo>
+DcmtkReader::load_thumbnail(const std::filesystem::path& path, uint32_t max_dimension, ThumbnailCache* cache) {
+    return ::load_thumbnail(path, max_dimension, cache,
+        [this](const std::filesystem::path& file, DcmFileFormat& file_format) {
+            return impl_->decode_image(file, file_format);
+        });
+}
 
-    auto meta_result = load_metadata(path);
-    if (meta_result.is_error()) {
-        return meta_result.error();
+void DcmtkReader::set_pixel_cache(std::optional<PixelCacheConfig> config) {
+    std::shared_ptr<PixelCache> cache;
+    if (config) {
+        cache = std::make_shared<PixelCache>(std::move(*config));
     }
 
-    return std::make_pair(std::move(img_result.value()),
-        std::move(meta_result.value()));
+    std::lock_guard lock(impl_->pixel_cache_mutex_);
+    impl_->pixel_cache_ = std::move(cache);
+}
+
+void DcmtkReader::set_tiled_layout(bool enabled) {
+    impl_->tiled_layout_ = enabled;
+}
+
+Result<std::pair<DicomImageData, DicomMetadata>, ErrorInfo>
+DcmtkReader::load_complete(const std::filesystem::path& path) {
+    return impl_->load_complete_impl(path);
+}
+
+Result<std::pair<DicomImageData, DicomMetadata>, ErrorInfo>
+DcmtkReader::decode_complete(const std::filesystem::path& path, DcmFileFormat& file_format) {
+    return impl_->decode_complete_impl(path, file_format);
 }
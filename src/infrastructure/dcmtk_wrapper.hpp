@@ -4,8 +4,14 @@
 #include "core/error_codes.hpp"
 #include "core/dicom_image.hpp"
 #include "core/dicom_metadata.hpp"
+#include "core/frame_set.hpp"
+#include "pixel_cache.hpp"
+#include "preview_reader.hpp"
 #include <filesystem>
 #include <memory>
+#include <optional>
+
+class DcmFileFormat;
 
 class IDicomReader {
 public:
@@ -20,6 +26,29 @@ public:
     // Load both image and metadata together
     virtual Result<std::pair<DicomImageData, DicomMetadata>, ErrorInfo>
         load_complete(const std::filesystem::path& path) = 0;
+
+    // Same as load_complete for a dataset that is already in memory, e.g. one
+    // just received over the network; path is where it was stored
+    virtual Result<std::pair<DicomImageData, DicomMetadata>, ErrorInfo>
+        decode_complete(const std::filesystem::path& path, DcmFileFormat& file_format) = 0;
+
+    // Decode every frame of a multi-frame object in parallel
+    virtual Result<FrameSet, ErrorInfo>
+        load_frames(const std::filesystem::path& path) = 0;
+    
+    // Coarse preview for first paint, cheaper than a full decode
+    virtual Result<ImagePreview, ErrorInfo>
+        load_preview(const std::filesystem::path& path, uint32_t max_dimension) = 0;
+    
+    // Windowed thumbnail for browsing, from the cache when it has one
+    virtual Result<LoadedThumbnail, ErrorInfo>
+        load_thumbnail(const std::filesystem::path& path, uint32_t max_dimension, ThumbnailCache* cache) = 0;
+    
+    // Opt-in persistent cache of decoded frames (std::nullopt disables it)
+    virtual void set_pixel_cache(std::optional<PixelCacheConfig> config) = 0;
+    
+    // Opt-in tiled, lazily read layout for very large native grayscale images
+    virtual void set_tiled_layout(bool enabled) = 0;
 };
 
 class DcmtkReader : public IDicomReader {
@@ -45,4 +74,20 @@ public:
     
     Result<std::pair<DicomImageData, DicomMetadata>, ErrorInfo>
         load_complete(const std::filesystem::path& path) override;
+
+    Result<std::pair<DicomImageData, DicomMetadata>, ErrorInfo>
+        decode_complete(const std::filesystem::path& path, DcmFileFormat& file_format) override;
+
+    Result<FrameSet, ErrorInfo>
+        load_frames(const std::filesystem::path& path) override;
+    
+    Result<ImagePreview, ErrorInfo>
+        load_preview(const std::filesystem::path& path, uint32_t max_dimension) override;
+    
+    Result<LoadedThumbnail, ErrorInfo>
+        load_thumbnail(const std::filesystem::path& path, uint32_t max_dimension, ThumbnailCache* cache) override;
+    
+    void set_pixel_cache(std::optional<PixelCacheConfig> config) override;
+    
+    void set_tiled_layout(bool enabled) override;
 };
\ No newline at end of file
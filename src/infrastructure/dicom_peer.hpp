@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Remote application entity an SCU opens associations with
+struct DicomPeer {
+    std::string host = "localhost";
+    uint16_t port = 11112;
+    std::string called_ae_title = "DICOMVIEWER";
+    std::string calling_ae_title = "DICOMVIEWER_SCU";
+};
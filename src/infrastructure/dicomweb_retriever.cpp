@@ -0,0 +1,298 @@
+#include "dicomweb_retriever.hpp"
+#include "http_client.hpp"
+
+// DCMTK includes
+#include <dcmtk/dcmdata/dctk.h>
+#include <dcmtk/dcmdata/dcistrmb.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <optional>
+#include <stdexcept>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Instances as stored, whatever their transfer syntax
+const char* const kInstancesAccept = "multipart/related; type=\"application/dicom\"; transfer-syntax=*";
+const char* const kFramesAccept = "multipart/related; type=\"application/octet-stream\"";
+
+// Declared frame lengths come from the server and are only a hint: a frame
+// buffer is reserved up to this size and otherwise grows with the data
+constexpr size_t kMaxFrameReserve = 64 * 1024 * 1024;
+
+double ms_since(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+bool has_media_type(const std::string& content_type, const std::string& media_type) {
+    std::string lower = content_type;
+    for (char& c : lower) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return lower.rfind(media_type, 0) == 0;
+}
+
+} // namespace
+
+// One part being read: the DCMTK stream consumes each piece as it is fed
+// and keeps only an unfinished element header between pieces
+class DicomMultipartReader::Part {
+public:
+    std::shared_ptr<DcmFileFormat> file_format = std::make_shared<DcmFileFormat>();
+    std::string error;
+
+    Part() {
+        file_format->transferInit();
+    }
+
+    void read(const char* data, size_t size) {
+        if (!error.empty()) {
+            return;
+        }
+        stream_.setBuffer(data, static_cast<offile_off_t>(size));
+        const OFCondition cond = file_format->read(stream_, EXS_Unknown, EGL_noChange, DCM_MaxReadLength);
+        stream_.releaseBuffer();
+        if (cond.bad() && cond != EC_StreamNotifyClient) {
+            error = cond.text();
+        }
+    }
+
+    // The part's bytes are all in; false if they did not make a whole object
+    bool finish() {
+        if (error.empty()) {
+            stream_.setEos();
+            const OFCondition cond = file_format->read(stream_, EXS_Unknown, EGL_noChange, DCM_MaxReadLength);
+            if (cond.bad() && cond != EC_EndOfStream) {
+                error = cond == EC_StreamNotifyClient ? "object truncated" : cond.text();
+            }
+        }
+        file_format->transferEnd();
+        return error.empty();
+    }
+
+private:
+    DcmInputBufferStream stream_;
+};
+
+DicomMultipartReader::DicomMultipartReader(InstanceIngest& ingest, const std::string& boundary)
+    : ingest_(ingest)
+    , parser_(boundary, MultipartParser::Handler{
+          [this](const MultipartHeaders& headers) { return begin_part(headers); },
+          [this](const char* data, size_t size) { part_->read(data, size); return true; },
+          [this]() { end_part(); return true; } }) {
+}
+
+DicomMultipartReader::~DicomMultipartReader() = default;
+
+Result<bool, ErrorInfo> DicomMultipartReader::feed(const char* data, size_t size) {
+    return parser_.feed(data, size);
+}
+
+bool DicomMultipartReader::begin_part(const MultipartHeaders& headers) {
+    part_ = std::make_unique<Part>();
+    const std::string content_type = headers.get("content-type");
+    if (!content_type.empty() && !has_media_type(content_type, "application/dicom")) {
+        part_->error = "unexpected part type " + content_type;
+    }
+    return true;
+}
+
+void DicomMultipartReader::end_part() {
+    std::unique_ptr<Part> part = std::move(part_);
+    if (!part->finish()) {
+        std::cout << "[DEBUG] DICOMweb part " << parser_.parts() << " unreadable: " << part->error << std::endl;
+        ingest_.count_failure();
+        ++failed_;
+        return;
+    }
+    // Rejections are counted by the ingest
+    auto result = ingest_.ingest(std::move(part->file_format));
+    if (result.is_ok()) {
+        ++instances_;
+    }
+    else {
+        std::cout << "[DEBUG] DICOMweb instance rejected: " << result.error().full_message() << std::endl;
+        ++failed_;
+    }
+}
+
+Result<DicomWebStats, ErrorInfo> DicomWebRetriever::retrieve(const std::string& url) {
+    const auto start = Clock::now();
+    DicomWebStats stats;
+
+    auto parsed = parse_http_url(url);
+    if (parsed.is_error()) {
+        return parsed.error();
+    }
+
+    std::unique_ptr<DicomMultipartReader> reader;
+    std::optional<ErrorInfo> error;
+    auto response = http_get(parsed.value(), kInstancesAccept,
+        [&](const HttpResponse& response) {
+            auto type = parse_multipart_content_type(response.content_type);
+            if (!type) {
+                error = ErrorInfo{ DicomError::NetworkError, "DICOMweb response is not multipart",
+                                   response.content_type };
+                return false;
+            }
+            reader = std::make_unique<DicomMultipartReader>(ingest_, type->boundary);
+            return true;
+        },
+        [&](const char* data, size_t size) {
+            if (cancelled_) {
+                return false;
+            }
+            stats.bytes += size;
+            auto fed = reader->feed(data, size);
+            if (fed.is_error()) {
+                error = fed.error();
+                return false;
+            }
+            if (stats.first_part_ms < 0.0 && reader->instances() > 0) {
+                stats.first_part_ms = ms_since(start);
+            }
+            return true;
+        });
+    if (response.is_error()) {
+        return response.error();
+    }
+    if (error) {
+        return *error;
+    }
+
+    stats.received = reader->instances();
+    stats.failed = reader->failed();
+    stats.cancelled = cancelled_;
+    stats.total_ms = ms_since(start);
+    if (!stats.cancelled && !reader->finished()) {
+        return ErrorInfo{ DicomError::NetworkError, "DICOMweb response ended early",
+                         std::to_string(stats.received) + " instances received from " + url };
+    }
+    std::cout << "[DEBUG] WADO-RS retrieved " << stats.received << " instances, " << stats.bytes
+        << " bytes in " << stats.total_ms << " ms" << std::endl;
+    return stats;
+}
+
+std::string dicomweb_series_url(const std::string& service_url, const std::string& study_instance_uid,
+    const std::string& series_instance_uid) {
+    std::string url = service_url;
+    while (!url.empty() && url.back() == '/') {
+        url.pop_back();
+    }
+    return url + "/studies/" + study_instance_uid + "/series/" + series_instance_uid;
+}
+
+Result<DicomWebStats, ErrorInfo> retrieve_frames(const std::string& instance_url,
+    const std::vector<uint32_t>& frame_numbers, const FrameHandler& on_frame) {
+    const auto start = Clock::now();
+    DicomWebStats stats;
+    if (frame_numbers.empty()) {
+        return stats;
+    }
+
+    std::string url = instance_url + "/frames/";
+    for (size_t i = 0; i < frame_numbers.size(); ++i) {
+        url += (i == 0 ? "" : ",") + std::to_string(frame_numbers[i]);
+    }
+    auto parsed = parse_http_url(url);
+    if (parsed.is_error()) {
+        return parsed.error();
+    }
+
+    // A part's bytes are gathered into the buffer the handler is given
+    std::vector<uint8_t> frame;
+    bool stopped = false;
+    std::optional<ErrorInfo> error;
+    auto deliver = [&]() {
+        if (stats.received + stats.failed >= frame_numbers.size()) {
+            ++stats.failed;
+            return true;
+        }
+        if (stats.received == 0) {
+            stats.first_part_ms = ms_since(start);
+        }
+        const uint32_t number = frame_numbers[stats.received++];
+        stopped = !on_frame(number, std::move(frame));
+        frame = {};
+        return !stopped;
+    };
+    // A frame that does not fit in memory fails the retrieval
+    auto out_of_memory = [&]() {
+        error = ErrorInfo{ DicomError::MemoryAllocationFailed, "DICOMweb frame does not fit in memory",
+                           "frame " + std::to_string(stats.received + 1) + " from " + url };
+        return false;
+    };
+    auto reserve = [&](long long declared_length) {
+        try {
+            frame.reserve(static_cast<size_t>(std::clamp<long long>(declared_length, 0, kMaxFrameReserve)));
+            return true;
+        }
+        catch (const std::bad_alloc&) {
+            return out_of_memory();
+        }
+    };
+    auto append = [&](const char* data, size_t size) {
+        try {
+            frame.insert(frame.end(), data, data + size);
+            return true;
+        }
+        catch (const std::bad_alloc&) {
+            return out_of_memory();
+        }
+        catch (const std::length_error&) {
+            return out_of_memory();
+        }
+    };
+
+    std::optional<MultipartParser> parser;
+    auto response = http_get(parsed.value(), kFramesAccept,
+        [&](const HttpResponse& response) {
+            if (auto type = parse_multipart_content_type(response.content_type)) {
+                parser.emplace(type->boundary, MultipartParser::Handler{
+                    [&](const MultipartHeaders& headers) {
+                        return reserve(std::atoll(headers.get("content-length").c_str()));
+                    },
+                    append,
+                    deliver });
+                return true;
+            }
+            // A single frame may come back as a bare octet-stream
+            return reserve(static_cast<long long>(response.content_length));
+        },
+        [&](const char* data, size_t size) {
+            stats.bytes += size;
+            if (!parser) {
+                return append(data, size);
+            }
+            auto fed = parser->feed(data, size);
+            if (fed.is_error() && !stopped && !error) {
+                error = fed.error();
+            }
+            return fed.is_ok();
+        });
+    if (error) {
+        return *error;
+    }
+    if (response.is_error()) {
+        return response.error();
+    }
+    if (!parser && !frame.empty()) {
+        deliver();
+    }
+
+    stats.cancelled = stopped;
+    stats.total_ms = ms_since(start);
+    if (!stopped && parser && !parser->finished()) {
+        return ErrorInfo{ DicomError::NetworkError, "DICOMweb response ended early",
+                         std::to_string(stats.received) + " frames received from " + url };
+    }
+    stats.failed += static_cast<uint32_t>(frame_numbers.size()) - std::min<uint32_t>(
+        static_cast<uint32_t>(frame_numbers.size()), stats.received);
+    return stats;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "core/error_codes.hpp"
+#include "core/result.hpp"
+#include "instance_ingest.hpp"
+#include "multipart_parser.hpp"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct DicomWebStats {
+    uint32_t received = 0;            // instances stored and indexed, or frames delivered
+    uint32_t failed = 0;              // parts that could not be read or stored
+    uint64_t bytes = 0;               // response body bytes
+    double first_part_ms = -1.0;      // first instance indexed (its decode is queued right then) or frame delivered
+    double total_ms = 0.0;
+    bool cancelled = false;
+};
+
+// Reads the instances out of a multipart/related; type="application/dicom"
+// body fed in pieces. Each part is parsed by DCMTK through a
+// DcmInputBufferStream straight from the fed bytes; once its closing
+// delimiter arrives it is complete and goes to the ingest, which stores it
+// and queues its decode while later parts are still being fed.
+class DicomMultipartReader {
+public:
+    DicomMultipartReader(InstanceIngest& ingest, const std::string& boundary);
+    ~DicomMultipartReader();
+
+    DicomMultipartReader(const DicomMultipartReader&) = delete;
+    DicomMultipartReader& operator=(const DicomMultipartReader&) = delete;
+
+    // Fails only if the body is malformed; unreadable parts are counted
+    Result<bool, ErrorInfo> feed(const char* data, size_t size);
+
+    // Whether the close delimiter was fed, i.e. no part was cut off
+    bool finished() const { return parser_.finished(); }
+
+    uint32_t instances() const { return instances_; }
+    uint32_t failed() const { return failed_; }
+
+private:
+    class Part;
+
+    InstanceIngest& ingest_;
+    MultipartParser parser_;
+    std::unique_ptr<Part> part_;
+    uint32_t instances_ = 0;
+    uint32_t failed_ = 0;
+
+    bool begin_part(const MultipartHeaders& headers);
+    void end_part();
+};
+
+// WADO-RS (DICOMweb) retrieval of whole instances over HTTP. The response
+// is parsed as it comes off the socket, never buffered whole, so the first
+// instances are stored and decoding while the rest is still downloading.
+// Use one retriever per retrieval.
+class DicomWebRetriever {
+public:
+    explicit DicomWebRetriever(InstanceIngest& ingest) : ingest_(ingest) {}
+
+    DicomWebRetriever(const DicomWebRetriever&) = delete;
+    DicomWebRetriever& operator=(const DicomWebRetriever&) = delete;
+
+    // Stops reading the response; any thread
+    void cancel() { cancelled_ = true; }
+
+    // Retrieves every instance of a WADO-RS study, series or instance
+    // resource, e.g. http://host/dicom-web/studies/{study}/series/{series}.
+    // Blocks until the response is read. Fails if it cannot be read to the end.
+    Result<DicomWebStats, ErrorInfo> retrieve(const std::string& url);
+
+private:
+    InstanceIngest& ingest_;
+    std::atomic<bool> cancelled_{ false };
+};
+
+// Resource URL of a series under a DICOMweb service root
+std::string dicomweb_series_url(const std::string& service_url, const std::string& study_instance_uid,
+    const std::string& series_instance_uid);
+
+// Called with each frame's bytes, in the order requested; false stops the retrieval
+using FrameHandler = std::function<bool(uint32_t frame_number, std::vector<uint8_t> bytes)>;
+
+// WADO-RS frame retrieval from an instance resource URL: the frames come
+// back as application/octet-stream parts, uncompressed (Explicit VR Little
+// Endian pixel data), and are handed over one by one as each part completes.
+Result<DicomWebStats, ErrorInfo> retrieve_frames(const std::string& instance_url,
+    const std::vector<uint32_t>& frame_numbers, const FrameHandler& on_frame);
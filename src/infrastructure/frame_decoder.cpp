@@ -0,0 +1,476 @@
+#include "frame_decoder.hpp"
+#include "codec_registry.hpp"
+#include "functional_groups_reader.hpp"
+
+// DCMTK includes
+#include <dcmtk/dcmdata/dctk.h>
+#include <dcmtk/dcmdata/dcfcache.h>
+#include <dcmtk/dcmdata/dcpixseq.h>
+#include <dcmtk/dcmdata/dcpxitem.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+struct FrameLayout {
+    Uint16 rows = 0;
+    Uint16 columns = 0;
+    Uint16 bits_allocated = 0;
+    Uint16 bits_stored = 0;
+    Uint16 high_bit = 0;
+    Uint16 samples_per_pixel = 1;
+    Uint16 pixel_rep = 0;
+    Sint32 frame_count = 1;
+    Float64 rescale_slope = 1.0;
+    Float64 rescale_intercept = 0.0;
+    bool is_monochrome1 = false;
+    bool is_compressed = false;
+    Uint32 frame_size = 0;
+    size_t bytes_per_sample = 2;
+};
+
+DcmPixelData* find_pixel_data(DcmDataset* dataset) {
+    DcmElement* element = nullptr;
+    if (dataset->findAndGetElement(DCM_PixelData, element).bad() || !element ||
+        element->ident() != EVR_PixelData) {
+        return nullptr;
+    }
+    return static_cast<DcmPixelData*>(element);
+}
+
+// Index of the first fragment of every frame (item 0 is the offset table).
+// An empty result means frames cannot be located independently.
+std::vector<Uint32> locate_start_fragments(DcmPixelData* pixel_data, Uint32 frame_count) {
+    E_TransferSyntax xfer = EXS_Unknown;
+    const DcmRepresentationParameter* param = nullptr;
+    pixel_data->getOriginalRepresentationKey(xfer, param);
+
+    DcmPixelSequence* sequence = nullptr;
+    if (pixel_data->getEncapsulatedRepresentation(xfer, param, sequence).bad() || !sequence) {
+        return {};
+    }
+
+    const Uint32 item_count = static_cast<Uint32>(sequence->card());
+    if (item_count < 2) {
+        return {};
+    }
+
+    std::vector<Uint32> start(frame_count, 0);
+
+    // One fragment per frame
+    if (item_count - 1 == frame_count) {
+        std::iota(start.begin(), start.end(), 1u);
+        return start;
+    }
+
+    // Basic offset table: byte offsets relative to the first fragment item
+    DcmPixelItem* table = nullptr;
+    if (sequence->getItem(table, 0).good() && table &&
+        table->getLength() >= frame_count * sizeof(Uint32)) {
+        Uint8* table_bytes = nullptr;
+        if (table->getUint8Array(table_bytes).good() && table_bytes) {
+            std::map<Uint32, Uint32> fragment_at_offset;
+            Uint32 position = 0;
+            for (Uint32 i = 1; i < item_count; ++i) {
+                DcmPixelItem* fragment = nullptr;
+                if (sequence->getItem(fragment, i).bad() || !fragment) {
+                    return {};
+                }
+                fragment_at_offset[position] = i;
+                position += 8 + fragment->getLength();
+            }
+
+            for (Uint32 f = 0; f < frame_count; ++f) {
+                const Uint8* p = table_bytes + f * sizeof(Uint32);
+                const Uint32 offset = static_cast<Uint32>(p[0]) | (static_cast<Uint32>(p[1]) << 8) |
+                    (static_cast<Uint32>(p[2]) << 16) | (static_cast<Uint32>(p[3]) << 24);
+                auto it = fragment_at_offset.find(offset);
+                if (it == fragment_at_offset.end()) {
+                    return {};
+                }
+                start[f] = it->second;
+            }
+            return start;
+        }
+    }
+
+    // No usable table: JPEG and JPEG-LS frames begin with an SOI marker
+    Uint32 found = 0;
+    for (Uint32 i = 1; i < item_count && found < frame_count; ++i) {
+        DcmPixelItem* fragment = nullptr;
+        Uint8 marker[2] = { 0, 0 };
+        if (sequence->getItem(fragment, i).good() && fragment && fragment->getLength() >= 2 &&
+            fragment->getPartialValue(marker, 0, 2).good() &&
+            marker[0] == 0xFF && marker[1] == 0xD8) {
+            start[found++] = i;
+        }
+    }
+
+    return found == frame_count ? start : std::vector<Uint32>{};
+}
+
+// Stored value of a raw sample honoring Bits Stored, High Bit and sign
+int32_t stored_value(uint32_t raw, const FrameLayout& layout) {
+    const uint32_t shift = layout.high_bit + 1u - layout.bits_stored;
+    const uint32_t mask = layout.bits_stored >= 32 ? 0xFFFFFFFFu : ((1u << layout.bits_stored) - 1u);
+    int32_t value = static_cast<int32_t>((raw >> shift) & mask);
+    if (layout.pixel_rep == 1 && (value & (1 << (layout.bits_stored - 1)))) {
+        value -= (1 << layout.bits_stored);
+    }
+    return value;
+}
+
+} // namespace
+
+FrameDecodeScheduler::FrameDecodeScheduler(ThreadPool& pool, size_t max_workers)
+    : pool_(pool), max_workers_(max_workers == 0 ? pool.size() : max_workers) {
+}
+
+Result<FrameSet, ErrorInfo> FrameDecodeScheduler::decode(
+    const std::filesystem::path& path,
+    FrameDecodeStats* stats,
+    PixelCache* cache
+) {
+    auto decode_start = std::chrono::steady_clock::now();
+
+    // Header pass; large values such as pixel fragments stay on disk
+    DcmFileFormat file_format;
+    OFCondition status = file_format.loadFile(path.string().c_str());
+    if (status.bad()) {
+        return ErrorInfo{ DicomError::InvalidFormat, "Failed to load DICOM file", status.text() };
+    }
+
+    DcmDataset* dataset = file_format.getDataset();
+    FrameLayout layout;
+
+    OFString photometric_str;
+    dataset->findAndGetOFString(DCM_PhotometricInterpretation, photometric_str);
+    if (photometric_str != "MONOCHROME1" && photometric_str != "MONOCHROME2") {
+        return ErrorInfo{ DicomError::UnsupportedPhotometricInterpretation,
+                         "Multi-frame decoding supports grayscale images only",
+                         photometric_str.c_str() };
+    }
+    layout.is_monochrome1 = (photometric_str == "MONOCHROME1");
+
+    dataset->findAndGetUint16(DCM_Rows, layout.rows);
+    dataset->findAndGetUint16(DCM_Columns, layout.columns);
+    dataset->findAndGetUint16(DCM_BitsAllocated, layout.bits_allocated);
+    dataset->findAndGetUint16(DCM_BitsStored, layout.bits_stored);
+    dataset->findAndGetUint16(DCM_PixelRepresentation, layout.pixel_rep);
+    dataset->findAndGetUint16(DCM_SamplesPerPixel, layout.samples_per_pixel);
+    dataset->findAndGetSint32(DCM_NumberOfFrames, layout.frame_count);
+    dataset->findAndGetFloat64(DCM_RescaleSlope, layout.rescale_slope);
+    dataset->findAndGetFloat64(DCM_RescaleIntercept, layout.rescale_intercept);
+    if (dataset->findAndGetUint16(DCM_HighBit, layout.high_bit).bad()) {
+        layout.high_bit = layout.bits_stored - 1;
+    }
+    if (layout.frame_count < 1) layout.frame_count = 1;
+
+    if (layout.rows == 0 || layout.columns == 0 || layout.bits_stored == 0 ||
+        layout.bits_stored > 16 || layout.samples_per_pixel != 1 ||
+        layout.high_bit + 1 < layout.bits_stored) {
+        return ErrorInfo{ DicomError::InvalidImageDimensions, "Unsupported frame layout", "" };
+    }
+
+    DcmPixelData* pixel_data = find_pixel_data(dataset);
+    if (!pixel_data) {
+        return ErrorInfo{ DicomError::MissingPixelData, "No pixel data found", "" };
+    }
+
+    layout.is_compressed = DcmXfer(dataset->getOriginalXfer()).usesEncapsulatedFormat();
+    ensure_decoders(*dataset);
+    status = pixel_data->getUncompressedFrameSize(dataset, layout.frame_size, !layout.is_compressed);
+    if (status.bad()) {
+        return ErrorInfo{ DicomError::InvalidFormat, "Cannot determine frame size", status.text() };
+    }
+
+    const uint32_t frame_count = static_cast<uint32_t>(layout.frame_count);
+    const size_t frame_pixels = static_cast<size_t>(layout.rows) * layout.columns;
+    layout.bytes_per_sample = layout.frame_size / frame_pixels >= 2 ? 2 : 1;
+
+    std::vector<Uint32> start_fragments;
+    if (layout.is_compressed) {
+        start_fragments = locate_start_fragments(pixel_data, frame_count);
+        if (start_fragments.empty()) {
+            std::cout << "[DEBUG] Frame fragments not locatable, decoding sequentially" << std::endl;
+        }
+    }
+
+    // Frames are only looked up when each can be decoded on its own, as a
+    // sequential decode must walk the fragments of every frame
+    std::optional<PixelCacheKey> cache_key;
+    OFString sop_instance_uid;
+    if (cache && !start_fragments.empty() &&
+        dataset->findAndGetOFString(DCM_SOPInstanceUID, sop_instance_uid).good() && !sop_instance_uid.empty()) {
+        cache_key = PixelCacheKey{ sop_instance_uid.c_str(), 0, PixelCache::fingerprint(path) };
+    }
+
+    FrameSet frames;
+    frames.width = layout.columns;
+    frames.height = layout.rows;
+    frames.frame_count = frame_count;
+    frames.bits_allocated = layout.bits_allocated;
+    frames.bits_stored = layout.bits_stored;
+    frames.is_signed = (layout.pixel_rep == 1);
+
+    // Enhanced objects keep geometry, rescale and window per frame
+    auto groups = read_functional_groups(*dataset, frame_count, pool_);
+    if (groups.is_ok()) {
+        frames.functional_groups = std::move(groups.value());
+    }
+    else {
+        std::cout << "[DEBUG] Ignoring functional groups: " << groups.error().message << std::endl;
+    }
+    const FunctionalGroupTable& functional_groups = frames.functional_groups;
+
+    try {
+        frames.pixels = PixelBuffer::allocate(PixelFormat::Gray16, frame_pixels * frame_count);
+    }
+    catch (const std::bad_alloc&) {
+        return ErrorInfo{ DicomError::MemoryAllocationFailed, "Cannot allocate frame buffer", "" };
+    }
+
+    // Per-frame stored value range, each entry written by exactly one worker
+    std::vector<int32_t> frame_min(frame_count, std::numeric_limits<int32_t>::max());
+    std::vector<int32_t> frame_max(frame_count, std::numeric_limits<int32_t>::min());
+    // Frames taken from the cache, read in place by the normalization pass
+    std::vector<PixelBuffer> cached_frames(frame_count);
+    std::atomic<uint32_t> cache_hits{ 0 };
+
+    std::atomic<uint32_t> next_frame{ 0 };
+    std::atomic<bool> failed{ false };
+    std::mutex error_mutex;
+    std::optional<ErrorInfo> first_error;
+
+    auto fail = [&](ErrorInfo error) {
+        std::lock_guard lock(error_mutex);
+        if (!first_error) first_error = std::move(error);
+        failed = true;
+    };
+
+    auto worker = [&]() {
+        // Workers that start late find the frames taken and skip the parse
+        if (next_frame.load() >= frame_count) {
+            return;
+        }
+        DcmFileFormat worker_file;
+        OFCondition cond = worker_file.loadFile(path.string().c_str());
+        if (cond.bad()) {
+            fail(ErrorInfo{ DicomError::InvalidFormat, "Failed to load DICOM file", cond.text() });
+            return;
+        }
+
+        DcmDataset* worker_dataset = worker_file.getDataset();
+        DcmPixelData* worker_pixels = find_pixel_data(worker_dataset);
+        if (!worker_pixels) {
+            fail(ErrorInfo{ DicomError::MissingPixelData, "No pixel data found", "" });
+            return;
+        }
+
+        DcmFileCache file_cache;
+        std::vector<Uint8> scratch;
+        if (layout.bytes_per_sample == 1) {
+            scratch.resize(layout.frame_size + (layout.frame_size & 1));
+        }
+
+        Uint32 sequential_fragment = 0;
+
+        for (;;) {
+            const uint32_t f = next_frame.fetch_add(1);
+            if (f >= frame_count || failed) {
+                break;
+            }
+
+            std::optional<PixelCacheKey> frame_key;
+            if (cache_key) {
+                frame_key = *cache_key;
+                frame_key->frame = f;
+                if (auto cached = cache->lookup_frame(*frame_key, layout.columns, layout.rows)) {
+                    cached_frames[f] = std::move(cached->samples);
+                    frame_min[f] = cached->min_value;
+                    frame_max[f] = cached->max_value;
+                    ++cache_hits;
+                    continue;
+                }
+            }
+
+            uint16_t* slot = frames.frame(f);
+            Uint32 start_fragment = start_fragments.empty() ? sequential_fragment : start_fragments[f];
+            OFString color_model;
+
+            if (layout.bytes_per_sample == 2) {
+                cond = worker_pixels->getUncompressedFrame(worker_dataset, f, start_fragment, slot,
+                    static_cast<Uint32>(frame_pixels * sizeof(uint16_t)), color_model, &file_cache);
+            }
+            else {
+                cond = worker_pixels->getUncompressedFrame(worker_dataset, f, start_fragment,
+                    scratch.data(), static_cast<Uint32>(scratch.size()), color_model, &file_cache);
+                if (cond.good()) {
+                    std::copy(scratch.begin(), scratch.begin() + frame_pixels, slot);
+                }
+            }
+
+            if (cond.bad()) {
+                fail(ErrorInfo{ DicomError::UnsupportedTransferSyntax,
+                               "Failed to decode frame " + std::to_string(f), cond.text() });
+                break;
+            }
+            sequential_fragment = start_fragment;
+
+            int32_t lo = std::numeric_limits<int32_t>::max();
+            int32_t hi = std::numeric_limits<int32_t>::min();
+            for (size_t i = 0; i < frame_pixels; ++i) {
+                const int32_t value = stored_value(slot[i], layout);
+                lo = std::min(lo, value);
+                hi = std::max(hi, value);
+            }
+            frame_min[f] = lo;
+            frame_max[f] = hi;
+
+            if (frame_key) {
+                cache->store_frame(*frame_key, slot, layout.columns, layout.rows, lo, hi);
+            }
+        }
+    };
+
+    // Without locatable fragments frames must be decoded in order by one worker
+    size_t worker_count = start_fragments.empty() && layout.is_compressed
+        ? 1 : std::min<size_t>({ max_workers_, pool_.size(), frame_count });
+    worker_count = std::max<size_t>(worker_count, 1);
+
+    // Workers pull frames from a shared counter; the calling thread is one of
+    // them, so the decode also completes when it runs on a busy pool's worker
+    pool_.parallel_for(worker_count, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            worker();
+        }
+    });
+
+    if (first_error) {
+        return *first_error;
+    }
+
+    auto normalize_start = std::chrono::steady_clock::now();
+
+    // Each frame's rescale: its own from the functional groups, else the dataset's
+    auto frame_rescale = [&](uint32_t f) -> std::pair<double, double> {
+        if (!functional_groups.empty() && functional_groups.has(f, FunctionalGroupTable::Rescale)) {
+            return { functional_groups.rescale_slope[f], functional_groups.rescale_intercept[f] };
+        }
+        return { layout.rescale_slope, layout.rescale_intercept };
+    };
+
+    // One value mapping for all frames: stored -> modality -> 0-65535
+    double min_val = std::numeric_limits<double>::max();
+    double max_val = std::numeric_limits<double>::lowest();
+    for (uint32_t f = 0; f < frame_count; ++f) {
+        const auto [slope, intercept] = frame_rescale(f);
+        const double a = frame_min[f] * slope + intercept;
+        const double b = frame_max[f] * slope + intercept;
+        min_val = std::min({ min_val, a, b });
+        max_val = std::max({ max_val, a, b });
+    }
+    double data_range = max_val - min_val;
+    if (data_range < 1) data_range = 1;
+    const double scale = 65535.0 / data_range;
+
+    // One table per distinct rescale, usually a single one
+    const size_t lut_size = size_t{ 1 } << (8 * layout.bytes_per_sample);
+    std::map<std::pair<double, double>, size_t> lut_of_rescale;
+    std::vector<std::vector<uint16_t>> luts;
+    std::vector<size_t> frame_lut(frame_count);
+    for (uint32_t f = 0; f < frame_count; ++f) {
+        const auto rescale = frame_rescale(f);
+        auto [it, inserted] = lut_of_rescale.try_emplace(rescale, luts.size());
+        frame_lut[f] = it->second;
+        if (!inserted) {
+            continue;
+        }
+        std::vector<uint16_t>& lut = luts.emplace_back(lut_size);
+        for (size_t raw = 0; raw < lut_size; ++raw) {
+            const double modality = stored_value(static_cast<uint32_t>(raw), layout) * rescale.first + rescale.second;
+            double normalized = std::clamp((modality - min_val) * scale, 0.0, 65535.0);
+            if (layout.is_monochrome1) {
+                normalized = 65535.0 - normalized;
+            }
+            lut[raw] = static_cast<uint16_t>(normalized);
+        }
+    }
+
+    pool_.parallel_for(frames.pixels.pixel_count(), [&](size_t begin, size_t end) {
+        uint16_t* pixels = frames.pixels.gray16();
+        // A chunk may straddle frames with different tables or sources
+        while (begin < end) {
+            const size_t f = begin / frame_pixels;
+            const size_t stop = std::min(end, (f + 1) * frame_pixels);
+            const uint16_t* lut = luts[frame_lut[f]].data();
+            const PixelBuffer& cached = cached_frames[f];
+            uint16_t* out = pixels + begin;
+            const uint16_t* source = cached.empty() ? out : cached.gray16() + (begin - f * frame_pixels);
+            for (size_t i = 0; i < stop - begin; ++i) {
+                out[i] = lut[source[i]];
+            }
+            begin = stop;
+        }
+    });
+
+    cached_frames.clear();
+    frames.modality = ModalityMapping::from_normalization(min_val, scale, layout.is_monochrome1);
+
+    // Window from the file or the middle frame's functional groups,
+    // otherwise derived from the middle frame's pixels
+    const uint32_t middle_frame = frame_count / 2;
+    Float64 file_wc = 0, file_ww = 0;
+    if (dataset->findAndGetFloat64(DCM_WindowCenter, file_wc).good() &&
+        dataset->findAndGetFloat64(DCM_WindowWidth, file_ww).good() && file_ww > 0) {
+        frames.window_center = static_cast<int32_t>((file_wc - min_val) * scale);
+        frames.window_width = static_cast<int32_t>(file_ww * scale);
+        if (layout.is_monochrome1) {
+            frames.window_center = 65535 - frames.window_center;
+        }
+    }
+    else if (!functional_groups.empty() && functional_groups.has(middle_frame, FunctionalGroupTable::Window)) {
+        std::tie(frames.window_center, frames.window_width) = frames.frame_window(middle_frame);
+    }
+    else {
+        DicomImageData middle = frames.frame_image(middle_frame);
+        middle.auto_window_level();
+        frames.window_center = middle.data().window_center;
+        frames.window_width = middle.data().window_width;
+    }
+    frames.window_width = std::max(frames.window_width, 1);
+
+    auto done = std::chrono::steady_clock::now();
+
+    FrameDecodeStats result_stats;
+    result_stats.frames = frame_count;
+    result_stats.cached_frames = cache_hits;
+    result_stats.workers = worker_count;
+    result_stats.decode_ms = std::chrono::duration<double, std::milli>(normalize_start - decode_start).count();
+    result_stats.normalize_ms = std::chrono::duration<double, std::milli>(done - normalize_start).count();
+
+    std::cout << "[DEBUG] Decoded " << frame_count << " frames with " << worker_count
+        << " workers in " << result_stats.decode_ms + result_stats.normalize_ms << " ms ("
+        << result_stats.frames_per_second() << " fps)";
+    if (cache_key) {
+        std::cout << ", " << result_stats.cached_frames << " from the pixel cache";
+    }
+    std::cout << std::endl;
+
+    if (stats) {
+        *stats = result_stats;
+    }
+
+    return frames;
+}
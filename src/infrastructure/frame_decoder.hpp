@@ -0,0 +1,46 @@
+#pragma once
+
+#include "core/result.hpp"
+#include "core/error_codes.hpp"
+#include "core/frame_set.hpp"
+#include "core/thread_pool.hpp"
+#include "pixel_cache.hpp"
+#include <filesystem>
+#include <cstdint>
+#include <cstddef>
+
+struct FrameDecodeStats {
+    uint32_t frames = 0;
+    uint32_t cached_frames = 0;
+    size_t workers = 0;
+    double decode_ms = 0.0;
+    double normalize_ms = 0.0;
+
+    double frames_per_second() const {
+        const double total_ms = decode_ms + normalize_ms;
+        return total_ms > 0.0 ? frames * 1000.0 / total_ms : 0.0;
+    }
+};
+
+// Decodes all frames of a grayscale multi-frame object (native, RLE, JPEG or
+// JPEG-LS) on a worker pool. Every worker parses the file itself and owns its
+// codec and file cache state, so no DCMTK object is shared between threads.
+// Decoded frames land directly in their preallocated FrameSet slot.
+// With a pixel cache, each compressed frame is cached under its own index
+// before normalization; a cached frame skips its codec and is normalized
+// straight out of the cache file's mapping.
+// The decoders for the file's transfer syntax are registered on first use.
+class FrameDecodeScheduler {
+    ThreadPool& pool_;
+    size_t max_workers_;
+
+public:
+    // max_workers == 0 uses every thread of the pool
+    explicit FrameDecodeScheduler(ThreadPool& pool, size_t max_workers = 0);
+
+    Result<FrameSet, ErrorInfo> decode(
+        const std::filesystem::path& path,
+        FrameDecodeStats* stats = nullptr,
+        PixelCache* cache = nullptr
+    );
+};
@@ -0,0 +1,256 @@
+#include "functional_groups_reader.hpp"
+
+// DCMTK includes
+#include <dcmtk/dcmdata/dctk.h>
+#include <dcmtk/dcmfg/fgfracon.h>
+#include <dcmtk/dcmfg/fgframevoilut.h>
+#include <dcmtk/dcmfg/fgpixeltransform.h>
+#include <dcmtk/dcmfg/fgpixmsr.h>
+#include <dcmtk/dcmfg/fgplanor.h>
+#include <dcmtk/dcmfg/fgplanpo.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+// Values of one functional groups item; per-frame items start from the shared ones
+struct GroupValues {
+    uint8_t fields = 0;
+    Vec3 position;
+    Vec3 row_direction{ 1, 0, 0 };
+    Vec3 column_direction{ 0, 1, 0 };
+    std::array<double, 2> pixel_spacing{ 1.0, 1.0 };
+    double slice_thickness = 0.0;
+    double rescale_slope = 1.0;
+    double rescale_intercept = 0.0;
+    double window_center = 0.0;
+    double window_width = 0.0;
+    uint32_t in_stack_position = 0;
+    uint32_t temporal_position = 0;
+};
+
+double parse_decimal(const OFString& text, double fallback) {
+    OFBool ok = OFFalse;
+    const double value = OFStandard::atof(text.c_str(), &ok);
+    return ok ? value : fallback;
+}
+
+// Groups are parsed only when their sequence is present, which keeps dcmfg
+// from logging every group a frame leaves to the shared item
+void read_groups(DcmItem& item, GroupValues& values) {
+    if (item.tagExists(DCM_PlanePositionSequence)) {
+        FGPlanePosPatient group;
+        Float64 x = 0, y = 0, z = 0;
+        if (group.read(item).good() && group.getImagePositionPatient(x, y, z).good()) {
+            values.position = { x, y, z };
+            values.fields |= FunctionalGroupTable::Position;
+        }
+    }
+
+    if (item.tagExists(DCM_PlaneOrientationSequence)) {
+        FGPlaneOrientationPatient group;
+        Float64 rx = 0, ry = 0, rz = 0, cx = 0, cy = 0, cz = 0;
+        if (group.read(item).good() && group.getImageOrientationPatient(rx, ry, rz, cx, cy, cz).good()) {
+            values.row_direction = Vec3{ rx, ry, rz }.normalized();
+            values.column_direction = Vec3{ cx, cy, cz }.normalized();
+            values.fields |= FunctionalGroupTable::Orientation;
+        }
+    }
+
+    if (item.tagExists(DCM_PixelMeasuresSequence)) {
+        FGPixelMeasures group;
+        Float64 row_spacing = 0, column_spacing = 0, thickness = 0;
+        if (group.read(item).good() && group.getPixelSpacing(row_spacing, 0).good() &&
+            group.getPixelSpacing(column_spacing, 1).good() && row_spacing > 0 && column_spacing > 0) {
+            values.pixel_spacing = { row_spacing, column_spacing };
+            if (group.getSliceThickness(thickness).good()) {
+                values.slice_thickness = thickness;
+            }
+            values.fields |= FunctionalGroupTable::Spacing;
+        }
+    }
+
+    if (item.tagExists(DCM_PixelValueTransformationSequence)) {
+        FGPixelValueTransformation group;
+        OFString slope, intercept;
+        if (group.read(item).good() && group.getRescaleSlope(slope).good() &&
+            group.getRescaleIntercept(intercept).good()) {
+            values.rescale_slope = parse_decimal(slope, 1.0);
+            values.rescale_intercept = parse_decimal(intercept, 0.0);
+            if (values.rescale_slope == 0.0) values.rescale_slope = 1.0;
+            values.fields |= FunctionalGroupTable::Rescale;
+        }
+    }
+
+    if (item.tagExists(DCM_FrameVOILUTSequence)) {
+        FGFrameVOILUT group;
+        Float64 center = 0, width = 0;
+        if (group.read(item).good() && group.getWindowCenter(center).good() &&
+            group.getWindowWidth(width).good() && width > 0) {
+            values.window_center = center;
+            values.window_width = width;
+            values.fields |= FunctionalGroupTable::Window;
+        }
+    }
+
+    if (item.tagExists(DCM_FrameContentSequence)) {
+        FGFrameContent group;
+        Uint32 in_stack = 0, temporal = 0;
+        if (group.read(item).good()) {
+            const bool has_stack = group.getInStackPositionNumber(in_stack).good();
+            const bool has_temporal = group.getTemporalPositionIndex(temporal).good();
+            if (has_stack || has_temporal) {
+                values.in_stack_position = has_stack ? in_stack : 0;
+                values.temporal_position = has_temporal ? temporal : 0;
+                values.fields |= FunctionalGroupTable::Stack;
+            }
+        }
+    }
+}
+
+void store(FunctionalGroupTable& table, uint32_t f, const GroupValues& values) {
+    table.fields[f] = values.fields;
+    table.position[f] = values.position;
+    table.row_direction[f] = values.row_direction;
+    table.column_direction[f] = values.column_direction;
+    table.pixel_spacing[f] = values.pixel_spacing;
+    table.slice_thickness[f] = values.slice_thickness;
+    table.rescale_slope[f] = values.rescale_slope;
+    table.rescale_intercept[f] = values.rescale_intercept;
+    table.window_center[f] = values.window_center;
+    table.window_width[f] = values.window_width;
+    table.in_stack_position[f] = values.in_stack_position;
+    table.temporal_position[f] = values.temporal_position;
+}
+
+// First item of a sequence that is in this item itself, not a nested one
+DcmItem* first_item(DcmItem& item, const DcmTagKey& key) {
+    DcmItem* result = nullptr;
+    return item.findAndGetSequenceItem(key, result, 0).good() ? result : nullptr;
+}
+
+} // namespace
+
+Result<FunctionalGroupTable, ErrorInfo>
+read_functional_groups(DcmItem& dataset, uint32_t frame_count, ThreadPool& pool) {
+    FunctionalGroupTable table;
+    DcmSequenceOfItems* per_frame = nullptr;
+    DcmItem* shared_item = first_item(dataset, DCM_SharedFunctionalGroupsSequence);
+    dataset.findAndGetSequence(DCM_PerFrameFunctionalGroupsSequence, per_frame);
+    if (frame_count == 0 || (!shared_item && !per_frame)) {
+        return table;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    GroupValues shared;
+    if (shared_item) {
+        read_groups(*shared_item, shared);
+    }
+
+    // Item pointers in one pass: looking items up by index walks the list each time
+    std::vector<DcmItem*> items;
+    items.reserve(frame_count);
+    if (per_frame) {
+        for (DcmObject* object = per_frame->nextInContainer(nullptr); object && items.size() < frame_count;
+            object = per_frame->nextInContainer(object)) {
+            items.push_back(static_cast<DcmItem*>(object));
+        }
+        if (items.size() != frame_count) {
+            std::cout << "[DEBUG] Per-frame functional groups cover " << items.size() << " of "
+                << frame_count << " frames" << std::endl;
+        }
+    }
+
+    // Pixel Value Transformation reads the root's SOP Class UID for every
+    // frame; converting the string once here leaves only reads for the workers
+    OFString sop_class;
+    dataset.findAndGetOFString(DCM_SOPClassUID, sop_class);
+
+    table.resize(frame_count);
+    // Frames without a per-frame item keep the shared values
+    pool.parallel_for(frame_count, [&](size_t begin, size_t end) {
+        for (size_t f = begin; f < end; ++f) {
+            GroupValues values = shared;
+            if (f < items.size()) {
+                read_groups(*items[f], values);
+            }
+            store(table, static_cast<uint32_t>(f), values);
+        }
+    });
+    table.finish();
+
+    const auto elapsed = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << "[DEBUG] Indexed functional groups of " << frame_count << " frames in " << elapsed << " ms"
+        << (table.varies(FunctionalGroupTable::Rescale) ? ", per-frame rescale" : "")
+        << (table.varies(FunctionalGroupTable::Window) ? ", per-frame window" : "") << std::endl;
+
+    return table;
+}
+
+Result<FunctionalGroupTable, ErrorInfo>
+read_functional_groups(const std::filesystem::path& path, ThreadPool& pool) {
+    DcmFileFormat file_format;
+    OFCondition status = file_format.loadFile(path.string().c_str());
+    if (status.bad()) {
+        return ErrorInfo{ DicomError::InvalidFormat, "Failed to load DICOM file", status.text() };
+    }
+
+    DcmDataset* dataset = file_format.getDataset();
+    Sint32 frame_count = 1;
+    dataset->findAndGetSint32(DCM_NumberOfFrames, frame_count);
+    return read_functional_groups(*dataset, static_cast<uint32_t>(std::max<Sint32>(frame_count, 1)), pool);
+}
+
+struct FunctionalGroupWalker::Impl {
+    DcmFileFormat file_format;
+};
+
+FunctionalGroupWalker::FunctionalGroupWalker() : impl_(std::make_unique<Impl>()) {
+}
+
+FunctionalGroupWalker::FunctionalGroupWalker(FunctionalGroupWalker&&) noexcept = default;
+FunctionalGroupWalker& FunctionalGroupWalker::operator=(FunctionalGroupWalker&&) noexcept = default;
+FunctionalGroupWalker::~FunctionalGroupWalker() = default;
+
+Result<FunctionalGroupWalker, ErrorInfo> FunctionalGroupWalker::open(const std::filesystem::path& path) {
+    FunctionalGroupWalker walker;
+    OFCondition status = walker.impl_->file_format.loadFile(path.string().c_str());
+    if (status.bad()) {
+        return ErrorInfo{ DicomError::InvalidFormat, "Failed to load DICOM file", status.text() };
+    }
+    return walker;
+}
+
+FunctionalGroupWalker::FrameValues FunctionalGroupWalker::frame(uint32_t index) const {
+    DcmDataset* dataset = impl_->file_format.getDataset();
+    DcmItem* per_frame = nullptr;
+    dataset->findAndGetSequenceItem(DCM_PerFrameFunctionalGroupsSequence, per_frame, static_cast<signed long>(index));
+    DcmItem* shared = first_item(*dataset, DCM_SharedFunctionalGroupsSequence);
+
+    // The macro's item from the frame's groups, else from the shared ones
+    auto macro = [&](const DcmTagKey& key) -> DcmItem* {
+        DcmItem* item = per_frame ? first_item(*per_frame, key) : nullptr;
+        return item ? item : (shared ? first_item(*shared, key) : nullptr);
+    };
+
+    FrameValues values;
+    if (DcmItem* item = macro(DCM_PlanePositionSequence)) {
+        item->findAndGetFloat64(DCM_ImagePositionPatient, values.position.x, 0);
+        item->findAndGetFloat64(DCM_ImagePositionPatient, values.position.y, 1);
+        item->findAndGetFloat64(DCM_ImagePositionPatient, values.position.z, 2);
+    }
+    if (DcmItem* item = macro(DCM_PixelValueTransformationSequence)) {
+        item->findAndGetFloat64(DCM_RescaleSlope, values.rescale_slope);
+        item->findAndGetFloat64(DCM_RescaleIntercept, values.rescale_intercept);
+    }
+    if (DcmItem* item = macro(DCM_FrameVOILUTSequence)) {
+        item->findAndGetFloat64(DCM_WindowCenter, values.window_center);
+        item->findAndGetFloat64(DCM_WindowWidth, values.window_width);
+    }
+    return values;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "core/result.hpp"
+#include "core/error_codes.hpp"
+#include "core/functional_groups.hpp"
+#include "core/thread_pool.hpp"
+#include <filesystem>
+#include <memory>
+#include <cstdint>
+
+class DcmItem;
+
+// Flattens the Shared and Per-Frame Functional Groups Sequences of an
+// enhanced multi-frame dataset into a FunctionalGroupTable using dcmfg's
+// functional group classes. Only the groups the table holds are parsed;
+// per-frame items are split over the pool. A dataset without functional
+// groups gives an empty table.
+Result<FunctionalGroupTable, ErrorInfo>
+    read_functional_groups(DcmItem& dataset, uint32_t frame_count, ThreadPool& pool = ThreadPool::shared());
+
+// Same, parsing the header of the file at path; pixel data stays on disk
+Result<FunctionalGroupTable, ErrorInfo>
+    read_functional_groups(const std::filesystem::path& path, ThreadPool& pool = ThreadPool::shared());
+
+// One frame's values found by walking the functional group sequences on
+// every call, as code without the table does: the frame's item is reached
+// through the Per-Frame sequence, then the Shared one is tried. For
+// checking and timing the table.
+class FunctionalGroupWalker {
+public:
+    struct FrameValues {
+        Vec3 position;
+        double rescale_slope = 1.0;
+        double rescale_intercept = 0.0;
+        double window_center = 0.0;
+        double window_width = 0.0;
+    };
+
+    static Result<FunctionalGroupWalker, ErrorInfo> open(const std::filesystem::path& path);
+
+    FunctionalGroupWalker(FunctionalGroupWalker&&) noexcept;
+    FunctionalGroupWalker& operator=(FunctionalGroupWalker&&) noexcept;
+    ~FunctionalGroupWalker();
+
+    FrameValues frame(uint32_t index) const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+
+    FunctionalGroupWalker();
+};
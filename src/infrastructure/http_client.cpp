@@ -0,0 +1,294 @@
+#include "http_client.hpp"
+#include "tcp_socket.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+constexpr size_t kReceiveBufferSize = 256 * 1024;
+constexpr size_t kMaxHeaderBytes = 64 * 1024;
+constexpr uint32_t kReceiveTimeoutSeconds = 30;
+
+std::string to_lower(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(),
+        [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return text;
+}
+
+std::string trim(const std::string& text) {
+    const size_t first = text.find_first_not_of(" \t");
+    if (first == std::string::npos) {
+        return {};
+    }
+    return text.substr(first, text.find_last_not_of(" \t") - first + 1);
+}
+
+// Undoes chunked transfer coding on the fly, passing chunk data on as
+// pointers into the received bytes
+class ChunkedDecoder {
+public:
+    enum class Status { More, Done, Stopped, Malformed };
+
+    explicit ChunkedDecoder(const HttpBodyHandler& on_body) : on_body_(on_body) {}
+
+    Status feed(const char* data, size_t size) {
+        size_t i = 0;
+        while (i < size) {
+            switch (state_) {
+            case State::Size: {
+                const char c = data[i++];
+                if (std::isxdigit(static_cast<unsigned char>(c))) {
+                    if (remaining_ > (uint64_t(1) << 59)) {
+                        return Status::Malformed;
+                    }
+                    const int digit = c <= '9' ? c - '0' : (std::tolower(static_cast<unsigned char>(c)) - 'a' + 10);
+                    remaining_ = remaining_ * 16 + static_cast<uint64_t>(digit);
+                }
+                else if (c == ';' || c == ' ' || c == '\t') {
+                    state_ = State::Extension;
+                }
+                else if (c == '\r') {
+                    state_ = State::SizeLf;
+                }
+                else {
+                    return Status::Malformed;
+                }
+                break;
+            }
+            case State::Extension:
+                if (data[i++] == '\r') {
+                    state_ = State::SizeLf;
+                }
+                break;
+            case State::SizeLf:
+                if (data[i++] != '\n') {
+                    return Status::Malformed;
+                }
+                state_ = remaining_ == 0 ? State::TrailerLineStart : State::Data;
+                break;
+            case State::Data: {
+                const size_t n = static_cast<size_t>(std::min<uint64_t>(remaining_, size - i));
+                if (!on_body_(data + i, n)) {
+                    return Status::Stopped;
+                }
+                i += n;
+                remaining_ -= n;
+                if (remaining_ == 0) {
+                    state_ = State::DataCr;
+                }
+                break;
+            }
+            case State::DataCr:
+                if (data[i++] != '\r') {
+                    return Status::Malformed;
+                }
+                state_ = State::DataLf;
+                break;
+            case State::DataLf:
+                if (data[i++] != '\n') {
+                    return Status::Malformed;
+                }
+                state_ = State::Size;
+                break;
+            case State::TrailerLineStart:
+                state_ = data[i++] == '\r' ? State::TrailerEndLf : State::TrailerLine;
+                break;
+            case State::TrailerLine:
+                if (data[i++] == '\n') {
+                    state_ = State::TrailerLineStart;
+                }
+                break;
+            case State::TrailerEndLf:
+                if (data[i++] != '\n') {
+                    return Status::Malformed;
+                }
+                state_ = State::Done;
+                return Status::Done;
+            case State::Done:
+                return Status::Done;
+            }
+        }
+        return state_ == State::Done ? Status::Done : Status::More;
+    }
+
+private:
+    enum class State { Size, Extension, SizeLf, Data, DataCr, DataLf, TrailerLineStart, TrailerLine, TrailerEndLf, Done };
+
+    const HttpBodyHandler& on_body_;
+    State state_ = State::Size;
+    uint64_t remaining_ = 0;
+};
+
+} // namespace
+
+Result<HttpUrl, ErrorInfo> parse_http_url(const std::string& url) {
+    const std::string scheme = "http://";
+    if (to_lower(url.substr(0, scheme.size())) != scheme) {
+        return ErrorInfo{ DicomError::NetworkError, "Only http:// URLs are supported", url };
+    }
+    HttpUrl result;
+    const size_t path_start = url.find('/', scheme.size());
+    std::string authority = url.substr(scheme.size(), path_start == std::string::npos
+        ? std::string::npos : path_start - scheme.size());
+    if (path_start != std::string::npos) {
+        result.path = url.substr(path_start);
+    }
+
+    const size_t colon = authority.rfind(':');
+    if (colon != std::string::npos && authority.find(']', colon) == std::string::npos) {
+        const unsigned long port = std::strtoul(authority.c_str() + colon + 1, nullptr, 10);
+        if (port == 0 || port > 65535) {
+            return ErrorInfo{ DicomError::NetworkError, "Invalid port in URL", url };
+        }
+        result.port = static_cast<uint16_t>(port);
+        authority.resize(colon);
+    }
+    if (authority.size() > 2 && authority.front() == '[' && authority.back() == ']') {
+        authority = authority.substr(1, authority.size() - 2);
+    }
+    if (authority.empty()) {
+        return ErrorInfo{ DicomError::NetworkError, "No host in URL", url };
+    }
+    result.host = authority;
+    return result;
+}
+
+Result<HttpResponse, ErrorInfo> http_get(const HttpUrl& url, const std::string& accept,
+    const HttpResponseHandler& on_response, const HttpBodyHandler& on_body) {
+    auto connected = TcpSocket::connect(url.host, url.port);
+    if (connected.is_error()) {
+        return connected.error();
+    }
+    TcpSocket socket = std::move(connected.value());
+    socket.set_receive_timeout(kReceiveTimeoutSeconds);
+
+    const std::string request = "GET " + url.path + " HTTP/1.1\r\n"
+        "Host: " + url.host + ":" + std::to_string(url.port) + "\r\n"
+        "Accept: " + accept + "\r\n"
+        "Connection: close\r\n"
+        "\r\n";
+    if (!socket.send_all(request.data(), request.size())) {
+        return ErrorInfo{ DicomError::NetworkError, "Cannot send HTTP request", url.host };
+    }
+
+    std::vector<char> buffer(kReceiveBufferSize);
+    auto receive_error = [&](int64_t received) {
+        return ErrorInfo{ DicomError::NetworkError, "HTTP response incomplete",
+                         received == 0 ? "connection closed by " + url.host : "receive failed or timed out" };
+    };
+
+    // Status line and headers; whatever follows them in the same read is body
+    std::string head;
+    size_t head_end = std::string::npos;
+    while (head_end == std::string::npos) {
+        const int64_t received = socket.receive(buffer.data(), buffer.size());
+        if (received <= 0) {
+            return receive_error(received);
+        }
+        const size_t searched_from = head.size() < 3 ? 0 : head.size() - 3;
+        head.append(buffer.data(), static_cast<size_t>(received));
+        head_end = head.find("\r\n\r\n", searched_from);
+        if (head_end == std::string::npos && head.size() > kMaxHeaderBytes) {
+            return ErrorInfo{ DicomError::NetworkError, "HTTP response headers too large", url.host };
+        }
+    }
+    std::string body_start = head.substr(head_end + 4);
+    head.resize(head_end);
+
+    HttpResponse response;
+    bool chunked = false;
+    size_t line_start = 0;
+    size_t line_end = head.find("\r\n");
+    const std::string status_line = head.substr(0, line_end);
+    const size_t space = status_line.find(' ');
+    if (status_line.rfind("HTTP/", 0) != 0 || space == std::string::npos) {
+        return ErrorInfo{ DicomError::NetworkError, "Not an HTTP response", status_line };
+    }
+    response.status = std::atoi(status_line.c_str() + space + 1);
+    while (line_end != std::string::npos) {
+        line_start = line_end + 2;
+        line_end = head.find("\r\n", line_start);
+        const std::string line = head.substr(line_start, line_end == std::string::npos
+            ? std::string::npos : line_end - line_start);
+        const size_t colon = line.find(':');
+        if (colon == std::string::npos) {
+            continue;
+        }
+        const std::string name = to_lower(trim(line.substr(0, colon)));
+        const std::string value = trim(line.substr(colon + 1));
+        if (name == "content-type") {
+            response.content_type = value;
+        }
+        else if (name == "content-length") {
+            response.content_length = std::strtoll(value.c_str(), nullptr, 10);
+        }
+        else if (name == "transfer-encoding") {
+            chunked = to_lower(value).find("chunked") != std::string::npos;
+        }
+    }
+    if (chunked) {
+        response.content_length = -1;
+    }
+
+    if (response.status < 200 || response.status >= 300) {
+        return ErrorInfo{ DicomError::NetworkError, "HTTP request failed",
+                         status_line.substr(space + 1) + " for " + url.path };
+    }
+    if (!on_response(response)) {
+        return response;
+    }
+
+    // Body, up to its length, the last chunk or the connection closing
+    ChunkedDecoder decoder(on_body);
+    uint64_t delivered = 0;
+    bool done = response.content_length == 0;
+    auto deliver = [&](const char* data, size_t size) -> Result<bool, ErrorInfo> {
+        if (chunked) {
+            switch (decoder.feed(data, size)) {
+            case ChunkedDecoder::Status::Malformed:
+                return ErrorInfo{ DicomError::NetworkError, "Malformed chunked HTTP response", url.path };
+            case ChunkedDecoder::Status::Stopped:
+                return false;
+            case ChunkedDecoder::Status::Done:
+                done = true;
+                return true;
+            case ChunkedDecoder::Status::More:
+                return true;
+            }
+        }
+        if (response.content_length >= 0) {
+            size = static_cast<size_t>(std::min<uint64_t>(size,
+                static_cast<uint64_t>(response.content_length) - delivered));
+        }
+        delivered += size;
+        done = response.content_length >= 0 && delivered == static_cast<uint64_t>(response.content_length);
+        return size == 0 || on_body(data, size);
+    };
+
+    auto delivered_first = deliver(body_start.data(), body_start.size());
+    if (delivered_first.is_error() || !delivered_first.value()) {
+        return delivered_first.is_error() ? Result<HttpResponse, ErrorInfo>(delivered_first.error()) : response;
+    }
+    body_start.clear();
+
+    while (!done) {
+        const int64_t received = socket.receive(buffer.data(), buffer.size());
+        if (received == 0 && !chunked && response.content_length < 0) {
+            break;   // the body ends with the connection
+        }
+        if (received <= 0) {
+            return receive_error(received);
+        }
+        auto delivered_more = deliver(buffer.data(), static_cast<size_t>(received));
+        if (delivered_more.is_error()) {
+            return delivered_more.error();
+        }
+        if (!delivered_more.value()) {
+            break;
+        }
+    }
+    return response;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "core/error_codes.hpp"
+#include "core/result.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+struct HttpUrl {
+    std::string host;
+    uint16_t port = 80;
+    std::string path = "/";   // including the query, if any
+};
+
+// http://host[:port][/path]; https is not supported
+Result<HttpUrl, ErrorInfo> parse_http_url(const std::string& url);
+
+struct HttpResponse {
+    int status = 0;
+    std::string content_type;
+    int64_t content_length = -1;   // -1 if chunked or ended by the server closing
+};
+
+// Called with the response headers, before any body bytes
+using HttpResponseHandler = std::function<bool(const HttpResponse&)>;
+
+// Called with the next piece of the body, chunked transfer coding already
+// removed. The bytes point into the receive buffer and are only valid
+// during the call.
+using HttpBodyHandler = std::function<bool(const char* data, size_t size)>;
+
+// HTTP/1.1 GET on a connection of its own. The body is streamed to on_body
+// as it is received, never accumulated; either handler can return false to
+// stop. Fails on a connection error, a truncated body or a status that is
+// not 2xx (the handlers are not called then).
+Result<HttpResponse, ErrorInfo> http_get(const HttpUrl& url, const std::string& accept,
+    const HttpResponseHandler& on_response, const HttpBodyHandler& on_body);
@@ -0,0 +1,178 @@
+#include "instance_ingest.hpp"
+
+// DCMTK includes
+#include <dcmtk/dcmdata/dctk.h>
+
+#include <iostream>
+#include <iterator>
+
+namespace {
+
+// Received data is kept in the transfer syntax the sender used; compressed
+// syntaxes come first so compressed objects are not expanded on the wire
+const char* const kAcceptedTransferSyntaxes[] = {
+    UID_JPEGLSLosslessTransferSyntax,
+    UID_JPEGProcess14SV1TransferSyntax,
+    UID_JPEGProcess14TransferSyntax,
+    UID_JPEGProcess1TransferSyntax,
+    UID_JPEGProcess2_4TransferSyntax,
+    UID_JPEGLSLossyTransferSyntax,
+    UID_RLELosslessTransferSyntax,
+    UID_JPEG2000LosslessOnlyTransferSyntax,
+    UID_JPEG2000TransferSyntax,
+    UID_LittleEndianExplicitTransferSyntax,
+    UID_BigEndianExplicitTransferSyntax,
+    UID_LittleEndianImplicitTransferSyntax,
+};
+
+std::string dataset_string(DcmDataset* dataset, const DcmTagKey& tag) {
+    OFString value;
+    dataset->findAndGetOFString(tag, value);
+    return value.c_str();
+}
+
+} // namespace
+
+InstanceIngest::InstanceIngest(IDicomReader& reader, StudyIndex& index, ImageCache& cache, ThreadPool& pool)
+    : reader_(reader), index_(index), cache_(cache), pool_(pool) {
+}
+
+InstanceIngest::~InstanceIngest() {
+    // Queued decodes refer to this object
+    wait_idle();
+}
+
+const std::vector<std::string>& InstanceIngest::accepted_transfer_syntaxes() {
+    static const std::vector<std::string> uids(std::begin(kAcceptedTransferSyntaxes),
+        std::end(kAcceptedTransferSyntaxes));
+    return uids;
+}
+
+void InstanceIngest::configure(IngestConfig config) {
+    config_ = std::move(config);
+}
+
+void InstanceIngest::set_handler(InstanceHandler handler) {
+    handler_ = std::move(handler);
+}
+
+Result<InstanceRecord, ErrorInfo> InstanceIngest::ingest(std::shared_ptr<DcmFileFormat> file_format) {
+    DcmDataset* dataset = file_format->getDataset();
+
+    OFString sop_instance_uid, study_instance_uid;
+    dataset->findAndGetOFString(DCM_SOPInstanceUID, sop_instance_uid);
+    dataset->findAndGetOFString(DCM_StudyInstanceUID, study_instance_uid);
+    // UIDs become path components, so anything but the UID grammar is refused
+    if (!is_valid_uid(sop_instance_uid.c_str()) || !is_valid_uid(study_instance_uid.c_str()) || dataset->isEmpty()) {
+        count_failure();
+        return ErrorInfo{ DicomError::InvalidMetadata, "Received dataset has no usable Study or SOP Instance UID",
+                         std::string(study_instance_uid.c_str()) + " / " + sop_instance_uid.c_str() };
+    }
+
+    const std::filesystem::path directory = config_.storage_directory / study_instance_uid.c_str();
+    const std::filesystem::path path =
+        (directory / (std::string(sop_instance_uid.c_str()) + ".dcm")).lexically_normal();
+
+    // Stored as received; the file is what the viewer opens later
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    const OFCondition status = file_format->saveFile(path.string().c_str());
+    if (status.bad()) {
+        count_failure();
+        return ErrorInfo{ DicomError::FileNotFound, "Cannot write received instance",
+                         path.string() + ": " + (ec ? ec.message() : status.text()) };
+    }
+
+    InstanceRecord record;
+    record.patient_id = dataset_string(dataset, DCM_PatientID);
+    record.patient_name = dataset_string(dataset, DCM_PatientName);
+    record.study_instance_uid = study_instance_uid.c_str();
+    record.study_description = dataset_string(dataset, DCM_StudyDescription);
+    record.series_instance_uid = dataset_string(dataset, DCM_SeriesInstanceUID);
+    record.series_description = dataset_string(dataset, DCM_SeriesDescription);
+    record.modality = dataset_string(dataset, DCM_Modality);
+    record.sop_class_uid = dataset_string(dataset, DCM_SOPClassUID);
+    record.sop_instance_uid = sop_instance_uid.c_str();
+    Sint32 instance_number = 0;
+    if (dataset->findAndGetSint32(DCM_InstanceNumber, instance_number).good()) {
+        record.instance_number = instance_number;
+    }
+    record.path = path;
+    index_.add(record);
+
+    bool queue_decode = false;
+    {
+        std::lock_guard lock(mutex_);
+        ++stats_.instances_received;
+        stats_.bytes_received += std::filesystem::file_size(path, ec);
+        if (stats_.pending_decodes < config_.max_pending_decodes) {
+            ++stats_.pending_decodes;
+            queue_decode = true;
+        }
+        else {
+            ++stats_.decodes_skipped;
+        }
+    }
+
+    if (handler_) {
+        handler_(record);
+    }
+
+    // The sender is acknowledged as soon as this returns; pixels are decoded
+    // meanwhile, behind whatever the viewer is showing
+    if (queue_decode) {
+        pool_.post([this, file_format = std::move(file_format), record]() mutable {
+            decode(std::move(file_format), std::move(record));
+        }, TaskPriority::Prefetch);
+    }
+    return record;
+}
+
+void InstanceIngest::decode(std::shared_ptr<DcmFileFormat> file_format, InstanceRecord record) {
+    auto result = reader_.decode_complete(record.path, *file_format);
+    file_format.reset();
+
+    if (result.is_ok()) {
+        cache_.insert(record.path.string(), std::move(result.value().first));
+        index_.mark_decoded(record.sop_instance_uid);
+        record.decoded = true;
+    }
+    else {
+        std::cout << "[DEBUG] Could not decode received " << record.path.string() << ": "
+            << result.error().full_message() << std::endl;
+    }
+
+    if (record.decoded && handler_) {
+        handler_(record);
+    }
+
+    std::lock_guard lock(mutex_);
+    if (record.decoded) {
+        ++stats_.instances_decoded;
+    }
+    if (--stats_.pending_decodes == 0) {
+        idle_.notify_all();
+    }
+}
+
+void InstanceIngest::count_failure() {
+    std::lock_guard lock(mutex_);
+    ++stats_.instances_failed;
+}
+
+IngestStats InstanceIngest::stats() const {
+    std::lock_guard lock(mutex_);
+    return stats_;
+}
+
+void InstanceIngest::reset_stats() {
+    std::lock_guard lock(mutex_);
+    const uint32_t pending = stats_.pending_decodes;
+    stats_ = IngestStats{};
+    stats_.pending_decodes = pending;
+}
+
+void InstanceIngest::wait_idle() {
+    std::unique_lock lock(mutex_);
+    idle_.wait(lock, [this]() { return stats_.pending_decodes == 0; });
+}
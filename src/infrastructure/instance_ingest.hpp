@@ -0,0 +1,84 @@
+#pragma once
+
+#include "core/error_codes.hpp"
+#include "core/image_cache.hpp"
+#include "core/result.hpp"
+#include "core/study_index.hpp"
+#include "core/thread_pool.hpp"
+#include "dcmtk_wrapper.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct IngestConfig {
+    std::filesystem::path storage_directory;  // files go to <dir>/<Study UID>/<SOP UID>.dcm
+    uint32_t max_pending_decodes = 64;        // beyond this, instances are only indexed
+};
+
+struct IngestStats {
+    uint64_t instances_received = 0;
+    uint64_t instances_failed = 0;
+    uint64_t bytes_received = 0;      // size of the stored files
+    uint64_t instances_decoded = 0;
+    uint64_t decodes_skipped = 0;     // not decoded because the decode queue was full
+    uint32_t pending_decodes = 0;
+};
+
+// Where instances arriving over the network end up, whichever service
+// delivered them (C-STORE, C-GET): each dataset is written to disk and added
+// to the study index, then its pixels are decoded on the thread pool from
+// the dataset still in memory and land in the image cache under the stored
+// file's path. Safe to call from several receiving threads.
+class InstanceIngest {
+public:
+    // Called once an instance is indexed, and again (with decoded set) once
+    // its pixels are in the cache; runs on the receiving or a pool thread
+    using InstanceHandler = std::function<void(const InstanceRecord&)>;
+
+    InstanceIngest(IDicomReader& reader, StudyIndex& index, ImageCache& cache,
+        ThreadPool& pool = ThreadPool::shared());
+    ~InstanceIngest();
+
+    InstanceIngest(const InstanceIngest&) = delete;
+    InstanceIngest& operator=(const InstanceIngest&) = delete;
+
+    // Transfer syntaxes receivers accept, compressed ones first
+    static const std::vector<std::string>& accepted_transfer_syntaxes();
+
+    // Set while nothing is being ingested
+    void configure(IngestConfig config);
+    void set_handler(InstanceHandler handler);
+
+    // Stores and indexes a received dataset and queues its decode. Fails with
+    // InvalidMetadata if its UIDs are unusable, FileNotFound if it cannot be written.
+    Result<InstanceRecord, ErrorInfo> ingest(std::shared_ptr<DcmFileFormat> file_format);
+
+    // Counts an instance that could not even be received
+    void count_failure();
+
+    IngestStats stats() const;
+    void reset_stats();
+
+    // Blocks until no decode is pending
+    void wait_idle();
+
+private:
+    IDicomReader& reader_;
+    StudyIndex& index_;
+    ImageCache& cache_;
+    ThreadPool& pool_;
+
+    IngestConfig config_;
+    InstanceHandler handler_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable idle_;
+    IngestStats stats_;
+
+    void decode(std::shared_ptr<DcmFileFormat> file_format, InstanceRecord record);
+};
@@ -0,0 +1,170 @@
+#include "mapped_file.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <atomic>
+#include <string>
+#include <utility>
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr))
+    , size_(std::exchange(other.size_, 0))
+    , writable_(std::exchange(other.writable_, false))
+#ifdef _WIN32
+    , file_handle_(std::exchange(other.file_handle_, nullptr))
+    , mapping_handle_(std::exchange(other.mapping_handle_, nullptr))
+#endif
+{
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+        writable_ = std::exchange(other.writable_, false);
+#ifdef _WIN32
+        file_handle_ = std::exchange(other.file_handle_, nullptr);
+        mapping_handle_ = std::exchange(other.mapping_handle_, nullptr);
+#endif
+    }
+    return *this;
+}
+
+Result<MappedFile, ErrorInfo> MappedFile::open(const std::filesystem::path& path) {
+    MappedFile mapped;
+
+#ifdef _WIN32
+    HANDLE file = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ,
+        nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return ErrorInfo{ DicomError::FileNotFound, "Failed to open file", path.string() };
+    }
+    mapped.file_handle_ = file;
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+        return ErrorInfo{ DicomError::InvalidFormat, "Cannot map empty file", path.string() };
+    }
+    mapped.size_ = static_cast<size_t>(file_size.QuadPart);
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        return ErrorInfo{ DicomError::MemoryAllocationFailed, "Failed to map file", path.string() };
+    }
+    mapped.mapping_handle_ = mapping;
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        return ErrorInfo{ DicomError::MemoryAllocationFailed, "Failed to map file", path.string() };
+    }
+    mapped.data_ = static_cast<uint8_t*>(view);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return ErrorInfo{ DicomError::FileNotFound, "Failed to open file", path.string() };
+    }
+
+    struct stat st {};
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return ErrorInfo{ DicomError::InvalidFormat, "Cannot map empty file", path.string() };
+    }
+
+    void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+
+    if (view == MAP_FAILED) {
+        return ErrorInfo{ DicomError::MemoryAllocationFailed, "Failed to map file", path.string() };
+    }
+
+    mapped.data_ = static_cast<uint8_t*>(view);
+    mapped.size_ = static_cast<size_t>(st.st_size);
+#endif
+
+    return mapped;
+}
+
+Result<MappedFile, ErrorInfo> MappedFile::create_scratch(const std::filesystem::path& directory, size_t size) {
+    MappedFile mapped;
+    if (size == 0) {
+        return ErrorInfo{ DicomError::MemoryAllocationFailed, "Cannot map empty file", directory.string() };
+    }
+
+#ifdef _WIN32
+    static std::atomic<uint32_t> counter{ 0 };
+    const auto path = directory / ("dicom_viewer_scratch_" + std::to_string(GetCurrentProcessId()) + "_" +
+        std::to_string(counter++) + ".tmp");
+    HANDLE file = CreateFileW(path.wstring().c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr,
+        CREATE_ALWAYS, FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return ErrorInfo{ DicomError::FileNotFound, "Failed to create scratch file", path.string() };
+    }
+    mapped.file_handle_ = file;
+
+    ULARGE_INTEGER file_size;
+    file_size.QuadPart = size;
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READWRITE,
+        file_size.HighPart, file_size.LowPart, nullptr);
+    if (!mapping) {
+        return ErrorInfo{ DicomError::MemoryAllocationFailed, "Failed to map scratch file", path.string() };
+    }
+    mapped.mapping_handle_ = mapping;
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (!view) {
+        return ErrorInfo{ DicomError::MemoryAllocationFailed, "Failed to map scratch file", path.string() };
+    }
+#else
+    std::string name = (directory / "dicom_viewer_scratch_XXXXXX").string();
+    int fd = mkstemp(name.data());
+    if (fd < 0) {
+        return ErrorInfo{ DicomError::FileNotFound, "Failed to create scratch file", directory.string() };
+    }
+    // The file lives on only through the descriptor and then the mapping
+    ::unlink(name.c_str());
+
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        ::close(fd);
+        return ErrorInfo{ DicomError::MemoryAllocationFailed, "Failed to size scratch file", name };
+    }
+
+    void* view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+
+    if (view == MAP_FAILED) {
+        return ErrorInfo{ DicomError::MemoryAllocationFailed, "Failed to map scratch file", name };
+    }
+#endif
+
+    mapped.data_ = static_cast<uint8_t*>(view);
+    mapped.size_ = size;
+    mapped.writable_ = true;
+    return mapped;
+}
+
+void MappedFile::close() noexcept {
+#ifdef _WIN32
+    if (data_) UnmapViewOfFile(data_);
+    if (mapping_handle_) CloseHandle(mapping_handle_);
+    if (file_handle_) CloseHandle(file_handle_);
+    mapping_handle_ = nullptr;
+    file_handle_ = nullptr;
+#else
+    if (data_) munmap(data_, size_);
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    writable_ = false;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "core/result.hpp"
+#include "core/error_codes.hpp"
+#include <filesystem>
+#include <cstddef>
+#include <cstdint>
+
+// Memory mapping of a whole file (RAII): read-only views of existing files,
+// or writable scratch files that are deleted when the mapping is closed
+class MappedFile {
+    uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    bool writable_ = false;
+#ifdef _WIN32
+    void* file_handle_ = nullptr;
+    void* mapping_handle_ = nullptr;
+#endif
+
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    static Result<MappedFile, ErrorInfo> open(const std::filesystem::path& path);
+
+    // New zero-filled file of the given size in directory, mapped read-write.
+    // Pages are written back to the file rather than to swap under memory pressure.
+    static Result<MappedFile, ErrorInfo> create_scratch(const std::filesystem::path& directory, size_t size);
+
+    const uint8_t* data() const { return data_; }
+    uint8_t* writable_data() { return writable_ ? data_ : nullptr; }
+    size_t size() const { return size_; }
+
+private:
+    void close() noexcept;
+};
@@ -0,0 +1,78 @@
+#include "memory_usage.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#endif
+
+#ifdef _WIN32
+
+MemoryUsage current_memory_usage() {
+    MemoryUsage usage;
+    PROCESS_MEMORY_COUNTERS counters{};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        usage.resident_bytes = counters.WorkingSetSize;
+        usage.peak_resident_bytes = counters.PeakWorkingSetSize;
+        // Windows does not split soft and hard faults
+        usage.minor_page_faults = counters.PageFaultCount;
+    }
+    return usage;
+}
+
+bool reset_peak_memory() {
+    return false;
+}
+
+uint64_t physical_memory_bytes() {
+    MEMORYSTATUSEX status{};
+    status.dwLength = sizeof(status);
+    return GlobalMemoryStatusEx(&status) ? status.ullTotalPhys : 0;
+}
+
+#else
+
+MemoryUsage current_memory_usage() {
+    MemoryUsage usage;
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        // Lines look like "VmRSS:     12345 kB"
+        if (line.rfind("VmRSS:", 0) == 0) {
+            usage.resident_bytes = std::strtoull(line.c_str() + 6, nullptr, 10) * 1024;
+        }
+        else if (line.rfind("VmHWM:", 0) == 0) {
+            usage.peak_resident_bytes = std::strtoull(line.c_str() + 6, nullptr, 10) * 1024;
+        }
+    }
+
+    rusage resources{};
+    if (getrusage(RUSAGE_SELF, &resources) == 0) {
+        usage.minor_page_faults = static_cast<uint64_t>(resources.ru_minflt);
+        usage.major_page_faults = static_cast<uint64_t>(resources.ru_majflt);
+    }
+    return usage;
+}
+
+bool reset_peak_memory() {
+    // Writing 5 to clear_refs resets VmHWM to the current RSS (Linux 4.0+)
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    if (!clear_refs) {
+        return false;
+    }
+    clear_refs << "5";
+    return static_cast<bool>(clear_refs.flush());
+}
+
+uint64_t physical_memory_bytes() {
+    const long pages = sysconf(_SC_PHYS_PAGES);
+    const long page_size = sysconf(_SC_PAGESIZE);
+    return pages > 0 && page_size > 0 ? static_cast<uint64_t>(pages) * static_cast<uint64_t>(page_size) : 0;
+}
+
+#endif
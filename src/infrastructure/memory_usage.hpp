@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+
+// Process memory as reported by the operating system
+struct MemoryUsage {
+    uint64_t resident_bytes = 0;        // current resident set
+    uint64_t peak_resident_bytes = 0;   // high-water mark since start or last reset
+    uint64_t minor_page_faults = 0;     // cumulative, served without I/O
+    uint64_t major_page_faults = 0;     // cumulative, required I/O
+};
+
+MemoryUsage current_memory_usage();
+
+// Restart the peak counter from the current resident set, so the next
+// reading covers only what happens afterwards. Returns false where the
+// platform cannot reset it (the peak then stays process-wide).
+bool reset_peak_memory();
+
+// Installed physical memory, 0 if unknown
+uint64_t physical_memory_bytes();
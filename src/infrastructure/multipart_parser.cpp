@@ -0,0 +1,255 @@
+#include "multipart_parser.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace {
+
+// Longest header block accepted for one part
+constexpr size_t kMaxHeaderBlock = 16 * 1024;
+
+std::string to_lower(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(),
+        [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return text;
+}
+
+std::string trim(const std::string& text) {
+    const size_t first = text.find_first_not_of(" \t");
+    if (first == std::string::npos) {
+        return {};
+    }
+    return text.substr(first, text.find_last_not_of(" \t") - first + 1);
+}
+
+ErrorInfo malformed(const std::string& details) {
+    return ErrorInfo{ DicomError::NetworkError, "Malformed multipart response", details };
+}
+
+} // namespace
+
+std::optional<MultipartType> parse_multipart_content_type(const std::string& content_type) {
+    // Split on semicolons outside quoted strings
+    std::vector<std::string> fields(1);
+    bool quoted = false;
+    for (char c : content_type) {
+        if (c == '"') {
+            quoted = !quoted;
+        }
+        if (c == ';' && !quoted) {
+            fields.emplace_back();
+        }
+        else {
+            fields.back() += c;
+        }
+    }
+    if (to_lower(trim(fields.front())).rfind("multipart/", 0) != 0) {
+        return std::nullopt;
+    }
+
+    MultipartType result;
+    for (size_t i = 1; i < fields.size(); ++i) {
+        const size_t equals = fields[i].find('=');
+        if (equals == std::string::npos) {
+            continue;
+        }
+        const std::string name = to_lower(trim(fields[i].substr(0, equals)));
+        std::string value = trim(fields[i].substr(equals + 1));
+        if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+            value = value.substr(1, value.size() - 2);
+        }
+        if (name == "boundary") {
+            result.boundary = value;
+        }
+        else if (name == "type") {
+            result.type = to_lower(value);
+        }
+    }
+    if (result.boundary.empty()) {
+        return std::nullopt;
+    }
+    return result;
+}
+
+std::string MultipartHeaders::get(const std::string& name) const {
+    for (const auto& [field, value] : fields) {
+        if (field == name) {
+            return value;
+        }
+    }
+    return {};
+}
+
+MultipartParser::MultipartParser(const std::string& boundary, Handler handler)
+    : delimiter_("\r\n--" + boundary), handler_(std::move(handler)) {
+    // The first delimiter may open the body without a CRLF before it
+    matched_ = 2;
+}
+
+Result<bool, ErrorInfo> MultipartParser::feed(const char* data, size_t size) {
+    size_t i = 0;
+    while (i < size) {
+        switch (state_) {
+        case State::Preamble:
+        case State::Body: {
+            auto consumed = scan_body(data + i, size - i);
+            if (consumed.is_error()) {
+                return consumed.error();
+            }
+            i += consumed.value();
+            break;
+        }
+        case State::DelimiterLine: {
+            const char c = data[i++];
+            if (c == '-') {
+                state_ = State::CloseDash;
+            }
+            else if (c == '\r') {
+                state_ = State::DelimiterLf;
+            }
+            else if (c != ' ' && c != '\t') {
+                return malformed("unexpected character after a boundary");
+            }
+            break;
+        }
+        case State::DelimiterLf:
+            if (data[i++] != '\n') {
+                return malformed("boundary line not terminated by CRLF");
+            }
+            // Seeded with the CRLF ending the boundary line, so that an
+            // empty header block is simply the next CRLF
+            header_block_ = "\r\n";
+            state_ = State::Headers;
+            break;
+        case State::CloseDash:
+            if (data[i++] != '-') {
+                return malformed("unexpected character after a boundary");
+            }
+            state_ = State::Epilogue;
+            break;
+        case State::Headers: {
+            header_block_ += data[i++];
+            const size_t n = header_block_.size();
+            if (n >= 4 && header_block_.compare(n - 4, 4, "\r\n\r\n") == 0) {
+                auto begun = begin_part();
+                if (begun.is_error()) {
+                    return begun.error();
+                }
+                state_ = State::Body;
+            }
+            else if (n > kMaxHeaderBlock) {
+                return malformed("part headers exceed " + std::to_string(kMaxHeaderBlock) + " bytes");
+            }
+            break;
+        }
+        case State::Epilogue:
+            return true;
+        }
+    }
+    return true;
+}
+
+Result<size_t, ErrorInfo> MultipartParser::scan_body(const char* data, size_t size) {
+    size_t i = 0;
+
+    // A delimiter split across feeds
+    if (matched_ > 0) {
+        while (matched_ < delimiter_.size() && i < size && data[i] == delimiter_[matched_]) {
+            ++matched_;
+            ++i;
+        }
+        if (i == size && matched_ < delimiter_.size()) {
+            return size;
+        }
+        if (matched_ < delimiter_.size()) {
+            // Body bytes after all. Only the first delimiter byte is a CR and
+            // boundaries cannot contain one, so no delimiter starts inside them.
+            auto emitted = emit(delimiter_.data(), matched_);
+            matched_ = 0;
+            if (emitted.is_error()) {
+                return emitted.error();
+            }
+        }
+    }
+
+    const size_t start = i;
+    size_t end = size;       // body bytes end here
+    bool found = matched_ == delimiter_.size();
+    if (found) {
+        end = i;
+    }
+    while (!found && i < size) {
+        const void* cr = std::memchr(data + i, '\r', size - i);
+        if (cr == nullptr) {
+            break;
+        }
+        const size_t j = static_cast<size_t>(static_cast<const char*>(cr) - data);
+        size_t k = 0;
+        while (k < delimiter_.size() && j + k < size && data[j + k] == delimiter_[k]) {
+            ++k;
+        }
+        if (k == delimiter_.size()) {
+            end = j;
+            i = j + k;
+            found = true;
+        }
+        else if (j + k == size) {
+            // Possibly a delimiter continuing in the next feed; hold it back
+            end = j;
+            matched_ = k;
+            i = size;
+        }
+        else {
+            i = j + 1;
+        }
+    }
+    if (!found) {
+        i = size;
+    }
+
+    auto emitted = emit(data + start, end - start);
+    if (emitted.is_error()) {
+        return emitted.error();
+    }
+    if (found) {
+        matched_ = 0;
+        if (state_ == State::Body && handler_.end && !handler_.end()) {
+            return ErrorInfo{ DicomError::NetworkError, "Multipart part rejected", "part " + std::to_string(parts_) };
+        }
+        state_ = State::DelimiterLine;
+    }
+    return i;
+}
+
+Result<bool, ErrorInfo> MultipartParser::emit(const char* data, size_t size) {
+    if (state_ != State::Body || size == 0 || !handler_.data) {
+        return true;
+    }
+    if (!handler_.data(data, size)) {
+        return ErrorInfo{ DicomError::NetworkError, "Multipart part rejected", "part " + std::to_string(parts_) };
+    }
+    return true;
+}
+
+Result<bool, ErrorInfo> MultipartParser::begin_part() {
+    MultipartHeaders headers;
+    size_t line_start = 2;   // past the seeded CRLF
+    while (line_start + 2 < header_block_.size()) {
+        const size_t line_end = header_block_.find("\r\n", line_start);
+        const std::string line = header_block_.substr(line_start, line_end - line_start);
+        const size_t colon = line.find(':');
+        if (colon == std::string::npos) {
+            return malformed("part header without a colon: " + line);
+        }
+        headers.fields.emplace_back(to_lower(trim(line.substr(0, colon))), trim(line.substr(colon + 1)));
+        line_start = line_end + 2;
+    }
+    header_block_.clear();
+    ++parts_;
+
+    if (handler_.begin && !handler_.begin(headers)) {
+        return ErrorInfo{ DicomError::NetworkError, "Multipart part rejected", "part " + std::to_string(parts_) };
+    }
+    return true;
+}
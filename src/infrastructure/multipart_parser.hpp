@@ -0,0 +1,75 @@
+#pragma once
+
+#include "core/error_codes.hpp"
+#include "core/result.hpp"
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Media type of a multipart response, from its Content-Type header
+struct MultipartType {
+    std::string boundary;
+    std::string type;   // the "type" parameter, e.g. application/dicom
+};
+
+// Parses `multipart/related; type="application/dicom"; boundary=...`;
+// empty if the content type is not multipart or has no boundary
+std::optional<MultipartType> parse_multipart_content_type(const std::string& content_type);
+
+// Headers of one body part, names lower-cased
+struct MultipartHeaders {
+    std::vector<std::pair<std::string, std::string>> fields;
+
+    // Value of the named (lower-case) header, empty if absent
+    std::string get(const std::string& name) const;
+};
+
+// Incremental parser for a multipart body (RFC 2046). Bytes are fed as they
+// come off the wire, split anywhere. Part bodies are reported as pointers
+// into the fed bytes, never copied; only a header block, or the first bytes
+// of a delimiter split across two feeds, is held between calls.
+class MultipartParser {
+public:
+    struct Handler {
+        std::function<bool(const MultipartHeaders&)> begin;   // a part starts
+        std::function<bool(const char*, size_t)> data;        // next bytes of its body
+        std::function<bool()> end;                            // its closing delimiter arrived
+    };
+
+    MultipartParser(const std::string& boundary, Handler handler);
+
+    // Fails on a malformed body or when a handler returns false
+    Result<bool, ErrorInfo> feed(const char* data, size_t size);
+
+    // Whether the close delimiter was seen; anything after it is ignored
+    bool finished() const { return state_ == State::Epilogue; }
+
+    size_t parts() const { return parts_; }
+
+private:
+    enum class State {
+        Preamble,         // before the first delimiter
+        DelimiterLine,    // after a delimiter: "--" or padding up to CRLF
+        DelimiterLf,
+        CloseDash,
+        Headers,
+        Body,
+        Epilogue,
+    };
+
+    std::string delimiter_;   // CRLF "--" boundary
+    Handler handler_;
+    State state_ = State::Preamble;
+    size_t matched_ = 0;      // delimiter bytes matched at the end of the last feed
+    std::string header_block_;
+    size_t parts_ = 0;
+
+    // Scans for the delimiter, passing body bytes on unless in the preamble.
+    // Returns the bytes consumed; stops right after a delimiter.
+    Result<size_t, ErrorInfo> scan_body(const char* data, size_t size);
+    Result<bool, ErrorInfo> emit(const char* data, size_t size);
+    Result<bool, ErrorInfo> begin_part();
+};
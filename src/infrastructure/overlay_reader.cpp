@@ -0,0 +1,172 @@
+#include "overlay_reader.hpp"
+#include "core/mask_blend.hpp"
+
+// DCMTK includes
+#include <dcmtk/dcmdata/dctk.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+namespace {
+
+constexpr Uint16 kFirstOverlayGroup = 0x6000;
+constexpr Uint16 kLastOverlayGroup = 0x601E;
+
+DcmTagKey in_group(Uint16 group, const DcmTagKey& key) {
+    return DcmTagKey(group, key.getElement());
+}
+
+// Image attributes the planes are checked against
+struct ImageLayout {
+    Uint16 rows = 0;
+    Uint16 columns = 0;
+    Uint16 bits_allocated = 0;
+    Uint16 bits_stored = 0;
+    Uint16 high_bit = 0;
+    uint32_t frames = 1;
+    bool native = false;
+};
+
+// Overlay Data holds the plane's frames back to back at one bit per pixel,
+// least significant bit first. OW values are in host byte order, which is
+// little endian on the hosts we build for, so both VRs read as bytes. Each
+// frame is unpacked into scratch and kept as runs; short data keeps the
+// frames it has in full.
+bool unpack_overlay_data(DcmElement& data, uint32_t frames, OverlayPlane& plane) {
+    Uint8* bytes = nullptr;
+    if (data.getUint8Array(bytes).bad() || !bytes) {
+        Uint16* words = nullptr;
+        if (data.getUint16Array(words).bad() || !words) return false;
+        bytes = reinterpret_cast<Uint8*>(words);
+    }
+
+    const size_t available = static_cast<size_t>(data.getLength()) * 8 / plane.frame_pixels();
+    frames = static_cast<uint32_t>(std::min<size_t>(frames, available));
+    std::vector<uint8_t> scratch(plane.frame_pixels());
+    for (uint32_t f = 0; f < frames; ++f) {
+        unpack_bits(bytes, f * plane.frame_pixels(), plane.frame_pixels(), scratch.data());
+        plane.add_frame(scratch.data());
+    }
+    return frames > 0;
+}
+
+// An overlay in a bit of native 16-bit Pixel Data outside Bits Stored,
+// one frame per image frame from the plane's first
+bool extract_embedded(DcmDataset& dataset, const ImageLayout& image, Uint16 bit_position, uint32_t frames,
+    OverlayPlane& plane) {
+    const unsigned low_bit = static_cast<unsigned>(image.high_bit + 1 - image.bits_stored);
+    if (!image.native || image.bits_allocated != 16 || bit_position >= 16 ||
+        (bit_position >= low_bit && bit_position <= image.high_bit) ||
+        plane.width != image.columns || plane.height != image.rows || plane.first_frame >= image.frames) {
+        return false;
+    }
+
+    const Uint16* words = nullptr;
+    unsigned long count = 0;
+    if (dataset.findAndGetUint16Array(DCM_PixelData, words, &count).bad() || !words) return false;
+    const size_t available = count / plane.frame_pixels();
+    const size_t after_first = available > plane.first_frame ? available - plane.first_frame : 0;
+    frames = static_cast<uint32_t>(std::min<size_t>(
+        { size_t{ frames }, size_t{ image.frames - plane.first_frame }, after_first }));
+
+    std::vector<uint8_t> scratch(plane.frame_pixels());
+    for (uint32_t f = 0; f < frames; ++f) {
+        extract_bit_plane(words + (plane.first_frame + f) * plane.frame_pixels(), plane.frame_pixels(),
+            bit_position, scratch.data());
+        plane.add_frame(scratch.data());
+    }
+    plane.embedded = true;
+    return frames > 0;
+}
+
+} // namespace
+
+OverlayPlanes read_overlays(DcmDataset& dataset) {
+    const auto start = std::chrono::steady_clock::now();
+
+    ImageLayout image;
+    dataset.findAndGetUint16(DCM_Rows, image.rows);
+    dataset.findAndGetUint16(DCM_Columns, image.columns);
+    dataset.findAndGetUint16(DCM_BitsAllocated, image.bits_allocated);
+    dataset.findAndGetUint16(DCM_BitsStored, image.bits_stored);
+    dataset.findAndGetUint16(DCM_HighBit, image.high_bit);
+    Sint32 frames = 1;
+    if (dataset.findAndGetSint32(DCM_NumberOfFrames, frames).good() && frames > 1) {
+        image.frames = static_cast<uint32_t>(frames);
+    }
+    image.native = !DcmXfer(dataset.getOriginalXfer()).isPixelDataCompressed();
+
+    OverlayPlanes planes;
+    for (Uint16 group = kFirstOverlayGroup; group <= kLastOverlayGroup; group += 2) {
+        Uint16 rows = 0, columns = 0;
+        if (dataset.findAndGetUint16(in_group(group, DCM_OverlayRows), rows).bad() ||
+            dataset.findAndGetUint16(in_group(group, DCM_OverlayColumns), columns).bad() ||
+            rows == 0 || columns == 0) {
+            continue;
+        }
+
+        OverlayPlane plane;
+        plane.group = group;
+        plane.width = columns;
+        plane.height = rows;
+
+        OFString text;
+        if ((dataset.findAndGetOFString(in_group(group, DCM_OverlayLabel), text).good() && !text.empty()) ||
+            (dataset.findAndGetOFString(in_group(group, DCM_OverlayDescription), text).good() && !text.empty())) {
+            plane.label = text.c_str();
+        }
+        plane.roi = dataset.findAndGetOFString(in_group(group, DCM_OverlayType), text).good() && text == "R";
+
+        Sint16 origin_row = 1, origin_column = 1;
+        dataset.findAndGetSint16(in_group(group, DCM_OverlayOrigin), origin_row, 0);
+        dataset.findAndGetSint16(in_group(group, DCM_OverlayOrigin), origin_column, 1);
+        plane.row_origin = origin_row - 1;
+        plane.column_origin = origin_column - 1;
+
+        Sint32 overlay_frames = 0;
+        Uint16 frame_origin = 1;
+        dataset.findAndGetUint16(in_group(group, DCM_ImageFrameOrigin), frame_origin);
+        plane.first_frame = frame_origin > 0 ? frame_origin - 1u : 0u;
+        const bool has_frames =
+            dataset.findAndGetSint32(in_group(group, DCM_NumberOfFramesInOverlay), overlay_frames).good() &&
+            overlay_frames > 0;
+
+        bool read = false;
+        DcmElement* data = nullptr;
+        if (dataset.findAndGetElement(in_group(group, DCM_OverlayData), data).good() && data->getLength() > 0) {
+            plane.every_frame = !has_frames;
+            read = unpack_overlay_data(*data, has_frames ? static_cast<uint32_t>(overlay_frames) : 1, plane);
+        }
+        else {
+            // Each image frame carries its own bits, so these never repeat
+            Uint16 bit_position = 0;
+            dataset.findAndGetUint16(in_group(group, DCM_OverlayBitPosition), bit_position);
+            read = extract_embedded(dataset, image, bit_position,
+                has_frames ? static_cast<uint32_t>(overlay_frames) : image.frames, plane);
+        }
+
+        if (!read) {
+            std::cout << "[DEBUG] Skipped unreadable overlay plane " << std::hex << group << std::dec << std::endl;
+            continue;
+        }
+        planes.push_back(std::move(plane));
+    }
+
+    if (!planes.empty()) {
+        const auto elapsed = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+        std::cout << "[DEBUG] Extracted " << planes.size() << " overlay planes ("
+            << overlay_memory_bytes(planes) / 1024 << " KB) in " << elapsed << " ms" << std::endl;
+    }
+    return planes;
+}
+
+Result<OverlayPlanes, ErrorInfo> read_overlays(const std::filesystem::path& path) {
+    DcmFileFormat file_format;
+    OFCondition status = file_format.loadFile(path.string().c_str());
+    if (status.bad()) {
+        return ErrorInfo{ DicomError::InvalidFormat, "Failed to load DICOM file", status.text() };
+    }
+    return read_overlays(*file_format.getDataset());
+}
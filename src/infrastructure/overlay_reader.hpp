@@ -0,0 +1,19 @@
+#pragma once
+
+#include "core/result.hpp"
+#include "core/error_codes.hpp"
+#include "core/overlay.hpp"
+#include <filesystem>
+
+class DcmDataset;
+
+// Reads the overlay planes of groups 6000-601E into runs of set pixels:
+// Overlay Data (1 bit per pixel, OB or OW) is expanded frame by frame with
+// the SIMD bit unpacker, and overlays embedded in the unused high bits of
+// native 16-bit Pixel Data by testing that bit of every sample. Must run
+// before DCMTK's image classes detach the pixel data and mask the high
+// bits. Planes that are malformed or cannot be read are left out.
+OverlayPlanes read_overlays(DcmDataset& dataset);
+
+// Same, loading the file at path
+Result<OverlayPlanes, ErrorInfo> read_overlays(const std::filesystem::path& path);
@@ -0,0 +1,379 @@
+#include "pixel_cache.hpp"
+#include "mapped_file.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace {
+
+constexpr char kMagic[4] = { 'D', 'V', 'P', 'C' };
+constexpr uint32_t kVersion = 3;
+constexpr size_t kUidCapacity = 72;
+constexpr const char* kExtension = ".dvpc";
+
+// Eviction frees space down to this share of max_bytes
+constexpr uint64_t kLowWaterPercent = 80;
+
+// Histogram and pixels start on cache-line aligned offsets inside the file
+constexpr uint64_t kHeaderBytes = 256;
+constexpr uint64_t kHistogramOffset = kHeaderBytes;
+constexpr uint64_t kPixelOffset =
+    kHistogramOffset + PixelStatistics::kHistogramBins * sizeof(uint32_t);
+
+static_assert(kPixelOffset % 64 == 0, "pixel data must be cache-line aligned");
+
+uint64_t fnv1a(const void* data, size_t size, uint64_t hash = 14695981039346656037ull) {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Whether [offset, offset + size) lies inside a file of file_size bytes
+bool section_fits(uint64_t file_size, uint64_t offset, uint64_t size) {
+    return offset <= file_size && size <= file_size - offset;
+}
+
+} // namespace
+
+struct PixelCache::EntryHeader {
+    char magic[4];
+    uint32_t version;
+    char sop_instance_uid[kUidCapacity];
+    uint32_t frame;
+    uint32_t width;
+    uint64_t fingerprint;
+    uint32_t height;
+    uint16_t bits_allocated;
+    uint16_t bits_stored;
+    int32_t window_center;
+    int32_t window_width;
+    uint16_t min_value;
+    uint16_t max_value;
+    uint8_t is_signed;
+    uint8_t stored_values;        // a multi-frame object's frame before normalization
+    uint8_t reserved[2];
+    uint64_t histogram_offset;
+    uint64_t pixel_offset;
+    double modality_slope;
+    double modality_intercept;
+    int32_t stored_min;           // stored value range of a stored_values entry
+    int32_t stored_max;
+};
+
+struct PixelCache::Entry {
+    std::shared_ptr<const MappedFile> file;
+    EntryHeader header;
+
+    PixelBuffer pixels() const {
+        return PixelBuffer::wrap(PixelFormat::Gray16, uint64_t{ header.width } * header.height,
+            file, file->data() + header.pixel_offset);
+    }
+};
+
+PixelCache::PixelCache(PixelCacheConfig config)
+    : config_(std::move(config)), total_bytes_(0) {
+    std::error_code ec;
+    std::filesystem::create_directories(config_.directory, ec);
+    scan_directory();
+}
+
+uint64_t PixelCache::fingerprint(const std::filesystem::path& path) {
+    std::error_code ec;
+    const uint64_t file_size = std::filesystem::file_size(path, ec);
+    if (ec) return 0;
+
+    const auto mtime = std::filesystem::last_write_time(path, ec).time_since_epoch().count();
+
+    uint64_t hash = fnv1a(&file_size, sizeof(file_size));
+    hash = fnv1a(&mtime, sizeof(mtime), hash);
+
+    std::ifstream in(path, std::ios::binary);
+    std::vector<char> block(4096);
+
+    in.read(block.data(), static_cast<std::streamsize>(block.size()));
+    hash = fnv1a(block.data(), static_cast<size_t>(in.gcount()), hash);
+
+    if (file_size > block.size()) {
+        in.clear();
+        in.seekg(-static_cast<std::streamoff>(block.size()), std::ios::end);
+        in.read(block.data(), static_cast<std::streamsize>(block.size()));
+        hash = fnv1a(block.data(), static_cast<size_t>(in.gcount()), hash);
+    }
+
+    return hash;
+}
+
+std::filesystem::path PixelCache::entry_path(const PixelCacheKey& key, bool stored_values) const {
+    uint64_t hash = fnv1a(key.sop_instance_uid.data(), key.sop_instance_uid.size());
+    hash = fnv1a(&key.frame, sizeof(key.frame), hash);
+    hash = fnv1a(&key.fingerprint, sizeof(key.fingerprint), hash);
+    hash = fnv1a(&stored_values, sizeof(stored_values), hash);
+
+    char name[17];
+    std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(hash));
+    return config_.directory / (std::string(name) + kExtension);
+}
+
+std::optional<PixelCache::Entry> PixelCache::open_entry(const PixelCacheKey& key, bool stored_values) {
+    const auto path = entry_path(key, stored_values);
+
+    auto mapped = MappedFile::open(path);
+    if (mapped.is_error()) {
+        return std::nullopt;
+    }
+
+    auto file = std::make_shared<const MappedFile>(std::move(mapped.value()));
+    if (file->size() < kPixelOffset) {
+        return std::nullopt;
+    }
+
+    EntryHeader header;
+    std::memcpy(&header, file->data(), sizeof(header));
+
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+        header.version != kVersion || header.stored_values != (stored_values ? 1 : 0) ||
+        header.frame != key.frame || header.fingerprint != key.fingerprint ||
+        std::strncmp(header.sop_instance_uid, key.sop_instance_uid.c_str(), kUidCapacity) != 0) {
+        return std::nullopt;
+    }
+
+    // Offsets come from disk: only the layout write_entry() produces is
+    // accepted, and every section must lie inside the file
+    if (header.histogram_offset != kHistogramOffset || header.pixel_offset != kPixelOffset ||
+        !section_fits(file->size(), header.histogram_offset, PixelStatistics::kHistogramBins * sizeof(uint32_t))) {
+        return std::nullopt;
+    }
+    const uint64_t pixel_count = uint64_t{ header.width } * header.height;
+    if (pixel_count == 0 || pixel_count > (UINT64_MAX - header.pixel_offset) / sizeof(uint16_t) ||
+        !section_fits(file->size(), header.pixel_offset, pixel_count * sizeof(uint16_t))) {
+        return std::nullopt;
+    }
+
+    // Refresh recency for LRU eviction; the file time carries it across runs
+    std::error_code ec;
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+    {
+        std::lock_guard lock(mutex_);
+        touch_locked(path.filename().string(), file->size());
+    }
+
+    return Entry{ std::move(file), header };
+}
+
+std::optional<ImageData> PixelCache::lookup(const PixelCacheKey& key) {
+    auto entry = open_entry(key, false);
+    if (!entry) {
+        return std::nullopt;
+    }
+    const EntryHeader& header = entry->header;
+
+    ImageData img_data;
+    img_data.width = header.width;
+    img_data.height = header.height;
+    img_data.bits_allocated = header.bits_allocated;
+    img_data.bits_stored = header.bits_stored;
+    img_data.samples_per_pixel = 1;
+    img_data.is_signed = header.is_signed != 0;
+    img_data.photometric = PhotometricInterpretation::Monochrome2;
+    img_data.window_center = header.window_center;
+    img_data.window_width = header.window_width;
+    img_data.modality = ModalityMapping{ header.modality_slope, header.modality_intercept };
+    img_data.pixels = entry->pixels();
+
+    PixelStatistics stats;
+    stats.min_value = header.min_value;
+    stats.max_value = header.max_value;
+    stats.histogram.resize(PixelStatistics::kHistogramBins);
+    std::memcpy(stats.histogram.data(), entry->file->data() + header.histogram_offset,
+        PixelStatistics::kHistogramBins * sizeof(uint32_t));
+    img_data.statistics = std::move(stats);
+
+    return img_data;
+}
+
+bool PixelCache::store(const PixelCacheKey& key, const ImageData& image) {
+    if (!image.is_grayscale() || !image.statistics || !image.pixels.gray16()) {
+        return false;
+    }
+
+    EntryHeader header{};
+    header.width = image.width;
+    header.height = image.height;
+    header.bits_allocated = image.bits_allocated;
+    header.bits_stored = image.bits_stored;
+    header.is_signed = image.is_signed ? 1 : 0;
+    header.window_center = image.window_center;
+    header.window_width = image.window_width;
+    header.min_value = image.statistics->min_value;
+    header.max_value = image.statistics->max_value;
+    header.modality_slope = image.modality.slope;
+    header.modality_intercept = image.modality.intercept;
+
+    return write_entry(key, header, image.statistics->histogram.data(), image.pixels.gray16(),
+        image.pixels.pixel_count());
+}
+
+std::optional<CachedFrame> PixelCache::lookup_frame(const PixelCacheKey& key, uint32_t width, uint32_t height) {
+    auto entry = open_entry(key, true);
+    if (!entry || entry->header.width != width || entry->header.height != height) {
+        return std::nullopt;
+    }
+    return CachedFrame{ entry->pixels(), entry->header.stored_min, entry->header.stored_max };
+}
+
+bool PixelCache::store_frame(const PixelCacheKey& key, const uint16_t* samples, uint32_t width, uint32_t height,
+    int32_t min_value, int32_t max_value) {
+    EntryHeader header{};
+    header.width = width;
+    header.height = height;
+    header.stored_values = 1;
+    header.stored_min = min_value;
+    header.stored_max = max_value;
+    header.modality_slope = 1.0;
+
+    // The histogram section is kept, empty, so both kinds share one layout
+    const std::vector<uint32_t> histogram(PixelStatistics::kHistogramBins, 0);
+    return write_entry(key, header, histogram.data(), samples, uint64_t{ width } * height);
+}
+
+bool PixelCache::write_entry(const PixelCacheKey& key, EntryHeader header, const uint32_t* histogram,
+    const uint16_t* pixels, uint64_t pixel_count) {
+    if (!pixels || pixel_count == 0 ||
+        key.sop_instance_uid.empty() || key.sop_instance_uid.size() >= kUidCapacity) {
+        return false;
+    }
+
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    std::memset(header.sop_instance_uid, 0, sizeof(header.sop_instance_uid));
+    std::memcpy(header.sop_instance_uid, key.sop_instance_uid.data(), key.sop_instance_uid.size());
+    header.frame = key.frame;
+    header.fingerprint = key.fingerprint;
+    header.histogram_offset = kHistogramOffset;
+    header.pixel_offset = kPixelOffset;
+
+    static_assert(sizeof(EntryHeader) <= kHeaderBytes, "cache header must fit reserved space");
+
+    const uint64_t pixel_bytes = pixel_count * sizeof(uint16_t);
+    const uint64_t entry_bytes = kPixelOffset + pixel_bytes;
+    if (entry_bytes > config_.max_bytes) {
+        return false;
+    }
+
+    const auto path = entry_path(key, header.stored_values != 0);
+    auto tmp_path = path;
+    tmp_path += ".tmp";
+
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            return false;
+        }
+
+        std::vector<char> header_block(kHeaderBytes, 0);
+        std::memcpy(header_block.data(), &header, sizeof(header));
+        out.write(header_block.data(), static_cast<std::streamsize>(header_block.size()));
+        out.write(reinterpret_cast<const char*>(histogram),
+            static_cast<std::streamsize>(PixelStatistics::kHistogramBins * sizeof(uint32_t)));
+        out.write(reinterpret_cast<const char*>(pixels), static_cast<std::streamsize>(pixel_bytes));
+
+        if (!out) {
+            out.close();
+            std::error_code ec;
+            std::filesystem::remove(tmp_path, ec);
+            return false;
+        }
+    }
+
+    std::lock_guard lock(mutex_);
+
+    std::error_code ec;
+    std::filesystem::rename(tmp_path, path, ec);
+    if (ec) {
+        std::filesystem::remove(tmp_path, ec);
+        return false;
+    }
+
+    touch_locked(path.filename().string(), entry_bytes);
+    if (total_bytes_ > config_.max_bytes) {
+        evict_locked();
+    }
+
+    return true;
+}
+
+uint64_t PixelCache::size_bytes() const {
+    std::lock_guard lock(mutex_);
+    return total_bytes_;
+}
+
+void PixelCache::scan_directory() {
+    struct Found {
+        std::string name;
+        std::filesystem::file_time_type last_used;
+        uint64_t size;
+    };
+
+    std::vector<Found> found;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(config_.directory, ec)) {
+        if (entry.path().extension() == kExtension) {
+            found.push_back({ entry.path().filename().string(), entry.last_write_time(ec), entry.file_size(ec) });
+        }
+    }
+    std::sort(found.begin(), found.end(),
+        [](const Found& a, const Found& b) { return a.last_used < b.last_used; });
+
+    std::lock_guard lock(mutex_);
+    index_.clear();
+    lru_.clear();
+    total_bytes_ = 0;
+    for (const auto& entry : found) {
+        touch_locked(entry.name, entry.size);
+    }
+
+    if (total_bytes_ > config_.max_bytes) {
+        evict_locked();
+    }
+}
+
+// Makes name the most recently used entry, adding it if it is new
+void PixelCache::touch_locked(const std::string& name, uint64_t size) {
+    auto it = index_.find(name);
+    if (it == index_.end()) {
+        lru_.push_front(name);
+        index_.emplace(name, IndexEntry{ size, lru_.begin() });
+        total_bytes_ += size;
+        return;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second.lru);
+    total_bytes_ = total_bytes_ - std::min(total_bytes_, it->second.size) + size;
+    it->second.size = size;
+}
+
+void PixelCache::evict_locked() {
+    const uint64_t low_water = config_.max_bytes / 100 * kLowWaterPercent;
+    uint32_t evicted = 0;
+    std::error_code ec;
+    while (total_bytes_ > low_water && !lru_.empty()) {
+        const std::string name = lru_.back();
+        lru_.pop_back();
+        auto it = index_.find(name);
+        total_bytes_ -= std::min(total_bytes_, it->second.size);
+        index_.erase(it);
+
+        // Gone already counts as evicted; the index forgets it either way
+        std::filesystem::remove(config_.directory / name, ec);
+        ++evicted;
+    }
+    std::cout << "[DEBUG] Pixel cache evicted " << evicted << " entries, " << total_bytes_ / (1024 * 1024)
+        << " MB left" << std::endl;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "core/dicom_image.hpp"
+#include <filesystem>
+#include <list>
+#include <optional>
+#include <string>
+#include <mutex>
+#include <unordered_map>
+#include <cstdint>
+
+struct PixelCacheKey {
+    std::string sop_instance_uid;
+    uint32_t frame;
+    uint64_t fingerprint;
+};
+
+// Decoded frame of a multi-frame object before normalization: its sample
+// words as the decoder wrote them and the range of their stored values
+struct CachedFrame {
+    PixelBuffer samples;
+    int32_t min_value;
+    int32_t max_value;
+};
+
+struct PixelCacheConfig {
+    std::filesystem::path directory;
+    uint64_t max_bytes;
+};
+
+// Persistent cache of decoded grayscale frames: normalized images, and the
+// frames of multi-frame objects before their shared normalization.
+// Each entry is one raw file (header, histogram, pixels) that is mmapped on
+// lookup; the returned pixels read from that mapping, which they keep alive.
+// The cache is bounded by total size; least recently used entries are evicted
+// first, down to a low-water mark so that a full cache does not evict on every
+// store. Entries are indexed in memory from one directory scan at construction.
+class PixelCache {
+    struct IndexEntry {
+        uint64_t size;
+        std::list<std::string>::iterator lru;
+    };
+
+    PixelCacheConfig config_;
+    uint64_t total_bytes_;
+    std::unordered_map<std::string, IndexEntry> index_;   // by entry file name
+    std::list<std::string> lru_;                          // entry file names, most recently used first
+    mutable std::mutex mutex_;
+
+public:
+    explicit PixelCache(PixelCacheConfig config);
+
+    std::optional<ImageData> lookup(const PixelCacheKey& key);
+
+    // Entry must be a normalized grayscale frame with statistics
+    bool store(const PixelCacheKey& key, const ImageData& image);
+
+    // Frames are keyed by their index; a frame of other dimensions is a miss
+    std::optional<CachedFrame> lookup_frame(const PixelCacheKey& key, uint32_t width, uint32_t height);
+    bool store_frame(const PixelCacheKey& key, const uint16_t* samples, uint32_t width, uint32_t height,
+        int32_t min_value, int32_t max_value);
+
+    uint64_t size_bytes() const;
+    const PixelCacheConfig& config() const { return config_; }
+
+    // Cheap identity of a file: size, modification time and a hash of its head and tail
+    static uint64_t fingerprint(const std::filesystem::path& path);
+
+private:
+    struct EntryHeader;
+    struct Entry;
+
+    std::filesystem::path entry_path(const PixelCacheKey& key, bool stored_values) const;
+    std::optional<Entry> open_entry(const PixelCacheKey& key, bool stored_values);
+    bool write_entry(const PixelCacheKey& key, EntryHeader header, const uint32_t* histogram,
+        const uint16_t* pixels, uint64_t pixel_count);
+    void scan_directory();
+    void touch_locked(const std::string& name, uint64_t size);
+    void evict_locked();
+};
@@ -0,0 +1,457 @@
+#include "preview_reader.hpp"
+#include "codec_registry.hpp"
+#include "pixel_cache.hpp"
+#include "scaled_jpeg.hpp"
+
+// DCMTK includes
+#include <dcmtk/dcmdata/dctk.h>
+#include <dcmtk/dcmdata/dcfcache.h>
+#include <dcmtk/dcmdata/dcpixseq.h>
+#include <dcmtk/dcmdata/dcpxitem.h>
+#include <dcmtk/dcmimgle/dcmimage.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+namespace {
+
+DicomImageData grayscale_preview_image(DcmDataset* dataset, const std::vector<double>& values,
+    uint32_t out_width, uint32_t out_height, double min_val, double max_val);
+
+Result<ImagePreview, ErrorInfo> strided_native_preview(
+    DcmDataset* dataset, DcmElement* pixel_element, uint32_t max_dimension) {
+    Uint16 rows = 0, columns = 0, bits_allocated = 0, bits_stored = 0, high_bit = 0, pixel_rep = 0;
+    dataset->findAndGetUint16(DCM_Rows, rows);
+    dataset->findAndGetUint16(DCM_Columns, columns);
+    dataset->findAndGetUint16(DCM_BitsAllocated, bits_allocated);
+    dataset->findAndGetUint16(DCM_BitsStored, bits_stored);
+    dataset->findAndGetUint16(DCM_PixelRepresentation, pixel_rep);
+    if (dataset->findAndGetUint16(DCM_HighBit, high_bit).bad()) {
+        high_bit = bits_stored - 1;
+    }
+
+    if (rows == 0 || columns == 0 || (bits_allocated != 8 && bits_allocated != 16) ||
+        bits_stored == 0 || bits_stored > bits_allocated || high_bit + 1 < bits_stored) {
+        return ErrorInfo{ DicomError::InvalidImageDimensions, "Unsupported layout for preview", "" };
+    }
+
+    Float64 rescale_slope = 1.0, rescale_intercept = 0.0;
+    dataset->findAndGetFloat64(DCM_RescaleSlope, rescale_slope);
+    dataset->findAndGetFloat64(DCM_RescaleIntercept, rescale_intercept);
+
+    const uint32_t stride = std::max<uint32_t>(1,
+        (std::max<uint32_t>(rows, columns) + max_dimension - 1) / max_dimension);
+    const uint32_t out_width = (columns + stride - 1) / stride;
+    const uint32_t out_height = (rows + stride - 1) / stride;
+    const size_t bytes_per_sample = bits_allocated / 8;
+    const size_t row_bytes = columns * bytes_per_sample;
+
+    // Stored values of the sampled grid, converted to modality values
+    std::vector<double> values(static_cast<size_t>(out_width) * out_height);
+    std::vector<Uint8> row(row_bytes + (row_bytes & 1));
+    DcmFileCache file_cache;
+
+    const uint32_t shift = high_bit + 1u - bits_stored;
+    const uint32_t mask = (1u << bits_stored) - 1u;
+    double min_val = std::numeric_limits<double>::max();
+    double max_val = std::numeric_limits<double>::lowest();
+
+    for (uint32_t oy = 0; oy < out_height; ++oy) {
+        const Uint32 offset = static_cast<Uint32>(static_cast<size_t>(oy) * stride * row_bytes);
+        OFCondition status = pixel_element->getPartialValue(row.data(), offset,
+            static_cast<Uint32>(row_bytes), &file_cache);
+        if (status.bad()) {
+            return ErrorInfo{ DicomError::MissingPixelData, "Failed to read preview rows", status.text() };
+        }
+
+        for (uint32_t ox = 0; ox < out_width; ++ox) {
+            const size_t x = static_cast<size_t>(ox) * stride;
+            uint32_t raw = bytes_per_sample == 2
+                ? reinterpret_cast<const Uint16*>(row.data())[x]
+                : row[x];
+            int32_t stored = static_cast<int32_t>((raw >> shift) & mask);
+            if (pixel_rep == 1 && (stored & (1 << (bits_stored - 1)))) {
+                stored -= (1 << bits_stored);
+            }
+            const double modality = stored * rescale_slope + rescale_intercept;
+            values[static_cast<size_t>(oy) * out_width + ox] = modality;
+            min_val = std::min(min_val, modality);
+            max_val = std::max(max_val, modality);
+        }
+    }
+
+    return ImagePreview{ grayscale_preview_image(dataset, values, out_width, out_height, min_val, max_val),
+        columns, rows, PreviewSource::StridedNative };
+}
+
+// Modality values of a reduced grayscale image, normalized to the full 16-bit
+// range with the file's window mapped along, as the full load does
+DicomImageData grayscale_preview_image(DcmDataset* dataset, const std::vector<double>& values,
+    uint32_t out_width, uint32_t out_height, double min_val, double max_val) {
+    Uint16 bits_allocated = 0, bits_stored = 0, pixel_rep = 0;
+    dataset->findAndGetUint16(DCM_BitsAllocated, bits_allocated);
+    dataset->findAndGetUint16(DCM_BitsStored, bits_stored);
+    dataset->findAndGetUint16(DCM_PixelRepresentation, pixel_rep);
+
+    OFString photometric_str;
+    dataset->findAndGetOFString(DCM_PhotometricInterpretation, photometric_str);
+    const bool is_monochrome1 = (photometric_str == "MONOCHROME1");
+
+    double data_range = max_val - min_val;
+    if (data_range < 1) data_range = 1;
+    const double scale = 65535.0 / data_range;
+
+    ImageData img_data;
+    img_data.width = out_width;
+    img_data.height = out_height;
+    img_data.bits_allocated = bits_allocated;
+    img_data.bits_stored = bits_stored;
+    img_data.is_signed = (pixel_rep == 1);
+    img_data.photometric = PhotometricInterpretation::Monochrome2;
+    img_data.pixels = PixelBuffer::allocate(PixelFormat::Gray16, values.size());
+    uint16_t* pixels = img_data.pixels.gray16();
+
+    for (size_t i = 0; i < values.size(); ++i) {
+        double normalized = std::clamp((values[i] - min_val) * scale, 0.0, 65535.0);
+        if (is_monochrome1) normalized = 65535.0 - normalized;
+        pixels[i] = static_cast<uint16_t>(normalized);
+    }
+
+    DicomImageData image;
+    Float64 file_wc = 0, file_ww = 0;
+    if (dataset->findAndGetFloat64(DCM_WindowCenter, file_wc).good() &&
+        dataset->findAndGetFloat64(DCM_WindowWidth, file_ww).good() && file_ww > 0) {
+        img_data.window_center = static_cast<int32_t>((file_wc - min_val) * scale);
+        img_data.window_width = std::max(static_cast<int32_t>(file_ww * scale), 1);
+        if (is_monochrome1) {
+            img_data.window_center = 65535 - img_data.window_center;
+        }
+        image.set_data(std::move(img_data));
+    }
+    else {
+        image.set_data(std::move(img_data));
+        image.auto_window_level();
+    }
+    return image;
+}
+
+Result<ImagePreview, ErrorInfo> icon_image_preview(DcmDataset* dataset) {
+    DcmItem* icon = nullptr;
+    if (dataset->findAndGetSequenceItem(DCM_IconImageSequence, icon, 0).bad() || !icon) {
+        return ErrorInfo{ DicomError::MissingPixelData, "No preview available",
+                         "Compressed image without icon" };
+    }
+
+    Uint16 source_rows = 0, source_columns = 0;
+    dataset->findAndGetUint16(DCM_Rows, source_rows);
+    dataset->findAndGetUint16(DCM_Columns, source_columns);
+
+    // Icon pixel data is usually native, but may be encapsulated like the image's
+    DcmElement* icon_pixels = nullptr;
+    const bool encapsulated = icon->findAndGetElement(DCM_PixelData, icon_pixels).good() && icon_pixels &&
+        icon_pixels->getLengthField() == DCM_UndefinedLength;
+    if (encapsulated) {
+        ensure_decoders(*dataset);
+    }
+    ::DicomImage dcmtk_icon(icon, encapsulated ? dataset->getOriginalXfer() : EXS_LittleEndianExplicit,
+        CIF_MayDetachPixelData);
+    if (dcmtk_icon.getStatus() != EIS_Normal) {
+        return ErrorInfo{ DicomError::MissingPixelData, "Failed to read icon image",
+                         ::DicomImage::getString(dcmtk_icon.getStatus()) };
+    }
+
+    ImageData img_data;
+    img_data.width = dcmtk_icon.getWidth();
+    img_data.height = dcmtk_icon.getHeight();
+    const size_t pixel_count = static_cast<size_t>(img_data.width) * img_data.height;
+
+    if (dcmtk_icon.isMonochrome()) {
+        dcmtk_icon.setMinMaxWindow();
+        const auto* gray = static_cast<const Uint8*>(dcmtk_icon.getOutputData(8));
+        if (!gray) {
+            return ErrorInfo{ DicomError::MissingPixelData, "Failed to render icon image", "" };
+        }
+        img_data.photometric = PhotometricInterpretation::Monochrome2;
+        img_data.pixels = PixelBuffer::allocate(PixelFormat::Gray16, pixel_count);
+        uint16_t* pixels = img_data.pixels.gray16();
+        for (size_t i = 0; i < pixel_count; ++i) {
+            pixels[i] = static_cast<uint16_t>(gray[i]) * 257;
+        }
+        img_data.window_center = 32768;
+        img_data.window_width = 65536;
+    }
+    else {
+        const auto* rgb = static_cast<const Uint8*>(dcmtk_icon.getOutputData(8));
+        if (!rgb) {
+            return ErrorInfo{ DicomError::MissingPixelData, "Failed to render icon image", "" };
+        }
+        img_data.photometric = PhotometricInterpretation::RGB;
+        img_data.samples_per_pixel = 3;
+        img_data.pixels = PixelBuffer::allocate(PixelFormat::Rgb8, pixel_count);
+        std::memcpy(img_data.pixels.rgb8(), rgb, img_data.pixels.size_bytes());
+        img_data.window_center = 128;
+        img_data.window_width = 256;
+    }
+
+    DicomImageData image;
+    image.set_data(std::move(img_data));
+    return ImagePreview{ std::move(image), source_columns, source_rows, PreviewSource::IconImage };
+}
+
+// Whether the first frame ends here: EOI, perhaps followed by a pad byte
+bool ends_with_end_of_image(const std::vector<Uint8>& stream) {
+    const size_t n = stream.size();
+    return (n >= 2 && stream[n - 2] == 0xFF && stream[n - 1] == 0xD9) ||
+        (n >= 3 && stream[n - 3] == 0xFF && stream[n - 2] == 0xD9 && stream[n - 1] == 0x00);
+}
+
+// The first frame of 8-bit DCT JPEG pixel data, decoded at the smallest
+// scale that still covers max_dimension. Only its fragments are read.
+Result<ImagePreview, ErrorInfo> scaled_jpeg_preview(
+    DcmDataset* dataset, DcmElement* pixel_element, uint32_t max_dimension) {
+    Uint16 rows = 0, columns = 0, bits_allocated = 0, pixel_rep = 0;
+    dataset->findAndGetUint16(DCM_Rows, rows);
+    dataset->findAndGetUint16(DCM_Columns, columns);
+    dataset->findAndGetUint16(DCM_BitsAllocated, bits_allocated);
+    dataset->findAndGetUint16(DCM_PixelRepresentation, pixel_rep);
+    if (rows == 0 || columns == 0 || bits_allocated != 8) {
+        return ErrorInfo{ DicomError::InvalidImageDimensions, "Unsupported layout for preview", "" };
+    }
+
+    auto* pixel_data = static_cast<DcmPixelData*>(pixel_element);
+    E_TransferSyntax xfer = EXS_Unknown;
+    const DcmRepresentationParameter* param = nullptr;
+    pixel_data->getOriginalRepresentationKey(xfer, param);
+    DcmPixelSequence* sequence = nullptr;
+    if (pixel_data->getEncapsulatedRepresentation(xfer, param, sequence).bad() || !sequence) {
+        return ErrorInfo{ DicomError::MissingPixelData, "No encapsulated pixel data", "" };
+    }
+
+    // Item 0 is the offset table; the first frame runs up to its EOI marker
+    std::vector<Uint8> stream;
+    for (unsigned long i = 1; i < sequence->card() && !ends_with_end_of_image(stream); ++i) {
+        DcmPixelItem* fragment = nullptr;
+        Uint8* data = nullptr;
+        if (sequence->getItem(fragment, i).bad() || fragment->getUint8Array(data).bad() || !data) {
+            return ErrorInfo{ DicomError::MissingPixelData, "Failed to read JPEG fragment", "" };
+        }
+        stream.insert(stream.end(), data, data + fragment->getLength());
+    }
+
+    OFString photometric_str;
+    dataset->findAndGetOFString(DCM_PhotometricInterpretation, photometric_str);
+    auto decoded = decode_jpeg_scaled(stream.data(), stream.size(), max_dimension, photometric_str == "RGB");
+    if (decoded.is_error()) {
+        return decoded.error();
+    }
+    const ScaledJpegImage& jpeg = decoded.value();
+
+    // The DCT scale goes down in powers of two; the rest is sampled
+    const uint32_t stride = std::max<uint32_t>(1,
+        (std::max(jpeg.width, jpeg.height) + max_dimension - 1) / max_dimension);
+    const uint32_t out_width = (jpeg.width + stride - 1) / stride;
+    const uint32_t out_height = (jpeg.height + stride - 1) / stride;
+    const size_t pixel_count = static_cast<size_t>(out_width) * out_height;
+
+    if (jpeg.components == 3) {
+        ImageData img_data;
+        img_data.width = out_width;
+        img_data.height = out_height;
+        img_data.photometric = PhotometricInterpretation::RGB;
+        img_data.samples_per_pixel = 3;
+        img_data.pixels = PixelBuffer::allocate(PixelFormat::Rgb8, pixel_count);
+        uint8_t* rgb = img_data.pixels.rgb8();
+        for (uint32_t oy = 0; oy < out_height; ++oy) {
+            const uint8_t* row = jpeg.samples.data() + static_cast<size_t>(oy) * stride * jpeg.width * 3;
+            for (uint32_t ox = 0; ox < out_width; ++ox) {
+                std::memcpy(rgb, row + static_cast<size_t>(ox) * stride * 3, 3);
+                rgb += 3;
+            }
+        }
+        img_data.window_center = 128;
+        img_data.window_width = 256;
+
+        DicomImageData image;
+        image.set_data(std::move(img_data));
+        return ImagePreview{ std::move(image), columns, rows, PreviewSource::ScaledJpeg };
+    }
+
+    Float64 rescale_slope = 1.0, rescale_intercept = 0.0;
+    dataset->findAndGetFloat64(DCM_RescaleSlope, rescale_slope);
+    dataset->findAndGetFloat64(DCM_RescaleIntercept, rescale_intercept);
+    std::vector<double> values(pixel_count);
+    double min_val = std::numeric_limits<double>::max();
+    double max_val = std::numeric_limits<double>::lowest();
+    for (uint32_t oy = 0; oy < out_height; ++oy) {
+        const uint8_t* row = jpeg.samples.data() + static_cast<size_t>(oy) * stride * jpeg.width;
+        for (uint32_t ox = 0; ox < out_width; ++ox) {
+            const uint8_t sample = row[static_cast<size_t>(ox) * stride];
+            const int32_t stored = pixel_rep == 1 ? static_cast<int8_t>(sample) : sample;
+            const double modality = stored * rescale_slope + rescale_intercept;
+            values[static_cast<size_t>(oy) * out_width + ox] = modality;
+            min_val = std::min(min_val, modality);
+            max_val = std::max(max_val, modality);
+        }
+    }
+    return ImagePreview{ grayscale_preview_image(dataset, values, out_width, out_height, min_val, max_val),
+        columns, rows, PreviewSource::ScaledJpeg };
+}
+
+// Whether the Icon Image Sequence holds an icon at least half the requested size
+bool icon_covers(DcmDataset* dataset, uint32_t max_dimension) {
+    DcmItem* icon = nullptr;
+    if (dataset->findAndGetSequenceItem(DCM_IconImageSequence, icon, 0).bad() || !icon) {
+        return false;
+    }
+    Uint16 icon_rows = 0, icon_columns = 0, rows = 0, columns = 0;
+    icon->findAndGetUint16(DCM_Rows, icon_rows);
+    icon->findAndGetUint16(DCM_Columns, icon_columns);
+    dataset->findAndGetUint16(DCM_Rows, rows);
+    dataset->findAndGetUint16(DCM_Columns, columns);
+    const uint32_t wanted = std::min<uint32_t>(max_dimension, std::max(rows, columns));
+    return std::max<uint32_t>(icon_rows, icon_columns) * 2 >= wanted;
+}
+
+Result<ImagePreview, ErrorInfo> preview_from_dataset(DcmDataset* dataset, uint32_t max_dimension) {
+    max_dimension = std::max<uint32_t>(max_dimension, 1);
+
+    OFString photometric_str;
+    dataset->findAndGetOFString(DCM_PhotometricInterpretation, photometric_str);
+    Uint16 samples_per_pixel = 1;
+    dataset->findAndGetUint16(DCM_SamplesPerPixel, samples_per_pixel);
+
+    const bool is_grayscale = (photometric_str == "MONOCHROME1" || photometric_str == "MONOCHROME2");
+    const bool is_native = DcmXfer(dataset->getOriginalXfer()).usesNativeFormat();
+
+    DcmElement* pixel_element = nullptr;
+    if (is_grayscale && is_native && samples_per_pixel == 1 &&
+        dataset->findAndGetElement(DCM_PixelData, pixel_element).good() && pixel_element) {
+        return strided_native_preview(dataset, pixel_element, max_dimension);
+    }
+
+    // Compressed: an icon of about the right size is cheapest, then a reduced
+    // decode of baseline or extended 8-bit JPEG
+    const E_TransferSyntax xfer = dataset->getOriginalXfer();
+    if ((xfer == EXS_JPEGProcess1 || xfer == EXS_JPEGProcess2_4) && !icon_covers(dataset, max_dimension) &&
+        dataset->findAndGetElement(DCM_PixelData, pixel_element).good() && pixel_element) {
+        auto preview = scaled_jpeg_preview(dataset, pixel_element, max_dimension);
+        if (preview.is_ok()) {
+            return preview;
+        }
+    }
+
+    return icon_image_preview(dataset);
+}
+
+// Longest side at most max_dimension: windowed Gray8, or Rgb8
+Thumbnail windowed_thumbnail(DicomImageData& image, uint32_t max_dimension,
+    uint32_t source_width, uint32_t source_height) {
+    const ImageData& data = image.data();
+    const uint32_t longest = std::max(data.width, data.height);
+    const double scale = longest > max_dimension ? static_cast<double>(max_dimension) / longest : 1.0;
+
+    Thumbnail thumbnail;
+    thumbnail.width = std::max<uint32_t>(1, static_cast<uint32_t>(data.width * scale + 0.5));
+    thumbnail.height = std::max<uint32_t>(1, static_cast<uint32_t>(data.height * scale + 0.5));
+    thumbnail.source_width = source_width;
+    thumbnail.source_height = source_height;
+
+    if (data.is_rgb()) {
+        thumbnail.rgb = true;
+        thumbnail.pixels.resize(static_cast<size_t>(thumbnail.width) * thumbnail.height * 3);
+        const uint8_t* rgb = data.pixels.rgb8();
+        uint8_t* out = thumbnail.pixels.data();
+        for (uint32_t y = 0; y < thumbnail.height; ++y) {
+            const size_t sy = std::min<size_t>(data.height - 1, static_cast<size_t>(y / scale));
+            for (uint32_t x = 0; x < thumbnail.width; ++x) {
+                const size_t sx = std::min<size_t>(data.width - 1, static_cast<size_t>(x / scale));
+                std::memcpy(out, rgb + (sy * data.width + sx) * 3, 3);
+                out += 3;
+            }
+        }
+        return thumbnail;
+    }
+
+    // The window comes from the file or from the cached histogram statistics
+    if (data.window_width <= 0) {
+        image.auto_window_level();
+    }
+    PixelBuffer gray = image.render_region(PixelRegion{ 0, 0, data.width, data.height },
+        thumbnail.width, thumbnail.height, data.window_center, data.window_width);
+    if (gray.gray8()) {
+        thumbnail.pixels.assign(gray.gray8(), gray.gray8() + gray.pixel_count());
+    }
+    return thumbnail;
+}
+
+// A cached thumbnail serves requests up to twice its size
+bool thumbnail_fits(const Thumbnail& thumbnail, uint32_t max_dimension) {
+    const uint32_t longest = std::max(thumbnail.width, thumbnail.height);
+    const uint32_t source_longest = std::max(thumbnail.source_width, thumbnail.source_height);
+    return longest <= max_dimension && (longest * 2 > max_dimension || longest >= source_longest);
+}
+
+} // namespace
+
+Result<ImagePreview, ErrorInfo>
+load_image_preview(const std::filesystem::path& path, uint32_t max_dimension) {
+    DcmFileFormat file_format;
+    OFCondition status = file_format.loadFile(path.string().c_str());
+    if (status.bad()) {
+        return ErrorInfo{ DicomError::InvalidFormat, "Failed to load DICOM file", status.text() };
+    }
+    return preview_from_dataset(file_format.getDataset(), max_dimension);
+}
+
+Result<LoadedThumbnail, ErrorInfo> load_thumbnail(const std::filesystem::path& path, uint32_t max_dimension,
+    ThumbnailCache* cache, const FullImageDecoder& full_decode) {
+    DcmFileFormat file_format;
+    OFCondition status = file_format.loadFile(path.string().c_str());
+    if (status.bad()) {
+        return ErrorInfo{ DicomError::InvalidFormat, "Failed to load DICOM file", status.text() };
+    }
+    DcmDataset* dataset = file_format.getDataset();
+    max_dimension = std::max<uint32_t>(max_dimension, 1);
+
+    OFString sop_instance_uid;
+    dataset->findAndGetOFString(DCM_SOPInstanceUID, sop_instance_uid);
+    const uint64_t fingerprint = cache ? PixelCache::fingerprint(path) : 0;
+    if (cache && !sop_instance_uid.empty()) {
+        auto cached = cache->lookup(sop_instance_uid.c_str(), fingerprint);
+        if (cached && thumbnail_fits(*cached, max_dimension)) {
+            return LoadedThumbnail{ std::move(*cached), std::nullopt };
+        }
+    }
+
+    Uint16 rows = 0, columns = 0;
+    dataset->findAndGetUint16(DCM_Rows, rows);
+    dataset->findAndGetUint16(DCM_Columns, columns);
+
+    DicomImageData image;
+    PreviewSource source = PreviewSource::FullDecode;
+    auto preview = preview_from_dataset(dataset, max_dimension);
+    if (preview.is_ok()) {
+        image = std::move(preview.value().image);
+        source = preview.value().source;
+    }
+    else {
+        // Compressed without an icon or a reduced decode: the full frame it is
+        auto full = full_decode(path, file_format);
+        if (full.is_error()) {
+            return full.error();
+        }
+        image = std::move(full.value());
+    }
+
+    Thumbnail thumbnail = windowed_thumbnail(image, max_dimension, columns, rows);
+    if (thumbnail.pixels.empty()) {
+        return ErrorInfo{ DicomError::MissingPixelData, "Failed to render thumbnail", path.filename().string() };
+    }
+    if (cache && !sop_instance_uid.empty()) {
+        cache->store(sop_instance_uid.c_str(), fingerprint, thumbnail);
+    }
+    return LoadedThumbnail{ std::move(thumbnail), source };
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "core/result.hpp"
+#include "core/error_codes.hpp"
+#include "core/dicom_image.hpp"
+#include "thumbnail_cache.hpp"
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <cstdint>
+
+class DcmFileFormat;
+
+enum class PreviewSource {
+    StridedNative,   // every n-th row and column read straight from native pixel data
+    IconImage,       // Icon Image Sequence embedded in the file
+    ScaledJpeg,      // 8-bit DCT JPEG decoded at 1/2, 1/4 or 1/8 scale
+    FullDecode       // thumbnails only: decoded at full size, then reduced
+};
+
+struct ImagePreview {
+    DicomImageData image;
+    uint32_t source_width;
+    uint32_t source_height;
+    PreviewSource source;
+};
+
+// Build a coarse preview (longest side at most max_dimension) without decoding
+// the full frame. Only the sampled rows of native pixel data are read from disk;
+// baseline JPEG is decoded at reduced scale from the fragments of its first
+// frame. Other compressed images without an icon have no preview (MissingPixelData).
+Result<ImagePreview, ErrorInfo>
+    load_image_preview(const std::filesystem::path& path, uint32_t max_dimension);
+
+struct LoadedThumbnail {
+    Thumbnail thumbnail;
+    std::optional<PreviewSource> source;   // empty when it came from the cache
+};
+
+// Decodes the loaded file at full size, for images no preview path covers
+using FullImageDecoder =
+    std::function<Result<DicomImageData, ErrorInfo>(const std::filesystem::path&, DcmFileFormat&)>;
+
+// Thumbnail of the first frame, longest side at most max_dimension, windowed
+// with the file's window or one from the histogram. Built from the preview
+// paths above; other compressed images go through full_decode. With a cache,
+// a thumbnail of the same instance and file is reused, and new ones are stored.
+Result<LoadedThumbnail, ErrorInfo> load_thumbnail(const std::filesystem::path& path, uint32_t max_dimension,
+    ThumbnailCache* cache, const FullImageDecoder& full_decode);
@@ -0,0 +1,150 @@
+#include "process_info.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <cstdio>
+#else
+#include <spawn.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+extern char** environ;
+#endif
+
+#ifdef _WIN32
+
+double process_age_ms() {
+    FILETIME creation{}, exit{}, kernel{}, user{};
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+        return -1.0;
+    }
+    FILETIME now{};
+    GetSystemTimePreciseAsFileTime(&now);
+    const auto ticks = [](const FILETIME& time) {
+        return (static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+    };
+    // FILETIME counts 100 ns intervals
+    return static_cast<double>(ticks(now) - ticks(creation)) / 10000.0;
+}
+
+std::filesystem::path executable_path() {
+    wchar_t buffer[MAX_PATH];
+    const DWORD length = GetModuleFileNameW(nullptr, buffer, MAX_PATH);
+    return length > 0 && length < MAX_PATH ? std::filesystem::path(std::wstring(buffer, length))
+                                           : std::filesystem::path();
+}
+
+Result<std::string, ErrorInfo> run_and_capture(const std::filesystem::path& program,
+    const std::vector<std::string>& arguments) {
+    // _popen runs the line through cmd.exe, which wants the whole line quoted once more
+    std::string command = "\"\"" + program.string() + "\"";
+    for (const auto& argument : arguments) {
+        command += " \"" + argument + "\"";
+    }
+    command += "\"";
+
+    FILE* pipe = _popen(command.c_str(), "rb");
+    if (!pipe) {
+        return ErrorInfo{ DicomError::UnknownError, "Cannot start process", program.string() };
+    }
+    std::string output;
+    char buffer[4096];
+    size_t read = 0;
+    while ((read = std::fread(buffer, 1, sizeof(buffer), pipe)) > 0) {
+        output.append(buffer, read);
+    }
+    if (_pclose(pipe) != 0) {
+        return ErrorInfo{ DicomError::UnknownError, "Process failed", program.string() };
+    }
+    return output;
+}
+
+#else
+
+double process_age_ms() {
+#ifdef __linux__
+    // Field 22 of /proc/self/stat is the start time in clock ticks since boot.
+    // The command name in field 2 may hold spaces, so fields are counted
+    // from its closing parenthesis.
+    std::ifstream stat_file("/proc/self/stat");
+    std::string stat((std::istreambuf_iterator<char>(stat_file)), std::istreambuf_iterator<char>());
+    const size_t name_end = stat.rfind(')');
+    if (name_end == std::string::npos) {
+        return -1.0;
+    }
+    std::istringstream fields(stat.substr(name_end + 2));
+    std::string field;
+    for (int i = 3; i < 22 && fields >> field; ++i) {
+    }
+    unsigned long long start_ticks = 0;
+    timespec now{};
+    const long ticks_per_second = sysconf(_SC_CLK_TCK);
+    if (!(fields >> start_ticks) || ticks_per_second <= 0 || clock_gettime(CLOCK_BOOTTIME, &now) != 0) {
+        return -1.0;
+    }
+    const double now_ms = static_cast<double>(now.tv_sec) * 1000.0 + static_cast<double>(now.tv_nsec) / 1e6;
+    return now_ms - static_cast<double>(start_ticks) * 1000.0 / static_cast<double>(ticks_per_second);
+#else
+    return -1.0;
+#endif
+}
+
+std::filesystem::path executable_path() {
+#ifdef __linux__
+    std::error_code ec;
+    return std::filesystem::read_symlink("/proc/self/exe", ec);
+#else
+    return {};
+#endif
+}
+
+Result<std::string, ErrorInfo> run_and_capture(const std::filesystem::path& program,
+    const std::vector<std::string>& arguments) {
+    int pipe_fds[2];
+    if (pipe(pipe_fds) != 0) {
+        return ErrorInfo{ DicomError::UnknownError, "Cannot create pipe", program.string() };
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, pipe_fds[1], STDOUT_FILENO);
+    posix_spawn_file_actions_addclose(&actions, pipe_fds[0]);
+    posix_spawn_file_actions_addclose(&actions, pipe_fds[1]);
+
+    std::string program_string = program.string();
+    std::vector<std::string> strings = arguments;
+    std::vector<char*> argv;
+    argv.push_back(program_string.data());
+    for (auto& argument : strings) {
+        argv.push_back(argument.data());
+    }
+    argv.push_back(nullptr);
+
+    pid_t pid = 0;
+    const int spawned = posix_spawn(&pid, program_string.c_str(), &actions, nullptr, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    close(pipe_fds[1]);
+    if (spawned != 0) {
+        close(pipe_fds[0]);
+        return ErrorInfo{ DicomError::UnknownError, "Cannot start process", program_string };
+    }
+
+    std::string output;
+    char buffer[4096];
+    ssize_t received = 0;
+    while ((received = read(pipe_fds[0], buffer, sizeof(buffer))) > 0) {
+        output.append(buffer, static_cast<size_t>(received));
+    }
+    close(pipe_fds[0]);
+
+    int status = 0;
+    if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        return ErrorInfo{ DicomError::UnknownError, "Process failed", program_string };
+    }
+    return output;
+}
+
+#endif
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "core/result.hpp"
+#include "core/error_codes.hpp"
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Milliseconds since the operating system started this process, negative
+// if the platform does not tell. Linux reports the start in clock ticks,
+// so the value is only good to about 10 ms there.
+double process_age_ms();
+
+// The running program's executable, empty if unknown
+std::filesystem::path executable_path();
+
+// Runs a program to completion and returns what it wrote to standard output
+Result<std::string, ErrorInfo> run_and_capture(const std::filesystem::path& program,
+    const std::vector<std::string>& arguments);
@@ -0,0 +1,233 @@
+#include "query_scu.hpp"
+
+// DCMTK includes
+#include <dcmtk/dcmdata/dctk.h>
+#include <dcmtk/dcmnet/diutil.h>
+#include <dcmtk/dcmnet/scu.h>
+
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+#include <iostream>
+#include <memory>
+
+namespace {
+
+ErrorInfo association_error(const DicomPeer& peer, const OFCondition& cond) {
+    return ErrorInfo{ DicomError::NetworkError,
+                     "Cannot open association with " + peer.called_ae_title + " at " + peer.host + ":" +
+                         std::to_string(peer.port),
+                     cond.text() };
+}
+
+// One association proposing the given query/retrieve information models
+OFCondition open_association(DcmSCU& scu, const DicomPeer& peer,
+    std::initializer_list<const char*> abstract_syntaxes) {
+    // dcmnet logs every DIMSE message at INFO level
+    DCM_dcmnetLogger.setLogLevel(OFLogger::WARN_LOG_LEVEL);
+
+    scu.setAETitle(peer.calling_ae_title.c_str());
+    scu.setPeerHostName(peer.host.c_str());
+    scu.setPeerPort(peer.port);
+    scu.setPeerAETitle(peer.called_ae_title.c_str());
+    scu.setMaxReceivePDULength(ASC_MAXIMUMPDUSIZE);
+
+    OFList<OFString> transfer_syntaxes;
+    transfer_syntaxes.push_back(UID_LittleEndianExplicitTransferSyntax);
+    transfer_syntaxes.push_back(UID_LittleEndianImplicitTransferSyntax);
+    for (const char* abstract_syntax : abstract_syntaxes) {
+        scu.addPresentationContext(abstract_syntax, transfer_syntaxes);
+    }
+
+    OFCondition cond = scu.initNetwork();
+    if (cond.good()) {
+        cond = scu.negotiateAssociation();
+    }
+    return cond;
+}
+
+// Runs one C-FIND and hands every matching identifier to on_match
+Result<bool, ErrorInfo> find(const DicomPeer& peer, DcmDataset& keys,
+    const std::function<void(DcmDataset&)>& on_match) {
+    DcmSCU scu;
+    OFCondition cond = open_association(scu, peer, { UID_FINDStudyRootQueryRetrieveInformationModel });
+    if (cond.bad()) {
+        return association_error(peer, cond);
+    }
+    const T_ASC_PresentationContextID context =
+        scu.findPresentationContextID(UID_FINDStudyRootQueryRetrieveInformationModel, "");
+    if (context == 0) {
+        scu.releaseAssociation();
+        return ErrorInfo{ DicomError::NetworkError, "Peer does not support Study Root C-FIND",
+                         peer.called_ae_title };
+    }
+
+    OFList<QRResponse*> responses;
+    cond = scu.sendFINDRequest(context, &keys, &responses);
+
+    Uint16 final_status = STATUS_Success;
+    for (QRResponse* response : responses) {
+        if (response->m_dataset != nullptr && DICOM_PENDING_STATUS(response->m_status)) {
+            on_match(*response->m_dataset);
+        }
+        final_status = response->m_status;
+        delete response;
+    }
+
+    if (scu.isConnected()) {
+        scu.releaseAssociation();
+    }
+    if (cond.bad()) {
+        return ErrorInfo{ DicomError::NetworkError, "C-FIND failed", cond.text() };
+    }
+    if (final_status != STATUS_Success && !DICOM_PENDING_STATUS(final_status)) {
+        return ErrorInfo{ DicomError::NetworkError, "C-FIND failed", DU_cfindStatusString(final_status) };
+    }
+    return true;
+}
+
+std::string dataset_string(DcmDataset& dataset, const DcmTagKey& tag) {
+    OFString value;
+    dataset.findAndGetOFString(tag, value);
+    return value.c_str();
+}
+
+int32_t dataset_int(DcmDataset& dataset, const DcmTagKey& tag) {
+    Sint32 value = 0;
+    dataset.findAndGetSint32(tag, value);
+    return value;
+}
+
+} // namespace
+
+Result<std::vector<StudyMatch>, ErrorInfo> find_studies(const DicomPeer& peer, const StudyQuery& query) {
+    DcmDataset keys;
+    keys.putAndInsertString(DCM_QueryRetrieveLevel, "STUDY");
+    keys.putAndInsertString(DCM_StudyInstanceUID, "");
+    keys.putAndInsertString(DCM_PatientName, query.patient_name.c_str());
+    keys.putAndInsertString(DCM_PatientID, query.patient_id.c_str());
+    keys.putAndInsertString(DCM_StudyDate, query.study_date.c_str());
+    keys.putAndInsertString(DCM_AccessionNumber, query.accession_number.c_str());
+    keys.putAndInsertString(DCM_StudyDescription, "");
+
+    std::vector<StudyMatch> studies;
+    auto result = find(peer, keys, [&](DcmDataset& match) {
+        StudyMatch study;
+        study.study_instance_uid = dataset_string(match, DCM_StudyInstanceUID);
+        study.patient_name = dataset_string(match, DCM_PatientName);
+        study.patient_id = dataset_string(match, DCM_PatientID);
+        study.study_date = dataset_string(match, DCM_StudyDate);
+        study.study_description = dataset_string(match, DCM_StudyDescription);
+        study.accession_number = dataset_string(match, DCM_AccessionNumber);
+        studies.push_back(std::move(study));
+    });
+    if (result.is_error()) {
+        return result.error();
+    }
+    std::cout << "[DEBUG] C-FIND: " << studies.size() << " studies on " << peer.called_ae_title << std::endl;
+    return studies;
+}
+
+Result<std::vector<SeriesMatch>, ErrorInfo>
+find_series(const DicomPeer& peer, const std::string& study_instance_uid) {
+    DcmDataset keys;
+    keys.putAndInsertString(DCM_QueryRetrieveLevel, "SERIES");
+    keys.putAndInsertString(DCM_StudyInstanceUID, study_instance_uid.c_str());
+    keys.putAndInsertString(DCM_SeriesInstanceUID, "");
+    keys.putAndInsertString(DCM_Modality, "");
+    keys.putAndInsertString(DCM_SeriesNumber, "");
+    keys.putAndInsertString(DCM_SeriesDescription, "");
+
+    std::vector<SeriesMatch> series;
+    auto result = find(peer, keys, [&](DcmDataset& match) {
+        SeriesMatch entry;
+        entry.series_instance_uid = dataset_string(match, DCM_SeriesInstanceUID);
+        entry.modality = dataset_string(match, DCM_Modality);
+        entry.series_description = dataset_string(match, DCM_SeriesDescription);
+        entry.series_number = dataset_int(match, DCM_SeriesNumber);
+        series.push_back(std::move(entry));
+    });
+    if (result.is_error()) {
+        return result.error();
+    }
+    std::sort(series.begin(), series.end(), [](const SeriesMatch& a, const SeriesMatch& b) {
+        return a.series_number < b.series_number;
+    });
+    return series;
+}
+
+Result<std::vector<InstanceMatch>, ErrorInfo> find_instances(const DicomPeer& peer,
+    const std::string& study_instance_uid, const std::string& series_instance_uid) {
+    DcmDataset keys;
+    keys.putAndInsertString(DCM_QueryRetrieveLevel, "IMAGE");
+    keys.putAndInsertString(DCM_StudyInstanceUID, study_instance_uid.c_str());
+    keys.putAndInsertString(DCM_SeriesInstanceUID, series_instance_uid.c_str());
+    keys.putAndInsertString(DCM_SOPInstanceUID, "");
+    keys.putAndInsertString(DCM_SOPClassUID, "");
+    keys.putAndInsertString(DCM_InstanceNumber, "");
+
+    std::vector<InstanceMatch> instances;
+    auto result = find(peer, keys, [&](DcmDataset& match) {
+        InstanceMatch instance;
+        instance.sop_instance_uid = dataset_string(match, DCM_SOPInstanceUID);
+        instance.sop_class_uid = dataset_string(match, DCM_SOPClassUID);
+        instance.instance_number = dataset_int(match, DCM_InstanceNumber);
+        instances.push_back(std::move(instance));
+    });
+    if (result.is_error()) {
+        return result.error();
+    }
+    std::stable_sort(instances.begin(), instances.end(), [](const InstanceMatch& a, const InstanceMatch& b) {
+        return a.instance_number < b.instance_number;
+    });
+    return instances;
+}
+
+Result<RetrieveCounts, ErrorInfo> move_series(const DicomPeer& peer, const std::string& destination_ae_title,
+    const std::string& study_instance_uid, const std::string& series_instance_uid) {
+    DcmSCU scu;
+    // Like movescu, also propose C-FIND; some SCPs expect it next to C-MOVE
+    OFCondition cond = open_association(scu, peer, { UID_MOVEStudyRootQueryRetrieveInformationModel,
+                                                     UID_FINDStudyRootQueryRetrieveInformationModel });
+    if (cond.bad()) {
+        return association_error(peer, cond);
+    }
+    const T_ASC_PresentationContextID context =
+        scu.findPresentationContextID(UID_MOVEStudyRootQueryRetrieveInformationModel, "");
+    if (context == 0) {
+        scu.releaseAssociation();
+        return ErrorInfo{ DicomError::NetworkError, "Peer does not support Study Root C-MOVE",
+                         peer.called_ae_title };
+    }
+
+    DcmDataset keys;
+    keys.putAndInsertString(DCM_QueryRetrieveLevel, "SERIES");
+    keys.putAndInsertString(DCM_StudyInstanceUID, study_instance_uid.c_str());
+    keys.putAndInsertString(DCM_SeriesInstanceUID, series_instance_uid.c_str());
+
+    OFList<RetrieveResponse*> responses;
+    cond = scu.sendMOVERequest(context, destination_ae_title.c_str(), &keys, &responses);
+
+    RetrieveCounts counts;
+    Uint16 final_status = STATUS_Success;
+    for (RetrieveResponse* response : responses) {
+        counts.completed = response->m_numberOfCompletedSubops;
+        counts.failed = response->m_numberOfFailedSubops;
+        counts.warning = response->m_numberOfWarningSubops;
+        final_status = response->m_status;
+        delete response;
+    }
+
+    if (scu.isConnected()) {
+        scu.releaseAssociation();
+    }
+    if (cond.bad()) {
+        return ErrorInfo{ DicomError::NetworkError, "C-MOVE failed", cond.text() };
+    }
+    // A partial move is reported through the failed count, not as an error
+    if (DICOM_FAILURE_STATUS(final_status) && counts.completed == 0) {
+        return ErrorInfo{ DicomError::NetworkError, "C-MOVE to " + destination_ae_title + " failed",
+                         DU_cmoveStatusString(final_status) };
+    }
+    return counts;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "core/error_codes.hpp"
+#include "core/result.hpp"
+#include "dicom_peer.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Study level matching keys; empty means any. Patient name and ID may use
+// the * and ? wildcards, the study date a YYYYMMDD-YYYYMMDD range.
+struct StudyQuery {
+    std::string patient_name;
+    std::string patient_id;
+    std::string study_date;
+    std::string accession_number;
+};
+
+struct StudyMatch {
+    std::string study_instance_uid;
+    std::string patient_name;
+    std::string patient_id;
+    std::string study_date;
+    std::string study_description;
+    std::string accession_number;
+};
+
+struct SeriesMatch {
+    std::string series_instance_uid;
+    std::string modality;
+    std::string series_description;
+    int32_t series_number = 0;
+};
+
+struct InstanceMatch {
+    std::string sop_instance_uid;
+    std::string sop_class_uid;      // empty if the peer does not return it
+    int32_t instance_number = 0;
+};
+
+// Sub-operation counts of a C-MOVE or C-GET, as reported by the peer
+struct RetrieveCounts {
+    uint32_t completed = 0;
+    uint32_t failed = 0;
+    uint32_t warning = 0;
+};
+
+// C-FIND with the Study Root information model, one association per call
+Result<std::vector<StudyMatch>, ErrorInfo> find_studies(const DicomPeer& peer, const StudyQuery& query);
+
+Result<std::vector<SeriesMatch>, ErrorInfo>
+    find_series(const DicomPeer& peer, const std::string& study_instance_uid);
+
+// Sorted by instance number, the order the series is displayed and retrieved in
+Result<std::vector<InstanceMatch>, ErrorInfo> find_instances(const DicomPeer& peer,
+    const std::string& study_instance_uid, const std::string& series_instance_uid);
+
+// Asks the peer to send a series to another application entity (usually our
+// own StorageServer, which the peer must know by AE title). Returns once the
+// peer reports the move complete; the instances arrive on the destination.
+Result<RetrieveCounts, ErrorInfo> move_series(const DicomPeer& peer, const std::string& destination_ae_title,
+    const std::string& study_instance_uid, const std::string& series_instance_uid);
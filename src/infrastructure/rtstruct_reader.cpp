@@ -0,0 +1,162 @@
+#include "rtstruct_reader.hpp"
+
+// DCMTK includes
+#include <dcmtk/dcmdata/dctk.h>
+#include <dcmtk/dcmrt/seq/drtssrs.h>
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <iostream>
+#include <map>
+
+namespace {
+
+// Colors for structures without an ROI Display Color
+constexpr std::array<std::array<uint8_t, 3>, 8> kFallbackColors{ {
+    { 255, 0, 0 }, { 0, 255, 0 }, { 0, 128, 255 }, { 255, 255, 0 },
+    { 255, 0, 255 }, { 0, 255, 255 }, { 255, 128, 0 }, { 160, 96, 255 }
+} };
+
+// One contour's Contour Data text, parsed on the pool
+struct PendingContour {
+    uint32_t structure;
+    uint32_t slot;            // index into the structure's contours
+    const char* text;
+    size_t length;
+};
+
+// Decimal String values separated by backslashes, with the padding and
+// leading plus sign DS allows; false when a value does not parse
+bool parse_decimals(const char* text, size_t length, std::vector<double>& values) {
+    values.clear();
+    const char* p = text;
+    const char* end = text + length;
+    while (p < end) {
+        while (p < end && (*p == ' ' || *p == '+')) ++p;
+        double value = 0.0;
+        const auto [next, error] = std::from_chars(p, end, value);
+        if (error != std::errc()) return false;
+        values.push_back(value);
+        p = next;
+        while (p < end && *p == ' ') ++p;
+        if (p < end && *p++ != '\\') return false;
+    }
+    return true;
+}
+
+} // namespace
+
+Result<StructureSet, ErrorInfo> load_structure_set(const std::filesystem::path& path, ThreadPool& pool) {
+    const auto start = std::chrono::steady_clock::now();
+
+    DcmFileFormat file_format;
+    OFCondition status = file_format.loadFile(path.string().c_str());
+    if (status.bad()) {
+        return ErrorInfo{ DicomError::InvalidFormat, "Failed to load DICOM file", status.text() };
+    }
+    DcmDataset* dataset = file_format.getDataset();
+    OFString sop_class;
+    dataset->findAndGetOFString(DCM_SOPClassUID, sop_class);
+    if (sop_class != UID_RTStructureSetStorage) {
+        return ErrorInfo{ DicomError::InvalidFormat, "Not an RT Structure Set", sop_class.c_str() };
+    }
+
+    DRTStructureSetROISequence rois;
+    status = rois.read(*dataset, "1-n", "1", "StructureSetModule");
+    if (status.bad()) {
+        return ErrorInfo{ DicomError::InvalidFormat, "RT Structure Set has no readable ROIs", status.text() };
+    }
+
+    StructureSet result;
+    std::map<Sint32, uint32_t> by_number;
+    for (OFCondition it = rois.gotoFirstItem(); it.good(); it = rois.gotoNextItem()) {
+        const DRTStructureSetROISequence::Item& item = rois.getCurrentItem();
+        Structure structure;
+        if (item.getROINumber(structure.number).bad()) continue;
+        OFString text;
+        if (item.getROIName(text).good()) structure.name = text.c_str();
+        if (result.frame_of_reference_uid.empty() && item.getReferencedFrameOfReferenceUID(text).good()) {
+            result.frame_of_reference_uid = text.c_str();
+        }
+        structure.color = kFallbackColors[result.structures.size() % kFallbackColors.size()];
+        by_number[structure.number] = static_cast<uint32_t>(result.structures.size());
+        result.structures.push_back(std::move(structure));
+    }
+
+    // The ROI Contour Sequence is walked here rather than through dcmrt,
+    // which checks every Contour Data value with the VR scanner and converts
+    // each with a locale-independent atof: about a microsecond per value,
+    // seconds for a full planning structure set. The text is gathered
+    // serially, as values larger than the read limit load on first access.
+    std::vector<PendingContour> pending;
+    size_t skipped = 0;
+    DcmSequenceOfItems* roi_contours = nullptr;
+    dataset->findAndGetSequence(DCM_ROIContourSequence, roi_contours);
+    for (DcmObject* object = roi_contours ? roi_contours->nextInContainer(nullptr) : nullptr; object;
+        object = roi_contours->nextInContainer(object)) {
+        auto* item = static_cast<DcmItem*>(object);
+        Sint32 number = 0;
+        auto found = item->findAndGetSint32(DCM_ReferencedROINumber, number).good()
+            ? by_number.find(number) : by_number.end();
+        if (found == by_number.end()) continue;
+        Structure& structure = result.structures[found->second];
+        Sint32 red = 0, green = 0, blue = 0;
+        if (item->findAndGetSint32(DCM_ROIDisplayColor, red, 0).good() &&
+            item->findAndGetSint32(DCM_ROIDisplayColor, green, 1).good() &&
+            item->findAndGetSint32(DCM_ROIDisplayColor, blue, 2).good()) {
+            structure.color = { static_cast<uint8_t>(std::clamp<Sint32>(red, 0, 255)),
+                                static_cast<uint8_t>(std::clamp<Sint32>(green, 0, 255)),
+                                static_cast<uint8_t>(std::clamp<Sint32>(blue, 0, 255)) };
+        }
+
+        DcmSequenceOfItems* contours = nullptr;
+        item->findAndGetSequence(DCM_ContourSequence, contours);
+        for (DcmObject* entry = contours ? contours->nextInContainer(nullptr) : nullptr; entry;
+            entry = contours->nextInContainer(entry)) {
+            auto* contour = static_cast<DcmItem*>(entry);
+            OFString type;
+            DcmElement* data = nullptr;
+            char* text = nullptr;
+            Uint32 length = 0;
+            contour->findAndGetOFString(DCM_ContourGeometricType, type);
+            if (type != "CLOSED_PLANAR" || contour->findAndGetElement(DCM_ContourData, data).bad() ||
+                data->getString(text, length).bad() || !text) {
+                ++skipped;
+                continue;
+            }
+            pending.push_back({ found->second, static_cast<uint32_t>(structure.contours.size()), text, length });
+            structure.contours.emplace_back();
+        }
+    }
+
+    pool.parallel_for(pending.size(), [&](size_t begin, size_t end) {
+        std::vector<double> values;
+        for (size_t i = begin; i < end; ++i) {
+            const PendingContour& contour = pending[i];
+            if (!parse_decimals(contour.text, contour.length, values) || values.size() < 9) continue;
+            auto& points = result.structures[contour.structure].contours[contour.slot].points;
+            points.reserve(values.size() / 3);
+            for (size_t p = 0; p + 2 < values.size(); p += 3) {
+                points.push_back(Vec3{ values[p], values[p + 1], values[p + 2] });
+            }
+        }
+    });
+
+    // Contours that did not parse are left out
+    for (Structure& structure : result.structures) {
+        const size_t before = structure.contours.size();
+        std::erase_if(structure.contours, [](const StructureContour& contour) { return contour.points.empty(); });
+        skipped += before - structure.contours.size();
+    }
+
+    const auto elapsed = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << "[DEBUG] Loaded structure set with " << result.structures.size() << " structures, "
+        << result.contour_count() << " contours in " << elapsed << " ms" << std::endl;
+    if (skipped > 0) {
+        std::cout << "[DEBUG] Skipped " << skipped << " contours that are not closed planar or not readable"
+            << std::endl;
+    }
+    return result;
+}
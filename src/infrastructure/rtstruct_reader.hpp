@@ -0,0 +1,15 @@
+#pragma once
+
+#include "core/result.hpp"
+#include "core/error_codes.hpp"
+#include "core/structure_set.hpp"
+#include "core/thread_pool.hpp"
+#include <filesystem>
+
+// Loads an RT Structure Set: the ROIs of the Structure Set ROI Sequence,
+// read with dcmrt, each with its ROI Display Color (a fixed palette when
+// absent) and the CLOSED_PLANAR contours of the ROI Contour Sequence.
+// Contour Data is parsed on the pool. Points, open contours and contours
+// that do not parse are left out.
+Result<StructureSet, ErrorInfo>
+    load_structure_set(const std::filesystem::path& path, ThreadPool& pool = ThreadPool::shared());
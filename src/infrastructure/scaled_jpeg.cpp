@@ -0,0 +1,143 @@
+#include "scaled_jpeg.hpp"
+
+// DCMTK's IJG 8-bit library; its symbols carry a dcmtk_jpeg8_ prefix
+#include <dcmtk/config/osconfig.h>
+#include <algorithm>
+#include <csetjmp>
+#include <cstdio>
+
+extern "C" {
+#define boolean ijg_boolean
+#include "jpeglib8.h"
+#include "jerror8.h"
+#undef boolean
+}
+
+#ifdef const
+#undef const
+#endif
+
+namespace {
+
+struct ErrorManager {
+    jpeg_error_mgr pub;
+    std::jmp_buf jump;
+};
+
+extern "C" void scaled_jpeg_error_exit(j_common_ptr cinfo) {
+    std::longjmp(reinterpret_cast<ErrorManager*>(cinfo->err)->jump, 1);
+}
+
+// Warnings such as corrupt data are not worth a line per thumbnail
+extern "C" void scaled_jpeg_emit_message(j_common_ptr, int) {
+}
+
+extern "C" void scaled_jpeg_init_source(j_decompress_ptr) {
+}
+
+// The whole stream is in memory; running out of it means a truncated stream,
+// which ends with a fake EOI as the IJG examples do
+extern "C" ijg_boolean scaled_jpeg_fill_input_buffer(j_decompress_ptr cinfo) {
+    static const JOCTET end_of_image[] = { 0xFF, JPEG_EOI };
+    cinfo->src->next_input_byte = end_of_image;
+    cinfo->src->bytes_in_buffer = 2;
+    return TRUE;
+}
+
+extern "C" void scaled_jpeg_skip_input_data(j_decompress_ptr cinfo, long num_bytes) {
+    if (num_bytes <= 0) {
+        return;
+    }
+    const size_t skip = std::min(static_cast<size_t>(num_bytes), cinfo->src->bytes_in_buffer);
+    cinfo->src->next_input_byte += skip;
+    cinfo->src->bytes_in_buffer -= skip;
+}
+
+extern "C" void scaled_jpeg_term_source(j_decompress_ptr) {
+}
+
+// State that must survive a longjmp out of the library
+struct Decompressor {
+    jpeg_decompress_struct cinfo{};
+    ErrorManager error{};
+    jpeg_source_mgr source{};
+    bool created = false;
+
+    ~Decompressor() {
+        if (created) {
+            jpeg_destroy_decompress(&cinfo);
+        }
+    }
+};
+
+bool run_decode(Decompressor& d, const uint8_t* data, size_t size, uint32_t min_dimension,
+    bool rgb_components, ScaledJpegImage& image) {
+    d.cinfo.err = jpeg_std_error(&d.error.pub);
+    d.error.pub.error_exit = scaled_jpeg_error_exit;
+    d.error.pub.emit_message = scaled_jpeg_emit_message;
+    if (setjmp(d.error.jump)) {
+        return false;
+    }
+    jpeg_create_decompress(&d.cinfo);
+    d.created = true;
+
+    d.source.init_source = scaled_jpeg_init_source;
+    d.source.fill_input_buffer = scaled_jpeg_fill_input_buffer;
+    d.source.skip_input_data = scaled_jpeg_skip_input_data;
+    d.source.resync_to_restart = jpeg_resync_to_restart;
+    d.source.term_source = scaled_jpeg_term_source;
+    d.source.next_input_byte = data;
+    d.source.bytes_in_buffer = size;
+    d.cinfo.src = &d.source;
+
+    jpeg_read_header(&d.cinfo, TRUE);
+    if (d.cinfo.process == JPROC_LOSSLESS || (d.cinfo.num_components != 1 && d.cinfo.num_components != 3)) {
+        return false;
+    }
+    if (d.cinfo.num_components == 3) {
+        if (rgb_components) {
+            d.cinfo.jpeg_color_space = JCS_RGB;
+        }
+        d.cinfo.out_color_space = JCS_RGB;
+    }
+
+    const uint32_t longest = std::max<uint32_t>(d.cinfo.image_width, d.cinfo.image_height);
+    uint32_t denominator = 1;
+    while (denominator < 8 && longest / (denominator * 2) >= min_dimension) {
+        denominator *= 2;
+    }
+    d.cinfo.scale_num = 1;
+    d.cinfo.scale_denom = denominator;
+    d.cinfo.dct_method = JDCT_IFAST;
+    d.cinfo.do_fancy_upsampling = FALSE;
+
+    jpeg_start_decompress(&d.cinfo);
+    image.width = d.cinfo.output_width;
+    image.height = d.cinfo.output_height;
+    image.components = static_cast<uint32_t>(d.cinfo.output_components);
+    image.scale_denominator = denominator;
+    const size_t row_bytes = static_cast<size_t>(image.width) * image.components;
+    image.samples.resize(row_bytes * image.height);
+    while (d.cinfo.output_scanline < d.cinfo.output_height) {
+        JSAMPROW row = image.samples.data() + static_cast<size_t>(d.cinfo.output_scanline) * row_bytes;
+        jpeg_read_scanlines(&d.cinfo, &row, 1);
+    }
+    jpeg_finish_decompress(&d.cinfo);
+    return true;
+}
+
+} // namespace
+
+Result<ScaledJpegImage, ErrorInfo> decode_jpeg_scaled(const uint8_t* data, size_t size,
+    uint32_t min_dimension, bool rgb_components) {
+    Decompressor decompressor;
+    ScaledJpegImage image;
+    if (!run_decode(decompressor, data, size, std::max<uint32_t>(min_dimension, 1), rgb_components, image)) {
+        char message[JMSG_LENGTH_MAX] = "not an 8-bit DCT stream";
+        if (decompressor.created && decompressor.error.pub.msg_code != 0) {
+            decompressor.error.pub.format_message(reinterpret_cast<j_common_ptr>(&decompressor.cinfo), message);
+        }
+        return ErrorInfo{ DicomError::InvalidFormat, "Scaled JPEG decode failed", message };
+    }
+    return image;
+}
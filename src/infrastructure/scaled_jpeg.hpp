@@ -0,0 +1,24 @@
+#pragma once
+
+#include "core/result.hpp"
+#include "core/error_codes.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct ScaledJpegImage {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t components = 0;        // 1 gray, 3 RGB
+    std::vector<uint8_t> samples;   // interleaved, row-major
+    uint32_t scale_denominator = 1;
+};
+
+// Decodes an 8-bit DCT (baseline or extended) JPEG stream at 1/1, 1/2, 1/4
+// or 1/8 scale, the largest reduction that keeps the longest side at least
+// min_dimension. The reduced image comes straight out of the inverse DCT,
+// so the transform and color conversion cost fall with the square of the
+// scale; only the entropy decoding still covers every block. Three-component
+// streams are converted to RGB unless rgb_components says they already are.
+Result<ScaledJpegImage, ErrorInfo> decode_jpeg_scaled(const uint8_t* data, size_t size,
+    uint32_t min_dimension, bool rgb_components);
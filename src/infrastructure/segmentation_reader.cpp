@@ -0,0 +1,259 @@
+#include "segmentation_reader.hpp"
+#include "codec_registry.hpp"
+#include "core/mask_blend.hpp"
+
+// DCMTK includes
+#include <dcmtk/dcmdata/dctk.h>
+#include <dcmtk/dcmfg/fgderimg.h>
+#include <dcmtk/dcmfg/fgseg.h>
+#include <dcmtk/dcmseg/segdoc.h>
+#include <dcmtk/dcmseg/segment.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <optional>
+
+namespace {
+
+// Colors for segments without a Recommended Display CIELab Value
+constexpr std::array<std::array<uint8_t, 3>, 6> kFallbackColors{ {
+    { 255, 64, 64 }, { 64, 200, 64 }, { 64, 128, 255 }, { 255, 200, 0 }, { 200, 64, 255 }, { 0, 210, 210 }
+} };
+
+// Recommended Display CIELab Value (L 0-100, a and b -128-127, each scaled
+// to 0-65535) to sRGB, under the D65 white point
+std::array<uint8_t, 3> cielab_to_srgb(Uint16 l_scaled, Uint16 a_scaled, Uint16 b_scaled) {
+    const double l = l_scaled * 100.0 / 65535.0;
+    const double a = a_scaled * 255.0 / 65535.0 - 128.0;
+    const double b = b_scaled * 255.0 / 65535.0 - 128.0;
+
+    const auto f_inverse = [](double t) {
+        return t > 6.0 / 29.0 ? t * t * t : 3.0 * (6.0 / 29.0) * (6.0 / 29.0) * (t - 4.0 / 29.0);
+    };
+    const double fy = (l + 16.0) / 116.0;
+    const double x = 0.95047 * f_inverse(fy + a / 500.0);
+    const double y = 1.00000 * f_inverse(fy);
+    const double z = 1.08883 * f_inverse(fy - b / 200.0);
+
+    const auto encode = [](double linear) {
+        linear = std::clamp(linear, 0.0, 1.0);
+        const double v = linear <= 0.0031308 ? 12.92 * linear : 1.055 * std::pow(linear, 1.0 / 2.4) - 0.055;
+        return static_cast<uint8_t>(std::lround(v * 255.0));
+    };
+    return { encode(3.2406 * x - 1.5372 * y - 0.4986 * z),
+             encode(-0.9689 * x + 1.8758 * y + 0.0415 * z),
+             encode(0.0557 * x - 0.2040 * y + 1.0570 * z) };
+}
+
+// The source frames a SEG frame was derived from; frame numbers are 1-based
+// in the file, and none listed means the whole (single-frame) source
+std::vector<SourceFrame> source_frames(FGDerivationImage* derivation) {
+    std::vector<SourceFrame> sources;
+    if (!derivation) return sources;
+    for (DerivationImageItem* item : derivation->getDerivationImageItems()) {
+        for (SourceImageItem* source : item->getSourceImageItems()) {
+            ImageSOPInstanceReferenceMacro& reference = source->getImageSOPInstanceReference();
+            OFString uid;
+            if (reference.getReferencedSOPInstanceUID(uid).bad() || uid.empty()) continue;
+            OFVector<Uint16> numbers;
+            reference.getReferencedFrameNumber(numbers);
+            if (numbers.empty()) {
+                sources.emplace_back(uid.c_str(), 0);
+            }
+            for (Uint16 number : numbers) {
+                if (number > 0) sources.emplace_back(uid.c_str(), number - 1u);
+            }
+        }
+    }
+    return sources;
+}
+
+// What is known of a SEG frame before its pixels are read
+struct FrameInfo {
+    uint32_t segment = 0;            // index into Segmentation::segments; unused for label maps
+    std::vector<SourceFrame> sources;
+};
+
+// A mask cut to the rows of a full-frame coverage image that hold anything;
+// nullopt when the frame is empty
+std::optional<SegmentMask> crop_rows(const uint8_t* coverage, uint32_t width, uint32_t height) {
+    const auto row_empty = [&](uint32_t y) {
+        const uint8_t* row = coverage + static_cast<size_t>(y) * width;
+        return std::all_of(row, row + width, [](uint8_t v) { return v == 0; });
+    };
+    uint32_t first = 0;
+    while (first < height && row_empty(first)) ++first;
+    if (first == height) return std::nullopt;
+    uint32_t end = height;
+    while (end > first && row_empty(end - 1)) --end;
+
+    SegmentMask mask;
+    mask.first_row = first;
+    mask.end_row = end;
+    mask.coverage.assign(coverage + static_cast<size_t>(first) * width, coverage + static_cast<size_t>(end) * width);
+    return mask;
+}
+
+} // namespace
+
+Result<Segmentation, ErrorInfo>
+load_segmentation(const std::filesystem::path& path, ThreadPool& pool) {
+    const auto start = std::chrono::steady_clock::now();
+
+    DcmFileFormat file_format;
+    OFCondition status = file_format.loadFile(path.string().c_str());
+    if (status.bad()) {
+        return ErrorInfo{ DicomError::InvalidFormat, "Failed to load DICOM file", status.text() };
+    }
+    DcmDataset* dataset = file_format.getDataset();
+
+    // loadDataset decompresses RLE frames through the registered decoders
+    ensure_decoders(*dataset);
+    DcmSegmentation* loaded = nullptr;
+    status = DcmSegmentation::loadDataset(*dataset, loaded);
+    std::unique_ptr<DcmSegmentation> seg(loaded);
+    if (status.bad() || !seg) {
+        return ErrorInfo{ DicomError::InvalidFormat, "Not a readable DICOM Segmentation", status.text() };
+    }
+
+    Uint16 rows = 0, columns = 0;
+    dataset->findAndGetUint16(DCM_Rows, rows);
+    dataset->findAndGetUint16(DCM_Columns, columns);
+    const size_t frame_count = seg->getNumberOfFrames();
+    if (rows == 0 || columns == 0) {
+        return ErrorInfo{ DicomError::InvalidImageDimensions, "Segmentation has no frame size", "" };
+    }
+
+    const DcmSegTypes::E_SegmentationType type = seg->getSegmentationType();
+    Uint16 max_fractional = 255;
+    dataset->findAndGetUint16(DCM_MaximumFractionalValue, max_fractional);
+    if (max_fractional == 0) max_fractional = 255;
+
+    Segmentation result;
+    result.width = columns;
+    result.height = rows;
+
+    std::map<Uint16, uint32_t> segment_index;
+    for (const auto& [number, segment] : seg->getSegments()) {
+        Segment entry;
+        entry.number = number;
+        OFString label;
+        if (segment && segment->getSegmentLabel(label).good()) {
+            entry.label = label.c_str();
+        }
+        Uint16 l = 0, a = 0, b = 0;
+        entry.color = segment && segment->getRecommendedDisplayCIELabValue(l, a, b).good()
+            ? cielab_to_srgb(l, a, b) : kFallbackColors[result.segments.size() % kFallbackColors.size()];
+        segment_index[number] = static_cast<uint32_t>(result.segments.size());
+        result.segments.push_back(std::move(entry));
+    }
+
+    // Functional groups are read serially: dcmfg converts values on access
+    // and items shared by all frames are the same objects
+    FGInterface& groups = seg->getFunctionalGroups();
+    std::vector<FrameInfo> infos(frame_count);
+    size_t unreferenced = 0;
+    for (size_t f = 0; f < frame_count; ++f) {
+        const Uint32 frame = static_cast<Uint32>(f);
+        infos[f].sources = source_frames(
+            OFstatic_cast(FGDerivationImage*, groups.get(frame, DcmFGTypes::EFG_DERIVATIONIMAGE)));
+        if (infos[f].sources.empty()) ++unreferenced;
+
+        if (type != DcmSegTypes::ST_LABELMAP) {
+            auto* group = OFstatic_cast(FGSegmentation*, groups.get(frame, DcmFGTypes::EFG_SEGMENTATION));
+            Uint16 number = 0;
+            auto it = group && group->getReferencedSegmentNumber(number).good()
+                ? segment_index.find(number) : segment_index.end();
+            if (it == segment_index.end()) {
+                infos[f].sources.clear();
+                continue;
+            }
+            infos[f].segment = it->second;
+        }
+    }
+
+    // Unpacking and cropping run per frame on the pool
+    const size_t pixels = static_cast<size_t>(rows) * columns;
+    std::vector<std::vector<SegmentMask>> frame_masks(frame_count);
+    std::vector<const DcmIODTypes::FrameBase*> frames(frame_count);
+    for (size_t f = 0; f < frame_count; ++f) {
+        frames[f] = seg->getFrame(f);
+    }
+
+    pool.parallel_for(frame_count, [&](size_t begin, size_t end) {
+        std::vector<uint8_t> coverage(pixels);
+        for (size_t f = begin; f < end; ++f) {
+            const DcmIODTypes::FrameBase* frame = frames[f];
+            if (!frame || infos[f].sources.empty()) continue;
+            const void* data = frame->getPixelData();
+            const size_t bytes = frame->getLengthInBytes();
+
+            const auto add = [&](uint32_t segment) {
+                if (auto mask = crop_rows(coverage.data(), columns, rows)) {
+                    mask->segment = segment;
+                    mask->sources = infos[f].sources;
+                    frame_masks[f].push_back(std::move(*mask));
+                }
+            };
+
+            if (type == DcmSegTypes::ST_BINARY) {
+                if (bytes * 8 < pixels) continue;
+                unpack_bits(static_cast<const uint8_t*>(data), 0, pixels, coverage.data());
+                add(infos[f].segment);
+            }
+            else if (type == DcmSegTypes::ST_FRACTIONAL) {
+                if (bytes < pixels) continue;
+                const uint8_t* values = static_cast<const uint8_t*>(data);
+                for (size_t i = 0; i < pixels; ++i) {
+                    const uint32_t v = std::min<uint32_t>(values[i], max_fractional);
+                    coverage[i] = static_cast<uint8_t>((v * 255 + max_fractional / 2) / max_fractional);
+                }
+                add(infos[f].segment);
+            }
+            else if (type == DcmSegTypes::ST_LABELMAP) {
+                // One mask per segment whose label occurs in the frame
+                const bool wide = frame->bytesPerPixel() == 2;
+                if (bytes < pixels * (wide ? 2 : 1)) continue;
+                const auto label_at = [&](size_t i) -> Uint16 {
+                    return wide ? static_cast<const Uint16*>(data)[i] : static_cast<const Uint8*>(data)[i];
+                };
+                std::vector<Uint16> labels;
+                for (size_t i = 0; i < pixels; ++i) {
+                    const Uint16 label = label_at(i);
+                    if (label != 0 && std::find(labels.begin(), labels.end(), label) == labels.end()) {
+                        labels.push_back(label);
+                    }
+                }
+                for (Uint16 label : labels) {
+                    auto it = segment_index.find(label);
+                    if (it == segment_index.end()) continue;
+                    for (size_t i = 0; i < pixels; ++i) {
+                        coverage[i] = label_at(i) == label ? 255 : 0;
+                    }
+                    add(it->second);
+                }
+            }
+        }
+    });
+
+    for (auto& masks : frame_masks) {
+        for (SegmentMask& mask : masks) {
+            result.masks.push_back(std::move(mask));
+        }
+    }
+    result.finish();
+
+    const auto elapsed = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << "[DEBUG] Loaded segmentation with " << result.segments.size() << " segments, "
+        << result.masks.size() << " non-empty masks from " << frame_count << " frames in "
+        << elapsed << " ms" << std::endl;
+    if (unreferenced > 0) {
+        std::cout << "[DEBUG] " << unreferenced << " segmentation frames name no source frame" << std::endl;
+    }
+
+    return result;
+}
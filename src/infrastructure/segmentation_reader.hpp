@@ -0,0 +1,16 @@
+#pragma once
+
+#include "core/result.hpp"
+#include "core/error_codes.hpp"
+#include "core/segmentation.hpp"
+#include "core/thread_pool.hpp"
+#include <filesystem>
+
+// Loads a DICOM Segmentation with dcmseg. Binary frames are unpacked from
+// their 1-bit packing and fractional ones scaled to 0-255 by the Maximum
+// Fractional Value, on the pool; label maps give one mask per label. Each
+// frame is matched to its source frames through the Derivation Image
+// functional group (Referenced SOP Instance UID and Referenced Frame
+// Number); frames without one are left out. Empty frames are dropped.
+Result<Segmentation, ErrorInfo>
+    load_segmentation(const std::filesystem::path& path, ThreadPool& pool = ThreadPool::shared());
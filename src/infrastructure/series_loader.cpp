@@ -0,0 +1,466 @@
+#include "series_loader.hpp"
+#include "codec_registry.hpp"
+#include "mapped_file.hpp"
+#include "memory_usage.hpp"
+#include "core/thread_pool.hpp"
+
+// DCMTK includes
+#include <dcmtk/dcmdata/dctk.h>
+#include <dcmtk/dcmimgle/dcmimage.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <system_error>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+struct SliceFile {
+    std::filesystem::path path;
+    Vec3 position;
+    double distance = 0;   // along the slice normal
+};
+
+class ScratchVoxelStorage : public VoxelStorage {
+    MappedFile file_;
+
+public:
+    explicit ScratchVoxelStorage(MappedFile file) : file_(std::move(file)) {
+        data_ = reinterpret_cast<uint16_t*>(file_.writable_data());
+    }
+
+    bool file_backed() const override { return true; }
+};
+
+Vec3 to_vec3(const std::array<double, 3>& v) {
+    return { v[0], v[1], v[2] };
+}
+
+bool same_orientation(const std::array<double, 6>& a, const std::array<double, 6>& b) {
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (std::abs(a[i] - b[i]) > 1e-3) return false;
+    }
+    return true;
+}
+
+bool is_integer(double value) {
+    return value == std::floor(value);
+}
+
+// Modality values [low, high] a slice can hold according to its header
+void nominal_modality_range(const DicomMetadata& meta, double& low, double& high) {
+    const uint16_t bits = std::clamp<uint16_t>(meta.bits_stored.value_or(16), 1, 32);
+    const bool is_signed = meta.pixel_representation.value_or(0) == 1;
+    const double stored_min = is_signed ? -std::ldexp(1.0, bits - 1) : 0.0;
+    const double stored_max = is_signed ? std::ldexp(1.0, bits - 1) - 1 : std::ldexp(1.0, bits) - 1;
+    const double slope = meta.rescale_slope.value_or(1.0);
+    const double intercept = meta.rescale_intercept.value_or(0.0);
+    low = std::min(stored_min * slope, stored_max * slope) + intercept;
+    high = std::max(stored_min * slope, stored_max * slope) + intercept;
+}
+
+// Integer modality values that fit 16 bits are kept exactly; anything else is
+// spread over the full 16-bit range
+ModalityMapping choose_modality_mapping(const std::vector<DicomMetadata>& slices, bool monochrome1) {
+    double low = std::numeric_limits<double>::max();
+    double high = std::numeric_limits<double>::lowest();
+    bool integer = true;
+    for (const DicomMetadata& meta : slices) {
+        double slice_low = 0, slice_high = 0;
+        nominal_modality_range(meta, slice_low, slice_high);
+        low = std::min(low, slice_low);
+        high = std::max(high, slice_high);
+        integer = integer && is_integer(meta.rescale_slope.value_or(1.0)) &&
+            is_integer(meta.rescale_intercept.value_or(0.0));
+    }
+
+    ModalityMapping mapping;
+    mapping.slope = (integer && high - low <= 65535.0) ? 1.0 : std::max(high - low, 1e-9) / 65535.0;
+    mapping.intercept = low;
+    if (monochrome1) {
+        mapping.slope = -mapping.slope;
+        mapping.intercept = low + 65535.0 * -mapping.slope;
+    }
+    return mapping;
+}
+
+struct DecodedSlice {
+    uint16_t min_voxel = 0xFFFF;
+    uint16_t max_voxel = 0;
+    std::optional<std::pair<double, double>> window;   // center, width in modality units
+};
+
+// Decodes one slice into dst through the volume's value mapping. Stored values
+// go through the slice's own rescale, so slices with different Rescale
+// Slope/Intercept (e.g. PET) still land on one scale.
+Result<DecodedSlice, ErrorInfo> decode_slice(const std::filesystem::path& path, const Volume& volume,
+    uint16_t* dst) {
+    DcmFileFormat file_format;
+    OFCondition status = file_format.loadFile(path.string().c_str());
+    if (status.bad()) {
+        return ErrorInfo{ DicomError::InvalidFormat, "Failed to load DICOM file", status.text() };
+    }
+    DcmDataset* dataset = file_format.getDataset();
+
+    Float64 slope = 1.0, intercept = 0.0;
+    dataset->findAndGetFloat64(DCM_RescaleSlope, slope);
+    dataset->findAndGetFloat64(DCM_RescaleIntercept, intercept);
+
+    DecodedSlice decoded;
+    Float64 wc = 0, ww = 0;
+    if (dataset->findAndGetFloat64(DCM_WindowCenter, wc).good() &&
+        dataset->findAndGetFloat64(DCM_WindowWidth, ww).good() && ww > 0) {
+        decoded.window = std::make_pair(wc, ww);
+    }
+
+    // DCMTK rounds rescaled values to integers, so a fractional rescale is
+    // applied here instead; integer rescales and Modality LUTs are left to DCMTK
+    const bool rescale_here = !dataset->tagExists(DCM_ModalityLUTSequence) &&
+        !(is_integer(slope) && is_integer(intercept));
+    if (!rescale_here) {
+        slope = 1.0;
+        intercept = 0.0;
+    }
+    ensure_decoders(*dataset);
+    ::DicomImage image(static_cast<DcmObject*>(dataset), EXS_Unknown,
+        CIF_MayDetachPixelData | (rescale_here ? CIF_IgnoreModalityTransformation : 0));
+    if (image.getStatus() != EIS_Normal) {
+        return ErrorInfo{ DicomError::InvalidImageDimensions, "Failed to load DICOM image",
+                         ::DicomImage::getString(image.getStatus()) };
+    }
+    if (!image.isMonochrome() || image.getWidth() != volume.width || image.getHeight() != volume.height) {
+        return ErrorInfo{ DicomError::UnsupportedPhotometricInterpretation,
+                         "Series slices must be grayscale and of one size", path.filename().string() };
+    }
+
+    const DiPixel* pixel_data = image.getInterData();
+    if (!pixel_data) {
+        return ErrorInfo{ DicomError::MissingPixelData, "No pixel data found", path.filename().string() };
+    }
+
+    const ModalityMapping& mapping = volume.modality;
+    auto to_voxel = [&](double stored) {
+        const double voxel = mapping.to_sample(stored * slope + intercept);
+        return static_cast<uint16_t>(std::clamp(std::round(voxel), 0.0, 65535.0));
+    };
+
+    const size_t count = volume.slice_voxels();
+    auto convert = [&](const auto* src) {
+        using T = std::remove_cv_t<std::remove_pointer_t<decltype(src)>>;
+        if constexpr (sizeof(T) <= 2) {
+            // One table over every possible sample value
+            constexpr int64_t lowest = std::numeric_limits<T>::min();
+            std::vector<uint16_t> lut(size_t{ 1 } << (8 * sizeof(T)));
+            for (size_t i = 0; i < lut.size(); ++i) {
+                lut[i] = to_voxel(static_cast<double>(lowest + static_cast<int64_t>(i)));
+            }
+            for (size_t i = 0; i < count; ++i) {
+                dst[i] = lut[static_cast<size_t>(static_cast<int64_t>(src[i]) - lowest)];
+            }
+        }
+        else {
+            for (size_t i = 0; i < count; ++i) dst[i] = to_voxel(static_cast<double>(src[i]));
+        }
+    };
+
+    const void* raw = pixel_data->getData();
+    switch (pixel_data->getRepresentation()) {
+    case EPR_Uint8: convert(static_cast<const uint8_t*>(raw)); break;
+    case EPR_Sint8: convert(static_cast<const int8_t*>(raw)); break;
+    case EPR_Uint16: convert(static_cast<const uint16_t*>(raw)); break;
+    case EPR_Sint16: convert(static_cast<const int16_t*>(raw)); break;
+    case EPR_Uint32: convert(static_cast<const uint32_t*>(raw)); break;
+    case EPR_Sint32: convert(static_cast<const int32_t*>(raw)); break;
+    default:
+        return ErrorInfo{ DicomError::InvalidFormat, "Unsupported pixel representation", path.filename().string() };
+    }
+
+    const auto [lo, hi] = std::minmax_element(dst, dst + count);
+    decoded.min_voxel = *lo;
+    decoded.max_voxel = *hi;
+    return decoded;
+}
+
+Result<Volume, ErrorInfo> allocate_volume(uint32_t width, uint32_t height, uint32_t depth,
+    const VolumeLoadOptions& options) {
+    Volume volume;
+    const size_t bytes = Volume::storage_bytes(width, height, depth);
+
+    bool scratch = options.storage == VolumeStorageMode::ScratchFile;
+    if (options.storage == VolumeStorageMode::Auto) {
+        const uint64_t physical = physical_memory_bytes();
+        scratch = physical > 0 && bytes > physical / 2;
+    }
+
+    if (scratch) {
+        std::filesystem::path directory = options.scratch_directory;
+        if (directory.empty()) {
+            std::error_code ec;
+            directory = std::filesystem::temp_directory_path(ec);
+            if (ec) {
+                return ErrorInfo{ DicomError::FileNotFound, "No directory for the volume scratch file", ec.message() };
+            }
+        }
+        auto mapped = MappedFile::create_scratch(directory, bytes);
+        if (mapped.is_error()) {
+            return std::move(mapped).error();
+        }
+        volume.allocate(width, height, depth, std::make_unique<ScratchVoxelStorage>(std::move(mapped.value())));
+        std::cout << "[DEBUG] Volume backed by a " << bytes / (1024 * 1024) << " MB scratch file in "
+            << directory.string() << std::endl;
+    }
+    else {
+        volume.allocate(width, height, depth);
+    }
+
+    if (volume.empty()) {
+        return ErrorInfo{ DicomError::MemoryAllocationFailed, "Failed to allocate volume",
+                         std::to_string(bytes / (1024 * 1024)) + " MB" };
+    }
+    return volume;
+}
+
+// Stacks the frames of one enhanced multi-frame object along the slice
+// normal, placed by the per-frame positions of its functional groups. The
+// frames are already on one value scale, which the volume keeps.
+Result<Volume, ErrorInfo> load_multiframe_volume(const std::filesystem::path& file, IDicomReader& reader,
+    const VolumeLoadOptions& options) {
+    const auto start = std::chrono::steady_clock::now();
+
+    auto frames_result = reader.load_frames(file);
+    if (frames_result.is_error()) {
+        return std::move(frames_result).error();
+    }
+    const FrameSet& frames = frames_result.value();
+    const FunctionalGroupTable& groups = frames.functional_groups;
+    if (!groups.all_have(FunctionalGroupTable::Position) || !groups.all_have(FunctionalGroupTable::Orientation) ||
+        groups.varies(FunctionalGroupTable::Orientation)) {
+        return ErrorInfo{ DicomError::InvalidMetadata, "Frames have no common patient geometry",
+                         file.filename().string() };
+    }
+
+    const Vec3 row_direction = groups.row_direction[0];
+    const Vec3 column_direction = groups.column_direction[0];
+    const Vec3 normal = row_direction.cross(column_direction).normalized();
+
+    // Along the normal; other temporal positions at the same place are dropped
+    std::vector<uint32_t> order(frames.frame_count);
+    for (uint32_t f = 0; f < frames.frame_count; ++f) order[f] = f;
+    auto distance = [&](uint32_t f) { return groups.position[f].dot(normal); };
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        if (distance(a) != distance(b)) return distance(a) < distance(b);
+        if (groups.temporal_position[a] != groups.temporal_position[b]) {
+            return groups.temporal_position[a] < groups.temporal_position[b];
+        }
+        return a < b;
+    });
+    std::vector<uint32_t> sorted;
+    for (uint32_t f : order) {
+        if (!sorted.empty() && std::abs(distance(f) - distance(sorted.back())) < 1e-3) continue;
+        sorted.push_back(f);
+    }
+    if (sorted.size() < frames.frame_count) {
+        std::cout << "[DEBUG] Dropped " << frames.frame_count - sorted.size()
+            << " frames at duplicate slice positions" << std::endl;
+    }
+    if (sorted.size() < 2) {
+        return ErrorInfo{ DicomError::InvalidMetadata, "Series needs at least two slices",
+                         std::to_string(sorted.size()) + " found" };
+    }
+
+    auto volume_result = allocate_volume(frames.width, frames.height, static_cast<uint32_t>(sorted.size()), options);
+    if (volume_result.is_error()) {
+        return volume_result;
+    }
+    Volume& volume = volume_result.value();
+
+    const Vec3 extent = groups.position[sorted.back()] - groups.position[sorted.front()];
+    volume.origin = groups.position[sorted.front()];
+    volume.row_direction = row_direction;
+    volume.column_direction = column_direction;
+    volume.slice_direction = extent.normalized();
+    if (groups.has(sorted.front(), FunctionalGroupTable::Spacing)) {
+        volume.spacing.x = groups.pixel_spacing[sorted.front()][1];
+        volume.spacing.y = groups.pixel_spacing[sorted.front()][0];
+    }
+    volume.spacing.z = extent.length() / (sorted.size() - 1);
+    volume.modality = frames.modality;
+    std::tie(volume.window_center, volume.window_width) = frames.frame_window(sorted[sorted.size() / 2]);
+
+    ThreadPool::shared().parallel_for(sorted.size(), [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; ++k) {
+            const uint16_t* src = frames.frame(sorted[k]);
+            std::copy(src, src + frames.frame_pixels(), volume.slice(static_cast<uint32_t>(k)));
+        }
+    });
+
+    const auto elapsed = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << "[DEBUG] Multi-frame volume: " << volume.width << "x" << volume.height << "x" << volume.depth
+        << ", spacing " << volume.spacing.x << "/" << volume.spacing.y << "/" << volume.spacing.z
+        << " mm, loaded in " << elapsed << " ms" << std::endl;
+
+    return volume_result;
+}
+
+} // namespace
+
+Result<Volume, ErrorInfo>
+load_series_volume(const std::filesystem::path& file, IDicomReader& reader, const VolumeLoadOptions& options) {
+    const auto start = std::chrono::steady_clock::now();
+
+    auto reference_result = reader.load_metadata(file);
+    if (!reference_result) {
+        return std::move(reference_result).error();
+    }
+    const DicomMetadata& reference = reference_result.value();
+    if (reference.number_of_frames.value_or(1) > 1) {
+        return load_multiframe_volume(file, reader, options);
+    }
+    if (!reference.series_instance_uid || !reference.rows || !reference.columns ||
+        !reference.image_position || !reference.image_orientation) {
+        return ErrorInfo{ DicomError::InvalidMetadata, "Image has no series or patient geometry",
+                         file.filename().string() };
+    }
+
+    const auto& orientation = *reference.image_orientation;
+    const Vec3 row_direction = Vec3{ orientation[0], orientation[1], orientation[2] }.normalized();
+    const Vec3 column_direction = Vec3{ orientation[3], orientation[4], orientation[5] }.normalized();
+    const Vec3 normal = row_direction.cross(column_direction).normalized();
+
+    // Collect the slices of the series
+    std::vector<SliceFile> slices;
+    std::vector<DicomMetadata> slice_metadata;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(file.parent_path(), ec)) {
+        if (!entry.is_regular_file(ec)) continue;
+
+        auto meta_result = reader.load_metadata(entry.path());
+        if (!meta_result) continue;
+        DicomMetadata& meta = meta_result.value();
+        if (meta.series_instance_uid != reference.series_instance_uid ||
+            meta.rows != reference.rows || meta.columns != reference.columns ||
+            !meta.image_position || !meta.image_orientation ||
+            !same_orientation(*meta.image_orientation, orientation) ||
+            meta.number_of_frames.value_or(1) > 1) {
+            continue;
+        }
+
+        SliceFile slice;
+        slice.path = entry.path();
+        slice.position = to_vec3(*meta.image_position);
+        slice.distance = slice.position.dot(normal);
+        slices.push_back(std::move(slice));
+        slice_metadata.push_back(std::move(meta));
+    }
+
+    // Sort along the normal; the path breaks ties so duplicates resolve the same way every time
+    std::vector<size_t> order(slices.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        if (slices[a].distance != slices[b].distance) return slices[a].distance < slices[b].distance;
+        return slices[a].path < slices[b].path;
+    });
+
+    // Several images at one position (repeats, other echoes) would fold the volume
+    std::vector<SliceFile> sorted;
+    size_t duplicates = 0;
+    for (size_t index : order) {
+        if (!sorted.empty() && std::abs(slices[index].distance - sorted.back().distance) < 1e-3) {
+            ++duplicates;
+            continue;
+        }
+        sorted.push_back(std::move(slices[index]));
+    }
+    if (duplicates > 0) {
+        std::cout << "[DEBUG] Dropped " << duplicates << " images at duplicate slice positions" << std::endl;
+    }
+
+    if (sorted.size() < 2) {
+        return ErrorInfo{ DicomError::InvalidMetadata, "Series needs at least two slices",
+                         std::to_string(sorted.size()) + " found" };
+    }
+
+    const Vec3 extent = sorted.back().position - sorted.front().position;
+    const double slice_spacing = extent.length() / (sorted.size() - 1);
+
+    double min_gap = std::numeric_limits<double>::max(), max_gap = 0;
+    for (size_t k = 1; k < sorted.size(); ++k) {
+        const double gap = sorted[k].distance - sorted[k - 1].distance;
+        min_gap = std::min(min_gap, gap);
+        max_gap = std::max(max_gap, gap);
+    }
+    if (max_gap > min_gap * 1.1) {
+        std::cout << "[DEBUG] Uneven slice spacing (" << min_gap << " - " << max_gap
+            << " mm), using the mean of " << slice_spacing << " mm" << std::endl;
+    }
+
+    auto volume_result = allocate_volume(*reference.columns, *reference.rows,
+        static_cast<uint32_t>(sorted.size()), options);
+    if (volume_result.is_error()) {
+        return volume_result;
+    }
+    Volume& volume = volume_result.value();
+
+    volume.origin = sorted.front().position;
+    volume.row_direction = row_direction;
+    volume.column_direction = column_direction;
+    volume.slice_direction = extent.normalized();
+    if (reference.pixel_spacing_mm) {
+        volume.spacing.x = (*reference.pixel_spacing_mm)[1];
+        volume.spacing.y = (*reference.pixel_spacing_mm)[0];
+    }
+    volume.spacing.z = slice_spacing;
+    volume.modality = choose_modality_mapping(slice_metadata,
+        reference.photometric_interpretation == "MONOCHROME1");
+
+    // Decode the slices straight into their place in the volume
+    std::mutex mutex;
+    std::optional<ErrorInfo> first_error;
+    std::optional<std::pair<double, double>> window;
+    uint16_t min_voxel = 0xFFFF, max_voxel = 0;
+    const size_t middle = sorted.size() / 2;
+    ThreadPool::shared().parallel_for(sorted.size(), [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; ++k) {
+            auto decoded = decode_slice(sorted[k].path, volume, volume.slice(static_cast<uint32_t>(k)));
+            std::lock_guard lock(mutex);
+            if (decoded.is_error()) {
+                if (!first_error) first_error = std::move(decoded).error();
+                continue;
+            }
+            const DecodedSlice& slice = decoded.value();
+            min_voxel = std::min(min_voxel, slice.min_voxel);
+            max_voxel = std::max(max_voxel, slice.max_voxel);
+            if (k == middle) window = slice.window;
+        }
+    });
+    if (first_error) {
+        return std::move(*first_error);
+    }
+
+    // The file's window in modality units, else the occupied voxel range
+    const ModalityMapping& mapping = volume.modality;
+    if (window) {
+        volume.window_center = static_cast<int32_t>(std::lround(mapping.to_sample(window->first)));
+        volume.window_width = std::max(static_cast<int32_t>(std::lround(window->second / std::abs(mapping.slope))), 1);
+    }
+    else {
+        volume.window_center = (int32_t{ min_voxel } + max_voxel) / 2;
+        volume.window_width = std::max(int32_t{ max_voxel } - min_voxel, 1);
+    }
+
+    const auto elapsed = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << "[DEBUG] Series volume: " << volume.width << "x" << volume.height << "x" << volume.depth
+        << ", spacing " << volume.spacing.x << "/" << volume.spacing.y << "/" << volume.spacing.z
+        << " mm, modality = voxel * " << mapping.slope << " + " << mapping.intercept
+        << ", loaded in " << elapsed << " ms" << std::endl;
+
+    return volume_result;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "core/result.hpp"
+#include "core/error_codes.hpp"
+#include "core/volume.hpp"
+#include "dcmtk_wrapper.hpp"
+#include <filesystem>
+
+enum class VolumeStorageMode {
+    Memory,        // pooled memory
+    ScratchFile,   // memory-mapped scratch file, paged by the OS
+    Auto           // scratch file when the volume exceeds half of physical memory
+};
+
+struct VolumeLoadOptions {
+    VolumeStorageMode storage = VolumeStorageMode::Auto;
+    std::filesystem::path scratch_directory;   // empty: the system temp directory
+};
+
+// Stacks the series that file belongs to (single-frame grayscale images in the
+// same directory with the same Series Instance UID, size and orientation) into
+// a volume. Slices are ordered by position along the slice normal; duplicate
+// positions are dropped. Geometry comes from Image Position/Orientation
+// (Patient) and Pixel Spacing. Every slice is decoded in parallel straight
+// into the volume through one value mapping, chosen from the nominal modality
+// range of the whole series, so voxels compare across slices.
+// An enhanced multi-frame file is stacked from its own frames instead,
+// placed by the per-frame positions of its functional groups.
+Result<Volume, ErrorInfo>
+    load_series_volume(const std::filesystem::path& file, IDicomReader& reader,
+        const VolumeLoadOptions& options = {});
@@ -0,0 +1,207 @@
+#include "series_retriever.hpp"
+
+// DCMTK includes
+#include <dcmtk/dcmdata/dctk.h>
+#include <dcmtk/dcmnet/diutil.h>
+#include <dcmtk/dcmnet/scu.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <unordered_set>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// One presentation context is the C-GET model, the rest carry the C-STOREs
+constexpr size_t kMaxStorageContexts = 127;
+
+// Up to count pending indices nearest focus, alternating ahead and behind
+std::vector<size_t> pick_batch(const std::vector<bool>& pending, size_t focus, uint32_t count) {
+    std::vector<size_t> batch;
+    const size_t n = pending.size();
+    focus = std::min(focus, n - 1);
+    for (size_t distance = 0; batch.size() < count && (focus + distance < n || distance <= focus); ++distance) {
+        if (focus + distance < n && pending[focus + distance]) {
+            batch.push_back(focus + distance);
+        }
+        if (distance > 0 && distance <= focus && batch.size() < count && pending[focus - distance]) {
+            batch.push_back(focus - distance);
+        }
+    }
+    return batch;
+}
+
+} // namespace
+
+// Hands the objects arriving on the C-GET association to the ingest instead
+// of writing them to the working directory
+class SeriesRetriever::Scu : public DcmSCU {
+public:
+    Scu(InstanceIngest& ingest, RetrieveStats& stats, Clock::time_point start)
+        : ingest_(ingest), stats_(stats), start_(start) {
+    }
+
+    bool received(const std::string& sop_instance_uid) const {
+        return received_.count(sop_instance_uid) != 0;
+    }
+
+protected:
+    OFCondition handleSTORERequest(const T_ASC_PresentationContextID /* presID */,
+        DcmDataset* incoming, OFBool& /* continueCGETSession */, Uint16& status) override {
+        if (incoming == nullptr) {
+            return DIMSE_NULLKEY;
+        }
+        // Takes ownership of the dataset; it stays alive until decoded
+        auto file_format = std::make_shared<DcmFileFormat>(incoming, OFFalse);
+        auto result = ingest_.ingest(std::move(file_format));
+        if (result.is_error()) {
+            std::cout << "[DEBUG] C-GET instance rejected: " << result.error().full_message() << std::endl;
+            status = result.error().code == DicomError::InvalidMetadata
+                ? STATUS_STORE_Error_CannotUnderstand
+                : STATUS_STORE_Refused_OutOfResources;
+            return EC_Normal;
+        }
+
+        const InstanceRecord& record = result.value();
+        if (stats_.received++ == 0) {
+            stats_.first_instance_ms = std::chrono::duration<double, std::milli>(Clock::now() - start_).count();
+        }
+        std::error_code ec;
+        stats_.bytes += std::filesystem::file_size(record.path, ec);
+        received_.insert(record.sop_instance_uid);
+        status = STATUS_Success;
+        return EC_Normal;
+    }
+
+private:
+    InstanceIngest& ingest_;
+    RetrieveStats& stats_;
+    Clock::time_point start_;
+    std::unordered_set<std::string> received_;
+};
+
+Result<RetrieveStats, ErrorInfo> SeriesRetriever::retrieve(const DicomPeer& peer,
+    const std::string& study_instance_uid, const std::string& series_instance_uid,
+    const std::vector<InstanceMatch>& instances) {
+    const auto start = Clock::now();
+    RetrieveStats stats;
+    stats.requested = static_cast<uint32_t>(instances.size());
+    if (instances.empty()) {
+        return stats;
+    }
+
+    // Storage contexts for the SOP classes the query reported, or for the
+    // common ones if the peer did not report them
+    std::set<std::string> sop_classes;
+    bool all_known = true;
+    for (const InstanceMatch& instance : instances) {
+        if (instance.sop_class_uid.empty()) {
+            all_known = false;
+            break;
+        }
+        sop_classes.insert(instance.sop_class_uid);
+    }
+    if (!all_known) {
+        sop_classes.clear();
+        for (int i = 0; i < numberOfDcmLongSCUStorageSOPClassUIDs && sop_classes.size() < kMaxStorageContexts; ++i) {
+            sop_classes.insert(dcmLongSCUStorageSOPClassUIDs[i]);
+        }
+    }
+    if (sop_classes.size() > kMaxStorageContexts) {
+        return ErrorInfo{ DicomError::NetworkError, "Too many SOP classes in series",
+                         std::to_string(sop_classes.size()) + " needed, " +
+                         std::to_string(kMaxStorageContexts) + " allowed per association" };
+    }
+
+    // dcmnet logs every DIMSE message at INFO level
+    DCM_dcmnetLogger.setLogLevel(OFLogger::WARN_LOG_LEVEL);
+
+    Scu scu(ingest_, stats, start);
+    scu.setAETitle(peer.calling_ae_title.c_str());
+    scu.setPeerHostName(peer.host.c_str());
+    scu.setPeerPort(peer.port);
+    scu.setPeerAETitle(peer.called_ae_title.c_str());
+    scu.setMaxReceivePDULength(ASC_MAXIMUMPDUSIZE);
+
+    OFList<OFString> query_syntaxes;
+    query_syntaxes.push_back(UID_LittleEndianExplicitTransferSyntax);
+    query_syntaxes.push_back(UID_LittleEndianImplicitTransferSyntax);
+    scu.addPresentationContext(UID_GETStudyRootQueryRetrieveInformationModel, query_syntaxes);
+
+    // We are the storage SCP on this association
+    OFList<OFString> storage_syntaxes;
+    for (const std::string& uid : InstanceIngest::accepted_transfer_syntaxes()) {
+        storage_syntaxes.push_back(uid.c_str());
+    }
+    for (const std::string& sop_class : sop_classes) {
+        scu.addPresentationContext(sop_class.c_str(), storage_syntaxes, ASC_SC_ROLE_SCP);
+    }
+
+    OFCondition cond = scu.initNetwork();
+    if (cond.good()) {
+        cond = scu.negotiateAssociation();
+    }
+    if (cond.bad()) {
+        return ErrorInfo{ DicomError::NetworkError,
+                         "Cannot open association with " + peer.called_ae_title + " at " + peer.host + ":" +
+                             std::to_string(peer.port),
+                         cond.text() };
+    }
+    const T_ASC_PresentationContextID context =
+        scu.findPresentationContextID(UID_GETStudyRootQueryRetrieveInformationModel, "");
+    if (context == 0) {
+        scu.releaseAssociation();
+        return ErrorInfo{ DicomError::NetworkError, "Peer does not support Study Root C-GET",
+                         peer.called_ae_title };
+    }
+
+    std::vector<bool> pending(instances.size(), true);
+    size_t remaining = instances.size();
+    while (remaining > 0 && !cancelled_) {
+        const std::vector<size_t> batch = pick_batch(pending, focus_, batch_size_);
+
+        // List of UID matching on the SOP Instance UID
+        std::string uid_list;
+        for (size_t index : batch) {
+            if (!uid_list.empty()) {
+                uid_list += '\\';
+            }
+            uid_list += instances[index].sop_instance_uid;
+        }
+        DcmDataset keys;
+        keys.putAndInsertString(DCM_QueryRetrieveLevel, "IMAGE");
+        keys.putAndInsertString(DCM_StudyInstanceUID, study_instance_uid.c_str());
+        keys.putAndInsertString(DCM_SeriesInstanceUID, series_instance_uid.c_str());
+        keys.putAndInsertString(DCM_SOPInstanceUID, uid_list.c_str());
+
+        cond = scu.sendCGETRequest(context, &keys, nullptr);
+        ++stats.requests;
+
+        for (size_t index : batch) {
+            pending[index] = false;
+            if (!scu.received(instances[index].sop_instance_uid)) {
+                ++stats.failed;
+            }
+        }
+        remaining -= batch.size();
+
+        if (cond.bad() && !scu.isConnected()) {
+            std::cout << "[DEBUG] C-GET association lost: " << cond.text() << std::endl;
+            stats.failed += static_cast<uint32_t>(remaining);
+            remaining = 0;
+        }
+    }
+    stats.cancelled = remaining > 0;
+
+    if (scu.isConnected()) {
+        scu.releaseAssociation();
+    }
+    stats.total_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    std::cout << "[DEBUG] C-GET retrieved " << stats.received << "/" << stats.requested << " instances in "
+        << stats.requests << " requests, " << stats.total_ms << " ms" << std::endl;
+    return stats;
+}
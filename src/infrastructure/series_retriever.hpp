@@ -0,0 +1,58 @@
+#pragma once
+
+#include "core/error_codes.hpp"
+#include "core/result.hpp"
+#include "dicom_peer.hpp"
+#include "instance_ingest.hpp"
+#include "query_scu.hpp"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct RetrieveStats {
+    uint32_t requested = 0;
+    uint32_t received = 0;           // instances stored and indexed
+    uint32_t failed = 0;             // requested but not delivered
+    uint32_t requests = 0;           // C-GET requests sent
+    uint64_t bytes = 0;
+    double first_instance_ms = -1.0; // first instance indexed (its decode is queued right then)
+    double total_ms = 0.0;
+    bool cancelled = false;
+};
+
+// Streams a series in with C-GET over one association. Every instance is
+// handed to the ingest as it arrives, so it is displayable while the rest is
+// still on the wire. Instances are requested a batch at a time, each batch
+// the pending ones nearest the focus, so scrolling pulls the slices around
+// the current position forward. Use one retriever per retrieval.
+class SeriesRetriever {
+public:
+    explicit SeriesRetriever(InstanceIngest& ingest) : ingest_(ingest) {}
+
+    SeriesRetriever(const SeriesRetriever&) = delete;
+    SeriesRetriever& operator=(const SeriesRetriever&) = delete;
+
+    // Instances per C-GET request. Smaller batches follow the focus more
+    // closely at the cost of a round trip each. Set before retrieve().
+    void set_batch_size(uint32_t batch_size) { batch_size_ = batch_size == 0 ? 1 : batch_size; }
+
+    // Index into the instance list to retrieve around next; any thread
+    void set_focus(size_t index) { focus_ = index; }
+
+    // Stops after the batch in flight; any thread
+    void cancel() { cancelled_ = true; }
+
+    // Blocks until every instance was requested once. instances is the
+    // display order, as returned by find_instances().
+    Result<RetrieveStats, ErrorInfo> retrieve(const DicomPeer& peer, const std::string& study_instance_uid,
+        const std::string& series_instance_uid, const std::vector<InstanceMatch>& instances);
+
+private:
+    class Scu;
+
+    InstanceIngest& ingest_;
+    uint32_t batch_size_ = 8;
+    std::atomic<size_t> focus_{ 0 };
+    std::atomic<bool> cancelled_{ false };
+};
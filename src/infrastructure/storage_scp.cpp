@@ -0,0 +1,253 @@
+#include "storage_scp.hpp"
+
+// DCMTK includes
+#include <dcmtk/dcmdata/dctk.h>
+#include <dcmtk/dcmnet/diutil.h>
+#include <dcmtk/dcmnet/scppool.h>
+#include <dcmtk/dcmnet/scpthrd.h>
+
+#include <atomic>
+#include <future>
+#include <iostream>
+#include <thread>
+
+class StorageServer::Impl {
+public:
+    class Pool;
+    class Worker;
+
+    InstanceIngest ingest_;
+    StorageServerConfig config_;
+
+    std::unique_ptr<Pool> scp_pool_;
+    std::thread listener_;
+    std::atomic<bool> running_{ false };
+
+    std::atomic<uint64_t> associations_{ 0 };
+
+    Impl(IDicomReader& reader, StudyIndex& index, ImageCache& cache, ThreadPool& pool)
+        : ingest_(reader, index, cache, pool) {
+    }
+
+    Result<bool, ErrorInfo> start(const StorageServerConfig& config);
+    void stop();
+
+    // Runs on the association's worker thread; the returned status is sent to the sender
+    Uint16 store(std::shared_ptr<DcmFileFormat> file_format);
+};
+
+// Listener that hands each association to a Worker. DcmSCPPool cannot be
+// used directly: it default-constructs its workers, and ours need the server.
+class StorageServer::Impl::Pool : public DcmBaseSCPPool {
+public:
+    explicit Pool(Impl& server) : server_(server) {}
+
+    std::future<OFCondition> bound() { return bound_.get_future(); }
+
+protected:
+    DcmBaseSCPWorker* createSCPWorker() override;
+
+    // Reports whether the port could be bound back to start()
+    OFCondition initializeNetwork(T_ASC_Network** network) override {
+        OFCondition cond = DcmBaseSCPPool::initializeNetwork(network);
+        bound_.set_value(cond);
+        return cond;
+    }
+
+private:
+    Impl& server_;
+    std::promise<OFCondition> bound_;
+};
+
+class StorageServer::Impl::Worker : public DcmBaseSCPPool::DcmBaseSCPWorker, private DcmThreadSCP {
+public:
+    Worker(Pool& pool, Impl& server) : DcmBaseSCPWorker(pool), server_(server) {}
+
+    OFCondition setSharedConfig(const DcmSharedSCPConfig& config) override {
+        return DcmThreadSCP::setSharedConfig(config);
+    }
+
+    OFBool busy() override {
+        return DcmThreadSCP::isConnected();
+    }
+
+    // The base class runs a reused worker on the calling (listener) thread,
+    // which would serialize associations; give it a thread of its own again
+    void rerun() override {
+        join();
+        if (start() != 0) {
+            DcmBaseSCPWorker::rerun();
+        }
+    }
+
+protected:
+    OFCondition workerListen(T_ASC_Association* const assoc) override {
+        OFCondition result = DcmThreadSCP::run(assoc);
+        DcmThreadSCP::dropAndDestroyAssociation();
+        return result;
+    }
+
+    void notifyAssociationAcknowledge() override {
+        ++server_.associations_;
+    }
+
+    OFCondition handleIncomingCommand(T_DIMSE_Message* message,
+        const DcmPresentationContextInfo& presentation) override {
+        if (message->CommandField == DIMSE_C_ECHO_RQ) {
+            return handleECHORequest(message->msg.CEchoRQ, presentation.presentationContextID);
+        }
+        if (message->CommandField != DIMSE_C_STORE_RQ) {
+            return DcmThreadSCP::handleIncomingCommand(message, presentation);
+        }
+
+        T_DIMSE_C_StoreRQ& request = message->msg.CStoreRQ;
+        auto file_format = std::make_shared<DcmFileFormat>();
+        DcmDataset* dataset = file_format->getDataset();
+        OFCondition status = receiveSTORERequest(request, presentation.presentationContextID, dataset);
+        if (status.bad()) {
+            server_.ingest_.count_failure();
+            if (status == DIMSE_OUTOFRESOURCES) {
+                sendSTOREResponse(presentation.presentationContextID, request,
+                    STATUS_STORE_Refused_OutOfResources);
+            }
+            return status;
+        }
+
+        const Uint16 response = server_.store(std::move(file_format));
+        return sendSTOREResponse(presentation.presentationContextID, request, response);
+    }
+
+private:
+    Impl& server_;
+};
+
+DcmBaseSCPPool::DcmBaseSCPWorker* StorageServer::Impl::Pool::createSCPWorker() {
+    return new Worker(*this, server_);
+}
+
+Result<bool, ErrorInfo> StorageServer::Impl::start(const StorageServerConfig& config) {
+    if (running_) {
+        return ErrorInfo{ DicomError::NetworkError, "Storage server is already running", "" };
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(config.storage_directory, ec);
+    if (ec) {
+        return ErrorInfo{ DicomError::FileNotFound, "Cannot create storage directory",
+                         config.storage_directory.string() + ": " + ec.message() };
+    }
+
+    config_ = config;
+    ingest_.configure(IngestConfig{ config.storage_directory, config.max_pending_decodes });
+    ingest_.reset_stats();
+    associations_ = 0;
+
+    // dcmnet logs every DIMSE message at INFO level
+    DCM_dcmnetLogger.setLogLevel(OFLogger::WARN_LOG_LEVEL);
+
+    scp_pool_ = std::make_unique<Pool>(*this);
+    scp_pool_->setMaxThreads(std::max<uint16_t>(config.max_associations, 1));
+
+    DcmSCPConfig& scp_config = scp_pool_->getConfig();
+    scp_config.setPort(config.port);
+    scp_config.setAETitle(config.ae_title.c_str());
+    scp_config.setMaxReceivePDULength(ASC_MAXIMUMPDUSIZE);
+    scp_config.setHostLookupEnabled(OFFalse);
+    // Poll for new associations so that stop() is noticed within a second
+    scp_config.setConnectionBlockingMode(DUL_NOBLOCK);
+    scp_config.setConnectionTimeout(1);
+
+    OFList<OFString> transfer_syntaxes;
+    for (const std::string& uid : InstanceIngest::accepted_transfer_syntaxes()) {
+        transfer_syntaxes.push_back(uid.c_str());
+    }
+    for (int i = 0; i < numberOfDcmAllStorageSOPClassUIDs; ++i) {
+        scp_config.addPresentationContext(dcmAllStorageSOPClassUIDs[i], transfer_syntaxes);
+    }
+    OFList<OFString> verification_syntaxes;
+    verification_syntaxes.push_back(UID_LittleEndianExplicitTransferSyntax);
+    verification_syntaxes.push_back(UID_LittleEndianImplicitTransferSyntax);
+    scp_config.addPresentationContext(UID_VerificationSOPClass, verification_syntaxes);
+
+    std::future<OFCondition> bound = scp_pool_->bound();
+    listener_ = std::thread([this]() { scp_pool_->listen(); });
+
+    const OFCondition cond = bound.get();
+    if (cond.bad()) {
+        listener_.join();
+        scp_pool_.reset();
+        return ErrorInfo{ DicomError::NetworkError,
+                         "Cannot listen on port " + std::to_string(config.port), cond.text() };
+    }
+
+    running_ = true;
+    std::cout << "[DEBUG] Storage SCP " << config.ae_title << " listening on port " << config.port
+        << " (" << config.max_associations << " associations)" << std::endl;
+    return true;
+}
+
+void StorageServer::Impl::stop() {
+    if (!running_) {
+        return;
+    }
+    scp_pool_->stopAfterCurrentAssociations();
+    listener_.join();
+    // Waits for open associations, then joins the idle workers
+    scp_pool_.reset();
+    ingest_.wait_idle();
+    running_ = false;
+
+    std::cout << "[DEBUG] Storage SCP stopped" << std::endl;
+}
+
+Uint16 StorageServer::Impl::store(std::shared_ptr<DcmFileFormat> file_format) {
+    auto result = ingest_.ingest(std::move(file_format));
+    if (result.is_ok()) {
+        return STATUS_Success;
+    }
+    std::cout << "[DEBUG] Storage SCP refused an instance: " << result.error().full_message() << std::endl;
+    return result.error().code == DicomError::InvalidMetadata
+        ? STATUS_STORE_Error_CannotUnderstand
+        : STATUS_STORE_Refused_OutOfResources;
+}
+
+StorageServer::StorageServer(IDicomReader& reader, StudyIndex& index, ImageCache& cache, ThreadPool& pool)
+    : impl_(std::make_unique<Impl>(reader, index, cache, pool)) {
+}
+
+StorageServer::~StorageServer() {
+    impl_->stop();
+}
+
+Result<bool, ErrorInfo> StorageServer::start(const StorageServerConfig& config) {
+    return impl_->start(config);
+}
+
+void StorageServer::stop() {
+    impl_->stop();
+}
+
+bool StorageServer::running() const {
+    return impl_->running_;
+}
+
+void StorageServer::set_instance_handler(InstanceHandler handler) {
+    impl_->ingest_.set_handler(std::move(handler));
+}
+
+StorageServerStats StorageServer::stats() const {
+    const IngestStats ingest = impl_->ingest_.stats();
+    StorageServerStats stats;
+    stats.associations = impl_->associations_;
+    stats.instances_received = ingest.instances_received;
+    stats.instances_failed = ingest.instances_failed;
+    stats.bytes_received = ingest.bytes_received;
+    stats.instances_decoded = ingest.instances_decoded;
+    stats.decodes_skipped = ingest.decodes_skipped;
+    stats.pending_decodes = ingest.pending_decodes;
+    return stats;
+}
+
+void StorageServer::wait_idle() {
+    impl_->ingest_.wait_idle();
+}
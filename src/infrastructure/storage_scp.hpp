@@ -0,0 +1,69 @@
+#pragma once
+
+#include "core/error_codes.hpp"
+#include "core/image_cache.hpp"
+#include "core/result.hpp"
+#include "core/study_index.hpp"
+#include "core/thread_pool.hpp"
+#include "dcmtk_wrapper.hpp"
+#include "instance_ingest.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+
+struct StorageServerConfig {
+    uint16_t port = 11112;
+    std::string ae_title = "DICOMVIEWER";
+    uint16_t max_associations = 8;            // concurrent senders, one worker thread each
+    std::filesystem::path storage_directory;  // received files go to <dir>/<Study UID>/<SOP UID>.dcm
+    uint32_t max_pending_decodes = 64;        // beyond this, instances are only indexed
+};
+
+struct StorageServerStats {
+    uint64_t associations = 0;
+    uint64_t instances_received = 0;
+    uint64_t instances_failed = 0;
+    uint64_t bytes_received = 0;      // size of the stored files
+    uint64_t instances_decoded = 0;
+    uint64_t decodes_skipped = 0;     // not decoded because the decode queue was full
+    uint32_t pending_decodes = 0;
+};
+
+// Embedded C-STORE SCP (plus C-ECHO). Each association runs on its own
+// worker thread. Received datasets go through an InstanceIngest: written to
+// disk and indexed before the store is acknowledged, then decoded in the
+// background from memory into the image cache. Also the destination of C-MOVE.
+class StorageServer {
+    class Impl;
+    std::unique_ptr<Impl> impl_;
+
+public:
+    // Called on a receiving thread once an instance is indexed, and again
+    // (with decoded set) once its pixels are in the cache
+    using InstanceHandler = InstanceIngest::InstanceHandler;
+
+    StorageServer(IDicomReader& reader, StudyIndex& index, ImageCache& cache,
+        ThreadPool& pool = ThreadPool::shared());
+    ~StorageServer();
+
+    StorageServer(const StorageServer&) = delete;
+    StorageServer& operator=(const StorageServer&) = delete;
+
+    // Binds the port and starts accepting associations
+    Result<bool, ErrorInfo> start(const StorageServerConfig& config);
+
+    // Stops listening and waits for open associations and pending decodes
+    void stop();
+
+    bool running() const;
+
+    // Set before start()
+    void set_instance_handler(InstanceHandler handler);
+
+    StorageServerStats stats() const;
+
+    // Blocks until no decode is pending
+    void wait_idle();
+};
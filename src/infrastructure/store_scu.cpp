@@ -0,0 +1,130 @@
+#include "store_scu.hpp"
+
+// DCMTK includes
+#include <dcmtk/dcmdata/dctk.h>
+#include <dcmtk/dcmnet/diutil.h>
+#include <dcmtk/dcmnet/scu.h>
+
+#include <iostream>
+#include <set>
+#include <utility>
+
+namespace {
+
+// Presentation contexts an association may propose
+constexpr size_t kMaxPresentationContexts = 128;
+
+struct FileSyntax {
+    std::string sop_class_uid;
+    std::string transfer_syntax_uid;
+};
+
+// SOP class and transfer syntax from the file meta information only
+bool read_file_syntax(const std::filesystem::path& path, FileSyntax& syntax) {
+    DcmFileFormat file_format;
+    if (file_format.loadFile(path.string().c_str(), EXS_Unknown, EGL_noChange,
+        DCM_MaxReadLength, ERM_metaOnly).bad()) {
+        return false;
+    }
+    OFString sop_class, transfer_syntax;
+    DcmMetaInfo* meta = file_format.getMetaInfo();
+    meta->findAndGetOFString(DCM_MediaStorageSOPClassUID, sop_class);
+    meta->findAndGetOFString(DCM_TransferSyntaxUID, transfer_syntax);
+    if (sop_class.empty() || transfer_syntax.empty()) {
+        return false;
+    }
+    syntax.sop_class_uid = sop_class.c_str();
+    syntax.transfer_syntax_uid = transfer_syntax.c_str();
+    return true;
+}
+
+} // namespace
+
+Result<StoreSendStats, ErrorInfo>
+send_files(const DicomPeer& peer, const std::vector<std::filesystem::path>& files) {
+    StoreSendStats stats;
+
+    std::vector<FileSyntax> syntaxes(files.size());
+    std::vector<bool> readable(files.size(), false);
+    std::set<std::pair<std::string, std::string>> contexts;
+    for (size_t i = 0; i < files.size(); ++i) {
+        readable[i] = read_file_syntax(files[i], syntaxes[i]);
+        if (readable[i]) {
+            contexts.emplace(syntaxes[i].sop_class_uid, syntaxes[i].transfer_syntax_uid);
+        }
+        else {
+            ++stats.failed;
+        }
+    }
+    if (contexts.empty()) {
+        return stats;
+    }
+    if (contexts.size() > kMaxPresentationContexts) {
+        return ErrorInfo{ DicomError::NetworkError, "Too many SOP class and transfer syntax combinations",
+                         std::to_string(contexts.size()) + " needed, " +
+                         std::to_string(kMaxPresentationContexts) + " allowed per association" };
+    }
+
+    // dcmnet logs every DIMSE message at INFO level
+    DCM_dcmnetLogger.setLogLevel(OFLogger::WARN_LOG_LEVEL);
+
+    DcmSCU scu;
+    scu.setAETitle(peer.calling_ae_title.c_str());
+    scu.setPeerHostName(peer.host.c_str());
+    scu.setPeerPort(peer.port);
+    scu.setPeerAETitle(peer.called_ae_title.c_str());
+    scu.setMaxReceivePDULength(ASC_MAXIMUMPDUSIZE);
+
+    for (const auto& [sop_class, transfer_syntax] : contexts) {
+        OFList<OFString> transfer_syntaxes;
+        transfer_syntaxes.push_back(transfer_syntax.c_str());
+        scu.addPresentationContext(sop_class.c_str(), transfer_syntaxes);
+    }
+
+    OFCondition cond = scu.initNetwork();
+    if (cond.good()) {
+        cond = scu.negotiateAssociation();
+    }
+    if (cond.bad()) {
+        return ErrorInfo{ DicomError::NetworkError,
+                         "Cannot open association with " + peer.host + ":" + std::to_string(peer.port),
+                         cond.text() };
+    }
+
+    bool connected = true;
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (!readable[i]) {
+            continue;
+        }
+        if (!connected) {
+            ++stats.failed;
+            continue;
+        }
+        const T_ASC_PresentationContextID context = scu.findPresentationContextID(
+            syntaxes[i].sop_class_uid.c_str(), syntaxes[i].transfer_syntax_uid.c_str());
+        if (context == 0) {
+            ++stats.failed;
+            continue;
+        }
+
+        Uint16 status = 0;
+        cond = scu.sendSTORERequest(context, files[i].string().c_str(), nullptr, status);
+        if (cond.good() && (status == STATUS_Success || DICOM_WARNING_STATUS(status))) {
+            ++stats.sent;
+            std::error_code ec;
+            stats.bytes += std::filesystem::file_size(files[i], ec);
+        }
+        else {
+            ++stats.failed;
+            if (cond.bad() && !scu.isConnected()) {
+                std::cout << "[DEBUG] C-STORE association lost: " << cond.text() << std::endl;
+                connected = false;
+            }
+        }
+    }
+
+    if (connected) {
+        scu.releaseAssociation();
+    }
+    return stats;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "core/error_codes.hpp"
+#include "core/result.hpp"
+#include "dicom_peer.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+struct StoreSendStats {
+    uint32_t sent = 0;          // acknowledged with Success (or a warning)
+    uint32_t failed = 0;
+    uint64_t bytes = 0;         // size of the files sent
+};
+
+// Sends files to a C-STORE SCP over one association, like storescu: one
+// presentation context per SOP class and transfer syntax found in the files,
+// which are sent as stored. Fails only if no association could be set up.
+Result<StoreSendStats, ErrorInfo>
+    send_files(const DicomPeer& peer, const std::vector<std::filesystem::path>& files);
@@ -0,0 +1,738 @@
+#include "study_anonymizer.hpp"
+
+// DCMTK includes
+#include <dcmtk/dcmdata/dctk.h>
+#include <dcmtk/dcmdata/dcfcache.h>
+#include <dcmtk/dcmdata/dcostrmf.h>
+#include <dcmtk/dcmdata/dcpixseq.h>
+#include <dcmtk/dcmdata/dcpxitem.h>
+#include <dcmtk/dcmdata/dcwcache.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Files being worked on per worker: enough to keep reads and writes overlapping
+constexpr size_t kQueuedFilesPerWorker = 2;
+
+// Block size of the pixel data comparison
+constexpr Uint32 kCompareBlockBytes = 1024 * 1024;
+
+// The table covers the attributes of PS3.15 Table E.1-1 that we meet in
+// practice, not all of them, so the output does not claim the Basic profile
+const char* const kBasicProfileName = "Header rules after DICOM PS3.15 Annex E; pixel data unchanged";
+
+TagRule rule(const DcmTagKey& tag, TagAction action) {
+    return TagRule{ tag.getGroup(), tag.getElement(), 0xFFFF, action, {} };
+}
+
+TagRule group_rule(uint16_t group, uint16_t element, TagAction action) {
+    return TagRule{ group, element, 0xFF00, action, {} };
+}
+
+uint32_t tag_key(uint16_t group, uint16_t element) {
+    return (static_cast<uint32_t>(group) << 16) | element;
+}
+
+// Value of the D action for string VRs
+const char* dummy_value(DcmEVR vr) {
+    switch (vr) {
+        case EVR_DA: return "19000101";
+        case EVR_TM: return "000000";
+        case EVR_DT: return "19000101000000";
+        case EVR_PN: return "ANONYMOUS";
+        case EVR_AS: return "000Y";
+        case EVR_IS:
+        case EVR_DS: return "0";
+        default: return "ANONYMIZED";
+    }
+}
+
+std::string dataset_string(DcmItem* item, const DcmTagKey& tag) {
+    OFString value;
+    item->findAndGetOFString(tag, value);
+    return value.c_str();
+}
+
+std::string trim(const std::string& text) {
+    const size_t first = text.find_first_not_of(" \t\r");
+    if (first == std::string::npos) {
+        return {};
+    }
+    return text.substr(first, text.find_last_not_of(" \t\r") - first + 1);
+}
+
+DcmElement* find_pixel_data(DcmDataset* dataset) {
+    DcmElement* element = nullptr;
+    if (dataset->findAndGetElement(DCM_PixelData, element).bad() || !element ||
+        element->ident() != EVR_PixelData) {
+        return nullptr;
+    }
+    return element;
+}
+
+// Compares two not yet loaded values block by block
+bool same_value(DcmElement* first, DcmFileCache& first_cache, DcmElement* second, DcmFileCache& second_cache,
+    std::vector<char>& first_block, std::vector<char>& second_block) {
+    const Uint32 length = first->getLength();
+    if (length != second->getLength()) {
+        return false;
+    }
+    for (Uint32 offset = 0; offset < length; offset += kCompareBlockBytes) {
+        const Uint32 size = std::min(kCompareBlockBytes, length - offset);
+        if (first->getPartialValue(first_block.data(), offset, size, &first_cache).bad() ||
+            second->getPartialValue(second_block.data(), offset, size, &second_cache).bad() ||
+            std::memcmp(first_block.data(), second_block.data(), size) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+DcmPixelSequence* encapsulated_sequence(DcmDataset* dataset, DcmElement* element) {
+    if (!DcmXfer(dataset->getOriginalXfer()).usesEncapsulatedFormat()) {
+        return nullptr;
+    }
+    auto* pixel_data = static_cast<DcmPixelData*>(element);
+    E_TransferSyntax xfer = EXS_Unknown;
+    const DcmRepresentationParameter* param = nullptr;
+    pixel_data->getOriginalRepresentationKey(xfer, param);
+    DcmPixelSequence* sequence = nullptr;
+    pixel_data->getEncapsulatedRepresentation(xfer, param, sequence);
+    return sequence;
+}
+
+} // namespace
+
+AnonymizationProfile AnonymizationProfile::basic() {
+    using A = TagAction;
+    AnonymizationProfile profile;
+    profile.name = kBasicProfileName;
+    profile.rules = {
+        // Identifying UIDs; the same replacement wherever they occur
+        rule(DCM_StudyInstanceUID, A::ReplaceUid),
+        rule(DCM_SeriesInstanceUID, A::ReplaceUid),
+        rule(DCM_SOPInstanceUID, A::ReplaceUid),
+        rule(DCM_FrameOfReferenceUID, A::ReplaceUid),
+        rule(DCM_SynchronizationFrameOfReferenceUID, A::ReplaceUid),
+        rule(DCM_ReferencedSOPInstanceUID, A::ReplaceUid),
+        rule(DCM_ReferencedFrameOfReferenceUID, A::ReplaceUid),
+        rule(DCM_RETIRED_RelatedFrameOfReferenceUID, A::ReplaceUid),
+        rule(DCM_ConcatenationUID, A::ReplaceUid),
+        rule(DCM_DimensionOrganizationUID, A::ReplaceUid),
+        rule(DCM_IrradiationEventUID, A::ReplaceUid),
+        rule(DCM_StorageMediaFileSetUID, A::ReplaceUid),
+        rule(DCM_TransactionUID, A::ReplaceUid),
+        rule(DCM_DeviceUID, A::ReplaceUid),
+        rule(DCM_FiducialUID, A::ReplaceUid),
+        rule(DCM_UID, A::ReplaceUid),
+        rule(DCM_InstanceCreatorUID, A::Remove),
+
+        // Patient
+        rule(DCM_PatientName, A::Empty),
+        rule(DCM_PatientID, A::Empty),
+        rule(DCM_PatientBirthDate, A::Empty),
+        rule(DCM_PatientSex, A::Empty),
+        rule(DCM_PatientBirthTime, A::Remove),
+        rule(DCM_PatientAge, A::Remove),
+        rule(DCM_PatientSize, A::Remove),
+        rule(DCM_PatientWeight, A::Remove),
+        rule(DCM_PatientAddress, A::Remove),
+        rule(DCM_PatientTelephoneNumbers, A::Remove),
+        rule(DCM_PatientBirthName, A::Remove),
+        rule(DCM_PatientMotherBirthName, A::Remove),
+        rule(DCM_RETIRED_OtherPatientIDs, A::Remove),
+        rule(DCM_OtherPatientNames, A::Remove),
+        rule(DCM_OtherPatientIDsSequence, A::Remove),
+        rule(DCM_IssuerOfPatientID, A::Remove),
+        rule(DCM_PatientInsurancePlanCodeSequence, A::Remove),
+        rule(DCM_RETIRED_MedicalRecordLocator, A::Remove),
+        rule(DCM_MilitaryRank, A::Remove),
+        rule(DCM_BranchOfService, A::Remove),
+        rule(DCM_CountryOfResidence, A::Remove),
+        rule(DCM_RegionOfResidence, A::Remove),
+        rule(DCM_RETIRED_EthnicGroup, A::Remove),
+        rule(DCM_Occupation, A::Remove),
+        rule(DCM_MedicalAlerts, A::Remove),
+        rule(DCM_Allergies, A::Remove),
+        rule(DCM_SmokingStatus, A::Remove),
+        rule(DCM_PregnancyStatus, A::Remove),
+        rule(DCM_LastMenstrualDate, A::Remove),
+        rule(DCM_AdditionalPatientHistory, A::Remove),
+        rule(DCM_PatientReligiousPreference, A::Remove),
+        rule(DCM_PatientComments, A::Remove),
+        rule(DCM_ReferencedPatientSequence, A::Remove),
+        rule(DCM_RETIRED_ReferencedPatientAliasSequence, A::Remove),
+        rule(DCM_ReferencedPatientPhotoSequence, A::Remove),
+        rule(DCM_IssuerOfPatientIDQualifiersSequence, A::Remove),
+        rule(DCM_PatientSexNeutered, A::Remove),
+        rule(DCM_PatientState, A::Remove),
+        rule(DCM_SpecialNeeds, A::Remove),
+        rule(DCM_PatientTelecomInformation, A::Remove),
+        rule(DCM_PatientPrimaryLanguageCodeSequence, A::Remove),
+        rule(DCM_PatientBirthDateInAlternativeCalendar, A::Remove),
+        rule(DCM_PatientDeathDateInAlternativeCalendar, A::Remove),
+        rule(DCM_RETIRED_InsurancePlanIdentification, A::Remove),
+        rule(DCM_ResponsiblePerson, A::Remove),
+        rule(DCM_ResponsibleOrganization, A::Remove),
+        rule(DCM_AdmissionID, A::Remove),
+        rule(DCM_RETIRED_IssuerOfAdmissionID, A::Remove),
+        rule(DCM_IssuerOfAdmissionIDSequence, A::Remove),
+        rule(DCM_AdmittingDate, A::Remove),
+        rule(DCM_AdmittingTime, A::Remove),
+        rule(DCM_AdmittingDiagnosesCodeSequence, A::Remove),
+        rule(DCM_ServiceEpisodeID, A::Remove),
+        rule(DCM_ServiceEpisodeDescription, A::Remove),
+        rule(DCM_CurrentPatientLocation, A::Remove),
+        rule(DCM_PatientInstitutionResidence, A::Remove),
+        rule(DCM_RETIRED_ScheduledPatientInstitutionResidence, A::Remove),
+        rule(DCM_PatientTransportArrangements, A::Remove),
+
+        // Study, series and procedure
+        rule(DCM_StudyDate, A::Empty),
+        rule(DCM_StudyTime, A::Empty),
+        rule(DCM_AccessionNumber, A::Empty),
+        rule(DCM_StudyID, A::Empty),
+        rule(DCM_ReferringPhysicianName, A::Empty),
+        rule(DCM_ContentDate, A::Empty),
+        rule(DCM_ContentTime, A::Empty),
+        rule(DCM_PlacerOrderNumberImagingServiceRequest, A::Empty),
+        rule(DCM_FillerOrderNumberImagingServiceRequest, A::Empty),
+        rule(DCM_ContentCreatorName, A::Empty),
+        rule(DCM_SeriesDate, A::Remove),
+        rule(DCM_SeriesTime, A::Remove),
+        rule(DCM_AcquisitionDate, A::Remove),
+        rule(DCM_AcquisitionTime, A::Remove),
+        rule(DCM_AcquisitionDateTime, A::Remove),
+        rule(DCM_InstanceCreationDate, A::Remove),
+        rule(DCM_InstanceCreationTime, A::Remove),
+        rule(DCM_InstanceCoercionDateTime, A::Remove),
+        rule(DCM_TimezoneOffsetFromUTC, A::Remove),
+        rule(DCM_DateOfSecondaryCapture, A::Remove),
+        rule(DCM_TimeOfSecondaryCapture, A::Remove),
+        rule(DCM_DateOfLastCalibration, A::Remove),
+        rule(DCM_TimeOfLastCalibration, A::Remove),
+        rule(DCM_RETIRED_OverlayDate, A::Remove),
+        rule(DCM_RETIRED_OverlayTime, A::Remove),
+        rule(DCM_StudyDescription, A::Remove),
+        rule(DCM_SeriesDescription, A::Remove),
+        rule(DCM_ProtocolName, A::Remove),
+        rule(DCM_ImageComments, A::Remove),
+        rule(DCM_FrameComments, A::Remove),
+        rule(DCM_RETIRED_ImagePresentationComments, A::Remove),
+        rule(DCM_RETIRED_StudyComments, A::Remove),
+        rule(DCM_RETIRED_ReasonForStudy, A::Remove),
+        rule(DCM_RequestingService, A::Remove),
+        rule(DCM_RequestedProcedureLocation, A::Remove),
+        rule(DCM_RequestedProcedureComments, A::Remove),
+        rule(DCM_ReasonForTheRequestedProcedure, A::Remove),
+        rule(DCM_ImagingServiceRequestComments, A::Remove),
+        rule(DCM_OrderEnteredBy, A::Remove),
+        rule(DCM_OrderEntererLocation, A::Remove),
+        rule(DCM_OrderCallbackPhoneNumber, A::Remove),
+        rule(DCM_DerivationDescription, A::Remove),
+        rule(DCM_AdmittingDiagnosesDescription, A::Remove),
+        rule(DCM_ReferencedStudySequence, A::Remove),
+        rule(DCM_RequestAttributesSequence, A::Remove),
+        rule(DCM_RequestedProcedureDescription, A::Remove),
+        rule(DCM_RequestedProcedureID, A::Remove),
+        rule(DCM_ScheduledProcedureStepID, A::Remove),
+        rule(DCM_ScheduledProcedureStepDescription, A::Remove),
+        rule(DCM_ScheduledProcedureStepStartDate, A::Remove),
+        rule(DCM_ScheduledProcedureStepStartTime, A::Remove),
+        rule(DCM_ScheduledProcedureStepEndDate, A::Remove),
+        rule(DCM_ScheduledProcedureStepEndTime, A::Remove),
+        rule(DCM_ScheduledProcedureStepLocation, A::Remove),
+        rule(DCM_ScheduledStationName, A::Remove),
+        rule(DCM_ScheduledStationAETitle, A::Remove),
+        rule(DCM_ScheduledPerformingPhysicianName, A::Remove),
+        rule(DCM_ScheduledHumanPerformersSequence, A::Remove),
+        rule(DCM_PerformedProcedureStepID, A::Remove),
+        rule(DCM_PerformedProcedureStepStartDate, A::Remove),
+        rule(DCM_PerformedProcedureStepStartTime, A::Remove),
+        rule(DCM_PerformedProcedureStepEndDate, A::Remove),
+        rule(DCM_PerformedProcedureStepEndTime, A::Remove),
+        rule(DCM_PerformedProcedureStepDescription, A::Remove),
+        rule(DCM_CommentsOnThePerformedProcedureStep, A::Remove),
+        rule(DCM_PerformedStationName, A::Remove),
+        rule(DCM_PerformedStationAETitle, A::Remove),
+        rule(DCM_PerformedLocation, A::Remove),
+        rule(DCM_ReferencedPerformedProcedureStepSequence, A::Remove),
+        rule(DCM_ActualHumanPerformersSequence, A::Remove),
+        rule(DCM_HumanPerformerName, A::Remove),
+        rule(DCM_HumanPerformerOrganization, A::Remove),
+        rule(DCM_AcquisitionContextSequence, A::Remove),
+        rule(DCM_OriginalAttributesSequence, A::Remove),
+        rule(DCM_ContentSequence, A::Remove),
+        rule(DCM_TextValue, A::Remove),
+        rule(DCM_DateTime, A::Remove),
+        rule(DCM_Date, A::Remove),
+        rule(DCM_Time, A::Remove),
+        rule(DCM_PersonName, A::Remove),
+        rule(DCM_VerifyingObserverName, A::Remove),
+        rule(DCM_VerifyingObserverSequence, A::Remove),
+        rule(DCM_VerifyingObserverIdentificationCodeSequence, A::Remove),
+        rule(DCM_ContentCreatorIdentificationCodeSequence, A::Remove),
+        rule(DCM_AuthorObserverSequence, A::Remove),
+        rule(DCM_ParticipantSequence, A::Remove),
+        rule(DCM_CustodialOrganizationSequence, A::Remove),
+        rule(DCM_ModifiedAttributesSequence, A::Remove),
+        rule(DCM_IconImageSequence, A::Remove),
+
+        // People, places and equipment
+        rule(DCM_InstitutionName, A::Remove),
+        rule(DCM_InstitutionAddress, A::Remove),
+        rule(DCM_InstitutionCodeSequence, A::Remove),
+        rule(DCM_InstitutionalDepartmentName, A::Remove),
+        rule(DCM_ReferringPhysicianAddress, A::Remove),
+        rule(DCM_ReferringPhysicianTelephoneNumbers, A::Remove),
+        rule(DCM_ReferringPhysicianIdentificationSequence, A::Remove),
+        rule(DCM_ConsultingPhysicianName, A::Remove),
+        rule(DCM_ConsultingPhysicianIdentificationSequence, A::Remove),
+        rule(DCM_PhysiciansOfRecord, A::Remove),
+        rule(DCM_PhysiciansOfRecordIdentificationSequence, A::Remove),
+        rule(DCM_PerformingPhysicianName, A::Remove),
+        rule(DCM_PerformingPhysicianIdentificationSequence, A::Remove),
+        rule(DCM_NameOfPhysiciansReadingStudy, A::Remove),
+        rule(DCM_PhysiciansReadingStudyIdentificationSequence, A::Remove),
+        rule(DCM_RequestingPhysician, A::Remove),
+        rule(DCM_OperatorsName, A::Remove),
+        rule(DCM_OperatorIdentificationSequence, A::Remove),
+        rule(DCM_PersonAddress, A::Remove),
+        rule(DCM_PersonTelephoneNumbers, A::Remove),
+        rule(DCM_PersonIdentificationCodeSequence, A::Remove),
+        rule(DCM_RETIRED_InterpretationRecorder, A::Remove),
+        rule(DCM_RETIRED_InterpretationTranscriber, A::Remove),
+        rule(DCM_RETIRED_InterpretationAuthor, A::Remove),
+        rule(DCM_RETIRED_InterpretationApproverSequence, A::Remove),
+        rule(DCM_RETIRED_DistributionName, A::Remove),
+        rule(DCM_RETIRED_DistributionAddress, A::Remove),
+        rule(DCM_ReviewerName, A::Remove),
+        rule(DCM_StationName, A::Remove),
+        rule(DCM_StationAETitle, A::Remove),
+        rule(DCM_DeviceSerialNumber, A::Remove),
+        rule(DCM_DetectorID, A::Remove),
+        rule(DCM_PlateID, A::Remove),
+        rule(DCM_CassetteID, A::Remove),
+        rule(DCM_GantryID, A::Remove),
+        rule(DCM_AcquisitionDeviceProcessingDescription, A::Remove),
+        rule(DCM_RETIRED_AcquisitionComments, A::Remove),
+        rule(DCM_RETIRED_TextComments, A::Remove),
+        rule(DCM_RETIRED_Arbitrary, A::Remove),
+        rule(DCM_StorageMediaFileSetID, A::Remove),
+
+        // Signatures and encrypted copies would carry or vouch for the original values
+        rule(DCM_DigitalSignaturesSequence, A::Remove),
+        rule(DCM_MACParametersSequence, A::Remove),
+        rule(DCM_EncryptedAttributesSequence, A::Remove),
+        rule(DCM_DataSetTrailingPadding, A::Remove),
+
+        // Overlays and curves may carry names and dates of their own
+        group_rule(0x6000, 0x3000, A::Remove),   // Overlay Data
+        group_rule(0x6000, 0x4000, A::Remove),   // Overlay Comments
+        group_rule(0x5000, 0x3000, A::Remove),   // Curve Data
+    };
+    return profile;
+}
+
+Result<AnonymizationProfile, ErrorInfo> load_anonymization_profile(const std::filesystem::path& path) {
+    std::ifstream in(path);
+    if (!in) {
+        return ErrorInfo{ DicomError::FileNotFound, "Cannot open anonymization profile", path.string() };
+    }
+
+    AnonymizationProfile profile = AnonymizationProfile::basic();
+    profile.name = "Basic profile with options from " + path.filename().string();
+    std::string line;
+    int number = 0;
+    while (std::getline(in, line)) {
+        ++number;
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty()) {
+            continue;
+        }
+        if (line == "private keep") {
+            profile.remove_private_tags = false;
+            continue;
+        }
+        if (line == "burned-in allow") {
+            profile.reject_burned_in_annotation = false;
+            continue;
+        }
+
+        // "(gggg,eeee) A [value]"; 'x' digits in the group make a repeating group
+        const auto invalid = [&]() {
+            return ErrorInfo{ DicomError::InvalidFormat, "Invalid anonymization profile line",
+                             path.filename().string() + ":" + std::to_string(number) + ": " + line };
+        };
+        if (line.size() < 13 || line[0] != '(' || line[5] != ',' || line[10] != ')') {
+            return invalid();
+        }
+        TagRule parsed;
+        std::string group = line.substr(1, 4);
+        if (group[2] == 'x' || group[2] == 'X') {
+            group[2] = group[3] = '0';
+            parsed.group_mask = 0xFF00;
+        }
+        char* end = nullptr;
+        parsed.group = static_cast<uint16_t>(std::strtoul(group.c_str(), &end, 16));
+        const std::string element = line.substr(6, 4);
+        parsed.element = static_cast<uint16_t>(std::strtoul(element.c_str(), &end, 16));
+        std::istringstream rest(line.substr(11));
+        std::string action;
+        rest >> action;
+        std::getline(rest, parsed.value);
+        parsed.value = trim(parsed.value);
+        if (action == "K") parsed.action = TagAction::Keep;
+        else if (action == "X") parsed.action = TagAction::Remove;
+        else if (action == "Z") parsed.action = TagAction::Empty;
+        else if (action == "D") parsed.action = TagAction::Dummy;
+        else if (action == "U") parsed.action = TagAction::ReplaceUid;
+        else return invalid();
+
+        // Later rules for the same tag win
+        auto& rules = profile.rules;
+        rules.erase(std::remove_if(rules.begin(), rules.end(), [&](const TagRule& existing) {
+            return existing.group == parsed.group && existing.element == parsed.element &&
+                existing.group_mask == parsed.group_mask;
+        }), rules.end());
+        rules.push_back(std::move(parsed));
+    }
+    return profile;
+}
+
+class StudyAnonymizer::Impl {
+public:
+    struct FileResult {
+        uint64_t input_bytes = 0;
+        uint64_t output_bytes = 0;
+        bool verified = false;
+        std::string error;
+    };
+
+    explicit Impl(AnonymizationProfile profile) : profile_(std::move(profile)) {
+        for (const TagRule& tag_rule : profile_.rules) {
+            if (tag_rule.group_mask == 0xFFFF) {
+                exact_rules_[tag_key(tag_rule.group, tag_rule.element)] = &tag_rule;
+            }
+            else {
+                group_rules_.push_back(&tag_rule);
+            }
+        }
+    }
+
+    FileResult anonymize_file(const std::filesystem::path& input, const std::filesystem::path& output_directory,
+        bool verify_pixels);
+
+private:
+    AnonymizationProfile profile_;
+    std::unordered_map<uint32_t, const TagRule*> exact_rules_;
+    std::vector<const TagRule*> group_rules_;
+
+    // Old UID to new, shared by every file of the run
+    std::mutex uid_mutex_;
+    std::unordered_map<std::string, std::string> uids_;
+
+    const TagRule* find_rule(uint16_t group, uint16_t element) const {
+        auto it = exact_rules_.find(tag_key(group, element));
+        if (it != exact_rules_.end()) {
+            return it->second;
+        }
+        for (const TagRule* group_rule : group_rules_) {
+            if (group_rule->matches(group, element)) {
+                return group_rule;
+            }
+        }
+        return nullptr;
+    }
+
+    std::string replacement_uid(const std::string& uid) {
+        if (uid.empty()) {
+            return uid;
+        }
+        std::lock_guard lock(uid_mutex_);
+        auto [it, inserted] = uids_.try_emplace(uid);
+        if (inserted) {
+            char buffer[100];
+            it->second = dcmGenerateUniqueIdentifier(buffer, SITE_INSTANCE_UID_ROOT);
+        }
+        return it->second;
+    }
+
+    void replace_uids(DcmElement* element);
+    void apply_rules(DcmItem* item);
+};
+
+void StudyAnonymizer::Impl::replace_uids(DcmElement* element) {
+    OFString values;
+    element->getOFStringArray(values);
+    std::string replaced;
+    std::istringstream in(values.c_str());
+    std::string uid;
+    while (std::getline(in, uid, '\\')) {
+        replaced += (replaced.empty() ? "" : "\\") + replacement_uid(trim(uid));
+    }
+    element->putString(replaced.c_str());
+}
+
+void StudyAnonymizer::Impl::apply_rules(DcmItem* item) {
+    unsigned long i = 0;
+    while (i < item->card()) {
+        DcmElement* element = item->getElement(i);
+        const uint16_t group = element->getGTag();
+        const uint16_t element_number = element->getETag();
+        const bool is_sequence = element->ident() == EVR_SQ;
+
+        // Pixel data is never looked at
+        if (element->ident() == EVR_PixelData) {
+            ++i;
+            continue;
+        }
+        if ((group & 1) != 0 && profile_.remove_private_tags) {
+            delete item->remove(i);
+            continue;
+        }
+
+        const TagRule* tag_rule = find_rule(group, element_number);
+        TagAction action = tag_rule ? tag_rule->action : TagAction::Keep;
+        const DcmVR vr(element->getVR());
+        if (action == TagAction::Dummy && (is_sequence || !vr.isaString())) {
+            action = TagAction::Empty;
+        }
+        switch (action) {
+            case TagAction::Remove:
+                delete item->remove(i);
+                continue;
+            case TagAction::Empty:
+                element->clear();
+                break;
+            case TagAction::Dummy:
+                if (element->getVR() == EVR_UI) {
+                    replace_uids(element);
+                }
+                else {
+                    element->putString(tag_rule->value.empty() ? dummy_value(element->getVR()) : tag_rule->value.c_str());
+                }
+                break;
+            case TagAction::ReplaceUid:
+                if (element->getVR() == EVR_UI) {
+                    replace_uids(element);
+                }
+                break;
+            case TagAction::Keep:
+                if (is_sequence) {
+                    auto* sequence = static_cast<DcmSequenceOfItems*>(element);
+                    for (unsigned long n = 0; n < sequence->card(); ++n) {
+                        apply_rules(sequence->getItem(n));
+                    }
+                }
+                break;
+        }
+        ++i;
+    }
+}
+
+StudyAnonymizer::Impl::FileResult StudyAnonymizer::Impl::anonymize_file(const std::filesystem::path& input,
+    const std::filesystem::path& output_directory, bool verify_pixels) {
+    FileResult result;
+    std::error_code ec;
+    result.input_bytes = std::filesystem::file_size(input, ec);
+
+    // Header pass; the pixel data stays on disk until it is copied out
+    DcmFileFormat file_format;
+    OFCondition cond = file_format.loadFile(input.string().c_str());
+    if (cond.bad()) {
+        result.error = std::string("not readable: ") + cond.text();
+        return result;
+    }
+    DcmDataset* dataset = file_format.getDataset();
+    if (profile_.reject_burned_in_annotation && dataset_string(dataset, DCM_BurnedInAnnotation) == "YES") {
+        result.error = "pixel data has burned-in annotation";
+        return result;
+    }
+
+    apply_rules(dataset);
+    dataset->putAndInsertString(DCM_PatientIdentityRemoved, "YES");
+    dataset->putAndInsertString(DCM_DeidentificationMethod, profile_.name.c_str());
+
+    const std::string sop_instance_uid = dataset_string(dataset, DCM_SOPInstanceUID);
+    if (sop_instance_uid.empty()) {
+        result.error = "no SOP Instance UID";
+        return result;
+    }
+    const std::filesystem::path output = (output_directory / dataset_string(dataset, DCM_StudyInstanceUID) /
+        (sop_instance_uid + ".dcm")).lexically_normal();
+    std::filesystem::create_directories(output.parent_path(), ec);
+
+    // The write cache copies values still on disk in blocks, pixel data included.
+    // The meta header is built anew from the edited dataset, so it carries the
+    // new SOP Instance UID and nothing of the sender's (source AE title and the like)
+    DcmOutputFileStream stream(output.string().c_str());
+    if (!stream.good()) {
+        result.error = "cannot create " + output.string();
+        return result;
+    }
+    DcmWriteCache write_cache;
+    file_format.transferInit();
+    cond = file_format.write(stream, dataset->getOriginalXfer(), EET_ExplicitLength, &write_cache,
+        EGL_recalcGL, EPD_noChange, 0, 0, 0, EWM_createNewMeta);
+    file_format.transferEnd();
+    if (cond.bad()) {
+        result.error = std::string("write failed: ") + cond.text();
+        return result;
+    }
+    result.output_bytes = static_cast<uint64_t>(stream.tell());
+    stream.fclose();
+
+    if (verify_pixels) {
+        auto identical = pixel_data_identical(input, output);
+        if (identical.is_error() || !identical.value()) {
+            result.error = "pixel data differs from the input";
+            return result;
+        }
+        result.verified = true;
+    }
+    return result;
+}
+
+StudyAnonymizer::StudyAnonymizer(AnonymizationProfile profile, ThreadPool& pool)
+    : impl_(std::make_unique<Impl>(std::move(profile)))
+    , pool_(pool) {
+}
+
+StudyAnonymizer::~StudyAnonymizer() = default;
+
+Result<AnonymizeStats, ErrorInfo> StudyAnonymizer::anonymize(const std::vector<std::filesystem::path>& files,
+    const std::filesystem::path& output_directory) {
+    const auto start = Clock::now();
+    AnonymizeStats stats;
+
+    std::error_code ec;
+    std::filesystem::create_directories(output_directory, ec);
+    if (!std::filesystem::is_directory(output_directory, ec)) {
+        return ErrorInfo{ DicomError::FileNotFound, "Cannot create output directory", output_directory.string() };
+    }
+    // The output is named by the new UIDs, so it cannot overwrite an input;
+    // still, an output inside the input would be picked up on the next run
+    for (const auto& file : files) {
+        if (std::filesystem::equivalent(file.parent_path(), output_directory, ec)) {
+            return ErrorInfo{ DicomError::FileNotFound, "Output directory holds input files", output_directory.string() };
+        }
+    }
+
+    const uint32_t total = static_cast<uint32_t>(files.size());
+    uint32_t done = 0;
+    std::deque<std::pair<std::filesystem::path, std::future<Impl::FileResult>>> queue;
+    auto collect_oldest = [&]() {
+        auto [path, future] = std::move(queue.front());
+        queue.pop_front();
+        const Impl::FileResult result = future.get();
+        if (result.error.empty()) {
+            ++stats.files;
+            stats.input_bytes += result.input_bytes;
+            stats.output_bytes += result.output_bytes;
+            stats.verified += result.verified ? 1 : 0;
+        }
+        else {
+            std::cout << "[DEBUG] Anonymize skipped " << path.filename().string() << ": " << result.error << std::endl;
+            if (stats.failed++ == 0) {
+                stats.first_error = path.filename().string() + ": " + result.error;
+            }
+        }
+        ++done;
+        if (progress_) {
+            progress_(done, total);
+        }
+    };
+
+    for (const auto& path : files) {
+        if (cancelled_) {
+            stats.cancelled = true;
+            break;
+        }
+        queue.emplace_back(path, pool_.submit([impl = impl_.get(), path, output_directory, verify = verify_pixels_]() {
+            return impl->anonymize_file(path, output_directory, verify);
+        }, TaskPriority::Indexing));
+        while (queue.size() > pool_.size() * kQueuedFilesPerWorker) {
+            collect_oldest();
+        }
+    }
+    while (!queue.empty()) {
+        collect_oldest();
+    }
+
+    stats.total_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    if (stats.files == 0 && stats.failed > 0) {
+        return ErrorInfo{ DicomError::InvalidFormat, "No file could be anonymized", stats.first_error };
+    }
+    std::cout << "[DEBUG] Anonymized " << stats.files << " files, " << stats.input_bytes / (1024 * 1024)
+        << " MB at " << stats.megabytes_per_second() << " MB/s; " << stats.failed << " failed" << std::endl;
+    return stats;
+}
+
+Result<bool, ErrorInfo> pixel_data_identical(const std::filesystem::path& first, const std::filesystem::path& second) {
+    DcmFileFormat first_file;
+    DcmFileFormat second_file;
+    if (first_file.loadFile(first.string().c_str()).bad()) {
+        return ErrorInfo{ DicomError::InvalidFormat, "Failed to load DICOM file", first.string() };
+    }
+    if (second_file.loadFile(second.string().c_str()).bad()) {
+        return ErrorInfo{ DicomError::InvalidFormat, "Failed to load DICOM file", second.string() };
+    }
+    DcmDataset* first_dataset = first_file.getDataset();
+    DcmDataset* second_dataset = second_file.getDataset();
+    DcmElement* first_pixels = find_pixel_data(first_dataset);
+    DcmElement* second_pixels = find_pixel_data(second_dataset);
+    if (!first_pixels || !second_pixels) {
+        return !first_pixels && !second_pixels;
+    }
+
+    DcmFileCache first_cache;
+    DcmFileCache second_cache;
+    std::vector<char> first_block(kCompareBlockBytes);
+    std::vector<char> second_block(kCompareBlockBytes);
+    DcmPixelSequence* first_sequence = encapsulated_sequence(first_dataset, first_pixels);
+    DcmPixelSequence* second_sequence = encapsulated_sequence(second_dataset, second_pixels);
+    if (!first_sequence || !second_sequence) {
+        return !first_sequence && !second_sequence &&
+            same_value(first_pixels, first_cache, second_pixels, second_cache, first_block, second_block);
+    }
+
+    // Offset table and fragments, item by item
+    if (first_sequence->card() != second_sequence->card()) {
+        return false;
+    }
+    for (unsigned long i = 0; i < first_sequence->card(); ++i) {
+        DcmPixelItem* first_item = nullptr;
+        DcmPixelItem* second_item = nullptr;
+        if (first_sequence->getItem(first_item, i).bad() || second_sequence->getItem(second_item, i).bad() ||
+            !same_value(first_item, first_cache, second_item, second_cache, first_block, second_block)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Result<bool, ErrorInfo> meta_header_matches_dataset(const std::filesystem::path& path) {
+    DcmFileFormat file_format;
+    if (file_format.loadFile(path.string().c_str()).bad()) {
+        return ErrorInfo{ DicomError::InvalidFormat, "Failed to load DICOM file", path.string() };
+    }
+    DcmMetaInfo* meta = file_format.getMetaInfo();
+    DcmDataset* dataset = file_format.getDataset();
+    const std::string instance_uid = dataset_string(dataset, DCM_SOPInstanceUID);
+    return !instance_uid.empty() && dataset_string(meta, DCM_MediaStorageSOPInstanceUID) == instance_uid &&
+        dataset_string(meta, DCM_MediaStorageSOPClassUID) == dataset_string(dataset, DCM_SOPClassUID);
+}
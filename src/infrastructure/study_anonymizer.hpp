@@ -0,0 +1,113 @@
+#pragma once
+
+#include "core/error_codes.hpp"
+#include "core/result.hpp"
+#include "core/thread_pool.hpp"
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// What happens to an attribute, as in the action codes of DICOM PS3.15 Annex E
+enum class TagAction {
+    Keep,         // K
+    Remove,       // X
+    Empty,        // Z: kept with a zero-length value
+    Dummy,        // D: replaced with a dummy value of its VR, or the rule's value
+    ReplaceUid    // U: replaced with a new UID, the same one wherever the old UID appears
+};
+
+struct TagRule {
+    uint16_t group = 0;
+    uint16_t element = 0;
+    uint16_t group_mask = 0xFFFF;   // 0xFF00 for repeating groups such as (60xx,3000)
+    TagAction action = TagAction::Keep;
+    std::string value;              // for Dummy; empty for the VR's default
+
+    bool matches(uint16_t tag_group, uint16_t tag_element) const {
+        return (tag_group & group_mask) == group && tag_element == element;
+    }
+};
+
+struct AnonymizationProfile {
+    std::string name;                   // recorded as De-identification Method
+    std::vector<TagRule> rules;         // applied in datasets and in every sequence item
+    bool remove_private_tags = true;
+    bool reject_burned_in_annotation = true;   // pixels are never touched, so such images are refused
+
+    // Rules after the Basic Application Level Confidentiality Profile of DICOM
+    // PS3.15, for the attributes of its Table E.1-1 that images commonly carry
+    static AnonymizationProfile basic();
+};
+
+// Rules as text, one per line: "(0010,0010) D ANONYMOUS", "(60xx,3000) X",
+// "(0020,000D) U"; '#' starts a comment. "private keep" retains private
+// tags and "burned-in allow" accepts images with burned-in annotation.
+// The rules are added to the Basic profile and override it for the same tag.
+Result<AnonymizationProfile, ErrorInfo> load_anonymization_profile(const std::filesystem::path& path);
+
+struct AnonymizeStats {
+    uint32_t files = 0;
+    uint32_t failed = 0;
+    uint32_t verified = 0;        // outputs whose pixel data was compared with the input
+    uint64_t input_bytes = 0;
+    uint64_t output_bytes = 0;
+    double total_ms = 0.0;
+    bool cancelled = false;
+    std::string first_error;
+
+    // Input read per second
+    double megabytes_per_second() const {
+        return total_ms > 0.0 ? static_cast<double>(input_bytes) / (1024.0 * 1024.0) / (total_ms / 1000.0) : 0.0;
+    }
+};
+
+// De-identifies DICOM files by rewriting header attributes only. Pixel data,
+// native or encapsulated, is never decoded or even loaded: it stays on disk
+// while the header is edited and is copied block by block from the input
+// to the output file, so it comes out byte for byte as it went in. Files
+// are processed in parallel on the pool. Replacement UIDs are shared by all
+// files of one run, so references between instances stay intact.
+// Use one anonymizer per run.
+class StudyAnonymizer {
+public:
+    explicit StudyAnonymizer(AnonymizationProfile profile, ThreadPool& pool = ThreadPool::shared());
+    ~StudyAnonymizer();
+
+    StudyAnonymizer(const StudyAnonymizer&) = delete;
+    StudyAnonymizer& operator=(const StudyAnonymizer&) = delete;
+
+    // Called on the anonymizing thread after each file
+    void set_progress(std::function<void(uint32_t done, uint32_t total)> progress) { progress_ = std::move(progress); }
+
+    // Stops after the files in progress; any thread
+    void cancel() { cancelled_ = true; }
+
+    // Reads each output back and compares its pixel data with the input;
+    // a difference fails the file
+    void set_verify_pixels(bool verify) { verify_pixels_ = verify; }
+
+    // Writes each file to <output_directory>/<new Study UID>/<new SOP UID>.dcm.
+    // Files that cannot be read or de-identified are counted and skipped.
+    // Must not be called from a thread of the pool.
+    Result<AnonymizeStats, ErrorInfo> anonymize(const std::vector<std::filesystem::path>& files,
+        const std::filesystem::path& output_directory);
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> impl_;
+    ThreadPool& pool_;
+    std::function<void(uint32_t, uint32_t)> progress_;
+    std::atomic<bool> cancelled_{ false };
+    bool verify_pixels_ = false;
+};
+
+// Whether two files hold the same pixel data bytes: the same native value,
+// or the same encapsulated fragments. Compared in blocks without decoding.
+Result<bool, ErrorInfo> pixel_data_identical(const std::filesystem::path& first, const std::filesystem::path& second);
+
+// Whether a file's meta header names the SOP Class and Instance UIDs its dataset has
+Result<bool, ErrorInfo> meta_header_matches_dataset(const std::filesystem::path& path);
@@ -0,0 +1,423 @@
+#include "study_transcoder.hpp"
+#include "codec_registry.hpp"
+#include "core/dicom_metadata.hpp"
+
+// DCMTK includes
+#include <dcmtk/dcmdata/dctk.h>
+#include <dcmtk/dcmdata/dcfcache.h>
+#include <dcmtk/dcmdata/dcostrmf.h>
+#include <dcmtk/dcmdata/dcpixseq.h>
+#include <dcmtk/dcmdata/dcpxitem.h>
+#include <dcmtk/dcmdata/dcrleerg.h>
+#include <dcmtk/dcmdata/dcrlerp.h>
+#include <dcmtk/dcmimgle/diutils.h>
+#include <dcmtk/dcmjpls/djencode.h>
+#include <dcmtk/dcmjpls/djrparam.h>
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <memory>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Frames read but not yet encoded: enough to keep every worker busy, and a
+// bound on memory whatever the study size
+constexpr size_t kQueuedFramesPerWorker = 4;
+constexpr uint64_t kMaxQueuedBytes = 128ull * 1024 * 1024;
+
+void register_codecs() {
+    // Idempotent; decoders for compressed input come from ensure_decoders
+    DcmRLEEncoderRegistration::registerCodecs();
+    DJLSEncoderRegistration::registerCodecs();
+
+    // The JPEG-LS encoder would log an info line for every frame
+    DCM_dcmimgleLogger.setLogLevel(OFLogger::WARN_LOG_LEVEL);
+}
+
+E_TransferSyntax transfer_syntax(TranscodeCodec codec) {
+    return codec == TranscodeCodec::Rle ? EXS_RLELossless : EXS_JPEGLSLossless;
+}
+
+const DcmRepresentationParameter* representation_parameter(TranscodeCodec codec) {
+    static const DcmRLERepresentationParameter rle;
+    static const DJLSRepresentationParameter jpeg_ls(2, OFTrue);
+    if (codec == TranscodeCodec::Rle) {
+        return &rle;
+    }
+    return &jpeg_ls;
+}
+
+DcmPixelData* find_pixel_data(DcmDataset* dataset) {
+    DcmElement* element = nullptr;
+    if (dataset->findAndGetElement(DCM_PixelData, element).bad() || !element ||
+        element->ident() != EVR_PixelData) {
+        return nullptr;
+    }
+    return static_cast<DcmPixelData*>(element);
+}
+
+// One encoded frame: its fragments, and the Image Pixel attributes the encoder settled on
+struct EncodedFrame {
+    std::vector<std::unique_ptr<DcmPixelItem>> fragments;
+    std::string photometric;
+    std::optional<Uint16> planar_configuration;
+    uint64_t bytes = 0;
+    std::string error;
+};
+
+// A single frame as a dataset of its own, so the registered encoders can
+// run on it independently of the other frames
+std::unique_ptr<DcmDataset> frame_dataset(DcmDataset* source, const OFString& color_model) {
+    auto frame = std::make_unique<DcmDataset>();
+    const DcmTagKey copied[] = { DCM_SamplesPerPixel, DCM_Rows, DCM_Columns, DCM_BitsAllocated,
+        DCM_BitsStored, DCM_HighBit, DCM_PixelRepresentation, DCM_PlanarConfiguration };
+    for (const DcmTagKey& tag : copied) {
+        Uint16 value = 0;
+        if (source->findAndGetUint16(tag, value).good()) {
+            frame->putAndInsertUint16(tag, value);
+        }
+    }
+    frame->putAndInsertString(DCM_PhotometricInterpretation, color_model.c_str());
+    return frame;
+}
+
+EncodedFrame encode_frame(DcmDataset& frame, TranscodeCodec codec) {
+    EncodedFrame encoded;
+    const E_TransferSyntax xfer = transfer_syntax(codec);
+    const DcmRepresentationParameter* param = representation_parameter(codec);
+    OFCondition cond = frame.chooseRepresentation(xfer, param);
+    DcmPixelSequence* sequence = nullptr;
+    DcmPixelData* pixel_data = find_pixel_data(&frame);
+    if (cond.good() && pixel_data) {
+        cond = pixel_data->getEncapsulatedRepresentation(xfer, param, sequence);
+    }
+    if (cond.bad() || !sequence) {
+        encoded.error = cond.bad() ? cond.text() : "no encoded pixel data";
+        return encoded;
+    }
+
+    // Item 0 is the offset table; the fragments move over without copying
+    DcmPixelItem* item = nullptr;
+    while (sequence->card() > 1 && sequence->remove(item, 1).good()) {
+        encoded.bytes += item->getLength();
+        encoded.fragments.emplace_back(item);
+    }
+    OFString photometric;
+    frame.findAndGetOFString(DCM_PhotometricInterpretation, photometric);
+    encoded.photometric = photometric.c_str();
+    Uint16 planar_configuration = 0;
+    if (frame.findAndGetUint16(DCM_PlanarConfiguration, planar_configuration).good()) {
+        encoded.planar_configuration = planar_configuration;
+    }
+    return encoded;
+}
+
+// A file whose frames are being encoded
+struct OpenFile {
+    std::filesystem::path input;
+    std::filesystem::path output;
+    DcmFileFormat file_format;
+    DcmFileCache file_cache;
+    std::vector<EncodedFrame> frames;
+    uint32_t submitted = 0;
+    uint32_t collected = 0;
+    bool read_all = false;
+    std::string error;
+
+    bool complete() const { return read_all && collected == submitted; }
+};
+
+struct QueuedFrame {
+    std::shared_ptr<OpenFile> file;
+    uint32_t index;
+    uint64_t bytes;
+    std::future<EncodedFrame> encoded;
+};
+
+std::string dataset_string(DcmDataset* dataset, const DcmTagKey& tag) {
+    OFString value;
+    dataset->findAndGetOFString(tag, value);
+    return value.c_str();
+}
+
+// Streams the file out; returns the bytes written
+Result<uint64_t, ErrorInfo> write_file(DcmFileFormat& file_format, const std::filesystem::path& path,
+    E_TransferSyntax xfer) {
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+    DcmOutputFileStream stream(path.string().c_str());
+    if (!stream.good()) {
+        return ErrorInfo{ DicomError::FileNotFound, "Cannot create output file", path.string() };
+    }
+    file_format.transferInit();
+    const OFCondition cond = file_format.write(stream, xfer, EET_ExplicitLength, nullptr);
+    file_format.transferEnd();
+    if (cond.bad()) {
+        return ErrorInfo{ DicomError::FileNotFound, "Failed to write output file", cond.text() };
+    }
+    return static_cast<uint64_t>(stream.tell());
+}
+
+} // namespace
+
+std::optional<TranscodeCodec> parse_transcode_codec(std::string_view name) {
+    if (name == "jpegls" || name == "jpeg-ls") {
+        return TranscodeCodec::JpegLsLossless;
+    }
+    if (name == "rle") {
+        return TranscodeCodec::Rle;
+    }
+    return std::nullopt;
+}
+
+Result<TranscodeStats, ErrorInfo> StudyTranscoder::transcode(const std::vector<std::filesystem::path>& files,
+    const std::filesystem::path& output_directory) {
+    const auto start = Clock::now();
+    TranscodeStats stats;
+
+    std::error_code ec;
+    std::filesystem::create_directories(output_directory, ec);
+    if (!std::filesystem::is_directory(output_directory, ec)) {
+        return ErrorInfo{ DicomError::FileNotFound, "Cannot create output directory", output_directory.string() };
+    }
+    register_codecs();
+
+    const E_TransferSyntax xfer = transfer_syntax(codec_);
+    const uint32_t total = static_cast<uint32_t>(files.size());
+    uint32_t done = 0;
+    auto fail = [&](const std::filesystem::path& path, const std::string& reason) {
+        std::cout << "[DEBUG] Transcode skipped " << path.filename().string() << ": " << reason << std::endl;
+        if (stats.failed++ == 0) {
+            stats.first_error = path.filename().string() + ": " + reason;
+        }
+    };
+    auto report = [&]() {
+        ++done;
+        if (progress_) {
+            progress_(done, total);
+        }
+    };
+
+    // Frames go to the pool in file order and are collected in that order,
+    // so files complete, and are written, in order too
+    std::deque<QueuedFrame> queue;
+    std::deque<std::shared_ptr<OpenFile>> open_files;
+    uint64_t queued_bytes = 0;
+
+    auto finish_file = [&](OpenFile& file) {
+        if (file.error.empty()) {
+            DcmDataset* dataset = file.file_format.getDataset();
+            auto* sequence = new DcmPixelSequence(DCM_PixelSequenceTag);
+            auto* offset_table = new DcmPixelItem(DCM_PixelItemTag);
+            sequence->insert(offset_table);
+            DcmOffsetList offsets;
+            for (EncodedFrame& frame : file.frames) {
+                Uint32 frame_length = 0;
+                for (auto& fragment : frame.fragments) {
+                    frame_length += fragment->getLength() + 8;   // item header included
+                    sequence->insert(fragment.release());
+                }
+                offsets.push_back(frame_length);
+            }
+            // Past 4 GB the offset table stays empty, which is allowed
+            offset_table->createOffsetTable(offsets);
+            find_pixel_data(dataset)->putOriginalRepresentation(xfer, representation_parameter(codec_), sequence);
+
+            const EncodedFrame& first = file.frames.front();
+            dataset->putAndInsertString(DCM_PhotometricInterpretation, first.photometric.c_str());
+            if (first.planar_configuration) {
+                dataset->putAndInsertUint16(DCM_PlanarConfiguration, *first.planar_configuration);
+            }
+            else {
+                delete dataset->remove(DCM_PlanarConfiguration);
+            }
+
+            auto written = write_file(file.file_format, file.output, xfer);
+            if (written.is_ok()) {
+                ++stats.files;
+                stats.output_bytes += written.value();
+            }
+            else {
+                file.error = written.error().full_message();
+            }
+        }
+        if (!file.error.empty()) {
+            fail(file.input, file.error);
+        }
+        report();
+    };
+    auto finish_complete_files = [&]() {
+        while (!open_files.empty() && open_files.front()->complete()) {
+            finish_file(*open_files.front());
+            open_files.pop_front();
+        }
+    };
+    auto collect_oldest = [&]() {
+        QueuedFrame queued = std::move(queue.front());
+        queue.pop_front();
+        queued_bytes -= queued.bytes;
+        EncodedFrame encoded = queued.encoded.get();
+        OpenFile& file = *queued.file;
+        ++file.collected;
+        if (!encoded.error.empty()) {
+            if (file.error.empty()) {
+                file.error = "frame " + std::to_string(queued.index + 1) + " not encoded: " + encoded.error;
+            }
+        }
+        else {
+            stats.frames += 1;
+            stats.pixel_bytes += queued.bytes;
+            stats.encoded_bytes += encoded.bytes;
+        }
+        file.frames[queued.index] = std::move(encoded);
+        finish_complete_files();
+    };
+
+    for (const auto& path : files) {
+        if (cancelled_) {
+            stats.cancelled = true;
+            break;
+        }
+
+        auto file = std::make_shared<OpenFile>();
+        file->input = path;
+        // Header pass; the pixel data stays on disk and is read a frame at a time
+        OFCondition cond = file->file_format.loadFile(path.string().c_str());
+        if (cond.bad()) {
+            fail(path, std::string("not readable: ") + cond.text());
+            report();
+            continue;
+        }
+        DcmDataset* dataset = file->file_format.getDataset();
+        // The UIDs name the output, so they must not step outside the output directory
+        const std::string study_instance_uid = dataset_string(dataset, DCM_StudyInstanceUID);
+        const std::string sop_instance_uid = dataset_string(dataset, DCM_SOPInstanceUID);
+        if (!is_valid_uid(study_instance_uid) || !is_valid_uid(sop_instance_uid)) {
+            fail(path, "no usable Study or SOP Instance UID");
+            report();
+            continue;
+        }
+        file->output = (output_directory / study_instance_uid / (sop_instance_uid + ".dcm")).lexically_normal();
+        if (std::filesystem::equivalent(file->output, path, ec)) {
+            fail(path, "output would overwrite the input");
+            report();
+            continue;
+        }
+
+        // Nothing to encode: written as it is
+        DcmPixelData* pixel_data = find_pixel_data(dataset);
+        const E_TransferSyntax original_xfer = dataset->getOriginalXfer();
+        if (!pixel_data || original_xfer == xfer) {
+            auto written = write_file(file->file_format, file->output, original_xfer);
+            if (written.is_ok()) {
+                ++stats.copied;
+                stats.output_bytes += written.value();
+            }
+            else {
+                fail(path, written.error().full_message());
+            }
+            report();
+            continue;
+        }
+
+        ensure_decoders(*dataset);
+        Sint32 frame_count = 1;
+        if (dataset->findAndGetSint32(DCM_NumberOfFrames, frame_count).bad() || frame_count < 1) {
+            frame_count = 1;
+        }
+        Uint32 frame_size = 0;
+        cond = pixel_data->getUncompressedFrameSize(dataset, frame_size,
+            !DcmXfer(original_xfer).usesEncapsulatedFormat());
+        Uint16 bits_allocated = 0;
+        dataset->findAndGetUint16(DCM_BitsAllocated, bits_allocated);
+        if (cond.bad() || frame_size == 0 || (bits_allocated != 8 && bits_allocated != 16)) {
+            fail(path, "unsupported pixel data (" + std::to_string(bits_allocated) + " bits allocated)");
+            report();
+            continue;
+        }
+
+        file->frames.resize(static_cast<size_t>(frame_count));
+        open_files.push_back(file);
+        Uint32 start_fragment = 0;
+        for (Sint32 f = 0; f < frame_count; ++f) {
+            // Read straight into the pixel data of the frame's own dataset
+            OFString color_model;
+            dataset->findAndGetOFString(DCM_PhotometricInterpretation, color_model);
+            auto frame = frame_dataset(dataset, color_model);
+            auto* frame_pixels = new DcmPixelData(DCM_PixelData);
+            frame->insert(frame_pixels);
+            // An odd frame size needs a pad byte
+            const Uint32 buffer_size = frame_size + (frame_size & 1);
+            void* buffer = nullptr;
+            if (bits_allocated == 16) {
+                Uint16* words = nullptr;
+                cond = frame_pixels->createUint16Array(buffer_size / 2, words);
+                buffer = words;
+            }
+            else {
+                Uint8* bytes = nullptr;
+                cond = frame_pixels->createUint8Array(buffer_size, bytes);
+                buffer = bytes;
+            }
+            if (cond.good()) {
+                cond = pixel_data->getUncompressedFrame(dataset, static_cast<Uint32>(f), start_fragment, buffer,
+                    buffer_size, color_model, &file->file_cache);
+            }
+            if (cond.bad()) {
+                file->error = "frame " + std::to_string(f + 1) + " not readable: " + cond.text();
+                break;
+            }
+            // Compressed input comes out in the decoder's color model
+            frame->putAndInsertString(DCM_PhotometricInterpretation, color_model.c_str());
+
+            queue.push_back(QueuedFrame{ file, static_cast<uint32_t>(f), frame_size,
+                pool_.submit([frame = std::move(frame), codec = codec_]() { return encode_frame(*frame, codec); },
+                    TaskPriority::Indexing) });
+            ++file->submitted;
+            queued_bytes += frame_size;
+            while (queue.size() > pool_.size() * kQueuedFramesPerWorker || queued_bytes > kMaxQueuedBytes) {
+                collect_oldest();
+            }
+        }
+        file->read_all = true;
+        finish_complete_files();
+    }
+
+    while (!queue.empty()) {
+        collect_oldest();
+    }
+    finish_complete_files();
+
+    stats.total_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    if (stats.files + stats.copied == 0 && stats.failed > 0) {
+        return ErrorInfo{ DicomError::InvalidFormat, "No file could be transcoded", stats.first_error };
+    }
+    std::cout << "[DEBUG] Transcoded " << stats.files << " files (" << stats.frames << " frames) to "
+        << transcode_codec_name(codec_) << ", ratio " << stats.compression_ratio() << ", "
+        << stats.megabytes_per_second() << " MB/s; " << stats.copied << " copied, "
+        << stats.failed << " failed" << std::endl;
+    return stats;
+}
+
+std::vector<std::filesystem::path> collect_files(const std::vector<std::filesystem::path>& paths) {
+    std::vector<std::filesystem::path> files;
+    std::error_code ec;
+    for (const auto& path : paths) {
+        if (std::filesystem::is_directory(path, ec)) {
+            for (const auto& entry : std::filesystem::recursive_directory_iterator(path, ec)) {
+                if (entry.is_regular_file(ec)) {
+                    files.push_back(entry.path());
+                }
+            }
+        }
+        else if (std::filesystem::is_regular_file(path, ec)) {
+            files.push_back(path);
+        }
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
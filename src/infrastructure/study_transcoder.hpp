@@ -0,0 +1,88 @@
+#pragma once
+
+#include "core/error_codes.hpp"
+#include "core/result.hpp"
+#include "core/thread_pool.hpp"
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class TranscodeCodec {
+    JpegLsLossless,
+    Rle
+};
+
+constexpr std::string_view transcode_codec_name(TranscodeCodec codec) {
+    switch (codec) {
+        case TranscodeCodec::JpegLsLossless: return "JPEG-LS Lossless";
+        case TranscodeCodec::Rle: return "RLE";
+        default: return "Unknown";
+    }
+}
+
+// "jpegls" or "rle", as given on the command line
+std::optional<TranscodeCodec> parse_transcode_codec(std::string_view name);
+
+struct TranscodeStats {
+    uint32_t files = 0;           // written with the new transfer syntax
+    uint32_t copied = 0;          // written unchanged: no pixel data, or already in the transfer syntax
+    uint32_t failed = 0;
+    uint64_t frames = 0;          // frames encoded
+    uint64_t pixel_bytes = 0;     // their uncompressed size
+    uint64_t encoded_bytes = 0;   // their encoded size
+    uint64_t output_bytes = 0;    // size of the files written
+    double total_ms = 0.0;
+    bool cancelled = false;
+    std::string first_error;      // why the first failed file failed
+
+    double compression_ratio() const {
+        return encoded_bytes > 0 ? static_cast<double>(pixel_bytes) / static_cast<double>(encoded_bytes) : 0.0;
+    }
+
+    // Uncompressed pixel data encoded per second
+    double megabytes_per_second() const {
+        return total_ms > 0.0 ? static_cast<double>(pixel_bytes) / (1024.0 * 1024.0) / (total_ms / 1000.0) : 0.0;
+    }
+};
+
+// Re-encodes DICOM files to a lossless transfer syntax for archiving or
+// forwarding. The calling thread reads frames and writes files; the frames
+// are encoded on the pool, across files, so single-frame series keep every
+// core as busy as multi-frame objects do. Pixel data is read a frame at a
+// time and each file is streamed out as soon as its frames are encoded,
+// so at most a bounded window of frames is held in memory. Use one
+// transcoder per export.
+class StudyTranscoder {
+public:
+    explicit StudyTranscoder(TranscodeCodec codec, ThreadPool& pool = ThreadPool::shared())
+        : codec_(codec), pool_(pool) {}
+
+    StudyTranscoder(const StudyTranscoder&) = delete;
+    StudyTranscoder& operator=(const StudyTranscoder&) = delete;
+
+    // Called on the transcoding thread after each file
+    void set_progress(std::function<void(uint32_t done, uint32_t total)> progress) { progress_ = std::move(progress); }
+
+    // Stops after the files in progress; any thread
+    void cancel() { cancelled_ = true; }
+
+    // Writes each file to <output_directory>/<Study UID>/<SOP UID>.dcm.
+    // Files that cannot be read or encoded are counted and skipped. Must not
+    // be called from a thread of the pool. Fails only if nothing can be written.
+    Result<TranscodeStats, ErrorInfo> transcode(const std::vector<std::filesystem::path>& files,
+        const std::filesystem::path& output_directory);
+
+private:
+    TranscodeCodec codec_;
+    ThreadPool& pool_;
+    std::function<void(uint32_t, uint32_t)> progress_;
+    std::atomic<bool> cancelled_{ false };
+};
+
+// Regular files among the paths and under the directories among them, sorted
+std::vector<std::filesystem::path> collect_files(const std::vector<std::filesystem::path>& paths);
@@ -0,0 +1,187 @@
+#include "tcp_socket.hpp"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+#ifdef _WIN32
+using NativeSocket = SOCKET;
+
+bool start_network() {
+    static const bool started = []() {
+        WSADATA data;
+        return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+    }();
+    return started;
+}
+
+void close_native(NativeSocket socket) {
+    closesocket(socket);
+}
+
+std::string last_error() {
+    return "WSA error " + std::to_string(WSAGetLastError());
+}
+#else
+using NativeSocket = int;
+
+bool start_network() {
+    return true;
+}
+
+void close_native(NativeSocket socket) {
+    ::close(socket);
+}
+
+std::string last_error() {
+    return std::strerror(errno);
+}
+#endif
+
+NativeSocket native(intptr_t handle) {
+    return static_cast<NativeSocket>(handle);
+}
+
+// Requests and small headers go out at once instead of waiting on delayed ACKs
+void disable_nagle(NativeSocket socket) {
+    int on = 1;
+    setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&on), sizeof(on));
+}
+
+} // namespace
+
+TcpSocket::~TcpSocket() {
+    close();
+}
+
+TcpSocket::TcpSocket(TcpSocket&& other) noexcept
+    : handle_(std::exchange(other.handle_, kInvalid)) {
+}
+
+TcpSocket& TcpSocket::operator=(TcpSocket&& other) noexcept {
+    if (this != &other) {
+        close();
+        handle_ = std::exchange(other.handle_, kInvalid);
+    }
+    return *this;
+}
+
+Result<TcpSocket, ErrorInfo> TcpSocket::connect(const std::string& host, uint16_t port) {
+    if (!start_network()) {
+        return ErrorInfo{ DicomError::NetworkError, "Cannot initialize networking", "" };
+    }
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addresses = nullptr;
+    const std::string service = std::to_string(port);
+    if (getaddrinfo(host.c_str(), service.c_str(), &hints, &addresses) != 0 || addresses == nullptr) {
+        return ErrorInfo{ DicomError::NetworkError, "Cannot resolve host", host };
+    }
+
+    std::string error = "no address";
+    for (addrinfo* address = addresses; address != nullptr; address = address->ai_next) {
+        const NativeSocket socket = ::socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (static_cast<intptr_t>(socket) == kInvalid) {
+            continue;
+        }
+        if (::connect(socket, address->ai_addr, static_cast<int>(address->ai_addrlen)) == 0) {
+            freeaddrinfo(addresses);
+            disable_nagle(socket);
+            return TcpSocket(static_cast<intptr_t>(socket));
+        }
+        error = last_error();
+        close_native(socket);
+    }
+    freeaddrinfo(addresses);
+    return ErrorInfo{ DicomError::NetworkError, "Cannot connect to " + host + ":" + service, error };
+}
+
+Result<TcpSocket, ErrorInfo> TcpSocket::listen(uint16_t port) {
+    if (!start_network()) {
+        return ErrorInfo{ DicomError::NetworkError, "Cannot initialize networking", "" };
+    }
+
+    TcpSocket listener(static_cast<intptr_t>(::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP)));
+    if (!listener.valid()) {
+        return ErrorInfo{ DicomError::NetworkError, "Cannot create socket", last_error() };
+    }
+    int on = 1;
+    setsockopt(native(listener.handle_), SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&on), sizeof(on));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    if (::bind(native(listener.handle_), reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(native(listener.handle_), SOMAXCONN) != 0) {
+        return ErrorInfo{ DicomError::NetworkError, "Cannot listen on port " + std::to_string(port), last_error() };
+    }
+    return listener;
+}
+
+Result<TcpSocket, ErrorInfo> TcpSocket::accept() {
+    TcpSocket client(static_cast<intptr_t>(::accept(native(handle_), nullptr, nullptr)));
+    if (!client.valid()) {
+        return ErrorInfo{ DicomError::NetworkError, "Cannot accept connection", last_error() };
+    }
+    disable_nagle(native(client.handle_));
+    return client;
+}
+
+int64_t TcpSocket::receive(char* buffer, size_t size) {
+    const int chunk = static_cast<int>(std::min<size_t>(size, 1 << 30));
+    return static_cast<int64_t>(::recv(native(handle_), buffer, chunk, 0));
+}
+
+bool TcpSocket::send_all(const char* data, size_t size) {
+#ifdef _WIN32
+    constexpr int flags = 0;
+#else
+    // A peer that went away is reported as an error, not SIGPIPE
+    constexpr int flags = MSG_NOSIGNAL;
+#endif
+    while (size > 0) {
+        const int chunk = static_cast<int>(std::min<size_t>(size, 1 << 30));
+        const auto sent = ::send(native(handle_), data, chunk, flags);
+        if (sent <= 0) {
+            return false;
+        }
+        data += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+void TcpSocket::set_receive_timeout(uint32_t seconds) {
+#ifdef _WIN32
+    const DWORD timeout = seconds * 1000;
+#else
+    timeval timeout{};
+    timeout.tv_sec = static_cast<time_t>(seconds);
+#endif
+    setsockopt(native(handle_), SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+}
+
+void TcpSocket::close() {
+    if (valid()) {
+        close_native(native(handle_));
+        handle_ = kInvalid;
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "core/error_codes.hpp"
+#include "core/result.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Blocking TCP stream socket, just enough for the HTTP client and the
+// test server behind it. Move-only; closes on destruction.
+class TcpSocket {
+public:
+    TcpSocket() = default;
+    ~TcpSocket();
+
+    TcpSocket(TcpSocket&& other) noexcept;
+    TcpSocket& operator=(TcpSocket&& other) noexcept;
+    TcpSocket(const TcpSocket&) = delete;
+    TcpSocket& operator=(const TcpSocket&) = delete;
+
+    static Result<TcpSocket, ErrorInfo> connect(const std::string& host, uint16_t port);
+
+    // Listens on every interface
+    static Result<TcpSocket, ErrorInfo> listen(uint16_t port);
+
+    // Blocks until a client connects
+    Result<TcpSocket, ErrorInfo> accept();
+
+    bool valid() const { return handle_ != kInvalid; }
+
+    // Bytes received into buffer, 0 once the peer closed, -1 on error or timeout
+    int64_t receive(char* buffer, size_t size);
+
+    bool send_all(const char* data, size_t size);
+
+    // 0 waits forever
+    void set_receive_timeout(uint32_t seconds);
+
+    void close();
+
+private:
+    static constexpr intptr_t kInvalid = -1;
+
+    explicit TcpSocket(intptr_t handle) : handle_(handle) {}
+
+    intptr_t handle_ = kInvalid;   // SOCKET on Windows, file descriptor elsewhere
+};
@@ -0,0 +1,283 @@
+#include "test_dicomweb_server.hpp"
+#include "codec_registry.hpp"
+#include "tcp_socket.hpp"
+
+// DCMTK includes
+#include <dcmtk/dcmdata/dctk.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <thread>
+
+namespace {
+
+const char* const kBoundary = "DICOMVIEWER-TEST-PART";
+
+// Body bytes per chunk of the chunked transfer coding
+constexpr size_t kChunkSize = 64 * 1024;
+
+struct RecordedResponse {
+    std::string content_type;
+    std::filesystem::path body;
+};
+
+// A multipart body written part by part
+class MultipartWriter {
+public:
+    explicit MultipartWriter(const std::filesystem::path& path) : file_(path, std::ios::binary) {}
+
+    void begin_part(const std::string& content_type, uint64_t length) {
+        file_ << "--" << kBoundary << "\r\n"
+              << "Content-Type: " << content_type << "\r\n"
+              << "Content-Length: " << length << "\r\n\r\n";
+    }
+
+    void write(const char* data, size_t size) {
+        file_.write(data, static_cast<std::streamsize>(size));
+    }
+
+    void copy(const std::filesystem::path& path) {
+        std::ifstream in(path, std::ios::binary);
+        file_ << in.rdbuf();
+    }
+
+    void end_part() {
+        file_ << "\r\n";
+    }
+
+    bool close() {
+        file_ << "--" << kBoundary << "--\r\n";
+        file_.close();
+        return !file_.fail();
+    }
+
+private:
+    std::ofstream file_;
+};
+
+std::string multipart_type(const std::string& part_type) {
+    return "multipart/related; type=\"" + part_type + "\"; boundary=" + kBoundary;
+}
+
+std::string dataset_string(DcmDataset* dataset, const DcmTagKey& tag) {
+    OFString value;
+    dataset->findAndGetOFString(tag, value);
+    return value.c_str();
+}
+
+} // namespace
+
+class TestDicomWebServer::Impl {
+public:
+    TestDicomWebConfig config_;
+    std::map<std::string, RecordedResponse> responses_;   // by request target
+    TcpSocket listener_;
+    std::thread thread_;
+    std::atomic<bool> stopping_{ false };
+
+    explicit Impl(TestDicomWebConfig config) : config_(std::move(config)) {}
+
+    std::filesystem::path next_body_path() const {
+        return config_.storage_directory / ("response_" + std::to_string(responses_.size()) + ".bin");
+    }
+
+    std::string url(const std::string& target) const {
+        return "http://127.0.0.1:" + std::to_string(config_.port) + target;
+    }
+
+    void serve(TcpSocket& client) const;
+};
+
+void TestDicomWebServer::Impl::serve(TcpSocket& client) const {
+    client.set_receive_timeout(5);
+    std::string request;
+    char buffer[4096];
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < 16 * 1024) {
+        const int64_t received = client.receive(buffer, sizeof(buffer));
+        if (received <= 0) {
+            return;
+        }
+        request.append(buffer, static_cast<size_t>(received));
+    }
+
+    // "GET <target> HTTP/1.1"
+    const size_t target_start = request.find(' ') + 1;
+    const size_t target_end = request.find(' ', target_start);
+    const std::string target = request.compare(0, 4, "GET ") == 0 && target_end != std::string::npos
+        ? request.substr(target_start, target_end - target_start)
+        : std::string();
+    auto it = responses_.find(target);
+    if (it == responses_.end()) {
+        const std::string not_found = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        client.send_all(not_found.data(), not_found.size());
+        return;
+    }
+
+    const std::string head = "HTTP/1.1 200 OK\r\n"
+        "Content-Type: " + it->second.content_type + "\r\n"
+        "Transfer-Encoding: chunked\r\n"
+        "Connection: close\r\n\r\n";
+    if (!client.send_all(head.data(), head.size())) {
+        return;
+    }
+
+    std::ifstream body(it->second.body, std::ios::binary);
+    std::vector<char> chunk(kChunkSize + 32);
+    const auto start = std::chrono::steady_clock::now();
+    uint64_t sent = 0;
+    for (;;) {
+        // Room is left in front for the chunk size line
+        char* data = chunk.data() + 16;
+        body.read(data, static_cast<std::streamsize>(kChunkSize));
+        const size_t size = static_cast<size_t>(body.gcount());
+        char size_line[16];
+        const int line_length = std::snprintf(size_line, sizeof(size_line), "%zx\r\n", size);
+        char* begin = data - line_length;
+        std::copy(size_line, size_line + line_length, begin);
+        data[size] = '\r';
+        data[size + 1] = '\n';
+        const size_t length = static_cast<size_t>(line_length) + size + 2;
+        if (size == 0) {
+            // Last chunk, no trailer
+            client.send_all("0\r\n\r\n", 5);
+            return;
+        }
+
+        if (config_.bytes_per_second > 0) {
+            std::this_thread::sleep_until(start + std::chrono::microseconds(sent * 1000000 / config_.bytes_per_second));
+        }
+        if (!client.send_all(begin, length)) {
+            return;   // the client stopped reading
+        }
+        sent += size;
+    }
+}
+
+TestDicomWebServer::TestDicomWebServer(TestDicomWebConfig config)
+    : impl_(std::make_unique<Impl>(std::move(config))) {
+}
+
+TestDicomWebServer::~TestDicomWebServer() {
+    stop();
+}
+
+Result<std::string, ErrorInfo> TestDicomWebServer::add_series(const std::vector<std::filesystem::path>& files) {
+    if (files.empty()) {
+        return ErrorInfo{ DicomError::FileNotFound, "No files for the recorded series", "" };
+    }
+    DcmFileFormat first;
+    if (first.loadFileUntilTag(files.front().string().c_str(), EXS_Unknown, EGL_noChange, DCM_MaxReadLength,
+            ERM_autoDetect, DCM_PixelData).bad()) {
+        return ErrorInfo{ DicomError::InvalidFormat, "Cannot read recorded instance", files.front().string() };
+    }
+    const std::string target = "/dicom-web/studies/" + dataset_string(first.getDataset(), DCM_StudyInstanceUID) +
+        "/series/" + dataset_string(first.getDataset(), DCM_SeriesInstanceUID);
+
+    std::error_code ec;
+    std::filesystem::create_directories(impl_->config_.storage_directory, ec);
+    const std::filesystem::path path = impl_->next_body_path();
+    MultipartWriter writer(path);
+    for (const auto& file : files) {
+        writer.begin_part("application/dicom", std::filesystem::file_size(file, ec));
+        writer.copy(file);
+        writer.end_part();
+    }
+    if (!writer.close()) {
+        return ErrorInfo{ DicomError::FileNotFound, "Cannot write recorded response", path.string() };
+    }
+
+    impl_->responses_[target] = RecordedResponse{ multipart_type("application/dicom"), path };
+    return impl_->url(target);
+}
+
+Result<std::string, ErrorInfo> TestDicomWebServer::add_frames(const std::filesystem::path& file,
+    const std::vector<uint32_t>& frame_numbers) {
+    DcmFileFormat file_format;
+    if (file_format.loadFile(file.string().c_str()).bad()) {
+        return ErrorInfo{ DicomError::InvalidFormat, "Cannot read recorded instance", file.string() };
+    }
+    DcmDataset* dataset = file_format.getDataset();
+    ensure_decoders(*dataset);
+    DcmElement* pixel_data = nullptr;
+    Uint32 frame_size = 0;
+    if (dataset->findAndGetElement(DCM_PixelData, pixel_data).bad() ||
+        pixel_data->getUncompressedFrameSize(dataset, frame_size, OFTrue).bad()) {
+        return ErrorInfo{ DicomError::MissingPixelData, "Recorded instance has no pixel data", file.string() };
+    }
+    const std::string instance_target = "/dicom-web/studies/" + dataset_string(dataset, DCM_StudyInstanceUID) +
+        "/series/" + dataset_string(dataset, DCM_SeriesInstanceUID) +
+        "/instances/" + dataset_string(dataset, DCM_SOPInstanceUID);
+    std::string target = instance_target + "/frames/";
+
+    std::error_code ec;
+    std::filesystem::create_directories(impl_->config_.storage_directory, ec);
+    const std::filesystem::path path = impl_->next_body_path();
+    MultipartWriter writer(path);
+    std::vector<char> frame(frame_size + (frame_size & 1));
+    for (size_t i = 0; i < frame_numbers.size(); ++i) {
+        Uint32 start_fragment = 0;
+        OFString color_model;
+        if (frame_numbers[i] == 0 || pixel_data->getUncompressedFrame(dataset, frame_numbers[i] - 1,
+                start_fragment, frame.data(), static_cast<Uint32>(frame.size()), color_model).bad()) {
+            return ErrorInfo{ DicomError::MissingPixelData, "No frame " + std::to_string(frame_numbers[i]),
+                             file.string() };
+        }
+        writer.begin_part("application/octet-stream", frame_size);
+        writer.write(frame.data(), frame_size);
+        writer.end_part();
+        target += (i == 0 ? "" : ",") + std::to_string(frame_numbers[i]);
+    }
+    if (!writer.close()) {
+        return ErrorInfo{ DicomError::FileNotFound, "Cannot write recorded response", path.string() };
+    }
+
+    impl_->responses_[target] = RecordedResponse{ multipart_type("application/octet-stream"), path };
+    return impl_->url(instance_target);
+}
+
+Result<bool, ErrorInfo> TestDicomWebServer::start() {
+    if (impl_->listener_.valid()) {
+        return ErrorInfo{ DicomError::NetworkError, "Test DICOMweb server is already running", "" };
+    }
+    auto listener = TcpSocket::listen(impl_->config_.port);
+    if (listener.is_error()) {
+        return listener.error();
+    }
+    impl_->listener_ = std::move(listener.value());
+
+    impl_->stopping_ = false;
+    impl_->thread_ = std::thread([impl = impl_.get()]() {
+        while (!impl->stopping_) {
+            auto client = impl->listener_.accept();
+            if (client.is_ok() && !impl->stopping_) {
+                impl->serve(client.value());
+            }
+        }
+    });
+
+    std::cout << "[DEBUG] Test DICOMweb server listening on port " << impl_->config_.port << std::endl;
+    return true;
+}
+
+void TestDicomWebServer::stop() {
+    if (!impl_->listener_.valid()) {
+        return;
+    }
+    impl_->stopping_ = true;
+
+    // Wakes the blocking accept
+    TcpSocket::connect("127.0.0.1", impl_->config_.port);
+
+    impl_->thread_.join();
+    impl_->listener_.close();
+    std::cout << "[DEBUG] Test DICOMweb server stopped" << std::endl;
+}
+
+std::string TestDicomWebServer::service_url() const {
+    return impl_->url("/dicom-web");
+}
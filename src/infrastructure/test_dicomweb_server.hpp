@@ -0,0 +1,48 @@
+#pragma once
+
+#include "core/error_codes.hpp"
+#include "core/result.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct TestDicomWebConfig {
+    uint16_t port = 8042;
+    std::filesystem::path storage_directory;   // recorded responses go here, created if missing
+    uint64_t bytes_per_second = 0;             // paces responses like a WAN link; 0 is loopback speed
+};
+
+// Stand-in for a DICOMweb server in benchmarks: answers GETs with responses
+// recorded beforehand, streamed from disk with chunked transfer coding, one
+// connection at a time, on a thread of its own.
+class TestDicomWebServer {
+    class Impl;
+    std::unique_ptr<Impl> impl_;
+
+public:
+    explicit TestDicomWebServer(TestDicomWebConfig config);
+    ~TestDicomWebServer();
+
+    TestDicomWebServer(const TestDicomWebServer&) = delete;
+    TestDicomWebServer& operator=(const TestDicomWebServer&) = delete;
+
+    // Records the WADO-RS response for the series the files belong to, as
+    // application/dicom parts in the given order. Returns the series URL.
+    // Call before start().
+    Result<std::string, ErrorInfo> add_series(const std::vector<std::filesystem::path>& files);
+
+    // Records the response for these frames of an uncompressed file, as
+    // application/octet-stream parts. Returns the instance URL. Call before start().
+    Result<std::string, ErrorInfo> add_frames(const std::filesystem::path& file,
+        const std::vector<uint32_t>& frame_numbers);
+
+    Result<bool, ErrorInfo> start();
+
+    // Finishes the response in progress, then stops listening
+    void stop();
+
+    // http://127.0.0.1:<port>/dicom-web
+    std::string service_url() const;
+};
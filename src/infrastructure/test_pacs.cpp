@@ -0,0 +1,189 @@
+#include "test_pacs.hpp"
+
+// DCMTK includes
+#include <dcmtk/dcmdata/dctk.h>
+#include <dcmtk/dcmnet/dcasccfg.h>
+#include <dcmtk/dcmnet/diutil.h>
+#include <dcmtk/dcmnet/scu.h>
+#include <dcmtk/dcmqrdb/dcmqrcnf.h>
+#include <dcmtk/dcmqrdb/dcmqrdbi.h>
+#include <dcmtk/dcmqrdb/dcmqrdbs.h>
+#include <dcmtk/dcmqrdb/dcmqropt.h>
+#include <dcmtk/dcmqrdb/dcmqrsrv.h>
+#include <dcmtk/dcmtls/tlsopt.h>
+
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+namespace {
+
+// Must agree between the configuration file and direct database access
+constexpr long kMaxStudies = 200;
+constexpr long kMaxBytesPerStudy = 1024l * 1024 * 1024;
+
+} // namespace
+
+class TestPacs::Impl {
+public:
+    TestPacsConfig config_;
+
+    // The SCP keeps references to all of these
+    DcmQueryRetrieveConfig qr_config_;
+    DcmQueryRetrieveOptions options_;
+    DcmAssociationConfiguration association_config_;
+    DcmTLSOptions tls_options_{ NET_ACCEPTORREQUESTOR };
+    std::unique_ptr<DcmQueryRetrieveIndexDatabaseHandleFactory> factory_;
+    std::unique_ptr<DcmQueryRetrieveSCP> scp_;
+
+    std::thread thread_;
+    std::atomic<bool> stopping_{ false };
+
+    explicit Impl(TestPacsConfig config) : config_(std::move(config)) {}
+
+    std::filesystem::path database_directory() const {
+        return std::filesystem::absolute(config_.storage_directory).lexically_normal();
+    }
+
+    // dcmqrdb is configured through a dcmqrscp.cfg style file only
+    Result<std::filesystem::path, ErrorInfo> write_config_file() const {
+        const std::filesystem::path path = database_directory() / "dcmqrscp.cfg";
+        std::ofstream file(path);
+        file << "NetworkTCPPort = " << config_.port << "\n"
+             << "MaxPDUSize = " << ASC_MAXIMUMPDUSIZE << "\n"
+             << "MaxAssociations = 16\n"
+             << "HostTable BEGIN\n";
+        for (size_t i = 0; i < config_.move_destinations.size(); ++i) {
+            const DicomPeer& destination = config_.move_destinations[i];
+            file << "destination" << i << " = (" << destination.called_ae_title << ", " << destination.host
+                 << ", " << destination.port << ")\n";
+        }
+        file << "HostTable END\n"
+             << "AETable BEGIN\n"
+             << config_.ae_title << " " << database_directory().string() << " RW (" << kMaxStudies << ", "
+             << kMaxBytesPerStudy / (1024 * 1024) << "mb) ANY\n"
+             << "AETable END\n";
+        if (!file) {
+            return ErrorInfo{ DicomError::FileNotFound, "Cannot write PACS configuration", path.string() };
+        }
+        return path;
+    }
+};
+
+TestPacs::TestPacs(TestPacsConfig config)
+    : impl_(std::make_unique<Impl>(std::move(config))) {
+}
+
+TestPacs::~TestPacs() {
+    stop();
+}
+
+Result<uint32_t, ErrorInfo> TestPacs::add_files(const std::vector<std::filesystem::path>& files) {
+    std::error_code ec;
+    std::filesystem::create_directories(impl_->database_directory(), ec);
+
+    OFCondition cond;
+    DcmQueryRetrieveIndexDatabaseHandle handle(impl_->database_directory().string().c_str(),
+        kMaxStudies, kMaxBytesPerStudy, cond);
+    if (cond.bad()) {
+        return ErrorInfo{ DicomError::FileNotFound, "Cannot open PACS database",
+                         impl_->database_directory().string() + ": " + cond.text() };
+    }
+    // Files are registered where they are; the quota would delete them
+    handle.enableQuotaSystem(OFFalse);
+
+    uint32_t added = 0;
+    for (const auto& file : files) {
+        const std::string path = std::filesystem::absolute(file).string();
+        char sop_class[128];
+        char sop_instance[128];
+        if (!DU_findSOPClassAndInstanceInFile(path.c_str(), sop_class, sizeof(sop_class),
+                sop_instance, sizeof(sop_instance))) {
+            continue;
+        }
+        DcmQueryRetrieveDatabaseStatus status;
+        if (handle.storeRequest(sop_class, sop_instance, path.c_str(), &status).good()) {
+            ++added;
+        }
+    }
+    return added;
+}
+
+Result<bool, ErrorInfo> TestPacs::start() {
+    if (impl_->scp_) {
+        return ErrorInfo{ DicomError::NetworkError, "Test PACS is already running", "" };
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(impl_->database_directory(), ec);
+    auto config_file = impl_->write_config_file();
+    if (config_file.is_error()) {
+        return config_file.error();
+    }
+    if (!impl_->qr_config_.init(config_file.value().string().c_str())) {
+        return ErrorInfo{ DicomError::InvalidFormat, "Invalid PACS configuration", config_file.value().string() };
+    }
+
+    // dcmqrdb and dcmnet log every request at INFO level
+    DCM_dcmnetLogger.setLogLevel(OFLogger::WARN_LOG_LEVEL);
+    DCM_dcmqrdbLogger.setLogLevel(OFLogger::WARN_LOG_LEVEL);
+
+    DcmQueryRetrieveOptions& options = impl_->options_;
+    options.singleProcess_ = OFTrue;
+    options.maxPDU_ = ASC_MAXIMUMPDUSIZE;
+    options.maxAssociations_ = impl_->qr_config_.getMaxAssociations();
+    OFCondition cond = ASC_initializeNetwork(NET_ACCEPTORREQUESTOR, impl_->config_.port,
+        options.acse_timeout_, &options.net_);
+    if (cond.bad()) {
+        return ErrorInfo{ DicomError::NetworkError,
+                         "Cannot listen on port " + std::to_string(impl_->config_.port), cond.text() };
+    }
+
+    impl_->factory_ = std::make_unique<DcmQueryRetrieveIndexDatabaseHandleFactory>(&impl_->qr_config_);
+    impl_->scp_ = std::make_unique<DcmQueryRetrieveSCP>(impl_->qr_config_, options, *impl_->factory_,
+        impl_->association_config_, impl_->tls_options_);
+
+    impl_->stopping_ = false;
+    impl_->thread_ = std::thread([impl = impl_.get()]() {
+        while (!impl->stopping_) {
+            impl->scp_->waitForAssociation(impl->options_.net_);
+        }
+    });
+
+    std::cout << "[DEBUG] Test PACS " << impl_->config_.ae_title << " listening on port "
+        << impl_->config_.port << std::endl;
+    return true;
+}
+
+void TestPacs::stop() {
+    if (!impl_->scp_) {
+        return;
+    }
+    impl_->stopping_ = true;
+
+    // The SCP waits up to 1000 s for an association; give it one to end the wait
+    DcmSCU scu;
+    scu.setPeerHostName("localhost");
+    scu.setPeerPort(impl_->config_.port);
+    scu.setPeerAETitle(impl_->config_.ae_title.c_str());
+    OFList<OFString> transfer_syntaxes;
+    transfer_syntaxes.push_back(UID_LittleEndianImplicitTransferSyntax);
+    scu.addPresentationContext(UID_VerificationSOPClass, transfer_syntaxes);
+    if (scu.initNetwork().good() && scu.negotiateAssociation().good()) {
+        scu.releaseAssociation();
+    }
+
+    impl_->thread_.join();
+    impl_->scp_.reset();
+    impl_->factory_.reset();
+    ASC_dropNetwork(&impl_->options_.net_);
+    std::cout << "[DEBUG] Test PACS stopped" << std::endl;
+}
+
+DicomPeer TestPacs::peer() const {
+    DicomPeer peer;
+    peer.port = impl_->config_.port;
+    peer.called_ae_title = impl_->config_.ae_title;
+    return peer;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "core/error_codes.hpp"
+#include "core/result.hpp"
+#include "dicom_peer.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct TestPacsConfig {
+    uint16_t port = 11114;
+    std::string ae_title = "TESTPACS";
+    std::filesystem::path storage_directory;     // holds the index database, created if missing
+    std::vector<DicomPeer> move_destinations;    // who C-MOVE may send to (called AE title, host, port)
+};
+
+// Stand-in for a PACS in benchmarks: DCMTK's Query/Retrieve SCP (dcmqrdb,
+// the engine of dcmqrscp) serving C-FIND, C-MOVE, C-GET and C-ECHO from an
+// index database, one association at a time, on a thread of its own.
+class TestPacs {
+    class Impl;
+    std::unique_ptr<Impl> impl_;
+
+public:
+    explicit TestPacs(TestPacsConfig config);
+    ~TestPacs();
+
+    TestPacs(const TestPacs&) = delete;
+    TestPacs& operator=(const TestPacs&) = delete;
+
+    // Registers files in the database where they lie, without copying them.
+    // Call before start(). Returns the number of files added.
+    Result<uint32_t, ErrorInfo> add_files(const std::vector<std::filesystem::path>& files);
+
+    Result<bool, ErrorInfo> start();
+
+    // Finishes the association in progress, then stops listening
+    void stop();
+
+    DicomPeer peer() const;
+};
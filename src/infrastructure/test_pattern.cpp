@@ -0,0 +1,534 @@
+#include "test_pattern.hpp"
+
+// DCMTK includes
+#include <dcmtk/dcmdata/dctk.h>
+#include <dcmtk/dcmdata/dcrleerg.h>
+#include <dcmtk/dcmdata/dcrlerp.h>
+#include <dcmtk/dcmfg/fgderimg.h>
+#include <dcmtk/dcmfg/fgfracon.h>
+#include <dcmtk/dcmfg/fgpixmsr.h>
+#include <dcmtk/dcmfg/fgplanor.h>
+#include <dcmtk/dcmfg/fgplanpo.h>
+#include <dcmtk/dcmjpeg/djencode.h>
+#include <dcmtk/dcmjpeg/djrplol.h>
+#include <dcmtk/dcmjpeg/djrploss.h>
+#include <dcmtk/dcmjpls/djencode.h>
+#include <dcmtk/dcmjpls/djrparam.h>
+#include <dcmtk/dcmseg/segdoc.h>
+#include <dcmtk/dcmseg/segment.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+void register_encoders() {
+    static std::once_flag once;
+    std::call_once(once, []() {
+        DcmRLEEncoderRegistration::registerCodecs();
+        DJEncoderRegistration::registerCodecs();
+        DJLSEncoderRegistration::registerCodecs();
+    });
+}
+
+template<typename T>
+void fill_frames(T* pixels, const TestPatternSpec& spec) {
+    const uint32_t max_value = (1u << (8 * sizeof(T))) - 1;
+    uint32_t noise = 12345;
+
+    for (uint32_t f = 0; f < spec.frames; ++f) {
+        for (uint32_t y = 0; y < spec.height; ++y) {
+            for (uint32_t x = 0; x < spec.width; ++x) {
+                noise = noise * 1103515245u + 12345u;
+                const uint32_t gradient = ((x + f * 4) * max_value / (spec.width + spec.frames * 4) +
+                    y * max_value / spec.height) / 2;
+                const uint32_t value = gradient + ((noise >> 16) & 0x7);
+                *pixels++ = static_cast<T>(value > max_value ? max_value : value);
+            }
+        }
+    }
+}
+
+// First frame sampled down to an 8-bit icon, as modalities embed them
+template<typename T>
+void insert_icon(DcmDataset* dataset, const T* pixels, const TestPatternSpec& spec) {
+    const uint32_t stride = std::max<uint32_t>(1,
+        (std::max(spec.width, spec.height) + spec.icon_size - 1) / spec.icon_size);
+    const uint32_t width = (spec.width + stride - 1) / stride;
+    const uint32_t height = (spec.height + stride - 1) / stride;
+    std::vector<Uint8> icon_pixels;
+    icon_pixels.reserve(static_cast<size_t>(width) * height);
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            const T value = pixels[static_cast<size_t>(y) * stride * spec.width + static_cast<size_t>(x) * stride];
+            icon_pixels.push_back(static_cast<Uint8>(value >> (8 * (sizeof(T) - 1))));
+        }
+    }
+
+    DcmItem* icon = nullptr;
+    if (dataset->findOrCreateSequenceItem(DCM_IconImageSequence, icon).bad() || !icon) {
+        return;
+    }
+    icon->putAndInsertUint16(DCM_SamplesPerPixel, 1);
+    icon->putAndInsertString(DCM_PhotometricInterpretation, "MONOCHROME2");
+    icon->putAndInsertUint16(DCM_Rows, static_cast<Uint16>(height));
+    icon->putAndInsertUint16(DCM_Columns, static_cast<Uint16>(width));
+    icon->putAndInsertUint16(DCM_BitsAllocated, 8);
+    icon->putAndInsertUint16(DCM_BitsStored, 8);
+    icon->putAndInsertUint16(DCM_HighBit, 7);
+    icon->putAndInsertUint16(DCM_PixelRepresentation, 0);
+    icon->putAndInsertUint8Array(DCM_PixelData, icon_pixels.data(), static_cast<unsigned long>(icon_pixels.size()));
+}
+
+DcmItem* new_macro_item(DcmItem& parent, const DcmTagKey& sequence) {
+    DcmItem* item = nullptr;
+    parent.findOrCreateSequenceItem(sequence, item, 0);
+    return item;
+}
+
+// Geometry shared by all frames, everything else per frame, as scanners write it
+void insert_functional_groups(DcmDataset* dataset, const TestPatternSpec& spec) {
+    DcmItem* shared = nullptr;
+    if (dataset->findOrCreateSequenceItem(DCM_SharedFunctionalGroupsSequence, shared, 0).bad() || !shared) {
+        return;
+    }
+    if (DcmItem* item = new_macro_item(*shared, DCM_PlaneOrientationSequence)) {
+        item->putAndInsertString(DCM_ImageOrientationPatient, "1\\0\\0\\0\\1\\0");
+    }
+    if (DcmItem* item = new_macro_item(*shared, DCM_PixelMeasuresSequence)) {
+        item->putAndInsertString(DCM_PixelSpacing, "0.5\\0.5");
+        item->putAndInsertString(DCM_SliceThickness, "1");
+    }
+
+    auto* per_frame = new DcmSequenceOfItems(DCM_PerFrameFunctionalGroupsSequence);
+    for (uint32_t f = 0; f < spec.frames; ++f) {
+        auto* frame = new DcmItem();
+        per_frame->append(frame);
+        if (DcmItem* item = new_macro_item(*frame, DCM_FrameContentSequence)) {
+            item->putAndInsertString(DCM_StackID, "1");
+            item->putAndInsertUint32(DCM_InStackPositionNumber, f + 1);
+        }
+        if (DcmItem* item = new_macro_item(*frame, DCM_PlanePositionSequence)) {
+            const std::string position = "0\\0\\" + std::to_string(f);
+            item->putAndInsertString(DCM_ImagePositionPatient, position.c_str());
+        }
+        if (DcmItem* item = new_macro_item(*frame, DCM_PixelValueTransformationSequence)) {
+            item->putAndInsertString(DCM_RescaleIntercept, "-1024");
+            item->putAndInsertString(DCM_RescaleSlope, "1");
+            item->putAndInsertString(DCM_RescaleType, "HU");
+        }
+        if (DcmItem* item = new_macro_item(*frame, DCM_FrameVOILUTSequence)) {
+            item->putAndInsertString(DCM_WindowCenter, std::to_string(40 + f % 8 * 10).c_str());
+            item->putAndInsertString(DCM_WindowWidth, "400");
+        }
+    }
+    dataset->insert(per_frame, OFTrue);
+}
+
+constexpr uint16_t kMaxOverlayPlanes = 16;
+
+// Whether pixel (x, y) is set in test overlay plane n
+bool overlay_pixel(uint32_t n, uint32_t x, uint32_t y, const TestPatternSpec& spec) {
+    const uint32_t x0 = spec.width / 16 + n * spec.width / 40;
+    const uint32_t y0 = spec.height / 16 + n * spec.height / 40;
+    const uint32_t x1 = spec.width - x0;
+    const uint32_t y1 = spec.height - y0;
+    const bool box = x >= x0 && x < x1 && y >= y0 && y < y1 &&
+        (x < x0 + 2 || x + 2 >= x1 || y < y0 + 2 || y + 2 >= y1);
+
+    // Ticks every 10 pixels, longer every 50, rising from a baseline
+    const uint32_t baseline = 4 * (n + 1);
+    if (spec.height <= baseline) return box;
+    const uint32_t ruler_y = spec.height - 1 - baseline;
+    const uint32_t tick = x % 50 == 0 ? 12 : 4;
+    const bool ruler = y == ruler_y || (x % 10 == 0 && y < ruler_y && y + tick >= ruler_y);
+    return box || ruler;
+}
+
+void insert_overlay_attributes(DcmDataset* dataset, Uint16 group, const TestPatternSpec& spec,
+    Uint16 bits_allocated, Uint16 bit_position, const char* label) {
+    const Sint16 origin[2] = { 1, 1 };
+    dataset->putAndInsertUint16(DcmTagKey(group, DCM_OverlayRows.getElement()), static_cast<Uint16>(spec.height));
+    dataset->putAndInsertUint16(DcmTagKey(group, DCM_OverlayColumns.getElement()), static_cast<Uint16>(spec.width));
+    dataset->putAndInsertString(DcmTagKey(group, DCM_OverlayType.getElement()), "G");
+    dataset->putAndInsertSint16Array(DcmTagKey(group, DCM_OverlayOrigin.getElement()), origin, 2);
+    dataset->putAndInsertUint16(DcmTagKey(group, DCM_OverlayBitsAllocated.getElement()), bits_allocated);
+    dataset->putAndInsertUint16(DcmTagKey(group, DCM_OverlayBitPosition.getElement()), bit_position);
+    dataset->putAndInsertString(DcmTagKey(group, DCM_OverlayLabel.getElement()), label);
+}
+
+// Overlay Data of each plane packed 16 pixels to a word, least significant bit first
+void insert_overlay_planes(DcmDataset* dataset, const TestPatternSpec& spec) {
+    const size_t pixel_count = static_cast<size_t>(spec.width) * spec.height;
+    for (uint16_t n = 0; n < spec.overlays; ++n) {
+        const Uint16 group = static_cast<Uint16>(0x6000 + 2 * n);
+        const std::string label = "Annotation " + std::to_string(n + 1);
+        insert_overlay_attributes(dataset, group, spec, 1, 0, label.c_str());
+
+        std::vector<Uint16> words((pixel_count + 15) / 16, 0);
+        for (uint32_t y = 0; y < spec.height; ++y) {
+            for (uint32_t x = 0; x < spec.width; ++x) {
+                if (!overlay_pixel(n, x, y, spec)) continue;
+                const size_t i = static_cast<size_t>(y) * spec.width + x;
+                words[i / 16] |= static_cast<Uint16>(1u << (i % 16));
+            }
+        }
+        auto* data = new DcmOtherByteOtherWord(DcmTag(group, DCM_OverlayData.getElement(), EVR_OW));
+        data->putUint16Array(words.data(), static_cast<unsigned long>(words.size()));
+        dataset->insert(data, OFTrue);
+    }
+}
+
+// Samples moved down to 12 bits with the next overlay plane in bit 15
+void embed_overlay(DcmDataset* dataset, Uint16* pixels, const TestPatternSpec& spec) {
+    const uint32_t n = spec.overlays;
+    for (uint32_t f = 0; f < spec.frames; ++f) {
+        for (uint32_t y = 0; y < spec.height; ++y) {
+            for (uint32_t x = 0; x < spec.width; ++x, ++pixels) {
+                *pixels = static_cast<Uint16>((*pixels >> 4) | (overlay_pixel(n, x, y, spec) ? 0x8000 : 0));
+            }
+        }
+    }
+    insert_overlay_attributes(dataset, static_cast<Uint16>(0x6000 + 2 * n), spec, 16, 15, "Embedded");
+    dataset->putAndInsertUint16(DCM_BitsStored, 12);
+    dataset->putAndInsertUint16(DCM_HighBit, 11);
+}
+
+const char* sop_class_uid(const TestPatternSpec& spec) {
+    return spec.enhanced ? UID_EnhancedCTImageStorage
+        : spec.bits_allocated == 8 ? UID_MultiframeGrayscaleByteSecondaryCaptureImageStorage
+        : UID_MultiframeGrayscaleWordSecondaryCaptureImageStorage;
+}
+
+} // namespace
+
+Result<std::filesystem::path, ErrorInfo>
+write_test_pattern(const std::filesystem::path& path, const TestPatternSpec& spec) {
+    if (spec.width == 0 || spec.height == 0 || spec.frames == 0 ||
+        (spec.bits_allocated != 8 && spec.bits_allocated != 16) ||
+        (spec.codec == PixelCodec::JpegBaseline && spec.bits_allocated != 8) ||
+        spec.overlays + (spec.embedded_overlay ? 1 : 0) > kMaxOverlayPlanes ||
+        (spec.embedded_overlay && (spec.bits_allocated != 16 || spec.codec != PixelCodec::Uncompressed))) {
+        return ErrorInfo{ DicomError::InvalidImageDimensions, "Invalid test pattern", "" };
+    }
+
+    register_encoders();
+
+    DcmFileFormat file_format;
+    DcmDataset* dataset = file_format.getDataset();
+
+    char uid[100];
+    const bool is_byte = (spec.bits_allocated == 8);
+
+    dataset->putAndInsertString(DCM_SOPClassUID, sop_class_uid(spec));
+    dataset->putAndInsertString(DCM_SOPInstanceUID, spec.sop_instance_uid.empty()
+        ? dcmGenerateUniqueIdentifier(uid, SITE_INSTANCE_UID_ROOT) : spec.sop_instance_uid.c_str());
+    dataset->putAndInsertString(DCM_StudyInstanceUID, spec.study_instance_uid.empty()
+        ? dcmGenerateUniqueIdentifier(uid, SITE_STUDY_UID_ROOT) : spec.study_instance_uid.c_str());
+    dataset->putAndInsertString(DCM_SeriesInstanceUID, spec.series_instance_uid.empty()
+        ? dcmGenerateUniqueIdentifier(uid, SITE_SERIES_UID_ROOT) : spec.series_instance_uid.c_str());
+    dataset->putAndInsertString(DCM_InstanceNumber, std::to_string(spec.instance_number).c_str());
+    dataset->putAndInsertString(DCM_PatientName, "Benchmark^Synthetic");
+    dataset->putAndInsertString(DCM_PatientID, "BENCHMARK");
+    dataset->putAndInsertString(DCM_Modality, spec.enhanced ? "CT" : "OT");
+    dataset->putAndInsertString(DCM_PhotometricInterpretation, "MONOCHROME2");
+    dataset->putAndInsertUint16(DCM_SamplesPerPixel, 1);
+    dataset->putAndInsertUint16(DCM_Rows, static_cast<Uint16>(spec.height));
+    dataset->putAndInsertUint16(DCM_Columns, static_cast<Uint16>(spec.width));
+    dataset->putAndInsertUint16(DCM_BitsAllocated, spec.bits_allocated);
+    dataset->putAndInsertUint16(DCM_BitsStored, spec.bits_allocated);
+    dataset->putAndInsertUint16(DCM_HighBit, spec.bits_allocated - 1);
+    dataset->putAndInsertUint16(DCM_PixelRepresentation, 0);
+    dataset->putAndInsertString(DCM_NumberOfFrames, std::to_string(spec.frames).c_str());
+    if (spec.enhanced) {
+        insert_functional_groups(dataset, spec);
+    }
+    insert_overlay_planes(dataset, spec);
+
+    const size_t sample_count = static_cast<size_t>(spec.width) * spec.height * spec.frames;
+    OFCondition status;
+    if (is_byte) {
+        std::vector<Uint8> pixels(sample_count);
+        fill_frames(pixels.data(), spec);
+        if (spec.icon_size > 0) {
+            insert_icon(dataset, pixels.data(), spec);
+        }
+        status = dataset->putAndInsertUint8Array(DCM_PixelData, pixels.data(),
+            static_cast<unsigned long>(pixels.size()));
+    }
+    else {
+        std::vector<Uint16> pixels(sample_count);
+        fill_frames(pixels.data(), spec);
+        if (spec.embedded_overlay) {
+            embed_overlay(dataset, pixels.data(), spec);
+        }
+        if (spec.icon_size > 0) {
+            insert_icon(dataset, pixels.data(), spec);
+        }
+        status = dataset->putAndInsertUint16Array(DCM_PixelData, pixels.data(),
+            static_cast<unsigned long>(pixels.size()));
+    }
+
+    if (status.bad()) {
+        return ErrorInfo{ DicomError::MemoryAllocationFailed, "Failed to create pixel data", status.text() };
+    }
+
+    E_TransferSyntax xfer = EXS_LittleEndianExplicit;
+    switch (spec.codec) {
+        case PixelCodec::Rle: {
+            xfer = EXS_RLELossless;
+            DcmRLERepresentationParameter param;
+            status = dataset->chooseRepresentation(xfer, &param);
+            break;
+        }
+        case PixelCodec::JpegLossless: {
+            xfer = EXS_JPEGProcess14SV1;
+            DJ_RPLossless param;
+            status = dataset->chooseRepresentation(xfer, &param);
+            break;
+        }
+        case PixelCodec::JpegLsLossless: {
+            xfer = EXS_JPEGLSLossless;
+            DJLSRepresentationParameter param(2, OFTrue);
+            status = dataset->chooseRepresentation(xfer, &param);
+            break;
+        }
+        case PixelCodec::JpegBaseline: {
+            xfer = EXS_JPEGProcess1;
+            DJ_RPLossy param(90);
+            status = dataset->chooseRepresentation(xfer, &param);
+            break;
+        }
+        default:
+            break;
+    }
+
+    if (status.bad() || !dataset->canWriteXfer(xfer)) {
+        return ErrorInfo{ DicomError::UnsupportedTransferSyntax, "Failed to encode test pattern",
+                         std::string(codec_name(spec.codec)) };
+    }
+
+    status = file_format.saveFile(path.string().c_str(), xfer);
+    if (status.bad()) {
+        return ErrorInfo{ DicomError::FileNotFound, "Failed to write test pattern", status.text() };
+    }
+
+    return path;
+}
+
+Result<std::filesystem::path, ErrorInfo>
+write_test_segmentation(const std::filesystem::path& path, const TestPatternSpec& source, uint16_t segments) {
+    if (source.width == 0 || source.height == 0 || source.width > 0xFFFF || source.height > 0xFFFF ||
+        source.frames == 0 || source.frames > 0xFFFF || segments == 0 || source.sop_instance_uid.empty()) {
+        return ErrorInfo{ DicomError::InvalidImageDimensions, "Invalid test segmentation", "" };
+    }
+
+    IODGeneralEquipmentModule::EquipmentInfo equipment("DICOM Viewer", "Benchmark", "1", "1.0");
+    ContentIdentificationMacro content("1", "BENCHMARK", "Synthetic segments", "Benchmark^Synthetic");
+    DcmSegmentation* created = nullptr;
+    OFCondition status = DcmSegmentation::createBinarySegmentation(created,
+        static_cast<Uint16>(source.height), static_cast<Uint16>(source.width), equipment, content);
+    std::unique_ptr<DcmSegmentation> seg(created);
+    if (status.bad() || !seg) {
+        return ErrorInfo{ DicomError::MemoryAllocationFailed, "Failed to create segmentation", status.text() };
+    }
+    seg->setCheckFGOnWrite(OFFalse);
+    seg->setCheckDimensionsOnWrite(OFFalse);
+    seg->getPatient().setPatientName("Benchmark^Synthetic");
+    seg->getPatient().setPatientID("BENCHMARK");
+    if (!source.study_instance_uid.empty()) {
+        seg->getStudy().setStudyInstanceUID(source.study_instance_uid.c_str());
+    }
+    seg->getSeries().setSeriesNumber("99");
+    seg->getFrameOfReference().setFrameOfReferenceUID(make_test_uid().c_str());
+
+    FGPixelMeasures measures;
+    measures.setPixelSpacing("0.5\\0.5");
+    measures.setSliceThickness("1");
+    FGPlaneOrientationPatient orientation;
+    orientation.setImageOrientationPatient("1", "0", "0", "0", "1", "0");
+    seg->addForAllFrames(measures);
+    seg->addForAllFrames(orientation);
+
+    // Frames are organized by stack position, one stack per segment
+    const std::string organization = make_test_uid();
+    IODMultiframeDimensionModule& dimensions = seg->getDimensions();
+    dimensions.addDimensionIndex(DCM_StackID, organization.c_str(), DCM_FrameContentSequence, "STACK");
+    dimensions.addDimensionIndex(DCM_InStackPositionNumber, organization.c_str(), DCM_FrameContentSequence, "STACK");
+    auto* organization_item = new IODMultiframeDimensionModule::DimensionOrganizationItem;
+    organization_item->setDimensionOrganizationUID(organization.c_str());
+    dimensions.getDimensionOrganizationSequence().push_back(organization_item);
+
+    for (uint16_t s = 0; s < segments; ++s) {
+        DcmSegment* segment = nullptr;
+        const std::string label = "Segment " + std::to_string(s + 1);
+        DcmSegment::create(segment, label.c_str(), CodeSequenceMacro("85756007", "SCT", "Tissue"),
+            CodeSequenceMacro("4147007", "SCT", "Mass"), DcmSegTypes::SAT_AUTOMATIC, "Benchmark");
+        Uint16 number = 0;
+        if (!segment || seg->addSegment(segment, number).bad()) {
+            delete segment;
+            return ErrorInfo{ DicomError::MemoryAllocationFailed, "Failed to add segment", label };
+        }
+    }
+
+    // Disks of a quarter of the shorter side, spread around the center and
+    // drifting one pixel per frame
+    const double radius = std::min(source.width, source.height) / 4.0;
+    std::vector<Uint8> pixels(static_cast<size_t>(source.width) * source.height);
+    const char* source_class = sop_class_uid(source);
+    for (uint32_t f = 0; f < source.frames; ++f) {
+        ImageSOPInstanceReferenceMacro* reference = nullptr;
+        ImageSOPInstanceReferenceMacro::create(source_class, source.sop_instance_uid.c_str(), reference);
+        std::unique_ptr<ImageSOPInstanceReferenceMacro> owned(reference);
+        // Added as text: the frame list setter stores binary values, which
+        // the Integer String element rejects
+        if (!reference || reference->addReferencedFrameNumber(static_cast<Uint16>(f + 1)).bad()) {
+            return ErrorInfo{ DicomError::MemoryAllocationFailed, "Failed to reference source frame", "" };
+        }
+        std::unique_ptr<FGDerivationImage> derivation(FGDerivationImage::createMinimal(
+            OFVector<ImageSOPInstanceReferenceMacro>(1, *reference), "Synthetic segments",
+            CodeSequenceMacro("113076", "DCM", "Segmentation"),
+            CodeSequenceMacro("121322", "DCM", "Source image for image processing operation")));
+        FGFrameContent content_group;
+        content_group.setStackID("1");
+        content_group.setInStackPositionNumber(f + 1);
+        content_group.setDimensionIndexValues(1, 0);
+        content_group.setDimensionIndexValues(f + 1, 1);
+        FGPlanePosPatient position;
+        position.setImagePositionPatient("0", "0", std::to_string(f).c_str());
+        OFVector<FGBase*> groups;
+        groups.push_back(&content_group);
+        groups.push_back(&position);
+        if (derivation) groups.push_back(derivation.get());
+
+        for (uint16_t s = 0; s < segments; ++s) {
+            const double angle = 6.283185307179586 * s / segments;
+            const double cx = source.width / 2.0 + radius * 0.6 * std::cos(angle) + f % 32;
+            const double cy = source.height / 2.0 + radius * 0.6 * std::sin(angle);
+            for (uint32_t y = 0; y < source.height; ++y) {
+                for (uint32_t x = 0; x < source.width; ++x) {
+                    const double dx = x + 0.5 - cx;
+                    const double dy = y + 0.5 - cy;
+                    pixels[static_cast<size_t>(y) * source.width + x] = dx * dx + dy * dy <= radius * radius ? 1 : 0;
+                }
+            }
+            status = seg->addFrame(pixels.data(), static_cast<Uint16>(s + 1), groups);
+            if (status.bad()) {
+                return ErrorInfo{ DicomError::MemoryAllocationFailed, "Failed to add segmentation frame",
+                                 status.text() };
+            }
+        }
+    }
+
+    status = seg->saveFile(path.string().c_str(), EXS_LittleEndianExplicit);
+    if (status.bad()) {
+        return ErrorInfo{ DicomError::FileNotFound, "Failed to write test segmentation", status.text() };
+    }
+    return path;
+}
+
+Result<std::filesystem::path, ErrorInfo>
+write_test_structure_set(const std::filesystem::path& path, uint32_t structures, uint32_t slices,
+    double slice_spacing_mm, double field_mm, uint32_t points) {
+    if (structures == 0 || slices == 0 || points < 3 || !(slice_spacing_mm > 0) || !(field_mm > 0)) {
+        return ErrorInfo{ DicomError::InvalidImageDimensions, "Invalid test structure set", "" };
+    }
+
+    DcmFileFormat file_format;
+    DcmDataset* dataset = file_format.getDataset();
+    const std::string frame_of_reference = make_test_uid();
+    dataset->putAndInsertString(DCM_SOPClassUID, UID_RTStructureSetStorage);
+    dataset->putAndInsertString(DCM_SOPInstanceUID, make_test_uid().c_str());
+    dataset->putAndInsertString(DCM_StudyInstanceUID, make_test_uid().c_str());
+    dataset->putAndInsertString(DCM_SeriesInstanceUID, make_test_uid().c_str());
+    dataset->putAndInsertString(DCM_Modality, "RTSTRUCT");
+    dataset->putAndInsertString(DCM_PatientName, "Benchmark^Synthetic");
+    dataset->putAndInsertString(DCM_PatientID, "BENCHMARK");
+    dataset->putAndInsertString(DCM_Manufacturer, "DICOM Viewer");
+    dataset->putAndInsertString(DCM_SeriesNumber, "98");
+    dataset->putAndInsertString(DCM_InstanceNumber, "1");
+    dataset->putAndInsertString(DCM_StructureSetLabel, "BENCHMARK");
+    dataset->putAndInsertString(DCM_StructureSetDate, "20240101");
+    dataset->putAndInsertString(DCM_StructureSetTime, "120000");
+    if (DcmItem* item = new_macro_item(*dataset, DCM_ReferencedFrameOfReferenceSequence)) {
+        item->putAndInsertString(DCM_FrameOfReferenceUID, frame_of_reference.c_str());
+    }
+
+    // Square grid of cells over the field, one structure per cell
+    const uint32_t columns = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(structures))));
+    const double cell = field_mm / columns;
+    const double two_pi = 6.283185307179586;
+    std::string data;
+    auto contour_item = [&](DcmSequenceOfItems* sequence, double cx, double cy, double rx, double ry, double z) {
+        data.clear();
+        char value[64];
+        for (uint32_t p = 0; p < points; ++p) {
+            const double angle = two_pi * p / points;
+            std::snprintf(value, sizeof(value), "%s%.2f\\%.2f\\%.2f", p == 0 ? "" : "\\",
+                cx + rx * std::cos(angle), cy + ry * std::sin(angle), z);
+            data += value;
+        }
+        auto* item = new DcmItem();
+        sequence->append(item);
+        item->putAndInsertString(DCM_ContourGeometricType, "CLOSED_PLANAR");
+        item->putAndInsertString(DCM_NumberOfContourPoints, std::to_string(points).c_str());
+        item->putAndInsertOFStringArray(DCM_ContourData, data.c_str());
+    };
+
+    auto* rois = new DcmSequenceOfItems(DCM_StructureSetROISequence);
+    auto* roi_contours = new DcmSequenceOfItems(DCM_ROIContourSequence);
+    auto* observations = new DcmSequenceOfItems(DCM_RTROIObservationsSequence);
+    for (uint32_t s = 0; s < structures; ++s) {
+        const std::string number = std::to_string(s + 1);
+        auto* roi = new DcmItem();
+        rois->append(roi);
+        roi->putAndInsertString(DCM_ROINumber, number.c_str());
+        roi->putAndInsertString(DCM_ReferencedFrameOfReferenceUID, frame_of_reference.c_str());
+        roi->putAndInsertString(DCM_ROIName, ("Structure " + number).c_str());
+        roi->putAndInsertString(DCM_ROIGenerationAlgorithm, "AUTOMATIC");
+
+        auto* roi_contour = new DcmItem();
+        roi_contours->append(roi_contour);
+        const std::string color = std::to_string(s * 97 % 256) + "\\" + std::to_string(255 - s * 53 % 200) +
+            "\\" + std::to_string(s * 151 % 256);
+        roi_contour->putAndInsertString(DCM_ROIDisplayColor, color.c_str());
+        roi_contour->putAndInsertString(DCM_ReferencedROINumber, number.c_str());
+        auto* contours = new DcmSequenceOfItems(DCM_ContourSequence);
+        const double cx = (s % columns + 0.5) * cell;
+        const double cy = (s / columns + 0.5) * cell;
+        for (uint32_t k = 0; k < slices; ++k) {
+            const double scale = 0.3 + 0.1 * std::sin(two_pi * (k + s * 7) / 64.0);
+            const double z = k * slice_spacing_mm;
+            contour_item(contours, cx, cy, cell * scale, cell * scale * 0.8, z);
+            if (s % 3 == 2) {
+                contour_item(contours, cx, cy, cell * scale * 0.4, cell * scale * 0.3, z);
+            }
+        }
+        roi_contour->insert(contours, OFTrue);
+
+        auto* observation = new DcmItem();
+        observations->append(observation);
+        observation->putAndInsertString(DCM_ObservationNumber, number.c_str());
+        observation->putAndInsertString(DCM_ReferencedROINumber, number.c_str());
+        observation->putAndInsertString(DCM_RTROIInterpretedType, "ORGAN");
+        observation->putAndInsertString(DCM_ROIInterpreter, "");
+    }
+    dataset->insert(rois, OFTrue);
+    dataset->insert(roi_contours, OFTrue);
+    dataset->insert(observations, OFTrue);
+
+    OFCondition status = file_format.saveFile(path.string().c_str(), EXS_LittleEndianExplicit);
+    if (status.bad()) {
+        return ErrorInfo{ DicomError::FileNotFound, "Failed to write test structure set", status.text() };
+    }
+    return path;
+}
+
+std::string make_test_uid() {
+    char uid[100];
+    return dcmGenerateUniqueIdentifier(uid, SITE_INSTANCE_UID_ROOT);
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "core/result.hpp"
+#include "core/error_codes.hpp"
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+enum class PixelCodec {
+    Uncompressed,
+    Rle,
+    JpegLossless,
+    JpegLsLossless,
+    JpegBaseline   // lossy, 8-bit only
+};
+
+constexpr std::string_view codec_name(PixelCodec codec) {
+    switch (codec) {
+        case PixelCodec::Uncompressed: return "Uncompressed";
+        case PixelCodec::Rle: return "RLE";
+        case PixelCodec::JpegLossless: return "JPEG Lossless";
+        case PixelCodec::JpegLsLossless: return "JPEG-LS Lossless";
+        case PixelCodec::JpegBaseline: return "JPEG Baseline";
+        default: return "Unknown";
+    }
+}
+
+struct TestPatternSpec {
+    uint32_t width;
+    uint32_t height;
+    uint32_t frames;
+    uint16_t bits_allocated;   // 8 or 16
+    PixelCodec codec;
+    // Set to put several objects in one study or series; generated when empty
+    std::string study_instance_uid = {};
+    std::string series_instance_uid = {};
+    int32_t instance_number = 1;
+    uint32_t icon_size = 0;    // longest side of an 8-bit Icon Image Sequence; none when 0
+    // Enhanced CT with Shared and Per-Frame Functional Groups: axial frames
+    // 1 mm apart, a per-frame rescale and a window that changes every frame
+    bool enhanced = false;
+    std::string sop_instance_uid = {};   // generated when empty
+    // Overlay planes in groups 6000, 6002, ...: a box outline, inset
+    // further for each plane, and a ruler along the bottom edge
+    uint16_t overlays = 0;
+    // One more overlay embedded in bit 15 of the pixel data, which is then
+    // stored in 12 bits; needs 16-bit uncompressed pixels
+    bool embedded_overlay = false;
+};
+
+// Write a synthetic multi-frame grayscale object (gradient plus noise, shifted per frame)
+// encoded with the requested codec. Used by the command line benchmarks.
+Result<std::filesystem::path, ErrorInfo>
+    write_test_pattern(const std::filesystem::path& path, const TestPatternSpec& spec);
+
+// Write a binary DICOM SEG over a test pattern written with the same spec
+// (which must name its SOP Instance UID): segments disks that drift from
+// frame to frame and partly overlap, one SEG frame per segment and source
+// frame, each referencing its source frame.
+Result<std::filesystem::path, ErrorInfo>
+    write_test_segmentation(const std::filesystem::path& path, const TestPatternSpec& source, uint16_t segments);
+
+// Write an RT Structure Set of structures elliptical ROIs on a grid over a
+// field_mm square of axial slices at z = k * slice_spacing_mm, one closed
+// planar contour of the given number of points per structure and slice,
+// swelling and shrinking from slice to slice. Every third structure also
+// has an inner contour, a hole.
+Result<std::filesystem::path, ErrorInfo>
+    write_test_structure_set(const std::filesystem::path& path, uint32_t structures, uint32_t slices,
+        double slice_spacing_mm, double field_mm, uint32_t points);
+
+// A new unique UID, for test patterns that share a study or series
+std::string make_test_uid();
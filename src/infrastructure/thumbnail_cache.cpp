@@ -0,0 +1,233 @@
+#include "thumbnail_cache.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+constexpr char kMagic[4] = { 'D', 'V', 'T', 'C' };
+constexpr uint32_t kVersion = 1;
+constexpr size_t kUidCapacity = 72;
+constexpr const char* kPackName = "thumbnails.dvtc";
+
+// Thumbnails are small; larger ones are not worth a pack entry
+constexpr uint32_t kMaxDimension = 1024;
+
+struct RecordHeader {
+    char magic[4];
+    uint32_t version;
+    char sop_instance_uid[kUidCapacity];
+    uint64_t fingerprint;
+    uint32_t width;
+    uint32_t height;
+    uint32_t source_width;
+    uint32_t source_height;
+    uint8_t rgb;
+    uint8_t reserved[7];
+};
+
+uint64_t record_bytes(uint64_t pixel_bytes) {
+    return sizeof(RecordHeader) + pixel_bytes;
+}
+
+} // namespace
+
+ThumbnailCache::ThumbnailCache(ThumbnailCacheConfig config)
+    : config_(std::move(config)), pack_path_(config_.directory / kPackName) {
+    std::error_code ec;
+    std::filesystem::create_directories(config_.directory, ec);
+    if (!std::filesystem::exists(pack_path_, ec)) {
+        std::ofstream create(pack_path_, std::ios::binary);
+    }
+    pack_.open(pack_path_, std::ios::binary | std::ios::in | std::ios::out);
+    scan_pack();
+}
+
+void ThumbnailCache::scan_pack() {
+    std::lock_guard lock(mutex_);
+    entries_.clear();
+    live_bytes_ = 0;
+
+    std::error_code ec;
+    const uint64_t file_bytes = std::filesystem::file_size(pack_path_, ec);
+    uint64_t offset = 0;
+    RecordHeader header;
+    pack_.seekg(0);
+    while (offset + sizeof(header) <= file_bytes &&
+           pack_.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+        if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion ||
+            header.sop_instance_uid[kUidCapacity - 1] != '\0') {
+            break;
+        }
+        Entry entry{ offset, header.fingerprint, header.width, header.height,
+                     header.source_width, header.source_height, header.rgb != 0 };
+        const uint64_t bytes = record_bytes(entry.pixel_bytes());
+        if (offset + bytes > file_bytes) {
+            break;
+        }
+
+        // Later records replace earlier ones of the same instance
+        auto [it, inserted] = entries_.try_emplace(header.sop_instance_uid, entry);
+        if (!inserted) {
+            live_bytes_ -= record_bytes(it->second.pixel_bytes());
+            it->second = entry;
+        }
+        live_bytes_ += bytes;
+        offset += bytes;
+        pack_.seekg(static_cast<std::streamoff>(offset));
+    }
+    pack_.clear();
+
+    // A record cut short by a crash is dropped
+    if (offset < file_bytes) {
+        pack_.close();
+        std::filesystem::resize_file(pack_path_, offset, ec);
+        pack_.open(pack_path_, std::ios::binary | std::ios::in | std::ios::out);
+        std::cout << "[DEBUG] Thumbnail cache dropped " << file_bytes - offset << " bytes of a damaged pack" << std::endl;
+    }
+    pack_bytes_ = offset;
+
+    if (pack_bytes_ > config_.max_bytes) {
+        compact_locked(config_.max_bytes * 3 / 4);
+    }
+}
+
+std::optional<Thumbnail> ThumbnailCache::lookup(const std::string& sop_instance_uid, uint64_t fingerprint) {
+    std::lock_guard lock(mutex_);
+    auto it = entries_.find(sop_instance_uid);
+    if (it == entries_.end() || it->second.fingerprint != fingerprint) {
+        return std::nullopt;
+    }
+
+    const Entry& entry = it->second;
+    Thumbnail thumbnail;
+    thumbnail.width = entry.width;
+    thumbnail.height = entry.height;
+    thumbnail.source_width = entry.source_width;
+    thumbnail.source_height = entry.source_height;
+    thumbnail.rgb = entry.rgb;
+    thumbnail.pixels.resize(entry.pixel_bytes());
+    pack_.seekg(static_cast<std::streamoff>(entry.offset + sizeof(RecordHeader)));
+    if (!pack_.read(reinterpret_cast<char*>(thumbnail.pixels.data()),
+            static_cast<std::streamsize>(thumbnail.pixels.size()))) {
+        pack_.clear();
+        return std::nullopt;
+    }
+    return thumbnail;
+}
+
+bool ThumbnailCache::store(const std::string& sop_instance_uid, uint64_t fingerprint, const Thumbnail& thumbnail) {
+    const uint64_t pixel_bytes = static_cast<uint64_t>(thumbnail.width) * thumbnail.height * (thumbnail.rgb ? 3 : 1);
+    if (sop_instance_uid.empty() || sop_instance_uid.size() >= kUidCapacity || thumbnail.pixels.size() != pixel_bytes ||
+        pixel_bytes == 0 || thumbnail.width > kMaxDimension || thumbnail.height > kMaxDimension ||
+        record_bytes(pixel_bytes) > config_.max_bytes) {
+        return false;
+    }
+
+    RecordHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    std::memcpy(header.sop_instance_uid, sop_instance_uid.data(), sop_instance_uid.size());
+    header.fingerprint = fingerprint;
+    header.width = thumbnail.width;
+    header.height = thumbnail.height;
+    header.source_width = thumbnail.source_width;
+    header.source_height = thumbnail.source_height;
+    header.rgb = thumbnail.rgb ? 1 : 0;
+
+    std::lock_guard lock(mutex_);
+    if (!pack_.is_open()) {
+        return false;
+    }
+    pack_.seekp(static_cast<std::streamoff>(pack_bytes_));
+    pack_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    pack_.write(reinterpret_cast<const char*>(thumbnail.pixels.data()), static_cast<std::streamsize>(pixel_bytes));
+    pack_.flush();
+    if (!pack_) {
+        pack_.clear();
+        return false;
+    }
+
+    Entry entry{ pack_bytes_, fingerprint, thumbnail.width, thumbnail.height,
+                 thumbnail.source_width, thumbnail.source_height, thumbnail.rgb };
+    auto [it, inserted] = entries_.try_emplace(sop_instance_uid, entry);
+    if (!inserted) {
+        live_bytes_ -= record_bytes(it->second.pixel_bytes());
+        it->second = entry;
+    }
+    live_bytes_ += record_bytes(pixel_bytes);
+    pack_bytes_ += record_bytes(pixel_bytes);
+
+    // Replaced records are garbage; rewrite once they are half the pack
+    if (pack_bytes_ > config_.max_bytes || pack_bytes_ - live_bytes_ > std::max<uint64_t>(live_bytes_, 1024 * 1024)) {
+        compact_locked(std::min(config_.max_bytes * 3 / 4, live_bytes_));
+    }
+    return true;
+}
+
+void ThumbnailCache::compact_locked(uint64_t target_bytes) {
+    // Newest entries are kept first
+    std::vector<std::pair<std::string, Entry>> kept(entries_.begin(), entries_.end());
+    std::sort(kept.begin(), kept.end(),
+        [](const auto& a, const auto& b) { return a.second.offset > b.second.offset; });
+    uint64_t kept_bytes = 0;
+    size_t count = 0;
+    while (count < kept.size() && kept_bytes + record_bytes(kept[count].second.pixel_bytes()) <= target_bytes) {
+        kept_bytes += record_bytes(kept[count].second.pixel_bytes());
+        ++count;
+    }
+    kept.resize(count);
+    std::reverse(kept.begin(), kept.end());
+
+    auto tmp_path = pack_path_;
+    tmp_path += ".tmp";
+    std::unordered_map<std::string, Entry> entries;
+    uint64_t offset = 0;
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        std::vector<char> record;
+        for (auto& [uid, entry] : kept) {
+            record.resize(record_bytes(entry.pixel_bytes()));
+            pack_.seekg(static_cast<std::streamoff>(entry.offset));
+            if (!pack_.read(record.data(), static_cast<std::streamsize>(record.size()))) {
+                pack_.clear();
+                continue;
+            }
+            out.write(record.data(), static_cast<std::streamsize>(record.size()));
+            entry.offset = offset;
+            offset += record.size();
+            entries.emplace(uid, entry);
+        }
+        if (!out) {
+            std::error_code ec;
+            std::filesystem::remove(tmp_path, ec);
+            return;
+        }
+    }
+
+    pack_.close();
+    std::error_code ec;
+    std::filesystem::rename(tmp_path, pack_path_, ec);
+    pack_.open(pack_path_, std::ios::binary | std::ios::in | std::ios::out);
+    if (ec) {
+        std::filesystem::remove(tmp_path, ec);
+        return;
+    }
+
+    std::cout << "[DEBUG] Thumbnail cache compacted " << entries_.size() << " entries, "
+        << pack_bytes_ / 1024 << " KB to " << entries.size() << " entries, " << offset / 1024 << " KB" << std::endl;
+    entries_ = std::move(entries);
+    pack_bytes_ = offset;
+    live_bytes_ = offset;
+}
+
+size_t ThumbnailCache::entry_count() const {
+    std::lock_guard lock(mutex_);
+    return entries_.size();
+}
+
+uint64_t ThumbnailCache::size_bytes() const {
+    std::lock_guard lock(mutex_);
+    return pack_bytes_;
+}
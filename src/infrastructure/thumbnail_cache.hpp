@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct Thumbnail {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t source_width = 0;
+    uint32_t source_height = 0;
+    bool rgb = false;
+    std::vector<uint8_t> pixels;   // windowed Gray8, or Rgb8 when rgb
+};
+
+struct ThumbnailCacheConfig {
+    std::filesystem::path directory;
+    uint64_t max_bytes;
+};
+
+// Persistent cache of windowed thumbnails keyed by SOP Instance UID. All
+// entries live in one append-only pack file with an in-memory index, so a
+// study of thousands of thumbnails costs one file rather than thousands of
+// small ones. Past the size bound the pack is rewritten without the oldest
+// entries and without replaced ones.
+class ThumbnailCache {
+public:
+    explicit ThumbnailCache(ThumbnailCacheConfig config);
+
+    ThumbnailCache(const ThumbnailCache&) = delete;
+    ThumbnailCache& operator=(const ThumbnailCache&) = delete;
+
+    // The fingerprint is that of the source file (PixelCache::fingerprint);
+    // a changed file misses
+    std::optional<Thumbnail> lookup(const std::string& sop_instance_uid, uint64_t fingerprint);
+
+    bool store(const std::string& sop_instance_uid, uint64_t fingerprint, const Thumbnail& thumbnail);
+
+    size_t entry_count() const;
+    uint64_t size_bytes() const;
+    const ThumbnailCacheConfig& config() const { return config_; }
+
+private:
+    struct Entry {
+        uint64_t offset;   // of the record header in the pack
+        uint64_t fingerprint;
+        uint32_t width;
+        uint32_t height;
+        uint32_t source_width;
+        uint32_t source_height;
+        bool rgb;
+
+        uint64_t pixel_bytes() const { return static_cast<uint64_t>(width) * height * (rgb ? 3 : 1); }
+    };
+
+    ThumbnailCacheConfig config_;
+    std::filesystem::path pack_path_;
+    std::fstream pack_;
+    std::unordered_map<std::string, Entry> entries_;
+    uint64_t pack_bytes_ = 0;
+    uint64_t live_bytes_ = 0;
+    mutable std::mutex mutex_;
+
+    void scan_pack();
+    void compact_locked(uint64_t target_bytes);
+};
@@ -0,0 +1,185 @@
+#include "tiled_reader.hpp"
+
+// DCMTK includes
+#include <dcmtk/dcmdata/dctk.h>
+#include <dcmtk/dcmdata/dcfcache.h>
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+// Open file plus what is needed to turn raw rows into normalized samples.
+// Tiles may be requested from several threads; DCMTK element access is not
+// thread-safe, so reads are serialized.
+struct TileFile {
+    DcmFileFormat file_format;
+    DcmElement* pixel_element = nullptr;
+    DcmFileCache file_cache;
+    std::mutex mutex;
+
+    uint32_t columns = 0;
+    size_t bytes_per_sample = 2;
+    std::vector<uint16_t> lut;   // raw sample -> normalized value
+};
+
+} // namespace
+
+Result<ImageData, ErrorInfo>
+load_tiled_image(const std::filesystem::path& path, uint32_t tile_size) {
+    auto file = std::make_shared<TileFile>();
+
+    // Values above the default lazy threshold (pixel data) stay on disk
+    OFCondition status = file->file_format.loadFile(path.string().c_str());
+    if (status.bad()) {
+        return ErrorInfo{ DicomError::InvalidFormat, "Failed to load DICOM file", status.text() };
+    }
+
+    DcmDataset* dataset = file->file_format.getDataset();
+
+    OFString photometric_str;
+    dataset->findAndGetOFString(DCM_PhotometricInterpretation, photometric_str);
+    const bool is_monochrome1 = (photometric_str == "MONOCHROME1");
+
+    Uint16 rows = 0, columns = 0, bits_allocated = 0, bits_stored = 0, high_bit = 0;
+    Uint16 samples_per_pixel = 1, pixel_rep = 0;
+    Sint32 frame_count = 1;
+    dataset->findAndGetUint16(DCM_Rows, rows);
+    dataset->findAndGetUint16(DCM_Columns, columns);
+    dataset->findAndGetUint16(DCM_BitsAllocated, bits_allocated);
+    dataset->findAndGetUint16(DCM_BitsStored, bits_stored);
+    dataset->findAndGetUint16(DCM_SamplesPerPixel, samples_per_pixel);
+    dataset->findAndGetUint16(DCM_PixelRepresentation, pixel_rep);
+    dataset->findAndGetSint32(DCM_NumberOfFrames, frame_count);
+    if (dataset->findAndGetUint16(DCM_HighBit, high_bit).bad()) {
+        high_bit = bits_stored - 1;
+    }
+
+    if (!is_monochrome1 && photometric_str != "MONOCHROME2") {
+        return ErrorInfo{ DicomError::UnsupportedPhotometricInterpretation,
+                         "Tiled layout needs grayscale pixel data", photometric_str.c_str() };
+    }
+    if (!DcmXfer(dataset->getOriginalXfer()).usesNativeFormat() || samples_per_pixel != 1 ||
+        frame_count > 1 || dataset->tagExists(DCM_ModalityLUTSequence)) {
+        return ErrorInfo{ DicomError::UnsupportedTransferSyntax,
+                         "Tiled layout needs native single-frame pixel data", "" };
+    }
+    if (rows == 0 || columns == 0 || (bits_allocated != 8 && bits_allocated != 16) ||
+        bits_stored == 0 || bits_stored > bits_allocated || high_bit + 1 < bits_stored) {
+        return ErrorInfo{ DicomError::InvalidImageDimensions, "Unsupported pixel layout", "" };
+    }
+
+    if (dataset->findAndGetElement(DCM_PixelData, file->pixel_element).bad() || !file->pixel_element) {
+        return ErrorInfo{ DicomError::MissingPixelData, "No pixel data found", "" };
+    }
+
+    const size_t bytes_per_sample = bits_allocated / 8;
+    if (file->pixel_element->getLength() < static_cast<size_t>(rows) * columns * bytes_per_sample) {
+        return ErrorInfo{ DicomError::MissingPixelData, "Pixel data is truncated", "" };
+    }
+
+    Float64 rescale_slope = 1.0, rescale_intercept = 0.0;
+    dataset->findAndGetFloat64(DCM_RescaleSlope, rescale_slope);
+    dataset->findAndGetFloat64(DCM_RescaleIntercept, rescale_intercept);
+
+    // Nominal stored range, narrowed by Smallest/Largest Image Pixel Value when present
+    const bool is_signed = (pixel_rep == 1);
+    int32_t stored_min = is_signed ? -(1 << (bits_stored - 1)) : 0;
+    int32_t stored_max = is_signed ? (1 << (bits_stored - 1)) - 1 : (1 << bits_stored) - 1;
+    if (is_signed) {
+        Sint16 smallest = 0, largest = 0;
+        if (dataset->findAndGetSint16(DCM_SmallestImagePixelValue, smallest).good() &&
+            dataset->findAndGetSint16(DCM_LargestImagePixelValue, largest).good() && smallest < largest) {
+            stored_min = std::max<int32_t>(stored_min, smallest);
+            stored_max = std::min<int32_t>(stored_max, largest);
+        }
+    }
+    else {
+        Uint16 smallest = 0, largest = 0;
+        if (dataset->findAndGetUint16(DCM_SmallestImagePixelValue, smallest).good() &&
+            dataset->findAndGetUint16(DCM_LargestImagePixelValue, largest).good() && smallest < largest) {
+            stored_min = std::max<int32_t>(stored_min, smallest);
+            stored_max = std::min<int32_t>(stored_max, largest);
+        }
+    }
+
+    double min_val = stored_min * rescale_slope + rescale_intercept;
+    double max_val = stored_max * rescale_slope + rescale_intercept;
+    if (min_val > max_val) std::swap(min_val, max_val);
+
+    double data_range = max_val - min_val;
+    if (data_range < 1) data_range = 1;
+    const double scale = 65535.0 / data_range;
+
+    // Masking, sign extension, rescale, normalization and MONOCHROME1 inversion in one table
+    const uint32_t shift = high_bit + 1u - bits_stored;
+    const uint32_t mask = (1u << bits_stored) - 1u;
+    file->lut.resize(size_t{ 1 } << bits_allocated);
+    for (uint32_t raw = 0; raw < file->lut.size(); ++raw) {
+        int32_t stored = static_cast<int32_t>((raw >> shift) & mask);
+        if (is_signed && (stored & (1 << (bits_stored - 1)))) {
+            stored -= (1 << bits_stored);
+        }
+        const double modality = stored * rescale_slope + rescale_intercept;
+        double normalized = std::clamp((modality - min_val) * scale, 0.0, 65535.0);
+        if (is_monochrome1) normalized = 65535.0 - normalized;
+        file->lut[raw] = static_cast<uint16_t>(normalized);
+    }
+
+    file->columns = columns;
+    file->bytes_per_sample = bytes_per_sample;
+
+    auto source = [file](const PixelRegion& region, uint16_t* dst, size_t dst_stride) {
+        const size_t row_bytes = region.width * file->bytes_per_sample;
+        std::vector<Uint8> raw(row_bytes + (row_bytes & 1));
+
+        std::lock_guard lock(file->mutex);
+        for (uint32_t y = 0; y < region.height; ++y) {
+            const size_t offset = ((static_cast<size_t>(region.y) + y) * file->columns + region.x) *
+                file->bytes_per_sample;
+            uint16_t* out = dst + y * dst_stride;
+            OFCondition cond = file->pixel_element->getPartialValue(raw.data(),
+                static_cast<Uint32>(offset), static_cast<Uint32>(row_bytes), &file->file_cache);
+            if (cond.bad()) {
+                std::fill(out, out + region.width, uint16_t{ 0 });
+                continue;
+            }
+            if (file->bytes_per_sample == 2) {
+                const Uint16* samples = reinterpret_cast<const Uint16*>(raw.data());
+                for (uint32_t x = 0; x < region.width; ++x) out[x] = file->lut[samples[x]];
+            }
+            else {
+                for (uint32_t x = 0; x < region.width; ++x) out[x] = file->lut[raw[x]];
+            }
+        }
+    };
+
+    ImageData img_data;
+    img_data.width = columns;
+    img_data.height = rows;
+    img_data.bits_allocated = bits_allocated;
+    img_data.bits_stored = bits_stored;
+    img_data.samples_per_pixel = 1;
+    img_data.is_signed = is_signed;
+    img_data.photometric = PhotometricInterpretation::Monochrome2;
+    img_data.tiles = std::make_shared<TiledImage>(columns, rows, std::move(source), tile_size);
+    img_data.modality = ModalityMapping::from_normalization(min_val, scale, is_monochrome1);
+
+    Float64 file_wc = 0, file_ww = 0;
+    if (dataset->findAndGetFloat64(DCM_WindowCenter, file_wc).good() &&
+        dataset->findAndGetFloat64(DCM_WindowWidth, file_ww).good() && file_ww > 0) {
+        img_data.window_center = static_cast<int32_t>((file_wc - min_val) * scale);
+        img_data.window_width = std::max(static_cast<int32_t>(file_ww * scale), 1);
+        if (is_monochrome1) {
+            img_data.window_center = 65535 - img_data.window_center;
+        }
+    }
+
+    std::cout << "[DEBUG] Tiled layout: " << img_data.tiles->tiles_x() << "x" << img_data.tiles->tiles_y()
+        << " tiles of " << tile_size << " px, read on demand" << std::endl;
+
+    return img_data;
+}
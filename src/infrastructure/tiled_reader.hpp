@@ -0,0 +1,19 @@
+#pragma once
+
+#include "core/result.hpp"
+#include "core/error_codes.hpp"
+#include "core/dicom_image.hpp"
+#include <filesystem>
+#include <cstdint>
+
+// Images with at least this many pixels use the tiled layout when it is enabled
+inline constexpr uint64_t kTiledLayoutMinPixels = 16ull * 1024 * 1024;
+
+// Native single-frame grayscale image whose tiles are read from the file on
+// first use, so only the parts that are actually viewed are read and normalized.
+// Values are normalized over the nominal pixel range (Smallest/Largest Image
+// Pixel Value, or the full Bits Stored range) since the true range is unknown
+// until every tile has been read. Other layouts fail with UnsupportedTransferSyntax.
+Result<ImageData, ErrorInfo>
+    load_tiled_image(const std::filesystem::path& path,
+        uint32_t tile_size = TiledImage::kDefaultTileSize);
@@ -1,8 +1,26 @@
 #include "main_window.hpp"
+#include "cli/anonymize.hpp"
+#include "cli/benchmark.hpp"
+#include "cli/transcode.hpp"
+#include "codec_registry.hpp"
 #include <QApplication>
 #include <QStyleFactory>
+#include <string_view>
 
 int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string_view(argv[1]) == "--benchmark") {
+        return run_benchmark(argc - 2, argv + 2);
+    }
+    if (argc > 1 && std::string_view(argv[1]) == "--transcode") {
+        return run_transcode(argc - 2, argv + 2);
+    }
+    if (argc > 1 && std::string_view(argv[1]) == "--anonymize") {
+        return run_anonymize(argc - 2, argv + 2);
+    }
+    
+    // Loads while Qt starts up and the window is built
+    DictionaryPreload dictionary_preload;
+    
     QApplication app(argc, argv);
     
     QApplication::setApplicationName("DICOM Exercise");
@@ -31,5 +49,11 @@ int main(int argc, char* argv[]) {
     MainWindow window;
     window.show();
     
+    // dicom_viewer <file> opens the file at start
+    const QStringList arguments = QApplication::arguments();
+    if (arguments.size() > 1) {
+        window.open_startup_file(arguments.at(1).toStdString());
+    }
+    
     return app.exec();
 }
\ No newline at end of file
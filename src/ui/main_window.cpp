@@ -1,5 +1,16 @@
 #include "main_window.hpp"
+#include "memory_usage.hpp"
+#include "process_info.hpp"
+#include "rtstruct_reader.hpp"
+#include "segmentation_reader.hpp"
+#include "series_loader.hpp"
+#include "tiled_reader.hpp"
+#include <QActionGroup>
+#include <QApplication>
+#include <QInputDialog>
 #include <QMenuBar>
+#include <QMouseEvent>
+#include <QPainter>
 #include <QToolBar>
 #include <QFileDialog>
 #include <QMessageBox>
@@ -10,11 +21,29 @@
 #include <QScrollArea>
 #include <QImage>
 #include <QPixmap>
+#include <QRegularExpression>
+#include <QSignalBlocker>
+#include <QStandardPaths>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
 
 MainWindow::MainWindow(QWidget* parent)
     : QMainWindow(parent)
     , dicom_reader_(std::make_unique<DcmtkReader>())
+    , image_cache_(kImageCacheMaxBytes)
+    , storage_server_(std::make_unique<StorageServer>(*dicom_reader_, study_index_, image_cache_))
+    , retrieve_ingest_(*dicom_reader_, study_index_, image_cache_)
+    , retrieved_decoded_(0)
+    , listing_retrieved_(false)
+    , pacs_address_("PACS@localhost:104")
+    , dicomweb_url_("http://localhost:8042/dicom-web/studies/<study UID>/series/<series UID>")
     , image_loaded_(false)
+    , loading_(false)
+    , first_pixel_ms_(-1.0)
+    , startup_image_pending_(false)
+    , roi_shape_(RoiShape::Off)
+    , roi_dragging_(false)
     , current_window_center_(0)
     , current_window_width_(0)
 {
@@ -25,11 +54,55 @@ MainWindow::MainWindow(QWidget* parent)
     setup_menu();
     create_toolbar();
     
+    retrieve_ingest_.set_handler([this](const InstanceRecord& record) {
+        QMetaObject::invokeMethod(this, [this, record]() { on_retrieved_instance(record); },
+            Qt::QueuedConnection);
+    });
+    
     status_bar_ = statusBar();
     status_bar_->showMessage("Ready");
+    
+    // Runs once the event loop has shown the window
+    QTimer::singleShot(0, this, [this]() {
+        const double started_ms = process_age_ms();
+        if (started_ms < 0) {
+            return;
+        }
+        std::cout << "[DEBUG] Startup: window shown " << started_ms << " ms after process start" << std::endl;
+        if (!image_loaded_ && !loading_) {
+            status_bar_->showMessage(QString("Ready (started in %1 ms)").arg(started_ms, 0, 'f', 0));
+        }
+    });
 }
 
-MainWindow::~MainWindow() = default;
+MainWindow::~MainWindow() {
+    // Their handlers post to this window
+    storage_server_->stop();
+    if (series_retriever_) {
+        series_retriever_->cancel();
+    }
+    if (dicomweb_retriever_) {
+        dicomweb_retriever_->cancel();
+    }
+    if (retrieve_thread_.joinable()) {
+        retrieve_thread_.join();
+    }
+    if (transcoder_) {
+        transcoder_->cancel();
+    }
+    if (anonymizer_) {
+        anonymizer_->cancel();
+    }
+    if (export_thread_.joinable()) {
+        export_thread_.join();
+    }
+    retrieve_ingest_.wait_idle();
+    closing_.cancel();
+    load_cancel_.cancel();
+    if (load_job_.valid()) {
+        load_job_.wait();
+    }
+}
 
 void MainWindow::setup_ui() {
     // Central widget with splitter
@@ -54,7 +127,124 @@ void MainWindow::setup_ui() {
     image_label_->setStyleSheet("QLabel { background-color: #2b2b2b; color: #888; font-size: 14px; }");
     
     scroll_area->setWidget(image_label_);
-    image_layout->addWidget(scroll_area);
+    image_label_->installEventFilter(this);
+    
+    // Multi-viewport layouts replace the single view (page 0)
+    viewport_grid_ = new ViewportGrid();
+    view_stack_ = new QStackedWidget();
+    view_stack_->addWidget(scroll_area);
+    view_stack_->addWidget(viewport_grid_);
+    image_layout->addWidget(view_stack_);
+    
+    // Frame selection for multi-frame objects
+    frame_controls_ = new QWidget();
+    auto* frame_layout = new QHBoxLayout(frame_controls_);
+    frame_layout->setContentsMargins(0, 0, 0, 0);
+    frame_layout->addWidget(new QLabel("Frame:"));
+    
+    frame_slider_ = new QSlider(Qt::Horizontal);
+    frame_slider_->setRange(0, 0);
+    frame_layout->addWidget(frame_slider_);
+    
+    frame_label_ = new QLabel("1 / 1");
+    frame_layout->addWidget(frame_label_);
+    
+    cine_play_btn_ = new QPushButton("Play");
+    cine_play_btn_->setCheckable(true);
+    frame_layout->addWidget(cine_play_btn_);
+    
+    cine_rate_spin_ = new QSpinBox();
+    cine_rate_spin_->setRange(1, 120);
+    cine_rate_spin_->setSuffix(" fps");
+    cine_rate_spin_->setValue(kDefaultCineRate);
+    frame_layout->addWidget(cine_rate_spin_);
+    
+    cine_timer_ = new QTimer(this);
+    cine_timer_->setTimerType(Qt::PreciseTimer);
+    
+    frame_controls_->setVisible(false);
+    image_layout->addWidget(frame_controls_);
+    
+    // Plane selection for series volumes
+    mpr_controls_ = new QGroupBox("Reformat");
+    auto* mpr_layout = new QVBoxLayout(mpr_controls_);
+    
+    auto* plane_layout = new QHBoxLayout();
+    plane_layout->addWidget(new QLabel("Plane:"));
+    mpr_plane_combo_ = new QComboBox();
+    // Reformatted planes in MprOrientation order, then the acquired slices as stored
+    mpr_plane_combo_->addItems({ "Axial", "Coronal", "Sagittal", "Oblique", "Acquired Slices" });
+    plane_layout->addWidget(mpr_plane_combo_);
+    plane_layout->addWidget(new QLabel("Position (mm):"));
+    mpr_position_slider_ = new QSlider(Qt::Horizontal);
+    plane_layout->addWidget(mpr_position_slider_);
+    mpr_layout->addLayout(plane_layout);
+    
+    auto* angle_layout = new QHBoxLayout();
+    angle_layout->addWidget(new QLabel("Tilt:"));
+    mpr_tilt_slider_ = new QSlider(Qt::Horizontal);
+    mpr_tilt_slider_->setRange(-90, 90);
+    angle_layout->addWidget(mpr_tilt_slider_);
+    angle_layout->addWidget(new QLabel("Rotation:"));
+    mpr_rotation_slider_ = new QSlider(Qt::Horizontal);
+    mpr_rotation_slider_->setRange(-180, 180);
+    angle_layout->addWidget(mpr_rotation_slider_);
+    mpr_layout->addLayout(angle_layout);
+    
+    // Thick-slab projections run through the acquired slices
+    auto* slab_layout = new QHBoxLayout();
+    slab_layout->addWidget(new QLabel("Projection:"));
+    slab_mode_combo_ = new QComboBox();
+    slab_mode_combo_->addItems({ "None", "MIP", "MinIP", "Average" });
+    slab_layout->addWidget(slab_mode_combo_);
+    slab_layout->addWidget(new QLabel("Slab (slices):"));
+    slab_thickness_spin_ = new QSpinBox();
+    slab_thickness_spin_->setRange(1, 1);
+    slab_layout->addWidget(slab_thickness_spin_);
+    mpr_layout->addLayout(slab_layout);
+    
+    mpr_controls_->setVisible(false);
+    image_layout->addWidget(mpr_controls_);
+    
+    // Segments of a loaded DICOM SEG, shown once one is open
+    segment_controls_ = new QGroupBox("Segments");
+    auto* segment_layout = new QVBoxLayout(segment_controls_);
+    segment_list_ = new QListWidget();
+    segment_list_->setMaximumHeight(100);
+    segment_layout->addWidget(segment_list_);
+    
+    auto* opacity_layout = new QHBoxLayout();
+    opacity_layout->addWidget(new QLabel("Opacity:"));
+    segment_opacity_slider_ = new QSlider(Qt::Horizontal);
+    segment_opacity_slider_->setRange(0, 100);
+    segment_opacity_slider_->setValue(kDefaultSegmentOpacity);
+    opacity_layout->addWidget(segment_opacity_slider_);
+    segment_layout->addLayout(opacity_layout);
+    
+    segment_controls_->setVisible(false);
+    image_layout->addWidget(segment_controls_);
+    
+    // Structures of a loaded RT Structure Set, shown once one is open
+    structure_controls_ = new QGroupBox("Structures");
+    auto* structure_layout = new QVBoxLayout(structure_controls_);
+    structure_list_ = new QListWidget();
+    structure_list_->setMaximumHeight(120);
+    structure_layout->addWidget(structure_list_);
+    structure_fill_check_ = new QCheckBox("Filled");
+    structure_layout->addWidget(structure_fill_check_);
+    
+    structure_controls_->setVisible(false);
+    image_layout->addWidget(structure_controls_);
+    
+    // Overlay planes of the current image, shown when it has any
+    overlay_controls_ = new QGroupBox("Overlays");
+    auto* overlay_layout = new QVBoxLayout(overlay_controls_);
+    overlay_list_ = new QListWidget();
+    overlay_list_->setMaximumHeight(100);
+    overlay_layout->addWidget(overlay_list_);
+    
+    overlay_controls_->setVisible(false);
+    image_layout->addWidget(overlay_controls_);
     
     // Window/Level controls
     auto* controls_group = new QGroupBox("Window/Level");
@@ -138,10 +328,46 @@ void MainWindow::setup_ui() {
     connect(window_width_spin_, QOverload<int>::of(&QSpinBox::valueChanged),
             window_width_slider_, &QSlider::setValue);
     
+    connect(frame_slider_, &QSlider::valueChanged,
+            this, &MainWindow::on_frame_changed);
+    connect(cine_play_btn_, &QPushButton::toggled,
+            this, &MainWindow::on_cine_toggled);
+    connect(cine_rate_spin_, QOverload<int>::of(&QSpinBox::valueChanged),
+            this, &MainWindow::on_cine_rate_changed);
+    connect(cine_timer_, &QTimer::timeout,
+            this, &MainWindow::on_cine_tick);
+    
+    connect(mpr_plane_combo_, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::on_mpr_plane_changed);
+    connect(mpr_position_slider_, &QSlider::valueChanged,
+            this, &MainWindow::on_mpr_changed);
+    connect(mpr_tilt_slider_, &QSlider::valueChanged,
+            this, &MainWindow::on_mpr_changed);
+    connect(mpr_rotation_slider_, &QSlider::valueChanged,
+            this, &MainWindow::on_mpr_changed);
+    connect(slab_mode_combo_, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::on_slab_mode_changed);
+    connect(slab_thickness_spin_, QOverload<int>::of(&QSpinBox::valueChanged),
+            this, &MainWindow::on_mpr_changed);
+    
+    connect(segment_list_, &QListWidget::itemChanged,
+            this, &MainWindow::on_segment_toggled);
+    connect(segment_opacity_slider_, &QSlider::valueChanged,
+            this, [this]() { update_image_display(); });
+    connect(structure_list_, &QListWidget::itemChanged,
+            this, &MainWindow::on_structure_toggled);
+    connect(structure_fill_check_, &QCheckBox::toggled,
+            this, [this]() { update_image_display(); });
+    connect(overlay_list_, &QListWidget::itemChanged,
+            this, &MainWindow::on_overlay_toggled);
+    
     connect(reset_window_btn_, &QPushButton::clicked,
             this, &MainWindow::on_reset_window);
     connect(auto_window_btn_, &QPushButton::clicked,
             this, &MainWindow::on_auto_window);
+    
+    connect(viewport_grid_, &ViewportGrid::active_window_changed,
+            this, &MainWindow::on_active_viewport_window);
 }
 
 void MainWindow::setup_menu() {
@@ -151,6 +377,46 @@ void MainWindow::setup_menu() {
     open_action->setShortcut(QKeySequence::Open);
     connect(open_action, &QAction::triggered, this, &MainWindow::on_open_file);
     
+    auto* series_action = file_menu->addAction("Open &Series...");
+    connect(series_action, &QAction::triggered, this, &MainWindow::on_open_series);
+    
+    auto* segmentation_action = file_menu->addAction("Open Se&gmentation...");
+    connect(segmentation_action, &QAction::triggered, this, &MainWindow::on_open_segmentation);
+    
+    auto* structure_set_action = file_menu->addAction("Open S&tructure Set...");
+    connect(structure_set_action, &QAction::triggered, this, &MainWindow::on_open_structure_set);
+    
+    file_menu->addSeparator();
+    
+    auto* cache_action = file_menu->addAction("Cache &Decoded Pixels");
+    cache_action->setCheckable(true);
+    cache_action->setChecked(false);
+    connect(cache_action, &QAction::toggled, this, &MainWindow::on_toggle_pixel_cache);
+    
+    auto* tiled_action = file_menu->addAction("&Tiled Layout for Large Images");
+    tiled_action->setCheckable(true);
+    tiled_action->setChecked(false);
+    connect(tiled_action, &QAction::toggled, this, &MainWindow::on_toggle_tiled_layout);
+    
+    file_menu->addSeparator();
+    
+    receive_action_ = file_menu->addAction(QString("&Receive Images (C-STORE, port %1)").arg(kStoragePort));
+    receive_action_->setCheckable(true);
+    receive_action_->setChecked(false);
+    connect(receive_action_, &QAction::toggled, this, &MainWindow::on_toggle_storage_server);
+    
+    auto* retrieve_action = file_menu->addAction("&Query/Retrieve...");
+    connect(retrieve_action, &QAction::triggered, this, &MainWindow::on_query_retrieve);
+    
+    auto* dicomweb_action = file_menu->addAction("Open &DICOMweb Series...");
+    connect(dicomweb_action, &QAction::triggered, this, &MainWindow::on_open_dicomweb);
+    
+    auto* export_action = file_menu->addAction("&Export Study (Lossless)...");
+    connect(export_action, &QAction::triggered, this, &MainWindow::on_export_study);
+    
+    auto* anonymize_action = file_menu->addAction("Export Study (&Anonymized)...");
+    connect(anonymize_action, &QAction::triggered, this, &MainWindow::on_export_anonymized);
+    
     file_menu->addSeparator();
     
     auto* exit_action = file_menu->addAction("E&xit");
@@ -162,6 +428,41 @@ void MainWindow::setup_menu() {
     auto* metadata_action = view_menu->addAction("Toggle &Metadata Panel");
     metadata_action->setShortcut(Qt::Key_M);
     connect(metadata_action, &QAction::triggered, this, &MainWindow::toggle_metadata_panel);
+    
+    view_menu->addSeparator();
+    
+    // 1 x 1 is the single image view; larger layouts show the viewport grid
+    auto* layout_menu = view_menu->addMenu("&Layout");
+    auto* layout_group = new QActionGroup(this);
+    const std::pair<int, int> layouts[] = { { 1, 1 }, { 1, 2 }, { 2, 1 }, { 2, 2 }, { 2, 3 }, { 3, 3 } };
+    for (const auto& layout : layouts) {
+        const int rows = layout.first;
+        const int columns = layout.second;
+        auto* layout_action = layout_menu->addAction(QString("%1 x %2").arg(rows).arg(columns));
+        layout_action->setCheckable(true);
+        layout_action->setChecked(rows == 1 && columns == 1);
+        layout_group->addAction(layout_action);
+        connect(layout_action, &QAction::triggered, this,
+            [this, rows, columns]() { on_viewport_layout(rows, columns); });
+    }
+    
+    auto* link_action = view_menu->addAction("Link &Window/Level");
+    link_action->setCheckable(true);
+    link_action->setChecked(true);
+    connect(link_action, &QAction::toggled, this, &MainWindow::on_toggle_window_link);
+    
+    // Drag on the single view to measure; statistics are drawn beside the ROI
+    auto* roi_menu = view_menu->addMenu("&ROI Measurement");
+    auto* roi_group = new QActionGroup(this);
+    const std::pair<const char*, RoiShape> roi_shapes[] = {
+        { "&Off", RoiShape::Off }, { "&Rectangle", RoiShape::Rectangle }, { "&Ellipse", RoiShape::Ellipse } };
+    for (const auto& [label, shape] : roi_shapes) {
+        auto* roi_action = roi_menu->addAction(label);
+        roi_action->setCheckable(true);
+        roi_action->setChecked(shape == RoiShape::Off);
+        roi_group->addAction(roi_action);
+        connect(roi_action, &QAction::triggered, this, [this, shape = shape]() { on_roi_shape(shape); });
+    }
 }
 
 void MainWindow::create_toolbar() {
@@ -180,6 +481,11 @@ void MainWindow::create_toolbar() {
 }
 
 void MainWindow::on_open_file() {
+    if (showing_viewport_grid()) {
+        open_into_viewports();
+        return;
+    }
+    
     QString filename = QFileDialog::getOpenFileName(
         this,
         "Open DICOM File",
@@ -191,21 +497,140 @@ void MainWindow::on_open_file() {
         return;
     }
     
+    open_file(filename.toStdString());
+}
+
+void MainWindow::open_startup_file(const std::filesystem::path& path) {
+    // After the window has been shown
+    startup_image_pending_ = true;
+    QTimer::singleShot(0, this, [this, path]() { open_file(path); });
+}
+
+void MainWindow::open_file(const std::filesystem::path& path) {
+    if (loading_) {
+        status_bar_->showMessage("Still loading the previous file...");
+        return;
+    }
+    
+    stop_cine();
+    retrieved_slices_.clear();
+    listing_retrieved_ = false;
+    roi_anchor_.reset();
     status_bar_->showMessage("Loading DICOM file...");
+    load_start_ = std::chrono::steady_clock::now();
+    first_pixel_ms_ = -1.0;
+    
+    current_volume_.reset();
+    rebuild_contour_cache();
+    mpr_controls_->setVisible(false);
+    
+    loading_ = true;
+    const bool build_roi_table = roi_shape_ != RoiShape::Off;
+    start_load([this, path, build_roi_table]() {
+        // The coarse preview is handed over to be painted before the full decode starts
+        auto preview = dicom_reader_->load_preview(path, kPreviewMaxDimension);
+        if (preview.is_ok()) {
+            auto shown = std::make_shared<ImagePreview>(std::move(preview.value()));
+            QMetaObject::invokeMethod(this, [this, shown]() { on_preview_loaded(shown); },
+                Qt::QueuedConnection);
+        }
+        auto result = std::make_shared<Result<LoadedImage, ErrorInfo>>(load_full_image(path, build_roi_table));
+        QMetaObject::invokeMethod(this, [this, result]() { on_load_finished(result); },
+            Qt::QueuedConnection);
+    });
+}
+
+void MainWindow::start_load(std::function<void()> job) {
+    // The job ends by posting its handler; a job dropped at close posts nothing
+    load_job_ = ThreadPool::shared().submit([this, job = std::move(job)]() {
+        if (!closing_.cancelled()) {
+            job();
+        }
+    }, TaskPriority::VisibleDecode);
+}
+
+Result<MainWindow::LoadedImage, ErrorInfo> MainWindow::load_full_image(const std::filesystem::path& path,
+    bool build_roi_table) {
+    auto result = dicom_reader_->load_complete(path);
+    if (result.is_error()) {
+        return result.error();
+    }
     
-    auto result = dicom_reader_->load_complete(filename.toStdString());
+    auto [image, metadata] = std::move(result.value());
+    LoadedImage loaded{ std::move(image), std::move(metadata), std::nullopt, std::nullopt };
+    
+    if (loaded.metadata.number_of_frames.value_or(1) > 1) {
+        auto frames_result = dicom_reader_->load_frames(path);
+        if (frames_result.is_ok()) {
+            loaded.frames = std::move(frames_result.value());
+            loaded.frames->overlays = loaded.image.data().overlays;
+            loaded.image = loaded.frames->frame_image(0);
+        }
+    }
     
-    if (result.is_error()) {
-        display_error(result.error());
+    if (build_roi_table) {
+        loaded.roi_table = SummedAreaTable::build(loaded.image);
+    }
+    
+    return loaded;
+}
+
+void MainWindow::on_preview_loaded(std::shared_ptr<ImagePreview> preview) {
+    current_image_ = std::move(preview->image);
+    current_frames_.reset();
+    current_image_changed();
+    preview_source_size_ = QSize(static_cast<int>(preview->source_width), static_cast<int>(preview->source_height));
+    image_loaded_ = true;
+    
+    current_window_center_ = current_image_.data().window_center;
+    current_window_width_ = current_image_.data().window_width;
+    set_window_controls_enabled(false);
+    frame_controls_->setVisible(false);
+    
+    update_image_display();
+    image_label_->repaint();
+    first_pixel_ms_ = elapsed_ms(load_start_);
+    std::cout << "[DEBUG] Time to first pixel (preview): " << first_pixel_ms_ << " ms" << std::endl;
+    report_startup_image();
+    
+    status_bar_->showMessage(
+        QString("Preview shown in %1 ms, loading full resolution...").arg(first_pixel_ms_, 0, 'f', 1));
+}
+
+void MainWindow::on_load_finished(std::shared_ptr<Result<LoadedImage, ErrorInfo>> result) {
+    load_job_.get();
+    loading_ = false;
+    preview_source_size_.reset();
+    
+    if (result->is_error()) {
+        image_loaded_ = false;
+        startup_image_pending_ = false;
+        image_label_->setPixmap(QPixmap());
+        image_label_->setText("No image loaded\n\nFile > Open to load a DICOM file");
+        display_error(result->error());
         status_bar_->showMessage("Failed to load DICOM file");
         return;
     }
     
-    auto [image, metadata] = std::move(result.value());
+    LoadedImage& loaded = result->value();
     
-    current_image_ = std::move(image);
-    current_metadata_ = std::move(metadata);
+    current_image_ = std::move(loaded.image);
+    current_metadata_ = std::move(loaded.metadata);
+    current_frames_ = std::move(loaded.frames);
     image_loaded_ = true;
+    current_image_changed();
+    roi_table_ = std::move(loaded.roi_table);
+    
+    frame_slider_->blockSignals(true);
+    frame_slider_->setRange(0, current_frames_ ? static_cast<int>(current_frames_->frame_count) - 1 : 0);
+    frame_slider_->setValue(0);
+    frame_slider_->blockSignals(false);
+    frame_label_->setText(QString("1 / %1").arg(current_frames_ ? current_frames_->frame_count : 1));
+    frame_controls_->setVisible(current_frames_.has_value());
+    cine_rate_spin_->blockSignals(true);
+    cine_rate_spin_->setValue(static_cast<int>(std::lround(
+        current_metadata_.cine_frame_rate().value_or(kDefaultCineRate))));
+    cine_rate_spin_->blockSignals(false);
     
     // Set initial window/level from image
     current_window_center_ = current_image_.data().window_center;
@@ -215,23 +640,569 @@ void MainWindow::on_open_file() {
     display_image();
     update_metadata_display();
     
-    // Enable controls
-    window_center_slider_->setEnabled(true);
-    window_center_spin_->setEnabled(true);
-    window_width_slider_->setEnabled(true);
-    window_width_spin_->setEnabled(true);
-    reset_window_btn_->setEnabled(true);
-    auto_window_btn_->setEnabled(true);
+    set_window_controls_enabled(true);
+    
+    const double full_ms = elapsed_ms(load_start_);
+    if (first_pixel_ms_ < 0) {
+        first_pixel_ms_ = full_ms;
+    }
+    std::cout << "[DEBUG] Time to full resolution: " << full_ms << " ms" << std::endl;
+    report_startup_image();
+    
+    const BufferPoolStats pool = BufferPool::shared().stats();
+    const MemoryUsage memory = current_memory_usage();
+    std::cout << "[DEBUG] Buffer pool: " << pool.allocations << " allocations ("
+        << pool.huge_page_blocks << " huge-page), " << pool.reuses << " reuses, "
+        << pool.bytes_in_use / (1024 * 1024) << " MB in use, "
+        << pool.bytes_cached / (1024 * 1024) << " MB cached | page faults: "
+        << memory.minor_page_faults << " minor, " << memory.major_page_faults << " major" << std::endl;
+    
+    const SchedulerStats scheduler = ThreadPool::shared().stats();
+    std::cout << "[DEBUG] Scheduler: " << scheduler.workers << " workers on " << scheduler.numa_nodes
+        << " NUMA node(s), " << scheduler.steals << " steals" << std::endl;
+    for (size_t p = 0; p < kTaskPriorityCount; ++p) {
+        const TaskClassStats& task_class = scheduler.classes[p];
+        std::cout << "[DEBUG]   " << to_string(static_cast<TaskPriority>(p)) << ": " << task_class.completed
+            << " done, " << task_class.queued << " queued, " << task_class.cancelled << " cancelled, wait "
+            << task_class.mean_wait_ms << " ms mean / " << task_class.max_wait_ms << " ms max" << std::endl;
+    }
     
     status_bar_->showMessage(
-        QString("Loaded: %1x%2 %3")
+        QString("Loaded: %1x%2 %3 | first pixel %4 ms, full load %5 ms")
             .arg(current_image_.data().width)
             .arg(current_image_.data().height)
             .arg(current_image_.data().is_rgb() ? "RGB" : "Grayscale")
+            .arg(first_pixel_ms_, 0, 'f', 1)
+            .arg(full_ms, 0, 'f', 1)
+    );
+}
+
+bool MainWindow::showing_viewport_grid() const {
+    return view_stack_->currentWidget() == viewport_grid_;
+}
+
+void MainWindow::open_into_viewports() {
+    const QStringList filenames = QFileDialog::getOpenFileNames(
+        this,
+        "Open DICOM Files into Viewports",
+        "",
+        "DICOM Files (*.dcm *.DCM *.dicom);;All Files (*)"
+    );
+    
+    if (filenames.isEmpty()) {
+        return;
+    }
+    
+    if (loading_) {
+        status_bar_->showMessage("Still loading the previous file...");
+        return;
+    }
+    
+    // Files fill the viewports from the active one on; the rest are ignored
+    const int first = viewport_grid_->active_index();
+    std::vector<std::filesystem::path> paths;
+    for (int i = 0; i < filenames.size() && first + i < viewport_grid_->viewport_count(); ++i) {
+        paths.push_back(filenames[i].toStdString());
+    }
+    
+    status_bar_->showMessage(QString("Loading %1 image(s) into viewports...").arg(paths.size()));
+    load_start_ = std::chrono::steady_clock::now();
+    
+    // The images are decoded side by side on the shared pool, and each appears
+    // as soon as it is ready; images already on screen come from the cache.
+    // A layout change cancels the ones not started yet.
+    loading_ = true;
+    load_cancel_ = CancellationToken();
+    start_load([this, paths, first, cancel = load_cancel_]() {
+        ThreadPool::shared().parallel_for(paths.size(), [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const std::filesystem::path path = paths[i];
+                auto result = std::make_shared<Result<SharedImage, ErrorInfo>>(image_cache_.get_or_load(
+                    path.lexically_normal().string(), [this, &path]() { return dicom_reader_->load_image(path); }));
+                const int index = first + static_cast<int>(i);
+                QMetaObject::invokeMethod(this, [this, index, path, result]() {
+                    on_viewport_image_loaded(index, path, result);
+                }, Qt::QueuedConnection);
+            }
+        }, &cancel);
+        QMetaObject::invokeMethod(this, [this]() { on_viewports_loaded(); }, Qt::QueuedConnection);
+    });
+}
+
+void MainWindow::on_viewport_image_loaded(int index, const std::filesystem::path& path,
+    std::shared_ptr<Result<SharedImage, ErrorInfo>> result) {
+    if (result->is_error()) {
+        std::cout << "[DEBUG] Viewport " << index + 1 << ": " << path.string() << ": "
+            << result->error().full_message() << std::endl;
+        status_bar_->showMessage(QString("Failed to load %1: %2")
+            .arg(QString::fromStdString(path.filename().string()))
+            .arg(QString::fromStdString(result->error().message)));
+        return;
+    }
+    
+    viewport_grid_->set_image(index, result->value(), QString::fromStdString(path.filename().string()));
+}
+
+void MainWindow::on_viewports_loaded() {
+    load_job_.get();
+    loading_ = false;
+    
+    const ImageCacheStats stats = image_cache_.stats();
+    status_bar_->showMessage(
+        QString("Viewports loaded in %1 ms | image cache: %2 images, %3 MB, %4 hits")
+            .arg(elapsed_ms(load_start_), 0, 'f', 1)
+            .arg(stats.entries)
+            .arg(stats.bytes / (1024 * 1024))
+            .arg(stats.hits)
+    );
+}
+
+void MainWindow::on_viewport_layout(int rows, int columns) {
+    load_cancel_.cancel();
+    
+    if (rows == 1 && columns == 1) {
+        view_stack_->setCurrentIndex(0);
+        set_window_controls_enabled(image_loaded_);
+        update_window_controls();
+        return;
+    }
+    
+    stop_cine();
+    viewport_grid_->set_layout(rows, columns);
+    view_stack_->setCurrentWidget(viewport_grid_);
+    
+    // The window controls follow the active viewport; auto window needs the single view
+    const bool has_image = viewport_grid_->state(viewport_grid_->active_index()).image != nullptr;
+    set_window_controls_enabled(has_image);
+    auto_window_btn_->setEnabled(false);
+    if (has_image) {
+        viewport_grid_->set_active(viewport_grid_->active_index());
+    }
+    
+    status_bar_->showMessage(QString("%1 x %2 layout: File > Open fills the viewports from the active one")
+        .arg(rows).arg(columns));
+}
+
+void MainWindow::on_toggle_window_link(bool linked) {
+    viewport_grid_->set_window_linked(linked);
+}
+
+void MainWindow::on_active_viewport_window(int32_t center, int32_t width) {
+    set_window_controls(center, width);
+    set_window_controls_enabled(true);
+    auto_window_btn_->setEnabled(false);
+}
+
+void MainWindow::on_open_segmentation() {
+    QString filename = QFileDialog::getOpenFileName(
+        this,
+        "Open DICOM Segmentation",
+        "",
+        "DICOM Files (*.dcm *.DCM *.dicom);;All Files (*)"
+    );
+    
+    if (filename.isEmpty()) {
+        return;
+    }
+    
+    if (loading_) {
+        status_bar_->showMessage("Still loading the previous file...");
+        return;
+    }
+    
+    status_bar_->showMessage("Loading segmentation...");
+    load_start_ = std::chrono::steady_clock::now();
+    
+    loading_ = true;
+    const std::filesystem::path path = filename.toStdString();
+    start_load([this, path]() {
+        auto result = std::make_shared<Result<Segmentation, ErrorInfo>>(load_segmentation(path));
+        QMetaObject::invokeMethod(this, [this, result]() { on_segmentation_loaded(result); },
+            Qt::QueuedConnection);
+    });
+}
+
+void MainWindow::on_segmentation_loaded(std::shared_ptr<Result<Segmentation, ErrorInfo>> result) {
+    load_job_.get();
+    loading_ = false;
+    
+    if (result->is_error()) {
+        display_error(result->error());
+        status_bar_->showMessage("Failed to load segmentation");
+        return;
+    }
+    
+    segmentation_ = std::make_shared<const Segmentation>(std::move(result->value()));
+    segment_visible_.assign(segmentation_->segments.size(), true);
+    
+    {
+        QSignalBlocker blocker(segment_list_);
+        segment_list_->clear();
+        for (const Segment& segment : segmentation_->segments) {
+            QPixmap swatch(12, 12);
+            swatch.fill(QColor(segment.color[0], segment.color[1], segment.color[2]));
+            auto* item = new QListWidgetItem(QIcon(swatch), segment.label.empty()
+                ? QString("Segment %1").arg(segment.number) : QString::fromStdString(segment.label));
+            item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
+            item->setCheckState(Qt::Checked);
+            segment_list_->addItem(item);
+        }
+    }
+    segment_controls_->setVisible(true);
+    
+    const bool covers_current = image_loaded_ && current_metadata_.sop_instance_uid &&
+        segmentation_->covers(*current_metadata_.sop_instance_uid, current_frames_ ? frame_slider_->value() : 0);
+    status_bar_->showMessage(QString("Segmentation with %1 segments loaded in %2 ms%3")
+        .arg(segmentation_->segments.size())
+        .arg(elapsed_ms(load_start_), 0, 'f', 0)
+        .arg(covers_current ? "" : "; none over the current image"));
+    update_image_display();
+}
+
+void MainWindow::on_segment_toggled(QListWidgetItem* item) {
+    const int index = segment_list_->row(item);
+    if (index < 0 || static_cast<size_t>(index) >= segment_visible_.size()) return;
+    segment_visible_[index] = item->checkState() == Qt::Checked;
+    update_image_display();
+}
+
+void MainWindow::on_open_structure_set() {
+    QString filename = QFileDialog::getOpenFileName(
+        this,
+        "Open RT Structure Set",
+        "",
+        "DICOM Files (*.dcm *.DCM *.dicom);;All Files (*)"
+    );
+    
+    if (filename.isEmpty()) {
+        return;
+    }
+    
+    if (loading_) {
+        status_bar_->showMessage("Still loading the previous file...");
+        return;
+    }
+    
+    status_bar_->showMessage("Loading structure set...");
+    load_start_ = std::chrono::steady_clock::now();
+    
+    loading_ = true;
+    const std::filesystem::path path = filename.toStdString();
+    start_load([this, path]() {
+        auto result = std::make_shared<Result<StructureSet, ErrorInfo>>(load_structure_set(path));
+        QMetaObject::invokeMethod(this, [this, result]() { on_structure_set_loaded(result); },
+            Qt::QueuedConnection);
+    });
+}
+
+void MainWindow::on_structure_set_loaded(std::shared_ptr<Result<StructureSet, ErrorInfo>> result) {
+    load_job_.get();
+    loading_ = false;
+    
+    if (result->is_error()) {
+        display_error(result->error());
+        status_bar_->showMessage("Failed to load structure set");
+        return;
+    }
+    
+    structure_set_ = std::make_shared<const StructureSet>(std::move(result->value()));
+    structure_visible_.assign(structure_set_->structures.size(), true);
+    
+    {
+        QSignalBlocker blocker(structure_list_);
+        structure_list_->clear();
+        for (const Structure& structure : structure_set_->structures) {
+            QPixmap swatch(12, 12);
+            swatch.fill(QColor(structure.color[0], structure.color[1], structure.color[2]));
+            auto* item = new QListWidgetItem(QIcon(swatch), structure.name.empty()
+                ? QString("ROI %1").arg(structure.number) : QString::fromStdString(structure.name));
+            item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
+            item->setCheckState(Qt::Checked);
+            structure_list_->addItem(item);
+        }
+    }
+    structure_controls_->setVisible(true);
+    rebuild_contour_cache();
+    
+    status_bar_->showMessage(QString("Structure set with %1 structures loaded in %2 ms; %3")
+        .arg(structure_set_->structures.size())
+        .arg(elapsed_ms(load_start_), 0, 'f', 0)
+        .arg(contour_cache_
+            ? QString("%1 of %2 contours on the series' slices")
+                .arg(contour_cache_->matched_contours()).arg(structure_set_->contour_count())
+            : QString("contours are drawn over a series")));
+    update_image_display();
+}
+
+void MainWindow::on_structure_toggled(QListWidgetItem* item) {
+    const int index = structure_list_->row(item);
+    if (index < 0 || static_cast<size_t>(index) >= structure_visible_.size()) return;
+    structure_visible_[index] = item->checkState() == Qt::Checked;
+    update_image_display();
+}
+
+void MainWindow::on_overlay_toggled(QListWidgetItem* item) {
+    const int index = overlay_list_->row(item);
+    if (index < 0 || static_cast<size_t>(index) >= overlay_visible_.size()) return;
+    overlay_visible_[index] = item->checkState() == Qt::Checked;
+    update_image_display();
+}
+
+void MainWindow::update_overlay_controls() {
+    const auto& overlays = current_image_.data().overlays;
+    if (overlays == shown_overlays_) return;
+    
+    shown_overlays_ = overlays;
+    overlay_visible_.assign(overlays ? overlays->size() : 0, true);
+    QSignalBlocker blocker(overlay_list_);
+    overlay_list_->clear();
+    if (overlays) {
+        for (const OverlayPlane& plane : *overlays) {
+            QString name = plane.label.empty()
+                ? QString("Overlay %1").arg(QString::number(plane.group, 16).toUpper())
+                : QString::fromStdString(plane.label);
+            if (plane.embedded) name += " (embedded)";
+            auto* item = new QListWidgetItem(name);
+            item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
+            item->setCheckState(Qt::Checked);
+            overlay_list_->addItem(item);
+        }
+    }
+    overlay_controls_->setVisible(!overlay_visible_.empty());
+}
+
+void MainWindow::rebuild_contour_cache() {
+    if (contour_cache_) {
+        contour_cache_->cancel();
+        contour_cache_.reset();
+    }
+    if (!structure_set_ || !current_volume_) return;
+    
+    // Slices are rasterized in the background from the one in view outwards
+    contour_cache_ = ContourRasterCache::create(structure_set_, *current_volume_);
+    contour_cache_->prefetch(static_cast<uint32_t>(std::max(mpr_position_slider_->value(), 0)));
+}
+
+void MainWindow::on_open_series() {
+    QString filename = QFileDialog::getOpenFileName(
+        this,
+        "Open Any Image of a Series",
+        "",
+        "DICOM Files (*.dcm *.DCM *.dicom);;All Files (*)"
+    );
+    
+    if (filename.isEmpty()) {
+        return;
+    }
+    
+    if (loading_) {
+        status_bar_->showMessage("Still loading the previous file...");
+        return;
+    }
+    
+    const std::filesystem::path path = filename.toStdString();
+    auto metadata = dicom_reader_->load_metadata(path);
+    if (metadata.is_error()) {
+        display_error(metadata.error());
+        return;
+    }
+    stop_cine();
+    retrieved_slices_.clear();
+    listing_retrieved_ = false;
+    current_metadata_ = std::move(metadata.value());
+    update_metadata_display();
+    
+    status_bar_->showMessage("Loading series...");
+    load_start_ = std::chrono::steady_clock::now();
+    
+    loading_ = true;
+    start_load([this, path]() {
+        auto result = std::make_shared<Result<Volume, ErrorInfo>>(load_series_volume(path, *dicom_reader_));
+        QMetaObject::invokeMethod(this, [this, result]() { on_series_loaded(result); },
+            Qt::QueuedConnection);
+    });
+}
+
+void MainWindow::on_series_loaded(std::shared_ptr<Result<Volume, ErrorInfo>> result) {
+    load_job_.get();
+    loading_ = false;
+    
+    if (result->is_error()) {
+        display_error(result->error());
+        status_bar_->showMessage("Failed to load series");
+        return;
+    }
+    
+    current_volume_ = std::make_shared<const Volume>(std::move(result->value()));
+    rebuild_contour_cache();
+    current_frames_.reset();
+    frame_controls_->setVisible(false);
+    preview_source_size_.reset();
+    image_loaded_ = true;
+    
+    current_window_center_ = current_volume_->window_center;
+    current_window_width_ = current_volume_->window_width;
+    update_window_controls();
+    set_window_controls_enabled(true);
+    
+    slab_projector_.reset();
+    slab_mode_combo_->blockSignals(true);
+    slab_mode_combo_->setCurrentIndex(0);
+    slab_mode_combo_->blockSignals(false);
+    slab_thickness_spin_->blockSignals(true);
+    slab_thickness_spin_->setRange(1, static_cast<int>(current_volume_->depth));
+    slab_thickness_spin_->setValue(std::min(10, static_cast<int>(current_volume_->depth)));
+    slab_thickness_spin_->blockSignals(false);
+    
+    mpr_plane_combo_->blockSignals(true);
+    mpr_plane_combo_->setCurrentIndex(kAcquiredSlicesIndex);
+    mpr_plane_combo_->blockSignals(false);
+    mpr_controls_->setVisible(true);
+    on_slab_mode_changed(slab_mode_combo_->currentIndex());
+    
+    status_bar_->showMessage(
+        QString("Series loaded: %1x%2x%3 in %4 ms")
+            .arg(current_volume_->width)
+            .arg(current_volume_->height)
+            .arg(current_volume_->depth)
+            .arg(elapsed_ms(load_start_), 0, 'f', 1)
+    );
+}
+
+void MainWindow::on_mpr_plane_changed(int index) {
+    if (!current_volume_) return;
+    
+    const bool oblique = index == static_cast<int>(MprOrientation::Oblique);
+    mpr_tilt_slider_->setEnabled(oblique);
+    mpr_rotation_slider_->setEnabled(oblique);
+    
+    configure_position_slider();
+    render_mpr();
+}
+
+void MainWindow::on_slab_mode_changed(int index) {
+    if (!current_volume_) return;
+    
+    // Slabs step through slices, so the plane controls only apply without one
+    const bool slab = index > 0;
+    const bool oblique = mpr_plane_combo_->currentIndex() == static_cast<int>(MprOrientation::Oblique);
+    mpr_plane_combo_->setEnabled(!slab);
+    mpr_tilt_slider_->setEnabled(!slab && oblique);
+    mpr_rotation_slider_->setEnabled(!slab && oblique);
+    slab_thickness_spin_->setEnabled(slab);
+    
+    configure_position_slider();
+    render_mpr();
+}
+
+void MainWindow::configure_position_slider() {
+    // Slab center or acquired slice as an index, or the plane offset in mm along its normal
+    int minimum = 0;
+    int maximum = static_cast<int>(current_volume_->depth) - 1;
+    int value = maximum / 2;
+    if (slab_mode_combo_->currentIndex() == 0 && !showing_acquired_slices()) {
+        const int limit = static_cast<int>(mpr_offset_limit(*current_volume_, current_mpr_plane()));
+        minimum = -limit;
+        maximum = limit;
+        value = 0;
+    }
+    
+    mpr_position_slider_->blockSignals(true);
+    mpr_position_slider_->setRange(minimum, maximum);
+    mpr_position_slider_->setValue(value);
+    mpr_position_slider_->blockSignals(false);
+}
+
+void MainWindow::on_mpr_changed() {
+    render_mpr();
+}
+
+bool MainWindow::showing_acquired_slices() const {
+    return slab_mode_combo_->currentIndex() == 0 && mpr_plane_combo_->currentIndex() == kAcquiredSlicesIndex;
+}
+
+MprPlane MainWindow::current_mpr_plane() const {
+    return make_mpr_plane(*current_volume_,
+        static_cast<MprOrientation>(mpr_plane_combo_->currentIndex()),
+        mpr_position_slider_->value(),
+        mpr_tilt_slider_->value(),
+        mpr_rotation_slider_->value());
+}
+
+void MainWindow::render_mpr() {
+    if (!current_volume_) return;
+    
+    const auto start = std::chrono::steady_clock::now();
+    const int slab_index = slab_mode_combo_->currentIndex();
+    QString description;
+    if (slab_index > 0) {
+        const SlabMode mode = static_cast<SlabMode>(slab_index - 1);
+        const int thickness = slab_thickness_spin_->value();
+        const int first = std::max(mpr_position_slider_->value() - thickness / 2, 0);
+        current_image_ = slab_projector_.project(*current_volume_, mode, static_cast<uint32_t>(first),
+            static_cast<uint32_t>(thickness));
+        current_image_changed();
+        description = QString("%1 of slices %2-%3 (%4 updated)")
+            .arg(slab_mode_combo_->currentText())
+            .arg(first + 1)
+            .arg(std::min(first + thickness, static_cast<int>(current_volume_->depth)))
+            .arg(slab_projector_.last_update_slices());
+    }
+    else if (showing_acquired_slices()) {
+        // Stack scrolling reads a slice in place, no resampling
+        const int slice = mpr_position_slider_->value();
+        current_image_ = current_volume_->slice_image(static_cast<uint32_t>(slice));
+        current_image_changed();
+        description = QString("Slice %1 / %2").arg(slice + 1).arg(current_volume_->depth);
+    }
+    else {
+        current_image_ = mpr_renderer_.reslice_image(*current_volume_, current_mpr_plane());
+        current_image_changed();
+        description = QString("%1 plane").arg(mpr_plane_combo_->currentText());
+    }
+    const double render_ms = elapsed_ms(start);
+    
+    update_image_display();
+    status_bar_->showMessage(
+        QString("%1 %2x%3 | %4 ms")
+            .arg(description)
+            .arg(current_image_.data().width)
+            .arg(current_image_.data().height)
+            .arg(render_ms, 0, 'f', 1)
     );
 }
 
+void MainWindow::set_window_controls_enabled(bool enabled) {
+    window_center_slider_->setEnabled(enabled);
+    window_center_spin_->setEnabled(enabled);
+    window_width_slider_->setEnabled(enabled);
+    window_width_spin_->setEnabled(enabled);
+    reset_window_btn_->setEnabled(enabled);
+    auto_window_btn_->setEnabled(enabled);
+}
+
+void MainWindow::report_startup_image() {
+    if (!startup_image_pending_) {
+        return;
+    }
+    startup_image_pending_ = false;
+    const double started_ms = process_age_ms();
+    if (started_ms >= 0) {
+        std::cout << "[DEBUG] Startup: first image shown " << started_ms << " ms after process start" << std::endl;
+    }
+}
+
+double MainWindow::elapsed_ms(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
 void MainWindow::on_window_center_changed(int value) {
+    if (showing_viewport_grid()) {
+        const int active = viewport_grid_->active_index();
+        viewport_grid_->set_window(active, value, viewport_grid_->state(active).window_width);
+        return;
+    }
+    
     if (!image_loaded_) return;
     
     current_window_center_ = value;
@@ -243,6 +1214,12 @@ void MainWindow::on_window_center_changed(int value) {
 }
 
 void MainWindow::on_window_width_changed(int value) {
+    if (showing_viewport_grid()) {
+        const int active = viewport_grid_->active_index();
+        viewport_grid_->set_window(active, viewport_grid_->state(active).window_center, value);
+        return;
+    }
+    
     if (!image_loaded_) return;
     
     current_window_width_ = value;
@@ -253,7 +1230,126 @@ void MainWindow::on_window_width_changed(int value) {
     update_image_display();
 }
 
+void MainWindow::on_frame_changed(int value) {
+    // Scrolling a series being retrieved pulls the slices around here forward
+    if (!retrieved_slices_.empty()) {
+        if (series_retriever_) {
+            series_retriever_->set_focus(static_cast<size_t>(value));
+        }
+        show_retrieved_slice(value);
+        return;
+    }
+    
+    if (!image_loaded_ || !current_frames_) return;
+    
+    // Dragging the slider during playback continues from there
+    if (cine_player_.playing()) {
+        start_cine(static_cast<uint32_t>(value));
+        return;
+    }
+    
+    current_image_ = current_frames_->frame_image(static_cast<uint32_t>(value));
+    current_image_changed();
+    frame_label_->setText(QString("%1 / %2").arg(value + 1).arg(current_frames_->frame_count));
+    
+    // Frames of enhanced objects may carry their own window
+    if (current_frames_->functional_groups.varies(FunctionalGroupTable::Window)) {
+        current_window_center_ = current_image_.data().window_center;
+        current_window_width_ = current_image_.data().window_width;
+        update_window_controls();
+    }
+    
+    update_image_display();
+}
+
+void MainWindow::on_cine_toggled(bool play) {
+    if (!play) {
+        stop_cine();
+        return;
+    }
+    if (!image_loaded_ || !current_frames_) {
+        cine_play_btn_->setChecked(false);
+        return;
+    }
+    start_cine(static_cast<uint32_t>(frame_slider_->value()));
+}
+
+void MainWindow::on_cine_rate_changed(int fps) {
+    if (!cine_player_.playing()) return;
+    
+    cine_player_.set_frame_rate(fps);
+    cine_timer_->setInterval(cine_poll_interval_ms());
+}
+
+void MainWindow::on_cine_tick() {
+    std::optional<CineFrame> frame = cine_player_.next_frame();
+    if (!frame) return;
+    
+    frame_slider_->blockSignals(true);
+    frame_slider_->setValue(static_cast<int>(frame->index));
+    frame_slider_->blockSignals(false);
+    frame_label_->setText(QString("%1 / %2").arg(frame->index + 1).arg(current_frames_->frame_count));
+    
+    // Nearest-neighbour scaling keeps the GUI thread's share of a frame small
+    const QSize frame_size(static_cast<int>(current_frames_->width), static_cast<int>(current_frames_->height));
+    show_display_buffer(std::move(frame->pixels), frame_size.width(), frame_size.height(),
+        fit_to_view(frame_size), Qt::FastTransformation);
+    
+    const CineStats stats = cine_player_.stats();
+    status_bar_->showMessage(
+        QString("Playing at %1 fps (target %2) | %3 dropped")
+            .arg(stats.presented_fps(), 0, 'f', 1)
+            .arg(cine_player_.frame_rate(), 0, 'f', 1)
+            .arg(stats.dropped)
+    );
+}
+
+void MainWindow::start_cine(uint32_t first_frame) {
+    cine_player_.start(current_frames_->frame_count, cine_rate_spin_->value(), make_cine_renderer(), first_frame);
+    cine_timer_->start(cine_poll_interval_ms());
+    cine_play_btn_->setText("Pause");
+}
+
+void MainWindow::stop_cine() {
+    if (!cine_player_.playing()) return;
+    
+    cine_timer_->stop();
+    cine_player_.stop();
+    cine_play_btn_->blockSignals(true);
+    cine_play_btn_->setChecked(false);
+    cine_play_btn_->blockSignals(false);
+    cine_play_btn_->setText("Play");
+    
+    // Leave the shown frame as the current image for windowing and export
+    if (current_frames_) {
+        current_image_ = current_frames_->frame_image(static_cast<uint32_t>(frame_slider_->value()));
+        current_image_changed();
+        update_image_display();
+    }
+}
+
+CinePlayer::RenderFrame MainWindow::make_cine_renderer() const {
+    // Frames outlive playback: stop_cine() runs before they are replaced
+    auto lut = std::make_shared<const std::vector<uint8_t>>(
+        DicomImageData::window_lut(current_window_center_, current_window_width_));
+    auto overlay_visible = std::make_shared<const std::vector<bool>>(overlay_visible_);
+    const FrameSet* frames = &*current_frames_;
+    return [frames, lut, overlay_visible](uint32_t index) {
+        return frames->window_frame(index, *lut, overlay_visible.get());
+    };
+}
+
+int MainWindow::cine_poll_interval_ms() const {
+    // Poll at twice the frame rate so a frame is never late by more than half a period
+    return std::max(1, static_cast<int>(500 / std::max(cine_rate_spin_->value(), 1)));
+}
+
 void MainWindow::on_reset_window() {
+    if (showing_viewport_grid()) {
+        viewport_grid_->reset_window(viewport_grid_->active_index());
+        return;
+    }
+    
     if (!image_loaded_) return;
     
     current_window_center_ = current_image_.data().window_center;
@@ -264,7 +1360,7 @@ void MainWindow::on_reset_window() {
 }
 
 void MainWindow::on_auto_window() {
-    if (!image_loaded_) return;
+    if (!image_loaded_ || showing_viewport_grid()) return;
     
     current_image_.auto_window_level();
     current_window_center_ = current_image_.data().window_center;
@@ -274,6 +1370,502 @@ void MainWindow::on_auto_window() {
     update_image_display();
 }
 
+void MainWindow::on_toggle_pixel_cache(bool enabled) {
+    if (!enabled) {
+        dicom_reader_->set_pixel_cache(std::nullopt);
+        status_bar_->showMessage("Decoded pixel cache disabled");
+        return;
+    }
+    
+    QString cache_dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+        + "/pixel-cache";
+    dicom_reader_->set_pixel_cache(PixelCacheConfig{
+        cache_dir.toStdString(),
+        kPixelCacheMaxBytes
+    });
+    status_bar_->showMessage(QString("Decoded pixel cache enabled: %1").arg(cache_dir));
+}
+
+void MainWindow::on_toggle_tiled_layout(bool enabled) {
+    dicom_reader_->set_tiled_layout(enabled);
+    status_bar_->showMessage(enabled
+        ? QString("Tiled layout enabled for native grayscale images of %1 MP and more")
+            .arg(kTiledLayoutMinPixels / (1024 * 1024))
+        : QString("Tiled layout disabled"));
+}
+
+void MainWindow::on_toggle_storage_server(bool enabled) {
+    if (!enabled) {
+        storage_server_->stop();
+        status_bar_->showMessage("Stopped receiving images");
+        return;
+    }
+    if (storage_server_->running()) {
+        return;
+    }
+    
+    StorageServerConfig config;
+    config.port = kStoragePort;
+    config.storage_directory = (QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)
+        + "/received").toStdString();
+    
+    storage_server_->set_instance_handler([this](const InstanceRecord& record) {
+        QMetaObject::invokeMethod(this, [this, record]() { on_instance_received(record); },
+            Qt::QueuedConnection);
+    });
+    
+    auto started = storage_server_->start(config);
+    if (started.is_error()) {
+        QSignalBlocker blocker(receive_action_);
+        receive_action_->setChecked(false);
+        display_error(started.error());
+        return;
+    }
+    status_bar_->showMessage(QString("Receiving images as %1 on port %2 into %3")
+        .arg(QString::fromStdString(config.ae_title))
+        .arg(config.port)
+        .arg(QString::fromStdString(config.storage_directory.string())));
+}
+
+void MainWindow::on_instance_received(const InstanceRecord& record) {
+    const StorageServerStats stats = storage_server_->stats();
+    status_bar_->showMessage(QString("Received %1 instance(s) in %2 study(ies), %3 decoded - last: %4 %5")
+        .arg(stats.instances_received)
+        .arg(study_index_.study_count())
+        .arg(stats.instances_decoded)
+        .arg(QString::fromStdString(record.patient_name))
+        .arg(QString::fromStdString(record.modality)));
+}
+
+void MainWindow::on_query_retrieve() {
+    if (retrieve_thread_.joinable()) {
+        status_bar_->showMessage("Still retrieving the previous series...");
+        return;
+    }
+    
+    bool ok = false;
+    const QString address = QInputDialog::getText(this, "Query/Retrieve", "PACS (AE title@host:port):",
+        QLineEdit::Normal, pacs_address_, &ok).trimmed();
+    if (!ok || address.isEmpty()) {
+        return;
+    }
+    const QRegularExpressionMatch parsed =
+        QRegularExpression("^([^@]+)@([^:]+):(\\d+)$").match(address);
+    if (!parsed.hasMatch()) {
+        display_error(ErrorInfo{ DicomError::NetworkError, "Invalid PACS address",
+                                 address.toStdString() + " (expected AE title@host:port)" });
+        return;
+    }
+    pacs_address_ = address;
+    
+    DicomPeer peer;
+    peer.called_ae_title = parsed.captured(1).toStdString();
+    peer.host = parsed.captured(2).toStdString();
+    peer.port = static_cast<uint16_t>(parsed.captured(3).toUInt());
+    // Same AE title as the receiver, which a PACS set up for C-MOVE already knows
+    peer.calling_ae_title = StorageServerConfig{}.ae_title;
+    
+    // Queries are short; the retrieval itself runs in the background
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    auto studies = find_studies(peer, StudyQuery{});
+    QApplication::restoreOverrideCursor();
+    if (studies.is_error()) {
+        display_error(studies.error());
+        return;
+    }
+    if (studies.value().empty()) {
+        status_bar_->showMessage(QString("No studies on %1").arg(address));
+        return;
+    }
+    
+    QStringList study_items;
+    for (const StudyMatch& study : studies.value()) {
+        study_items << QString("%1. %2  %3  %4")
+            .arg(study_items.size() + 1)
+            .arg(QString::fromStdString(study.patient_name))
+            .arg(QString::fromStdString(study.study_date))
+            .arg(QString::fromStdString(study.study_description));
+    }
+    const QString study_choice = QInputDialog::getItem(this, "Query/Retrieve", "Study:", study_items, 0, false, &ok);
+    if (!ok) {
+        return;
+    }
+    const StudyMatch& study = studies.value()[static_cast<size_t>(study_items.indexOf(study_choice))];
+    
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    auto series = find_series(peer, study.study_instance_uid);
+    QApplication::restoreOverrideCursor();
+    if (series.is_error()) {
+        display_error(series.error());
+        return;
+    }
+    if (series.value().empty()) {
+        status_bar_->showMessage("The study has no series");
+        return;
+    }
+    
+    QStringList series_items;
+    for (const SeriesMatch& entry : series.value()) {
+        series_items << QString("%1. #%2  %3  %4")
+            .arg(series_items.size() + 1)
+            .arg(entry.series_number)
+            .arg(QString::fromStdString(entry.modality))
+            .arg(QString::fromStdString(entry.series_description));
+    }
+    const QString series_choice = QInputDialog::getItem(this, "Query/Retrieve", "Series:", series_items, 0, false, &ok);
+    if (!ok) {
+        return;
+    }
+    const SeriesMatch& chosen = series.value()[static_cast<size_t>(series_items.indexOf(series_choice))];
+    
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    auto instances = find_instances(peer, study.study_instance_uid, chosen.series_instance_uid);
+    QApplication::restoreOverrideCursor();
+    if (instances.is_error()) {
+        display_error(instances.error());
+        return;
+    }
+    if (instances.value().empty()) {
+        status_bar_->showMessage("The series has no instances");
+        return;
+    }
+    
+    start_retrieve(peer, study.study_instance_uid, chosen.series_instance_uid, std::move(instances.value()));
+}
+
+void MainWindow::on_open_dicomweb() {
+    if (retrieve_thread_.joinable()) {
+        status_bar_->showMessage("Still retrieving the previous series...");
+        return;
+    }
+    
+    bool ok = false;
+    const QString url = QInputDialog::getText(this, "Open DICOMweb Series", "WADO-RS series URL:",
+        QLineEdit::Normal, dicomweb_url_, &ok).trimmed();
+    if (!ok || url.isEmpty()) {
+        return;
+    }
+    dicomweb_url_ = url;
+    
+    // The slices are learnt as the response brings them in
+    prepare_retrieve({});
+    listing_retrieved_ = true;
+    series_retriever_.reset();
+    dicomweb_retriever_ = std::make_unique<DicomWebRetriever>(retrieve_ingest_);
+    
+    status_bar_->showMessage(QString("Retrieving %1...").arg(url));
+    retrieve_start_ = std::chrono::steady_clock::now();
+    
+    retrieve_thread_ = std::thread([this, url = url.toStdString(), retriever = dicomweb_retriever_.get()]() {
+        auto result = std::make_shared<Result<DicomWebStats, ErrorInfo>>(retriever->retrieve(url));
+        QMetaObject::invokeMethod(this, [this, result]() { on_dicomweb_finished(result); },
+            Qt::QueuedConnection);
+    });
+}
+
+void MainWindow::on_export_study() {
+    if (export_thread_.joinable()) {
+        status_bar_->showMessage("Still exporting the previous study...");
+        return;
+    }
+    
+    const QString input = QFileDialog::getExistingDirectory(this, "Study Folder to Export");
+    if (input.isEmpty()) {
+        return;
+    }
+    bool ok = false;
+    const QStringList codecs = { "JPEG-LS Lossless", "RLE Lossless" };
+    const QString codec = QInputDialog::getItem(this, "Export Study", "Transfer syntax:", codecs, 0, false, &ok);
+    if (!ok) {
+        return;
+    }
+    const QString output = QFileDialog::getExistingDirectory(this, "Export To");
+    if (output.isEmpty()) {
+        return;
+    }
+    
+    auto files = collect_files({ input.toStdString() });
+    if (files.empty()) {
+        status_bar_->showMessage("The folder has no files");
+        return;
+    }
+    transcoder_ = std::make_unique<StudyTranscoder>(
+        codec == codecs[1] ? TranscodeCodec::Rle : TranscodeCodec::JpegLsLossless);
+    transcoder_->set_progress([this](uint32_t done, uint32_t total) {
+        QMetaObject::invokeMethod(this, [this, done, total]() {
+            status_bar_->showMessage(QString("Exporting: %1 / %2 files").arg(done).arg(total));
+        }, Qt::QueuedConnection);
+    });
+    
+    status_bar_->showMessage(QString("Exporting %1 files as %2...").arg(files.size()).arg(codec));
+    export_thread_ = std::thread([this, files = std::move(files), output = output.toStdString(),
+                                  transcoder = transcoder_.get()]() {
+        auto result = std::make_shared<Result<TranscodeStats, ErrorInfo>>(transcoder->transcode(files, output));
+        QMetaObject::invokeMethod(this, [this, result]() { on_export_finished(result); },
+            Qt::QueuedConnection);
+    });
+}
+
+void MainWindow::on_export_anonymized() {
+    if (export_thread_.joinable()) {
+        status_bar_->showMessage("Still exporting the previous study...");
+        return;
+    }
+    
+    const QString input = QFileDialog::getExistingDirectory(this, "Study Folder to Anonymize");
+    if (input.isEmpty()) {
+        return;
+    }
+    const QString output = QFileDialog::getExistingDirectory(this, "Export To");
+    if (output.isEmpty()) {
+        return;
+    }
+    
+    auto files = collect_files({ input.toStdString() });
+    if (files.empty()) {
+        status_bar_->showMessage("The folder has no files");
+        return;
+    }
+    anonymizer_ = std::make_unique<StudyAnonymizer>(AnonymizationProfile::basic());
+    anonymizer_->set_progress([this](uint32_t done, uint32_t total) {
+        QMetaObject::invokeMethod(this, [this, done, total]() {
+            status_bar_->showMessage(QString("Anonymizing: %1 / %2 files").arg(done).arg(total));
+        }, Qt::QueuedConnection);
+    });
+    
+    status_bar_->showMessage(QString("Anonymizing %1 files...").arg(files.size()));
+    export_thread_ = std::thread([this, files = std::move(files), output = output.toStdString(),
+                                  anonymizer = anonymizer_.get()]() {
+        auto result = std::make_shared<Result<AnonymizeStats, ErrorInfo>>(anonymizer->anonymize(files, output));
+        QMetaObject::invokeMethod(this, [this, result]() { on_anonymize_finished(result); },
+            Qt::QueuedConnection);
+    });
+}
+
+void MainWindow::prepare_retrieve(std::vector<InstanceMatch> slices) {
+    stop_cine();
+    current_volume_.reset();
+    rebuild_contour_cache();
+    mpr_controls_->setVisible(false);
+    current_frames_.reset();
+    preview_source_size_.reset();
+    image_loaded_ = false;
+    image_label_->setPixmap(QPixmap());
+    image_label_->setText("Retrieving series...");
+    
+    retrieved_slices_ = std::move(slices);
+    retrieved_series_uid_.clear();
+    retrieved_decoded_ = 0;
+    const int count = static_cast<int>(retrieved_slices_.size());
+    frame_slider_->blockSignals(true);
+    frame_slider_->setRange(0, std::max(count - 1, 0));
+    frame_slider_->setValue(0);
+    frame_slider_->blockSignals(false);
+    frame_label_->setText(QString("1 / %1").arg(count));
+    frame_controls_->setVisible(count > 0);
+    
+    // Decodes of an earlier retrieval may still be running
+    retrieve_ingest_.wait_idle();
+    retrieve_ingest_.configure(IngestConfig{
+        (QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/retrieved").toStdString(),
+        count > 0 ? static_cast<uint32_t>(count) : IngestConfig{}.max_pending_decodes });
+}
+
+void MainWindow::start_retrieve(const DicomPeer& peer, const std::string& study_uid,
+    const std::string& series_uid, std::vector<InstanceMatch> slices) {
+    prepare_retrieve(std::move(slices));
+    listing_retrieved_ = false;
+    retrieved_series_uid_ = series_uid;
+    const int count = static_cast<int>(retrieved_slices_.size());
+    
+    dicomweb_retriever_.reset();
+    series_retriever_ = std::make_unique<SeriesRetriever>(retrieve_ingest_);
+    series_retriever_->set_batch_size(kRetrieveBatchSize);
+    
+    status_bar_->showMessage(QString("Retrieving %1 instances from %2...")
+        .arg(count).arg(QString::fromStdString(peer.called_ae_title)));
+    retrieve_start_ = std::chrono::steady_clock::now();
+    
+    retrieve_thread_ = std::thread([this, peer, study_uid, series_uid, slices = retrieved_slices_,
+                                       retriever = series_retriever_.get()]() {
+        auto result = std::make_shared<Result<RetrieveStats, ErrorInfo>>(
+            retriever->retrieve(peer, study_uid, series_uid, slices));
+        QMetaObject::invokeMethod(this, [this, result]() { on_retrieve_finished(result); },
+            Qt::QueuedConnection);
+    });
+}
+
+void MainWindow::on_retrieved_instance(const InstanceRecord& record) {
+    if (!record.decoded) {
+        // A DICOMweb series is listed in the order the server sends it
+        if (listing_retrieved_ &&
+            (retrieved_series_uid_.empty() || record.series_instance_uid == retrieved_series_uid_)) {
+            retrieved_series_uid_ = record.series_instance_uid;
+            retrieved_slices_.push_back(InstanceMatch{ record.sop_instance_uid, record.sop_class_uid,
+                                                       record.instance_number });
+            const int count = static_cast<int>(retrieved_slices_.size());
+            frame_slider_->blockSignals(true);
+            frame_slider_->setRange(0, count - 1);
+            frame_slider_->blockSignals(false);
+            frame_label_->setText(QString("%1 / %2").arg(frame_slider_->value() + 1).arg(count));
+            frame_controls_->setVisible(true);
+        }
+        return;
+    }
+    if (retrieved_slices_.empty() || record.series_instance_uid != retrieved_series_uid_) {
+        return;
+    }
+    ++retrieved_decoded_;
+    
+    const int current = frame_slider_->value();
+    if (!image_loaded_) {
+        // The first slice to arrive is shown at once, wherever it is in the series
+        auto it = std::find_if(retrieved_slices_.begin(), retrieved_slices_.end(),
+            [&record](const InstanceMatch& slice) { return slice.sop_instance_uid == record.sop_instance_uid; });
+        if (it == retrieved_slices_.end()) {
+            return;
+        }
+        const int index = static_cast<int>(it - retrieved_slices_.begin());
+        frame_slider_->blockSignals(true);
+        frame_slider_->setValue(index);
+        frame_slider_->blockSignals(false);
+        if (show_retrieved_slice(index)) {
+            std::cout << "[DEBUG] Time to first retrieved image: " << elapsed_ms(retrieve_start_) << " ms" << std::endl;
+        }
+    }
+    else if (retrieved_slices_[static_cast<size_t>(current)].sop_instance_uid == record.sop_instance_uid) {
+        show_retrieved_slice(current);
+    }
+    
+    status_bar_->showMessage(QString("Retrieving: %1 / %2 slices decoded")
+        .arg(retrieved_decoded_).arg(retrieved_slices_.size()));
+}
+
+bool MainWindow::show_retrieved_slice(int index) {
+    const InstanceMatch& slice = retrieved_slices_[static_cast<size_t>(index)];
+    frame_label_->setText(QString("%1 / %2").arg(index + 1).arg(retrieved_slices_.size()));
+    
+    // Decoded slices are in the cache unless evicted since, then they are read back from disk
+    auto record = study_index_.find(slice.sop_instance_uid);
+    if (!record || !record->decoded) {
+        status_bar_->showMessage(QString("Slice %1 not received yet, retrieving it next").arg(index + 1));
+        return false;
+    }
+    const std::filesystem::path path = record->path;
+    auto image = image_cache_.get_or_load(path.string(), [this, &path]() { return dicom_reader_->load_image(path); });
+    if (image.is_error()) {
+        display_error(image.error());
+        return false;
+    }
+    
+    const bool first = !image_loaded_;
+    current_image_.set_data(image.value()->data().clone());
+    image_loaded_ = true;
+    current_image_changed();
+    if (first) {
+        current_window_center_ = current_image_.data().window_center;
+        current_window_width_ = current_image_.data().window_width;
+        update_window_controls();
+        set_window_controls_enabled(true);
+    }
+    update_image_display();
+    return true;
+}
+
+void MainWindow::on_retrieve_finished(std::shared_ptr<Result<RetrieveStats, ErrorInfo>> result) {
+    retrieve_thread_.join();
+    
+    if (result->is_error()) {
+        display_error(result->error());
+        status_bar_->showMessage("Retrieve failed");
+        return;
+    }
+    
+    const RetrieveStats& stats = result->value();
+    status_bar_->showMessage(
+        QString("Retrieved %1 of %2 instances in %3 ms (first after %4 ms), %5 failed")
+            .arg(stats.received)
+            .arg(stats.requested)
+            .arg(stats.total_ms, 0, 'f', 0)
+            .arg(stats.first_instance_ms, 0, 'f', 0)
+            .arg(stats.failed)
+    );
+}
+
+void MainWindow::on_dicomweb_finished(std::shared_ptr<Result<DicomWebStats, ErrorInfo>> result) {
+    retrieve_thread_.join();
+    
+    if (result->is_error()) {
+        display_error(result->error());
+        status_bar_->showMessage("DICOMweb retrieve failed");
+        return;
+    }
+    
+    const DicomWebStats& stats = result->value();
+    status_bar_->showMessage(
+        QString("Retrieved %1 instances (%2 MB) in %3 ms (first after %4 ms), %5 failed")
+            .arg(stats.received)
+            .arg(stats.bytes / (1024.0 * 1024.0), 0, 'f', 1)
+            .arg(stats.total_ms, 0, 'f', 0)
+            .arg(stats.first_part_ms, 0, 'f', 0)
+            .arg(stats.failed)
+    );
+}
+
+void MainWindow::on_export_finished(std::shared_ptr<Result<TranscodeStats, ErrorInfo>> result) {
+    export_thread_.join();
+    
+    if (result->is_error()) {
+        display_error(result->error());
+        status_bar_->showMessage("Export failed");
+        return;
+    }
+    
+    const TranscodeStats& stats = result->value();
+    status_bar_->showMessage(
+        QString("Exported %1 files (%2 frames) at %3:1, %4 MB/s; %5 copied unchanged, %6 failed%7")
+            .arg(stats.files)
+            .arg(stats.frames)
+            .arg(stats.compression_ratio(), 0, 'f', 2)
+            .arg(stats.megabytes_per_second(), 0, 'f', 1)
+            .arg(stats.copied)
+            .arg(stats.failed)
+            .arg(stats.cancelled ? " (cancelled)" : "")
+    );
+    if (stats.failed > 0) {
+        QMessageBox::warning(this, "Export Study",
+            QString("%1 files were not exported.\n\nFirst failure: %2")
+                .arg(stats.failed)
+                .arg(QString::fromStdString(stats.first_error)));
+    }
+}
+
+void MainWindow::on_anonymize_finished(std::shared_ptr<Result<AnonymizeStats, ErrorInfo>> result) {
+    export_thread_.join();
+    
+    if (result->is_error()) {
+        display_error(result->error());
+        status_bar_->showMessage("Anonymized export failed");
+        return;
+    }
+    
+    const AnonymizeStats& stats = result->value();
+    status_bar_->showMessage(
+        QString("Anonymized %1 files, %2 MB at %3 MB/s; %4 failed%5")
+            .arg(stats.files)
+            .arg(stats.input_bytes / (1024.0 * 1024.0), 0, 'f', 1)
+            .arg(stats.megabytes_per_second(), 0, 'f', 1)
+            .arg(stats.failed)
+            .arg(stats.cancelled ? " (cancelled)" : "")
+    );
+    if (stats.failed > 0) {
+        QMessageBox::warning(this, "Export Study (Anonymized)",
+            QString("%1 files were not exported.\n\nFirst failure: %2")
+                .arg(stats.failed)
+                .arg(QString::fromStdString(stats.first_error)));
+    }
+}
+
 void MainWindow::toggle_metadata_panel() {
     metadata_text_->setVisible(!metadata_text_->isVisible());
 }
@@ -296,7 +1888,12 @@ void MainWindow::display_error(const ErrorInfo& error) {
             break;
         case DicomError::UnsupportedPhotometricInterpretation:
             error_msg += "\n\nThe color format of this image is not supported.";
-            error_msg += "\nSupported formats: MONOCHROME1, MONOCHROME2, RGB";
+            error_msg += "\nSupported formats: MONOCHROME1, MONOCHROME2, RGB, YBR_FULL, YBR_FULL_422,";
+            error_msg += "\nYBR_RCT, YBR_ICT, PALETTE COLOR";
+            break;
+        case DicomError::NetworkError:
+            error_msg += "\n\nCheck that the port is not used by another application, "
+                         "or that the PACS address and AE title or the DICOMweb URL are correct.";
             break;
         default:
             break;
@@ -309,58 +1906,300 @@ void MainWindow::display_image() {
     update_image_display();
 }
 
+QSize MainWindow::fit_to_view(QSize size) const {
+    const QSize available_size = image_label_->parentWidget()->size();
+    if (size.width() > available_size.width() || size.height() > available_size.height()) {
+        size.scale(available_size, Qt::KeepAspectRatio);
+    }
+    return size;
+}
+
 void MainWindow::update_image_display() {
     if (!image_loaded_) return;
     
+    // During playback frames are windowed ahead by the cine workers
+    if (cine_player_.playing()) {
+        cine_player_.set_renderer(make_cine_renderer());
+        return;
+    }
+    
     const auto& img_data = current_image_.data();
     
-    QImage q_image;
-    
-    if (img_data.is_rgb()) {
-        // RGB image
-        auto rgb_buffer = current_image_.to_rgb_display_buffer();
-        q_image = QImage(
-            rgb_buffer.data(),
-            img_data.width,
-            img_data.height,
-            img_data.width * 3,
-            QImage::Format_RGB888
-        );
-        q_image = q_image.copy();  // Deep copy
-    } else {
-        // Grayscale image with window/level
-        auto display_buffer = current_image_.to_display_buffer(
-            current_window_center_,
-            current_window_width_
-        );
-        
-        q_image = QImage(
-            display_buffer.data(),
-            img_data.width,
-            img_data.height,
-            img_data.width,
-            QImage::Format_Grayscale8
-        );
-        q_image = q_image.copy();  // Deep copy
+    // A preview is drawn at the size the full-resolution image will have,
+    // so the view refines in place when the full decode arrives
+    const QSize target_size = fit_to_view(preview_source_size_.value_or(
+        QSize(static_cast<int>(img_data.width), static_cast<int>(img_data.height))));
+    
+    // Tiled images are windowed and resampled tile by tile straight to the
+    // target size; everything else is rendered at full size and scaled by Qt
+    const bool render_to_target = img_data.tiles && !target_size.isEmpty();
+    const int render_width = render_to_target ? target_size.width() : static_cast<int>(img_data.width);
+    const int render_height = render_to_target ? target_size.height() : static_cast<int>(img_data.height);
+    
+    PixelBuffer display = img_data.is_rgb() ? current_image_.to_rgb_display_buffer()
+        : render_to_target ? current_image_.render_region(
+            PixelRegion{ 0, 0, img_data.width, img_data.height },
+            static_cast<uint32_t>(render_width), static_cast<uint32_t>(render_height),
+            current_window_center_, current_window_width_)
+        : current_image_.to_display_buffer(current_window_center_, current_window_width_, &overlay_visible_);
+    
+    // Segments and contours are drawn on the source pixel grid, before Qt scales the image
+    if (!render_to_target) {
+        display = blend_segments(std::move(display));
+        display = draw_contours(std::move(display));
+    }
+    
+    show_display_buffer(std::move(display), render_width, render_height, target_size, Qt::SmoothTransformation);
+}
+
+PixelBuffer MainWindow::blend_segments(PixelBuffer display) const {
+    if (!segmentation_ || !current_metadata_.sop_instance_uid) {
+        return display;
     }
     
+    // A preview has another size than the frames the masks were made for,
+    // so it is shown without them
+    const auto& img_data = current_image_.data();
+    const uint32_t frame = current_frames_ ? static_cast<uint32_t>(frame_slider_->value()) : 0;
+    const auto opacity = static_cast<uint8_t>(segment_opacity_slider_->value() * 255 / 100);
+    PixelBuffer blended = segmentation_->blend(display, img_data.width, img_data.height,
+        *current_metadata_.sop_instance_uid, frame, segment_visible_, opacity);
+    return blended.empty() ? std::move(display) : std::move(blended);
+}
+
+PixelBuffer MainWindow::draw_contours(PixelBuffer display) const {
+    // Contours lie in the acquired slice planes, so resliced planes and
+    // slabs are shown without them
+    if (!contour_cache_ || !current_volume_ || !showing_acquired_slices()) {
+        return display;
+    }
+    
+    const auto& img_data = current_image_.data();
+    const int slice = mpr_position_slider_->value();
+    if (slice < 0 || static_cast<uint32_t>(slice) >= contour_cache_->depth() ||
+        img_data.width != contour_cache_->width() || img_data.height != contour_cache_->height()) {
+        return display;
+    }
+    PixelBuffer drawn = draw_structures(display, img_data.width, img_data.height,
+        contour_cache_->slice(static_cast<uint32_t>(slice)), contour_cache_->structure_set(), structure_visible_,
+        structure_fill_check_->isChecked(), kStructureFillOpacity);
+    return drawn.empty() ? std::move(display) : std::move(drawn);
+}
+
+void MainWindow::show_display_buffer(PixelBuffer buffer, int render_width, int render_height,
+    QSize target_size, Qt::TransformationMode mode) {
+    // The QImage borrows the pooled display buffer and hands it back to the
+    // pool when Qt releases the image, so renders recycle one allocation
+    auto display_buffer = std::make_unique<PixelBuffer>(std::move(buffer));
+    
+    const bool is_rgb = display_buffer->format() == PixelFormat::Rgb8;
+    uchar* bits = is_rgb ? display_buffer->rgb8() : display_buffer->gray8();
+    if (!bits) return;
+    
+    QImage q_image(
+        bits,
+        render_width,
+        render_height,
+        static_cast<qsizetype>(render_width) * (is_rgb ? 3 : 1),
+        is_rgb ? QImage::Format_RGB888 : QImage::Format_Grayscale8,
+        [](void* buffer) { delete static_cast<PixelBuffer*>(buffer); },
+        display_buffer.get()
+    );
+    display_buffer.release();
+    
     // Scale image to fit in the label while maintaining aspect ratio
     QPixmap pixmap = QPixmap::fromImage(q_image);
     
-    // Get available space in scroll area
-    QSize available_size = image_label_->parentWidget()->size();
-    
-    // Scale pixmap to fit, maintaining aspect ratio
-    if (pixmap.width() > available_size.width() || pixmap.height() > available_size.height()) {
+    if (pixmap.size() != target_size) {
         pixmap = pixmap.scaled(
-            available_size,
+            target_size,
             Qt::KeepAspectRatio,
-            Qt::SmoothTransformation
+            mode
         );
     }
     
-    image_label_->setPixmap(pixmap);
+    display_pixmap_ = pixmap;
     image_label_->resize(pixmap.size());
+    paint_roi();
+}
+
+void MainWindow::on_roi_shape(RoiShape shape) {
+    roi_shape_ = shape;
+    if (shape == RoiShape::Off) {
+        // About 12 bytes per pixel, worth keeping only while measuring
+        roi_anchor_.reset();
+        roi_table_.reset();
+    }
+    paint_roi();
+}
+
+bool MainWindow::eventFilter(QObject* watched, QEvent* event) {
+    if (watched != image_label_ || roi_shape_ == RoiShape::Off) {
+        return QMainWindow::eventFilter(watched, event);
+    }
+    
+    const auto type = event->type();
+    if (type == QEvent::MouseButtonPress) {
+        auto* mouse = static_cast<QMouseEvent*>(event);
+        if (mouse->button() != Qt::LeftButton || !image_loaded_ || loading_ || cine_player_.playing()) {
+            return false;
+        }
+        const auto position = label_to_image(mouse->position().toPoint());
+        const auto& img_data = current_image_.data();
+        if (!position || position->x() < 0 || position->y() < 0 ||
+            position->x() > img_data.width || position->y() > img_data.height) {
+            return false;
+        }
+        
+        if (!roi_table_) {
+            const auto start = std::chrono::steady_clock::now();
+            roi_table_ = SummedAreaTable::build(current_image_);
+            std::cout << "[DEBUG] ROI tables built in " << elapsed_ms(start) << " ms ("
+                << roi_table_->memory_bytes() / (1024 * 1024) << " MB)" << std::endl;
+        }
+        if (roi_table_->empty()) {
+            status_bar_->showMessage("ROI measurement needs a grayscale image that is not tiled");
+            return true;
+        }
+        
+        roi_anchor_ = *position;
+        roi_end_ = *position;
+        roi_dragging_ = true;
+        paint_roi();
+        return true;
+    }
+    if (type == QEvent::MouseMove && roi_dragging_) {
+        const auto position = label_to_image(static_cast<QMouseEvent*>(event)->position().toPoint());
+        if (position) {
+            const auto& img_data = current_image_.data();
+            roi_end_ = QPointF(std::clamp(position->x(), 0.0, static_cast<double>(img_data.width)),
+                std::clamp(position->y(), 0.0, static_cast<double>(img_data.height)));
+            paint_roi();
+        }
+        return true;
+    }
+    if (type == QEvent::MouseButtonRelease && roi_dragging_) {
+        roi_dragging_ = false;
+        return true;
+    }
+    return false;
+}
+
+std::optional<QPointF> MainWindow::label_to_image(QPoint position) const {
+    if (display_pixmap_.isNull() || current_image_.data().width == 0) {
+        return std::nullopt;
+    }
+    // The pixmap is centered in the label
+    const QPointF origin((image_label_->width() - display_pixmap_.width()) / 2.0,
+        (image_label_->height() - display_pixmap_.height()) / 2.0);
+    const double scale = static_cast<double>(current_image_.data().width) / display_pixmap_.width();
+    return (QPointF(position) - origin) * scale;
+}
+
+void MainWindow::current_image_changed() {
+    // The tables describe the previous image. The ROI stays on slices and
+    // frames it still fits, and is measured there without tables until
+    // the next drag, as one query costs less than building them.
+    roi_table_.reset();
+    roi_dragging_ = false;
+    const auto& img_data = current_image_.data();
+    if (roi_anchor_ && (std::max(roi_anchor_->x(), roi_end_.x()) > img_data.width ||
+        std::max(roi_anchor_->y(), roi_end_.y()) > img_data.height)) {
+        roi_anchor_.reset();
+    }
+    update_overlay_controls();
+}
+
+void MainWindow::paint_roi() {
+    if (display_pixmap_.isNull()) return;
+    
+    // Cine frames are not current_image_, so playback hides the ROI
+    if (!roi_anchor_ || roi_shape_ == RoiShape::Off || cine_player_.playing()) {
+        image_label_->setPixmap(display_pixmap_);
+        return;
+    }
+    
+    const QString text = roi_statistics_text();
+    QPixmap pixmap = display_pixmap_;
+    QPainter painter(&pixmap);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(QPen(QColor(255, 200, 0), 1.5));
+    
+    const double scale = pixmap.width() / static_cast<double>(current_image_.data().width);
+    const QRectF outline = QRectF(*roi_anchor_ * scale, roi_end_ * scale).normalized();
+    if (roi_shape_ == RoiShape::Ellipse) {
+        painter.drawEllipse(outline);
+    }
+    else {
+        painter.drawRect(outline);
+    }
+    
+    // Below the ROI, or above it near the bottom edge
+    constexpr double kTextWidth = 260.0;
+    constexpr double kTextHeight = 52.0;
+    const double text_top = outline.bottom() + kTextHeight + 4.0 > pixmap.height()
+        ? outline.top() - kTextHeight - 4.0 : outline.bottom() + 4.0;
+    painter.drawText(QRectF(outline.left(), text_top, kTextWidth, kTextHeight),
+        Qt::AlignLeft | Qt::AlignTop, text);
+    painter.end();
+    
+    image_label_->setPixmap(pixmap);
+}
+
+QString MainWindow::roi_statistics_text() {
+    const auto& img_data = current_image_.data();
+    const double left = std::min(roi_anchor_->x(), roi_end_.x());
+    const double right = std::max(roi_anchor_->x(), roi_end_.x());
+    const double top = std::min(roi_anchor_->y(), roi_end_.y());
+    const double bottom = std::max(roi_anchor_->y(), roi_end_.y());
+    
+    // Pixels whose centers lie inside the outline
+    std::vector<RowSpan> spans;
+    RoiStatistics stats;
+    if (roi_shape_ == RoiShape::Ellipse) {
+        spans = ellipse_spans((left + right) / 2.0, (top + bottom) / 2.0, (right - left) / 2.0, (bottom - top) / 2.0,
+            img_data.width, img_data.height);
+        stats = roi_table_ ? roi_table_->spans(spans) : scan_roi_statistics(current_image_, spans);
+    }
+    else {
+        const auto x_begin = static_cast<uint32_t>(std::max(0.0, std::ceil(left - 0.5)));
+        const auto x_end = static_cast<uint32_t>(std::max(0.0, std::floor(right - 0.5) + 1.0));
+        const auto y_begin = static_cast<uint32_t>(std::max(0.0, std::ceil(top - 0.5)));
+        const auto y_end = static_cast<uint32_t>(std::max(0.0, std::floor(bottom - 0.5) + 1.0));
+        if (roi_table_) {
+            stats = roi_table_->rectangle(x_begin, y_begin, x_end, y_end);
+        }
+        else {
+            for (uint32_t y = y_begin; y < std::min(y_end, img_data.height); ++y) {
+                spans.push_back({ y, x_begin, std::min(x_end, img_data.width) });
+            }
+            stats = scan_roi_statistics(current_image_, spans);
+        }
+    }
+    if (stats.pixels == 0) {
+        return QString();
+    }
+    
+    const QString unit = current_metadata_.modality.value_or("") == "CT" ? " HU" : "";
+    // Enhanced objects give the spacing per frame in their functional groups
+    std::optional<std::array<double, 2>> spacing = current_metadata_.pixel_spacing_mm;
+    if (!spacing && current_frames_) {
+        const FunctionalGroupTable& groups = current_frames_->functional_groups;
+        const uint32_t frame = static_cast<uint32_t>(frame_slider_->value());
+        if (frame < groups.frame_count && groups.has(frame, FunctionalGroupTable::Spacing)) {
+            spacing = groups.pixel_spacing[frame];
+        }
+    }
+    const QString area = spacing
+        ? QString("%1 mm\u00B2").arg(stats.area_mm2(*spacing), 0, 'f', 1)
+        : QString("%1 px").arg(stats.pixels);
+    return QString("Mean %1%3  SD %2%3\nMin %4%3  Max %5%3\nArea %6")
+        .arg(stats.mean, 0, 'f', 1)
+        .arg(stats.std_dev, 0, 'f', 1)
+        .arg(unit)
+        .arg(stats.min, 0, 'f', 1)
+        .arg(stats.max, 0, 'f', 1)
+        .arg(area);
 }
 
 void MainWindow::update_metadata_display() {
@@ -369,15 +2208,19 @@ void MainWindow::update_metadata_display() {
 }
 
 void MainWindow::update_window_controls() {
+    set_window_controls(current_window_center_, current_window_width_);
+}
+
+void MainWindow::set_window_controls(int32_t center, int32_t width) {
     window_center_slider_->blockSignals(true);
     window_center_spin_->blockSignals(true);
     window_width_slider_->blockSignals(true);
     window_width_spin_->blockSignals(true);
     
-    window_center_slider_->setValue(current_window_center_);
-    window_center_spin_->setValue(current_window_center_);
-    window_width_slider_->setValue(current_window_width_);
-    window_width_spin_->setValue(current_window_width_);
+    window_center_slider_->setValue(center);
+    window_center_spin_->setValue(center);
+    window_width_slider_->setValue(width);
+    window_width_spin_->setValue(width);
     
     window_center_slider_->blockSignals(false);
     window_center_spin_->blockSignals(false);
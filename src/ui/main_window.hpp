@@ -1,30 +1,157 @@
 #pragma once
 
 #include <QMainWindow>
+#include <QAction>
+#include <QCheckBox>
+#include <QComboBox>
 #include <QLabel>
+#include <QListWidget>
 #include <QSlider>
 #include <QSpinBox>
 #include <QTextEdit>
 #include <QStatusBar>
+#include <QPixmap>
+#include <QPointF>
 #include <QPushButton>
+#include <QStackedWidget>
+#include <QTimer>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <future>
 #include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
 
+#include "cine_player.hpp"
 #include "dcmtk_wrapper.hpp"
+#include "dicomweb_retriever.hpp"
 #include "dicom_image.hpp"
 #include "dicom_metadata.hpp"
+#include "image_cache.hpp"
+#include "instance_ingest.hpp"
+#include "mpr.hpp"
+#include "query_scu.hpp"
+#include "roi_statistics.hpp"
+#include "segmentation.hpp"
+#include "series_retriever.hpp"
+#include "slab_projection.hpp"
+#include "structure_set.hpp"
+#include "storage_scp.hpp"
+#include "study_anonymizer.hpp"
+#include "study_index.hpp"
+#include "study_transcoder.hpp"
+#include "viewport_grid.hpp"
+#include "volume.hpp"
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
     
     std::unique_ptr<IDicomReader> dicom_reader_;
     
+    // Decoded images shared by the viewports of multi-viewport layouts
+    ImageCache image_cache_;
+    
+    // Instances received by the embedded C-STORE server, which decodes them into image_cache_
+    StudyIndex study_index_;
+    std::unique_ptr<StorageServer> storage_server_;
+    
+    // Series retrieved from a PACS with C-GET, or from a DICOMweb server.
+    // Slices are shown from image_cache_ as they arrive; with C-GET the
+    // slice slider steers the retrieval. The retrieval keeps a thread of its
+    // own: it blocks on the network for the whole transfer, and on a pool
+    // worker it would hold back the decodes of the instances it receives.
+    InstanceIngest retrieve_ingest_;
+    std::unique_ptr<SeriesRetriever> series_retriever_;
+    std::unique_ptr<DicomWebRetriever> dicomweb_retriever_;
+    std::thread retrieve_thread_;
+    std::vector<InstanceMatch> retrieved_slices_;   // display order, empty unless showing one
+    std::string retrieved_series_uid_;
+    uint32_t retrieved_decoded_;
+    bool listing_retrieved_;   // slices are appended as a DICOMweb series arrives
+    std::chrono::steady_clock::time_point retrieve_start_;
+    QString pacs_address_;
+    QString dicomweb_url_;
+    
+    // Lossless or anonymized export of a study folder, in the background.
+    // Its thread waits on the Indexing tasks it submits, so it cannot be one
+    // of the pool's workers: it would take the slot they need to run.
+    std::unique_ptr<StudyTranscoder> transcoder_;
+    std::unique_ptr<StudyAnonymizer> anonymizer_;
+    std::thread export_thread_;
+    
     // Current loaded data
     DicomImageData current_image_;
     DicomMetadata current_metadata_;
     bool image_loaded_;
     
+    // All frames of a multi-frame object, decoded up front
+    std::optional<FrameSet> current_frames_;
+    
+    // Result of a background load
+    struct LoadedImage {
+        DicomImageData image;
+        DicomMetadata metadata;
+        std::optional<FrameSet> frames;
+        std::optional<SummedAreaTable> roi_table;   // when the ROI tool was on at load start
+    };
+    
+    // Background loading; a preview is shown until the full decode arrives.
+    // Each load is a visible decode task on the shared pool, whose decode
+    // work it fans out at the same class; handlers take load_job_ first.
+    std::future<void> load_job_;
+    bool loading_;
+    CancellationToken closing_;       // drops a load not started when the window closes
+    CancellationToken load_cancel_;   // skips the viewport images not started yet
+    std::chrono::steady_clock::time_point load_start_;
+    double first_pixel_ms_;
+    std::optional<QSize> preview_source_size_;
+    bool startup_image_pending_;   // the command-line file has not been painted yet
+    
+    // Series volume shown as multi-planar reformats instead of single images
+    std::shared_ptr<const Volume> current_volume_;
+    MprRenderer mpr_renderer_;
+    SlabProjector slab_projector_;
+    
+    // ROI measurement on the single view. The summed-area tables of
+    // current_image_ are built with the load while the tool is on, or on
+    // first use, so statistics follow the drag at any ROI size.
+    enum class RoiShape { Off, Rectangle, Ellipse };
+    RoiShape roi_shape_;
+    std::optional<SummedAreaTable> roi_table_;
+    std::optional<QPointF> roi_anchor_;   // image coordinates; no ROI while unset
+    QPointF roi_end_;
+    bool roi_dragging_;
+    QPixmap display_pixmap_;              // the shown image without the ROI overlay
+    
+    // DICOM SEG drawn over the frames of current_image_'s SOP instance it
+    // was derived from. Masks are unpacked once at load; showing, hiding or
+    // fading segments re-blends the windowed image without decoding it.
+    std::shared_ptr<const Segmentation> segmentation_;
+    std::vector<bool> segment_visible_;   // one flag per segment
+    
+    // RT Structure Set contours drawn over the acquired slices of
+    // current_volume_. The cache is rebuilt for each volume and rasterizes
+    // every slice in the background; scrolling only draws cached spans.
+    std::shared_ptr<const StructureSet> structure_set_;
+    std::shared_ptr<ContourRasterCache> contour_cache_;
+    std::vector<bool> structure_visible_;   // one flag per structure
+    
+    // Overlay planes of current_image_, drawn into the display buffer as it
+    // is windowed. The list is rebuilt only when another object's planes
+    // arrive, so frames of one object keep their toggles.
+    std::shared_ptr<const OverlayPlanes> shown_overlays_;
+    std::vector<bool> overlay_visible_;   // one flag per overlay plane
+    
+    // Playback of current_frames_; declared after it so it stops first
+    CinePlayer cine_player_;
+    
     // UI Components
+    QStackedWidget* view_stack_;   // single image view, or viewport_grid_ for N x M layouts
     QLabel* image_label_;
+    ViewportGrid* viewport_grid_;
     QTextEdit* metadata_text_;
     QSlider* window_center_slider_;
     QSlider* window_width_slider_;
@@ -32,31 +159,141 @@ class MainWindow : public QMainWindow {
     QSpinBox* window_width_spin_;
     QPushButton* reset_window_btn_;
     QPushButton* auto_window_btn_;
+    QWidget* frame_controls_;
+    QSlider* frame_slider_;
+    QLabel* frame_label_;
+    QPushButton* cine_play_btn_;
+    QSpinBox* cine_rate_spin_;
+    QTimer* cine_timer_;
+    QWidget* mpr_controls_;
+    QComboBox* mpr_plane_combo_;
+    QSlider* mpr_position_slider_;
+    QSlider* mpr_tilt_slider_;
+    QSlider* mpr_rotation_slider_;
+    QComboBox* slab_mode_combo_;
+    QSpinBox* slab_thickness_spin_;
+    QWidget* segment_controls_;
+    QListWidget* segment_list_;
+    QSlider* segment_opacity_slider_;
+    QWidget* structure_controls_;
+    QListWidget* structure_list_;
+    QCheckBox* structure_fill_check_;
+    QWidget* overlay_controls_;
+    QListWidget* overlay_list_;
     QStatusBar* status_bar_;
+    QAction* receive_action_;
     
     // Current window/level values
     int32_t current_window_center_;
     int32_t current_window_width_;
     
+    static constexpr uint64_t kPixelCacheMaxBytes = 2ull * 1024 * 1024 * 1024;
+    static constexpr uint64_t kImageCacheMaxBytes = 2ull * 1024 * 1024 * 1024;
+    static constexpr uint32_t kPreviewMaxDimension = 512;
+    static constexpr int kAcquiredSlicesIndex = 4;   // plane combo entry after the MprOrientation values
+    static constexpr int kDefaultCineRate = 25;      // fps when the file gives no frame timing
+    static constexpr uint16_t kStoragePort = 11112;
+    static constexpr uint32_t kRetrieveBatchSize = 8;  // instances per C-GET; smaller follows scrolling closer
+    static constexpr int kDefaultSegmentOpacity = 50;  // percent
+    static constexpr uint8_t kStructureFillOpacity = 80;  // of 255
+    
 public:
     explicit MainWindow(QWidget* parent = nullptr);
     ~MainWindow() override;
     
+    // Loads one image into the single view
+    void open_file(const std::filesystem::path& path);
+    
+    // The file named on the command line; its first paint is timed from process start
+    void open_startup_file(const std::filesystem::path& path);
+    
 private slots:
     void on_open_file();
+    void on_open_series();
+    void on_open_segmentation();
+    void on_segment_toggled(QListWidgetItem* item);
+    void on_open_structure_set();
+    void on_structure_toggled(QListWidgetItem* item);
+    void on_overlay_toggled(QListWidgetItem* item);
+    void on_mpr_plane_changed(int index);
+    void on_mpr_changed();
+    void on_slab_mode_changed(int index);
     void on_window_center_changed(int value);
     void on_window_width_changed(int value);
     void on_reset_window();
     void on_auto_window();
+    void on_frame_changed(int value);
+    void on_cine_toggled(bool play);
+    void on_cine_rate_changed(int fps);
+    void on_cine_tick();
+    void on_toggle_pixel_cache(bool enabled);
+    void on_toggle_tiled_layout(bool enabled);
+    void on_toggle_storage_server(bool enabled);
+    void on_query_retrieve();
+    void on_open_dicomweb();
+    void on_export_study();
+    void on_export_anonymized();
+    void on_viewport_layout(int rows, int columns);
+    void on_toggle_window_link(bool linked);
+    void on_active_viewport_window(int32_t center, int32_t width);
     void toggle_metadata_panel();
     
+protected:
+    bool eventFilter(QObject* watched, QEvent* event) override;
+    
 private:
     void setup_ui();
     void setup_menu();
     void create_toolbar();
+    Result<LoadedImage, ErrorInfo> load_full_image(const std::filesystem::path& path, bool build_roi_table);
+    void on_preview_loaded(std::shared_ptr<ImagePreview> preview);
+    void on_load_finished(std::shared_ptr<Result<LoadedImage, ErrorInfo>> result);
+    void start_load(std::function<void()> job);
+    void on_series_loaded(std::shared_ptr<Result<Volume, ErrorInfo>> result);
+    void on_segmentation_loaded(std::shared_ptr<Result<Segmentation, ErrorInfo>> result);
+    PixelBuffer blend_segments(PixelBuffer display) const;
+    void on_structure_set_loaded(std::shared_ptr<Result<StructureSet, ErrorInfo>> result);
+    void rebuild_contour_cache();
+    PixelBuffer draw_contours(PixelBuffer display) const;
+    bool showing_viewport_grid() const;
+    void open_into_viewports();
+    void on_viewport_image_loaded(int index, const std::filesystem::path& path,
+        std::shared_ptr<Result<SharedImage, ErrorInfo>> result);
+    void on_viewports_loaded();
+    void on_instance_received(const InstanceRecord& record);
+    void prepare_retrieve(std::vector<InstanceMatch> slices);
+    void start_retrieve(const DicomPeer& peer, const std::string& study_uid, const std::string& series_uid,
+        std::vector<InstanceMatch> slices);
+    void on_retrieved_instance(const InstanceRecord& record);
+    void on_retrieve_finished(std::shared_ptr<Result<RetrieveStats, ErrorInfo>> result);
+    void on_dicomweb_finished(std::shared_ptr<Result<DicomWebStats, ErrorInfo>> result);
+    void on_export_finished(std::shared_ptr<Result<TranscodeStats, ErrorInfo>> result);
+    void on_anonymize_finished(std::shared_ptr<Result<AnonymizeStats, ErrorInfo>> result);
+    bool show_retrieved_slice(int index);
+    bool showing_acquired_slices() const;
+    MprPlane current_mpr_plane() const;
+    void configure_position_slider();
+    void render_mpr();
+    void start_cine(uint32_t first_frame);
+    void stop_cine();
+    CinePlayer::RenderFrame make_cine_renderer() const;
+    int cine_poll_interval_ms() const;
+    void set_window_controls_enabled(bool enabled);
+    void report_startup_image();
+    static double elapsed_ms(std::chrono::steady_clock::time_point since);
     void display_error(const ErrorInfo& error);
     void display_image();
     void update_image_display();
+    QSize fit_to_view(QSize size) const;
+    void show_display_buffer(PixelBuffer buffer, int render_width, int render_height,
+        QSize target_size, Qt::TransformationMode mode);
+    void on_roi_shape(RoiShape shape);
+    std::optional<QPointF> label_to_image(QPoint position) const;   // unclamped
+    void current_image_changed();
+    void update_overlay_controls();
+    void paint_roi();
+    QString roi_statistics_text();
     void update_metadata_display();
     void update_window_controls();
+    void set_window_controls(int32_t center, int32_t width);
 };
\ No newline at end of file
@@ -0,0 +1,298 @@
+#include "viewport_grid.hpp"
+#include <QMouseEvent>
+#include <QPainter>
+#include <QTimer>
+#include <QWheelEvent>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+
+ViewportWidget::ViewportWidget(int index, QWidget* parent)
+    : QWidget(parent)
+    , index_(index)
+{
+    setMinimumSize(120, 120);
+    setAttribute(Qt::WA_OpaquePaintEvent);
+}
+
+void ViewportWidget::set_image(SharedImage image, const QString& caption) {
+    state_ = ViewportState{};
+    if (image) {
+        state_.window_center = image->data().window_center;
+        state_.window_width = std::max(image->data().window_width, 1);
+    }
+    state_.image = std::move(image);
+    caption_ = caption;
+}
+
+void ViewportWidget::set_active(bool active) {
+    if (active_ != active) {
+        active_ = active;
+        update();
+    }
+}
+
+void ViewportWidget::show_frame(ViewportFrame frame) {
+    placement_ = frame.placement;
+    if (frame.pixels.empty()) {
+        image_ = QImage();
+        update();
+        return;
+    }
+
+    auto pixels = std::make_unique<PixelBuffer>(std::move(frame.pixels));
+    const bool is_rgb = pixels->format() == PixelFormat::Rgb8;
+    uchar* bits = is_rgb ? pixels->rgb8() : pixels->gray8();
+    const int width = static_cast<int>(placement_.width);
+    image_ = QImage(
+        bits,
+        width,
+        static_cast<int>(placement_.height),
+        static_cast<qsizetype>(width) * (is_rgb ? 3 : 1),
+        is_rgb ? QImage::Format_RGB888 : QImage::Format_Grayscale8,
+        [](void* buffer) { delete static_cast<PixelBuffer*>(buffer); },
+        pixels.get()
+    );
+    pixels.release();
+    update();
+}
+
+void ViewportWidget::paintEvent(QPaintEvent*) {
+    QPainter painter(this);
+    painter.fillRect(rect(), Qt::black);
+
+    if (!image_.isNull()) {
+        painter.drawImage(QPoint(placement_.x, placement_.y), image_);
+    }
+
+    painter.setPen(QColor(0x88, 0x88, 0x88));
+    if (!state_.image) {
+        painter.drawText(rect(), Qt::AlignCenter, "Empty viewport\n\nFile > Open to load images");
+    }
+    else {
+        painter.drawText(rect().adjusted(6, 4, -6, -4), Qt::AlignLeft | Qt::AlignTop,
+            QString("%1\nWL %2 / WW %3  %4%")
+                .arg(caption_)
+                .arg(state_.window_center)
+                .arg(state_.window_width)
+                .arg(std::lround(view_scale() * 100)));
+    }
+
+    if (active_) {
+        painter.setPen(QPen(QColor(0x3d, 0x8e, 0xe6), 2));
+        painter.drawRect(rect().adjusted(1, 1, -1, -1));
+    }
+}
+
+void ViewportWidget::resizeEvent(QResizeEvent* event) {
+    QWidget::resizeEvent(event);
+    emit view_changed(index_);
+}
+
+void ViewportWidget::mousePressEvent(QMouseEvent* event) {
+    emit activated(index_);
+    drag_button_ = event->button();
+    last_mouse_pos_ = event->position().toPoint();
+}
+
+void ViewportWidget::mouseMoveEvent(QMouseEvent* event) {
+    if (!state_.image || drag_button_ == Qt::NoButton) return;
+
+    const QPoint pos = event->position().toPoint();
+    const QPoint delta = pos - last_mouse_pos_;
+    last_mouse_pos_ = pos;
+
+    if (drag_button_ == Qt::LeftButton) {
+        const double scale = view_scale();
+        state_.pan_x -= delta.x() / scale;
+        state_.pan_y -= delta.y() / scale;
+        emit view_changed(index_);
+    }
+    else if (drag_button_ == Qt::RightButton) {
+        emit window_dragged(index_, delta.y() * kWindowDragStep, delta.x() * kWindowDragStep);
+    }
+}
+
+void ViewportWidget::mouseReleaseEvent(QMouseEvent*) {
+    drag_button_ = Qt::NoButton;
+}
+
+void ViewportWidget::mouseDoubleClickEvent(QMouseEvent*) {
+    if (!state_.image) return;
+    state_.zoom = 1.0;
+    state_.pan_x = 0.0;
+    state_.pan_y = 0.0;
+    emit view_changed(index_);
+}
+
+void ViewportWidget::wheelEvent(QWheelEvent* event) {
+    if (!state_.image) return;
+    const double steps = event->angleDelta().y() / 120.0;
+    state_.zoom = std::clamp(state_.zoom * std::pow(1.25, steps), 0.1, 64.0);
+    emit view_changed(index_);
+}
+
+double ViewportWidget::view_scale() const {
+    if (placement_.source.width > 0) {
+        return static_cast<double>(placement_.width) / placement_.source.width;
+    }
+    if (!state_.image || state_.image->data().width == 0 || state_.image->data().height == 0) {
+        return 1.0;
+    }
+    const ImageData& data = state_.image->data();
+    return std::min(static_cast<double>(width()) / data.width,
+        static_cast<double>(height()) / data.height) * state_.zoom;
+}
+
+ViewportGrid::ViewportGrid(QWidget* parent)
+    : QWidget(parent)
+    , layout_(new QGridLayout(this))
+{
+    layout_->setContentsMargins(0, 0, 0, 0);
+    layout_->setSpacing(2);
+    set_layout(2, 2);
+}
+
+void ViewportGrid::set_layout(int rows, int columns) {
+    rows = std::max(rows, 1);
+    columns = std::max(columns, 1);
+    const size_t count = static_cast<size_t>(rows) * columns;
+
+    for (ViewportWidget* viewport : viewports_) {
+        layout_->removeWidget(viewport);
+    }
+    while (viewports_.size() > count) {
+        delete viewports_.back();
+        viewports_.pop_back();
+    }
+    while (viewports_.size() < count) {
+        auto* viewport = new ViewportWidget(static_cast<int>(viewports_.size()), this);
+        connect(viewport, &ViewportWidget::activated, this, &ViewportGrid::on_viewport_activated);
+        connect(viewport, &ViewportWidget::view_changed, this, &ViewportGrid::schedule_render);
+        connect(viewport, &ViewportWidget::window_dragged, this, &ViewportGrid::on_viewport_window_dragged);
+        viewports_.push_back(viewport);
+    }
+
+    // Rows and columns of a previous, larger layout stay in the grid but get no space
+    for (int r = 0; r < std::max(rows, rows_); ++r) {
+        layout_->setRowStretch(r, r < rows ? 1 : 0);
+    }
+    for (int c = 0; c < std::max(columns, columns_); ++c) {
+        layout_->setColumnStretch(c, c < columns ? 1 : 0);
+    }
+    for (size_t i = 0; i < viewports_.size(); ++i) {
+        layout_->addWidget(viewports_[i], static_cast<int>(i) / columns, static_cast<int>(i) % columns);
+        schedule_render(static_cast<int>(i));
+    }
+
+    rows_ = rows;
+    columns_ = columns;
+    set_active(std::min(active_, viewport_count() - 1));
+}
+
+void ViewportGrid::set_active(int index) {
+    if (index < 0 || index >= viewport_count()) return;
+    active_ = index;
+    for (ViewportWidget* viewport : viewports_) {
+        viewport->set_active(viewport->index() == index);
+    }
+    const ViewportState& active = viewports_[index]->state();
+    if (active.image) {
+        emit active_window_changed(active.window_center, active.window_width);
+    }
+}
+
+void ViewportGrid::set_image(int index, SharedImage image, const QString& caption) {
+    if (index < 0 || index >= viewport_count()) return;
+    viewports_[index]->set_image(std::move(image), caption);
+    schedule_render(index);
+    if (index == active_) {
+        set_active(index);
+    }
+}
+
+void ViewportGrid::set_window(int index, int32_t center, int32_t width) {
+    if (index < 0 || index >= viewport_count()) return;
+    const ViewportState& state = viewports_[index]->state();
+    if (!state.image) return;
+    adjust_window(index, center - state.window_center, width - state.window_width);
+}
+
+void ViewportGrid::adjust_window(int index, int32_t delta_center, int32_t delta_width) {
+    if (index < 0 || index >= viewport_count()) return;
+    for (ViewportWidget* viewport : viewports_) {
+        if (viewport->index() != index && !window_linked_) continue;
+        ViewportState& state = viewport->state();
+        if (!state.image) continue;
+        state.window_center += delta_center;
+        state.window_width = std::max(state.window_width + delta_width, 1);
+        schedule_render(viewport->index());
+    }
+    const ViewportState& active = viewports_[active_]->state();
+    if (active.image && (window_linked_ || index == active_)) {
+        emit active_window_changed(active.window_center, active.window_width);
+    }
+}
+
+void ViewportGrid::reset_window(int index) {
+    if (index < 0 || index >= viewport_count()) return;
+    for (ViewportWidget* viewport : viewports_) {
+        if (viewport->index() != index && !window_linked_) continue;
+        ViewportState& state = viewport->state();
+        if (!state.image) continue;
+        state.window_center = state.image->data().window_center;
+        state.window_width = std::max(state.image->data().window_width, 1);
+        schedule_render(viewport->index());
+    }
+    set_active(active_);
+}
+
+void ViewportGrid::set_window_linked(bool linked) {
+    window_linked_ = linked;
+}
+
+void ViewportGrid::on_viewport_activated(int index) {
+    if (index != active_) {
+        set_active(index);
+    }
+}
+
+void ViewportGrid::on_viewport_window_dragged(int index, int delta_center, int delta_width) {
+    adjust_window(index, delta_center, delta_width);
+}
+
+void ViewportGrid::schedule_render(int index) {
+    pending_.insert(index);
+    if (!render_scheduled_) {
+        // Collect everything changed by the current event, then render it in one pass
+        render_scheduled_ = true;
+        QTimer::singleShot(0, this, &ViewportGrid::render_pending);
+    }
+}
+
+void ViewportGrid::render_pending() {
+    render_scheduled_ = false;
+
+    std::vector<ViewportRequest> requests;
+    std::vector<ViewportWidget*> targets;
+    for (int index : pending_) {
+        if (index >= viewport_count()) continue;
+        ViewportWidget* viewport = viewports_[index];
+        requests.push_back(ViewportRequest{ viewport->state(),
+            static_cast<uint32_t>(viewport->width()), static_cast<uint32_t>(viewport->height()) });
+        targets.push_back(viewport);
+    }
+    pending_.clear();
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<ViewportFrame> frames = renderer_.render(requests);
+    const double render_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << "[DEBUG] Rendered " << frames.size() << " viewport(s) in " << render_ms << " ms" << std::endl;
+
+    for (size_t i = 0; i < frames.size(); ++i) {
+        targets[i]->show_frame(std::move(frames[i]));
+    }
+}
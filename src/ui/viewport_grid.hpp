@@ -0,0 +1,119 @@
+#pragma once
+
+#include <QGridLayout>
+#include <QImage>
+#include <QPoint>
+#include <QString>
+#include <QWidget>
+#include <set>
+#include <vector>
+
+#include "viewport.hpp"
+
+// One cell of a ViewportGrid. Left drag pans, right drag adjusts the window
+// (horizontal: width, vertical: center), the wheel zooms and a double click
+// fits the image again. Rendering is left to the grid.
+class ViewportWidget : public QWidget {
+    Q_OBJECT
+
+    int index_;
+    ViewportState state_;
+    QString caption_;
+    QImage image_;
+    ViewportPlacement placement_;
+    bool active_ = false;
+
+    QPoint last_mouse_pos_;
+    Qt::MouseButton drag_button_ = Qt::NoButton;
+
+public:
+    // Normalized window units per pixel of right-drag
+    static constexpr int kWindowDragStep = 64;
+
+    explicit ViewportWidget(int index, QWidget* parent = nullptr);
+
+    int index() const { return index_; }
+    const ViewportState& state() const { return state_; }
+    ViewportState& state() { return state_; }
+
+    void set_image(SharedImage image, const QString& caption);
+    void set_active(bool active);
+
+    // Takes the rendered pixels; the QImage hands them back to the pool when released
+    void show_frame(ViewportFrame frame);
+
+signals:
+    void activated(int index);
+    void view_changed(int index);
+    void window_dragged(int index, int delta_center, int delta_width);
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+    void resizeEvent(QResizeEvent* event) override;
+    void mousePressEvent(QMouseEvent* event) override;
+    void mouseMoveEvent(QMouseEvent* event) override;
+    void mouseReleaseEvent(QMouseEvent* event) override;
+    void mouseDoubleClickEvent(QMouseEvent* event) override;
+    void wheelEvent(QWheelEvent* event) override;
+
+private:
+    // Viewport pixels per image pixel at the current zoom
+    double view_scale() const;
+};
+
+// N x M layout of viewports drawing from one shared image cache. Each
+// viewport keeps its own window, zoom and pan; changes are collected and all
+// viewports that need it are rendered together in one parallel pass. With
+// linked windowing a window change applies to every viewport.
+class ViewportGrid : public QWidget {
+    Q_OBJECT
+
+    QGridLayout* layout_;
+    std::vector<ViewportWidget*> viewports_;
+    int rows_ = 0;
+    int columns_ = 0;
+    int active_ = 0;
+    bool window_linked_ = true;
+
+    ViewportRenderer renderer_;
+    std::set<int> pending_;   // viewports to render on the next pass
+    bool render_scheduled_ = false;
+
+public:
+    explicit ViewportGrid(QWidget* parent = nullptr);
+
+    // Keeps the states of viewports that remain in the new layout
+    void set_layout(int rows, int columns);
+    int rows() const { return rows_; }
+    int columns() const { return columns_; }
+    int viewport_count() const { return static_cast<int>(viewports_.size()); }
+
+    int active_index() const { return active_; }
+    void set_active(int index);
+    const ViewportState& state(int index) const { return viewports_[index]->state(); }
+
+    void set_image(int index, SharedImage image, const QString& caption);
+
+    // Moves the viewport's window to center/width. When windowing is linked
+    // every other viewport's window moves by the same amount.
+    void set_window(int index, int32_t center, int32_t width);
+    void adjust_window(int index, int32_t delta_center, int32_t delta_width);
+
+    // Back to each image's own window (every viewport when linked)
+    void reset_window(int index);
+
+    void set_window_linked(bool linked);
+    bool window_linked() const { return window_linked_; }
+
+signals:
+    // Window of the active viewport, after activation or a window change
+    void active_window_changed(int32_t center, int32_t width);
+
+private slots:
+    void on_viewport_activated(int index);
+    void on_viewport_window_dragged(int index, int delta_center, int delta_width);
+    void schedule_render(int index);
+
+private:
+    void render_pending();
+};